@@ -0,0 +1,260 @@
+"""Reader for the C++ detector's shared-memory detection bus.
+
+The native JARVIS binary publishes every frame's hand detections to a POSIX
+shared-memory ring (``/dev/shm/jarvis_detections`` when started with
+``JARVIS_DETECTION_BUS=1``). This module maps that ring read-only and decodes
+records without any socket, pipe or copy on the producer side. The layout is
+defined in ``legacy/hardware/JARVIS/include/detection_bus.hpp``; keep the two
+in step.
+
+Usage:
+    with DetectionBusReader() as bus:
+        for record in bus.records(poll_interval=0.005):
+            for hand in record.hands:
+                print(hand.gesture, hand.center)
+"""
+
+from __future__ import annotations
+
+import mmap
+import os
+import struct
+import time
+from dataclasses import dataclass
+from typing import Iterator
+
+DEFAULT_BUS_NAME = "/jarvis_detections"
+BUS_VERSION = 1
+
+# Gesture enum order of hand_detector::Gesture
+GESTURE_NAMES = (
+    "unknown",
+    "open_palm",
+    "fist",
+    "pointing",
+    "thumbs_up",
+    "peace",
+    "ok_sign",
+    "custom",
+)
+
+_HEADER = struct.Struct("<4sHHIIIIQQII16x")  # BusHeader, 64 bytes
+_RECORD = struct.Struct("<QQQIIII")  # BusRecordHeader, 40 bytes
+_HAND = struct.Struct("<iiiifiiIfiII10i8x")  # BusHand, 96 bytes
+_SEQ = struct.Struct("<Q")
+_U32 = struct.Struct("<I")
+_EPOCH_OFFSET = 24
+_PUBLISHED_OFFSET = 32
+_RETIRED_OFFSET = 44
+_REOPEN_INTERVAL = 0.1
+
+
+class DetectionBusError(RuntimeError):
+    """Raised when the bus segment is missing or has an unknown layout."""
+
+
+@dataclass(frozen=True, slots=True)
+class BusHand:
+    """One detected hand, in camera pixel coordinates."""
+
+    bbox: tuple[int, int, int, int]  # x, y, width, height
+    confidence: float
+    center: tuple[int, int]
+    gesture: str
+    gesture_confidence: float
+    num_fingers: int
+    contour_area: int
+    fingertips: tuple[tuple[int, int], ...]
+
+
+@dataclass(frozen=True, slots=True)
+class BusRecord:
+    """All hands detected in one camera frame."""
+
+    seq: int  # record number since the producer started
+    frame_id: int
+    capture_ns: int  # camera timestamp, CLOCK_MONOTONIC
+    publish_ns: int  # CLOCK_MONOTONIC when published
+    frame_width: int
+    frame_height: int
+    hands: tuple[BusHand, ...]
+
+    @property
+    def age_ms(self) -> float:
+        """Milliseconds since the producer published this record."""
+        return (time.clock_gettime_ns(time.CLOCK_MONOTONIC) - self.publish_ns) / 1e6
+
+
+def _shm_path(name: str) -> str:
+    return "/dev/shm/" + name.lstrip("/")
+
+
+class DetectionBusReader:
+    """Follows the detection ring of one producer.
+
+    Reading starts at the newest record. A reader that falls more than a ring
+    behind skips to the oldest record still present and counts the gap in
+    ``missed``. When the producer restarts, reading continues with its new
+    records and ``restarts`` is incremented.
+    """
+
+    def __init__(self, name: str = DEFAULT_BUS_NAME) -> None:
+        self._name = name
+        self._map: mmap.mmap | None = None
+        self._epoch = 0
+        self._slot_count = 0
+        self._slot_size = 0
+        self._max_hands = 0
+        self._cursor = 0
+        self._last_reopen = 0.0
+        self.missed = 0
+        self.restarts = 0
+        self._attach()
+        self._cursor = self._published()
+
+    def __enter__(self) -> "DetectionBusReader":
+        return self
+
+    def __exit__(self, *exc: object) -> None:
+        self.close()
+
+    def close(self) -> None:
+        """Unmap the segment."""
+        if self._map is not None:
+            self._map.close()
+            self._map = None
+
+    def _attach(self) -> None:
+        path = _shm_path(self._name)
+        try:
+            fd = os.open(path, os.O_RDONLY)
+        except OSError as e:
+            raise DetectionBusError(f"cannot open {path}: {e.strerror}") from e
+        try:
+            size = os.fstat(fd).st_size
+            if size < _HEADER.size:
+                raise DetectionBusError(f"{path} is not initialised")
+            m = mmap.mmap(fd, size, mmap.MAP_SHARED, mmap.PROT_READ)
+        finally:
+            os.close(fd)
+
+        (magic, version, header_size, slot_count, slot_size, max_hands, hand_size,
+         epoch, _published, _pid, _retired) = _HEADER.unpack_from(m, 0)
+        needed = 8 + _RECORD.size + max_hands * _HAND.size
+        if (
+            epoch == 0
+            or magic != b"JRVD"
+            or version != BUS_VERSION
+            or header_size != _HEADER.size
+            or hand_size != _HAND.size
+            or slot_count == 0
+            or slot_count & (slot_count - 1)
+            or slot_size < needed
+            or _HEADER.size + slot_count * slot_size > size
+        ):
+            m.close()
+            raise DetectionBusError(f"{path} has an unknown layout")
+
+        self.close()
+        self._map = m
+        self._epoch = epoch
+        self._slot_count = slot_count
+        self._slot_size = slot_size
+        self._max_hands = max_hands
+
+    def _published(self) -> int:
+        assert self._map is not None
+        return _SEQ.unpack_from(self._map, _PUBLISHED_OFFSET)[0]
+
+    def _follow_producer(self) -> None:
+        m = self._map
+        assert m is not None
+        if _U32.unpack_from(m, _RETIRED_OFFSET)[0]:
+            now = time.monotonic()
+            if now - self._last_reopen < _REOPEN_INTERVAL:
+                return
+            self._last_reopen = now
+            old_epoch = self._epoch
+            try:
+                self._attach()
+            except DetectionBusError:
+                return
+            if self._epoch != old_epoch:
+                self.restarts += 1
+                self._cursor = 0
+            return
+        epoch = _SEQ.unpack_from(m, _EPOCH_OFFSET)[0]
+        if epoch and epoch != self._epoch:
+            self._epoch = epoch
+            self.restarts += 1
+            self._cursor = 0
+
+    def _read_slot(self, n: int) -> BusRecord | None:
+        m = self._map
+        assert m is not None
+        offset = _HEADER.size + (n & (self._slot_count - 1)) * self._slot_size
+        if _SEQ.unpack_from(m, offset)[0] != 2 * n + 2:
+            return None
+        # One copy of the slot, then the sequence is checked again: a slot
+        # rewritten during the copy is rejected as a whole
+        raw = m[offset + 8 : offset + self._slot_size]
+        if _SEQ.unpack_from(m, offset)[0] != 2 * n + 2:
+            return None
+
+        frame_id, capture_ns, publish_ns, width, height, count, _ = _RECORD.unpack_from(raw, 0)
+        hands = []
+        for i in range(min(count, self._max_hands)):
+            f = _HAND.unpack_from(raw, _RECORD.size + i * _HAND.size)
+            gesture = GESTURE_NAMES[f[7]] if f[7] < len(GESTURE_NAMES) else "unknown"
+            tips = f[12:22]
+            hands.append(
+                BusHand(
+                    bbox=(f[0], f[1], f[2], f[3]),
+                    confidence=f[4],
+                    center=(f[5], f[6]),
+                    gesture=gesture,
+                    gesture_confidence=f[8],
+                    num_fingers=f[9],
+                    contour_area=f[10],
+                    fingertips=tuple((tips[2 * k], tips[2 * k + 1]) for k in range(min(f[11], 5))),
+                )
+            )
+        return BusRecord(n, frame_id, capture_ns, publish_ns, width, height, tuple(hands))
+
+    def next(self) -> BusRecord | None:
+        """Return the next unread record, or None if there is none yet."""
+        self._follow_producer()
+        published = self._published()
+        if self._cursor > published:
+            self._cursor = published
+        if published - self._cursor > self._slot_count:
+            self.missed += published - self._slot_count - self._cursor
+            self._cursor = published - self._slot_count
+        while self._cursor < published:
+            n = self._cursor
+            self._cursor += 1
+            record = self._read_slot(n)
+            if record is not None:
+                return record
+            self.missed += 1
+        return None
+
+    def latest(self) -> BusRecord | None:
+        """Return the newest record, skipping anything older, or None."""
+        self._follow_producer()
+        published = self._published()
+        if published == 0 or published <= self._cursor:
+            return None
+        if published - 1 > self._cursor:
+            self.missed += published - 1 - self._cursor
+        self._cursor = published
+        return self._read_slot(published - 1)
+
+    def records(self, poll_interval: float = 0.005) -> Iterator[BusRecord]:
+        """Yield records as they arrive, sleeping between empty polls."""
+        while self._map is not None:
+            record = self.next()
+            if record is None:
+                time.sleep(poll_interval)
+                continue
+            yield record
@@ -0,0 +1,207 @@
+"""Reader for camera frames exported by the C++ capture loop.
+
+With ``JARVIS_FRAME_RING=1`` the native JARVIS binary reads every camera
+frame straight into a POSIX shared-memory ring (``/dev/shm/jarvis_frames``;
+camera N > 0 uses ``jarvis_frames_N``). This module maps the ring read-only
+and copies frames out, checking each against the producer's sequence number
+so a frame overwritten mid-copy is never returned. The layout is defined in
+``legacy/hardware/JARVIS/include/frame_ring.hpp``.
+
+Usage:
+    with FrameRingReader() as ring:
+        frame = ring.latest()
+        if frame is not None and frame.format == "yuv420":
+            y_plane = frame.data[: frame.width * frame.height]
+"""
+
+from __future__ import annotations
+
+import mmap
+import os
+import struct
+import time
+from dataclasses import dataclass
+
+DEFAULT_RING_NAME = "/jarvis_frames"
+RING_VERSION = 1
+
+# camera::PixelFormat values
+FORMAT_NAMES = ("rgb888", "rgba8888", "yuv420", "unknown")
+
+_HEADER = struct.Struct("<4sHHIIIIQQII16x")  # FrameRingHeader, 64 bytes
+_SLOT = struct.Struct("<QQQIIIII20x")  # FrameSlotHeader, 64 bytes
+_SEQ = struct.Struct("<Q")
+_U32 = struct.Struct("<I")
+_EPOCH_OFFSET = 24
+_PUBLISHED_OFFSET = 32
+_RETIRED_OFFSET = 44
+_REOPEN_INTERVAL = 0.1
+
+
+class FrameRingError(RuntimeError):
+    """Raised when the ring is missing or has an unknown layout."""
+
+
+@dataclass(frozen=True, slots=True)
+class RingFrame:
+    """One camera frame copied out of the ring."""
+
+    seq: int  # frame number since the producer started
+    frame_id: int
+    timestamp_ns: int  # capture time, CLOCK_MONOTONIC
+    width: int
+    height: int
+    format: str
+    stride: int
+    data: bytes
+
+
+class FrameRingReader:
+    """Follows the frame ring of one camera.
+
+    Reading starts at the newest frame; ``missed`` counts frames skipped
+    because the reader fell behind, ``restarts`` producer restarts.
+    """
+
+    def __init__(self, name: str = DEFAULT_RING_NAME) -> None:
+        self._name = name
+        self._map: mmap.mmap | None = None
+        self._epoch = 0
+        self._slot_count = 0
+        self._slot_size = 0
+        self._capacity = 0
+        self._cursor = 0
+        self._last_reopen = 0.0
+        self.missed = 0
+        self.restarts = 0
+        self._attach()
+        self._cursor = self._published()
+
+    def __enter__(self) -> "FrameRingReader":
+        return self
+
+    def __exit__(self, *exc: object) -> None:
+        self.close()
+
+    def close(self) -> None:
+        """Unmap the ring."""
+        if self._map is not None:
+            self._map.close()
+            self._map = None
+
+    def _attach(self) -> None:
+        path = "/dev/shm/" + self._name.lstrip("/")
+        try:
+            fd = os.open(path, os.O_RDONLY)
+        except OSError as e:
+            raise FrameRingError(f"cannot open {path}: {e.strerror}") from e
+        try:
+            size = os.fstat(fd).st_size
+            if size < _HEADER.size:
+                raise FrameRingError(f"{path} is not initialised")
+            m = mmap.mmap(fd, size, mmap.MAP_SHARED, mmap.PROT_READ)
+        finally:
+            os.close(fd)
+
+        (magic, version, header_size, slot_count, slot_size, capacity, _,
+         epoch, _published, _pid, _retired) = _HEADER.unpack_from(m, 0)
+        if (
+            epoch == 0
+            or magic != b"JRVF"
+            or version != RING_VERSION
+            or header_size != _HEADER.size
+            or slot_count == 0
+            or slot_count & (slot_count - 1)
+            or slot_size < _SLOT.size + capacity
+            or _HEADER.size + slot_count * slot_size > size
+        ):
+            m.close()
+            raise FrameRingError(f"{path} has an unknown layout")
+
+        self.close()
+        self._map = m
+        self._epoch = epoch
+        self._slot_count = slot_count
+        self._slot_size = slot_size
+        self._capacity = capacity
+
+    def _published(self) -> int:
+        assert self._map is not None
+        return _SEQ.unpack_from(self._map, _PUBLISHED_OFFSET)[0]
+
+    def _follow_producer(self) -> None:
+        m = self._map
+        assert m is not None
+        if _U32.unpack_from(m, _RETIRED_OFFSET)[0]:
+            now = time.monotonic()
+            if now - self._last_reopen < _REOPEN_INTERVAL:
+                return
+            self._last_reopen = now
+            old_epoch = self._epoch
+            try:
+                self._attach()
+            except FrameRingError:
+                return
+            if self._epoch != old_epoch:
+                self.restarts += 1
+                self._cursor = 0
+            return
+        epoch = _SEQ.unpack_from(m, _EPOCH_OFFSET)[0]
+        if epoch and epoch != self._epoch:
+            self._epoch = epoch
+            self.restarts += 1
+            self._cursor = 0
+
+    def _read_slot(self, n: int) -> RingFrame | None:
+        m = self._map
+        assert m is not None
+        offset = _HEADER.size + (n & (self._slot_count - 1)) * self._slot_size
+        (seq, frame_id, timestamp_ns, width, height, fmt, stride,
+         used) = _SLOT.unpack_from(m, offset)
+        if seq != 2 * n + 2:
+            return None
+        start = offset + _SLOT.size
+        data = m[start : start + min(used, self._capacity)]
+        # Overwritten during the copy: the pixels may be mixed, drop them
+        if _SEQ.unpack_from(m, offset)[0] != seq:
+            return None
+        return RingFrame(
+            seq=n,
+            frame_id=frame_id,
+            timestamp_ns=timestamp_ns,
+            width=width,
+            height=height,
+            format=FORMAT_NAMES[fmt] if fmt < len(FORMAT_NAMES) else "unknown",
+            stride=stride,
+            data=data,
+        )
+
+    def next(self) -> RingFrame | None:
+        """Return the next unread frame, or None if there is none yet."""
+        self._follow_producer()
+        published = self._published()
+        if self._cursor > published:
+            self._cursor = published
+        keep = self._slot_count - 1  # the slot being filled is not readable
+        if published - self._cursor > keep:
+            self.missed += published - keep - self._cursor
+            self._cursor = published - keep
+        while self._cursor < published:
+            n = self._cursor
+            self._cursor += 1
+            frame = self._read_slot(n)
+            if frame is not None:
+                return frame
+            self.missed += 1
+        return None
+
+    def latest(self) -> RingFrame | None:
+        """Return the newest frame, skipping anything older, or None."""
+        self._follow_producer()
+        published = self._published()
+        if published == 0 or published <= self._cursor:
+            return None
+        if published - 1 > self._cursor:
+            self.missed += published - 1 - self._cursor
+        self._cursor = published
+        return self._read_slot(published - 1)
@@ -0,0 +1,155 @@
+"""Tests for the shared-memory detection bus reader."""
+
+import os
+import struct
+import uuid
+
+import pytest
+
+from core.vision.detection_bus import (
+    BusRecord,
+    DetectionBusError,
+    DetectionBusReader,
+)
+
+SHM_DIR = "/dev/shm"
+
+pytestmark = pytest.mark.skipif(not os.path.isdir(SHM_DIR), reason="needs /dev/shm")
+
+
+class FakeProducer:
+    """Writes the segment layout of the C++ DetectionPublisher."""
+
+    def __init__(self, name: str, slots: int = 8, max_hands: int = 2) -> None:
+        self.path = os.path.join(SHM_DIR, name.lstrip("/"))
+        self.slots = slots
+        self.max_hands = max_hands
+        self.slot_size = (8 + 40 + max_hands * 96 + 63) // 64 * 64
+        self.count = 0
+        self.epoch = 1_700_000_000_000_000_000
+        self.fd = os.open(self.path, os.O_RDWR | os.O_CREAT, 0o644)
+        os.ftruncate(self.fd, 64 + slots * self.slot_size)
+        self.restart()
+
+    def restart(self) -> None:
+        self.count = 0
+        self.epoch += 1
+        header = struct.pack(
+            "<4sHHIIIIQQII16x", b"JRVD", 1, 64, self.slots, self.slot_size,
+            self.max_hands, 96, self.epoch, 0, os.getpid(), 0,
+        )
+        os.pwrite(self.fd, header, 0)
+        os.pwrite(self.fd, b"\0" * (self.slots * self.slot_size), 64)
+
+    def publish(self, frame_id: int, hands: list[tuple[int, int]]) -> None:
+        n = self.count
+        offset = 64 + (n % self.slots) * self.slot_size
+        body = struct.pack("<QQQIIII", frame_id, frame_id * 10, 5, 640, 480, len(hands), 0)
+        for gesture, x in hands:
+            tips = [x, x + 1, x + 2, x + 3] + [0] * 6
+            body += struct.pack(
+                "<iiiifiiIfiII10i8x", x, 2 * x, 30, 40, 0.75, x + 15, 2 * x + 20,
+                gesture, 0.5, 2, 1234, 2, *tips,
+            )
+        os.pwrite(self.fd, struct.pack("<Q", 2 * n + 2) + body, offset)
+        self.count = n + 1
+        os.pwrite(self.fd, struct.pack("<Q", self.count), 32)
+
+    def retire(self) -> None:
+        os.pwrite(self.fd, struct.pack("<I", 1), 44)
+
+    def remove(self) -> None:
+        os.close(self.fd)
+        if os.path.exists(self.path):
+            os.unlink(self.path)
+
+
+@pytest.fixture
+def bus_name():
+    name = f"/jarvis_bus_pytest_{uuid.uuid4().hex[:8]}"
+    yield name
+    path = os.path.join(SHM_DIR, name.lstrip("/"))
+    if os.path.exists(path):
+        os.unlink(path)
+
+
+class TestDetectionBusReader:
+    """Tests for DetectionBusReader."""
+
+    def test_missing_segment_raises(self, bus_name: str) -> None:
+        """A reader cannot attach before the producer created the ring."""
+        with pytest.raises(DetectionBusError):
+            DetectionBusReader(bus_name)
+
+    def test_reads_records_in_order(self, bus_name: str) -> None:
+        """Records published after attaching are decoded in order."""
+        producer = FakeProducer(bus_name)
+        producer.publish(1, [(4, 10)])
+        with DetectionBusReader(bus_name) as bus:
+            assert bus.next() is None  # starts at the newest record
+
+            producer.publish(2, [(1, 20), (5, 30)])
+            producer.publish(3, [])
+            record = bus.next()
+            assert isinstance(record, BusRecord)
+            assert record.seq == 1
+            assert record.frame_id == 2
+            assert record.capture_ns == 20
+            assert (record.frame_width, record.frame_height) == (640, 480)
+            assert len(record.hands) == 2
+            hand = record.hands[1]
+            assert hand.bbox == (30, 60, 30, 40)
+            assert hand.confidence == pytest.approx(0.75)
+            assert hand.center == (45, 80)
+            assert hand.gesture == "peace"
+            assert hand.fingertips == ((30, 31), (32, 33))
+            assert record.hands[0].gesture == "open_palm"
+
+            assert bus.next().hands == ()
+            assert bus.next() is None
+            assert bus.missed == 0
+        producer.remove()
+
+    def test_slow_reader_counts_missed(self, bus_name: str) -> None:
+        """A reader lapped by the producer resumes at the oldest slot."""
+        producer = FakeProducer(bus_name, slots=4)
+        bus = DetectionBusReader(bus_name)
+        for frame in range(10):
+            producer.publish(frame, [])
+        assert bus.next().frame_id == 6
+        assert bus.missed == 6
+
+        producer.publish(10, [])
+        producer.publish(11, [])
+        assert bus.latest().frame_id == 11
+        assert bus.missed == 10
+        assert bus.latest() is None
+        bus.close()
+        producer.remove()
+
+    def test_follows_restarted_producer(self, bus_name: str) -> None:
+        """A new producer epoch restarts reading from its first record."""
+        producer = FakeProducer(bus_name)
+        bus = DetectionBusReader(bus_name)
+        for frame in range(3):
+            producer.publish(frame, [])
+        while bus.next() is not None:
+            pass
+
+        producer.retire()
+        producer.restart()
+        producer.publish(100, [(2, 1)])
+        record = bus.next()
+        assert record.frame_id == 100
+        assert record.seq == 0
+        assert bus.restarts == 1
+        bus.close()
+        producer.remove()
+
+    def test_rejects_unknown_layout(self, bus_name: str) -> None:
+        """A segment with another magic or version is not read."""
+        path = os.path.join(SHM_DIR, bus_name.lstrip("/"))
+        with open(path, "wb") as f:
+            f.write(b"NOPE" + b"\0" * 1020)
+        with pytest.raises(DetectionBusError):
+            DetectionBusReader(bus_name)
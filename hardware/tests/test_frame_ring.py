@@ -0,0 +1,99 @@
+"""Tests for the shared-memory camera frame ring reader."""
+
+import os
+import struct
+import uuid
+
+import pytest
+
+from core.vision.frame_ring import FrameRingError, FrameRingReader
+
+SHM_DIR = "/dev/shm"
+
+pytestmark = pytest.mark.skipif(not os.path.isdir(SHM_DIR), reason="needs /dev/shm")
+
+
+class FakeCamera:
+    """Writes the ring layout of the C++ FrameRingWriter."""
+
+    def __init__(self, name: str, slots: int = 4, capacity: int = 24) -> None:
+        self.path = os.path.join(SHM_DIR, name.lstrip("/"))
+        self.slots = slots
+        self.capacity = capacity
+        self.slot_size = (64 + capacity + 4095) // 4096 * 4096
+        self.count = 0
+        self.fd = os.open(self.path, os.O_RDWR | os.O_CREAT, 0o644)
+        os.ftruncate(self.fd, 64 + slots * self.slot_size)
+        header = struct.pack(
+            "<4sHHIIIIQQII16x", b"JRVF", 1, 64, slots, self.slot_size, capacity, 0,
+            1_700_000_000_000_000_000, 0, os.getpid(), 0,
+        )
+        os.pwrite(self.fd, header, 0)
+
+    def _slot(self, n: int) -> int:
+        return 64 + (n % self.slots) * self.slot_size
+
+    def begin(self) -> None:
+        n = self.count
+        os.pwrite(self.fd, struct.pack("<Q", 2 * n + 1), self._slot(n))
+
+    def publish(self, frame_id: int, pixels: bytes) -> None:
+        n = self.count
+        slot = struct.pack("<QQQIIIII20x", 2 * n + 2, frame_id, frame_id * 1000, 4, 4, 2, 4, len(pixels))
+        os.pwrite(self.fd, slot + pixels, self._slot(n))
+        self.count = n + 1
+        os.pwrite(self.fd, struct.pack("<Q", self.count), 32)
+
+    def remove(self) -> None:
+        os.close(self.fd)
+        if os.path.exists(self.path):
+            os.unlink(self.path)
+
+
+@pytest.fixture
+def ring_name():
+    name = f"/jarvis_ring_pytest_{uuid.uuid4().hex[:8]}"
+    yield name
+    path = os.path.join(SHM_DIR, name.lstrip("/"))
+    if os.path.exists(path):
+        os.unlink(path)
+
+
+class TestFrameRingReader:
+    """Tests for FrameRingReader."""
+
+    def test_missing_ring_raises(self, ring_name: str) -> None:
+        """A reader cannot attach before the camera created the ring."""
+        with pytest.raises(FrameRingError):
+            FrameRingReader(ring_name)
+
+    def test_reads_frames(self, ring_name: str) -> None:
+        """Frames published after attaching are copied out with metadata."""
+        camera = FakeCamera(ring_name)
+        camera.publish(1, b"\x01" * 24)
+        with FrameRingReader(ring_name) as ring:
+            assert ring.next() is None  # starts at the newest frame
+            camera.publish(2, bytes(range(24)))
+            frame = ring.next()
+            assert frame.seq == 1
+            assert frame.frame_id == 2
+            assert frame.timestamp_ns == 2000
+            assert (frame.width, frame.height, frame.stride) == (4, 4, 4)
+            assert frame.format == "yuv420"
+            assert frame.data == bytes(range(24))
+            assert ring.next() is None
+        camera.remove()
+
+    def test_skips_frames_being_written(self, ring_name: str) -> None:
+        """A lapped reader resumes after the slot the camera is filling."""
+        camera = FakeCamera(ring_name, slots=4)
+        ring = FrameRingReader(ring_name)
+        for frame_id in range(10):
+            camera.publish(frame_id, bytes([frame_id]) * 24)
+        camera.begin()
+        assert ring.next().frame_id == 7
+        assert ring.missed == 7
+        assert ring.latest().frame_id == 9
+        assert ring.missed == 8
+        ring.close()
+        camera.remove()
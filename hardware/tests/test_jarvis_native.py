@@ -0,0 +1,65 @@
+"""Tests for the jarvis_native C++ bindings (skipped when not built)."""
+
+import pytest
+
+np = pytest.importorskip("numpy")
+jn = pytest.importorskip("jarvis_native")
+
+
+class TestDetector:
+    """Tests for the detector bindings."""
+
+    def test_detect_returns_structured_array(self) -> None:
+        """Blank frames give an empty array of the bus record type."""
+        det = jn.HandDetector()
+        hands = det.detect(np.zeros((120, 160, 3), dtype=np.uint8))
+        assert hands.dtype == jn.detection_dtype
+        assert hands.shape == (0,)
+        assert det.stats.frames_processed == 1
+
+    def test_any_buffer_gives_the_same_result(self) -> None:
+        """NumPy arrays and plain memoryviews are read the same way."""
+        rng = np.random.default_rng(7)
+        image = rng.integers(0, 256, (120, 160, 3), dtype=np.uint8)
+        raw = memoryview(bytearray(image.tobytes())).cast("B", (120, 160, 3))
+        a = jn.HandDetector().detect(image)
+        b = jn.HandDetector().detect(raw)
+        assert a.tobytes() == b.tobytes()
+
+    def test_padded_rows_match_packed(self) -> None:
+        """A crop of a wider image is read in place, padding and all."""
+        rng = np.random.default_rng(11)
+        wide = rng.integers(0, 256, (120, 176, 3), dtype=np.uint8)
+        a = jn.HandDetector().detect(wide[:, :160])
+        b = jn.HandDetector().detect(np.ascontiguousarray(wide[:, :160]))
+        assert a.tobytes() == b.tobytes()
+
+    def test_rejects_wrong_layout(self) -> None:
+        """Only HxWx3 uint8 images with packed pixels are accepted."""
+        det = jn.HandDetector()
+        with pytest.raises(ValueError):
+            det.detect(np.zeros((120, 160), dtype=np.uint8))
+        with pytest.raises(ValueError):
+            det.detect(np.zeros((120, 320, 3), dtype=np.uint8)[:, ::2])
+        with pytest.raises(ValueError):
+            det.detect(np.zeros((120, 160, 3), dtype=np.uint8)[..., ::-1])
+
+
+class TestSketchPad:
+    """Tests for the SketchPad bindings."""
+
+    def test_lines_and_render(self) -> None:
+        """Lines round-trip and render into a caller-owned buffer."""
+        pad = jn.SketchPad(64, 48)
+        pad.add_line(10.0, 10.0, 90.0, 90.0)
+        assert pad.lines().shape == (1, 4)
+        target = np.zeros((48, 64), dtype=np.uint32)
+        pad.render(target)
+        assert target.any()
+
+    def test_render_rejects_non_integer_pixels(self) -> None:
+        """float32 has the right size but is not a pixel format."""
+        pad = jn.SketchPad(64, 48)
+        with pytest.raises(ValueError):
+            pad.render(np.zeros((48, 64), dtype=np.float32))
+        pad.render(np.zeros((48, 64), dtype=np.int32))
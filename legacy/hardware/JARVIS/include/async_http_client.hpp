@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct HttpRequest
+{
+    std::string method = "GET";
+    std::string host;
+    uint16_t port = 80;
+    std::string path = "/";
+    std::string body;                                          // sent when non-empty or method is POST/PUT
+    std::string content_type = "application/json";
+    std::vector<std::pair<std::string, std::string>> headers; // extra request headers
+    int timeout_ms = 3000;                                     // connect, and silence between reads
+    bool use_tls = false;
+};
+
+struct HttpResponse
+{
+    bool ok = false;   // a 2xx response arrived
+    int status = 0;    // 0 if no response arrived
+    std::string body;
+    std::string error; // as HttpClient::last_error()
+    std::vector<std::pair<std::string, std::string>> headers; // names lowercased
+    uint64_t duration_us = 0;
+
+    // Value of the first header with this (lowercase) name, or empty
+    std::string header(const char *lower_name) const
+    {
+        for (const auto &h : headers)
+            if (h.first == lower_name)
+                return h.second;
+        return std::string();
+    }
+};
+
+struct AsyncHttpStats
+{
+    uint64_t submitted = 0;
+    uint64_t completed = 0; // includes failures
+    uint64_t failed = 0;
+    uint64_t connects = 0;
+    uint64_t reuses = 0;
+    size_t in_flight = 0;
+    size_t peak_in_flight = 0;
+};
+
+// Non-blocking HTTP/1.1 client driven by an epoll reactor thread.
+//
+// Requests are queued from any thread and return immediately; sockets,
+// connects and TLS handshakes are non-blocking, so any number of requests
+// can be in flight without tying up the caller. Keep-alive connections are
+// pooled per host (at most max_connections_per_host open at once; extra
+// requests wait for one). DNS results and TLS sessions are shared with
+// HttpClient.
+//
+// Completion callbacks run on the reactor thread and must not block.
+class AsyncHttpClient
+{
+public:
+    using Callback = std::function<void(HttpResponse response)>;
+
+    explicit AsyncHttpClient(size_t max_connections_per_host = 4);
+    ~AsyncHttpClient();
+
+    void send(HttpRequest request, Callback done);
+    std::future<HttpResponse> send(HttpRequest request);
+
+    std::future<HttpResponse> get(const std::string &host, uint16_t port, const std::string &path,
+                                  int timeout_ms = 3000, bool use_tls = false);
+    std::future<HttpResponse> post(const std::string &host, uint16_t port, const std::string &path,
+                                   const std::string &body, const std::string &content_type = "application/json",
+                                   int timeout_ms = 3000, bool use_tls = false);
+
+    AsyncHttpStats stats() const;
+
+    // Fail whatever is still pending and stop the reactor (idempotent)
+    void shutdown();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+
+    AsyncHttpClient(const AsyncHttpClient &) = delete;
+    AsyncHttpClient &operator=(const AsyncHttpClient &) = delete;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sketch
+{
+
+    struct Sketch;
+    struct GridConfig;
+
+    // Binary .jarvis blueprint, version 1 (little-endian).
+    //
+    //   BlueprintHeader                         64 bytes
+    //   name                                    name_length bytes, zero-padded to 8
+    //   x0[n] y0[n] x1[n] y1[n]                 float32 columns (percent)
+    //   color[n]                                uint32 column (0x00RRGGBB)
+    //   thickness[n]                            int32 column (pixels)
+    //
+    // Every column is 4-byte aligned, so a mapped file is read in place. The
+    // signature is detached ("<file>.sig", hex) and covers the raw file bytes:
+    // HMAC-SHA256 with JARVIS_SECRET, plain SHA256 without.
+    struct BlueprintHeader
+    {
+        char magic[4];         // "JRVB"
+        uint16_t version;      // kBlueprintVersion
+        uint16_t header_size;  // sizeof(BlueprintHeader) for version 1
+        uint32_t line_count;   // n
+        uint32_t name_length;  // bytes, not terminated
+        uint32_t width;        // sketch resolution
+        uint32_t height;
+        uint64_t created_timestamp;
+        float grid_spacing_percent;
+        float real_world_spacing_cm;
+        uint32_t grid_flags;     // kGridSnap | kGridMeasurements
+        uint32_t columns_offset; // byte offset of x0[0]
+        uint8_t reserved[16];
+    };
+    static_assert(sizeof(BlueprintHeader) == 64, "BlueprintHeader layout changed");
+
+    constexpr uint16_t kBlueprintVersion = 1;
+    constexpr uint32_t kGridSnap = 1u << 0;
+    constexpr uint32_t kGridMeasurements = 1u << 1;
+
+    // True if the buffer starts with a binary blueprint header
+    bool is_binary_blueprint(const void *data, size_t size);
+
+    // Serialize a sketch and its grid settings
+    std::string encode_blueprint(const Sketch &sketch, const GridConfig &grid);
+
+    // Hex signature over raw bytes (HMAC-SHA256 if secret is non-empty, else SHA256)
+    std::string blueprint_signature(const void *data, size_t size, const std::string &secret);
+
+    // Signing key from JARVIS_SECRET (empty: plain SHA256 signatures)
+    std::string blueprint_secret();
+
+    // Path of the detached signature for a blueprint file
+    inline std::string blueprint_signature_path(const std::string &path) { return path + ".sig"; }
+
+    // Detached signature of a blueprint file (empty if missing). While a
+    // new base is being installed the .sig lists it ahead of the previous
+    // one; the first line is always the newest.
+    std::string read_blueprint_signature(const std::string &path);
+    std::vector<std::string> read_blueprint_signatures(const std::string &path);
+
+    // Create every missing directory above `path`
+    bool ensure_parent_dirs(const std::string &path);
+
+    // Write to "<path>.tmp" (0600), fsync, then rename over `path`
+    bool write_file_atomic(const std::string &path, const void *data, size_t size);
+
+    // Encode, sign and write a blueprint to `staged` (no .sig)
+    bool stage_blueprint(const std::string &staged, const Sketch &sketch, const GridConfig &grid,
+                         const std::string &secret, std::string *signature_out = nullptr);
+
+    // Rename a staged blueprint over `path` and make `signature` its .sig.
+    // The previous pair verifies until the rename, the new one after it, so
+    // a crash at any point leaves a loadable blueprint. False if nothing
+    // was replaced (the previous pair is still intact).
+    bool install_blueprint(const std::string &staged, const std::string &path, const std::string &signature);
+
+    // stage_blueprint + install_blueprint. This is the one place a full
+    // blueprint reaches disk (saves and compaction).
+    bool persist_blueprint(const std::string &path, const Sketch &sketch, const GridConfig &grid,
+                           const std::string &secret, std::string *signature_out = nullptr);
+
+    // Zero-copy, read-only view over a binary blueprint.
+    //
+    // open() maps the file; the column accessors point straight into the
+    // mapping, so opening is O(1) in the number of lines.
+    class BlueprintView
+    {
+    public:
+        BlueprintView() = default;
+        ~BlueprintView();
+        BlueprintView(BlueprintView &&other) noexcept;
+        BlueprintView &operator=(BlueprintView &&other) noexcept;
+
+        // Map and validate a file
+        bool open(const std::string &path);
+        // Validate a caller-owned buffer (must outlive the view)
+        bool attach(const void *data, size_t size);
+        void close();
+
+        bool valid() const { return header_ != nullptr; }
+        const std::string &error() const { return error_; }
+
+        const BlueprintHeader &header() const { return *header_; }
+        uint32_t line_count() const { return header_ ? header_->line_count : 0; }
+        std::string name() const;
+
+        const float *x0() const { return column<float>(0); }
+        const float *y0() const { return column<float>(1); }
+        const float *x1() const { return column<float>(2); }
+        const float *y1() const { return column<float>(3); }
+        const uint32_t *color() const { return column<uint32_t>(4); }
+        const int32_t *thickness() const { return column<int32_t>(5); }
+
+        // Raw bytes (what the signature covers)
+        const uint8_t *data() const { return data_; }
+        size_t size() const { return size_; }
+
+        // Compare against a detached hex signature
+        bool verify_signature(const std::string &signature_hex, const std::string &secret) const;
+
+        // Copy into a Sketch / GridConfig (grid is left untouched if null)
+        void to_sketch(Sketch &out, GridConfig *grid) const;
+
+    private:
+        template <typename T>
+        const T *column(int index) const
+        {
+            if (!header_)
+                return nullptr;
+            size_t offset = header_->columns_offset + static_cast<size_t>(index) * header_->line_count * 4;
+            return reinterpret_cast<const T *>(data_ + offset);
+        }
+
+        bool validate();
+
+        const uint8_t *data_ = nullptr;
+        size_t size_ = 0;
+        const BlueprintHeader *header_ = nullptr;
+        void *mapping_ = nullptr; // non-null when we own an mmap
+        std::string error_;
+
+        BlueprintView(const BlueprintView &) = delete;
+        BlueprintView &operator=(const BlueprintView &) = delete;
+    };
+
+    // The signature in `path`'s .sig that the view verifies against, or
+    // empty if none does
+    std::string verified_blueprint_signature(const BlueprintView &view, const std::string &path,
+                                             const std::string &secret);
+
+} // namespace sketch
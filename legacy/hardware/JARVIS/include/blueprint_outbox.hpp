@@ -0,0 +1,137 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+class AsyncHttpClient;
+
+namespace sketch
+{
+
+    struct OutboxConfig
+    {
+        std::string host;
+        uint16_t port = 80;
+        bool use_tls = false;
+        int timeout_ms = 3000;
+        // POST target for one blueprint ({"name", "data"})
+        std::function<std::string(const std::string &name)> save_path;
+        // POST target for several at once ({"blueprints": [...]}); empty
+        // disables batching
+        std::string batch_path;
+        size_t max_in_flight = 4;         // requests outstanding at once
+        size_t max_batch = 16;            // blueprints per batch request
+        size_t max_batch_bytes = 1 << 20; // body size a batch stops growing at
+        int backoff_initial_ms = 1000;    // first retry delay
+        int backoff_max_ms = 5 * 60 * 1000;
+        bool background = true;           // retry thread; otherwise call drain()
+    };
+
+    struct OutboxStats
+    {
+        uint64_t enqueued = 0;
+        uint64_t coalesced = 0;   // enqueues that replaced a queued upload
+        uint64_t uploaded = 0;    // blueprints the server accepted
+        uint64_t failed = 0;      // upload attempts that failed
+        uint64_t requests = 0;    // HTTP requests sent
+        uint64_t batches = 0;     // of which batch requests
+        uint64_t compactions = 0; // log rewrites
+        size_t pending = 0;
+    };
+
+    // Uploads that could not reach the server, kept until they do.
+    //
+    // Every blueprint has at most one queued upload, its latest JSON export:
+    // queueing a newer one replaces it (coalescing). Queued uploads and
+    // acknowledgements are appended to "<dir>/outbox.log" with increasing
+    // sequence numbers, so a restart resumes where the last run stopped; the
+    // log is rewritten once it is mostly acknowledged records. Legacy
+    // "<name>.pending.json" files in `dir` are imported on start.
+    //
+    // drain() sends what is due over the shared connection pool, at most
+    // max_in_flight requests at a time, several blueprints per request when
+    // the server has the batch endpoint. A failed upload is retried after an
+    // exponential, jittered delay. With `background` a thread drains
+    // whenever something becomes due.
+    class BlueprintOutbox
+    {
+    public:
+        BlueprintOutbox(AsyncHttpClient &http, std::string dir, OutboxConfig config);
+        ~BlueprintOutbox();
+
+        // Queue the JSON export of a blueprint; returns its sequence number,
+        // or 0 if the export is not valid JSON
+        uint64_t enqueue(const std::string &name, const std::string &export_json);
+
+        // Send every upload that is due (all of them with `ignore_backoff`)
+        // and wait for the answers. Returns the uploads accepted.
+        size_t drain(bool ignore_backoff = false);
+        // Make everything due now and wake the retry thread
+        void retry_now();
+        // Stop the retry thread; queued uploads stay in the log (idempotent)
+        void shutdown();
+
+        size_t pending() const;
+        bool queued(const std::string &name) const;
+        uint64_t last_sequence() const;
+        OutboxStats stats() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Entry
+        {
+            uint64_t seq = 0;
+            std::string data; // compact JSON export
+            int attempts = 0; // consecutive failures
+            Clock::time_point due;
+            bool in_flight = false;
+        };
+
+        // One queued upload as taken by drain()
+        struct Upload
+        {
+            std::string name;
+            uint64_t seq = 0;
+            std::string body; // {"name", "data"}
+        };
+
+        void run();
+        void import_pending_files();
+        void load_log();
+        bool append(const std::string &record);
+        void compact_locked();
+        void finish(const Upload &upload, bool ok);
+        std::chrono::milliseconds backoff_locked(int attempts);
+
+        AsyncHttpClient &http_;
+        std::string dir_;
+        std::string log_path_;
+        OutboxConfig config_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable wake_;
+        std::map<std::string, Entry> entries_;
+        uint64_t last_seq_ = 0;
+        int log_fd_ = -1;
+        size_t log_records_ = 0; // records in the log file
+        bool batch_supported_ = true;
+        std::mt19937_64 rng_;
+        OutboxStats stats_;
+        bool stopped_ = false;
+        bool kicked_ = false;
+        std::thread thread_;
+
+        BlueprintOutbox(const BlueprintOutbox &) = delete;
+        BlueprintOutbox &operator=(const BlueprintOutbox &) = delete;
+    };
+
+} // namespace sketch
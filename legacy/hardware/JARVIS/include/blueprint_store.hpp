@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sketch
+{
+
+    // One blueprint as recorded in the store index
+    struct BlueprintIndexEntry
+    {
+        std::string name;              // file stem: <dir>/<name>.jarvis
+        uint32_t line_count = 0;       // base plus journal
+        float min_x = 0, min_y = 0;    // bounds of every line end, percent
+        float max_x = 0, max_y = 0;    // (all zero without lines)
+        uint8_t hash[32] = {};         // SHA256 of the base file bytes
+        int64_t mtime_ns = 0;          // base file
+        uint64_t size = 0;             // base file
+        uint64_t journal_size = 0;     // 0 without a journal
+        uint32_t flags = 0;            // kIndex*
+    };
+
+    constexpr uint32_t kIndexJson = 1u << 0;       // legacy JSON base
+    constexpr uint32_t kIndexVerified = 1u << 1;   // signature checked when indexed
+    constexpr const char *kBlueprintIndexFile = "_index.jarvisidx";
+
+    // Compact, sorted index of a blueprint directory ("<dir>/_index.jarvisidx").
+    //
+    //   IndexHeader                      32 bytes ("JRVI", version, count)
+    //   IndexRecord[count]               96 bytes each, sorted by name
+    //   names                            concatenated, not terminated
+    //
+    // Loading reads the file once; listing and lookup never touch the
+    // blueprints themselves. Entries whose base or journal changed on disk
+    // since they were indexed are picked up by refresh().
+    class BlueprintIndex
+    {
+    public:
+        bool load(const std::string &path);
+        bool save(const std::string &path) const;
+
+        const std::vector<BlueprintIndexEntry> &entries() const { return entries_; }
+        size_t size() const { return entries_.size(); }
+        bool empty() const { return entries_.empty(); }
+
+        // Binary search by name (nullptr if absent)
+        const BlueprintIndexEntry *find(const std::string &name) const;
+        // Names starting with `prefix`, in order
+        std::vector<const BlueprintIndexEntry *> with_prefix(const std::string &prefix) const;
+
+        // Insert or replace, keeping the order
+        void put(BlueprintIndexEntry entry);
+        bool remove(const std::string &name);
+        void clear() { entries_.clear(); }
+
+        // Bring the index in line with `dir`: stat every blueprint, index new
+        // or changed ones and drop deleted ones. Indexing verifies the
+        // signature and replays the journal (see index_blueprint), so changed
+        // files are indexed one task each across a worker pool of `threads`
+        // (0 = one per core). Returns the number of entries that changed.
+        size_t refresh(const std::string &dir, const std::string &secret, size_t threads = 0);
+
+    private:
+        std::vector<BlueprintIndexEntry> entries_;
+    };
+
+    // Index one blueprint as it would load: base plus journal (replayed with
+    // `secret`). Binary bases are mapped and read in place. False if the
+    // file cannot be read.
+    bool index_blueprint(const std::string &dir, const std::string &name, const std::string &secret,
+                         BlueprintIndexEntry &out, std::string *error = nullptr);
+
+    // Names of the blueprints in `dir` ("*.jarvis"), sorted
+    std::vector<std::string> list_blueprints(const std::string &dir);
+
+    // What a store pass does to each blueprint
+    struct StoreOptions
+    {
+        std::string dir = "blueprints";
+        std::string secret;      // current signing key (empty: plain SHA256)
+        std::string new_secret;  // with resign: key to sign with afterwards
+        bool verify = true;      // check signatures and journal chains
+        bool resign = false;     // rewrite signatures with new_secret
+        bool compact = false;    // fold journals, convert JSON to binary
+        bool index = true;       // write <dir>/_index.jarvisidx
+        size_t threads = 0;      // 0 = one per core
+    };
+
+    enum class StoreStatus
+    {
+        OK,
+        UNREADABLE,       // missing, truncated or malformed
+        MISSING_SIGNATURE,
+        BAD_SIGNATURE,
+        WRITE_FAILED
+    };
+
+    const char *store_status_name(StoreStatus status);
+
+    struct StoreFileResult
+    {
+        std::string name;
+        StoreStatus status = StoreStatus::OK;
+        std::string error;
+        size_t journal_records = 0; // replayed from the journal
+        bool resigned = false;
+        bool compacted = false;
+        BlueprintIndexEntry entry; // state after the pass
+    };
+
+    struct StoreReport
+    {
+        std::vector<StoreFileResult> files; // sorted by name
+        size_t ok = 0;
+        size_t failed = 0;
+        size_t resigned = 0;
+        size_t compacted = 0;
+        bool index_written = false;
+        uint64_t duration_us = 0;
+    };
+
+    // Verify / re-sign / compact every blueprint in options.dir, one file
+    // per task across a worker pool, then write the index. Files that fail
+    // verification are never rewritten and stay out of the index.
+    StoreReport run_store_pass(const StoreOptions &options);
+
+} // namespace sketch
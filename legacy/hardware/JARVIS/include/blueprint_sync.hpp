@@ -0,0 +1,177 @@
+#pragma once
+
+#include "sketch_pad.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class AsyncHttpClient;
+
+namespace sketch
+{
+
+    // Content-addressed line id: 16 hex chars of SHA256 over the line's
+    // coordinates, colour and thickness and `occurrence`, the number of
+    // identical lines before it (so duplicates get distinct ids).
+    std::string line_id(const Line &line, uint32_t occurrence = 0);
+
+    // What changed between two versions of a blueprint
+    struct LineDelta
+    {
+        uint64_t base = 0;    // server version the change applies on top of
+        uint64_t version = 0; // server version it produces (server answers)
+        bool full = false;    // answer is a complete snapshot (implies clear)
+        bool clear = false;   // drop every line of `base` first
+        std::vector<std::string> removed;
+        std::vector<std::pair<std::string, Line>> added;
+        bool grid_changed = false;
+        GridConfig grid;
+        std::string device;                            // author (push only)
+        std::map<std::string, uint64_t> version_vector; // pushes accepted per device
+
+        bool empty() const { return !clear && removed.empty() && added.empty() && !grid_changed; }
+    };
+
+    // Compact JSON: lines travel as [id, x0, y0, x1, y1, color, thickness].
+    // Decoding requires "version", which every server answer carries.
+    std::string encode_line_delta(const LineDelta &delta);
+    bool decode_line_delta(const std::string &json, LineDelta &delta);
+
+    // zlib-wrapped deflate ("Content-Encoding: deflate"). Both return false
+    // when built without zlib (JARVIS_HAVE_ZLIB) or on corrupt input.
+    bool deflate_body(const std::string &in, std::string &out);
+    bool inflate_body(const std::string &in, std::string &out);
+
+    struct SyncEndpoint
+    {
+        std::string host;
+        uint16_t port = 80;
+        bool use_tls = false;
+        std::string push_path; // POST target for deltas
+        std::string pull_path; // GET target; "?since=<version>" is appended
+        int timeout_ms = 3000;
+        bool compress = true;  // deflate large pushes, accept deflated pulls
+    };
+
+    enum class SyncResult
+    {
+        UP_TO_DATE,  // nothing to send or merge
+        SYNCED,      // changes went out and/or came in
+        CONFLICT,    // push refused because the server moved on (push() only)
+        UNSUPPORTED, // the server has no delta endpoints; use a full upload
+        FAILED
+    };
+
+    const char *sync_result_name(SyncResult result);
+
+    struct SyncStats
+    {
+        uint64_t pushes = 0;
+        uint64_t pulls = 0;
+        uint64_t conflicts = 0;       // pushes answered 409
+        uint64_t merges = 0;          // pulls that changed the pad
+        uint64_t lines_hashed = 0;    // line ids computed locally
+        uint64_t lines_sent = 0;      // added lines pushed
+        uint64_t lines_received = 0;  // added lines pulled
+        uint64_t bytes_sent = 0;      // request bodies as sent
+        uint64_t bytes_received = 0;  // response bodies as received
+    };
+
+    // Line-level delta sync of one blueprint with the server.
+    //
+    // The server keeps a version counter per blueprint; the client remembers
+    // the version and line ids it last agreed on (the base) and sends only
+    // the lines added or removed since, plus grid changes. Pulls ask for
+    // what happened after the base version. Line ids are cached per local
+    // line and only new lines are hashed, so a pass costs time and bytes in
+    // proportion to the edit, not the blueprint (a clear or a load rehashes
+    // once). Progress is kept in a small sidecar ("<file>.sync") so the next
+    // run can tell whether the local copy still matches the base; if it
+    // does not, the first pass pulls a full snapshot and keeps the union.
+    //
+    // Calls are serialized on an internal lock; use one instance per
+    // blueprint and pad.
+    class BlueprintSync
+    {
+    public:
+        BlueprintSync(AsyncHttpClient &http, std::string device_id, SyncEndpoint endpoint,
+                      std::string state_path);
+
+        // Pull what the server has since the base, merge it into the pad and
+        // push what only exists locally. `snapshot` is the pad content the
+        // pass works from (SketchPad::snapshot_content or a save snapshot).
+        SyncResult sync(SketchPad &pad, const SaveSnapshot &snapshot);
+        SyncResult sync(SketchPad &pad);
+        // Push local changes without touching the pad. Returns CONFLICT when
+        // the server has changes of its own; the next sync() merges them.
+        SyncResult push(const SaveSnapshot &snapshot);
+
+        uint64_t server_version() const;
+        std::map<std::string, uint64_t> version_vector() const;
+        SyncStats stats() const;
+        std::string last_error() const;
+
+    private:
+        // Local changes the server has not acknowledged yet
+        struct Pending
+        {
+            bool clear = false;
+            std::vector<std::pair<std::string, Line>> added; // local lines not in base_
+            std::unordered_set<std::string> removed;         // base_ ids no longer local
+        };
+
+        enum class PushOutcome
+        {
+            NOTHING,
+            ACCEPTED,
+            CONFLICT,
+            UNSUPPORTED,
+            FAILED
+        };
+
+        void prime(const SaveSnapshot &snapshot);
+        void track_local(const SaveSnapshot &snapshot);
+        void rebuild_local(const SaveSnapshot &snapshot);
+        void append_local(const Line &line, const std::string &id);
+        void forget_pending_add(const std::string &id);
+        SyncResult pull_and_merge(SketchPad &pad, const SaveSnapshot &snapshot, bool &changed, bool &refused);
+        PushOutcome push_pending();
+        void base_insert(const std::string &id);
+        void base_erase(const std::string &id);
+        void base_clear();
+        void merge_version_vector(const std::map<std::string, uint64_t> &other);
+        void save_state() const;
+        bool load_state(uint64_t &version, size_t &lines, uint64_t &digest, GridConfig &grid);
+
+        AsyncHttpClient &http_;
+        std::string device_;
+        SyncEndpoint endpoint_;
+        std::string state_path_;
+
+        mutable std::mutex mutex_;
+        bool primed_ = false;
+        // Ids of the pad's lines as of the last pass, in pad order
+        std::vector<std::string> ids_;
+        std::unordered_map<std::string, size_t> positions_;     // id -> index in ids_
+        std::unordered_map<std::string, uint32_t> occurrences_; // line content -> copies in ids_
+        uint64_t clear_epoch_ = 0;
+        uint64_t content_generation_ = 0;
+        GridConfig local_grid_;
+        // What the server has at server_version_
+        std::unordered_set<std::string> base_;
+        uint64_t base_sum_ = 0; // order-independent digest of base_
+        GridConfig base_grid_;
+        uint64_t server_version_ = 0;
+        std::map<std::string, uint64_t> version_vector_;
+        Pending pending_;
+        SyncStats stats_;
+        std::string last_error_;
+    };
+
+} // namespace sketch
@@ -96,6 +96,11 @@ namespace camera
     };
 
     // Represents a single camera frame
+    class FramePyramid;
+
+    // Levels in a frame pyramid: 1/2, 1/4 and 1/8 size
+    constexpr int kPyramidLevels = 3;
+
     struct Frame
     {
         std::vector<uint8_t> data; // Raw pixel data
@@ -103,18 +108,45 @@ namespace camera
         uint32_t width;        // Frame width
         uint32_t height;       // Frame height
         PixelFormat format;    // Pixel format
-        uint64_t timestamp_ns; // Capture timestamp (nanoseconds)
+        uint64_t timestamp_ns; // Capture time (ns, steady_clock; the camera uses read time); kept as-is by every later stage
         int stride;            // Bytes per row
+        uint64_t sequence;     // Sequence number from the source; gaps are missed frames
 
         // IMX500 metadata (if available)
         std::vector<IMX500PoseDetection> imx500_detections;
         std::vector<IMX500HandLandmark> imx500_hand_landmarks;
         bool has_imx500_metadata;
 
+        // Pixels borrowed from elsewhere (e.g. a Python buffer) instead of
+        // data; the owner keeps them alive while the frame is in use
+        const uint8_t *external;
+
+        // Low-resolution detection stream captured with this frame (same
+        // timestamp), owned by the source; null unless configured
+        const Frame *lores;
+
         // Constructor
         Frame() : data(), size(0), width(0), height(0),
-              format(PixelFormat::UNKNOWN), timestamp_ns(0), stride(0),
-              has_imx500_metadata(false) {}
+              format(PixelFormat::UNKNOWN), timestamp_ns(0), stride(0), sequence(0),
+              has_imx500_metadata(false), external(nullptr), lores(nullptr) {}
+
+        // Read-only pixel access for both owned and borrowed frames
+        const uint8_t *pixels() const { return external ? external : data.data(); }
+        bool has_pixels() const { return external ? size != 0 : !data.empty(); }
+
+        // RGB888 copy at 1/2^level size (level 1..kPyramidLevels), or null
+        // for other formats and frames too small. Levels are built on first
+        // request, only as deep as asked, and shared by every consumer of
+        // the frame (and copies borrowing the same pixels); new pixels,
+        // sequence or timestamp rebuild them. Safe to call from several
+        // threads at once. Call invalidate_pyramid() after editing pixels in
+        // place.
+        const Frame *pyramid_level(int level) const;
+        // The smallest level still at least min_width x min_height, or the
+        // frame itself; for consumers that resize to a fixed input size
+        const Frame &pyramid_for(uint32_t min_width, uint32_t min_height) const;
+        void invalidate_pyramid() const { pyramid.reset(); }
+        mutable std::shared_ptr<FramePyramid> pyramid;
 
         // Get pixel at (x, y) for RGB888
         bool get_rgb(uint32_t x, uint32_t y, uint8_t &r, uint8_t &g, uint8_t &b) const;
@@ -131,41 +163,99 @@ namespace camera
         uint32_t framerate; // Desired FPS (default: 30)
         PixelFormat format; // Desired format (default: RGB888)
         bool verbose;       // Enable verbose logging
+        int camera_index;   // Sensor index for multi-camera boards (default: 0)
+        // Shared-memory ring every raw frame is also exported to (see
+        // frame_ring.hpp); empty falls back to JARVIS_FRAME_RING, unset = off
+        std::string frame_ring;
+        uint32_t frame_ring_slots; // Ring depth (default: 4)
+        // Recording every raw frame is appended to (see frame_recording.hpp);
+        // empty falls back to JARVIS_RECORD, unset = off
+        std::string record;
+        // Recording served instead of the camera by make_frame_source();
+        // empty falls back to JARVIS_REPLAY
+        std::string replay;
+        float replay_fps; // 0 = recorded pace, > 0 fixed, < 0 unpaced (JARVIS_REPLAY_FPS)
+        bool replay_loop; // Start over at the end instead of stopping
+        // Secondary detection stream delivered as Frame::lores; 0 = off.
+        // Detectors use it instead of downscaling the main frame.
+        uint32_t lores_width;
+        uint32_t lores_height;
+        PixelFormat lores_format; // RGB888 (default) or YUV420
 
         CameraConfig() : width(640), height(480), framerate(30),
-                         format(PixelFormat::RGB888), verbose(false) {}
+                         format(PixelFormat::RGB888), verbose(false), camera_index(0),
+                         frame_ring(), frame_ring_slots(4), record(), replay(),
+                         replay_fps(0.0f), replay_loop(false), lores_width(0), lores_height(0),
+                         lores_format(PixelFormat::RGB888) {}
+
+        bool has_lores() const { return lores_width != 0 && lores_height != 0; }
+    };
+
+    // Fills lores with config's detection stream sampled from a full-size
+    // YUV420 (any lores_format) or RGB888 (RGB888 only) image. Sampling is
+    // nearest-neighbour straight from the source planes, so the cost is the
+    // small frame's pixel count. The caller sets the timestamp.
+    bool make_lores_frame(const CameraConfig &config, const uint8_t *pixels, PixelFormat format,
+                          uint32_t width, uint32_t height, Frame &lores);
+
+    // Where frames come from: the camera, or a recording (ReplaySource)
+    class FrameSource
+    {
+    public:
+        virtual ~FrameSource() = default;
+
+        virtual bool init(const CameraConfig &config) = 0;
+        virtual bool start() = 0;
+        virtual void stop() = 0;
+        // Next frame (blocking); valid until the next call, nullptr on error
+        virtual Frame *capture_frame() = 0;
+
+        virtual const CameraConfig &get_config() const = 0;
+        virtual bool is_running() const = 0;
+        virtual const std::string &get_error() const = 0;
+        // Frames skipped between captures (sequence gaps) since start()
+        virtual uint64_t get_missed_frames() const = 0;
     };
 
+    // A ReplaySource when config.replay or JARVIS_REPLAY names a recording,
+    // otherwise the camera; init() is left to the caller
+    std::unique_ptr<FrameSource> make_frame_source(const CameraConfig &config);
+
     // Camera interface for Raspberry Pi cameras via libcamera
-    class Camera
+    class Camera : public FrameSource
     {
     public:
         Camera();
-        ~Camera();
+        ~Camera() override;
 
         // Initialize camera with configuration
         // Returns true on success
-        bool init(const CameraConfig &config);
+        bool init(const CameraConfig &config) override;
 
         // Start camera capture
-        bool start();
+        bool start() override;
 
         // Stop camera capture
-        void stop();
+        void stop() override;
 
         // Capture a single frame (blocking)
         // Returns pointer to frame data (valid until next capture)
         // Returns nullptr on error
-        Frame *capture_frame();
+        Frame *capture_frame() override;
 
         // Get current configuration
-        const CameraConfig &get_config() const { return config_; }
+        const CameraConfig &get_config() const override { return config_; }
 
         // Check if camera is running
-        bool is_running() const { return running_; }
+        bool is_running() const override { return running_; }
 
         // Get last error message
-        const std::string &get_error() const { return last_error_; }
+        const std::string &get_error() const override { return last_error_; }
+
+        // Frame periods with no frame read, from gaps between arrivals.
+        // Counts consumer stalls as well as sensor drops; the pipe carries
+        // nothing that tells them apart.
+        uint64_t get_missed_frames() const override;
 
         // List available cameras (returns count)
         static int list_cameras();
@@ -194,11 +284,31 @@ namespace camera
         void yuv420_to_rgb888(const uint8_t *yuv, uint8_t *rgb,
                               uint32_t width, uint32_t height);
 
-        // Resize image (simple nearest-neighbor)
+        // YUV420 to RGB888 at another size (nearest-neighbor); same pixels
+        // as converting everything and then calling resize_nearest
+        void yuv420_to_rgb888_resized(const uint8_t *yuv, uint8_t *rgb,
+                                      uint32_t src_w, uint32_t src_h,
+                                      uint32_t dst_w, uint32_t dst_h);
+
+        // Resize a YUV420 image (nearest-neighbor, all three planes)
+        void yuv420_resize_nearest(const uint8_t *src, uint8_t *dst,
+                                   uint32_t src_w, uint32_t src_h,
+                                   uint32_t dst_w, uint32_t dst_h);
+
+        // Resize image (simple nearest-neighbor); src_stride is bytes per
+        // source row, 0 for packed rows
         void resize_nearest(const uint8_t *src, uint8_t *dst,
                             uint32_t src_w, uint32_t src_h,
                             uint32_t dst_w, uint32_t dst_h,
-                            int channels);
+                            int channels, size_t src_stride = 0);
+
+        // Halve an RGB888 image `levels` times (2x2 box average, odd edges
+        // dropped) in one pass: each finished row feeds the next level
+        // while still in cache. dst[i] holds (width >> (i + 1)) x
+        // (height >> (i + 1)) packed pixels. Uses NEON when available.
+        void rgb888_pyramid(const uint8_t *src, size_t src_stride,
+                            uint32_t width, uint32_t height,
+                            uint8_t *const *dst, int levels);
 
         // Convert RGB to grayscale
         void rgb_to_gray(const uint8_t *rgb, uint8_t *gray,
@@ -1,15 +1,109 @@
 #pragma once
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace crypto {
 
+// Lowercase hex of `len` bytes written to `out` (2 * len chars, no terminator)
+void hex_encode(const void* data, size_t len, char* out);
+std::string to_hex(const void* data, size_t len);
+
 // Encrypt plaintext using AES-256-CBC with the given secret key.
 // Returns hex-encoded ciphertext (including IV prepended).
 // On error, returns empty string.
+// The derived key and cipher context are cached per thread for the last
+// secret used, so repeated calls with one secret only pay for the cipher.
 std::string aes256_encrypt(const std::string& plaintext, const std::string& secret);
 // Compute HMAC-SHA256 hex string (lowercase) using key
 std::string hmac_sha256_hex(const std::string& data, const std::string& key);
 // Compute SHA256 hex string (lowercase)
 std::string sha256_hex(const std::string& data);
+// Raw-buffer variants (e.g. for mmap'd files; no copy into a string)
+std::string hmac_sha256_hex(const void* data, size_t len, const std::string& key);
+std::string sha256_hex(const void* data, size_t len);
+// Raw 32-byte digests
+void sha256(const void* data, size_t len, unsigned char out[32]);
+bool hmac_sha256(const void* data, size_t len, const std::string& key, unsigned char out[32]);
+
+// Reusable SHA256 context: init() / update() / final() as often as needed.
+// The context is ready after construction and again after every final().
+class Hasher {
+public:
+    Hasher();
+    ~Hasher();
+    Hasher(const Hasher&) = delete;
+    Hasher& operator=(const Hasher&) = delete;
+
+    bool init();
+    bool update(const void* data, size_t len);
+    bool final(unsigned char out[32]);
+    // Empty on error
+    std::string final_hex();
+
+private:
+    void* ctx_; // EVP_MD_CTX
+};
+
+// Reusable HMAC-SHA256 context for one key (EVP_MAC, or HMAC_CTX before
+// OpenSSL 3). The key is set once; init() restarts from it without
+// re-hashing the key.
+class Hmac {
+public:
+    explicit Hmac(const std::string& key);
+    ~Hmac();
+    Hmac(const Hmac&) = delete;
+    Hmac& operator=(const Hmac&) = delete;
+
+    bool ok() const { return ctx_ != nullptr; }
+    const std::string& key() const { return key_; }
+
+    bool init();
+    bool update(const void* data, size_t len);
+    bool final(unsigned char out[32]);
+    // Empty on error
+    std::string final_hex();
+
+private:
+    void* ctx_; // EVP_MAC_CTX
+    std::string key_;
+};
+
+// AES-256-CBC encryptor for one secret: the key is derived and scheduled
+// once, and each encrypt() only sets a fresh random IV.
+class AesEncryptor {
+public:
+    explicit AesEncryptor(const std::string& secret);
+    ~AesEncryptor();
+    AesEncryptor(const AesEncryptor&) = delete;
+    AesEncryptor& operator=(const AesEncryptor&) = delete;
+
+    bool ok() const { return ctx_ != nullptr; }
+    const std::string& secret() const { return secret_; }
+
+    // Same output as aes256_encrypt(): hex IV followed by hex ciphertext
+    std::string encrypt(const std::string& plaintext);
+
+private:
+    void* ctx_; // EVP_CIPHER_CTX
+    std::string secret_;
+    std::vector<unsigned char> buffer_;
+};
+
+// Incremental SHA256, or HMAC-SHA256 when constructed with a non-empty key.
+// Feeding the same bytes in any chunking gives the one-shot result.
+class DigestStream {
+public:
+    explicit DigestStream(const std::string& key = std::string());
+
+    void update(const void* data, size_t len);
+    // Lowercase hex digest; the stream is finished afterwards
+    std::string final_hex();
+
+private:
+    Hasher hasher_;
+    std::unique_ptr<Hmac> hmac_;
+};
 
 } // namespace crypto
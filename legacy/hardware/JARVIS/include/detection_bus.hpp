@@ -0,0 +1,190 @@
+#pragma once
+
+#include "hand_detector.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hand_detector
+{
+
+    // Hand detections published to other processes through POSIX shared
+    // memory (/dev/shm/<name>): one producer, any number of readers, no
+    // locks, no syscalls per record.
+    //
+    // Layout (little-endian, every offset fixed; mirrored by
+    // hardware/core/vision/detection_bus.py):
+    //
+    //   BusHeader                    64 bytes
+    //   slot[slot_count]             slot_size bytes each
+    //     uint64 seq                 2n+1 while record n is written, 2n+2 once done
+    //     BusRecordHeader            40 bytes
+    //     BusHand[max_hands]         96 bytes each
+    //
+    // Record n (0-based) lives in slot n % slot_count. A reader copies the
+    // slot and accepts it if seq read before and after the copy is 2n+2;
+    // anything else means not yet written, or overwritten because the
+    // reader fell a full ring behind. `published` in the header is the
+    // number of completed records.
+    struct BusHeader
+    {
+        char magic[4];        // "JRVD"
+        uint16_t version;     // kDetectionBusVersion
+        uint16_t header_size; // sizeof(BusHeader)
+        uint32_t slot_count;  // power of two
+        uint32_t slot_size;   // bytes, multiple of 64
+        uint32_t max_hands;   // BusHand entries per slot
+        uint32_t hand_size;   // sizeof(BusHand)
+        uint64_t epoch_ns;    // CLOCK_REALTIME at creation; changes on producer restart
+        uint64_t published;   // completed records (atomic)
+        uint32_t producer_pid;
+        uint32_t retired;     // set when the producer closes; readers reopen by name
+        uint8_t reserved[16];
+    };
+    static_assert(sizeof(BusHeader) == 64, "BusHeader layout changed");
+
+    struct BusRecordHeader
+    {
+        uint64_t frame_id;
+        uint64_t capture_ns;  // frame timestamp (camera clock, CLOCK_MONOTONIC)
+        uint64_t publish_ns;  // CLOCK_MONOTONIC when published
+        uint32_t frame_width;
+        uint32_t frame_height;
+        uint32_t hand_count;  // entries used, <= max_hands
+        uint32_t reserved;
+    };
+    static_assert(sizeof(BusRecordHeader) == 40, "BusRecordHeader layout changed");
+
+    struct BusHand
+    {
+        int32_t bbox_x, bbox_y, bbox_w, bbox_h;
+        float confidence;
+        int32_t center_x, center_y;
+        uint32_t gesture; // Gesture enum value
+        float gesture_confidence;
+        int32_t num_fingers;
+        uint32_t contour_area;
+        uint32_t fingertip_count; // <= kBusMaxFingertips
+        int32_t fingertips[5][2];
+        uint8_t reserved[8];
+    };
+    static_assert(sizeof(BusHand) == 96, "BusHand layout changed");
+
+    constexpr uint16_t kDetectionBusVersion = 1;
+    constexpr uint32_t kBusMaxFingertips = 5;
+    constexpr uint32_t kBusMaxHands = 16;
+
+    // Flat form of a detection, shared by the bus and the Python bindings
+    // (where it is the structured NumPy dtype). The contour is not carried;
+    // fingertips past kBusMaxFingertips are dropped.
+    BusHand to_bus_hand(const HandDetection &hand);
+    HandDetection from_bus_hand(const BusHand &hand);
+
+    struct DetectionBusConfig
+    {
+        std::string name = "/jarvis_detections"; // shm_open name
+        uint32_t slots = 256;                     // rounded up to a power of two
+        uint32_t max_hands = 4;                   // at most kBusMaxHands
+    };
+
+    // One record as read back
+    struct BusEvent
+    {
+        uint64_t seq = 0; // record number
+        uint64_t frame_id = 0;
+        uint64_t capture_ns = 0;
+        uint64_t publish_ns = 0;
+        uint32_t frame_width = 0;
+        uint32_t frame_height = 0;
+        std::vector<HandDetection> hands; // contour is not carried
+    };
+
+    // Producer side. Creates (or takes over) the segment; only one
+    // publisher per name may run at a time.
+    class DetectionPublisher
+    {
+    public:
+        DetectionPublisher() = default;
+        ~DetectionPublisher();
+
+        bool open(const DetectionBusConfig &config = DetectionBusConfig());
+        // Marks the segment retired and unmaps it. The name stays, so a
+        // restarted producer reuses it and readers follow.
+        void close();
+        // Remove a segment name (readers that have it mapped keep it)
+        static bool unlink(const std::string &name);
+        bool is_open() const { return base_ != nullptr; }
+        const std::string &error() const { return error_; }
+
+        // Publish one frame's detections; hands past max_hands and
+        // fingertips past five are dropped. Returns the record number.
+        uint64_t publish(uint64_t frame_id, uint64_t capture_ns, uint32_t width, uint32_t height,
+                         const std::vector<HandDetection> &hands);
+
+        uint64_t published() const { return next_; }
+
+    private:
+        uint8_t *base_ = nullptr;
+        size_t size_ = 0;
+        std::string name_;
+        std::string error_;
+        uint32_t slot_count_ = 0;
+        uint32_t slot_size_ = 0;
+        uint32_t max_hands_ = 0;
+        uint64_t next_ = 0;
+
+        DetectionPublisher(const DetectionPublisher &) = delete;
+        DetectionPublisher &operator=(const DetectionPublisher &) = delete;
+    };
+
+    // Reader side (other C++ processes, tests). Never writes to the segment.
+    class DetectionSubscriber
+    {
+    public:
+        DetectionSubscriber() = default;
+        ~DetectionSubscriber();
+
+        // Attach to an existing segment; reading starts at the newest record
+        bool open(const std::string &name = "/jarvis_detections");
+        void close();
+        bool is_open() const { return base_ != nullptr; }
+        const std::string &error() const { return error_; }
+
+        // The next unread record. False if there is none yet. A reader that
+        // fell more than a ring behind skips to the oldest record still
+        // there and counts the gap in missed().
+        bool next(BusEvent &out);
+        // Newest complete record, skipping anything older
+        bool latest(BusEvent &out);
+
+        uint64_t missed() const { return missed_; }
+        // Times the producer restarted or replaced the segment; reading
+        // continues with its new records
+        uint64_t restarts() const { return restarts_; }
+
+    private:
+        bool map(const std::string &name);
+        bool read_slot(uint64_t seq, BusEvent &out) const;
+        uint64_t published() const;
+        void follow_producer();
+
+        const uint8_t *base_ = nullptr;
+        size_t size_ = 0;
+        std::string name_;
+        std::string error_;
+        uint32_t slot_count_ = 0;
+        uint32_t slot_size_ = 0;
+        uint32_t max_hands_ = 0;
+        uint64_t epoch_ = 0;
+        uint64_t cursor_ = 0; // next record number to read
+        uint64_t missed_ = 0;
+        uint64_t restarts_ = 0;
+        std::chrono::steady_clock::time_point last_reopen_;
+
+        DetectionSubscriber(const DetectionSubscriber &) = delete;
+        DetectionSubscriber &operator=(const DetectionSubscriber &) = delete;
+    };
+
+} // namespace hand_detector
@@ -0,0 +1,83 @@
+#pragma once
+#include "live_lines.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace renderer {
+
+// Single-pass parser for the /dots response (see "API Response Format").
+//
+// Bytes can be fed in any split as they arrive from the socket. Every
+// object that has at least one of x0/y0/x1/y1 becomes a line (thickness 3
+// and white unless given), appended to the caller's vector; "clear" is
+// picked up wherever it appears. Numbers are truncated to integers. Only
+// the nesting stack is allocated, and it is reused across polls.
+class DotsParser
+{
+public:
+    // Lines go to `out` (appended); call reset() before each body
+    explicit DotsParser(std::vector<RenderLine> *out = nullptr) : out_(out) {}
+
+    void reset(std::vector<RenderLine> *out);
+    void feed(const char *data, size_t size);
+    // False if the body ended inside a value or object
+    bool finish();
+
+    bool has_clear() const { return has_clear_; }
+    bool clear() const { return clear_; }
+    bool saw_lines_key() const { return saw_lines_key_; }
+    // FNV-1a over every byte fed since reset()
+    uint64_t hash() const { return hash_; }
+
+private:
+    enum class Key : uint8_t { OTHER, X0, Y0, X1, Y1, THICKNESS, COLOR, CLEAR, LINES };
+    enum class State : uint8_t { VALUE, STRING, NUMBER, LITERAL };
+
+    struct Frame
+    {
+        bool object = false;
+        bool expect_key = false;
+        bool has_any = false;
+        RenderLine line;
+    };
+
+    void structural(char c);
+    void end_string();
+    void end_number();
+    void end_literal();
+    Key classify_key() const;
+
+    std::vector<RenderLine> *out_;
+    std::vector<Frame> stack_;
+    State state_ = State::VALUE;
+    bool string_is_key_ = false;
+    bool escape_ = false;
+    Key key_ = Key::OTHER;        // key of the value being read
+    char buf_[16];                // key, colour or literal text (first 16 bytes)
+    size_t buf_len_ = 0;
+    bool negative_ = false;
+    bool fraction_ = false;       // past '.', 'e' or 'E': digits no longer count
+    int64_t number_ = 0;
+    bool has_clear_ = false;
+    bool clear_ = false;
+    bool saw_lines_key_ = false;
+    uint64_t hash_ = 1469598103934665603ULL;
+};
+
+// Lines of the last /dots poll, kept so an unchanged response is neither
+// stored again nor redrawn
+struct DotsFrame
+{
+    std::vector<RenderLine> lines;
+    bool clear = true;
+    uint64_t hash = 0;
+    bool valid = false;   // the display shows `lines`
+    uint64_t polls = 0;
+    uint64_t redraws = 0;
+
+    // Something else drew on the display: the next poll redraws
+    void invalidate() { valid = false; }
+};
+
+} // namespace renderer
@@ -15,6 +15,14 @@ namespace draw_ticker
     void draw_line(void *map, uint32_t stride, uint32_t width, uint32_t height,
                    int x0, int y0, int x1, int y1, uint32_t color, int thickness);
 
+    // Partial repaints: the same, limited to the clip rectangle
+    // [clip_x0, clip_x1) x [clip_y0, clip_y1)
+    void clear_rect(void *map, uint32_t stride, uint32_t width, uint32_t height,
+                    int clip_x0, int clip_y0, int clip_x1, int clip_y1, uint32_t color);
+    void draw_line_clipped(void *map, uint32_t stride, uint32_t width, uint32_t height,
+                           int clip_x0, int clip_y0, int clip_x1, int clip_y1,
+                           int x0, int y0, int x1, int y1, uint32_t color, int thickness);
+
     // Animate a moving line between two points by repeatedly mapping/unmapping the GBM BO.
     // Parameters:
     // - fd, crtc_id, conn_id, mode, fb_id: DRM objects (main opens/selects device)
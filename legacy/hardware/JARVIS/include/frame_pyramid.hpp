@@ -0,0 +1,57 @@
+#pragma once
+
+#include "camera.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace camera
+{
+
+    // Half, quarter and eighth size RGB888 copies of one frame, built by
+    // utils::rgb888_pyramid as deep as has been asked for. Frames hold one through
+    // Frame::pyramid; use Frame::pyramid_level() rather than this directly.
+    //
+    // Pyramids come from a small pool, so the level buffers are allocated
+    // once and reused from frame to frame.
+    class FramePyramid
+    {
+    public:
+        FramePyramid() = default;
+
+        // From the pool; goes back to it when the last frame lets go
+        static std::shared_ptr<FramePyramid> acquire();
+
+        // Level 1..kPyramidLevels of `source`, rebuilding first if the
+        // pyramid was built from other pixels and extending it if it stops
+        // short of `level`; null if the level is empty
+        const Frame *level(const Frame &source, int level);
+        // True if built from these pixels
+        bool matches(const Frame &source) const;
+        // How many levels are built, 0..kPyramidLevels
+        int built_levels() const;
+
+    private:
+        struct Key
+        {
+            const uint8_t *pixels = nullptr;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            int stride = 0;
+            uint64_t timestamp_ns = 0;
+            uint64_t sequence = 0;
+        };
+        static Key key_of(const Frame &source);
+        static bool same(const Key &a, const Key &b);
+        void build(const Frame &source, int level);
+
+        mutable std::mutex mutex_;
+        Key key_;
+        int built_levels_ = 0; // 0 until built from key_
+        Frame levels_[kPyramidLevels];
+
+        FramePyramid(const FramePyramid &) = delete;
+        FramePyramid &operator=(const FramePyramid &) = delete;
+    };
+
+} // namespace camera
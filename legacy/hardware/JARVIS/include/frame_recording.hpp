@@ -0,0 +1,207 @@
+#pragma once
+
+#include "camera.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace camera
+{
+
+    // Camera capture recorded to a file and served back later, so the
+    // detector and pipeline run headless and repeatably on any Linux box.
+    //
+    // Layout (little-endian; records and the index are 64-byte aligned):
+    //
+    //   RecordingHeader              64 bytes
+    //   record[frame_count]
+    //     RecordHeader               64 bytes
+    //     pixels                     bytes, zero-padded to 64
+    //     IMX500PoseDetection[pose_count], IMX500HandLandmark[hand_count],
+    //                                zero-padded to 64
+    //   RecordingIndexEntry[frame_count]
+    //
+    // The index and the header's frame_count/index_offset are written on
+    // close. A recording cut short (crash, power loss) has index_offset 0
+    // and is recovered by walking the records.
+    struct RecordingHeader
+    {
+        char magic[4];         // "JRVC"
+        uint16_t version;      // kRecordingVersion
+        uint16_t header_size;  // sizeof(RecordingHeader)
+        uint32_t record_header_size;
+        uint32_t reserved0;
+        uint64_t created_ns;   // CLOCK_REALTIME
+        uint64_t frame_count;  // 0 until closed
+        uint64_t index_offset; // 0 until closed
+        uint8_t reserved[24];
+    };
+    static_assert(sizeof(RecordingHeader) == 64, "RecordingHeader layout changed");
+
+    struct RecordHeader
+    {
+        char magic[4];         // "JRFR"
+        uint32_t format;       // PixelFormat
+        uint64_t frame_id;
+        uint64_t timestamp_ns; // capture time, CLOCK_MONOTONIC
+        uint32_t width;
+        uint32_t height;
+        uint32_t stride;
+        uint32_t bytes;        // pixel bytes
+        uint32_t pose_count;
+        uint32_t hand_count;
+        uint64_t record_size;  // this header to the next record
+        uint8_t reserved[8];
+    };
+    static_assert(sizeof(RecordHeader) == 64, "RecordHeader layout changed");
+
+    struct RecordingIndexEntry
+    {
+        uint64_t offset;
+        uint64_t timestamp_ns;
+    };
+    static_assert(sizeof(RecordingIndexEntry) == 16, "RecordingIndexEntry layout changed");
+
+    constexpr uint16_t kRecordingVersion = 1;
+
+    // Where to record to / replay from: the config value, else JARVIS_RECORD /
+    // JARVIS_REPLAY; camera N > 0 uses name_N.ext. Empty when off.
+    std::string recording_path(const CameraConfig &config);
+    std::string replay_path(const CameraConfig &config);
+
+    // Appends frames to a recording. Writes are buffered; nothing is
+    // mapped on this side.
+    class FrameRecorder
+    {
+    public:
+        FrameRecorder() = default;
+        ~FrameRecorder();
+
+        bool open(const std::string &path);
+        // Writes the index; the recording is complete only after this
+        bool close();
+        bool is_open() const { return file_ != nullptr; }
+        const std::string &error() const { return error_; }
+        uint64_t frames() const { return index_.size(); }
+
+        // The frame's own pixels and metadata
+        bool write(uint64_t frame_id, const Frame &frame);
+        // Other pixels (e.g. the raw YUV420 the frame was converted from)
+        // with the frame's timestamp, size and IMX500 metadata
+        bool write(uint64_t frame_id, const Frame &frame, const uint8_t *pixels, uint32_t bytes,
+                   PixelFormat format, uint32_t stride);
+
+    private:
+        RecordingHeader make_header() const;
+        bool put(const void *data, size_t bytes);
+        bool pad();
+        bool fail(const std::string &what);
+
+        FILE *file_ = nullptr;
+        std::string path_;
+        std::string error_;
+        uint64_t offset_ = 0;
+        uint64_t created_ns_ = 0;
+        std::vector<RecordingIndexEntry> index_;
+
+        FrameRecorder(const FrameRecorder &) = delete;
+        FrameRecorder &operator=(const FrameRecorder &) = delete;
+    };
+
+    // One recorded frame; pointers go into the reader's mapping
+    struct RecordingView
+    {
+        uint64_t frame_id = 0;
+        uint64_t timestamp_ns = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        PixelFormat format = PixelFormat::UNKNOWN;
+        uint32_t stride = 0;
+        uint32_t bytes = 0;
+        const uint8_t *data = nullptr;
+        uint32_t pose_count = 0;
+        uint32_t hand_count = 0;
+        const uint8_t *metadata = nullptr;
+    };
+
+    // Maps a recording read-only; frames are read in place
+    class FrameRecording
+    {
+    public:
+        FrameRecording() = default;
+        ~FrameRecording();
+
+        bool open(const std::string &path);
+        void close();
+        bool is_open() const { return base_ != nullptr; }
+        const std::string &error() const { return error_; }
+
+        size_t size() const { return index_.size(); }
+        // False when the recording was cut short and recovered by scanning
+        bool indexed() const { return indexed_; }
+        bool frame(size_t i, RecordingView &out) const;
+        // Fills the frame's IMX500 fields from the view
+        static void copy_metadata(const RecordingView &view, Frame &frame);
+
+    private:
+        bool fail(const std::string &what);
+        bool record_at(uint64_t offset, RecordHeader &out) const;
+
+        const uint8_t *base_ = nullptr;
+        size_t size_ = 0;
+        std::string error_;
+        std::vector<RecordingIndexEntry> index_;
+        bool indexed_ = false;
+
+        FrameRecording(const FrameRecording &) = delete;
+        FrameRecording &operator=(const FrameRecording &) = delete;
+    };
+
+    // Serves a recording in place of the camera. Frames keep their recorded
+    // timestamps, sequence numbers and IMX500 metadata; YUV420 records are converted to RGB888
+    // exactly as Camera does, RGB888 records are borrowed from the mapping.
+    // A configured detection stream (lores_*) is produced as Camera does.
+    //
+    // Pace: config.replay_fps 0 = as recorded, > 0 = fixed rate,
+    // < 0 = as fast as the caller takes them.
+    class ReplaySource : public FrameSource
+    {
+    public:
+        ReplaySource() = default;
+        ~ReplaySource() override = default;
+
+        // Opens config.replay; width and height come from the recording
+        bool init(const CameraConfig &config) override;
+        bool start() override;
+        void stop() override;
+        Frame *capture_frame() override;
+
+        const CameraConfig &get_config() const override { return config_; }
+        bool is_running() const override { return running_; }
+        const std::string &get_error() const override { return last_error_; }
+        // Gaps in the recorded frame ids
+        uint64_t get_missed_frames() const override { return missed_; }
+
+        const FrameRecording &recording() const { return recording_; }
+        uint64_t frames_served() const { return served_; }
+
+    private:
+        CameraConfig config_;
+        FrameRecording recording_;
+        Frame frame_;
+        Frame lores_; // detection stream, when configured
+        bool running_ = false;
+        std::string last_error_;
+        size_t next_ = 0;
+        uint64_t served_ = 0;
+        uint64_t loop_offset_ns_ = 0;  // keeps timestamps rising across loops
+        uint64_t loop_offset_seq_ = 0; // and sequence numbers
+        uint64_t missed_ = 0;
+        std::chrono::steady_clock::time_point start_;
+        uint64_t start_timestamp_ns_ = 0;
+    };
+
+} // namespace camera
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "camera.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace camera
+{
+
+    // Camera frames exported to other processes through POSIX shared memory
+    // (/dev/shm/<name>). The camera reads each frame straight into a ring
+    // slot, so exporting costs no copy and readers never slow capture down.
+    //
+    // Layout (little-endian; mirrored by hardware/core/vision/frame_ring.py):
+    //
+    //   FrameRingHeader              64 bytes
+    //   slot[slot_count]             slot_size bytes each (multiple of 4096)
+    //     FrameSlotHeader            64 bytes; seq first
+    //     pixel data                 up to frame_capacity bytes
+    //
+    // Frame n (0-based) lives in slot n % slot_count. seq is 2n+1 while the
+    // producer fills the slot and 2n+2 once it is complete. A reader checks
+    // seq, uses the pixels in place, then checks seq again: if it changed,
+    // the producer lapped the reader and whatever it read is discarded.
+    struct FrameRingHeader
+    {
+        char magic[4];           // "JRVF"
+        uint16_t version;        // kFrameRingVersion
+        uint16_t header_size;    // sizeof(FrameRingHeader)
+        uint32_t slot_count;     // power of two
+        uint32_t slot_size;      // bytes, slot header included
+        uint32_t frame_capacity; // largest frame a slot holds
+        uint32_t reserved0;
+        uint64_t epoch_ns;       // CLOCK_REALTIME at creation; changes on producer restart
+        uint64_t published;      // completed frames (atomic)
+        uint32_t producer_pid;
+        uint32_t retired;        // set when the producer closes; readers reopen by name
+        uint8_t reserved[16];
+    };
+    static_assert(sizeof(FrameRingHeader) == 64, "FrameRingHeader layout changed");
+
+    struct FrameSlotHeader
+    {
+        uint64_t seq;
+        uint64_t frame_id;
+        uint64_t timestamp_ns; // capture time, CLOCK_MONOTONIC
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;       // PixelFormat: 0 RGB888, 1 RGBA8888, 2 YUV420 (I420 planes)
+        uint32_t stride;       // bytes per row of the first plane
+        uint32_t bytes;        // pixel bytes used
+        uint32_t reserved[5];
+    };
+    static_assert(sizeof(FrameSlotHeader) == 64, "FrameSlotHeader layout changed");
+
+    constexpr uint16_t kFrameRingVersion = 1;
+
+    struct FrameRingConfig
+    {
+        std::string name = "/jarvis_frames"; // shm_open name
+        uint32_t slots = 4;                  // rounded up to a power of two
+        uint32_t frame_capacity = 0;         // bytes per frame
+    };
+
+    // A frame as seen by a reader. data points into the shared mapping: it
+    // is only trustworthy while FrameRingReader::valid() says so, and only
+    // usable until the reader's next next()/latest() call.
+    struct FrameRingView
+    {
+        uint64_t seq = 0; // frame number in the ring
+        uint64_t frame_id = 0;
+        uint64_t timestamp_ns = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        PixelFormat format = PixelFormat::UNKNOWN;
+        uint32_t stride = 0;
+        uint32_t bytes = 0;
+        const uint8_t *data = nullptr;
+    };
+
+    // Producer side; one per name at a time
+    class FrameRingWriter
+    {
+    public:
+        FrameRingWriter() = default;
+        ~FrameRingWriter();
+
+        bool open(const FrameRingConfig &config);
+        // Marks the ring retired and unmaps it; the name stays for a restart
+        void close();
+        static bool unlink(const std::string &name);
+        bool is_open() const { return base_ != nullptr; }
+        const std::string &error() const { return error_; }
+        uint32_t capacity() const { return frame_capacity_; }
+
+        // Slot for the next frame, to be filled in place and then committed
+        // (or aborted). Returns the same slot until then.
+        uint8_t *begin_frame();
+        // Publishes the slot from begin_frame(); returns the frame number
+        uint64_t commit_frame(uint64_t frame_id, uint64_t timestamp_ns, uint32_t width, uint32_t height,
+                              PixelFormat format, uint32_t stride, uint32_t bytes);
+        // The slot holds nothing usable (e.g. a short read)
+        void abort_frame();
+
+        uint64_t published() const { return next_; }
+
+    private:
+        uint8_t *slot(uint64_t n) const;
+
+        uint8_t *base_ = nullptr;
+        size_t size_ = 0;
+        std::string error_;
+        uint32_t slot_count_ = 0;
+        uint32_t slot_size_ = 0;
+        uint32_t frame_capacity_ = 0;
+        uint64_t next_ = 0;
+        bool writing_ = false;
+
+        FrameRingWriter(const FrameRingWriter &) = delete;
+        FrameRingWriter &operator=(const FrameRingWriter &) = delete;
+    };
+
+    // Reader side. Maps the ring read-only; nothing it does is visible to
+    // the producer.
+    class FrameRingReader
+    {
+    public:
+        FrameRingReader() = default;
+        ~FrameRingReader();
+
+        // Attach to an existing ring; reading starts at the newest frame
+        bool open(const std::string &name = "/jarvis_frames");
+        void close();
+        bool is_open() const { return base_ != nullptr; }
+        const std::string &error() const { return error_; }
+
+        // Next unread frame, or the oldest one still in the ring if the
+        // reader fell behind (the gap is counted in missed())
+        bool next(FrameRingView &out);
+        // Newest complete frame, skipping anything older
+        bool latest(FrameRingView &out);
+        // True while the frame's pixels have not been overwritten; check
+        // after using view.data in place
+        bool valid(const FrameRingView &view) const;
+        // Copy out the pixels; false if the frame was overwritten meanwhile
+        bool copy(const FrameRingView &view, std::vector<uint8_t> &out) const;
+
+        uint64_t missed() const { return missed_; }
+        uint64_t restarts() const { return restarts_; }
+
+    private:
+        bool map(const std::string &name);
+        bool read_slot(uint64_t n, FrameRingView &out) const;
+        uint64_t published() const;
+        void follow_producer();
+
+        const uint8_t *base_ = nullptr;
+        size_t size_ = 0;
+        std::string name_;
+        std::string error_;
+        uint32_t slot_count_ = 0;
+        uint32_t slot_size_ = 0;
+        uint32_t frame_capacity_ = 0;
+        uint64_t epoch_ = 0;
+        uint64_t cursor_ = 0;
+        uint64_t missed_ = 0;
+        uint64_t restarts_ = 0;
+        std::chrono::steady_clock::time_point last_reopen_;
+
+        FrameRingReader(const FrameRingReader &) = delete;
+        FrameRingReader &operator=(const FrameRingReader &) = delete;
+    };
+
+} // namespace camera
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sketch
+{
+
+    struct Point;
+
+    // Solve the 3x3 homography H (row-major, H[8] == 1) mapping src[i] -> dst[i].
+    // Uses the normalized DLT: exact for 4 points, least squares for n > 4.
+    // Returns false for n < 4 or degenerate (e.g. collinear) input.
+    bool solve_homography(const Point *src, const Point *dst, size_t n, double H[9]);
+
+    // Invert a homography. Returns false if H is singular.
+    bool invert_homography(const double H[9], double out[9]);
+
+    // Apply H to (x, y) with projective divide. Returns false at infinity.
+    bool apply_homography(const double H[9], double x, double y, double &ox, double &oy);
+
+    // Precomputed lookup that maps source pixels through a homography.
+    //
+    // The homography is defined in percentage space (0-100 on both sides, as
+    // used by ProjectorCalibration). The grid samples H once per `cell` source
+    // pixels at build time; map() is then a bilinear blend of four nodes, so
+    // per-frame cost is constant regardless of how the homography was solved.
+    // Fixed-point storage (Q16.16 percent) is the same size as float. It
+    // blends the four nodes with integer weights, so results do not depend on
+    // the target's float rounding; coordinates still go in and out as float.
+    class RemapGrid
+    {
+    public:
+        RemapGrid() = default;
+
+        // Build for a src_width x src_height pixel source. `cell` is the node
+        // spacing in source pixels (smaller = more accurate, more memory).
+        bool build(const double H[9], uint32_t src_width, uint32_t src_height,
+                   uint32_t cell = 8, bool fixed_point = false);
+        void reset();
+
+        bool valid() const { return cols_ > 0; }
+        bool fixed_point() const { return fixed_point_; }
+        uint32_t src_width() const { return src_width_; }
+        uint32_t src_height() const { return src_height_; }
+        uint32_t cell() const { return cell_; }
+
+        // Map a source pixel to destination percentage coordinates.
+        // Pixels outside the source are clamped to the border.
+        void map(float px, float py, float &out_x, float &out_y) const;
+
+    private:
+        uint32_t src_width_ = 0;
+        uint32_t src_height_ = 0;
+        uint32_t cell_ = 0;
+        uint32_t cols_ = 0; // nodes per row
+        uint32_t rows_ = 0;
+        bool fixed_point_ = false;
+        std::vector<float> nodes_f_;   // interleaved x,y
+        std::vector<int32_t> nodes_q_; // interleaved x,y in Q16.16
+    };
+
+} // namespace sketch
@@ -1,7 +1,67 @@
 #pragma once
 #include <string>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 
+// Shared by every HttpClient in the process
+struct HttpPoolConfig
+{
+    bool keep_alive = true;        // reuse connections between requests
+    size_t max_idle_per_host = 4;  // idle connections kept per host:port
+    int idle_timeout_ms = 30000;   // drop idle connections older than this
+    int dns_ttl_ms = 60000;        // reuse getaddrinfo results this long (0 = off)
+};
+
+struct HttpPoolStats
+{
+    uint64_t requests = 0;
+    uint64_t connects = 0;       // new TCP connections
+    uint64_t reuses = 0;         // requests sent on a pooled connection
+    uint64_t retries = 0;        // pooled connection was dead; resent on a new one
+    uint64_t dns_lookups = 0;    // getaddrinfo calls
+    uint64_t dns_cache_hits = 0;
+    uint64_t tls_handshakes = 0;
+    uint64_t tls_resumed = 0;    // handshakes that resumed a cached session
+    size_t idle = 0;             // connections currently parked in the pool
+};
+
+// Validators of a cached response, sent back as If-None-Match /
+// If-Modified-Since so an unchanged resource costs a 304 and no body
+struct HttpValidators
+{
+    std::string etag;
+    std::string last_modified;
+    uint64_t size = 0; // body bytes of the cached copy (what a 304 saves)
+
+    bool empty() const { return etag.empty() && last_modified.empty(); }
+    // Kept in a small text file next to the cached copy. save() of empty
+    // validators removes the file.
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+};
+
+// Conditional GETs, shared by every HttpClient in the process
+struct HttpCacheStats
+{
+    uint64_t hits = 0;             // 304: the cached copy is current
+    uint64_t misses = 0;           // body downloaded (no validators, or changed)
+    uint64_t bytes_downloaded = 0; // body bytes of misses
+    uint64_t bytes_saved = 0;      // cached sizes of hits
+};
+
+enum class HttpFetch
+{
+    MODIFIED,     // new body (and validators) received
+    NOT_MODIFIED, // 304; keep using the cached copy
+    FAILED
+};
+
+// Blocking HTTP/1.1 client.
+//
+// Connections are kept alive in a process-wide pool keyed by host, port and
+// scheme, so constructing an HttpClient per request is cheap. TLS uses one
+// long-lived SSL_CTX and resumes the last session for each host.
 class HttpClient
 {
 public:
@@ -14,8 +74,45 @@ public:
                      const std::string &body, const std::string &content_type = "application/json",
                      int timeout_ms = 3000, bool use_tls = false);
 
+    // Body bytes of a successful response as they arrive; return false to abort
+    using BodyCallback = std::function<bool(const char *data, size_t size)>;
+
+    // GET into out, reusing its capacity across calls; false on error
+    bool get_into(const std::string &host, uint16_t port, const std::string &path, std::string &out,
+                  int timeout_ms = 3000, bool use_tls = false);
+
+    // GET and hand the body to on_data piece by piece without buffering it
+    bool get_stream(const std::string &host, uint16_t port, const std::string &path,
+                    const BodyCallback &on_data, int timeout_ms = 3000, bool use_tls = false);
+
+    // GET revalidating a cached copy. On MODIFIED `out` holds the body and
+    // `validators` the response's; on NOT_MODIFIED neither is touched.
+    HttpFetch get_if_modified(const std::string &host, uint16_t port, const std::string &path,
+                              HttpValidators &validators, std::string &out,
+                              int timeout_ms = 3000, bool use_tls = false);
+
     const std::string &last_error() const { return last_error_; }
+    // Status of the last response received (0 if none)
+    int last_status() const { return last_status_; }
+
+    static void set_pool_config(const HttpPoolConfig &config);
+    static HttpPoolConfig pool_config();
+    static HttpPoolStats pool_stats();
+    static HttpCacheStats cache_stats();
+    // Close idle connections (TLS sessions and DNS entries are kept)
+    static void close_idle_connections();
+    // Close idle connections, forget TLS sessions and DNS entries, zero the
+    // pool and cache stats
+    static void reset_pool();
 
 private:
+    // The body goes into *into, or to on_data when into is null. With
+    // `validators` the request is conditional: a 304 succeeds (empty body)
+    // and the response's validators are stored back.
+    bool request(const char *method, const std::string &host, uint16_t port, const std::string &path,
+                 const std::string *body, const std::string &content_type, int timeout_ms, bool use_tls,
+                 std::string *into, const BodyCallback &on_data, HttpValidators *validators = nullptr);
+
     std::string last_error_;
+    int last_status_ = 0;
 };
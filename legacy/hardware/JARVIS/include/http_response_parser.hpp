@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Incremental HTTP/1.x response parser.
+//
+// Bytes are fed as they come off the socket, in pieces of any size. The
+// status line and headers are parsed as they complete. The body is framed
+// by Content-Length, chunked transfer encoding or end-of-stream, and its
+// bytes go straight to a sink callback (or an internal string) without the
+// raw response ever being buffered.
+class HttpResponseParser
+{
+public:
+    // Receives body bytes in order; return false to abort the response
+    using BodySink = std::function<bool(const char *data, size_t size)>;
+
+    // Largest body collected into body() before the response fails
+    static const uint64_t kDefaultMaxBody = 64ull * 1024 * 1024;
+
+    enum class Framing
+    {
+        NONE,           // no body (HEAD, 204, 304)
+        CONTENT_LENGTH,
+        CHUNKED,
+        UNTIL_EOF       // body ends when the server closes the connection
+    };
+
+    // head_request: the response to a HEAD has headers only
+    explicit HttpResponseParser(bool head_request = false) { reset(head_request); }
+
+    // Start over for a new response (the sink is kept)
+    void reset(bool head_request = false);
+
+    // Without a sink the body accumulates in body()
+    void set_body_sink(BodySink sink) { sink_ = std::move(sink); }
+    // Limit for body(); a sink sees every byte regardless (kept across reset)
+    void set_max_body(uint64_t bytes) { max_body_ = bytes; }
+    uint64_t max_body() const { return max_body_; }
+
+    // Consume bytes; returns how many were used. Stops at the end of the
+    // response, so anything left over belongs to whatever comes after it.
+    size_t feed(const char *data, size_t size);
+    // The peer closed the connection; completes an end-of-stream body
+    void finish_eof();
+
+    bool done() const { return state_ == State::DONE; }
+    bool failed() const { return state_ == State::FAILED; }
+    bool headers_complete() const { return headers_complete_; }
+    const std::string &error() const { return error_; }
+
+    int status() const { return status_; }
+    int http_minor() const { return minor_; }
+    // Header names are lowercased
+    const std::vector<std::pair<std::string, std::string>> &headers() const { return headers_; }
+    // Value of the first header with this (lowercase) name, or empty
+    const std::string &header(const char *lower_name) const;
+    Framing framing() const { return framing_; }
+    long long content_length() const { return content_length_; }
+    // The server will keep the connection open after this response
+    bool keep_alive() const { return keep_alive_; }
+
+    std::string &body() { return body_; }
+    uint64_t bytes_fed() const { return bytes_fed_; }
+    uint64_t body_bytes() const { return body_bytes_; }
+
+private:
+    enum class State
+    {
+        STATUS_LINE,
+        HEADERS,
+        BODY,          // Content-Length or until EOF
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_END, // CRLF after chunk data
+        TRAILERS,
+        DONE,
+        FAILED
+    };
+
+    // Collects a CRLF-terminated line across feeds; true once complete
+    bool take_line(const char *&p, const char *end);
+    bool on_status_line();
+    bool on_header_line();
+    bool on_headers_done();
+    bool emit(const char *data, size_t size);
+    void fail(const char *message);
+
+    State state_ = State::STATUS_LINE;
+    bool head_request_ = false;
+    bool headers_complete_ = false;
+    int status_ = 0;
+    int minor_ = 1;
+    std::vector<std::pair<std::string, std::string>> headers_;
+    Framing framing_ = Framing::NONE;
+    long long content_length_ = -1;
+    bool keep_alive_ = false;
+    uint64_t remaining_ = 0; // of the body or current chunk
+    std::string line_;
+    std::string body_;
+    BodySink sink_;
+    uint64_t max_body_ = kDefaultMaxBody;
+    std::string error_;
+    uint64_t bytes_fed_ = 0;
+    uint64_t body_bytes_ = 0;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+// Process-wide DNS cache and TLS state shared by HttpClient and
+// AsyncHttpClient (implemented in http_client.cpp, configured through
+// HttpClient::set_pool_config and counted in HttpClient::pool_stats).
+
+#include <openssl/ssl.h>
+#include <sys/socket.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace http_shared
+{
+
+    struct Address
+    {
+        struct sockaddr_storage addr;
+        socklen_t len = 0;
+        int family = 0;
+        int socktype = 0;
+        int protocol = 0;
+    };
+
+    // getaddrinfo through the DNS cache; blocks on a miss
+    bool resolve(const std::string &host, uint16_t port, std::vector<Address> &out, std::string &error);
+    // None of the resolved addresses answered; look the host up again next time
+    void forget_address(const std::string &host, uint16_t port);
+    std::string address_string(const Address &a);
+
+    // The long-lived client context (nullptr if OpenSSL could not create it)
+    SSL_CTX *tls_context();
+    // Per-host session resumption; key is "https://host:port"
+    void apply_session(const std::string &key, SSL *ssl);
+    void save_session(const std::string &key, SSL *ssl);
+    void forget_session(const std::string &key);
+
+} // namespace http_shared
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sketch
+{
+
+    struct Line;
+    struct GridConfig;
+
+    enum class JournalOp : uint8_t
+    {
+        ADD_LINE = 1,
+        CLEAR = 2,
+        GRID = 3
+    };
+
+    // One decoded journal entry (only the fields relevant to `op` are set)
+    struct JournalRecord
+    {
+        JournalOp op;
+        float x0, y0, x1, y1;
+        uint32_t color;
+        int32_t thickness;
+        float grid_spacing_percent;
+        float real_world_spacing_cm;
+        uint32_t grid_flags; // kGridSnap | kGridMeasurements
+
+        JournalRecord() : op(JournalOp::CLEAR), x0(0), y0(0), x1(0), y1(0), color(0), thickness(0),
+                          grid_spacing_percent(0), real_world_spacing_cm(0), grid_flags(0) {}
+    };
+
+    // Append-only, hash-chained change log kept next to a blueprint
+    // ("<file>.jarvis.journal").
+    //
+    // Every record carries MAC(prev_mac || record) (HMAC-SHA256 with the
+    // secret, SHA256 without). The chain starts from a hash of the base
+    // file's signature, so a journal left over after the base was rewritten
+    // (compaction, crash between the two) is recognised as stale. A torn or
+    // corrupt tail is cut at the last good record, so a crash loses at most
+    // the record being written.
+    //
+    // Replacing the base stages the next journal at staged_path() first;
+    // open() adopts it once its base is the one being opened, and drops it
+    // otherwise, so some journal matches whichever base survives a crash.
+    class LineJournal
+    {
+    public:
+        LineJournal() = default;
+        ~LineJournal();
+
+        // Open or create the journal for a base whose signature is
+        // `base_signature`, adopting a staged journal anchored to it. Valid
+        // records are appended to `replay`.
+        bool open(const std::string &path, const std::string &base_signature,
+                  const std::string &secret, std::vector<JournalRecord> *replay);
+        void close();
+        bool is_open() const { return fd_ >= 0; }
+
+        // Queue records; nothing reaches the disk until sync()
+        void append_line(const Line &line);
+        void append_clear();
+        void append_grid(const GridConfig &grid);
+
+        // Write queued records and fdatasync once. Returns false on I/O error
+        // (the journal is then closed and the caller should rewrite the base).
+        bool sync();
+
+        // Start over against a new base (after compaction)
+        bool reset(const std::string &base_signature);
+
+        const std::string &path() const { return path_; }
+        // Where the journal for a replacement base is written before the swap
+        static std::string staged_path(const std::string &path);
+        size_t record_count() const { return records_; }
+        uint64_t size_bytes() const { return size_; }
+
+        static void apply(const JournalRecord &record, std::vector<Line> &lines, GridConfig &grid);
+
+    private:
+        void append(JournalOp op, const void *payload, size_t length);
+        bool write_header(const std::string &base_signature);
+
+        int fd_ = -1;
+        std::string path_;
+        std::string secret_;
+        uint8_t chain_[32] = {}; // MAC of the last record (or the anchor)
+        uint64_t seq_ = 0;
+        size_t records_ = 0;
+        uint64_t size_ = 0;
+        std::string pending_; // encoded records not yet written
+
+        LineJournal(const LineJournal &) = delete;
+        LineJournal &operator=(const LineJournal &) = delete;
+    };
+
+} // namespace sketch
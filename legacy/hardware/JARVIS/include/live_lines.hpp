@@ -0,0 +1,200 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace renderer {
+
+// A line as drawn on the display (pixels, 0x00RRGGBB)
+struct RenderLine
+{
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    int thickness = 3;
+    uint32_t color = 0x00FFFFFF;
+};
+
+// Screen area [x0, x1) x [y0, y1) that needs repainting
+struct DirtyRect
+{
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+    void add(int ax0, int ay0, int ax1, int ay1);
+    void add(const RenderLine &line); // the pixels draw_line touches
+};
+
+// One Server-Sent Events message
+struct SseEvent
+{
+    std::string type = "message";
+    std::string data;
+    std::string id;
+};
+
+// Incremental text/event-stream parser: feed bytes as they arrive, get a
+// callback per complete event. Handles \n, \r\n and \r line ends split
+// across reads.
+class SseParser
+{
+public:
+    using Handler = std::function<void(const SseEvent &)>;
+
+    void feed(const char *data, size_t size, const Handler &on_event);
+    void reset();
+
+private:
+    void line(const Handler &on_event);
+
+    std::string line_;
+    SseEvent event_;
+    bool has_data_ = false;
+    bool skip_lf_ = false;
+};
+
+// Change to the set of lines on screen, as streamed by the server:
+//   event: add       data: {"id", "x0", "y0", "x1", "y1", "thickness", "color": "#RRGGBB"}
+//   event: remove    data: {"id"}
+//   event: clear
+//   event: snapshot  data: {"lines": [<add data>...]}  (replaces everything)
+// The SSE id is the server's sequence number, used to resume.
+struct LineEvent
+{
+    enum Type
+    {
+        ADD,
+        REMOVE,
+        CLEAR,
+        SNAPSHOT
+    };
+    Type type = ADD;
+    uint64_t seq = 0;
+    std::string id;
+    RenderLine line;
+    std::vector<std::pair<std::string, RenderLine>> lines; // SNAPSHOT
+};
+
+// False for unknown event types and malformed data
+bool parse_line_event(const SseEvent &sse, LineEvent &out);
+
+// The lines on screen, keyed by server id, with a coarse grid index so a
+// repaint only visits lines near the changed area.
+class LiveLineSet
+{
+public:
+    LiveLineSet(uint32_t width, uint32_t height, int cell_size = 64);
+
+    // Apply one event; grows `dirty` by the screen area it changed.
+    // Returns false if it changed nothing (unknown id, duplicate add).
+    bool apply(const LineEvent &event, DirtyRect &dirty);
+
+    // Lines that may touch `rect`, in the order they were added
+    void lines_in(const DirtyRect &rect, std::vector<const RenderLine *> &out) const;
+
+    size_t size() const { return index_.size(); }
+    bool contains(const std::string &id) const { return index_.count(id) != 0; }
+    const RenderLine *find(const std::string &id) const;
+
+private:
+    struct Slot
+    {
+        RenderLine line;
+        uint64_t order = 0; // draw order
+        bool live = false;
+    };
+
+    bool add(const std::string &id, const RenderLine &line, DirtyRect &dirty);
+    bool remove(const std::string &id, DirtyRect &dirty);
+    void clear(DirtyRect &dirty);
+    template <typename Fn>
+    void for_cells(const RenderLine &line, Fn fn);
+
+    uint32_t width_;
+    uint32_t height_;
+    int cell_size_;
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> free_;
+    std::unordered_map<std::string, uint32_t> index_;                // id -> slot
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;      // cell -> slots
+    uint64_t next_order_ = 0;
+};
+
+// Repaint `rect` of a mapped buffer from `set`: clear it to the background
+// and draw the lines crossing it, clipped
+void paint_region(const LiveLineSet &set, const DirtyRect &rect,
+                  void *map, uint32_t stride, uint32_t width, uint32_t height,
+                  uint32_t background = 0x00000000);
+
+struct LiveConfig
+{
+    std::string host;
+    uint16_t port = 80;
+    std::string path = "/dots/events";
+    bool use_tls = false;
+    int wait_ms = 1000;    // how long the server may hold a request open
+    int timeout_ms = 5000; // silence before the connection is given up
+    int retry_ms = 1000;   // pause after a failed request
+    size_t max_queued = 100000; // events beyond this are dropped for a snapshot
+};
+
+struct LiveStats
+{
+    uint64_t events = 0;   // line events received
+    uint64_t requests = 0; // long polls / streams opened
+    uint64_t errors = 0;
+    uint64_t resyncs = 0;  // queue overflows answered with a snapshot
+    uint64_t bytes = 0;
+};
+
+// Subscribes to the server's line events on a background thread.
+//
+// Each request is GET <path>?since=<seq>&wait_ms=<n> on the pooled
+// keep-alive client. The server answers with text/event-stream: either a
+// stream that stays open (SSE) or the events so far, held until something
+// happens or wait_ms passes (long poll); both are read as they arrive and
+// the next request resumes after the last sequence number. A 404/405/501
+// marks the server as unsupported and ends the subscription.
+class LiveLineSubscriber
+{
+public:
+    explicit LiveLineSubscriber(LiveConfig config);
+    ~LiveLineSubscriber();
+
+    void start();
+    // Returns once the current request ends (at most about wait_ms)
+    void stop();
+
+    // Wait up to timeout_ms for events, then apply everything queued to
+    // `set`. Returns true if the set changed.
+    bool apply(LiveLineSet &set, DirtyRect &dirty, int timeout_ms = 0);
+
+    bool unsupported() const { return unsupported_; }
+    LiveStats stats() const;
+
+private:
+    void run();
+    void sleep_ms(int ms);
+
+    LiveConfig config_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<LineEvent> queue_;
+    LiveStats stats_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> unsupported_{false};
+    bool resync_ = false;
+    std::thread thread_;
+
+    LiveLineSubscriber(const LiveLineSubscriber &) = delete;
+    LiveLineSubscriber &operator=(const LiveLineSubscriber &) = delete;
+};
+
+} // namespace renderer
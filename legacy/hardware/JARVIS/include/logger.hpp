@@ -0,0 +1,162 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// Asynchronous structured logger.
+//
+// Producers format into a fixed per-record buffer and push it onto a
+// lock-free per-thread ring; a background writer drains all rings and
+// writes to stderr in batches. Hot paths never touch the stderr lock.
+//
+// Usage:
+//   JLOG_INFO("SketchPad") << "Saved " << n << " lines";
+//   JLOG_EVERY_N(logger::Level::Debug, "Blueprint", 30) << "tip=" << x;
+//
+// Compile-time floor: JARVIS_LOG_COMPILE_LEVEL (0=trace .. 5=off). Records
+// below it compile to nothing. Runtime levels come from JARVIS_LOG_LEVEL,
+// e.g. "info,SketchPad=debug,Camera=warn".
+
+#ifndef JARVIS_LOG_COMPILE_LEVEL
+#define JARVIS_LOG_COMPILE_LEVEL 1
+#endif
+
+namespace logger
+{
+
+    enum class Level : uint8_t
+    {
+        Trace = 0,
+        Debug = 1,
+        Info = 2,
+        Warn = 3,
+        Error = 4,
+        Off = 5
+    };
+
+    // Per-module runtime level. One instance per module name, never freed,
+    // so call sites may cache a reference to it.
+    struct Module
+    {
+        const char *name;
+        std::atomic<uint8_t> level;
+    };
+
+    // Look up (or register) a module by name.
+    Module &module(const char *name);
+
+    // Runtime level control
+    void set_level(const char *module_name, Level level);
+    void set_default_level(Level level);
+    Level default_level();
+
+    // Parse "info,SketchPad=debug" style specs. Returns false on bad input.
+    bool configure(const std::string &spec);
+    bool parse_level(const std::string &text, Level &out);
+    const char *level_name(Level level);
+
+    // Replace the output sink (default writes to fd 2). Used by tests and
+    // by embedders that want log lines elsewhere. Pass nullptr to restore.
+    void set_sink(std::function<void(const char *data, size_t len)> sink);
+
+    // Write records synchronously from the calling thread instead of
+    // going through the background writer (JARVIS_LOG_SYNC=1).
+    void set_synchronous(bool sync);
+
+    // Block until everything queued before the call has been written.
+    void flush();
+
+    // Stop the writer thread after draining. Safe to call more than once.
+    void shutdown();
+
+    struct Stats
+    {
+        uint64_t written = 0;
+        uint64_t dropped = 0; // ring full
+    };
+    Stats stats();
+
+    // Maximum bytes of one record (prefix + message); longer text is truncated.
+    constexpr size_t kMaxRecord = 240;
+
+    namespace detail
+    {
+
+        inline bool enabled(const Module &m, Level level)
+        {
+            return static_cast<uint8_t>(level) >= m.level.load(std::memory_order_relaxed);
+        }
+
+        // Streambuf over a fixed array; silently truncates.
+        class FixedBuf : public std::streambuf
+        {
+        public:
+            FixedBuf(char *begin, size_t cap) { setp(begin, begin + cap); }
+            size_t size() const { return static_cast<size_t>(pptr() - pbase()); }
+
+        protected:
+            int_type overflow(int_type ch) override { return traits_type::not_eof(ch); }
+        };
+
+        // One log statement. Formats on the stack, submits on destruction.
+        class Record
+        {
+        public:
+            Record(const Module &m, Level level);
+            ~Record();
+            Record(const Record &) = delete;
+            Record &operator=(const Record &) = delete;
+            std::ostream &stream() { return os_; }
+
+        private:
+            char buf_[kMaxRecord];
+            FixedBuf sb_;
+            std::ostream os_;
+            Level level_;
+        };
+
+        // Used to turn a stream expression into void inside the ternary below
+        struct Voidify
+        {
+            void operator&(std::ostream &) {}
+        };
+
+    } // namespace detail
+
+} // namespace logger
+
+// Per-call-site module lookup: the lambda's static caches the registry entry.
+#define JLOG_MODULE_REF(name)                                   \
+    ([]() -> ::logger::Module & {                               \
+        static ::logger::Module &jlog_m = ::logger::module(name); \
+        return jlog_m;                                          \
+    }())
+
+#define JLOG_COMPILED(level) (static_cast<int>(level) >= JARVIS_LOG_COMPILE_LEVEL)
+
+#define JLOG_IF(level, name, cond)                                                      \
+    !(JLOG_COMPILED(level) && (cond) &&                                                 \
+      ::logger::detail::enabled(JLOG_MODULE_REF(name), level))                          \
+        ? (void)0                                                                       \
+        : ::logger::detail::Voidify() & ::logger::detail::Record(JLOG_MODULE_REF(name), level).stream()
+
+#define JLOG(level, name) JLOG_IF(level, name, true)
+
+#define JLOG_TRACE(name) JLOG(::logger::Level::Trace, name)
+#define JLOG_DEBUG(name) JLOG(::logger::Level::Debug, name)
+#define JLOG_INFO(name) JLOG(::logger::Level::Info, name)
+#define JLOG_WARN(name) JLOG(::logger::Level::Warn, name)
+#define JLOG_ERROR(name) JLOG(::logger::Level::Error, name)
+
+// Emit only every Nth time this call site is reached (1st, N+1th, ...).
+// Intended for per-frame diagnostics: N frames between prints.
+#define JLOG_EVERY_N(level, name, n)                                              \
+    JLOG_IF(level, name, ([]() -> std::atomic<uint32_t> & {                       \
+                static std::atomic<uint32_t> jlog_count{0};                       \
+                return jlog_count;                                                \
+            }().fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(n) == 0))
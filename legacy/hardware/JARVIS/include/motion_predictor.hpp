@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace sketch
+{
+
+    enum class PredictionModel
+    {
+        CONSTANT_VELOCITY,
+        CONSTANT_ACCELERATION
+    };
+
+    struct PredictorConfig
+    {
+        PredictionModel model;
+        size_t history;              // Samples used for the fit
+        float max_horizon_ms;        // Never extrapolate further ahead than this
+        float max_overshoot_percent; // Cap on distance from the newest sample
+        float stale_after_ms;        // Drop history after a gap this long
+
+        PredictorConfig() : model(PredictionModel::CONSTANT_VELOCITY),
+                            history(6),
+                            max_horizon_ms(120.0f),
+                            max_overshoot_percent(4.0f),
+                            stale_after_ms(150.0f)
+        {
+        }
+    };
+
+    // Extrapolates a timestamped fingertip track to a future time.
+    //
+    // Fits x(t), y(t) by least squares over the last `history` samples
+    // (degree 1 or 2 in t) and evaluates the fit at the requested time.
+    // The fit doubles as smoothing, so raw positions should be fed in.
+    class MotionPredictor
+    {
+    public:
+        explicit MotionPredictor(const PredictorConfig &config = PredictorConfig());
+
+        void set_config(const PredictorConfig &config);
+        const PredictorConfig &config() const { return config_; }
+
+        void add_sample(float x, float y, uint64_t timestamp_ns);
+        void reset();
+        size_t size() const { return samples_.size(); }
+        uint64_t last_timestamp_ns() const { return samples_.empty() ? 0 : samples_.back().t_ns; }
+
+        // Position expected at target_ns. Returns false without enough history.
+        bool predict(uint64_t target_ns, float &out_x, float &out_y) const;
+
+    private:
+        struct Sample
+        {
+            float x, y;
+            uint64_t t_ns;
+        };
+
+        PredictorConfig config_;
+        std::deque<Sample> samples_;
+    };
+
+    // Exponentially weighted estimate of capture -> display latency
+    class LatencyEstimator
+    {
+    public:
+        explicit LatencyEstimator(float alpha = 0.1f) : alpha_(alpha) {}
+
+        void observe(uint64_t latency_ns);
+        // Forget measurements; the fixed extra latency is kept
+        void reset()
+        {
+            estimate_ns_ = 0.0;
+            samples_ = 0;
+        }
+        // Fixed extra latency not visible to the process (projector, scanout)
+        void set_extra_ns(uint64_t extra_ns) { extra_ns_ = extra_ns; }
+        uint64_t latency_ns() const { return static_cast<uint64_t>(estimate_ns_) + extra_ns_; }
+        bool has_estimate() const { return samples_ > 0; }
+
+    private:
+        float alpha_;
+        double estimate_ns_ = 0.0;
+        uint64_t extra_ns_ = 0;
+        uint64_t samples_ = 0;
+    };
+
+} // namespace sketch
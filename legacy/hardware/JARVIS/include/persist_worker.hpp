@@ -0,0 +1,91 @@
+#pragma once
+
+#include "worker_pool.hpp"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sketch
+{
+
+    class SketchPad;
+    struct SaveSnapshot;
+
+    // Outcome of one background save, reported back to the UI
+    struct PersistResult
+    {
+        std::string name; // sketch name
+        std::string path; // file written
+        size_t lines = 0;
+        size_t requests = 1; // saves folded into this write
+        bool saved = false;
+        bool upload_attempted = false;
+        bool uploaded = false;
+        uint64_t duration_us = 0; // write + upload
+    };
+
+    // Runs blueprint saves, signing and server uploads off the drawing thread.
+    //
+    // SketchPad::save() (with the worker attached via set_persist_worker)
+    // hands over an immutable snapshot. A save that arrives while an older
+    // one for the same pad and file is still queued replaces it, so a burst
+    // of saves costs one write. Writes run one at a time in request order.
+    class PersistWorker
+    {
+    public:
+        // Sends the signed JSON export of a saved snapshot; true on success
+        using Uploader = std::function<bool(const std::string &name, const std::string &json)>;
+
+        // Sends what a saved snapshot changed (delta sync); may merge
+        // server changes back into the pad. True on success.
+        using SnapshotUploader = std::function<bool(SketchPad &pad, const SaveSnapshot &snapshot)>;
+
+        explicit PersistWorker(Uploader uploader = Uploader());
+        explicit PersistWorker(SnapshotUploader uploader);
+        ~PersistWorker();
+
+        // Queue a snapshot. Returns false once shut down.
+        bool submit(SketchPad &pad, std::shared_ptr<const SaveSnapshot> snapshot);
+
+        // Results finished since the last call (for the UI to report)
+        std::vector<PersistResult> take_results();
+
+        // Block until everything queued so far is written (and uploaded)
+        void flush();
+        // Finish queued work and stop (idempotent)
+        void shutdown();
+
+        size_t pending() const;
+        uint64_t writes() const;
+        uint64_t coalesced() const;
+
+    private:
+        using Key = std::pair<SketchPad *, std::string>;
+        struct Job
+        {
+            std::shared_ptr<const SaveSnapshot> snapshot;
+            size_t requests = 0;
+        };
+
+        void run(const Key &key);
+
+        Uploader uploader_;
+        SnapshotUploader snapshot_uploader_;
+        mutable std::mutex mutex_;
+        std::map<Key, Job> queued_; // not yet started, by pad and path
+        std::vector<PersistResult> results_;
+        uint64_t writes_ = 0;
+        uint64_t coalesced_ = 0;
+        bool stopped_ = false;
+        jarvis::WorkerPool pool_; // one thread: writes stay ordered
+
+        PersistWorker(const PersistWorker &) = delete;
+        PersistWorker &operator=(const PersistWorker &) = delete;
+    };
+
+} // namespace sketch
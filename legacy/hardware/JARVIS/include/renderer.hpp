@@ -1,4 +1,6 @@
 #pragma once
+#include "dots_parser.hpp"
+#include "live_lines.hpp"
 #include <string>
 #include <cstdint>
 #include <xf86drmMode.h>
@@ -19,4 +21,18 @@ bool render_frame(const std::string& host, uint16_t port, const std::string& pat
                   void* dumb_map, uint32_t dumb_pitch,
                   uint32_t width, uint32_t height);
 
+// Same, keeping the parsed lines in `frame` between polls: a response with
+// the same content hash as the one on screen is not drawn again
+bool render_frame(const std::string& host, uint16_t port, const std::string& path,
+                  bool use_gbm, struct gbm_bo* bo,
+                  void* dumb_map, uint32_t dumb_pitch,
+                  uint32_t width, uint32_t height, DotsFrame& frame);
+
+// Repaint only `rect` of the framebuffer from a live line set (see
+// LiveLineSubscriber). Same buffer arguments as render_frame.
+bool render_region(const LiveLineSet& lines, const DirtyRect& rect,
+                   bool use_gbm, struct gbm_bo* bo,
+                   void* dumb_map, uint32_t dumb_pitch,
+                   uint32_t width, uint32_t height);
+
 } // namespace renderer
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "crypto.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace sketch
+{
+
+    struct Sketch;
+    struct GridConfig;
+
+    // Digest of the CBOR encoding nlohmann::json::to_cbor() would produce,
+    // computed from a stream of values instead of a DOM.
+    //
+    // Callers emit values in document order; maps must be given their keys
+    // in sorted order (nlohmann objects are std::map) and containers their
+    // element count up front. Bytes go through a small staging buffer into
+    // the hash, so no CBOR document is ever built.
+    class CborDigest
+    {
+    public:
+        // HMAC-SHA256 if secret is non-empty, else SHA256 (as blueprint_signature)
+        explicit CborDigest(const std::string &secret);
+
+        void begin_map(size_t entries);
+        void begin_array(size_t elements);
+        void string(const char *data, size_t size);
+        void string(const std::string &s) { string(s.data(), s.size()); }
+        void string(const char *s) { string(s, std::strlen(s)); }
+        void boolean(bool v);
+        void null();
+        void integer(int64_t v);
+        void unsigned_integer(uint64_t v);
+        void number(double v);
+
+        std::string finish_hex();
+
+    private:
+        void head(uint8_t major, uint64_t value);
+        void put(const void *data, size_t size);
+        void flush();
+
+        crypto::DigestStream stream_;
+        unsigned char buffer_[4096];
+        size_t used_ = 0;
+    };
+
+    enum class SignedJsonResult
+    {
+        OK,
+        PARSE_ERROR,
+        MISSING_SIGNATURE,
+        BAD_SIGNATURE,
+        BAD_FIELD // A blueprint field has the wrong type
+    };
+
+    const char *signed_json_result_name(SignedJsonResult result);
+
+    // Verify a JSON blueprint's embedded `signature` (over the CBOR of the
+    // document without it) and read its contents, parsing the text with SAX
+    // callbacks rather than into a DOM. `sketch` and `grid` hold the defaults
+    // for missing fields and are only written on OK. Documents whose keys are
+    // not already sorted (hand-edited files) are normalized first.
+    SignedJsonResult read_signed_json_blueprint(const char *text, size_t size, const std::string &secret,
+                                                int default_thickness, Sketch &sketch, GridConfig &grid);
+
+    // Signature embedded by SketchPad::export_json() for this content
+    std::string json_blueprint_signature(const Sketch &sketch, const GridConfig &grid, const std::string &secret);
+
+    // Signed JSON export (what SketchPad::export_json() and the server sync use)
+    std::string export_json_blueprint(const Sketch &sketch, const GridConfig &grid, const std::string &secret);
+
+} // namespace sketch
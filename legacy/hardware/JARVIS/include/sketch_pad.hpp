@@ -1,11 +1,18 @@
 #pragma once
 
 #include "hand_detector.hpp"
+#include "homography.hpp"
+#include "line_journal.hpp"
+#include "motion_predictor.hpp"
 #include <vector>
 #include <functional>
 #include <string>
 #include <deque>
+#include <atomic>
 #include <cmath>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace sketch
 {
@@ -119,9 +126,26 @@ namespace sketch
 
         // Apply perspective transformation
         Point transform(const Point &p) const;
-        void compute_homography();
+        // Solve from the four corner pairs
+        bool compute_homography();
+        // Least-squares solve from n >= 4 point pairs
+        bool compute_homography(const Point *camera_pts, const Point *display_pts, size_t n);
     };
 
+    // Immutable copy of what one save writes. Captured under the drawing
+    // lock, written without it (see SketchPad::save and PersistWorker).
+    struct SaveSnapshot
+    {
+        std::string path; // resolved .jarvis path
+        Sketch sketch;
+        GridConfig grid;
+        uint64_t clear_epoch = 0;        // clear() calls so far
+        uint64_t content_generation = 0; // bumped when the content is replaced wholesale
+        uint64_t sequence = 0;           // capture order; older snapshots are never written over newer
+    };
+
+    class PersistWorker;
+
     // Enterprise drawing state machine
     enum class DrawingState
     {
@@ -156,7 +180,13 @@ namespace sketch
         }
     };
 
-    // Enterprise drawing state machine for architects
+    // Enterprise drawing state machine for architects.
+    //
+    // All drawing state is per instance. update/render/save/load and the
+    // other stateful calls are serialized on an internal lock, so one
+    // SketchPad may be updated from a worker thread while the display
+    // thread renders it. The inline configuration setters are meant to be
+    // called before the pad is shared.
     class SketchPad
     {
     public:
@@ -169,20 +199,78 @@ namespace sketch
 
         // Update with hand detection (returns true if drawing)
         bool update(const std::vector<hand_detector::HandDetection> &hands);
-
-        // Get current sketch
+        // Same, with the capture time (steady clock, Frame::timestamp_ns) so
+        // the preview can be extrapolated to the expected display time
+        bool update(const std::vector<hand_detector::HandDetection> &hands, uint64_t frame_timestamp_ns);
+        // Report that the frame captured at capture_timestamp_ns is now on screen
+        void note_frame_displayed(uint64_t capture_timestamp_ns);
+
+        // Get current sketch (not synchronized; use get_sketch_copy() while
+        // another thread may be updating the pad)
         const Sketch &get_sketch() const { return sketch_; }
+        Sketch get_sketch_copy() const
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            return sketch_;
+        }
         // Return resolved path for last loaded/saved sketch (empty if none)
         std::string get_last_loaded_path() const { return last_loaded_path_; }
 
         // Clear current sketch
         void clear();
 
-        // Save sketch to file
+        // Save sketch as a binary blueprint (see blueprint_format.hpp) with
+        // a detached "<file>.sig" signature. After the first full write,
+        // saves only append the new lines/clears/grid changes to a signed
+        // journal ("<file>.journal"), which is folded back into the base in
+        // the background once it grows past the compaction threshold.
+        // With a persist worker attached this only snapshots and queues the
+        // save; the return value then means "queued".
         bool save(const std::string &base_filename);
 
-        // Load sketch from file
+        // The two halves of save(): capture the content under the drawing
+        // lock, then write it. persist_snapshot() never takes the drawing
+        // lock while writing and may run on any thread.
+        std::shared_ptr<const SaveSnapshot> snapshot_for_save(const std::string &base_filename);
+        bool persist_snapshot(const std::shared_ptr<const SaveSnapshot> &snapshot);
+
+        // Content and edit counters as snapshot_for_save() captures them,
+        // without claiming a save (path and sequence are left empty)
+        SaveSnapshot snapshot_content() const;
+        // Merge changes pulled from the server. The lines at `remove`
+        // (ascending indices into seen.sketch.lines) are dropped and `add`
+        // is inserted where the seen lines end, ahead of anything drawn
+        // since. `grid`, if given, replaces the synced grid settings.
+        // Refused (false, nothing changed) if a clear or load happened
+        // after `seen` was taken; otherwise *content_generation receives
+        // the counter later snapshots will carry.
+        bool apply_remote_changes(const SaveSnapshot &seen, const std::vector<size_t> &remove,
+                                  const std::vector<Line> &add, const GridConfig *grid,
+                                  uint64_t *content_generation);
+
+        // Hand saves (including the auto-save after each line) to a
+        // background worker. nullptr restores synchronous saves. The worker
+        // must outlive the pad.
+        void set_persist_worker(PersistWorker *worker);
+
+        // Journal control. With the journal disabled every save rewrites the base.
+        void enable_journal(bool enable) { journal_enabled_ = enable; }
+        void set_journal_compaction(size_t records) { compact_after_records_ = records > 0 ? records : 1; }
+        // Rewrite the base now and restart the journal (synchronous)
+        bool compact();
+        // Block until a background compaction has finished. Do not call
+        // from the on-save callback.
+        void wait_for_compaction();
+        size_t get_journal_records() const;
+
+        // Load sketch from file. Binary blueprints are mapped and verified
+        // against their .sig; JSON files (older saves, server downloads) are
+        // imported and verified against their embedded signature.
         bool load(const std::string &base_filename);
+
+        // Signed JSON export of the current sketch (the format used before
+        // binary blueprints, and what the server sync exchanges)
+        std::string export_json() const;
         // Load sketch from raw JSON contents. This bypasses the on-disk
         // signature verification and is intended for recovery when the
         // file signature is invalid but the payload is parseable.
@@ -222,10 +310,35 @@ namespace sketch
         void enable_predictive_smoothing(bool enable) { predictive_smoothing_ = enable; }
         void enable_projector_calibration(bool enable) { use_projector_calibration_ = enable; }
 
+        // Latency compensation for the live preview
+        void enable_latency_compensation(bool enable) { latency_compensation_ = enable; }
+        void set_predictor_config(const PredictorConfig &config) { predictor_.set_config(config); }
+        // Latency the process can't observe (projector processing, scanout)
+        void set_display_latency_ms(float ms) { latency_.set_extra_ns(static_cast<uint64_t>(ms * 1e6f)); }
+        uint64_t get_latency_estimate_ns() const { return latency_.latency_ns(); }
+
         // Projector calibration for table setup
         void set_calibration_points(const Point camera_pts[4], const Point display_pts[4]);
-        void calibrate_projector();
+        // N-point variant (n >= 4); extra points are fitted in the least-squares sense
+        void set_calibration_points(const std::vector<Point> &camera_pts, const std::vector<Point> &display_pts);
+        bool calibrate_projector();
         bool is_calibrated() const { return calibration_.calibrated; }
+        // Read {"camera":[[x,y],...],"display":[[x,y],...]} (percent) and calibrate
+        bool load_calibration(const std::string &path);
+
+        // Resolution of the detection coordinates passed to update().
+        // Defaults to the sketch resolution when unset.
+        void set_camera_resolution(uint32_t width, uint32_t height);
+        // Remap grid node spacing in camera pixels and storage format
+        void set_remap_options(uint32_t cell, bool fixed_point);
+        const RemapGrid &get_remap_grid() const { return remap_; }
+        // Map a camera pixel to display percent (remap grid when calibrated)
+        Point camera_to_display(float px, float py) const;
+
+        // Debug overlay: draw the camera frame warped into display space
+        // (dimmed) so calibration can be checked by eye.
+        void render_camera_overlay(const camera::Frame &frame, void *map, uint32_t stride,
+                                   uint32_t width, uint32_t height);
 
         // Get current state for debugging
         DrawingState get_state() const { return state_; }
@@ -239,7 +352,8 @@ namespace sketch
         void clear_manual_start();
 
         // Register a callback invoked after a successful save. The argument
-        // is the resolved filesystem path that was written.
+        // is the resolved filesystem path that was written. With a persist
+        // worker attached it runs on the worker thread.
         void set_on_save_callback(std::function<void(const std::string &)> cb)
         {
             on_save_callback_ = std::move(cb);
@@ -257,10 +371,21 @@ namespace sketch
         uint32_t current_color_;
         int current_thickness_;
 
+        // Serializes the stateful public calls (recursive: save() runs from
+        // inside update() and its callback may read the pad)
+        mutable std::recursive_mutex mutex_;
+
         // Gesture confirmation tracking
         GestureConfirmation current_confirmation_;
         int required_confirmation_frames_; // Default 2
         bool gesture_changed_since_start_;
+        // Persistent START/END locks (survive brief detection dropouts)
+        int first_gesture_frames_ = 0;
+        Point first_gesture_pos_;
+        int second_gesture_frames_ = 0;
+        Point second_gesture_pos_;
+        bool first_locked_ = false;
+        bool second_locked_ = false;
         float position_tolerance_percent_; // Position tolerance for confirmation (in percentage units)
 
         // High-precision smoothing for jitter reduction
@@ -268,6 +393,13 @@ namespace sketch
         int smoothing_window_;
         float jitter_threshold_; // Minimum movement to register (prevents micro-jitter)
 
+        // Latency-compensating preview prediction
+        MotionPredictor predictor_;
+        LatencyEstimator latency_;
+        bool latency_compensation_ = true;
+        bool display_feedback_ = false; // note_frame_displayed() seen
+        uint64_t frame_timestamp_ns_ = 0;
+
         // Enterprise rendering features
         bool anti_aliasing_enabled_;
         bool subpixel_rendering_;
@@ -276,6 +408,14 @@ namespace sketch
 
         // Projector calibration
         ProjectorCalibration calibration_;
+        std::vector<Point> calib_camera_pts_;
+        std::vector<Point> calib_display_pts_;
+        uint32_t camera_width_ = 0;
+        uint32_t camera_height_ = 0;
+        uint32_t remap_cell_ = 8;
+        bool remap_fixed_point_ = false;
+        RemapGrid remap_;         // camera pixels -> display percent
+        RemapGrid overlay_remap_; // display pixels -> camera percent (debug overlay)
 
         // Manual preview flag used by Enter-driven flow
         bool manual_preview_active_ = false;
@@ -291,11 +431,40 @@ namespace sketch
         // the resolved file path that was written.
         std::function<void(const std::string &)> on_save_callback_;
 
+        // Save bookkeeping (drawing lock)
+        uint64_t clear_epoch_ = 0;        // bumped by clear()
+        uint64_t content_generation_ = 0; // bumped by init/load: next save is a full write
+        uint64_t save_sequence_ = 0;
+        PersistWorker *persist_worker_ = nullptr;
+
+        // What is already on disk (base + journal). Guarded by io_mutex_,
+        // which is taken after mutex_ and never held while waiting for it.
+        struct DurableState
+        {
+            bool valid = false; // false: the next save rewrites the base
+            std::string path;
+            size_t lines = 0;
+            GridConfig grid;
+            uint64_t clear_epoch = 0;
+            uint64_t content_generation = 0;
+            uint64_t sequence = 0;
+        };
+        mutable std::mutex io_mutex_;
+        DurableState durable_;
+        std::shared_ptr<const SaveSnapshot> last_persisted_;
+        LineJournal journal_;
+        std::atomic<bool> journal_enabled_{true};
+        std::atomic<size_t> compact_after_records_{256};
+        uint64_t base_generation_ = 0; // bumped whenever the base is replaced
+        bool compacting_ = false;
+        std::thread compactor_;
+
         // Helper functions
         Point get_smoothed_position();
         Point get_predictive_smoothed_position();
         Point apply_jitter_filter(const Point &new_pos, const Point &last_pos);
         Point apply_calibration(const Point &p) const;
+        void rebuild_remap();
         bool is_pointing_gesture(hand_detector::Gesture g) const
         {
             return g == hand_detector::Gesture::POINTING || g == hand_detector::Gesture::PEACE;
@@ -308,6 +477,17 @@ namespace sketch
 
         void update_state_machine(const std::vector<hand_detector::HandDetection> &hands);
         void finalize_line();
+        // "name" -> "blueprints/name.jarvis"
+        std::string resolve_path(const std::string &base_filename) const;
+        bool load_json_file(const std::string &full_path);
+        // Persistence helpers; io_mutex_ held
+        bool write_base(const SaveSnapshot &snapshot);
+        bool append_changes(const SaveSnapshot &snapshot);
+        // Queue the records taking `from` to `to`; false if lines were removed
+        static bool queue_changes(LineJournal &journal, const DurableState &from, const SaveSnapshot &to);
+        static DurableState durable_of(const SaveSnapshot &snapshot);
+        void mark_durable(const SaveSnapshot &snapshot);
+        void start_compaction(const std::shared_ptr<const SaveSnapshot> &snapshot);
 
 
 
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "camera.hpp"
+#include "hand_detector_production.hpp"
+#include "sketch_pad.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sketch
+{
+
+    // One camera/projector pair: what it captures, how it detects, and where
+    // on the shared display it is drawn.
+    struct SurfaceConfig
+    {
+        std::string name; // Project name used for the SketchPad
+        camera::CameraConfig camera;
+        hand_detector::DetectorConfig detector;
+        hand_detector::ProductionConfig production;
+        std::string calibration_path; // Projector calibration JSON (optional)
+
+        // Region of the display buffer owned by this surface (pixels)
+        uint32_t viewport_x;
+        uint32_t viewport_y;
+        uint32_t viewport_width;
+        uint32_t viewport_height;
+
+        SurfaceConfig() : viewport_x(0), viewport_y(0), viewport_width(0), viewport_height(0) {}
+    };
+
+    // A drawing surface with its own camera, detector and SketchPad.
+    //
+    // step() (capture -> detect -> update) runs on a worker thread while the
+    // display thread calls render(); the SketchPad's lock keeps the two apart.
+    // step() itself is never run concurrently for one surface.
+    class Surface
+    {
+    public:
+        // Returns the next frame, or nullptr on capture failure
+        using FrameSource = std::function<const camera::Frame *()>;
+
+        explicit Surface(const SurfaceConfig &config);
+        ~Surface();
+
+        // Init and start the camera. Not needed when a frame source is set.
+        bool start();
+        void stop();
+
+        // Replace the camera as frame source (replay, tests)
+        void set_frame_source(FrameSource source) { source_ = std::move(source); }
+
+        // Capture one frame and process it. Returns false on capture failure.
+        bool step();
+
+        // Detect hands in `frame` and advance the SketchPad
+        void process_frame(const camera::Frame &frame);
+
+        // Clear this surface's viewport in a full display buffer and render
+        // the sketch into it. `width`/`height` describe the whole buffer.
+        void render(void *map, uint32_t stride, uint32_t width, uint32_t height);
+
+        SketchPad &pad() { return pad_; }
+        const SurfaceConfig &config() const { return config_; }
+        uint64_t frames_processed() const { return frames_.load(std::memory_order_relaxed); }
+        uint64_t capture_failures() const { return failures_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class MultiSurfaceRunner;
+
+        SurfaceConfig config_;
+        camera::Camera camera_;
+        hand_detector::ProductionHandDetector detector_;
+        SketchPad pad_;
+        FrameSource source_;
+        bool calibrated_;
+
+        std::atomic<bool> busy_;         // a step is queued or running
+        std::atomic<uint64_t> frames_;
+        std::atomic<uint64_t> failures_;
+        std::atomic<uint64_t> last_frame_ns_; // capture time of the newest processed frame
+
+        Surface(const Surface &) = delete;
+        Surface &operator=(const Surface &) = delete;
+    };
+
+    // Drives several surfaces from one process on a shared worker pool.
+    //
+    // pump() queues one step per idle surface and returns immediately, so a
+    // slow camera only delays its own table. Call it from the display loop,
+    // then render_all() whatever state each SketchPad has reached.
+    class MultiSurfaceRunner
+    {
+    public:
+        // 0 threads = one per surface up to the core count
+        explicit MultiSurfaceRunner(size_t threads = 0);
+        ~MultiSurfaceRunner();
+
+        Surface &add_surface(const SurfaceConfig &config);
+        size_t size() const { return surfaces_.size(); }
+        Surface &surface(size_t i) { return *surfaces_[i]; }
+
+        // Start every surface's camera. Returns false if any failed.
+        bool start_all();
+
+        // Queue a step for each surface that is not already stepping.
+        // Returns the number of steps queued.
+        size_t pump();
+
+        // Wait for all queued steps to finish
+        void wait_idle();
+
+        void render_all(void *map, uint32_t stride, uint32_t width, uint32_t height);
+
+        // Drain the pool and stop all cameras
+        void stop();
+
+        // Lay out `count` viewports side by side (columns) over width x height
+        static std::vector<SurfaceConfig> split_viewports(const SurfaceConfig &base, size_t count,
+                                                          uint32_t width, uint32_t height);
+
+    private:
+        size_t threads_;
+        std::unique_ptr<jarvis::WorkerPool> pool_; // created on first pump()
+        std::vector<std::unique_ptr<Surface>> surfaces_;
+    };
+
+} // namespace sketch
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jarvis
+{
+
+    // Fixed-size pool of worker threads draining a FIFO task queue.
+    //
+    // Used to run per-surface capture/detect/update steps side by side; the
+    // tasks themselves decide what is safe to overlap.
+    class WorkerPool
+    {
+    public:
+        // 0 threads = std::thread::hardware_concurrency() (at least 1)
+        explicit WorkerPool(size_t threads = 0);
+        ~WorkerPool();
+
+        // Queue a task. Returns false once the pool is shutting down.
+        bool submit(std::function<void()> task);
+
+        // Block until the queue is empty and no task is running
+        void wait_idle();
+
+        // Finish queued tasks and join the workers (idempotent)
+        void shutdown();
+
+        size_t size() const { return workers_.size(); }
+
+    private:
+        void worker_loop();
+
+        std::vector<std::thread> workers_;
+        std::deque<std::function<void()>> tasks_;
+        std::mutex mutex_;
+        std::condition_variable work_cv_;
+        std::condition_variable idle_cv_;
+        size_t active_ = 0;
+        bool stopping_ = false;
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+    };
+
+} // namespace jarvis
@@ -0,0 +1,307 @@
+// jarvis_native.cpp
+// Python module exposing the C++ hand detectors and SketchPad to the
+// hardware app (hardware/core/vision).
+//
+//   import numpy as np, jarvis_native as jn
+//   det = jn.ProductionHandDetector()
+//   hands = det.detect(rgb)           # rgb: HxWx3 uint8, C-contiguous rows
+//   hands["center_x"], hands["gesture"], jn.gesture_name(hands["gesture"][0])
+//
+// Images are borrowed, never copied: any buffer-protocol object (NumPy
+// array, memoryview, frame ring mapping) is wrapped as a camera::Frame for
+// the duration of the call, and the GIL is released while C++ runs. The
+// caller must not write to the image from another thread meanwhile.
+// Detections come back as a structured array whose dtype is BusHand, the
+// same record the detection bus carries.
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../include/camera.hpp"
+#include "../include/detection_bus.hpp"
+#include "../include/hand_detector.hpp"
+#include "../include/hand_detector_production.hpp"
+#include "../include/sketch_pad.hpp"
+
+namespace py = pybind11;
+using hand_detector::BusHand;
+using hand_detector::HandDetection;
+
+PYBIND11_NUMPY_DTYPE(hand_detector::BusHand, bbox_x, bbox_y, bbox_w, bbox_h, confidence, center_x, center_y, gesture,
+                     gesture_confidence, num_fingers, contour_area, fingertip_count, fingertips);
+
+namespace
+{
+    // Frame over an HxWx3 uint8 buffer; `info` must outlive the frame
+    camera::Frame borrow_frame(const py::buffer_info &info)
+    {
+        if (info.ndim != 3 || info.shape[2] != 3 || info.format != py::format_descriptor<uint8_t>::format())
+            throw py::value_error("expected an HxWx3 uint8 RGB image");
+        // Rows may be padded (a crop of a wider image); pixels within a row may not
+        if (info.strides[2] != 1 || info.strides[1] != 3 || info.strides[0] < info.shape[1] * 3)
+            throw py::value_error("image pixels must be packed RGB within each row (numpy.ascontiguousarray)");
+        camera::Frame frame;
+        frame.external = static_cast<const uint8_t *>(info.ptr);
+        frame.width = static_cast<uint32_t>(info.shape[1]);
+        frame.height = static_cast<uint32_t>(info.shape[0]);
+        frame.stride = static_cast<int>(info.strides[0]);
+        // Up to the end of the last row; its padding may not belong to this view
+        frame.size = info.shape[0] ? static_cast<size_t>(info.shape[0] - 1) * info.strides[0] + info.shape[1] * 3 : 0;
+        frame.format = camera::PixelFormat::RGB888;
+        return frame;
+    }
+
+    // 32-bit integer elements, signed or not; rules out float32 and the like
+    bool is_int32(const py::buffer_info &info)
+    {
+        return info.itemsize == 4 && (info.format == py::format_descriptor<uint32_t>::format() ||
+                                      info.format == py::format_descriptor<int32_t>::format());
+    }
+
+    py::array_t<BusHand> to_array(const std::vector<HandDetection> &hands)
+    {
+        py::array_t<BusHand> out(static_cast<py::ssize_t>(hands.size()));
+        BusHand *dst = out.mutable_data();
+        for (size_t i = 0; i < hands.size(); ++i)
+            dst[i] = hand_detector::to_bus_hand(hands[i]);
+        return out;
+    }
+
+    std::vector<HandDetection> from_array(const py::array_t<BusHand, py::array::c_style> &hands)
+    {
+        std::vector<HandDetection> out;
+        out.reserve(static_cast<size_t>(hands.size()));
+        const BusHand *src = hands.data();
+        for (py::ssize_t i = 0; i < hands.size(); ++i)
+            out.push_back(hand_detector::from_bus_hand(src[i]));
+        return out;
+    }
+
+    // The GIL is dropped during detect(), so two Python threads could enter
+    // the same detector; each wrapper serialises its own calls
+    template <typename Detector>
+    struct Guarded
+    {
+        Detector detector;
+        std::mutex mutex;
+    };
+
+    template <typename Detector>
+    py::array_t<BusHand> detect(Guarded<Detector> &self, const py::buffer &image)
+    {
+        py::buffer_info info = image.request();
+        camera::Frame frame = borrow_frame(info);
+        std::vector<HandDetection> hands;
+        {
+            py::gil_scoped_release release;
+            std::lock_guard<std::mutex> lock(self.mutex);
+            hands = self.detector.detect(frame);
+        }
+        return to_array(hands);
+    }
+
+    template <typename Detector>
+    bool calibrate(Guarded<Detector> &self, const py::buffer &image, int x, int y, int w, int h)
+    {
+        py::buffer_info info = image.request();
+        camera::Frame frame = borrow_frame(info);
+        py::gil_scoped_release release;
+        std::lock_guard<std::mutex> lock(self.mutex);
+        return self.detector.calibrate_skin(frame, x, y, w, h);
+    }
+
+    using PyHandDetector = Guarded<hand_detector::HandDetector>;
+    using PyProductionDetector = Guarded<hand_detector::ProductionHandDetector>;
+} // namespace
+
+PYBIND11_MODULE(jarvis_native, m)
+{
+    m.doc() = "JARVIS hand detectors and SketchPad (C++ core)";
+
+    py::enum_<hand_detector::Gesture>(m, "Gesture")
+        .value("UNKNOWN", hand_detector::Gesture::UNKNOWN)
+        .value("OPEN_PALM", hand_detector::Gesture::OPEN_PALM)
+        .value("FIST", hand_detector::Gesture::FIST)
+        .value("POINTING", hand_detector::Gesture::POINTING)
+        .value("THUMBS_UP", hand_detector::Gesture::THUMBS_UP)
+        .value("PEACE", hand_detector::Gesture::PEACE)
+        .value("OK_SIGN", hand_detector::Gesture::OK_SIGN)
+        .value("CUSTOM", hand_detector::Gesture::CUSTOM);
+
+    m.def(
+        "gesture_name",
+        [](int g) { return hand_detector::HandDetector::gesture_to_string(static_cast<hand_detector::Gesture>(g)); },
+        py::arg("gesture"));
+    m.attr("detection_dtype") = py::dtype::of<BusHand>();
+
+    py::class_<hand_detector::DetectorConfig>(m, "DetectorConfig")
+        .def(py::init<>())
+        .def_readwrite("hue_min", &hand_detector::DetectorConfig::hue_min)
+        .def_readwrite("hue_max", &hand_detector::DetectorConfig::hue_max)
+        .def_readwrite("sat_min", &hand_detector::DetectorConfig::sat_min)
+        .def_readwrite("sat_max", &hand_detector::DetectorConfig::sat_max)
+        .def_readwrite("val_min", &hand_detector::DetectorConfig::val_min)
+        .def_readwrite("val_max", &hand_detector::DetectorConfig::val_max)
+        .def_readwrite("min_hand_area", &hand_detector::DetectorConfig::min_hand_area)
+        .def_readwrite("max_hand_area", &hand_detector::DetectorConfig::max_hand_area)
+        .def_readwrite("min_confidence", &hand_detector::DetectorConfig::min_confidence)
+        .def_readwrite("enable_morphology", &hand_detector::DetectorConfig::enable_morphology)
+        .def_readwrite("morph_iterations", &hand_detector::DetectorConfig::morph_iterations)
+        .def_readwrite("enable_gesture", &hand_detector::DetectorConfig::enable_gesture)
+        .def_readwrite("gesture_history", &hand_detector::DetectorConfig::gesture_history)
+        .def_readwrite("downscale_factor", &hand_detector::DetectorConfig::downscale_factor)
+        .def_readwrite("verbose", &hand_detector::DetectorConfig::verbose)
+        .def_readwrite("enable_simd", &hand_detector::DetectorConfig::enable_simd)
+        .def_readwrite("enable_threading", &hand_detector::DetectorConfig::enable_threading)
+        .def_readwrite("adaptive_hsv", &hand_detector::DetectorConfig::adaptive_hsv)
+        .def_readwrite("hsv_smoothing", &hand_detector::DetectorConfig::hsv_smoothing)
+        .def_readwrite("enable_tracking", &hand_detector::DetectorConfig::enable_tracking)
+        .def_readwrite("tracking_iou_threshold", &hand_detector::DetectorConfig::tracking_iou_threshold)
+        .def_readwrite("temporal_filter_frames", &hand_detector::DetectorConfig::temporal_filter_frames)
+        .def_readwrite("detection_persistence", &hand_detector::DetectorConfig::detection_persistence)
+        .def("load_from_file", &hand_detector::DetectorConfig::load_from_file, py::arg("path"))
+        .def("save_to_file", &hand_detector::DetectorConfig::save_to_file, py::arg("path"))
+        .def("validate", &hand_detector::DetectorConfig::validate);
+
+    py::class_<hand_detector::ProductionConfig>(m, "ProductionConfig")
+        .def(py::init<>())
+        .def_readwrite("enable_tracking", &hand_detector::ProductionConfig::enable_tracking)
+        .def_readwrite("tracking_history_frames", &hand_detector::ProductionConfig::tracking_history_frames)
+        .def_readwrite("tracking_iou_threshold", &hand_detector::ProductionConfig::tracking_iou_threshold)
+        .def_readwrite("adaptive_lighting", &hand_detector::ProductionConfig::adaptive_lighting)
+        .def_readwrite("lighting_adaptation_rate", &hand_detector::ProductionConfig::lighting_adaptation_rate)
+        .def_readwrite("gesture_stabilization_frames", &hand_detector::ProductionConfig::gesture_stabilization_frames)
+        .def_readwrite("gesture_confidence_threshold", &hand_detector::ProductionConfig::gesture_confidence_threshold)
+        .def_readwrite("enable_roi_tracking", &hand_detector::ProductionConfig::enable_roi_tracking)
+        .def_readwrite("roi_expansion_pixels", &hand_detector::ProductionConfig::roi_expansion_pixels)
+        .def_readwrite("filter_low_confidence", &hand_detector::ProductionConfig::filter_low_confidence)
+        .def_readwrite("min_detection_quality", &hand_detector::ProductionConfig::min_detection_quality)
+        .def_readwrite("verbose", &hand_detector::ProductionConfig::verbose);
+
+    py::class_<hand_detector::DetectionStats>(m, "DetectionStats")
+        .def_readonly("frames_processed", &hand_detector::DetectionStats::frames_processed)
+        .def_readonly("hands_detected", &hand_detector::DetectionStats::hands_detected)
+        .def_readonly("avg_process_time_ms", &hand_detector::DetectionStats::avg_process_time_ms)
+        .def_readonly("conversion_ms", &hand_detector::DetectionStats::conversion_ms)
+        .def_readonly("masking_ms", &hand_detector::DetectionStats::masking_ms)
+        .def_readonly("morphology_ms", &hand_detector::DetectionStats::morphology_ms)
+        .def_readonly("contours_ms", &hand_detector::DetectionStats::contours_ms)
+        .def_readonly("analysis_ms", &hand_detector::DetectionStats::analysis_ms);
+
+    py::class_<PyHandDetector>(m, "HandDetector")
+        .def(py::init([](const hand_detector::DetectorConfig &config) {
+                 auto *d = new PyHandDetector();
+                 d->detector.init(config);
+                 return d;
+             }),
+             py::arg("config") = hand_detector::DetectorConfig())
+        .def("detect", &detect<hand_detector::HandDetector>, py::arg("image"),
+             "Detect hands in an HxWx3 uint8 RGB image; returns a detection_dtype array")
+        .def("calibrate_skin", &calibrate<hand_detector::HandDetector>, py::arg("image"), py::arg("x"), py::arg("y"),
+             py::arg("w"), py::arg("h"))
+        .def_property(
+            "config", [](PyHandDetector &self) { return self.detector.get_config(); },
+            [](PyHandDetector &self, const hand_detector::DetectorConfig &c) {
+                std::lock_guard<std::mutex> lock(self.mutex);
+                self.detector.set_config(c);
+            })
+        .def_property_readonly("stats", [](PyHandDetector &self) { return self.detector.get_stats(); })
+        .def("reset_stats", [](PyHandDetector &self) {
+            std::lock_guard<std::mutex> lock(self.mutex);
+            self.detector.reset_stats();
+        });
+
+    py::class_<PyProductionDetector>(m, "ProductionHandDetector")
+        .def(py::init([](const hand_detector::DetectorConfig &config, const hand_detector::ProductionConfig &production) {
+                 auto *d = new PyProductionDetector();
+                 d->detector.init(config, production);
+                 return d;
+             }),
+             py::arg("config") = hand_detector::DetectorConfig(),
+             py::arg("production") = hand_detector::ProductionConfig())
+        .def("detect", &detect<hand_detector::ProductionHandDetector>, py::arg("image"),
+             "Detect and track hands in an HxWx3 uint8 RGB image; returns a detection_dtype array")
+        .def("calibrate_skin", &calibrate<hand_detector::ProductionHandDetector>, py::arg("image"), py::arg("x"),
+             py::arg("y"), py::arg("w"), py::arg("h"))
+        .def("auto_calibrate",
+             [](PyProductionDetector &self, const py::buffer &image) {
+                 py::buffer_info info = image.request();
+                 camera::Frame frame = borrow_frame(info);
+                 py::gil_scoped_release release;
+                 std::lock_guard<std::mutex> lock(self.mutex);
+                 return self.detector.auto_calibrate(frame);
+             },
+             py::arg("image"))
+        .def_property_readonly("stats", [](PyProductionDetector &self) { return self.detector.get_stats(); })
+        .def("reset_stats", [](PyProductionDetector &self) {
+            std::lock_guard<std::mutex> lock(self.mutex);
+            self.detector.reset_stats();
+        })
+        .def("reset_tracking", [](PyProductionDetector &self) {
+            std::lock_guard<std::mutex> lock(self.mutex);
+            self.detector.reset_tracking();
+        });
+
+    // SketchPad locks internally, so only the GIL needs handling here
+    py::class_<sketch::SketchPad>(m, "SketchPad")
+        .def(py::init<uint32_t, uint32_t>(), py::arg("width") = 1920, py::arg("height") = 1080)
+        .def("init", &sketch::SketchPad::init, py::arg("name"), py::arg("width"), py::arg("height"))
+        .def("set_camera_resolution", &sketch::SketchPad::set_camera_resolution, py::arg("width"), py::arg("height"))
+        .def(
+            "update",
+            [](sketch::SketchPad &self, const py::array_t<BusHand, py::array::c_style> &hands, uint64_t timestamp_ns) {
+                std::vector<HandDetection> v = from_array(hands);
+                py::gil_scoped_release release;
+                return timestamp_ns ? self.update(v, timestamp_ns) : self.update(v);
+            },
+            py::arg("hands"), py::arg("timestamp_ns") = 0,
+            "Feed one frame's detections (a detection_dtype array); True when a line was added")
+        .def("add_line",
+             [](sketch::SketchPad &self, float x1, float y1, float x2, float y2) {
+                 self.add_line(sketch::Point(x1, y1), sketch::Point(x2, y2));
+             },
+             py::arg("x1"), py::arg("y1"), py::arg("x2"), py::arg("y2"))
+        .def("lines",
+             [](const sketch::SketchPad &self) {
+                 sketch::Sketch s = self.get_sketch_copy();
+                 py::array_t<float> out({static_cast<py::ssize_t>(s.lines.size()), py::ssize_t(4)});
+                 auto v = out.mutable_unchecked<2>();
+                 for (size_t i = 0; i < s.lines.size(); ++i)
+                 {
+                     v(i, 0) = s.lines[i].start.x;
+                     v(i, 1) = s.lines[i].start.y;
+                     v(i, 2) = s.lines[i].end.x;
+                     v(i, 3) = s.lines[i].end.y;
+                 }
+                 return out;
+             },
+             "Lines as an Nx4 float32 array of x1, y1, x2, y2 in percent")
+        .def_property_readonly("stroke_count", &sketch::SketchPad::get_stroke_count)
+        .def(
+            "render",
+            [](sketch::SketchPad &self, const py::buffer &target) {
+                py::buffer_info info = target.request(true);
+                const bool rgba = info.ndim == 3 && info.shape[2] == 4 && info.strides[2] == 1 && info.strides[1] == 4 &&
+                                  info.format == py::format_descriptor<uint8_t>::format();
+                const bool packed = info.ndim == 2 && info.strides[1] == 4 && is_int32(info);
+                if (!rgba && !packed)
+                    throw py::value_error("expected an HxW uint32 or HxWx4 uint8 writable buffer");
+                py::gil_scoped_release release;
+                self.render(info.ptr, static_cast<uint32_t>(info.strides[0]), static_cast<uint32_t>(info.shape[1]),
+                            static_cast<uint32_t>(info.shape[0]));
+            },
+            py::arg("target"), "Draw the sketch into a 32-bit pixel buffer in place")
+        .def("clear", &sketch::SketchPad::clear)
+        .def("save", &sketch::SketchPad::save, py::arg("name"), py::call_guard<py::gil_scoped_release>())
+        .def("load", &sketch::SketchPad::load, py::arg("name"), py::call_guard<py::gil_scoped_release>())
+        .def("export_json", &sketch::SketchPad::export_json)
+        .def("set_color", &sketch::SketchPad::set_color, py::arg("color"))
+        .def("set_thickness", &sketch::SketchPad::set_thickness, py::arg("thickness"))
+        .def("set_grid_enabled", &sketch::SketchPad::set_grid_enabled, py::arg("enabled"))
+        .def("set_snap_to_grid", &sketch::SketchPad::set_snap_to_grid, py::arg("snap"));
+}
@@ -0,0 +1,866 @@
+#include "async_http_client.hpp"
+#include "http_response_parser.hpp"
+#include "http_shared.hpp"
+#include "logger.hpp"
+#include "worker_pool.hpp"
+
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const uint64_t kWakeId = 0; // epoll tag of the eventfd; ops start at 1
+
+    struct Connection
+    {
+        int fd = -1;
+        SSL *ssl = nullptr;
+        bool tls_up = false; // handshake finished; close with close_notify
+        Clock::time_point idle_since;
+    };
+
+    static void close_connection(Connection &c)
+    {
+        if (c.ssl)
+        {
+            if (c.tls_up)
+                SSL_shutdown(c.ssl);
+            SSL_free(c.ssl);
+            c.ssl = nullptr;
+        }
+        if (c.fd >= 0)
+        {
+            ::close(c.fd);
+            c.fd = -1;
+        }
+        c.tls_up = false;
+    }
+
+    // An idle keep-alive socket has nothing to read; EOF or stray bytes
+    // mean the server has closed it
+    static bool idle_connection_usable(const Connection &c)
+    {
+        struct pollfd pfd;
+        pfd.fd = c.fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        return poll(&pfd, 1, 0) == 0;
+    }
+
+    static std::string ssl_error_string()
+    {
+        char buf[256];
+        ERR_error_string_n(ERR_get_error(), buf, sizeof(buf));
+        return buf;
+    }
+}
+
+class AsyncHttpClient::Impl
+{
+public:
+    explicit Impl(size_t max_per_host)
+        : max_per_host_(std::max<size_t>(1, max_per_host)), resolver_(1)
+    {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = kWakeId;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+        // Make sure OpenSSL and the SIGPIPE handling are set up before
+        // the reactor touches a socket
+        http_shared::tls_context();
+        reactor_ = std::thread([this]() { run(); });
+    }
+
+    ~Impl()
+    {
+        shutdown();
+        ::close(wake_fd_);
+        ::close(epoll_fd_);
+    }
+
+    void submit(HttpRequest request, Callback done)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!stopping_)
+            {
+                incoming_.emplace_back(std::move(request), std::move(done));
+                ++stats_.submitted;
+                ++stats_.in_flight;
+                stats_.peak_in_flight = std::max(stats_.peak_in_flight, stats_.in_flight);
+                wake();
+                return;
+            }
+        }
+        HttpResponse response;
+        response.error = "client shut down";
+        if (done)
+            done(std::move(response));
+    }
+
+    AsyncHttpStats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_)
+                return;
+            stopping_ = true;
+            wake();
+        }
+        if (reactor_.joinable())
+            reactor_.join();
+        // Lookups still running finish into a queue nobody reads
+        resolver_.shutdown();
+    }
+
+private:
+    enum class Phase
+    {
+        WAITING,   // for a connection slot to this host
+        RESOLVING,
+        CONNECTING,
+        HANDSHAKE,
+        SENDING,
+        RECEIVING
+    };
+
+    struct Op
+    {
+        uint64_t id = 0;
+        HttpRequest request;
+        Callback done;
+        std::string key;  // scheme://host:port
+        std::string wire; // serialized request
+        size_t sent = 0;
+        Phase phase = Phase::WAITING;
+        Connection conn;
+        bool registered = false; // fd is in the epoll set
+        bool reused = false;
+        bool retried = false;
+        bool holds_slot = false;
+        std::vector<http_shared::Address> addresses;
+        size_t next_address = 0;
+        std::string connect_error;
+        HttpResponseParser parser;
+        Clock::time_point start;
+        Clock::time_point deadline;
+    };
+
+    struct Resolved
+    {
+        uint64_t id;
+        bool ok;
+        std::vector<http_shared::Address> addresses;
+        std::string error;
+    };
+
+    struct Host
+    {
+        size_t open = 0;                // connections held by requests
+        std::vector<Connection> idle;   // oldest first
+        std::deque<uint64_t> waiting;   // requests queued for a slot
+    };
+
+    void wake()
+    {
+        uint64_t one = 1;
+        ssize_t rc = ::write(wake_fd_, &one, sizeof(one));
+        (void)rc;
+    }
+
+    void run()
+    {
+        struct epoll_event events[64];
+        while (true)
+        {
+            int n = epoll_wait(epoll_fd_, events, 64, next_timeout_ms());
+            for (int i = 0; i < n; ++i)
+            {
+                if (events[i].data.u64 == kWakeId)
+                {
+                    uint64_t count;
+                    ssize_t rc = ::read(wake_fd_, &count, sizeof(count));
+                    (void)rc;
+                    continue;
+                }
+                on_io(events[i].data.u64);
+            }
+
+            std::deque<std::pair<HttpRequest, Callback>> incoming;
+            std::deque<Resolved> resolved;
+            bool stopping;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                incoming.swap(incoming_);
+                resolved.swap(resolved_);
+                stopping = stopping_;
+            }
+            if (stopping)
+            {
+                for (auto &entry : incoming)
+                    finish_unstarted(std::move(entry.second));
+                fail_everything();
+                return;
+            }
+            for (auto &entry : incoming)
+                start(std::move(entry.first), std::move(entry.second));
+            for (auto &r : resolved)
+                on_resolved(r);
+            expire();
+        }
+    }
+
+    int next_timeout_ms() const
+    {
+        bool any = false;
+        Clock::time_point next;
+        for (const auto &entry : ops_)
+        {
+            const Op &op = *entry.second;
+            if (op.phase == Phase::WAITING)
+                continue;
+            if (!any || op.deadline < next)
+                next = op.deadline;
+            any = true;
+        }
+        if (!any)
+            return -1;
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count();
+        return static_cast<int>(std::max<long long>(0, ms + 1));
+    }
+
+    void touch(Op &op)
+    {
+        op.deadline = Clock::now() + std::chrono::milliseconds(op.request.timeout_ms > 0 ? op.request.timeout_ms : 3600000);
+    }
+
+    void watch(Op &op, uint32_t events)
+    {
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = events;
+        ev.data.u64 = op.id;
+        epoll_ctl(epoll_fd_, op.registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, op.conn.fd, &ev);
+        op.registered = true;
+    }
+
+    void unwatch(Op &op)
+    {
+        if (op.registered)
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, op.conn.fd, nullptr);
+        op.registered = false;
+    }
+
+    void drop_connection(Op &op)
+    {
+        unwatch(op);
+        close_connection(op.conn);
+    }
+
+    void start(HttpRequest request, Callback done)
+    {
+        std::unique_ptr<Op> owned(new Op());
+        Op &op = *owned;
+        op.id = next_id_++;
+        op.request = std::move(request);
+        op.done = std::move(done);
+        op.key = std::string(op.request.use_tls ? "https://" : "http://") + op.request.host + ":" +
+                 std::to_string(op.request.port);
+        op.start = Clock::now();
+        touch(op);
+
+        const HttpRequest &r = op.request;
+        std::ostringstream oss;
+        oss << r.method << " " << (r.path.empty() ? "/" : r.path) << " HTTP/1.1\r\n";
+        oss << "Host: " << r.host << ":" << r.port << "\r\n";
+        oss << "User-Agent: JARVIS/1.0\r\n";
+        oss << "Accept: application/json\r\n";
+        for (const auto &h : r.headers)
+            oss << h.first << ": " << h.second << "\r\n";
+        if (!r.body.empty() || r.method == "POST" || r.method == "PUT")
+        {
+            oss << "Content-Type: " << r.content_type << "\r\n";
+            oss << "Content-Length: " << r.body.size() << "\r\n";
+        }
+        oss << "Connection: keep-alive\r\n\r\n";
+        op.wire = oss.str();
+        op.wire += r.body;
+
+        ops_[op.id] = std::move(owned);
+        acquire_slot(op);
+    }
+
+    // Run op on an idle connection, a new one, or queue it behind the limit
+    void acquire_slot(Op &op)
+    {
+        Host &host = hosts_[op.key];
+        if (host.open >= max_per_host_)
+        {
+            op.phase = Phase::WAITING;
+            host.waiting.push_back(op.id);
+            return;
+        }
+        ++host.open;
+        op.holds_slot = true;
+        touch(op);
+
+        while (!host.idle.empty())
+        {
+            Connection c = host.idle.back();
+            host.idle.pop_back();
+            if (Clock::now() - c.idle_since > std::chrono::milliseconds(kIdleTimeoutMs) || !idle_connection_usable(c))
+            {
+                close_connection(c);
+                continue;
+            }
+            op.conn = c;
+            op.reused = true;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++stats_.reuses;
+            }
+            begin_send(op);
+            return;
+        }
+        resolve(op);
+    }
+
+    void resolve(Op &op)
+    {
+        op.phase = Phase::RESOLVING;
+        op.addresses.clear();
+        op.next_address = 0;
+        op.connect_error.clear();
+        uint64_t id = op.id;
+        std::string host = op.request.host;
+        uint16_t port = op.request.port;
+        // getaddrinfo blocks; the shared cache usually answers at once
+        resolver_.submit([this, id, host, port]() {
+            Resolved r;
+            r.id = id;
+            r.ok = http_shared::resolve(host, port, r.addresses, r.error);
+            std::lock_guard<std::mutex> lock(mutex_);
+            resolved_.push_back(std::move(r));
+            wake();
+        });
+    }
+
+    void on_resolved(Resolved &r)
+    {
+        auto it = ops_.find(r.id);
+        if (it == ops_.end() || it->second->phase != Phase::RESOLVING)
+            return; // timed out meanwhile
+        Op &op = *it->second;
+        if (!r.ok)
+        {
+            fail(op, r.error);
+            return;
+        }
+        op.addresses = std::move(r.addresses);
+        try_connect(op);
+    }
+
+    void try_connect(Op &op)
+    {
+        while (op.next_address < op.addresses.size())
+        {
+            const http_shared::Address &a = op.addresses[op.next_address++];
+            int fd = ::socket(a.family, a.socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, a.protocol);
+            if (fd < 0)
+                continue;
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            int rc = ::connect(fd, reinterpret_cast<const struct sockaddr *>(&a.addr), a.len);
+            if (rc == 0 || errno == EINPROGRESS)
+            {
+                op.conn.fd = fd;
+                op.phase = Phase::CONNECTING;
+                touch(op);
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++stats_.connects;
+                }
+                watch(op, EPOLLOUT);
+                if (rc == 0)
+                    on_connected(op);
+                return;
+            }
+            op.connect_error = std::string("connect failed to ") + http_shared::address_string(a) + ": " + std::strerror(errno);
+            ::close(fd);
+        }
+        http_shared::forget_address(op.request.host, op.request.port);
+        fail(op, op.connect_error.empty() ? std::string("could not connect") : op.connect_error);
+    }
+
+    void on_connected(Op &op)
+    {
+        if (!op.request.use_tls)
+        {
+            begin_send(op);
+            return;
+        }
+        SSL_CTX *ctx = http_shared::tls_context();
+        if (!ctx)
+        {
+            fail(op, "OpenSSL: SSL_CTX_new failed");
+            return;
+        }
+        op.conn.ssl = SSL_new(ctx);
+        if (!op.conn.ssl || !SSL_set_fd(op.conn.ssl, op.conn.fd))
+        {
+            fail(op, "OpenSSL: SSL_new failed");
+            return;
+        }
+        // Set Server Name Indication (SNI) so TLS servers can route correctly
+        SSL_set_tlsext_host_name(op.conn.ssl, op.request.host.c_str());
+        http_shared::apply_session(op.key, op.conn.ssl);
+        SSL_set_connect_state(op.conn.ssl);
+        op.phase = Phase::HANDSHAKE;
+        continue_handshake(op);
+    }
+
+    void continue_handshake(Op &op)
+    {
+        ERR_clear_error();
+        int rc = SSL_do_handshake(op.conn.ssl);
+        if (rc == 1)
+        {
+            op.conn.tls_up = true;
+            begin_send(op);
+            return;
+        }
+        int err = SSL_get_error(op.conn.ssl, rc);
+        if (err == SSL_ERROR_WANT_READ)
+            watch(op, EPOLLIN);
+        else if (err == SSL_ERROR_WANT_WRITE)
+            watch(op, EPOLLOUT);
+        else
+        {
+            http_shared::forget_session(op.key);
+            fail(op, "SSL_connect failed: " + ssl_error_string());
+        }
+    }
+
+    void begin_send(Op &op)
+    {
+        op.phase = Phase::SENDING;
+        op.sent = 0;
+        op.parser.reset(op.request.method == "HEAD");
+        touch(op);
+        continue_send(op);
+    }
+
+    void continue_send(Op &op)
+    {
+        while (op.sent < op.wire.size())
+        {
+            const char *data = op.wire.data() + op.sent;
+            size_t left = op.wire.size() - op.sent;
+            if (op.conn.ssl)
+            {
+                ERR_clear_error();
+                int n = SSL_write(op.conn.ssl, data, static_cast<int>(std::min<size_t>(left, 1 << 30)));
+                if (n > 0)
+                {
+                    op.sent += static_cast<size_t>(n);
+                    continue;
+                }
+                int err = SSL_get_error(op.conn.ssl, n);
+                if (err == SSL_ERROR_WANT_WRITE)
+                    watch(op, EPOLLOUT);
+                else if (err == SSL_ERROR_WANT_READ)
+                    watch(op, EPOLLIN);
+                else
+                    io_failed(op, "SSL_write failed");
+                return;
+            }
+            ssize_t n = ::send(op.conn.fd, data, left, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                op.sent += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                watch(op, EPOLLOUT);
+            else
+                io_failed(op, std::string("send failed: ") + std::strerror(errno));
+            return;
+        }
+        op.phase = Phase::RECEIVING;
+        touch(op);
+        watch(op, EPOLLIN);
+        continue_receive(op);
+    }
+
+    void continue_receive(Op &op)
+    {
+        char buf[16384];
+        while (true)
+        {
+            ssize_t n;
+            if (op.conn.ssl)
+            {
+                ERR_clear_error();
+                int r = SSL_read(op.conn.ssl, buf, sizeof(buf));
+                if (r <= 0)
+                {
+                    int err = SSL_get_error(op.conn.ssl, r);
+                    if (err == SSL_ERROR_WANT_READ)
+                    {
+                        watch(op, EPOLLIN);
+                        return;
+                    }
+                    if (err == SSL_ERROR_WANT_WRITE)
+                    {
+                        watch(op, EPOLLOUT);
+                        return;
+                    }
+                    if (err != SSL_ERROR_ZERO_RETURN && !(err == SSL_ERROR_SYSCALL && r == 0))
+                    {
+                        io_failed(op, "SSL_read failed");
+                        return;
+                    }
+                    n = 0;
+                }
+                else
+                    n = r;
+            }
+            else
+            {
+                n = ::recv(op.conn.fd, buf, sizeof(buf), 0);
+                if (n < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK)
+                        return;
+                    io_failed(op, std::string("recv failed: ") + std::strerror(errno));
+                    return;
+                }
+            }
+
+            if (n == 0)
+            {
+                op.parser.finish_eof();
+                if (op.parser.done())
+                    complete_response(op, false);
+                else
+                    io_failed(op, op.parser.error());
+                return;
+            }
+            touch(op);
+            size_t used = op.parser.feed(buf, static_cast<size_t>(n));
+            if (op.parser.failed())
+            {
+                io_failed(op, op.parser.error());
+                return;
+            }
+            if (op.parser.done())
+            {
+                bool surplus = used < static_cast<size_t>(n);
+                complete_response(op, !surplus && op.parser.keep_alive() &&
+                                          op.parser.framing() != HttpResponseParser::Framing::UNTIL_EOF);
+                return;
+            }
+        }
+    }
+
+    void on_io(uint64_t id)
+    {
+        auto it = ops_.find(id);
+        if (it == ops_.end())
+            return;
+        Op &op = *it->second;
+        switch (op.phase)
+        {
+        case Phase::CONNECTING:
+        {
+            int soerr = 0;
+            socklen_t len = sizeof(soerr);
+            if (getsockopt(op.conn.fd, SOL_SOCKET, SO_ERROR, &soerr, &len) < 0)
+                soerr = errno;
+            if (soerr != 0)
+            {
+                const http_shared::Address &a = op.addresses[op.next_address - 1];
+                op.connect_error = std::string("connect failed to ") + http_shared::address_string(a) + ": " + std::strerror(soerr);
+                drop_connection(op);
+                try_connect(op);
+                return;
+            }
+            on_connected(op);
+            return;
+        }
+        case Phase::HANDSHAKE:
+            continue_handshake(op);
+            return;
+        case Phase::SENDING:
+            continue_send(op);
+            return;
+        case Phase::RECEIVING:
+            continue_receive(op);
+            return;
+        default:
+            return;
+        }
+    }
+
+    // A pooled connection the server closed while idle fails before any
+    // response byte; resend once on a fresh connection
+    void io_failed(Op &op, const std::string &error)
+    {
+        if (op.reused && !op.retried && op.parser.bytes_fed() == 0)
+        {
+            drop_connection(op);
+            op.reused = false;
+            op.retried = true;
+            resolve(op);
+            return;
+        }
+        fail(op, error);
+    }
+
+    void complete_response(Op &op, bool reusable)
+    {
+        HttpResponse response;
+        response.status = op.parser.status();
+        response.ok = response.status >= 200 && response.status < 300;
+        response.headers = op.parser.headers();
+        response.body = std::move(op.parser.body());
+        if (!response.ok)
+            response.error = "HTTP error: " + std::to_string(response.status) + " body=" + response.body;
+
+        if (op.conn.ssl)
+            http_shared::save_session(op.key, op.conn.ssl);
+        unwatch(op);
+        if (reusable)
+        {
+            Host &host = hosts_[op.key];
+            op.conn.idle_since = Clock::now();
+            host.idle.push_back(op.conn);
+            if (host.idle.size() > max_per_host_)
+            {
+                close_connection(host.idle.front());
+                host.idle.erase(host.idle.begin());
+            }
+            op.conn = Connection();
+        }
+        else
+            close_connection(op.conn);
+        complete(op, std::move(response));
+    }
+
+    void fail(Op &op, const std::string &error)
+    {
+        drop_connection(op);
+        HttpResponse response;
+        response.error = error;
+        complete(op, std::move(response));
+    }
+
+    // Hand the result over, free the slot and start whoever waited for it
+    void complete(Op &op, HttpResponse response)
+    {
+        response.duration_us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - op.start).count());
+        std::unique_ptr<Op> owned = std::move(ops_[op.id]);
+        ops_.erase(op.id);
+        std::string key = owned->key;
+        if (owned->holds_slot)
+            --hosts_[key].open;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.completed;
+            if (!response.ok)
+                ++stats_.failed;
+            --stats_.in_flight;
+        }
+        deliver(owned->done, std::move(response));
+
+        Host &host = hosts_[key];
+        while (!host.waiting.empty() && host.open < max_per_host_)
+        {
+            uint64_t next = host.waiting.front();
+            host.waiting.pop_front();
+            auto it = ops_.find(next);
+            if (it != ops_.end())
+                acquire_slot(*it->second);
+        }
+    }
+
+    void deliver(Callback &done, HttpResponse response)
+    {
+        if (!done)
+            return;
+        try
+        {
+            done(std::move(response));
+        }
+        catch (const std::exception &e)
+        {
+            JLOG_ERROR("AsyncHttp") << "Completion callback threw: " << e.what();
+        }
+    }
+
+    void finish_unstarted(Callback done)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.completed;
+            ++stats_.failed;
+            --stats_.in_flight;
+        }
+        HttpResponse response;
+        response.error = "client shut down";
+        deliver(done, std::move(response));
+    }
+
+    void expire()
+    {
+        Clock::time_point now = Clock::now();
+        std::vector<uint64_t> late;
+        for (const auto &entry : ops_)
+            if (entry.second->phase != Phase::WAITING && entry.second->deadline <= now)
+                late.push_back(entry.first);
+        for (uint64_t id : late)
+        {
+            auto it = ops_.find(id);
+            if (it == ops_.end())
+                continue;
+            Op &op = *it->second;
+            const char *what = "recv timeout";
+            if (op.phase == Phase::RESOLVING)
+                what = "getaddrinfo timeout";
+            else if (op.phase == Phase::CONNECTING)
+                what = "connect timeout";
+            else if (op.phase == Phase::HANDSHAKE)
+                what = "SSL_connect timeout";
+            else if (op.phase == Phase::SENDING)
+                what = "send timeout";
+            fail(op, what);
+        }
+    }
+
+    void fail_everything()
+    {
+        for (auto &entry : hosts_)
+            entry.second.waiting.clear();
+        while (!ops_.empty())
+        {
+            Op &op = *ops_.begin()->second;
+            op.holds_slot = false; // nothing left to start
+            fail(op, "client shut down");
+        }
+        for (auto &entry : hosts_)
+            for (Connection &c : entry.second.idle)
+                close_connection(c);
+        hosts_.clear();
+    }
+
+    static constexpr int kIdleTimeoutMs = 30000;
+
+    const size_t max_per_host_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+
+    // Shared with submitting threads and the resolver
+    mutable std::mutex mutex_;
+    std::deque<std::pair<HttpRequest, Callback>> incoming_;
+    std::deque<Resolved> resolved_;
+    AsyncHttpStats stats_;
+    bool stopping_ = false;
+
+    // Reactor thread only
+    std::map<uint64_t, std::unique_ptr<Op>> ops_;
+    std::map<std::string, Host> hosts_;
+    uint64_t next_id_ = 1;
+
+    jarvis::WorkerPool resolver_;
+    std::thread reactor_;
+};
+
+AsyncHttpClient::AsyncHttpClient(size_t max_connections_per_host)
+    : impl_(new Impl(max_connections_per_host))
+{
+}
+
+AsyncHttpClient::~AsyncHttpClient() = default;
+
+void AsyncHttpClient::send(HttpRequest request, Callback done)
+{
+    impl_->submit(std::move(request), std::move(done));
+}
+
+std::future<HttpResponse> AsyncHttpClient::send(HttpRequest request)
+{
+    auto promise = std::make_shared<std::promise<HttpResponse>>();
+    std::future<HttpResponse> future = promise->get_future();
+    impl_->submit(std::move(request), [promise](HttpResponse response) { promise->set_value(std::move(response)); });
+    return future;
+}
+
+std::future<HttpResponse> AsyncHttpClient::get(const std::string &host, uint16_t port, const std::string &path,
+                                               int timeout_ms, bool use_tls)
+{
+    HttpRequest request;
+    request.host = host;
+    request.port = port;
+    request.path = path;
+    request.timeout_ms = timeout_ms;
+    request.use_tls = use_tls;
+    return send(std::move(request));
+}
+
+std::future<HttpResponse> AsyncHttpClient::post(const std::string &host, uint16_t port, const std::string &path,
+                                                const std::string &body, const std::string &content_type,
+                                                int timeout_ms, bool use_tls)
+{
+    HttpRequest request;
+    request.method = "POST";
+    request.host = host;
+    request.port = port;
+    request.path = path;
+    request.body = body;
+    request.content_type = content_type;
+    request.timeout_ms = timeout_ms;
+    request.use_tls = use_tls;
+    return send(std::move(request));
+}
+
+AsyncHttpStats AsyncHttpClient::stats() const
+{
+    return impl_->stats();
+}
+
+void AsyncHttpClient::shutdown()
+{
+    impl_->shutdown();
+}
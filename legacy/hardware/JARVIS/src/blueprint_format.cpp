@@ -0,0 +1,437 @@
+#include "blueprint_format.hpp"
+#include "sketch_pad.hpp"
+#include "crypto.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Binary blueprints are little-endian; add byte swapping for this target"
+#endif
+
+namespace sketch
+{
+
+    namespace
+    {
+
+        const char kMagic[4] = {'J', 'R', 'V', 'B'};
+        const int kColumns = 6;
+
+        size_t pad8(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+    } // namespace
+
+    std::string blueprint_secret()
+    {
+        const char *secret_env = std::getenv("JARVIS_SECRET");
+        return (secret_env && *secret_env) ? std::string(secret_env) : std::string();
+    }
+
+    bool is_binary_blueprint(const void *data, size_t size)
+    {
+        return data && size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+    }
+
+    std::string encode_blueprint(const Sketch &sketch, const GridConfig &grid)
+    {
+        const uint32_t n = static_cast<uint32_t>(sketch.lines.size());
+
+        BlueprintHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.version = kBlueprintVersion;
+        h.header_size = sizeof(BlueprintHeader);
+        h.line_count = n;
+        h.name_length = static_cast<uint32_t>(sketch.name.size());
+        h.width = sketch.width;
+        h.height = sketch.height;
+        h.created_timestamp = sketch.created_timestamp;
+        h.grid_spacing_percent = grid.grid_spacing_percent;
+        h.real_world_spacing_cm = grid.real_world_spacing_cm;
+        h.grid_flags = (grid.snap_to_grid ? kGridSnap : 0u) | (grid.show_measurements ? kGridMeasurements : 0u);
+        h.columns_offset = static_cast<uint32_t>(sizeof(BlueprintHeader) + pad8(sketch.name.size()));
+
+        std::string out(h.columns_offset + static_cast<size_t>(kColumns) * n * 4, '\0');
+        char *base = &out[0];
+        std::memcpy(base, &h, sizeof(h));
+        std::memcpy(base + sizeof(h), sketch.name.data(), sketch.name.size());
+
+        float *x0 = reinterpret_cast<float *>(base + h.columns_offset);
+        float *y0 = x0 + n;
+        float *x1 = y0 + n;
+        float *y1 = x1 + n;
+        uint32_t *color = reinterpret_cast<uint32_t *>(y1 + n);
+        int32_t *thickness = reinterpret_cast<int32_t *>(color + n);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            const Line &line = sketch.lines[i];
+            x0[i] = line.start.x;
+            y0[i] = line.start.y;
+            x1[i] = line.end.x;
+            y1[i] = line.end.y;
+            color[i] = line.color;
+            thickness[i] = line.thickness;
+        }
+        return out;
+    }
+
+    std::string blueprint_signature(const void *data, size_t size, const std::string &secret)
+    {
+        return secret.empty() ? crypto::sha256_hex(data, size)
+                              : crypto::hmac_sha256_hex(data, size, secret);
+    }
+
+    bool ensure_parent_dirs(const std::string &path)
+    {
+        auto pos = path.find_last_of('/');
+        if (pos == std::string::npos)
+            return true; // no parent dir
+        std::string dir = path.substr(0, pos);
+        // Create directories iteratively
+        std::string accum;
+        size_t start = 0;
+        if (dir.size() > 0 && dir[0] == '/')
+        {
+            accum = "/";
+            start = 1;
+        }
+        while (start < dir.size())
+        {
+            auto next = dir.find('/', start);
+            std::string part = dir.substr(start, (next == std::string::npos) ? std::string::npos : next - start);
+            if (!accum.empty() && accum.back() != '/')
+                accum += "/";
+            accum += part;
+            struct stat st = {};
+            if (stat(accum.c_str(), &st) != 0)
+            {
+                if (mkdir(accum.c_str(), 0755) != 0 && errno != EEXIST)
+                    return false;
+            }
+            if (next == std::string::npos)
+                break;
+            start = next + 1;
+        }
+        return true;
+    }
+
+    bool write_file_atomic(const std::string &path, const void *data, size_t size)
+    {
+        std::string tmp_path = path + ".tmp";
+        int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fd < 0)
+        {
+            std::cerr << "[Blueprint] Failed to open temp file for writing: " << tmp_path << " (" << strerror(errno) << ")\n";
+            return false;
+        }
+
+        // Write full payload (loop to handle partial writes)
+        const char *buf = static_cast<const char *>(data);
+        size_t to_write = size;
+        while (to_write > 0)
+        {
+            ssize_t written = ::write(fd, buf, to_write);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                std::cerr << "[Blueprint] Write error: " << strerror(errno) << "\n";
+                close(fd);
+                unlink(tmp_path.c_str());
+                return false;
+            }
+            to_write -= static_cast<size_t>(written);
+            buf += written;
+        }
+
+        // Ensure data hits disk
+        if (fsync(fd) != 0)
+        {
+            std::cerr << "[Blueprint] fsync failed: " << strerror(errno) << "\n";
+            close(fd);
+            unlink(tmp_path.c_str());
+            return false;
+        }
+
+        if (close(fd) != 0)
+        {
+            std::cerr << "[Blueprint] close failed: " << strerror(errno) << "\n";
+            unlink(tmp_path.c_str());
+            return false;
+        }
+
+        // Atomically replace target
+        if (rename(tmp_path.c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "[Blueprint] rename failed: " << strerror(errno) << "\n";
+            unlink(tmp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool stage_blueprint(const std::string &staged, const Sketch &sketch, const GridConfig &grid,
+                         const std::string &secret, std::string *signature_out)
+    {
+        if (!ensure_parent_dirs(staged))
+        {
+            std::cerr << "[Blueprint] Failed to create parent directory for: " << staged << "\n";
+            return false;
+        }
+        std::string payload = encode_blueprint(sketch, grid);
+        if (!write_file_atomic(staged, payload.data(), payload.size()))
+            return false;
+        if (signature_out)
+            *signature_out = blueprint_signature(payload.data(), payload.size(), secret);
+        return true;
+    }
+
+    bool install_blueprint(const std::string &staged, const std::string &path, const std::string &signature)
+    {
+        // The base and its .sig cannot be swapped by one rename, so the new
+        // signature is listed ahead of the current one until the base is in
+        // place: whichever base a crash leaves behind still verifies.
+        const std::string sig_path = blueprint_signature_path(path);
+        const std::string current = read_blueprint_signature(path);
+        std::string both = signature + "\n";
+        if (!current.empty() && current != signature)
+            both += current + "\n";
+        if (!write_file_atomic(sig_path, both.data(), both.size()))
+            return false;
+        if (rename(staged.c_str(), path.c_str()) != 0)
+        {
+            std::cerr << "[Blueprint] rename failed: " << strerror(errno) << "\n";
+            return false;
+        }
+        // Retire the previous signature; if this fails the pair still verifies
+        std::string sig_line = signature + "\n";
+        if (!write_file_atomic(sig_path, sig_line.data(), sig_line.size()))
+            std::cerr << "[Blueprint] Previous signature left in " << sig_path << "\n";
+        return true;
+    }
+
+    bool persist_blueprint(const std::string &path, const Sketch &sketch, const GridConfig &grid,
+                           const std::string &secret, std::string *signature_out)
+    {
+        const std::string staged = path + ".new";
+        std::string sig;
+        if (!stage_blueprint(staged, sketch, grid, secret, &sig))
+            return false;
+        if (!install_blueprint(staged, path, sig))
+        {
+            unlink(staged.c_str());
+            return false;
+        }
+        if (signature_out)
+            *signature_out = sig;
+        return true;
+    }
+
+    std::vector<std::string> read_blueprint_signatures(const std::string &path)
+    {
+        std::ifstream in(blueprint_signature_path(path));
+        std::vector<std::string> sigs;
+        std::string sig;
+        while (in >> sig)
+            sigs.push_back(sig);
+        return sigs;
+    }
+
+    std::string read_blueprint_signature(const std::string &path)
+    {
+        std::ifstream in(blueprint_signature_path(path));
+        std::string sig;
+        if (in.is_open())
+            in >> sig;
+        return sig;
+    }
+
+    std::string verified_blueprint_signature(const BlueprintView &view, const std::string &path,
+                                             const std::string &secret)
+    {
+        for (const std::string &sig : read_blueprint_signatures(path))
+        {
+            if (view.verify_signature(sig, secret))
+                return sig;
+        }
+        return std::string();
+    }
+
+    // ------------------------------------------------------------------------
+    // BlueprintView
+    // ------------------------------------------------------------------------
+
+    BlueprintView::~BlueprintView()
+    {
+        close();
+    }
+
+    BlueprintView::BlueprintView(BlueprintView &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    BlueprintView &BlueprintView::operator=(BlueprintView &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            data_ = other.data_;
+            size_ = other.size_;
+            header_ = other.header_;
+            mapping_ = other.mapping_;
+            error_ = std::move(other.error_);
+            other.data_ = nullptr;
+            other.size_ = 0;
+            other.header_ = nullptr;
+            other.mapping_ = nullptr;
+        }
+        return *this;
+    }
+
+    bool BlueprintView::open(const std::string &path)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            error_ = "cannot open " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            error_ = "empty or unreadable file: " + path;
+            ::close(fd);
+            return false;
+        }
+        void *m = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps the file referenced
+        if (m == MAP_FAILED)
+        {
+            error_ = "mmap failed for " + path + ": " + std::strerror(errno);
+            return false;
+        }
+        mapping_ = m;
+        data_ = static_cast<const uint8_t *>(m);
+        size_ = static_cast<size_t>(st.st_size);
+        if (!validate())
+        {
+            std::string err = error_;
+            close();
+            error_ = err;
+            return false;
+        }
+        return true;
+    }
+
+    bool BlueprintView::attach(const void *data, size_t size)
+    {
+        close();
+        data_ = static_cast<const uint8_t *>(data);
+        size_ = size;
+        if (!validate())
+        {
+            data_ = nullptr;
+            size_ = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void BlueprintView::close()
+    {
+        if (mapping_)
+            munmap(mapping_, size_);
+        mapping_ = nullptr;
+        data_ = nullptr;
+        size_ = 0;
+        header_ = nullptr;
+        error_.clear();
+    }
+
+    bool BlueprintView::validate()
+    {
+        header_ = nullptr;
+        if (!is_binary_blueprint(data_, size_) || size_ < sizeof(BlueprintHeader))
+        {
+            error_ = "not a binary blueprint";
+            return false;
+        }
+        const BlueprintHeader *h = reinterpret_cast<const BlueprintHeader *>(data_);
+        if (h->version != kBlueprintVersion)
+        {
+            error_ = "unsupported blueprint version " + std::to_string(h->version);
+            return false;
+        }
+        // 64-bit arithmetic: a hostile header must not wrap the bounds check
+        uint64_t name_end = static_cast<uint64_t>(h->header_size) + h->name_length;
+        uint64_t end = static_cast<uint64_t>(h->columns_offset) + static_cast<uint64_t>(kColumns) * h->line_count * 4;
+        if (h->header_size < sizeof(BlueprintHeader) || h->columns_offset % 4 != 0 ||
+            h->columns_offset < name_end || end > size_)
+        {
+            error_ = "truncated or corrupt blueprint";
+            return false;
+        }
+        header_ = h;
+        return true;
+    }
+
+    std::string BlueprintView::name() const
+    {
+        if (!header_)
+            return std::string();
+        return std::string(reinterpret_cast<const char *>(data_) + header_->header_size, header_->name_length);
+    }
+
+    bool BlueprintView::verify_signature(const std::string &signature_hex, const std::string &secret) const
+    {
+        if (!valid() || signature_hex.empty())
+            return false;
+        return blueprint_signature(data_, size_, secret) == signature_hex;
+    }
+
+    void BlueprintView::to_sketch(Sketch &out, GridConfig *grid) const
+    {
+        if (!valid())
+            return;
+        const BlueprintHeader &h = *header_;
+        out.name = name();
+        out.width = h.width;
+        out.height = h.height;
+        out.created_timestamp = h.created_timestamp;
+
+        const uint32_t n = h.line_count;
+        const float *ax0 = x0(), *ay0 = y0(), *ax1 = x1(), *ay1 = y1();
+        const uint32_t *acolor = color();
+        const int32_t *athick = thickness();
+        out.lines.resize(n);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            Line &line = out.lines[i];
+            line.start = Point(ax0[i], ay0[i]);
+            line.end = Point(ax1[i], ay1[i]);
+            line.color = acolor[i];
+            line.thickness = athick[i];
+            line.timestamp = 0;
+        }
+
+        if (grid)
+        {
+            grid->grid_spacing_percent = h.grid_spacing_percent;
+            grid->real_world_spacing_cm = h.real_world_spacing_cm;
+            grid->snap_to_grid = (h.grid_flags & kGridSnap) != 0;
+            grid->show_measurements = (h.grid_flags & kGridMeasurements) != 0;
+            // Same as the JSON path: a stored grid turns grid rendering on
+            grid->enabled = true;
+        }
+    }
+
+} // namespace sketch
@@ -0,0 +1,525 @@
+#include "blueprint_outbox.hpp"
+#include "async_http_client.hpp"
+#include "logger.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <set>
+#include <utility>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace sketch
+{
+
+    namespace
+    {
+        const char *kPendingSuffix = ".pending.json";
+        // Rewrite the log once it holds this many records per live one
+        const size_t kCompactRatio = 4;
+        const size_t kCompactMin = 64;
+
+        // mkdir -p
+        void make_dirs(const std::string &dir)
+        {
+            for (size_t pos = dir.find('/', 1); ; pos = dir.find('/', pos + 1))
+            {
+                ::mkdir(dir.substr(0, pos).c_str(), 0755);
+                if (pos == std::string::npos)
+                    break;
+            }
+        }
+
+        std::string queued_record(uint64_t seq, const std::string &name, const std::string &data)
+        {
+            return "{\"seq\":" + std::to_string(seq) + ",\"name\":" + json(name).dump() + ",\"data\":" + data + "}\n";
+        }
+
+        std::string done_record(uint64_t seq, const std::string &name)
+        {
+            return "{\"seq\":" + std::to_string(seq) + ",\"name\":" + json(name).dump() + ",\"done\":true}\n";
+        }
+
+        std::string upload_body(const std::string &name, const std::string &data)
+        {
+            return "{\"name\":" + json(name).dump() + ",\"data\":" + data + "}";
+        }
+
+        bool write_all(int fd, const std::string &bytes)
+        {
+            const char *ptr = bytes.data();
+            size_t left = bytes.size();
+            while (left > 0)
+            {
+                ssize_t w = ::write(fd, ptr, left);
+                if (w < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                left -= static_cast<size_t>(w);
+                ptr += w;
+            }
+            return true;
+        }
+    }
+
+    BlueprintOutbox::BlueprintOutbox(AsyncHttpClient &http, std::string dir, OutboxConfig config)
+        : http_(http), dir_(std::move(dir)), config_(std::move(config)), rng_(std::random_device()())
+    {
+        if (config_.max_in_flight == 0)
+            config_.max_in_flight = 1;
+        if (config_.max_batch == 0)
+            config_.max_batch = 1;
+        make_dirs(dir_);
+        log_path_ = dir_ + "/outbox.log";
+        load_log();
+        import_pending_files();
+        if (!entries_.empty())
+            JLOG_INFO("Outbox") << entries_.size() << " upload(s) queued from an earlier run";
+        if (config_.background)
+            thread_ = std::thread([this]() { run(); });
+    }
+
+    BlueprintOutbox::~BlueprintOutbox()
+    {
+        shutdown();
+        if (log_fd_ >= 0)
+            ::close(log_fd_);
+    }
+
+    uint64_t BlueprintOutbox::enqueue(const std::string &name, const std::string &export_json)
+    {
+        json j = json::parse(export_json, nullptr, false);
+        if (j.is_discarded() || name.empty())
+        {
+            JLOG_WARN("Outbox") << "Not queueing '" << name << "': export is not valid JSON";
+            return 0;
+        }
+        std::string data = j.dump();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t seq = ++last_seq_;
+        if (!append(queued_record(seq, name, data)))
+            JLOG_WARN("Outbox") << "Cannot append to " << log_path_ << "; '" << name << "' is queued in memory only";
+        auto it = entries_.find(name);
+        if (it != entries_.end())
+        {
+            ++stats_.coalesced;
+            it->second.seq = seq;
+            it->second.data.swap(data);
+        }
+        else
+        {
+            Entry &entry = entries_[name];
+            entry.seq = seq;
+            entry.data.swap(data);
+            entry.due = Clock::now();
+        }
+        ++stats_.enqueued;
+        wake_.notify_all();
+        return seq;
+    }
+
+    size_t BlueprintOutbox::drain(bool ignore_backoff)
+    {
+        std::vector<Upload> uploads;
+        bool batching;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Clock::time_point now = Clock::now();
+            for (auto &entry : entries_)
+            {
+                Entry &e = entry.second;
+                if (e.in_flight || (!ignore_backoff && e.due > now))
+                    continue;
+                e.in_flight = true;
+                uploads.push_back(Upload{entry.first, e.seq, upload_body(entry.first, e.data)});
+            }
+            batching = !config_.batch_path.empty() && batch_supported_ && uploads.size() > 1;
+        }
+        if (uploads.empty())
+            return 0;
+        // Oldest first
+        std::sort(uploads.begin(), uploads.end(),
+                  [](const Upload &a, const Upload &b) { return a.seq < b.seq; });
+
+        // Each group is one request: a single upload or a batch
+        std::deque<std::vector<size_t>> todo;
+        for (size_t i = 0; i < uploads.size(); ++i)
+        {
+            if (batching && !todo.empty())
+            {
+                std::vector<size_t> &group = todo.back();
+                size_t bytes = 0;
+                for (size_t k : group)
+                    bytes += uploads[k].body.size();
+                if (group.size() < config_.max_batch && bytes + uploads[i].body.size() <= config_.max_batch_bytes)
+                {
+                    group.push_back(i);
+                    continue;
+                }
+            }
+            todo.push_back(std::vector<size_t>(1, i));
+        }
+
+        size_t accepted = 0;
+        std::deque<std::pair<std::vector<size_t>, std::future<HttpResponse>>> window;
+        while (!todo.empty() || !window.empty())
+        {
+            while (!todo.empty() && window.size() < config_.max_in_flight)
+            {
+                std::vector<size_t> group = std::move(todo.front());
+                todo.pop_front();
+                HttpRequest request;
+                request.method = "POST";
+                request.host = config_.host;
+                request.port = config_.port;
+                request.use_tls = config_.use_tls;
+                request.timeout_ms = config_.timeout_ms;
+                if (group.size() == 1)
+                {
+                    const Upload &u = uploads[group[0]];
+                    request.path = config_.save_path ? config_.save_path(u.name) : std::string("/");
+                    request.body = u.body;
+                }
+                else
+                {
+                    request.path = config_.batch_path;
+                    request.body = "{\"blueprints\":[";
+                    for (size_t k = 0; k < group.size(); ++k)
+                    {
+                        if (k)
+                            request.body += ',';
+                        request.body += uploads[group[k]].body;
+                    }
+                    request.body += "]}";
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++stats_.requests;
+                    if (group.size() > 1)
+                        ++stats_.batches;
+                }
+                window.emplace_back(std::move(group), http_.send(std::move(request)));
+            }
+
+            std::vector<size_t> group = std::move(window.front().first);
+            HttpResponse resp = window.front().second.get();
+            window.pop_front();
+
+            if (group.size() == 1)
+            {
+                if (!resp.ok)
+                    JLOG_WARN("Outbox") << "Upload of '" << uploads[group[0]].name << "' failed: " << resp.error;
+                finish(uploads[group[0]], resp.ok);
+                accepted += resp.ok ? 1 : 0;
+                continue;
+            }
+            if (resp.status == 404 || resp.status == 405 || resp.status == 501)
+            {
+                // No batch endpoint: send these one by one
+                JLOG_INFO("Outbox") << "Server has no batch upload; sending blueprints one by one";
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    batch_supported_ = false;
+                }
+                for (size_t k : group)
+                    todo.push_back(std::vector<size_t>(1, k));
+                continue;
+            }
+            // A 2xx accepts every blueprint not listed in "rejected"
+            std::set<std::string> rejected;
+            if (resp.ok)
+            {
+                json answer = json::parse(resp.body, nullptr, false);
+                if (answer.is_object() && answer.contains("rejected") && answer["rejected"].is_array())
+                    for (const auto &n : answer["rejected"])
+                        if (n.is_string())
+                            rejected.insert(n.get<std::string>());
+            }
+            else
+            {
+                JLOG_WARN("Outbox") << "Batch of " << group.size() << " uploads failed: " << resp.error;
+            }
+            for (size_t k : group)
+            {
+                bool ok = resp.ok && !rejected.count(uploads[k].name);
+                finish(uploads[k], ok);
+                accepted += ok ? 1 : 0;
+            }
+        }
+        if (accepted)
+            JLOG_INFO("Outbox") << "Uploaded " << accepted << " queued blueprint(s)";
+        return accepted;
+    }
+
+    void BlueprintOutbox::retry_now()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Clock::time_point now = Clock::now();
+        for (auto &entry : entries_)
+            entry.second.due = now;
+        kicked_ = true;
+        wake_.notify_all();
+    }
+
+    void BlueprintOutbox::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    size_t BlueprintOutbox::pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    bool BlueprintOutbox::queued(const std::string &name) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.count(name) != 0;
+    }
+
+    uint64_t BlueprintOutbox::last_sequence() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_seq_;
+    }
+
+    OutboxStats BlueprintOutbox::stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        OutboxStats out = stats_;
+        out.pending = entries_.size();
+        return out;
+    }
+
+    void BlueprintOutbox::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopped_)
+        {
+            Clock::time_point next = Clock::time_point::max();
+            for (const auto &entry : entries_)
+                if (!entry.second.in_flight)
+                    next = std::min(next, entry.second.due);
+            if (!kicked_ && next > Clock::now())
+            {
+                if (next == Clock::time_point::max())
+                    wake_.wait(lock);
+                else
+                    wake_.wait_until(lock, next);
+                continue;
+            }
+            bool all = kicked_;
+            kicked_ = false;
+            lock.unlock();
+            drain(all);
+            lock.lock();
+        }
+    }
+
+    void BlueprintOutbox::finish(const Upload &upload, bool ok)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(upload.name);
+        if (it == entries_.end())
+            return;
+        Entry &e = it->second;
+        e.in_flight = false;
+        if (!ok)
+        {
+            ++stats_.failed;
+            ++e.attempts;
+            e.due = Clock::now() + backoff_locked(e.attempts);
+            return;
+        }
+        ++stats_.uploaded;
+        append(done_record(upload.seq, upload.name));
+        if (e.seq == upload.seq)
+        {
+            entries_.erase(it);
+            if (log_records_ > kCompactMin && log_records_ > kCompactRatio * entries_.size())
+                compact_locked();
+        }
+        else
+        {
+            // Saved again while uploading: the newer export goes next
+            e.attempts = 0;
+            e.due = Clock::now();
+            wake_.notify_all();
+        }
+    }
+
+    std::chrono::milliseconds BlueprintOutbox::backoff_locked(int attempts)
+    {
+        // Exponential with "equal jitter": half fixed, half random, so
+        // devices that lost the server together do not retry together
+        int64_t delay = config_.backoff_initial_ms;
+        for (int i = 1; i < attempts && delay < config_.backoff_max_ms; ++i)
+            delay *= 2;
+        delay = std::min<int64_t>(delay, config_.backoff_max_ms);
+        std::uniform_int_distribution<int64_t> jitter(0, delay / 2);
+        return std::chrono::milliseconds(delay - delay / 2 + jitter(rng_));
+    }
+
+    bool BlueprintOutbox::append(const std::string &record)
+    {
+        if (log_fd_ < 0)
+            log_fd_ = ::open(log_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
+        if (log_fd_ < 0 || !write_all(log_fd_, record))
+            return false;
+        ::fdatasync(log_fd_);
+        ++log_records_;
+        return true;
+    }
+
+    void BlueprintOutbox::compact_locked()
+    {
+        std::vector<std::pair<uint64_t, const std::string *>> live;
+        for (const auto &entry : entries_)
+            live.emplace_back(entry.second.seq, &entry.first);
+        std::sort(live.begin(), live.end());
+
+        std::string tmp = log_path_ + ".tmp";
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+        if (fd < 0)
+            return;
+        bool ok = true;
+        for (const auto &l : live)
+            ok = ok && write_all(fd, queued_record(l.first, *l.second, entries_[*l.second].data));
+        ok = ::fsync(fd) == 0 && ok;
+        ::close(fd);
+        if (!ok || std::rename(tmp.c_str(), log_path_.c_str()) != 0)
+        {
+            ::unlink(tmp.c_str());
+            return;
+        }
+        if (log_fd_ >= 0)
+            ::close(log_fd_);
+        log_fd_ = -1;
+        log_records_ = live.size();
+        ++stats_.compactions;
+    }
+
+    void BlueprintOutbox::load_log()
+    {
+        std::string data;
+        {
+            std::ifstream in(log_path_, std::ios::binary);
+            if (!in)
+                return;
+            data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        // A torn last record (crash mid-append) has no newline; cut it so the
+        // next append starts a line of its own
+        const size_t end = data.rfind('\n') == std::string::npos ? 0 : data.rfind('\n') + 1;
+        if (end < data.size())
+        {
+            JLOG_WARN("Outbox") << "Dropping " << (data.size() - end) << " torn byte(s) at end of " << log_path_;
+            if (::truncate(log_path_.c_str(), static_cast<off_t>(end)) != 0)
+                JLOG_WARN("Outbox") << "Cannot truncate " << log_path_ << ": " << std::strerror(errno);
+            data.resize(end);
+        }
+
+        size_t records = 0;
+        bool damaged = false;
+        for (size_t pos = 0; pos < data.size();)
+        {
+            const size_t eol = data.find('\n', pos);
+            const std::string line = data.substr(pos, eol - pos);
+            pos = eol + 1;
+            json j = json::parse(line, nullptr, false);
+            if (j.is_discarded() || !j.is_object() || !j.contains("seq") || !j.contains("name"))
+            {
+                damaged = true;
+                continue;
+            }
+            try
+            {
+                uint64_t seq = j["seq"].get<uint64_t>();
+                std::string name = j["name"].get<std::string>();
+                last_seq_ = std::max(last_seq_, seq);
+                ++records;
+                if (j.value("done", false))
+                {
+                    auto it = entries_.find(name);
+                    if (it != entries_.end() && it->second.seq <= seq)
+                        entries_.erase(it);
+                }
+                else if (j.contains("data"))
+                {
+                    Entry &entry = entries_[name];
+                    if (entry.seq < seq)
+                    {
+                        entry.seq = seq;
+                        entry.data = j["data"].dump();
+                        entry.due = Clock::now();
+                    }
+                }
+            }
+            catch (const std::exception &)
+            {
+                damaged = true;
+            }
+        }
+        log_records_ = records;
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Rewrite without the lines that did not parse
+        if (damaged || log_records_ > entries_.size())
+            compact_locked();
+    }
+
+    void BlueprintOutbox::import_pending_files()
+    {
+        DIR *d = ::opendir(dir_.c_str());
+        if (!d)
+            return;
+        std::vector<std::string> names;
+        const std::string suffix = kPendingSuffix;
+        while (struct dirent *ent = ::readdir(d))
+        {
+            std::string file = ent->d_name;
+            if (file.size() > suffix.size() && file.compare(file.size() - suffix.size(), suffix.size(), suffix) == 0)
+                names.push_back(file);
+        }
+        ::closedir(d);
+
+        for (const auto &file : names)
+        {
+            std::string path = dir_ + "/" + file;
+            std::ifstream in(path, std::ios::binary);
+            std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            in.close();
+            // Written either as the upload body ({"name", "data"}) or as the export itself
+            json j = json::parse(text, nullptr, false);
+            if (j.is_object() && j.contains("data") && j.contains("name"))
+                j = j["data"];
+            std::string name = file.substr(0, file.size() - suffix.size());
+            if (!j.is_discarded() && enqueue(name, j.dump()) != 0)
+                ::unlink(path.c_str());
+            else
+                JLOG_WARN("Outbox") << "Ignoring unreadable queued upload " << path;
+        }
+    }
+
+} // namespace sketch
@@ -0,0 +1,624 @@
+#include "blueprint_store.hpp"
+#include "blueprint_format.hpp"
+#include "crypto.hpp"
+#include "line_journal.hpp"
+#include "signed_json.hpp"
+#include "sketch_pad.hpp"
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sketch
+{
+
+    namespace
+    {
+
+        const char kIndexMagic[4] = {'J', 'R', 'V', 'I'};
+        constexpr uint16_t kIndexVersion = 1;
+        const char kSuffix[] = ".jarvis";
+        constexpr size_t kSuffixLength = sizeof(kSuffix) - 1;
+
+        struct IndexHeader
+        {
+            char magic[4];
+            uint16_t version;
+            uint16_t header_size;
+            uint32_t count;
+            uint32_t record_size;
+            uint32_t names_offset;
+            uint32_t names_size;
+            uint8_t reserved[8];
+        };
+        static_assert(sizeof(IndexHeader) == 32, "IndexHeader layout changed");
+
+        struct IndexRecord
+        {
+            uint32_t name_offset; // into the name block
+            uint32_t name_length;
+            uint32_t line_count;
+            uint32_t flags;
+            float min_x, min_y, max_x, max_y;
+            uint8_t hash[32];
+            int64_t mtime_ns;
+            uint64_t size;
+            uint64_t journal_size;
+            uint8_t reserved[8];
+        };
+        static_assert(sizeof(IndexRecord) == 96, "IndexRecord layout changed");
+
+        std::string blueprint_path(const std::string &dir, const std::string &name)
+        {
+            return dir + "/" + name + kSuffix;
+        }
+
+        std::string journal_path(const std::string &path)
+        {
+            return path + ".journal";
+        }
+
+        // Size and mtime of a file; false if it does not exist
+        bool stat_file(const std::string &path, uint64_t &size, int64_t &mtime_ns)
+        {
+            struct stat st = {};
+            if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+                return false;
+            size = static_cast<uint64_t>(st.st_size);
+            mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+            return true;
+        }
+
+        uint64_t journal_size_of(const std::string &path)
+        {
+            uint64_t size = 0;
+            int64_t mtime = 0;
+            return stat_file(journal_path(path), size, mtime) ? size : 0;
+        }
+
+        bool less_by_name(const BlueprintIndexEntry &a, const BlueprintIndexEntry &b)
+        {
+            return a.name < b.name;
+        }
+
+        void set_bounds(BlueprintIndexEntry &e, const std::vector<Line> &lines)
+        {
+            e.line_count = static_cast<uint32_t>(lines.size());
+            e.min_x = e.min_y = e.max_x = e.max_y = 0;
+            for (size_t i = 0; i < lines.size(); ++i)
+            {
+                const Line &l = lines[i];
+                if (i == 0)
+                {
+                    e.min_x = e.max_x = l.start.x;
+                    e.min_y = e.max_y = l.start.y;
+                }
+                e.min_x = std::min({e.min_x, l.start.x, l.end.x});
+                e.max_x = std::max({e.max_x, l.start.x, l.end.x});
+                e.min_y = std::min({e.min_y, l.start.y, l.end.y});
+                e.max_y = std::max({e.max_y, l.start.y, l.end.y});
+            }
+        }
+
+        // Straight from the mapped columns; no Sketch copy
+        void set_bounds(BlueprintIndexEntry &e, const BlueprintView &view)
+        {
+            const uint32_t n = view.line_count();
+            e.line_count = n;
+            e.min_x = e.min_y = e.max_x = e.max_y = 0;
+            if (n == 0)
+                return;
+            const float *x0 = view.x0(), *y0 = view.y0(), *x1 = view.x1(), *y1 = view.y1();
+            float min_x = x0[0], max_x = x0[0], min_y = y0[0], max_y = y0[0];
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                min_x = std::min(min_x, std::min(x0[i], x1[i]));
+                max_x = std::max(max_x, std::max(x0[i], x1[i]));
+                min_y = std::min(min_y, std::min(y0[i], y1[i]));
+                max_y = std::max(max_y, std::max(y0[i], y1[i]));
+            }
+            e.min_x = min_x;
+            e.min_y = min_y;
+            e.max_x = max_x;
+            e.max_y = max_y;
+        }
+
+        // Replay an existing journal (never creates one). Opening also cuts a
+        // torn tail, as loading the blueprint would.
+        std::vector<JournalRecord> replay_journal(const std::string &path, const std::string &base_signature,
+                                                  const std::string &secret)
+        {
+            std::vector<JournalRecord> records;
+            if (journal_size_of(path) == 0)
+                return records;
+            LineJournal journal;
+            journal.open(journal_path(path), base_signature, secret, &records);
+            journal.close();
+            return records;
+        }
+
+        bool read_file(const std::string &path, std::string &out)
+        {
+            std::ifstream in(path, std::ios::binary);
+            if (!in.is_open())
+                return false;
+            out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            return true;
+        }
+
+        bool has_binary_magic(const std::string &path)
+        {
+            char magic[4] = {};
+            std::ifstream probe(path, std::ios::binary);
+            probe.read(magic, sizeof(magic));
+            return probe.gcount() == sizeof(magic) && is_binary_blueprint(magic, sizeof(magic));
+        }
+
+        StoreStatus json_status(SignedJsonResult result)
+        {
+            switch (result)
+            {
+            case SignedJsonResult::OK:
+                return StoreStatus::OK;
+            case SignedJsonResult::MISSING_SIGNATURE:
+                return StoreStatus::MISSING_SIGNATURE;
+            case SignedJsonResult::BAD_SIGNATURE:
+                return StoreStatus::BAD_SIGNATURE;
+            default:
+                return StoreStatus::UNREADABLE;
+            }
+        }
+
+        // Verify, then re-sign / compact one blueprint. Nothing is written
+        // unless the file verified with options.secret.
+        void process_blueprint(const StoreOptions &options, StoreFileResult &r)
+        {
+            const std::string path = blueprint_path(options.dir, r.name);
+            const bool check = options.verify || options.resign || options.compact;
+            const std::string &sign_with = options.resign ? options.new_secret : options.secret;
+
+            if (has_binary_magic(path))
+            {
+                BlueprintView view;
+                if (!view.open(path))
+                {
+                    r.status = StoreStatus::UNREADABLE;
+                    r.error = view.error();
+                    return;
+                }
+                std::string signature = read_blueprint_signature(path);
+                if (check && signature.empty())
+                {
+                    r.status = StoreStatus::MISSING_SIGNATURE;
+                    return;
+                }
+                if (check)
+                    signature = verified_blueprint_signature(view, path, options.secret);
+                if (check && signature.empty())
+                {
+                    r.status = StoreStatus::BAD_SIGNATURE;
+                    return;
+                }
+                // Only a verified base vouches for the journal's key
+                std::vector<JournalRecord> records;
+                if (check)
+                    records = replay_journal(path, signature, options.secret);
+                r.journal_records = records.size();
+
+                // Journal records are chained with the old key, so a re-sign
+                // folds them in as well
+                if (!records.empty() && (options.compact || options.resign))
+                {
+                    Sketch sketch;
+                    GridConfig grid;
+                    view.to_sketch(sketch, &grid);
+                    view.close();
+                    for (const auto &rec : records)
+                        LineJournal::apply(rec, sketch.lines, grid);
+                    if (!persist_blueprint(path, sketch, grid, sign_with))
+                    {
+                        r.status = StoreStatus::WRITE_FAILED;
+                        return;
+                    }
+                    std::remove(journal_path(path).c_str());
+                    r.compacted = true;
+                    r.resigned = options.resign;
+                }
+                else if (options.resign)
+                {
+                    std::string sig_line = blueprint_signature(view.data(), view.size(), sign_with) + "\n";
+                    if (!write_file_atomic(blueprint_signature_path(path), sig_line.data(), sig_line.size()))
+                    {
+                        r.status = StoreStatus::WRITE_FAILED;
+                        return;
+                    }
+                    // An empty journal is anchored to the old signature
+                    std::remove(journal_path(path).c_str());
+                    r.resigned = true;
+                }
+            }
+            else
+            {
+                // Legacy JSON: the reader verifies the embedded signature
+                std::string text;
+                if (!read_file(path, text))
+                {
+                    r.status = StoreStatus::UNREADABLE;
+                    r.error = "cannot read " + path;
+                    return;
+                }
+                Sketch sketch;
+                GridConfig grid;
+                r.status = json_status(read_signed_json_blueprint(text.data(), text.size(), options.secret, 3,
+                                                                  sketch, grid));
+                if (r.status != StoreStatus::OK)
+                    return;
+                // Rewritten in the binary format, as the next save would
+                if (options.compact || options.resign)
+                {
+                    if (!persist_blueprint(path, sketch, grid, sign_with))
+                    {
+                        r.status = StoreStatus::WRITE_FAILED;
+                        return;
+                    }
+                    r.compacted = options.compact;
+                    r.resigned = options.resign;
+                }
+            }
+
+            if (!index_blueprint(options.dir, r.name, sign_with, r.entry, &r.error))
+                r.status = StoreStatus::UNREADABLE;
+        }
+
+    } // namespace
+
+    // ------------------------------------------------------------------------
+    // Index file
+    // ------------------------------------------------------------------------
+
+    bool BlueprintIndex::load(const std::string &path)
+    {
+        entries_.clear();
+        std::string data;
+        if (!read_file(path, data))
+            return false;
+
+        IndexHeader h;
+        if (data.size() < sizeof(h))
+            return false;
+        std::memcpy(&h, data.data(), sizeof(h));
+        if (std::memcmp(h.magic, kIndexMagic, 4) != 0 || h.version != kIndexVersion ||
+            h.header_size != sizeof(IndexHeader) || h.record_size != sizeof(IndexRecord))
+            return false;
+        const uint64_t records_end = sizeof(IndexHeader) + static_cast<uint64_t>(h.count) * sizeof(IndexRecord);
+        if (records_end > h.names_offset || static_cast<uint64_t>(h.names_offset) + h.names_size > data.size())
+            return false;
+
+        entries_.resize(h.count);
+        for (uint32_t i = 0; i < h.count; ++i)
+        {
+            IndexRecord rec;
+            std::memcpy(&rec, data.data() + sizeof(IndexHeader) + i * sizeof(IndexRecord), sizeof(rec));
+            if (static_cast<uint64_t>(rec.name_offset) + rec.name_length > h.names_size)
+            {
+                entries_.clear();
+                return false;
+            }
+            BlueprintIndexEntry &e = entries_[i];
+            e.name.assign(data.data() + h.names_offset + rec.name_offset, rec.name_length);
+            e.line_count = rec.line_count;
+            e.flags = rec.flags;
+            e.min_x = rec.min_x;
+            e.min_y = rec.min_y;
+            e.max_x = rec.max_x;
+            e.max_y = rec.max_y;
+            std::memcpy(e.hash, rec.hash, sizeof(e.hash));
+            e.mtime_ns = rec.mtime_ns;
+            e.size = rec.size;
+            e.journal_size = rec.journal_size;
+        }
+        // Written sorted; a file that is not gets sorted rather than trusted
+        if (!std::is_sorted(entries_.begin(), entries_.end(), less_by_name))
+            std::sort(entries_.begin(), entries_.end(), less_by_name);
+        return true;
+    }
+
+    bool BlueprintIndex::save(const std::string &path) const
+    {
+        std::string names;
+        std::vector<IndexRecord> records(entries_.size());
+        for (size_t i = 0; i < entries_.size(); ++i)
+        {
+            const BlueprintIndexEntry &e = entries_[i];
+            IndexRecord &rec = records[i];
+            std::memset(&rec, 0, sizeof(rec));
+            rec.name_offset = static_cast<uint32_t>(names.size());
+            rec.name_length = static_cast<uint32_t>(e.name.size());
+            rec.line_count = e.line_count;
+            rec.flags = e.flags;
+            rec.min_x = e.min_x;
+            rec.min_y = e.min_y;
+            rec.max_x = e.max_x;
+            rec.max_y = e.max_y;
+            std::memcpy(rec.hash, e.hash, sizeof(rec.hash));
+            rec.mtime_ns = e.mtime_ns;
+            rec.size = e.size;
+            rec.journal_size = e.journal_size;
+            names += e.name;
+        }
+
+        IndexHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, kIndexMagic, 4);
+        h.version = kIndexVersion;
+        h.header_size = sizeof(IndexHeader);
+        h.count = static_cast<uint32_t>(records.size());
+        h.record_size = sizeof(IndexRecord);
+        h.names_offset = static_cast<uint32_t>(sizeof(IndexHeader) + records.size() * sizeof(IndexRecord));
+        h.names_size = static_cast<uint32_t>(names.size());
+
+        std::string out(reinterpret_cast<const char *>(&h), sizeof(h));
+        if (!records.empty())
+            out.append(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(IndexRecord));
+        out += names;
+        return write_file_atomic(path, out.data(), out.size());
+    }
+
+    const BlueprintIndexEntry *BlueprintIndex::find(const std::string &name) const
+    {
+        BlueprintIndexEntry key;
+        key.name = name;
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), key, less_by_name);
+        return it != entries_.end() && it->name == name ? &*it : nullptr;
+    }
+
+    std::vector<const BlueprintIndexEntry *> BlueprintIndex::with_prefix(const std::string &prefix) const
+    {
+        std::vector<const BlueprintIndexEntry *> out;
+        BlueprintIndexEntry key;
+        key.name = prefix;
+        for (auto it = std::lower_bound(entries_.begin(), entries_.end(), key, less_by_name);
+             it != entries_.end() && it->name.compare(0, prefix.size(), prefix) == 0; ++it)
+            out.push_back(&*it);
+        return out;
+    }
+
+    void BlueprintIndex::put(BlueprintIndexEntry entry)
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), entry, less_by_name);
+        if (it != entries_.end() && it->name == entry.name)
+            *it = std::move(entry);
+        else
+            entries_.insert(it, std::move(entry));
+    }
+
+    bool BlueprintIndex::remove(const std::string &name)
+    {
+        BlueprintIndexEntry key;
+        key.name = name;
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), key, less_by_name);
+        if (it == entries_.end() || it->name != name)
+            return false;
+        entries_.erase(it);
+        return true;
+    }
+
+    size_t BlueprintIndex::refresh(const std::string &dir, const std::string &secret, size_t threads)
+    {
+        std::vector<std::string> names = list_blueprints(dir);
+        size_t changed = 0;
+
+        // Drop entries whose file is gone (both lists are sorted)
+        std::vector<BlueprintIndexEntry> kept;
+        kept.reserve(entries_.size());
+        for (auto &e : entries_)
+        {
+            if (std::binary_search(names.begin(), names.end(), e.name))
+                kept.push_back(std::move(e));
+            else
+                ++changed;
+        }
+        entries_.swap(kept);
+
+        // Stat only here; unchanged files are never opened
+        std::vector<std::string> stale;
+        for (const auto &name : names)
+        {
+            const std::string path = blueprint_path(dir, name);
+            uint64_t size = 0;
+            int64_t mtime_ns = 0;
+            if (!stat_file(path, size, mtime_ns))
+                continue;
+            const BlueprintIndexEntry *known = find(name);
+            if (known && known->size == size && known->mtime_ns == mtime_ns &&
+                known->journal_size == journal_size_of(path))
+                continue;
+            stale.push_back(name);
+        }
+
+        // Verifying and replaying is the slow part: one task per file, each
+        // writing its own slot, as in run_store_pass
+        std::vector<BlueprintIndexEntry> indexed(stale.size());
+        std::vector<char> ok(stale.size(), 0);
+        if (stale.size() == 1)
+            ok[0] = index_blueprint(dir, stale[0], secret, indexed[0]);
+        else if (!stale.empty())
+        {
+            const size_t workers = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+            jarvis::WorkerPool pool(std::min(workers, stale.size()));
+            for (size_t i = 0; i < stale.size(); ++i)
+                pool.submit([&, i]() { ok[i] = index_blueprint(dir, stale[i], secret, indexed[i]); });
+            pool.wait_idle();
+        }
+
+        for (size_t i = 0; i < stale.size(); ++i)
+        {
+            if (ok[i])
+            {
+                put(std::move(indexed[i]));
+                ++changed;
+            }
+            else if (remove(stale[i])) // no longer readable
+                ++changed;
+        }
+        return changed;
+    }
+
+    // ------------------------------------------------------------------------
+    // Indexing and the store pass
+    // ------------------------------------------------------------------------
+
+    bool index_blueprint(const std::string &dir, const std::string &name, const std::string &secret,
+                         BlueprintIndexEntry &out, std::string *error)
+    {
+        const std::string path = blueprint_path(dir, name);
+        out = BlueprintIndexEntry();
+        out.name = name;
+        if (!stat_file(path, out.size, out.mtime_ns))
+        {
+            if (error)
+                *error = "cannot stat " + path;
+            return false;
+        }
+
+        if (has_binary_magic(path))
+        {
+            BlueprintView view;
+            if (!view.open(path))
+            {
+                if (error)
+                    *error = view.error();
+                return false;
+            }
+            crypto::sha256(view.data(), view.size(), out.hash);
+            std::string signature = verified_blueprint_signature(view, path, secret);
+            std::vector<JournalRecord> records;
+            if (!signature.empty())
+            {
+                out.flags |= kIndexVerified;
+                records = replay_journal(path, signature, secret);
+            }
+            out.journal_size = journal_size_of(path);
+            if (records.empty())
+            {
+                set_bounds(out, view);
+                return true;
+            }
+            Sketch sketch;
+            GridConfig grid;
+            view.to_sketch(sketch, &grid);
+            for (const auto &rec : records)
+                LineJournal::apply(rec, sketch.lines, grid);
+            set_bounds(out, sketch.lines);
+            return true;
+        }
+
+        std::string text;
+        if (!read_file(path, text))
+        {
+            if (error)
+                *error = "cannot read " + path;
+            return false;
+        }
+        crypto::sha256(text.data(), text.size(), out.hash);
+        Sketch sketch;
+        GridConfig grid;
+        SignedJsonResult result = read_signed_json_blueprint(text.data(), text.size(), secret, 3, sketch, grid);
+        if (result != SignedJsonResult::OK)
+        {
+            if (error)
+                *error = std::string("JSON blueprint: ") + signed_json_result_name(result);
+            return false;
+        }
+        out.flags |= kIndexJson | kIndexVerified;
+        set_bounds(out, sketch.lines);
+        return true;
+    }
+
+    std::vector<std::string> list_blueprints(const std::string &dir)
+    {
+        std::vector<std::string> names;
+        DIR *d = opendir(dir.c_str());
+        if (!d)
+            return names;
+        while (struct dirent *ent = readdir(d))
+        {
+            const size_t len = std::strlen(ent->d_name);
+            if (len <= kSuffixLength || std::strcmp(ent->d_name + len - kSuffixLength, kSuffix) != 0)
+                continue;
+            if (ent->d_type != DT_REG && ent->d_type != DT_UNKNOWN && ent->d_type != DT_LNK)
+                continue;
+            names.emplace_back(ent->d_name, len - kSuffixLength);
+        }
+        closedir(d);
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    const char *store_status_name(StoreStatus status)
+    {
+        switch (status)
+        {
+        case StoreStatus::OK:
+            return "ok";
+        case StoreStatus::UNREADABLE:
+            return "unreadable";
+        case StoreStatus::MISSING_SIGNATURE:
+            return "missing signature";
+        case StoreStatus::BAD_SIGNATURE:
+            return "bad signature";
+        case StoreStatus::WRITE_FAILED:
+            return "write failed";
+        }
+        return "unknown";
+    }
+
+    StoreReport run_store_pass(const StoreOptions &options)
+    {
+        auto start = std::chrono::steady_clock::now();
+        StoreReport report;
+        std::vector<std::string> names = list_blueprints(options.dir);
+        report.files.resize(names.size());
+
+        {
+            // Files are independent: one task each, results in their own slot
+            jarvis::WorkerPool pool(options.threads);
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                report.files[i].name = names[i];
+                StoreFileResult *slot = &report.files[i];
+                pool.submit([&options, slot]() { process_blueprint(options, *slot); });
+            }
+            pool.wait_idle();
+        }
+
+        BlueprintIndex index;
+        for (const auto &r : report.files)
+        {
+            if (r.status != StoreStatus::OK)
+            {
+                ++report.failed;
+                continue;
+            }
+            ++report.ok;
+            report.resigned += r.resigned ? 1 : 0;
+            report.compacted += r.compacted ? 1 : 0;
+            index.put(r.entry);
+        }
+        if (options.index)
+            report.index_written = index.save(options.dir + "/" + kBlueprintIndexFile);
+
+        report.duration_us = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        return report;
+    }
+
+} // namespace sketch
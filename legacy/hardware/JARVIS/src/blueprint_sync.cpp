@@ -0,0 +1,788 @@
+#include "blueprint_sync.hpp"
+#include "async_http_client.hpp"
+#include "crypto.hpp"
+#include "logger.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+#ifdef JARVIS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using json = nlohmann::json;
+
+namespace sketch
+{
+
+    namespace
+    {
+        // Push bodies smaller than this are not worth deflating
+        const size_t kCompressMin = 1024;
+        // Passes retried when the pad or the server moved underneath one
+        const int kSyncAttempts = 3;
+
+        void put_le32(std::string &out, uint32_t v)
+        {
+            for (int i = 0; i < 4; ++i)
+                out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+        }
+
+        void put_float(std::string &out, float f)
+        {
+            if (f == 0.0f)
+                f = 0.0f; // -0 and +0 are the same point
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            put_le32(out, bits);
+        }
+
+        // Canonical bytes of what a line looks like (its id without the occurrence)
+        std::string line_content(const Line &line)
+        {
+            std::string key;
+            key.reserve(24);
+            put_float(key, line.start.x);
+            put_float(key, line.start.y);
+            put_float(key, line.end.x);
+            put_float(key, line.end.y);
+            put_le32(key, line.color);
+            put_le32(key, static_cast<uint32_t>(line.thickness));
+            return key;
+        }
+
+        std::string id_from_content(std::string content, uint32_t occurrence)
+        {
+            put_le32(content, occurrence);
+            unsigned char digest[32];
+            crypto::sha256(content.data(), content.size(), digest);
+            static const char hex[] = "0123456789abcdef";
+            std::string id(16, '0');
+            for (int i = 0; i < 8; ++i)
+            {
+                id[2 * i] = hex[digest[i] >> 4];
+                id[2 * i + 1] = hex[digest[i] & 0x0F];
+            }
+            return id;
+        }
+
+        // FNV-1a; summed over a set it gives an order-independent digest
+        uint64_t id_hash(const std::string &id)
+        {
+            uint64_t h = 1469598103934665603ULL;
+            for (unsigned char c : id)
+            {
+                h ^= c;
+                h *= 1099511628211ULL;
+            }
+            return h;
+        }
+
+        // The grid fields that travel with a blueprint
+        bool same_grid(const GridConfig &a, const GridConfig &b)
+        {
+            return a.grid_spacing_percent == b.grid_spacing_percent &&
+                   a.real_world_spacing_cm == b.real_world_spacing_cm &&
+                   a.snap_to_grid == b.snap_to_grid && a.show_measurements == b.show_measurements;
+        }
+
+        json grid_json(const GridConfig &grid)
+        {
+            return {{"grid_spacing_percent", grid.grid_spacing_percent},
+                    {"real_world_spacing_cm", grid.real_world_spacing_cm},
+                    {"snap_to_grid", grid.snap_to_grid},
+                    {"show_measurements", grid.show_measurements}};
+        }
+
+        void grid_from_json(const json &j, GridConfig &grid)
+        {
+            grid.grid_spacing_percent = j.value("grid_spacing_percent", grid.grid_spacing_percent);
+            grid.real_world_spacing_cm = j.value("real_world_spacing_cm", grid.real_world_spacing_cm);
+            grid.snap_to_grid = j.value("snap_to_grid", grid.snap_to_grid);
+            grid.show_measurements = j.value("show_measurements", grid.show_measurements);
+        }
+
+        bool is_unsupported(int status)
+        {
+            return status == 404 || status == 405 || status == 501;
+        }
+    }
+
+    std::string line_id(const Line &line, uint32_t occurrence)
+    {
+        return id_from_content(line_content(line), occurrence);
+    }
+
+    std::string encode_line_delta(const LineDelta &delta)
+    {
+        json j;
+        j["base"] = delta.base;
+        j["version"] = delta.version;
+        if (delta.full)
+            j["full"] = true;
+        if (delta.clear)
+            j["clear"] = true;
+        if (!delta.device.empty())
+            j["device"] = delta.device;
+        if (!delta.version_vector.empty())
+            j["vv"] = delta.version_vector;
+        j["remove"] = delta.removed;
+        json added = json::array();
+        for (const auto &entry : delta.added)
+        {
+            const Line &l = entry.second;
+            added.push_back({entry.first, l.start.x, l.start.y, l.end.x, l.end.y, l.color, l.thickness});
+        }
+        j["add"] = std::move(added);
+        if (delta.grid_changed)
+            j["grid"] = grid_json(delta.grid);
+        return j.dump();
+    }
+
+    bool decode_line_delta(const std::string &text, LineDelta &delta)
+    {
+        delta = LineDelta();
+        json j = json::parse(text, nullptr, false);
+        if (j.is_discarded() || !j.is_object() || !j.contains("version"))
+            return false;
+        try
+        {
+            delta.base = j.value("base", uint64_t(0));
+            delta.version = j.value("version", uint64_t(0));
+            delta.full = j.value("full", false);
+            delta.clear = j.value("clear", false) || delta.full;
+            delta.device = j.value("device", std::string());
+            if (j.contains("vv") && j["vv"].is_object())
+                delta.version_vector = j["vv"].get<std::map<std::string, uint64_t>>();
+            if (j.contains("remove"))
+                delta.removed = j["remove"].get<std::vector<std::string>>();
+            if (j.contains("add"))
+            {
+                const json &added = j["add"];
+                if (!added.is_array())
+                    return false;
+                delta.added.reserve(added.size());
+                for (const auto &a : added)
+                {
+                    if (!a.is_array() || a.size() < 7 || !a[0].is_string())
+                        return false;
+                    Line line;
+                    line.start = Point(a[1].get<float>(), a[2].get<float>());
+                    line.end = Point(a[3].get<float>(), a[4].get<float>());
+                    line.color = a[5].get<uint32_t>();
+                    line.thickness = a[6].get<int>();
+                    delta.added.emplace_back(a[0].get<std::string>(), line);
+                }
+            }
+            if (j.contains("grid") && j["grid"].is_object())
+            {
+                delta.grid_changed = true;
+                grid_from_json(j["grid"], delta.grid);
+            }
+        }
+        catch (const json::exception &)
+        {
+            return false;
+        }
+        return true;
+    }
+
+    bool deflate_body(const std::string &in, std::string &out)
+    {
+#ifdef JARVIS_HAVE_ZLIB
+        uLongf size = compressBound(static_cast<uLong>(in.size()));
+        out.resize(size);
+        if (compress2(reinterpret_cast<Bytef *>(&out[0]), &size, reinterpret_cast<const Bytef *>(in.data()),
+                      static_cast<uLong>(in.size()), Z_BEST_SPEED) != Z_OK)
+            return false;
+        out.resize(size);
+        return true;
+#else
+        (void)in;
+        (void)out;
+        return false;
+#endif
+    }
+
+    bool inflate_body(const std::string &in, std::string &out)
+    {
+#ifdef JARVIS_HAVE_ZLIB
+        z_stream zs{};
+        if (inflateInit(&zs) != Z_OK)
+            return false;
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+        zs.avail_in = static_cast<uInt>(in.size());
+        out.clear();
+        char buffer[16384];
+        int rc = Z_OK;
+        while (rc == Z_OK)
+        {
+            zs.next_out = reinterpret_cast<Bytef *>(buffer);
+            zs.avail_out = sizeof(buffer);
+            rc = inflate(&zs, Z_NO_FLUSH);
+            if (rc != Z_OK && rc != Z_STREAM_END)
+                break;
+            out.append(buffer, sizeof(buffer) - zs.avail_out);
+            if (rc == Z_OK && zs.avail_in == 0 && zs.avail_out != 0)
+                break; // truncated
+        }
+        inflateEnd(&zs);
+        return rc == Z_STREAM_END;
+#else
+        (void)in;
+        (void)out;
+        return false;
+#endif
+    }
+
+    const char *sync_result_name(SyncResult result)
+    {
+        switch (result)
+        {
+        case SyncResult::UP_TO_DATE:
+            return "up to date";
+        case SyncResult::SYNCED:
+            return "synced";
+        case SyncResult::CONFLICT:
+            return "conflict";
+        case SyncResult::UNSUPPORTED:
+            return "unsupported";
+        case SyncResult::FAILED:
+            return "failed";
+        }
+        return "unknown";
+    }
+
+    BlueprintSync::BlueprintSync(AsyncHttpClient &http, std::string device_id, SyncEndpoint endpoint,
+                                 std::string state_path)
+        : http_(http), device_(std::move(device_id)), endpoint_(std::move(endpoint)),
+          state_path_(std::move(state_path))
+    {
+    }
+
+    uint64_t BlueprintSync::server_version() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return server_version_;
+    }
+
+    std::map<std::string, uint64_t> BlueprintSync::version_vector() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return version_vector_;
+    }
+
+    SyncStats BlueprintSync::stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    std::string BlueprintSync::last_error() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_error_;
+    }
+
+    void BlueprintSync::base_insert(const std::string &id)
+    {
+        if (base_.insert(id).second)
+            base_sum_ += id_hash(id);
+    }
+
+    void BlueprintSync::base_erase(const std::string &id)
+    {
+        if (base_.erase(id))
+            base_sum_ -= id_hash(id);
+    }
+
+    void BlueprintSync::base_clear()
+    {
+        base_.clear();
+        base_sum_ = 0;
+    }
+
+    void BlueprintSync::merge_version_vector(const std::map<std::string, uint64_t> &other)
+    {
+        for (const auto &entry : other)
+        {
+            uint64_t &mine = version_vector_[entry.first];
+            mine = std::max(mine, entry.second);
+        }
+    }
+
+    void BlueprintSync::append_local(const Line &line, const std::string &id)
+    {
+        positions_[id] = ids_.size();
+        ids_.push_back(id);
+        ++occurrences_[line_content(line)];
+    }
+
+    void BlueprintSync::forget_pending_add(const std::string &id)
+    {
+        auto &added = pending_.added;
+        auto it = std::find_if(added.begin(), added.end(),
+                               [&](const std::pair<std::string, Line> &entry) { return entry.first == id; });
+        if (it != added.end())
+            added.erase(it);
+    }
+
+    void BlueprintSync::rebuild_local(const SaveSnapshot &snapshot)
+    {
+        ids_.clear();
+        positions_.clear();
+        occurrences_.clear();
+        pending_ = Pending();
+        ids_.reserve(snapshot.sketch.lines.size());
+        for (const Line &line : snapshot.sketch.lines)
+        {
+            std::string content = line_content(line);
+            std::string id = id_from_content(content, occurrences_[content]);
+            append_local(line, id);
+            if (!base_.count(id))
+                pending_.added.emplace_back(id, line);
+        }
+        stats_.lines_hashed += snapshot.sketch.lines.size();
+        for (const std::string &id : base_)
+        {
+            if (!positions_.count(id))
+                pending_.removed.insert(id);
+        }
+        clear_epoch_ = snapshot.clear_epoch;
+        content_generation_ = snapshot.content_generation;
+        local_grid_ = snapshot.grid;
+    }
+
+    void BlueprintSync::prime(const SaveSnapshot &snapshot)
+    {
+        primed_ = true;
+        uint64_t version = 0;
+        size_t lines = 0;
+        uint64_t digest = 0;
+        GridConfig grid;
+        bool have_state = load_state(version, lines, digest, grid);
+        base_clear();
+        rebuild_local(snapshot);
+
+        uint64_t local_sum = 0;
+        for (const std::string &id : ids_)
+            local_sum += id_hash(id);
+        if (have_state && lines == ids_.size() && digest == local_sum)
+        {
+            // The local copy is what the server had at `version`
+            for (const std::string &id : ids_)
+                base_insert(id);
+            pending_ = Pending();
+            base_grid_ = grid;
+            server_version_ = version;
+        }
+        else
+        {
+            // Unknown base: the first pull brings a full snapshot and the
+            // local lines are offered on top of it
+            if (have_state)
+                JLOG_INFO("Sync") << "Local copy of '" << snapshot.sketch.name
+                                  << "' changed since the last sync; reconciling with the server";
+            base_grid_ = GridConfig();
+            server_version_ = 0;
+        }
+    }
+
+    void BlueprintSync::track_local(const SaveSnapshot &snapshot)
+    {
+        if (!primed_)
+        {
+            prime(snapshot);
+            return;
+        }
+        const std::vector<Line> &lines = snapshot.sketch.lines;
+        // Taken before a pass this object already saw; nothing new in it
+        if (snapshot.content_generation < content_generation_ || snapshot.clear_epoch < clear_epoch_ ||
+            (snapshot.content_generation == content_generation_ && snapshot.clear_epoch == clear_epoch_ &&
+             lines.size() < ids_.size()))
+            return;
+
+        local_grid_ = snapshot.grid;
+        if (snapshot.content_generation != content_generation_)
+        {
+            // Loaded or replaced: compare everything once
+            rebuild_local(snapshot);
+            return;
+        }
+        if (snapshot.clear_epoch != clear_epoch_)
+        {
+            // Everything in the pad was drawn after the clear
+            ids_.clear();
+            positions_.clear();
+            occurrences_.clear();
+            pending_ = Pending();
+            pending_.clear = true;
+            clear_epoch_ = snapshot.clear_epoch;
+        }
+        for (size_t i = ids_.size(); i < lines.size(); ++i)
+        {
+            std::string content = line_content(lines[i]);
+            std::string id = id_from_content(content, occurrences_[content]);
+            ++stats_.lines_hashed;
+            append_local(lines[i], id);
+            // Redrawing a line removed since the base cancels the removal
+            if (pending_.removed.erase(id))
+                continue;
+            if (pending_.clear || !base_.count(id))
+                pending_.added.emplace_back(id, lines[i]);
+        }
+    }
+
+    SyncResult BlueprintSync::pull_and_merge(SketchPad &pad, const SaveSnapshot &snapshot, bool &changed,
+                                             bool &refused)
+    {
+        changed = false;
+        refused = false;
+        HttpRequest request;
+        request.host = endpoint_.host;
+        request.port = endpoint_.port;
+        request.use_tls = endpoint_.use_tls;
+        request.timeout_ms = endpoint_.timeout_ms;
+        request.path = endpoint_.pull_path + (endpoint_.pull_path.find('?') == std::string::npos ? "?" : "&") +
+                       "since=" + std::to_string(server_version_);
+        if (endpoint_.compress)
+            request.headers.emplace_back("Accept-Encoding", "deflate");
+        HttpResponse response = http_.send(std::move(request)).get();
+        ++stats_.pulls;
+        if (!response.ok)
+        {
+            last_error_ = response.error;
+            return is_unsupported(response.status) ? SyncResult::UNSUPPORTED : SyncResult::FAILED;
+        }
+        stats_.bytes_received += response.body.size();
+        std::string body;
+        if (response.header("content-encoding") == "deflate")
+        {
+            if (!inflate_body(response.body, body))
+            {
+                last_error_ = "pull: cannot inflate response";
+                return SyncResult::FAILED;
+            }
+        }
+        else
+        {
+            body = std::move(response.body);
+        }
+        LineDelta remote;
+        if (!decode_line_delta(body, remote))
+        {
+            // A 200 that is not a delta: the path serves something else
+            last_error_ = "pull: answer is not a line delta";
+            return SyncResult::UNSUPPORTED;
+        }
+        stats_.lines_received += remote.added.size();
+
+        // Plan against the snapshot; nothing is committed until the pad takes it
+        std::vector<size_t> remove;
+        std::vector<std::pair<std::string, Line>> add;
+        std::unordered_set<std::string> kept_removals;
+        if (remote.clear)
+        {
+            for (const std::string &id : base_)
+            {
+                auto pos = positions_.find(id);
+                if (pos != positions_.end())
+                    remove.push_back(pos->second);
+            }
+            // Local removals stay wanted only for lines the server still has
+            for (const auto &entry : remote.added)
+                if (pending_.removed.count(entry.first))
+                    kept_removals.insert(entry.first);
+        }
+        else
+        {
+            for (const std::string &id : remote.removed)
+            {
+                auto pos = positions_.find(id);
+                if (base_.count(id) && pos != positions_.end())
+                    remove.push_back(pos->second);
+            }
+            kept_removals = pending_.removed;
+            for (const std::string &id : remote.removed)
+                kept_removals.erase(id);
+        }
+        for (const auto &entry : remote.added)
+        {
+            if (positions_.count(entry.first) || kept_removals.count(entry.first))
+                continue;
+            add.push_back(entry);
+        }
+        std::sort(remove.begin(), remove.end());
+        remove.erase(std::unique(remove.begin(), remove.end()), remove.end());
+        bool take_grid = remote.grid_changed && same_grid(local_grid_, base_grid_) &&
+                         !same_grid(local_grid_, remote.grid);
+
+        if (!remove.empty() || !add.empty() || take_grid)
+        {
+            std::vector<Line> add_lines;
+            add_lines.reserve(add.size());
+            for (const auto &entry : add)
+                add_lines.push_back(entry.second);
+            uint64_t generation = content_generation_;
+            if (!pad.apply_remote_changes(snapshot, remove, add_lines, take_grid ? &remote.grid : nullptr,
+                                          &generation))
+            {
+                refused = true;
+                return SyncResult::FAILED;
+            }
+            changed = true;
+            ++stats_.merges;
+
+            // Mirror the pad: drop removed ids, add the new ones where the seen lines end
+            if (!remove.empty())
+            {
+                size_t next = 0, out = 0;
+                for (size_t i = 0; i < ids_.size(); ++i)
+                {
+                    if (next < remove.size() && remove[next] == i)
+                    {
+                        ++next;
+                        auto occ = occurrences_.find(line_content(snapshot.sketch.lines[i]));
+                        if (occ != occurrences_.end() && occ->second > 0)
+                            --occ->second;
+                        continue;
+                    }
+                    ids_[out++] = std::move(ids_[i]);
+                }
+                ids_.resize(out);
+                positions_.clear();
+                for (size_t i = 0; i < ids_.size(); ++i)
+                    positions_[ids_[i]] = i;
+            }
+            for (const auto &entry : add)
+                append_local(entry.second, entry.first);
+            content_generation_ = generation;
+            if (take_grid)
+                local_grid_ = remote.grid;
+        }
+
+        // Advance the base to the server's version
+        if (remote.clear)
+            base_clear();
+        for (const std::string &id : remote.removed)
+            base_erase(id);
+        for (const auto &entry : remote.added)
+        {
+            base_insert(entry.first);
+            // Drawn here and there alike: nothing left to send
+            forget_pending_add(entry.first);
+            // A local clear still to be pushed would drop this one too
+            if (pending_.clear && positions_.count(entry.first))
+                pending_.added.push_back(entry);
+        }
+        pending_.removed = std::move(kept_removals);
+        if (remote.grid_changed)
+            base_grid_ = remote.grid;
+        bool advanced = remote.version != server_version_;
+        server_version_ = remote.version;
+        merge_version_vector(remote.version_vector);
+        if (advanced || changed)
+            save_state();
+        return changed ? SyncResult::SYNCED : SyncResult::UP_TO_DATE;
+    }
+
+    BlueprintSync::PushOutcome BlueprintSync::push_pending()
+    {
+        bool grid_changed = !same_grid(local_grid_, base_grid_);
+        if (!pending_.clear && pending_.added.empty() && pending_.removed.empty() && !grid_changed)
+            return PushOutcome::NOTHING;
+
+        LineDelta delta;
+        delta.base = server_version_;
+        delta.clear = pending_.clear;
+        delta.device = device_;
+        delta.version_vector = version_vector_;
+        delta.removed.assign(pending_.removed.begin(), pending_.removed.end());
+        delta.added = pending_.added;
+        delta.grid_changed = grid_changed;
+        delta.grid = local_grid_;
+
+        HttpRequest request;
+        request.method = "POST";
+        request.host = endpoint_.host;
+        request.port = endpoint_.port;
+        request.use_tls = endpoint_.use_tls;
+        request.timeout_ms = endpoint_.timeout_ms;
+        request.path = endpoint_.push_path;
+        request.body = encode_line_delta(delta);
+        // The same change against the same base: a replayed push is harmless
+        request.headers.emplace_back("X-Idempotency-Key",
+                                     device_ + "_" + std::to_string(server_version_) + "_" +
+                                         std::to_string(version_vector_[device_] + 1));
+        std::string packed;
+        if (endpoint_.compress && request.body.size() >= kCompressMin && deflate_body(request.body, packed) &&
+            packed.size() < request.body.size())
+        {
+            request.body.swap(packed);
+            request.headers.emplace_back("Content-Encoding", "deflate");
+        }
+        stats_.bytes_sent += request.body.size();
+        ++stats_.pushes;
+        HttpResponse response = http_.send(std::move(request)).get();
+        if (response.status == 409)
+        {
+            ++stats_.conflicts;
+            last_error_ = "push: server has newer changes";
+            return PushOutcome::CONFLICT;
+        }
+        if (!response.ok)
+        {
+            last_error_ = response.error;
+            return is_unsupported(response.status) ? PushOutcome::UNSUPPORTED : PushOutcome::FAILED;
+        }
+        stats_.bytes_received += response.body.size();
+        LineDelta answer;
+        if (!decode_line_delta(response.body, answer) || answer.version <= server_version_)
+        {
+            last_error_ = "push: invalid answer";
+            return PushOutcome::FAILED;
+        }
+        stats_.lines_sent += delta.added.size();
+
+        if (delta.clear)
+            base_clear();
+        for (const std::string &id : delta.removed)
+            base_erase(id);
+        for (const auto &entry : delta.added)
+            base_insert(entry.first);
+        base_grid_ = local_grid_;
+        server_version_ = answer.version;
+        ++version_vector_[device_];
+        merge_version_vector(answer.version_vector);
+        pending_ = Pending();
+        save_state();
+        return PushOutcome::ACCEPTED;
+    }
+
+    SyncResult BlueprintSync::sync(SketchPad &pad)
+    {
+        return sync(pad, pad.snapshot_content());
+    }
+
+    SyncResult BlueprintSync::sync(SketchPad &pad, const SaveSnapshot &snapshot)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        SaveSnapshot fresh;
+        const SaveSnapshot *current = &snapshot;
+        bool merged = false;
+        for (int attempt = 0; attempt < kSyncAttempts; ++attempt)
+        {
+            if (attempt > 0)
+            {
+                fresh = pad.snapshot_content();
+                current = &fresh;
+            }
+            track_local(*current);
+            bool changed = false, refused = false;
+            SyncResult pulled = pull_and_merge(pad, *current, changed, refused);
+            merged = merged || changed;
+            if (refused)
+                continue; // cleared or reloaded meanwhile; look again
+            if (pulled == SyncResult::UNSUPPORTED || pulled == SyncResult::FAILED)
+                return pulled;
+
+            switch (push_pending())
+            {
+            case PushOutcome::NOTHING:
+                return merged ? SyncResult::SYNCED : SyncResult::UP_TO_DATE;
+            case PushOutcome::ACCEPTED:
+                return SyncResult::SYNCED;
+            case PushOutcome::CONFLICT:
+                continue; // someone pushed in between; pull again
+            case PushOutcome::UNSUPPORTED:
+                return SyncResult::UNSUPPORTED;
+            case PushOutcome::FAILED:
+                return SyncResult::FAILED;
+            }
+        }
+        last_error_ = "blueprint kept changing during sync";
+        return SyncResult::FAILED;
+    }
+
+    SyncResult BlueprintSync::push(const SaveSnapshot &snapshot)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        track_local(snapshot);
+        switch (push_pending())
+        {
+        case PushOutcome::NOTHING:
+            return SyncResult::UP_TO_DATE;
+        case PushOutcome::ACCEPTED:
+            return SyncResult::SYNCED;
+        case PushOutcome::CONFLICT:
+            return SyncResult::CONFLICT;
+        case PushOutcome::UNSUPPORTED:
+            return SyncResult::UNSUPPORTED;
+        case PushOutcome::FAILED:
+            break;
+        }
+        return SyncResult::FAILED;
+    }
+
+    void BlueprintSync::save_state() const
+    {
+        if (state_path_.empty())
+            return;
+        char digest[17];
+        std::snprintf(digest, sizeof(digest), "%016llx", static_cast<unsigned long long>(base_sum_));
+        json j;
+        j["device"] = device_;
+        j["version"] = server_version_;
+        j["lines"] = base_.size();
+        j["digest"] = digest;
+        j["grid"] = grid_json(base_grid_);
+        j["vv"] = version_vector_;
+        std::string tmp = state_path_ + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out)
+            {
+                JLOG_WARN("Sync") << "Cannot write sync state: " << tmp;
+                return;
+            }
+            out << j.dump() << "\n";
+            if (!out)
+                return;
+        }
+        if (std::rename(tmp.c_str(), state_path_.c_str()) != 0)
+            ::unlink(tmp.c_str());
+    }
+
+    bool BlueprintSync::load_state(uint64_t &version, size_t &lines, uint64_t &digest, GridConfig &grid)
+    {
+        if (state_path_.empty())
+            return false;
+        std::ifstream in(state_path_, std::ios::binary);
+        if (!in)
+            return false;
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        json j = json::parse(text, nullptr, false);
+        if (j.is_discarded() || !j.is_object())
+            return false;
+        try
+        {
+            version = j.at("version").get<uint64_t>();
+            lines = j.at("lines").get<size_t>();
+            digest = std::stoull(j.at("digest").get<std::string>(), nullptr, 16);
+            if (j.contains("grid"))
+                grid_from_json(j["grid"], grid);
+            if (j.contains("vv") && j["vv"].is_object())
+                version_vector_ = j["vv"].get<std::map<std::string, uint64_t>>();
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+        return true;
+    }
+
+} // namespace sketch
@@ -1,4 +1,6 @@
 #include "camera.hpp"
+#include "frame_recording.hpp"
+#include "frame_ring.hpp"
 #include <iostream>
 #include <cstring>
 #include <cmath>
@@ -6,6 +8,7 @@
 #include <chrono>
 #include <thread>
 #include <cstdio>
+#include <cstdlib>
 #include <unistd.h>
 #include <fcntl.h>
 
@@ -16,6 +19,13 @@
 //  - Optional override via env var JARVIS_CAMERA_CMD
 //  - Graceful recovery if child process dies (re-spawn once)
 //  - Converts YUV420 -> RGB888 for downstream processing
+//  - Optionally exports raw frames to a shared-memory ring (frame_ring.hpp):
+//    the pipe is read straight into the ring slot, so observers cost nothing
+//  - Optionally records raw frames and IMX500 metadata (frame_recording.hpp)
+//    for headless replay through ReplaySource
+//  - Optionally delivers a low-res detection stream (Frame::lores) sampled
+//    straight from the YUV planes; rpicam-vid pipes only the main stream,
+//    so the ISP's lores output is not reachable from here
 // Limitations:
 //  - Relies on rpicam-vid being installed
 //  - Blocking read per frame; for higher FPS consider double buffering + thread
@@ -26,17 +36,18 @@ namespace camera
     // Frame methods
     bool Frame::get_rgb(uint32_t x, uint32_t y, uint8_t &r, uint8_t &g, uint8_t &b) const
     {
-        if (data.empty() || x >= width || y >= height)
+        if (!has_pixels() || x >= width || y >= height)
             return false;
+        const uint8_t *px = pixels();
 
         if (format == PixelFormat::RGB888)
         {
             size_t idx = (y * stride) + (x * 3);
             if (idx + 2 < size)
             {
-                r = data[idx];
-                g = data[idx + 1];
-                b = data[idx + 2];
+                r = px[idx];
+                g = px[idx + 1];
+                b = px[idx + 2];
                 return true;
             }
         }
@@ -45,9 +56,9 @@ namespace camera
             size_t idx = (y * stride) + (x * 4);
             if (idx + 3 < size)
             {
-                r = data[idx];
-                g = data[idx + 1];
-                b = data[idx + 2];
+                r = px[idx];
+                g = px[idx + 1];
+                b = px[idx + 2];
                 return true;
             }
         }
@@ -57,8 +68,9 @@ namespace camera
 
     bool Frame::get_rgb_from_yuv(uint32_t x, uint32_t y, uint8_t &r, uint8_t &g, uint8_t &b) const
     {
-        if (data.empty() || x >= width || y >= height || format != PixelFormat::YUV420)
+        if (!has_pixels() || x >= width || y >= height || format != PixelFormat::YUV420)
             return false;
+        const uint8_t *data = pixels();
 
         // YUV420 layout: Y plane, then U plane (width/2 * height/2), then V plane
         size_t y_idx = y * width + x;
@@ -98,6 +110,19 @@ namespace camera
             expected_yuv_size_ = config_.width * config_.height * 3 / 2; // YUV420
             // Pre-allocate RGB buffer
             frame_buffer_.resize(config_.width * config_.height * 3);
+            open_frame_ring();
+            open_recorder();
+            if (config_.has_lores())
+            {
+                Frame probe;
+                std::vector<uint8_t> blank(expected_yuv_size_);
+                if (make_lores_frame(config_, blank.data(), PixelFormat::YUV420, config_.width, config_.height, probe))
+                    std::cerr << "[Camera] Detection stream: " << config_.lores_width << "x" << config_.lores_height
+                              << std::endl;
+                else
+                    std::cerr << "[Camera][WARN] Detection stream " << config_.lores_width << "x"
+                              << config_.lores_height << " unsupported; detectors will downscale" << std::endl;
+            }
             initialized_ = true;
             if (config_.verbose)
                 std::cerr << "[Camera] Initialized: " << config_.width << "x" << config_.height << "@" << config_.framerate << "fps" << std::endl;
@@ -114,8 +139,13 @@ namespace camera
             if (running_)
                 return true;
 
-            std::string cmd = "rpicam-vid -t 0 -n --codec yuv420 --width 640 --height 480 --framerate 30 -o -";
-            std::cerr << "[Camera][INFO] Using forced command: " << cmd << std::endl;
+            // Size and rate come from the config so the pipe matches expected_yuv_size_;
+            // --camera selects the sensor when several are attached (multi-surface)
+            std::string cmd = "rpicam-vid -t 0 -n --codec yuv420 --camera " + std::to_string(config_.camera_index) +
+                              " --width " + std::to_string(config_.width) +
+                              " --height " + std::to_string(config_.height) +
+                              " --framerate " + std::to_string(config_.framerate) + " -o -";
+            std::cerr << "[Camera][INFO] Using command: " << cmd << std::endl;
             pipe_ = popen(cmd.c_str(), "r");
             if (!pipe_)
             {
@@ -125,6 +155,11 @@ namespace camera
             }
             running_ = true;
             frame_count_ = 0;
+            // Sequence numbers keep counting across restarts so the ring and
+            // recorder never see them go backwards; the stopped time is not
+            // counted as missed frames
+            last_timestamp_ns_ = 0;
+            missed_ = 0;
             if (config_.verbose)
                 std::cerr << "[Camera] Capture started (cmd: " << cmd << ")" << std::endl;
             return true;
@@ -159,14 +194,24 @@ namespace camera
                 running_ = false;
                 return nullptr;
             }
-            // Read one YUV420 frame
-            yuv_temp_.resize(expected_yuv_size_);
+            // Read one YUV420 frame, straight into the export ring when there is one
+            uint8_t *yuv = ring_.is_open() ? ring_.begin_frame() : nullptr;
+            if (!yuv)
+            {
+                yuv_temp_.resize(expected_yuv_size_);
+                yuv = yuv_temp_.data();
+            }
             size_t read_total = 0;
             const int max_retries = 4;
             int retries = 0;
+            uint64_t timestamp_ns = 0;
             while (read_total < expected_yuv_size_)
             {
-                size_t n = fread(yuv_temp_.data() + read_total, 1, expected_yuv_size_ - read_total, pipe_);
+                // The first byte is read on its own so the frame is stamped
+                // when it starts arriving, not after the whole read. That is
+                // still read time: a frame waiting in the pipe is stamped late.
+                const size_t want = read_total == 0 ? 1 : expected_yuv_size_ - read_total;
+                size_t n = fread(yuv + read_total, 1, want, pipe_);
                 if (n == 0)
                 {
                     int err = errno;
@@ -195,6 +240,8 @@ namespace camera
                     std::this_thread::sleep_for(std::chrono::milliseconds(2));
                     continue;
                 }
+                if (read_total == 0)
+                    timestamp_ns = monotonic_ns();
                 read_total += n;
             }
             if (read_total != expected_yuv_size_)
@@ -205,10 +252,15 @@ namespace camera
                 return nullptr;
             }
 
+            const uint64_t sequence = next_sequence(timestamp_ns);
+            if (ring_.is_open())
+                ring_.commit_frame(sequence, timestamp_ns, config_.width, config_.height,
+                                   PixelFormat::YUV420, config_.width, static_cast<uint32_t>(expected_yuv_size_));
+
             // --- Robust YUV420 → RGB validation and debug logging ---
             size_t expected_rgb_size = config_.width * config_.height * 3;
             buffer.resize(expected_rgb_size);
-            if (!yuv_temp_.data() || !buffer.data())
+            if (!yuv || !buffer.data())
             {
                 last_error_ = "[Camera][ERROR] Null buffer pointer for YUV or RGB";
                 std::cerr << last_error_ << std::endl;
@@ -216,7 +268,7 @@ namespace camera
                 return nullptr;
             }
 
-            utils::yuv420_to_rgb888(yuv_temp_.data(), buffer.data(), config_.width, config_.height);
+            utils::yuv420_to_rgb888(yuv, buffer.data(), config_.width, config_.height);
 
             // Simple post-conversion check: ensure RGB buffer is not all zero
             bool rgb_valid = false;
@@ -236,15 +288,27 @@ namespace camera
                 return nullptr;
             }
 
-            auto now = std::chrono::steady_clock::now();
-            frame.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
-            frame.data = buffer;
-            frame.size = buffer.size();
+            frame.timestamp_ns = timestamp_ns;
+            frame.sequence = sequence;
+            // Hand the converted pixels over; the old frame's storage is reused next time
+            frame.data.swap(buffer);
+            frame.size = frame.data.size();
             frame.width = config_.width;
             frame.height = config_.height;
             frame.format = PixelFormat::RGB888;
             frame.stride = config_.width * 3;
 
+            // Detection stream, sampled from the YUV planes rather than the RGB
+            frame.lores = make_lores_frame(config_, yuv, PixelFormat::YUV420, config_.width, config_.height,
+                                           lores_frame_)
+                              ? &lores_frame_
+                              : nullptr;
+            if (frame.lores)
+            {
+                lores_frame_.timestamp_ns = timestamp_ns;
+                lores_frame_.sequence = sequence;
+            }
+
             // Parse IMX500 metadata if enabled
             frame.has_imx500_metadata = false;
             frame.imx500_detections.clear();
@@ -255,6 +319,14 @@ namespace camera
                 // rpicam-apps outputs one JSON line per frame with pose data
                 parse_imx500_metadata(frame);
             }
+            // Record the YUV420 as read so replay converts it the same way
+            if (recorder_.is_open() &&
+                !recorder_.write(sequence, frame, yuv, static_cast<uint32_t>(expected_yuv_size_),
+                                 PixelFormat::YUV420, config_.width))
+            {
+                std::cerr << "[Camera][WARN] Recording stopped: " << recorder_.error() << std::endl;
+                recorder_.close();
+            }
             frame_count_++;
             return &frame;
         }
@@ -262,18 +334,95 @@ namespace camera
         bool is_initialized() const { return initialized_; }
         bool is_running() const { return running_; }
         const std::string &get_error() const { return last_error_; }
+        uint64_t missed_frames() const { return missed_; }
 
     private:
         CameraConfig config_{};
         bool initialized_{};
         bool running_{};
         uint64_t frame_count_{};
+        uint64_t sequence_{};          // last frame's sequence number
+        bool have_sequence_{};         // sequence_ is valid (a frame was captured)
+        uint64_t last_timestamp_ns_{}; // 0 before the first frame since start()
+        uint64_t missed_{};
         std::string last_error_{};
         std::vector<uint8_t> frame_buffer_{}; // RGB buffer reused
         std::vector<uint8_t> yuv_temp_{};     // YUV read buffer
         FILE *pipe_{};
         size_t expected_yuv_size_{};
         bool imx500_enabled_{false};
+        FrameRingWriter ring_{};
+        FrameRecorder recorder_{};
+        Frame lores_frame_{}; // detection stream, reused
+
+        // Raw frame export, from the config or JARVIS_FRAME_RING ("1" for
+        // /jarvis_frames, or a name; camera N > 0 appends _N). Failing to
+        // create the ring only loses the export, never capture.
+        void open_frame_ring()
+        {
+            FrameRingConfig ring;
+            if (!config_.frame_ring.empty())
+                ring.name = config_.frame_ring;
+            else
+            {
+                const char *env = std::getenv("JARVIS_FRAME_RING");
+                if (!env || !*env || std::strcmp(env, "0") == 0)
+                    return;
+                if (std::strcmp(env, "1") != 0)
+                    ring.name = env[0] == '/' ? env : std::string("/") + env;
+                if (config_.camera_index > 0)
+                    ring.name += "_" + std::to_string(config_.camera_index);
+            }
+            ring.slots = config_.frame_ring_slots;
+            ring.frame_capacity = static_cast<uint32_t>(expected_yuv_size_);
+            if (ring_.open(ring))
+                std::cerr << "[Camera] Exporting frames to /dev/shm" << ring.name << std::endl;
+            else
+                std::cerr << "[Camera][WARN] Frame export disabled: " << ring_.error() << std::endl;
+        }
+
+        static uint64_t monotonic_ns()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        // rpicam-vid's pipe carries no sequence numbers or sensor
+        // timestamps, so timestamps are read times and each whole frame
+        // period missing between arrivals counts as a missed frame. A slow
+        // reader and a sensor drop look the same here.
+        uint64_t next_sequence(uint64_t timestamp_ns)
+        {
+            if (last_timestamp_ns_ == 0)
+            {
+                sequence_ = have_sequence_ ? sequence_ + 1 : 0;
+                have_sequence_ = true;
+            }
+            else
+            {
+                const uint64_t period_ns = 1000000000ULL / std::max(1u, config_.framerate);
+                const uint64_t gap = timestamp_ns > last_timestamp_ns_ ? timestamp_ns - last_timestamp_ns_ : 0;
+                const uint64_t missed = gap > period_ns * 3 / 2 ? (gap + period_ns / 2) / period_ns - 1 : 0;
+                missed_ += missed;
+                sequence_ += 1 + missed;
+            }
+            last_timestamp_ns_ = timestamp_ns;
+            return sequence_;
+        }
+
+        // Raw frame recording, from the config or JARVIS_RECORD. Like the
+        // ring, a recording that cannot be written never stops capture.
+        void open_recorder()
+        {
+            const std::string path = recording_path(config_);
+            if (path.empty())
+                return;
+            if (recorder_.open(path))
+                std::cerr << "[Camera] Recording frames to " << path << std::endl;
+            else
+                std::cerr << "[Camera][WARN] Recording disabled: " << recorder_.error() << std::endl;
+        }
 
         // Parse IMX500 PoseNet JSON metadata from pipe
         void parse_imx500_metadata(Frame &frame)
@@ -487,6 +636,11 @@ namespace camera
         return impl_->capture_frame(frame_buffer_, current_frame_);
     }
 
+    uint64_t Camera::get_missed_frames() const
+    {
+        return impl_->missed_frames();
+    }
+
     int Camera::list_cameras()
     {
         // Use rpicam-hello --list-cameras or libcamera-hello --list-cameras
@@ -496,10 +650,59 @@ namespace camera
         return (ret == 0) ? 1 : 0;
     }
 
+    bool make_lores_frame(const CameraConfig &config, const uint8_t *pixels, PixelFormat format,
+                          uint32_t width, uint32_t height, Frame &lores)
+    {
+        const uint32_t w = config.lores_width;
+        const uint32_t h = config.lores_height;
+        if (!config.has_lores() || !pixels || w > width || h > height)
+            return false;
+        if (config.lores_format == PixelFormat::YUV420)
+        {
+            if (format != PixelFormat::YUV420 || (w | h) & 1)
+                return false;
+            lores.data.resize(static_cast<size_t>(w) * h * 3 / 2);
+            utils::yuv420_resize_nearest(pixels, lores.data.data(), width, height, w, h);
+            lores.stride = static_cast<int>(w);
+        }
+        else if (config.lores_format == PixelFormat::RGB888 &&
+                 (format == PixelFormat::YUV420 || format == PixelFormat::RGB888))
+        {
+            lores.data.resize(static_cast<size_t>(w) * h * 3);
+            if (format == PixelFormat::YUV420)
+                utils::yuv420_to_rgb888_resized(pixels, lores.data.data(), width, height, w, h);
+            else
+                utils::resize_nearest(pixels, lores.data.data(), width, height, w, h, 3);
+            lores.stride = static_cast<int>(w * 3);
+        }
+        else
+        {
+            return false;
+        }
+        lores.external = nullptr;
+        lores.lores = nullptr;
+        lores.size = lores.data.size();
+        lores.width = w;
+        lores.height = h;
+        lores.format = config.lores_format;
+        return true;
+    }
+
     // Utility functions
     namespace utils
     {
 
+        static inline void yuv_to_rgb(int Y, int U, int V, uint8_t *rgb)
+        {
+            int R = Y + (1.402 * V);
+            int G = Y - (0.344136 * U) - (0.714136 * V);
+            int B = Y + (1.772 * U);
+
+            rgb[0] = static_cast<uint8_t>(std::clamp(R, 0, 255));
+            rgb[1] = static_cast<uint8_t>(std::clamp(G, 0, 255));
+            rgb[2] = static_cast<uint8_t>(std::clamp(B, 0, 255));
+        }
+
         void yuv420_to_rgb888(const uint8_t *yuv, uint8_t *rgb,
                               uint32_t width, uint32_t height)
         {
@@ -517,29 +720,62 @@ namespace camera
                     size_t y_idx = y * width + x;
                     size_t uv_idx = (y / 2) * (width / 2) + (x / 2);
 
-                    int Y = y_plane[y_idx];
-                    int U = u_plane[uv_idx] - 128;
-                    int V = v_plane[uv_idx] - 128;
+                    yuv_to_rgb(y_plane[y_idx], u_plane[uv_idx] - 128, v_plane[uv_idx] - 128, rgb + y_idx * 3);
+                }
+            }
+        }
+
+        void yuv420_to_rgb888_resized(const uint8_t *yuv, uint8_t *rgb,
+                                      uint32_t src_w, uint32_t src_h,
+                                      uint32_t dst_w, uint32_t dst_h)
+        {
+            const size_t y_size = static_cast<size_t>(src_w) * src_h;
+            const size_t uv_size = (src_w / 2) * (src_h / 2);
+            const uint8_t *y_plane = yuv;
+            const uint8_t *u_plane = yuv + y_size;
+            const uint8_t *v_plane = yuv + y_size + uv_size;
 
-                    int R = Y + (1.402 * V);
-                    int G = Y - (0.344136 * U) - (0.714136 * V);
-                    int B = Y + (1.772 * U);
+            // Same sample positions as resize_nearest
+            float x_ratio = static_cast<float>(src_w) / dst_w;
+            float y_ratio = static_cast<float>(src_h) / dst_h;
 
-                    size_t rgb_idx = y_idx * 3;
-                    rgb[rgb_idx] = static_cast<uint8_t>(std::clamp(R, 0, 255));
-                    rgb[rgb_idx + 1] = static_cast<uint8_t>(std::clamp(G, 0, 255));
-                    rgb[rgb_idx + 2] = static_cast<uint8_t>(std::clamp(B, 0, 255));
+            for (uint32_t y = 0; y < dst_h; y++)
+            {
+                const uint32_t sy = static_cast<uint32_t>(y * y_ratio);
+                const uint8_t *y_row = y_plane + static_cast<size_t>(sy) * src_w;
+                const size_t uv_row = (sy / 2) * (src_w / 2);
+                uint8_t *out = rgb + static_cast<size_t>(y) * dst_w * 3;
+                for (uint32_t x = 0; x < dst_w; x++)
+                {
+                    const uint32_t sx = static_cast<uint32_t>(x * x_ratio);
+                    const size_t uv_idx = uv_row + sx / 2;
+                    yuv_to_rgb(y_row[sx], u_plane[uv_idx] - 128, v_plane[uv_idx] - 128, out + x * 3);
                 }
             }
         }
 
+        void yuv420_resize_nearest(const uint8_t *src, uint8_t *dst,
+                                   uint32_t src_w, uint32_t src_h,
+                                   uint32_t dst_w, uint32_t dst_h)
+        {
+            const size_t src_y = static_cast<size_t>(src_w) * src_h;
+            const size_t src_uv = (src_w / 2) * (src_h / 2);
+            const size_t dst_y = static_cast<size_t>(dst_w) * dst_h;
+            const size_t dst_uv = (dst_w / 2) * (dst_h / 2);
+            resize_nearest(src, dst, src_w, src_h, dst_w, dst_h, 1);
+            resize_nearest(src + src_y, dst + dst_y, src_w / 2, src_h / 2, dst_w / 2, dst_h / 2, 1);
+            resize_nearest(src + src_y + src_uv, dst + dst_y + dst_uv, src_w / 2, src_h / 2, dst_w / 2, dst_h / 2, 1);
+        }
+
         void resize_nearest(const uint8_t *src, uint8_t *dst,
                             uint32_t src_w, uint32_t src_h,
                             uint32_t dst_w, uint32_t dst_h,
-                            int channels)
+                            int channels, size_t src_stride)
         {
             float x_ratio = static_cast<float>(src_w) / dst_w;
             float y_ratio = static_cast<float>(src_h) / dst_h;
+            if (src_stride == 0)
+                src_stride = static_cast<size_t>(src_w) * channels;
 
             for (uint32_t y = 0; y < dst_h; y++)
             {
@@ -548,7 +784,7 @@ namespace camera
                     uint32_t src_x = static_cast<uint32_t>(x * x_ratio);
                     uint32_t src_y = static_cast<uint32_t>(y * y_ratio);
 
-                    size_t src_idx = (src_y * src_w + src_x) * channels;
+                    size_t src_idx = src_y * src_stride + static_cast<size_t>(src_x) * channels;
                     size_t dst_idx = (y * dst_w + x) * channels;
 
                     for (int c = 0; c < channels; c++)
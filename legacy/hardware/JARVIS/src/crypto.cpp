@@ -1,90 +1,320 @@
 #include "crypto.hpp"
 #include <openssl/evp.h>
+#include <openssl/opensslv.h>
 #include <openssl/rand.h>
 #include <openssl/sha.h>
 #include <cstring>
-#include <vector>
-#include <sstream>
-#include <iomanip>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#define JARVIS_CRYPTO_EVP_MAC 1
+#else
 #include <openssl/hmac.h>
+#endif
 
 namespace crypto {
 
-static std::string to_hex(const unsigned char* data, size_t len) {
-    std::ostringstream oss;
+namespace {
+
+#ifdef JARVIS_CRYPTO_EVP_MAC
+// Algorithms are fetched once; implicit fetches on every init are what make
+// the one-shot OpenSSL 3 helpers slow
+const EVP_MD* sha256_md()
+{
+    static EVP_MD* md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    return md;
+}
+
+EVP_MAC* hmac_mac()
+{
+    static EVP_MAC* mac = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+    return mac;
+}
+
+const EVP_CIPHER* aes_cipher()
+{
+    static EVP_CIPHER* cipher = EVP_CIPHER_fetch(nullptr, "AES-256-CBC", nullptr);
+    return cipher;
+}
+#else
+const EVP_MD* sha256_md() { return EVP_sha256(); }
+const EVP_CIPHER* aes_cipher() { return EVP_aes_256_cbc(); }
+#endif
+
+// HMAC context of the last key used on this thread
+Hmac* cached_hmac(const std::string& key)
+{
+    thread_local std::unique_ptr<Hmac> hmac;
+    if (!hmac || hmac->key() != key)
+        hmac.reset(new Hmac(key));
+    return hmac->ok() ? hmac.get() : nullptr;
+}
+
+} // namespace
+
+void hex_encode(const void* data, size_t len, char* out)
+{
+    static const char digits[] = "0123456789abcdef";
+    const unsigned char* in = static_cast<const unsigned char*>(data);
     for (size_t i = 0; i < len; ++i) {
-        oss << std::hex << std::setw(2) << std::setfill('0') << (int)data[i];
+        out[2 * i] = digits[in[i] >> 4];
+        out[2 * i + 1] = digits[in[i] & 0xF];
     }
-    return oss.str();
+}
+
+std::string to_hex(const void* data, size_t len)
+{
+    std::string out(2 * len, '\0');
+    hex_encode(data, len, &out[0]);
+    return out;
 }
 
 std::string aes256_encrypt(const std::string& plaintext, const std::string& secret) {
     if (plaintext.empty() || secret.empty()) return {};
 
+    thread_local std::unique_ptr<AesEncryptor> encryptor;
+    if (!encryptor || encryptor->secret() != secret)
+        encryptor.reset(new AesEncryptor(secret));
+    return encryptor->encrypt(plaintext);
+}
+
+std::string hmac_sha256_hex(const void* data, size_t len, const std::string& key)
+{
+    Hmac* hmac = cached_hmac(key);
+    if (!hmac) return std::string();
+    if (!hmac->update(data, len)) {
+        hmac->init();
+        return std::string();
+    }
+    return hmac->final_hex();
+}
+
+std::string hmac_sha256_hex(const std::string& data, const std::string& key)
+{
+    return hmac_sha256_hex(data.data(), data.size(), key);
+}
+
+std::string sha256_hex(const void* data, size_t len)
+{
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(static_cast<const unsigned char*>(data), len, hash);
+    return to_hex(hash, SHA256_DIGEST_LENGTH);
+}
+
+std::string sha256_hex(const std::string& data)
+{
+    return sha256_hex(data.data(), data.size());
+}
+
+void sha256(const void* data, size_t len, unsigned char out[32])
+{
+    SHA256(static_cast<const unsigned char*>(data), len, out);
+}
+
+bool hmac_sha256(const void* data, size_t len, const std::string& key, unsigned char out[32])
+{
+    Hmac* hmac = cached_hmac(key);
+    if (!hmac) return false;
+    if (!hmac->update(data, len)) {
+        hmac->init();
+        return false;
+    }
+    return hmac->final(out);
+}
+
+Hasher::Hasher() : ctx_(EVP_MD_CTX_new())
+{
+    init();
+}
+
+Hasher::~Hasher()
+{
+    EVP_MD_CTX_free(static_cast<EVP_MD_CTX*>(ctx_));
+}
+
+bool Hasher::init()
+{
+    return ctx_ && EVP_DigestInit_ex(static_cast<EVP_MD_CTX*>(ctx_), sha256_md(), nullptr) == 1;
+}
+
+bool Hasher::update(const void* data, size_t len)
+{
+    if (!len) return ctx_ != nullptr;
+    return ctx_ && EVP_DigestUpdate(static_cast<EVP_MD_CTX*>(ctx_), data, len) == 1;
+}
+
+bool Hasher::final(unsigned char out[32])
+{
+    unsigned int len = 0;
+    bool ok = ctx_ && EVP_DigestFinal_ex(static_cast<EVP_MD_CTX*>(ctx_), out, &len) == 1 &&
+              len == SHA256_DIGEST_LENGTH;
+    return init() && ok;
+}
+
+std::string Hasher::final_hex()
+{
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    if (!final(digest)) return std::string();
+    return to_hex(digest, sizeof(digest));
+}
+
+#ifdef JARVIS_CRYPTO_EVP_MAC
+Hmac::Hmac(const std::string& key) : ctx_(nullptr), key_(key)
+{
+    if (!hmac_mac()) return;
+    EVP_MAC_CTX* ctx = EVP_MAC_CTX_new(hmac_mac());
+    if (!ctx) return;
+    char digest[] = "SHA256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end(),
+    };
+    // A zero-length key still has to be set explicitly
+    static const unsigned char empty_key = 0;
+    const unsigned char* k = key.empty() ? &empty_key : reinterpret_cast<const unsigned char*>(key.data());
+    if (EVP_MAC_init(ctx, k, key.size(), params) != 1) {
+        EVP_MAC_CTX_free(ctx);
+        return;
+    }
+    ctx_ = ctx;
+}
+
+Hmac::~Hmac()
+{
+    EVP_MAC_CTX_free(static_cast<EVP_MAC_CTX*>(ctx_));
+}
+
+bool Hmac::init()
+{
+    // No key: HMAC restarts from the one already set
+    return ctx_ && EVP_MAC_init(static_cast<EVP_MAC_CTX*>(ctx_), nullptr, 0, nullptr) == 1;
+}
+
+bool Hmac::update(const void* data, size_t len)
+{
+    if (!len) return ctx_ != nullptr;
+    return ctx_ && EVP_MAC_update(static_cast<EVP_MAC_CTX*>(ctx_), static_cast<const unsigned char*>(data), len) == 1;
+}
+
+bool Hmac::final(unsigned char out[32])
+{
+    size_t len = 0;
+    bool ok = ctx_ && EVP_MAC_final(static_cast<EVP_MAC_CTX*>(ctx_), out, &len, SHA256_DIGEST_LENGTH) == 1 &&
+              len == SHA256_DIGEST_LENGTH;
+    return init() && ok;
+}
+#else
+// OpenSSL 1.1: HMAC_CTX, which also keeps the keyed state between messages
+Hmac::Hmac(const std::string& key) : ctx_(nullptr), key_(key)
+{
+    HMAC_CTX* ctx = HMAC_CTX_new();
+    if (!ctx) return;
+    static const unsigned char empty_key = 0;
+    const void* k = key.empty() ? static_cast<const void*>(&empty_key) : key.data();
+    if (HMAC_Init_ex(ctx, k, static_cast<int>(key.size()), EVP_sha256(), nullptr) != 1) {
+        HMAC_CTX_free(ctx);
+        return;
+    }
+    ctx_ = ctx;
+}
+
+Hmac::~Hmac()
+{
+    HMAC_CTX_free(static_cast<HMAC_CTX*>(ctx_));
+}
+
+bool Hmac::init()
+{
+    return ctx_ && HMAC_Init_ex(static_cast<HMAC_CTX*>(ctx_), nullptr, 0, nullptr, nullptr) == 1;
+}
+
+bool Hmac::update(const void* data, size_t len)
+{
+    if (!len) return ctx_ != nullptr;
+    return ctx_ && HMAC_Update(static_cast<HMAC_CTX*>(ctx_), static_cast<const unsigned char*>(data), len) == 1;
+}
+
+bool Hmac::final(unsigned char out[32])
+{
+    unsigned int len = 0;
+    bool ok = ctx_ && HMAC_Final(static_cast<HMAC_CTX*>(ctx_), out, &len) == 1 && len == SHA256_DIGEST_LENGTH;
+    return init() && ok;
+}
+#endif
+
+std::string Hmac::final_hex()
+{
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    if (!final(digest)) return std::string();
+    return to_hex(digest, sizeof(digest));
+}
+
+AesEncryptor::AesEncryptor(const std::string& secret) : ctx_(nullptr), secret_(secret)
+{
+    if (secret.empty()) return;
+
     // Derive a 32-byte key from secret using SHA256
     unsigned char key[32];
     SHA256(reinterpret_cast<const unsigned char*>(secret.data()), secret.size(), key);
 
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    if (ctx && EVP_EncryptInit_ex(ctx, aes_cipher(), nullptr, key, nullptr) == 1)
+        ctx_ = ctx;
+    else
+        EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_cleanse(key, sizeof(key));
+}
+
+AesEncryptor::~AesEncryptor()
+{
+    EVP_CIPHER_CTX_free(static_cast<EVP_CIPHER_CTX*>(ctx_));
+}
+
+std::string AesEncryptor::encrypt(const std::string& plaintext)
+{
+    if (!ctx_ || plaintext.empty()) return {};
+    EVP_CIPHER_CTX* ctx = static_cast<EVP_CIPHER_CTX*>(ctx_);
+
     // Generate random 16-byte IV
     unsigned char iv[16];
     if (RAND_bytes(iv, sizeof(iv)) != 1) return {};
+    // Only the IV changes; the key schedule stays
+    if (EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr, iv) != 1) return {};
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) return {};
-
-    if (EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, iv) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        return {};
-    }
-
-    std::vector<unsigned char> ciphertext(plaintext.size() + EVP_CIPHER_block_size(EVP_aes_256_cbc()));
+    buffer_.resize(plaintext.size() + 16);
     int len = 0, ciphertext_len = 0;
-
-    if (EVP_EncryptUpdate(ctx, ciphertext.data(), &len,
+    if (EVP_EncryptUpdate(ctx, buffer_.data(), &len,
                           reinterpret_cast<const unsigned char*>(plaintext.data()),
-                          static_cast<int>(plaintext.size())) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
+                          static_cast<int>(plaintext.size())) != 1)
         return {};
-    }
     ciphertext_len = len;
-
-    if (EVP_EncryptFinal_ex(ctx, ciphertext.data() + len, &len) != 1) {
-        EVP_CIPHER_CTX_free(ctx);
-        return {};
-    }
+    if (EVP_EncryptFinal_ex(ctx, buffer_.data() + len, &len) != 1) return {};
     ciphertext_len += len;
-    EVP_CIPHER_CTX_free(ctx);
 
     // Prepend IV to ciphertext and return as hex
-    std::string result = to_hex(iv, sizeof(iv)) + to_hex(ciphertext.data(), ciphertext_len);
+    std::string result(2 * (sizeof(iv) + ciphertext_len), '\0');
+    hex_encode(iv, sizeof(iv), &result[0]);
+    hex_encode(buffer_.data(), ciphertext_len, &result[2 * sizeof(iv)]);
     return result;
 }
 
-std::string hmac_sha256_hex(const std::string& data, const std::string& key)
+DigestStream::DigestStream(const std::string& key)
+    : hmac_(key.empty() ? nullptr : new Hmac(key))
 {
-    unsigned int len = EVP_MAX_MD_SIZE;
-    unsigned char out[EVP_MAX_MD_SIZE];
-    if (!HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
-              reinterpret_cast<const unsigned char*>(data.data()), static_cast<int>(data.size()), out, &len))
-    {
-        return std::string();
-    }
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (unsigned int i = 0; i < len; ++i)
-        oss << std::setw(2) << static_cast<int>(out[i]);
-    return oss.str();
 }
 
-std::string sha256_hex(const std::string& data)
+void DigestStream::update(const void* data, size_t len)
 {
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), hash);
-    std::ostringstream oss;
-    oss << std::hex << std::setfill('0');
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i)
-        oss << std::setw(2) << static_cast<int>(hash[i]);
-    return oss.str();
+    if (hmac_)
+        hmac_->update(data, len);
+    else
+        hasher_.update(data, len);
+}
+
+std::string DigestStream::final_hex()
+{
+    return hmac_ ? hmac_->final_hex() : hasher_.final_hex();
 }
 
 } // namespace crypto
@@ -0,0 +1,441 @@
+#include "detection_bus.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace hand_detector
+{
+
+    namespace
+    {
+
+        const char kBusMagic[4] = {'J', 'R', 'V', 'D'};
+        constexpr size_t kSeqSize = sizeof(uint64_t);
+
+        // Slot contents are copied as 64-bit words with relaxed atomics: a
+        // reader racing the producer gets a torn copy, which the sequence
+        // check then rejects, instead of undefined behaviour
+        void store_words(uint8_t *dst, const void *src, size_t bytes)
+        {
+            uint64_t *d = reinterpret_cast<uint64_t *>(dst);
+            const uint8_t *s = static_cast<const uint8_t *>(src);
+            for (size_t i = 0; i < bytes / 8; ++i)
+            {
+                uint64_t w;
+                std::memcpy(&w, s + i * 8, 8);
+                __atomic_store_n(d + i, w, __ATOMIC_RELAXED);
+            }
+        }
+
+        void load_words(void *dst, const uint8_t *src, size_t bytes)
+        {
+            const uint64_t *s = reinterpret_cast<const uint64_t *>(src);
+            uint8_t *d = static_cast<uint8_t *>(dst);
+            for (size_t i = 0; i < bytes / 8; ++i)
+            {
+                uint64_t w = __atomic_load_n(s + i, __ATOMIC_RELAXED);
+                std::memcpy(d + i * 8, &w, 8);
+            }
+        }
+
+        uint64_t clock_ns(clockid_t clock)
+        {
+            struct timespec ts;
+            clock_gettime(clock, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        uint32_t round_up_pow2(uint32_t v)
+        {
+            uint32_t p = 1;
+            while (p < v && p < (1u << 30))
+                p <<= 1;
+            return p;
+        }
+
+        size_t slot_size_for(uint32_t max_hands)
+        {
+            size_t bytes = kSeqSize + sizeof(BusRecordHeader) + static_cast<size_t>(max_hands) * sizeof(BusHand);
+            return (bytes + 63) & ~static_cast<size_t>(63);
+        }
+
+        std::string errno_text(const char *what, const std::string &name)
+        {
+            return std::string(what) + " " + name + ": " + std::strerror(errno);
+        }
+
+    } // namespace
+
+    BusHand to_bus_hand(const HandDetection &d)
+    {
+        BusHand hand = {};
+        hand.bbox_x = d.bbox.x;
+        hand.bbox_y = d.bbox.y;
+        hand.bbox_w = d.bbox.width;
+        hand.bbox_h = d.bbox.height;
+        hand.confidence = d.bbox.confidence;
+        hand.center_x = d.center.x;
+        hand.center_y = d.center.y;
+        hand.gesture = static_cast<uint32_t>(d.gesture);
+        hand.gesture_confidence = d.gesture_confidence;
+        hand.num_fingers = d.num_fingers;
+        hand.contour_area = d.contour_area;
+        hand.fingertip_count = static_cast<uint32_t>(std::min<size_t>(d.fingertips.size(), kBusMaxFingertips));
+        for (uint32_t f = 0; f < hand.fingertip_count; ++f)
+        {
+            hand.fingertips[f][0] = d.fingertips[f].x;
+            hand.fingertips[f][1] = d.fingertips[f].y;
+        }
+        return hand;
+    }
+
+    HandDetection from_bus_hand(const BusHand &b)
+    {
+        HandDetection d;
+        d.bbox.x = b.bbox_x;
+        d.bbox.y = b.bbox_y;
+        d.bbox.width = b.bbox_w;
+        d.bbox.height = b.bbox_h;
+        d.bbox.confidence = b.confidence;
+        d.center = Point(b.center_x, b.center_y);
+        d.gesture = static_cast<Gesture>(b.gesture);
+        d.gesture_confidence = b.gesture_confidence;
+        d.num_fingers = b.num_fingers;
+        d.contour_area = b.contour_area;
+        for (uint32_t f = 0; f < std::min(b.fingertip_count, kBusMaxFingertips); ++f)
+            d.fingertips.emplace_back(b.fingertips[f][0], b.fingertips[f][1]);
+        return d;
+    }
+
+    // ------------------------------------------------------------------------
+    // Publisher
+    // ------------------------------------------------------------------------
+
+    DetectionPublisher::~DetectionPublisher()
+    {
+        close();
+    }
+
+    bool DetectionPublisher::open(const DetectionBusConfig &config)
+    {
+        close();
+        error_.clear();
+        const uint32_t slots = round_up_pow2(std::max<uint32_t>(config.slots, 2));
+        const uint32_t max_hands = std::min(std::max<uint32_t>(config.max_hands, 1), kBusMaxHands);
+        const size_t slot_size = slot_size_for(max_hands);
+        const size_t needed = sizeof(BusHeader) + slots * slot_size;
+
+        int fd = shm_open(config.name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            error_ = errno_text("shm_open", config.name);
+            return false;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) == 0 && st.st_size != 0 && static_cast<size_t>(st.st_size) != needed)
+        {
+            // Another layout: retire it for mapped readers and start afresh
+            if (static_cast<size_t>(st.st_size) >= sizeof(BusHeader))
+            {
+                void *old = mmap(nullptr, sizeof(BusHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (old != MAP_FAILED)
+                {
+                    __atomic_store_n(&static_cast<BusHeader *>(old)->retired, 1u, __ATOMIC_RELEASE);
+                    munmap(old, sizeof(BusHeader));
+                }
+            }
+            ::close(fd);
+            shm_unlink(config.name.c_str());
+            fd = shm_open(config.name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                error_ = errno_text("shm_open", config.name);
+                return false;
+            }
+        }
+        if (ftruncate(fd, static_cast<off_t>(needed)) != 0)
+        {
+            error_ = errno_text("ftruncate", config.name);
+            ::close(fd);
+            return false;
+        }
+        void *m = mmap(nullptr, needed, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED)
+        {
+            error_ = errno_text("mmap", config.name);
+            return false;
+        }
+
+        base_ = static_cast<uint8_t *>(m);
+        size_ = needed;
+        name_ = config.name;
+        slot_count_ = slots;
+        slot_size_ = static_cast<uint32_t>(slot_size);
+        max_hands_ = max_hands;
+        next_ = 0;
+
+        // Readers treat epoch 0 as "being set up"; the real epoch goes in last
+        BusHeader *h = reinterpret_cast<BusHeader *>(base_);
+        const uint64_t previous_epoch = __atomic_load_n(&h->epoch_ns, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&h->epoch_ns, uint64_t(0), __ATOMIC_RELEASE);
+        for (uint32_t i = 0; i < slots; ++i)
+            __atomic_store_n(reinterpret_cast<uint64_t *>(base_ + sizeof(BusHeader) + i * slot_size), uint64_t(0),
+                             __ATOMIC_RELAXED);
+        std::memcpy(h->magic, kBusMagic, 4);
+        h->version = kDetectionBusVersion;
+        h->header_size = sizeof(BusHeader);
+        h->slot_count = slots;
+        h->slot_size = slot_size_;
+        h->max_hands = max_hands;
+        h->hand_size = sizeof(BusHand);
+        h->producer_pid = static_cast<uint32_t>(getpid());
+        __atomic_store_n(&h->published, uint64_t(0), __ATOMIC_RELAXED);
+        __atomic_store_n(&h->retired, 0u, __ATOMIC_RELAXED);
+        uint64_t epoch = clock_ns(CLOCK_REALTIME);
+        if (epoch == previous_epoch)
+            ++epoch;
+        __atomic_store_n(&h->epoch_ns, epoch, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    void DetectionPublisher::close()
+    {
+        if (!base_)
+            return;
+        __atomic_store_n(&reinterpret_cast<BusHeader *>(base_)->retired, 1u, __ATOMIC_RELEASE);
+        munmap(base_, size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+
+    bool DetectionPublisher::unlink(const std::string &name)
+    {
+        return shm_unlink(name.c_str()) == 0;
+    }
+
+    uint64_t DetectionPublisher::publish(uint64_t frame_id, uint64_t capture_ns, uint32_t width, uint32_t height,
+                                         const std::vector<HandDetection> &hands)
+    {
+        if (!base_)
+            return 0;
+        const uint64_t n = next_;
+        uint8_t *slot = base_ + sizeof(BusHeader) + (n & (slot_count_ - 1)) * slot_size_;
+        uint64_t *seq = reinterpret_cast<uint64_t *>(slot);
+
+        // Odd: readers of this slot back off until the record is complete
+        __atomic_store_n(seq, 2 * n + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        BusRecordHeader rec = {};
+        rec.frame_id = frame_id;
+        rec.capture_ns = capture_ns;
+        rec.publish_ns = clock_ns(CLOCK_MONOTONIC);
+        rec.frame_width = width;
+        rec.frame_height = height;
+        rec.hand_count = static_cast<uint32_t>(std::min<size_t>(hands.size(), max_hands_));
+        store_words(slot + kSeqSize, &rec, sizeof(rec));
+
+        uint8_t *out = slot + kSeqSize + sizeof(BusRecordHeader);
+        for (uint32_t i = 0; i < rec.hand_count; ++i)
+        {
+            const BusHand hand = to_bus_hand(hands[i]);
+            store_words(out + i * sizeof(BusHand), &hand, sizeof(hand));
+        }
+
+        __atomic_store_n(seq, 2 * n + 2, __ATOMIC_RELEASE);
+        __atomic_store_n(&reinterpret_cast<BusHeader *>(base_)->published, n + 1, __ATOMIC_RELEASE);
+        next_ = n + 1;
+        return n;
+    }
+
+    // ------------------------------------------------------------------------
+    // Subscriber
+    // ------------------------------------------------------------------------
+
+    DetectionSubscriber::~DetectionSubscriber()
+    {
+        close();
+    }
+
+    bool DetectionSubscriber::open(const std::string &name)
+    {
+        close();
+        name_ = name;
+        missed_ = 0;
+        restarts_ = 0;
+        if (!map(name))
+            return false;
+        cursor_ = published();
+        return true;
+    }
+
+    bool DetectionSubscriber::map(const std::string &name)
+    {
+        error_.clear();
+        int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            error_ = errno_text("shm_open", name);
+            return false;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BusHeader))
+        {
+            error_ = "detection bus " + name + " is not initialised";
+            ::close(fd);
+            return false;
+        }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void *m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED)
+        {
+            error_ = errno_text("mmap", name);
+            return false;
+        }
+
+        const BusHeader *h = static_cast<const BusHeader *>(m);
+        const uint64_t epoch = __atomic_load_n(&h->epoch_ns, __ATOMIC_ACQUIRE);
+        const bool valid = epoch != 0 && std::memcmp(h->magic, kBusMagic, 4) == 0 &&
+                           h->version == kDetectionBusVersion && h->header_size == sizeof(BusHeader) &&
+                           h->hand_size == sizeof(BusHand) && h->max_hands <= kBusMaxHands && h->slot_count != 0 &&
+                           (h->slot_count & (h->slot_count - 1)) == 0 && h->slot_size >= slot_size_for(h->max_hands) &&
+                           sizeof(BusHeader) + static_cast<size_t>(h->slot_count) * h->slot_size <= size;
+        if (!valid)
+        {
+            error_ = "detection bus " + name + " has an unknown layout";
+            munmap(m, size);
+            return false;
+        }
+
+        close();
+        base_ = static_cast<const uint8_t *>(m);
+        size_ = size;
+        slot_count_ = h->slot_count;
+        slot_size_ = h->slot_size;
+        max_hands_ = h->max_hands;
+        epoch_ = epoch;
+        return true;
+    }
+
+    void DetectionSubscriber::close()
+    {
+        if (base_)
+            munmap(const_cast<uint8_t *>(base_), size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+
+    uint64_t DetectionSubscriber::published() const
+    {
+        return __atomic_load_n(&reinterpret_cast<const BusHeader *>(base_)->published, __ATOMIC_ACQUIRE);
+    }
+
+    // Notice a producer restart (new epoch on the same segment) or a
+    // replaced segment (old one retired), and start over on its records
+    void DetectionSubscriber::follow_producer()
+    {
+        const BusHeader *h = reinterpret_cast<const BusHeader *>(base_);
+        if (__atomic_load_n(&h->retired, __ATOMIC_ACQUIRE))
+        {
+            // Cheap to retry, but not on every poll of a stopped producer
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_reopen_ < std::chrono::milliseconds(100))
+                return;
+            last_reopen_ = now;
+            std::string keep_error = error_;
+            uint64_t old_epoch = epoch_;
+            if (map(name_) && epoch_ != old_epoch)
+            {
+                ++restarts_;
+                cursor_ = 0;
+            }
+            else
+                error_ = keep_error;
+            return;
+        }
+        const uint64_t epoch = __atomic_load_n(&h->epoch_ns, __ATOMIC_ACQUIRE);
+        if (epoch != 0 && epoch != epoch_)
+        {
+            epoch_ = epoch;
+            ++restarts_;
+            cursor_ = 0;
+        }
+    }
+
+    bool DetectionSubscriber::read_slot(uint64_t n, BusEvent &out) const
+    {
+        const uint8_t *slot = base_ + sizeof(BusHeader) + (n & (slot_count_ - 1)) * slot_size_;
+        const uint64_t *seq = reinterpret_cast<const uint64_t *>(slot);
+        const uint64_t before = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+        if (before != 2 * n + 2)
+            return false;
+
+        BusRecordHeader rec;
+        load_words(&rec, slot + kSeqSize, sizeof(rec));
+        const uint32_t count = std::min(rec.hand_count, max_hands_);
+        BusHand hands[kBusMaxHands];
+        const uint32_t copied = std::min(count, kBusMaxHands);
+        load_words(hands, slot + kSeqSize + sizeof(BusRecordHeader), copied * sizeof(BusHand));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(seq, __ATOMIC_RELAXED) != before)
+            return false;
+
+        out.seq = n;
+        out.frame_id = rec.frame_id;
+        out.capture_ns = rec.capture_ns;
+        out.publish_ns = rec.publish_ns;
+        out.frame_width = rec.frame_width;
+        out.frame_height = rec.frame_height;
+        out.hands.resize(copied);
+        for (uint32_t i = 0; i < copied; ++i)
+            out.hands[i] = from_bus_hand(hands[i]);
+        return true;
+    }
+
+    bool DetectionSubscriber::next(BusEvent &out)
+    {
+        if (!base_)
+            return false;
+        follow_producer();
+        const uint64_t pub = published();
+        if (cursor_ > pub)
+            cursor_ = pub; // producer restarted and has not caught up
+        if (pub - cursor_ > slot_count_)
+        {
+            missed_ += pub - slot_count_ - cursor_;
+            cursor_ = pub - slot_count_;
+        }
+        while (cursor_ < pub)
+        {
+            if (read_slot(cursor_++, out))
+                return true;
+            ++missed_; // overwritten while we were looking
+        }
+        return false;
+    }
+
+    bool DetectionSubscriber::latest(BusEvent &out)
+    {
+        if (!base_)
+            return false;
+        follow_producer();
+        const uint64_t pub = published();
+        if (pub == 0 || pub <= cursor_)
+            return false;
+        if (pub - 1 > cursor_)
+            missed_ += pub - 1 - cursor_;
+        cursor_ = pub;
+        return read_slot(pub - 1, out);
+    }
+
+} // namespace hand_detector
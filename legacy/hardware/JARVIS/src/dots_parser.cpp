@@ -0,0 +1,277 @@
+#include "dots_parser.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace renderer
+{
+    namespace
+    {
+        const uint64_t kFnvPrime = 1099511628211ULL;
+        const int64_t kNumberCap = int64_t(1) << 40; // digits beyond this cannot fit an int anyway
+
+        inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+        inline bool is_alpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+        inline int hex_value(char c)
+        {
+            if (c >= '0' && c <= '9')
+                return c - '0';
+            if (c >= 'a' && c <= 'f')
+                return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F')
+                return c - 'A' + 10;
+            return -1;
+        }
+    }
+
+    void DotsParser::reset(std::vector<RenderLine> *out)
+    {
+        out_ = out;
+        stack_.clear(); // keeps its capacity
+        state_ = State::VALUE;
+        string_is_key_ = false;
+        escape_ = false;
+        key_ = Key::OTHER;
+        buf_len_ = 0;
+        has_clear_ = false;
+        clear_ = false;
+        saw_lines_key_ = false;
+        hash_ = 1469598103934665603ULL;
+    }
+
+    void DotsParser::feed(const char *data, size_t size)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            const char c = data[i];
+            hash_ = (hash_ ^ static_cast<uint8_t>(c)) * kFnvPrime;
+            switch (state_)
+            {
+            case State::STRING:
+                if (escape_)
+                    escape_ = false;
+                else if (c == '\\')
+                {
+                    escape_ = true;
+                    continue;
+                }
+                else if (c == '"')
+                {
+                    state_ = State::VALUE;
+                    end_string();
+                    continue;
+                }
+                if (buf_len_ < sizeof(buf_))
+                    buf_[buf_len_] = c;
+                ++buf_len_;
+                continue;
+            case State::NUMBER:
+                if (is_digit(c))
+                {
+                    if (!fraction_ && number_ < kNumberCap)
+                        number_ = number_ * 10 + (c - '0');
+                    continue;
+                }
+                if (c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-')
+                {
+                    fraction_ = true;
+                    continue;
+                }
+                state_ = State::VALUE;
+                end_number();
+                break;
+            case State::LITERAL:
+                if (is_alpha(c))
+                {
+                    if (buf_len_ < sizeof(buf_))
+                        buf_[buf_len_] = c;
+                    ++buf_len_;
+                    continue;
+                }
+                state_ = State::VALUE;
+                end_literal();
+                break;
+            case State::VALUE:
+                break;
+            }
+            structural(c);
+        }
+    }
+
+    bool DotsParser::finish()
+    {
+        if (state_ == State::NUMBER)
+            end_number();
+        else if (state_ == State::LITERAL)
+            end_literal();
+        bool complete = state_ != State::STRING && stack_.empty();
+        state_ = State::VALUE;
+        return complete;
+    }
+
+    void DotsParser::structural(char c)
+    {
+        switch (c)
+        {
+        case '{':
+            stack_.emplace_back();
+            stack_.back().object = true;
+            stack_.back().expect_key = true;
+            key_ = Key::OTHER;
+            break;
+        case '[':
+            stack_.emplace_back();
+            key_ = Key::OTHER;
+            break;
+        case '}':
+            if (!stack_.empty())
+            {
+                const Frame &f = stack_.back();
+                if (f.object && f.has_any && out_)
+                    out_->push_back(f.line);
+                stack_.pop_back();
+            }
+            key_ = Key::OTHER;
+            break;
+        case ']':
+            if (!stack_.empty())
+                stack_.pop_back();
+            key_ = Key::OTHER;
+            break;
+        case ',':
+            if (!stack_.empty() && stack_.back().object)
+                stack_.back().expect_key = true;
+            key_ = Key::OTHER;
+            break;
+        case '"':
+            state_ = State::STRING;
+            string_is_key_ = !stack_.empty() && stack_.back().object && stack_.back().expect_key;
+            escape_ = false;
+            buf_len_ = 0;
+            break;
+        default:
+            if (c == '-' || is_digit(c))
+            {
+                state_ = State::NUMBER;
+                negative_ = c == '-';
+                fraction_ = false;
+                number_ = negative_ ? 0 : c - '0';
+            }
+            else if (is_alpha(c))
+            {
+                state_ = State::LITERAL;
+                buf_[0] = c;
+                buf_len_ = 1;
+            }
+            // ':' and whitespace carry no information here
+            break;
+        }
+    }
+
+    DotsParser::Key DotsParser::classify_key() const
+    {
+        auto is = [this](const char *name) {
+            size_t n = std::strlen(name);
+            return buf_len_ == n && std::memcmp(buf_, name, n) == 0;
+        };
+        if (buf_len_ == 2 && (buf_[0] == 'x' || buf_[0] == 'y') && (buf_[1] == '0' || buf_[1] == '1'))
+        {
+            if (buf_[0] == 'x')
+                return buf_[1] == '0' ? Key::X0 : Key::X1;
+            return buf_[1] == '0' ? Key::Y0 : Key::Y1;
+        }
+        if (is("thickness"))
+            return Key::THICKNESS;
+        if (is("color"))
+            return Key::COLOR;
+        if (is("clear"))
+            return Key::CLEAR;
+        if (is("lines"))
+            return Key::LINES;
+        return Key::OTHER;
+    }
+
+    void DotsParser::end_string()
+    {
+        if (string_is_key_)
+        {
+            key_ = classify_key();
+            stack_.back().expect_key = false;
+            if (key_ == Key::LINES)
+                saw_lines_key_ = true;
+            return;
+        }
+        // Only "#RRGGBB" is a colour; anything else leaves the default
+        if (key_ == Key::COLOR && !stack_.empty() && stack_.back().object && buf_len_ == 7 && buf_[0] == '#')
+        {
+            uint32_t rgb = 0;
+            bool ok = true;
+            for (size_t i = 1; i < 7 && ok; ++i)
+            {
+                int v = hex_value(buf_[i]);
+                ok = v >= 0;
+                rgb = (rgb << 4) | static_cast<uint32_t>(v & 0xF);
+            }
+            if (ok)
+                stack_.back().line.color = rgb;
+        }
+        key_ = Key::OTHER;
+    }
+
+    void DotsParser::end_number()
+    {
+        if (!stack_.empty() && stack_.back().object)
+        {
+            Frame &f = stack_.back();
+            int64_t v = negative_ ? -number_ : number_;
+            int value = static_cast<int>(std::max<int64_t>(INT_MIN, std::min<int64_t>(INT_MAX, v)));
+            switch (key_)
+            {
+            case Key::X0:
+                f.line.x0 = value;
+                f.has_any = true;
+                break;
+            case Key::Y0:
+                f.line.y0 = value;
+                f.has_any = true;
+                break;
+            case Key::X1:
+                f.line.x1 = value;
+                f.has_any = true;
+                break;
+            case Key::Y1:
+                f.line.y1 = value;
+                f.has_any = true;
+                break;
+            case Key::THICKNESS:
+                if (!negative_)
+                    f.line.thickness = value;
+                break;
+            default:
+                break;
+            }
+        }
+        key_ = Key::OTHER;
+    }
+
+    void DotsParser::end_literal()
+    {
+        if (key_ == Key::CLEAR && !has_clear_)
+        {
+            if (buf_len_ == 4 && std::memcmp(buf_, "true", 4) == 0)
+            {
+                has_clear_ = true;
+                clear_ = true;
+            }
+            else if (buf_len_ == 5 && std::memcmp(buf_, "false", 5) == 0)
+            {
+                has_clear_ = true;
+                clear_ = false;
+            }
+        }
+        key_ = Key::OTHER;
+    }
+
+} // namespace renderer
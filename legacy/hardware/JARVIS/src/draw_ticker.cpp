@@ -60,25 +60,44 @@ namespace draw_ticker
         }
     }
 
-    void draw_line(void *map, uint32_t stride, uint32_t width, uint32_t height,
-                   int x0, int y0, int x1, int y1, uint32_t color, int thickness)
+    void clear_rect(void *map, uint32_t stride, uint32_t width, uint32_t height,
+                    int clip_x0, int clip_y0, int clip_x1, int clip_y1, uint32_t color)
     {
+        int x_end = std::min(clip_x1, (int)width);
+        int y_end = std::min(clip_y1, (int)height);
+        for (int y = std::max(0, clip_y0); y < y_end; ++y)
+        {
+            for (int x = std::max(0, clip_x0); x < x_end; ++x)
+            {
+                write_pixel_generic(map, stride, width, height, x, y, color);
+            }
+        }
+    }
+
+    void draw_line_clipped(void *map, uint32_t stride, uint32_t width, uint32_t height,
+                           int clip_x0, int clip_y0, int clip_x1, int clip_y1,
+                           int x0, int y0, int x1, int y1, uint32_t color, int thickness)
+    {
+        clip_x0 = std::max(0, clip_x0);
+        clip_y0 = std::max(0, clip_y0);
+        clip_x1 = std::min(clip_x1, (int)width);
+        clip_y1 = std::min(clip_y1, (int)height);
         int dx = std::abs(x1 - x0);
         int sx = x0 < x1 ? 1 : -1;
         int dy = -std::abs(y1 - y0);
         int sy = y0 < y1 ? 1 : -1;
         int err = dx + dy;
-        uint8_t *bytes = reinterpret_cast<uint8_t *>(map);
 
         while (true)
         {
-            if (x0 >= 0 && x0 < (int)width && y0 >= 0 && y0 < (int)height)
+            // The pen centre must be on screen, as in a full repaint
+            if (x0 >= 0 && x0 < (int)width && y0 >= clip_y0 && y0 < clip_y1)
             {
                 int half = std::max(0, thickness / 2);
                 for (int t = -half; t <= half; ++t)
                 {
                     int xx = x0 + t;
-                    if (xx >= 0 && xx < (int)width)
+                    if (xx >= clip_x0 && xx < clip_x1)
                         write_pixel_generic(map, stride, width, height, xx, y0, color);
                 }
             }
@@ -98,6 +117,13 @@ namespace draw_ticker
         }
     }
 
+    void draw_line(void *map, uint32_t stride, uint32_t width, uint32_t height,
+                   int x0, int y0, int x1, int y1, uint32_t color, int thickness)
+    {
+        draw_line_clipped(map, stride, width, height, 0, 0, (int)width, (int)height,
+                          x0, y0, x1, y1, color, thickness);
+    }
+
     void build_line(int fd, struct gbm_bo *bo, uint32_t fb_id,
                     uint32_t crtc_id, uint32_t conn_id, drmModeModeInfo mode,
                     int x0, int y0, int x1, int y1,
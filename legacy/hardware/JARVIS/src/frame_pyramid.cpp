@@ -0,0 +1,240 @@
+#include "frame_pyramid.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAS_NEON 1
+#else
+#define HAS_NEON 0
+#endif
+
+namespace camera
+{
+
+    namespace
+    {
+
+        // Pyramids kept for reuse; one per frame in flight is plenty
+        constexpr size_t kPoolSize = 4;
+
+        struct Pool
+        {
+            std::mutex mutex;
+            std::vector<FramePyramid *> free;
+            std::mutex assign; // Frame::pyramid swaps
+        };
+
+        // Never destroyed: frames may still release pyramids during exit
+        Pool &pool()
+        {
+            static Pool *p = new Pool;
+            return *p;
+        }
+
+        // One output row from two input rows: 2x2 box average, rounded
+        void halve_row(const uint8_t *r0, const uint8_t *r1, uint8_t *dst, uint32_t dst_w)
+        {
+            uint32_t x = 0;
+#if HAS_NEON
+            // 16 input pixels per row, deinterleaved into R, G, B
+            for (; x + 8 <= dst_w; x += 8)
+            {
+                const uint8x16x3_t a = vld3q_u8(r0 + x * 6);
+                const uint8x16x3_t b = vld3q_u8(r1 + x * 6);
+                uint8x8x3_t out;
+                for (int c = 0; c < 3; ++c)
+                    out.val[c] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[c]), vpaddlq_u8(b.val[c])), 2);
+                vst3_u8(dst + x * 3, out);
+            }
+#endif
+            for (; x < dst_w; ++x)
+            {
+                const uint8_t *p0 = r0 + x * 6;
+                const uint8_t *p1 = r1 + x * 6;
+                uint8_t *d = dst + x * 3;
+                for (int c = 0; c < 3; ++c)
+                    d[c] = static_cast<uint8_t>((p0[c] + p0[c + 3] + p1[c] + p1[c + 3] + 2) >> 2);
+            }
+        }
+
+    } // namespace
+
+    std::shared_ptr<FramePyramid> FramePyramid::acquire()
+    {
+        Pool &p = pool();
+        FramePyramid *pyramid = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+            if (!p.free.empty())
+            {
+                pyramid = p.free.back();
+                p.free.pop_back();
+            }
+        }
+        if (!pyramid)
+            pyramid = new FramePyramid();
+        return std::shared_ptr<FramePyramid>(pyramid, [](FramePyramid *released)
+                                             {
+            Pool &p = pool();
+            {
+                std::lock_guard<std::mutex> lock(p.mutex);
+                if (p.free.size() < kPoolSize)
+                {
+                    released->built_levels_ = 0;
+                    p.free.push_back(released);
+                    return;
+                }
+            }
+            delete released; });
+    }
+
+    FramePyramid::Key FramePyramid::key_of(const Frame &source)
+    {
+        Key key;
+        key.pixels = source.pixels();
+        key.width = source.width;
+        key.height = source.height;
+        key.stride = source.stride;
+        key.timestamp_ns = source.timestamp_ns;
+        key.sequence = source.sequence;
+        return key;
+    }
+
+    bool FramePyramid::same(const Key &a, const Key &b)
+    {
+        return a.pixels == b.pixels && a.width == b.width && a.height == b.height &&
+               a.stride == b.stride && a.timestamp_ns == b.timestamp_ns && a.sequence == b.sequence;
+    }
+
+    bool FramePyramid::matches(const Frame &source) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return built_levels_ > 0 && same(key_, key_of(source));
+    }
+
+    int FramePyramid::built_levels() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return built_levels_;
+    }
+
+    const Frame *FramePyramid::level(const Frame &source, int level)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (built_levels_ > 0 && !same(key_, key_of(source)))
+            built_levels_ = 0;
+        if (built_levels_ < level)
+            build(source, level);
+        const Frame &f = levels_[level - 1];
+        return f.width ? &f : nullptr;
+    }
+
+    void FramePyramid::build(const Frame &source, int level)
+    {
+        // Levels already built stay; the next one halves the last of them
+        const int first = built_levels_;
+        uint8_t *dst[kPyramidLevels];
+        int levels = 0;
+        for (int i = first; i < level; ++i)
+        {
+            Frame &f = levels_[i];
+            f.width = source.width >> (i + 1);
+            f.height = source.height >> (i + 1);
+            if (f.width == 0 || f.height == 0)
+                f.width = f.height = 0;
+            // resize() keeps the capacity, so reused pyramids do not allocate
+            f.data.resize(static_cast<size_t>(f.width) * f.height * 3);
+            f.size = f.data.size();
+            f.stride = static_cast<int>(f.width * 3);
+            f.format = PixelFormat::RGB888;
+            f.timestamp_ns = source.timestamp_ns;
+            f.sequence = source.sequence;
+            f.invalidate_pyramid();
+            if (f.width)
+                dst[levels++] = f.data.data();
+        }
+        if (first == 0)
+        {
+            const size_t stride = source.stride > 0 ? static_cast<size_t>(source.stride) : source.width * 3;
+            utils::rgb888_pyramid(source.pixels(), stride, source.width, source.height, dst, levels);
+            key_ = key_of(source);
+        }
+        else
+        {
+            const Frame &above = levels_[first - 1];
+            utils::rgb888_pyramid(above.data.data(), above.stride, above.width, above.height, dst, levels);
+        }
+        built_levels_ = level;
+    }
+
+    const Frame *Frame::pyramid_level(int level) const
+    {
+        if (level < 1 || level > kPyramidLevels || format != PixelFormat::RGB888 || !has_pixels() ||
+            (width >> level) == 0 || (height >> level) == 0)
+            return nullptr;
+        const size_t row = static_cast<size_t>(width) * 3;
+        const size_t stride_bytes = stride > 0 ? static_cast<size_t>(stride) : row;
+        if (stride_bytes < row || (external ? size : data.size()) < stride_bytes * (height - 1) + row)
+            return nullptr;
+        // Detectors on other threads may ask for the same frame at once, so
+        // which pyramid serves it is settled under one lock; building runs
+        // outside it. A copy of this frame may still share a pyramid of its
+        // own pixels; leave it that one rather than rebuilding underneath it.
+        FramePyramid *current;
+        {
+            std::lock_guard<std::mutex> lock(pool().assign);
+            if (!pyramid || (pyramid.use_count() > 1 && !pyramid->matches(*this)))
+                pyramid = FramePyramid::acquire();
+            current = pyramid.get();
+        }
+        return current->level(*this, level);
+    }
+
+    const Frame &Frame::pyramid_for(uint32_t min_width, uint32_t min_height) const
+    {
+        int level = 0;
+        while (level < kPyramidLevels && (width >> (level + 1)) >= min_width && (height >> (level + 1)) >= min_height)
+            ++level;
+        const Frame *f = level ? pyramid_level(level) : nullptr;
+        return f ? *f : *this;
+    }
+
+    namespace utils
+    {
+
+        void rgb888_pyramid(const uint8_t *src, size_t src_stride,
+                            uint32_t width, uint32_t height,
+                            uint8_t *const *dst, int levels)
+        {
+            levels = std::min(levels, kPyramidLevels);
+            if (levels <= 0)
+                return;
+            uint32_t w[kPyramidLevels] = {};
+            uint32_t h[kPyramidLevels] = {};
+            for (int l = 0; l < levels; ++l)
+            {
+                w[l] = width >> (l + 1);
+                h[l] = height >> (l + 1);
+            }
+            for (uint32_t y = 0; y < h[0]; ++y)
+            {
+                halve_row(src + 2 * y * src_stride, src + (2 * y + 1) * src_stride, dst[0] + static_cast<size_t>(y) * w[0] * 3, w[0]);
+                // Every second row of a level completes a row of the next
+                uint32_t row = y;
+                for (int l = 1; l < levels && (row & 1); ++l)
+                {
+                    row >>= 1;
+                    if (row >= h[l])
+                        break;
+                    const size_t above = static_cast<size_t>(w[l - 1]) * 3;
+                    const uint8_t *r0 = dst[l - 1] + 2 * row * above;
+                    halve_row(r0, r0 + above, dst[l] + static_cast<size_t>(row) * w[l] * 3, w[l]);
+                }
+            }
+        }
+
+    } // namespace utils
+
+} // namespace camera
@@ -0,0 +1,503 @@
+#include "frame_recording.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+namespace camera
+{
+
+    namespace
+    {
+
+        const char kRecordingMagic[4] = {'J', 'R', 'V', 'C'};
+        const char kRecordMagic[4] = {'J', 'R', 'F', 'R'};
+        constexpr uint64_t kAlign = 64;
+
+        uint64_t align_up(uint64_t v)
+        {
+            return (v + kAlign - 1) & ~(kAlign - 1);
+        }
+
+        uint64_t realtime_ns()
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        uint64_t metadata_bytes(uint64_t poses, uint64_t hands)
+        {
+            return poses * sizeof(IMX500PoseDetection) + hands * sizeof(IMX500HandLandmark);
+        }
+
+        // The configured path, else the env var; camera N > 0 records to
+        // name_N.ext so several cameras can share one setting
+        std::string source_path(const std::string &configured, const char *var, int camera_index)
+        {
+            if (!configured.empty())
+                return configured;
+            const char *env = std::getenv(var);
+            if (!env || !*env || std::strcmp(env, "0") == 0)
+                return "";
+            std::string path = env;
+            if (camera_index > 0)
+            {
+                size_t slash = path.find_last_of('/');
+                size_t dot = path.find_last_of('.');
+                if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+                    dot = path.size();
+                path.insert(dot, "_" + std::to_string(camera_index));
+            }
+            return path;
+        }
+
+    } // namespace
+
+    std::string recording_path(const CameraConfig &config)
+    {
+        return source_path(config.record, "JARVIS_RECORD", config.camera_index);
+    }
+
+    std::string replay_path(const CameraConfig &config)
+    {
+        return source_path(config.replay, "JARVIS_REPLAY", config.camera_index);
+    }
+
+    // ------------------------------------------------------------------------
+    // Recorder
+    // ------------------------------------------------------------------------
+
+    FrameRecorder::~FrameRecorder()
+    {
+        close();
+    }
+
+    bool FrameRecorder::fail(const std::string &what)
+    {
+        error_ = "recording " + path_ + ": " + what;
+        return false;
+    }
+
+    RecordingHeader FrameRecorder::make_header() const
+    {
+        RecordingHeader header{};
+        std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+        header.version = kRecordingVersion;
+        header.header_size = sizeof(RecordingHeader);
+        header.record_header_size = sizeof(RecordHeader);
+        header.created_ns = created_ns_;
+        return header;
+    }
+
+    bool FrameRecorder::put(const void *data, size_t bytes)
+    {
+        if (bytes && std::fwrite(data, 1, bytes, file_) != bytes)
+            return fail(std::string("write failed: ") + std::strerror(errno));
+        offset_ += bytes;
+        return true;
+    }
+
+    bool FrameRecorder::pad()
+    {
+        static const uint8_t zeros[kAlign] = {};
+        return put(zeros, align_up(offset_) - offset_);
+    }
+
+    bool FrameRecorder::open(const std::string &path)
+    {
+        close();
+        error_.clear();
+        path_ = path;
+        index_.clear();
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_)
+            return fail(std::strerror(errno));
+        // Frames are large and written whole; a bigger buffer saves syscalls
+        // for the small header/metadata writes in between
+        std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+
+        created_ns_ = realtime_ns();
+        RecordingHeader header = make_header();
+        offset_ = 0;
+        if (!put(&header, sizeof(header)))
+        {
+            std::fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    bool FrameRecorder::write(uint64_t frame_id, const Frame &frame)
+    {
+        return write(frame_id, frame, frame.pixels(), static_cast<uint32_t>(frame.size), frame.format,
+                     static_cast<uint32_t>(frame.stride));
+    }
+
+    bool FrameRecorder::write(uint64_t frame_id, const Frame &frame, const uint8_t *pixels, uint32_t bytes,
+                              PixelFormat format, uint32_t stride)
+    {
+        if (!file_)
+            return fail("not open");
+        if (!pixels || bytes == 0)
+            return fail("frame has no pixels");
+
+        RecordHeader h{};
+        std::memcpy(h.magic, kRecordMagic, sizeof(h.magic));
+        h.format = static_cast<uint32_t>(format);
+        h.frame_id = frame_id;
+        h.timestamp_ns = frame.timestamp_ns;
+        h.width = frame.width;
+        h.height = frame.height;
+        h.stride = stride;
+        h.bytes = bytes;
+        h.pose_count = static_cast<uint32_t>(frame.imx500_detections.size());
+        h.hand_count = static_cast<uint32_t>(frame.imx500_hand_landmarks.size());
+        h.record_size = sizeof(RecordHeader) + align_up(bytes) + align_up(metadata_bytes(h.pose_count, h.hand_count));
+
+        const uint64_t start = offset_;
+        bool ok = put(&h, sizeof(h)) && put(pixels, bytes) && pad() &&
+                  put(frame.imx500_detections.data(), h.pose_count * sizeof(IMX500PoseDetection)) &&
+                  put(frame.imx500_hand_landmarks.data(), h.hand_count * sizeof(IMX500HandLandmark)) && pad();
+        if (!ok)
+            return false;
+        index_.push_back({start, frame.timestamp_ns});
+        return true;
+    }
+
+    bool FrameRecorder::close()
+    {
+        if (!file_)
+            return true;
+        // Index first, header last: until the header points at it, the
+        // reader falls back to walking the records
+        const uint64_t index_offset = offset_;
+        bool ok = put(index_.data(), index_.size() * sizeof(RecordingIndexEntry)) && std::fflush(file_) == 0;
+        if (ok)
+        {
+            RecordingHeader header = make_header();
+            header.frame_count = index_.size();
+            header.index_offset = index_offset;
+            ok = std::fseek(file_, 0, SEEK_SET) == 0 && std::fwrite(&header, 1, sizeof(header), file_) == sizeof(header);
+        }
+        if (std::fclose(file_) != 0)
+            ok = false;
+        file_ = nullptr;
+        if (!ok && error_.empty())
+            fail(std::string("close failed: ") + std::strerror(errno));
+        return ok;
+    }
+
+    // ------------------------------------------------------------------------
+    // Reader
+    // ------------------------------------------------------------------------
+
+    FrameRecording::~FrameRecording()
+    {
+        close();
+    }
+
+    void FrameRecording::close()
+    {
+        if (base_)
+            munmap(const_cast<uint8_t *>(base_), size_);
+        base_ = nullptr;
+        size_ = 0;
+        index_.clear();
+        indexed_ = false;
+    }
+
+    bool FrameRecording::fail(const std::string &what)
+    {
+        error_ = what;
+        close();
+        return false;
+    }
+
+    bool FrameRecording::open(const std::string &path)
+    {
+        close();
+        error_.clear();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return fail("recording " + path + ": " + std::strerror(errno));
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(RecordingHeader))
+        {
+            ::close(fd);
+            return fail("recording " + path + ": too short");
+        }
+        void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return fail("recording " + path + ": mmap: " + std::strerror(errno));
+        base_ = static_cast<const uint8_t *>(p);
+        size_ = static_cast<size_t>(st.st_size);
+        // Replay reads front to back
+        madvise(p, size_, MADV_SEQUENTIAL);
+
+        RecordingHeader header;
+        std::memcpy(&header, base_, sizeof(header));
+        if (std::memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0 ||
+            header.version != kRecordingVersion || header.header_size != sizeof(RecordingHeader) ||
+            header.record_header_size != sizeof(RecordHeader))
+            return fail("recording " + path + ": not a JARVIS recording");
+
+        if (header.index_offset != 0 && header.index_offset <= size_ &&
+            header.frame_count <= (size_ - header.index_offset) / sizeof(RecordingIndexEntry))
+        {
+            index_.resize(header.frame_count);
+            std::memcpy(index_.data(), base_ + header.index_offset, index_.size() * sizeof(RecordingIndexEntry));
+            indexed_ = true;
+            return true;
+        }
+
+        // Cut short: every complete record is still usable
+        RecordHeader h;
+        for (uint64_t offset = sizeof(RecordingHeader); record_at(offset, h); offset += h.record_size)
+            index_.push_back({offset, h.timestamp_ns});
+        return true;
+    }
+
+    bool FrameRecording::record_at(uint64_t offset, RecordHeader &out) const
+    {
+        if (offset > size_ || size_ - offset < sizeof(RecordHeader))
+            return false;
+        std::memcpy(&out, base_ + offset, sizeof(out));
+        if (std::memcmp(out.magic, kRecordMagic, sizeof(out.magic)) != 0)
+            return false;
+        const uint64_t need = sizeof(RecordHeader) + align_up(out.bytes) +
+                              align_up(metadata_bytes(out.pose_count, out.hand_count));
+        return out.record_size >= need && out.record_size <= size_ - offset;
+    }
+
+    bool FrameRecording::frame(size_t i, RecordingView &out) const
+    {
+        RecordHeader h;
+        if (i >= index_.size() || !record_at(index_[i].offset, h))
+            return false;
+        const uint8_t *p = base_ + index_[i].offset + sizeof(RecordHeader);
+        out.frame_id = h.frame_id;
+        out.timestamp_ns = h.timestamp_ns;
+        out.width = h.width;
+        out.height = h.height;
+        out.format = h.format <= static_cast<uint32_t>(PixelFormat::UNKNOWN) ? static_cast<PixelFormat>(h.format)
+                                                                             : PixelFormat::UNKNOWN;
+        out.stride = h.stride;
+        out.bytes = h.bytes;
+        out.data = p;
+        out.pose_count = h.pose_count;
+        out.hand_count = h.hand_count;
+        out.metadata = p + align_up(h.bytes);
+        return true;
+    }
+
+    void FrameRecording::copy_metadata(const RecordingView &view, Frame &frame)
+    {
+        frame.imx500_detections.resize(view.pose_count);
+        frame.imx500_hand_landmarks.resize(view.hand_count);
+        const size_t pose_bytes = view.pose_count * sizeof(IMX500PoseDetection);
+        if (pose_bytes)
+            std::memcpy(frame.imx500_detections.data(), view.metadata, pose_bytes);
+        if (view.hand_count)
+            std::memcpy(frame.imx500_hand_landmarks.data(), view.metadata + pose_bytes,
+                        view.hand_count * sizeof(IMX500HandLandmark));
+        frame.has_imx500_metadata = view.pose_count + view.hand_count > 0;
+    }
+
+    // ------------------------------------------------------------------------
+    // Replay
+    // ------------------------------------------------------------------------
+
+    bool ReplaySource::init(const CameraConfig &config)
+    {
+        stop();
+        config_ = config;
+        const std::string path = replay_path(config);
+        if (path.empty())
+        {
+            last_error_ = "No recording to replay (set replay or JARVIS_REPLAY)";
+            return false;
+        }
+        if (!recording_.open(path))
+        {
+            last_error_ = recording_.error();
+            return false;
+        }
+        RecordingView first, last;
+        if (!recording_.frame(0, first) || !recording_.frame(recording_.size() - 1, last))
+        {
+            last_error_ = "recording " + path + ": no frames";
+            recording_.close();
+            return false;
+        }
+
+        if (config_.replay_fps == 0.0f)
+        {
+            const char *env = std::getenv("JARVIS_REPLAY_FPS");
+            if (env && std::strcmp(env, "max") == 0)
+                config_.replay_fps = -1.0f;
+            else if (env && *env)
+                config_.replay_fps = std::strtof(env, nullptr);
+        }
+        if (!config_.replay_loop)
+        {
+            const char *env = std::getenv("JARVIS_REPLAY_LOOP");
+            config_.replay_loop = env && std::strcmp(env, "1") == 0;
+        }
+
+        config_.width = first.width;
+        config_.height = first.height;
+        if (config_.replay_fps > 0.0f)
+            config_.framerate = static_cast<uint32_t>(config_.replay_fps + 0.5f);
+        else if (recording_.size() > 1 && last.timestamp_ns > first.timestamp_ns)
+            config_.framerate = static_cast<uint32_t>((recording_.size() - 1) * 1e9 /
+                                                      (last.timestamp_ns - first.timestamp_ns) + 0.5);
+        std::cerr << "[Replay] " << path << ": " << recording_.size() << " frames, " << config_.width << "x"
+                  << config_.height << (recording_.indexed() ? "" : " (recovered, no index)") << std::endl;
+        return true;
+    }
+
+    bool ReplaySource::start()
+    {
+        if (!recording_.is_open())
+        {
+            last_error_ = "Replay not initialized";
+            return false;
+        }
+        RecordingView first;
+        recording_.frame(0, first);
+        next_ = 0;
+        served_ = 0;
+        loop_offset_ns_ = 0;
+        loop_offset_seq_ = 0;
+        missed_ = 0;
+        start_timestamp_ns_ = first.timestamp_ns;
+        start_ = std::chrono::steady_clock::now();
+        running_ = true;
+        return true;
+    }
+
+    void ReplaySource::stop()
+    {
+        if (running_ && config_.verbose)
+            std::cerr << "[Replay] Stopped after " << served_ << " frames" << std::endl;
+        running_ = false;
+    }
+
+    Frame *ReplaySource::capture_frame()
+    {
+        if (!running_)
+        {
+            last_error_ = "Replay not running";
+            return nullptr;
+        }
+        if (next_ >= recording_.size())
+        {
+            if (!config_.replay_loop)
+            {
+                last_error_ = "End of recording";
+                running_ = false;
+                return nullptr;
+            }
+            // The next pass starts one frame interval after this one ended
+            RecordingView first, last;
+            recording_.frame(0, first);
+            recording_.frame(recording_.size() - 1, last);
+            const uint64_t span = last.timestamp_ns - first.timestamp_ns;
+            loop_offset_ns_ += span + (recording_.size() > 1 ? span / (recording_.size() - 1) : 33333333);
+            loop_offset_seq_ += last.frame_id - first.frame_id + 1;
+            next_ = 0;
+        }
+
+        RecordingView v;
+        if (!recording_.frame(next_, v))
+        {
+            last_error_ = "Corrupt record " + std::to_string(next_);
+            running_ = false;
+            return nullptr;
+        }
+        const uint64_t timestamp_ns = v.timestamp_ns + loop_offset_ns_;
+        // Recorded ids are the camera's sequence numbers, so drops at
+        // capture time replay as the same gaps
+        const uint64_t sequence = v.frame_id + loop_offset_seq_;
+        if (served_ > 0 && sequence > frame_.sequence + 1)
+            missed_ += sequence - frame_.sequence - 1;
+
+        // Frames are never dropped to catch up: every run sees every frame
+        if (config_.replay_fps > 0.0f)
+            std::this_thread::sleep_until(start_ + std::chrono::nanoseconds(
+                                                       static_cast<int64_t>(served_ * 1e9 / config_.replay_fps)));
+        else if (config_.replay_fps == 0.0f && timestamp_ns > start_timestamp_ns_)
+            std::this_thread::sleep_until(start_ + std::chrono::nanoseconds(timestamp_ns - start_timestamp_ns_));
+
+        if (v.format == PixelFormat::YUV420)
+        {
+            if (v.bytes < static_cast<uint64_t>(v.width) * v.height * 3 / 2)
+            {
+                last_error_ = "Short YUV420 record " + std::to_string(next_);
+                running_ = false;
+                return nullptr;
+            }
+            frame_.external = nullptr;
+            frame_.data.resize(static_cast<size_t>(v.width) * v.height * 3);
+            utils::yuv420_to_rgb888(v.data, frame_.data.data(), v.width, v.height);
+            frame_.size = frame_.data.size();
+            frame_.format = PixelFormat::RGB888;
+            frame_.stride = static_cast<int>(v.width * 3);
+        }
+        else
+        {
+            // Borrowed as is, so the record must hold every row it claims
+            const uint64_t row = static_cast<uint64_t>(v.width) * (v.format == PixelFormat::RGBA8888 ? 4 : 3);
+            if (v.format == PixelFormat::UNKNOWN || v.width == 0 || v.height == 0 || v.stride < row ||
+                v.bytes < static_cast<uint64_t>(v.stride) * (v.height - 1) + row)
+            {
+                last_error_ = "Short or malformed record " + std::to_string(next_);
+                running_ = false;
+                return nullptr;
+            }
+            frame_.external = v.data;
+            frame_.size = v.bytes;
+            frame_.format = v.format;
+            frame_.stride = static_cast<int>(v.stride);
+        }
+        frame_.width = v.width;
+        frame_.height = v.height;
+        frame_.timestamp_ns = timestamp_ns;
+        frame_.sequence = sequence;
+        FrameRecording::copy_metadata(v, frame_);
+
+        // The detection stream is derived from the recorded pixels the way
+        // Camera derives it, so replay exercises the same detector path
+        const bool packed = v.format != PixelFormat::RGB888 || v.stride == v.width * 3;
+        frame_.lores = packed && make_lores_frame(config_, v.data, v.format, v.width, v.height, lores_)
+                           ? &lores_
+                           : nullptr;
+        if (frame_.lores)
+        {
+            lores_.timestamp_ns = timestamp_ns;
+            lores_.sequence = sequence;
+        }
+
+        ++next_;
+        ++served_;
+        return &frame_;
+    }
+
+    std::unique_ptr<FrameSource> make_frame_source(const CameraConfig &config)
+    {
+        if (!replay_path(config).empty())
+            return std::unique_ptr<FrameSource>(new ReplaySource());
+        return std::unique_ptr<FrameSource>(new Camera());
+    }
+
+} // namespace camera
@@ -0,0 +1,420 @@
+#include "frame_ring.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace camera
+{
+
+    namespace
+    {
+
+        const char kRingMagic[4] = {'J', 'R', 'V', 'F'};
+        constexpr size_t kPage = 4096;
+
+        uint64_t realtime_ns()
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+        }
+
+        uint32_t round_up_pow2(uint32_t v)
+        {
+            uint32_t p = 1;
+            while (p < v && p < (1u << 16))
+                p <<= 1;
+            return p;
+        }
+
+        size_t slot_size_for(uint32_t capacity)
+        {
+            return (sizeof(FrameSlotHeader) + capacity + kPage - 1) & ~(kPage - 1);
+        }
+
+        std::string errno_text(const char *what, const std::string &name)
+        {
+            return std::string(what) + " " + name + ": " + std::strerror(errno);
+        }
+
+        // Slot header fields go through relaxed atomics so a reader racing
+        // the producer reads stale or torn values, never undefined ones;
+        // the seq check decides whether they are used
+        template <typename T>
+        void put(T *field, T value)
+        {
+            __atomic_store_n(field, value, __ATOMIC_RELAXED);
+        }
+
+        template <typename T>
+        T get(const T *field)
+        {
+            return __atomic_load_n(field, __ATOMIC_RELAXED);
+        }
+
+    } // namespace
+
+    // ------------------------------------------------------------------------
+    // Writer
+    // ------------------------------------------------------------------------
+
+    FrameRingWriter::~FrameRingWriter()
+    {
+        close();
+    }
+
+    bool FrameRingWriter::open(const FrameRingConfig &config)
+    {
+        close();
+        error_.clear();
+        if (config.frame_capacity == 0)
+        {
+            error_ = "frame ring " + config.name + ": no frame size given";
+            return false;
+        }
+        const uint32_t slots = round_up_pow2(std::max<uint32_t>(config.slots, 2));
+        const size_t slot_size = slot_size_for(config.frame_capacity);
+        const size_t needed = sizeof(FrameRingHeader) + slots * slot_size;
+
+        int fd = shm_open(config.name.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            error_ = errno_text("shm_open", config.name);
+            return false;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) == 0 && st.st_size != 0 && static_cast<size_t>(st.st_size) != needed)
+        {
+            // Another resolution or slot count: retire it for mapped readers
+            // and start afresh under the same name
+            if (static_cast<size_t>(st.st_size) >= sizeof(FrameRingHeader))
+            {
+                void *old = mmap(nullptr, sizeof(FrameRingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (old != MAP_FAILED)
+                {
+                    __atomic_store_n(&static_cast<FrameRingHeader *>(old)->retired, 1u, __ATOMIC_RELEASE);
+                    munmap(old, sizeof(FrameRingHeader));
+                }
+            }
+            ::close(fd);
+            shm_unlink(config.name.c_str());
+            fd = shm_open(config.name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                error_ = errno_text("shm_open", config.name);
+                return false;
+            }
+        }
+        if (ftruncate(fd, static_cast<off_t>(needed)) != 0)
+        {
+            error_ = errno_text("ftruncate", config.name);
+            ::close(fd);
+            return false;
+        }
+        void *m = mmap(nullptr, needed, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED)
+        {
+            error_ = errno_text("mmap", config.name);
+            return false;
+        }
+
+        base_ = static_cast<uint8_t *>(m);
+        size_ = needed;
+        slot_count_ = slots;
+        slot_size_ = static_cast<uint32_t>(slot_size);
+        frame_capacity_ = config.frame_capacity;
+        next_ = 0;
+        writing_ = false;
+
+        // Epoch 0 tells readers the ring is being set up
+        FrameRingHeader *h = reinterpret_cast<FrameRingHeader *>(base_);
+        const uint64_t previous_epoch = __atomic_load_n(&h->epoch_ns, __ATOMIC_ACQUIRE);
+        __atomic_store_n(&h->epoch_ns, uint64_t(0), __ATOMIC_RELEASE);
+        for (uint32_t i = 0; i < slots; ++i)
+            put(&reinterpret_cast<FrameSlotHeader *>(slot(i))->seq, uint64_t(0));
+        std::memcpy(h->magic, kRingMagic, 4);
+        h->version = kFrameRingVersion;
+        h->header_size = sizeof(FrameRingHeader);
+        h->slot_count = slots;
+        h->slot_size = slot_size_;
+        h->frame_capacity = frame_capacity_;
+        h->producer_pid = static_cast<uint32_t>(getpid());
+        put(&h->published, uint64_t(0));
+        put(&h->retired, 0u);
+        uint64_t epoch = realtime_ns();
+        if (epoch == previous_epoch)
+            ++epoch;
+        __atomic_store_n(&h->epoch_ns, epoch, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    void FrameRingWriter::close()
+    {
+        if (!base_)
+            return;
+        if (writing_)
+            abort_frame();
+        __atomic_store_n(&reinterpret_cast<FrameRingHeader *>(base_)->retired, 1u, __ATOMIC_RELEASE);
+        munmap(base_, size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+
+    bool FrameRingWriter::unlink(const std::string &name)
+    {
+        return shm_unlink(name.c_str()) == 0;
+    }
+
+    uint8_t *FrameRingWriter::slot(uint64_t n) const
+    {
+        return base_ + sizeof(FrameRingHeader) + (n & (slot_count_ - 1)) * slot_size_;
+    }
+
+    uint8_t *FrameRingWriter::begin_frame()
+    {
+        if (!base_)
+            return nullptr;
+        uint8_t *s = slot(next_);
+        if (!writing_)
+        {
+            // Odd: readers of this slot stop trusting it before any pixel changes
+            put(&reinterpret_cast<FrameSlotHeader *>(s)->seq, 2 * next_ + 1);
+            __atomic_thread_fence(__ATOMIC_RELEASE);
+            writing_ = true;
+        }
+        return s + sizeof(FrameSlotHeader);
+    }
+
+    uint64_t FrameRingWriter::commit_frame(uint64_t frame_id, uint64_t timestamp_ns, uint32_t width, uint32_t height,
+                                           PixelFormat format, uint32_t stride, uint32_t bytes)
+    {
+        if (!base_ || !writing_)
+            return 0;
+        const uint64_t n = next_;
+        FrameSlotHeader *sh = reinterpret_cast<FrameSlotHeader *>(slot(n));
+        put(&sh->frame_id, frame_id);
+        put(&sh->timestamp_ns, timestamp_ns);
+        put(&sh->width, width);
+        put(&sh->height, height);
+        put(&sh->format, static_cast<uint32_t>(format));
+        put(&sh->stride, stride);
+        put(&sh->bytes, std::min(bytes, frame_capacity_));
+        __atomic_store_n(&sh->seq, 2 * n + 2, __ATOMIC_RELEASE);
+        __atomic_store_n(&reinterpret_cast<FrameRingHeader *>(base_)->published, n + 1, __ATOMIC_RELEASE);
+        next_ = n + 1;
+        writing_ = false;
+        return n;
+    }
+
+    void FrameRingWriter::abort_frame()
+    {
+        if (!base_ || !writing_)
+            return;
+        __atomic_store_n(&reinterpret_cast<FrameSlotHeader *>(slot(next_))->seq, uint64_t(0), __ATOMIC_RELEASE);
+        writing_ = false;
+    }
+
+    // ------------------------------------------------------------------------
+    // Reader
+    // ------------------------------------------------------------------------
+
+    FrameRingReader::~FrameRingReader()
+    {
+        close();
+    }
+
+    bool FrameRingReader::open(const std::string &name)
+    {
+        close();
+        name_ = name;
+        missed_ = 0;
+        restarts_ = 0;
+        if (!map(name))
+            return false;
+        cursor_ = published();
+        return true;
+    }
+
+    bool FrameRingReader::map(const std::string &name)
+    {
+        error_.clear();
+        int fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            error_ = errno_text("shm_open", name);
+            return false;
+        }
+        struct stat st = {};
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(FrameRingHeader))
+        {
+            error_ = "frame ring " + name + " is not initialised";
+            ::close(fd);
+            return false;
+        }
+        const size_t size = static_cast<size_t>(st.st_size);
+        void *m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED)
+        {
+            error_ = errno_text("mmap", name);
+            return false;
+        }
+
+        const FrameRingHeader *h = static_cast<const FrameRingHeader *>(m);
+        const uint64_t epoch = __atomic_load_n(&h->epoch_ns, __ATOMIC_ACQUIRE);
+        const bool valid_layout = epoch != 0 && std::memcmp(h->magic, kRingMagic, 4) == 0 &&
+                                  h->version == kFrameRingVersion && h->header_size == sizeof(FrameRingHeader) &&
+                                  h->slot_count != 0 && (h->slot_count & (h->slot_count - 1)) == 0 &&
+                                  h->slot_size >= sizeof(FrameSlotHeader) + h->frame_capacity &&
+                                  sizeof(FrameRingHeader) + static_cast<size_t>(h->slot_count) * h->slot_size <= size;
+        if (!valid_layout)
+        {
+            error_ = "frame ring " + name + " has an unknown layout";
+            munmap(m, size);
+            return false;
+        }
+
+        close();
+        base_ = static_cast<const uint8_t *>(m);
+        size_ = size;
+        slot_count_ = h->slot_count;
+        slot_size_ = h->slot_size;
+        frame_capacity_ = h->frame_capacity;
+        epoch_ = epoch;
+        return true;
+    }
+
+    void FrameRingReader::close()
+    {
+        if (base_)
+            munmap(const_cast<uint8_t *>(base_), size_);
+        base_ = nullptr;
+        size_ = 0;
+    }
+
+    uint64_t FrameRingReader::published() const
+    {
+        return __atomic_load_n(&reinterpret_cast<const FrameRingHeader *>(base_)->published, __ATOMIC_ACQUIRE);
+    }
+
+    // Same restart handling as the detection bus: a new epoch on the same
+    // segment, or a retired segment replaced under the same name
+    void FrameRingReader::follow_producer()
+    {
+        const FrameRingHeader *h = reinterpret_cast<const FrameRingHeader *>(base_);
+        if (__atomic_load_n(&h->retired, __ATOMIC_ACQUIRE))
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_reopen_ < std::chrono::milliseconds(100))
+                return;
+            last_reopen_ = now;
+            std::string keep_error = error_;
+            uint64_t old_epoch = epoch_;
+            if (map(name_) && epoch_ != old_epoch)
+            {
+                ++restarts_;
+                cursor_ = 0;
+            }
+            else
+                error_ = keep_error;
+            return;
+        }
+        const uint64_t epoch = __atomic_load_n(&h->epoch_ns, __ATOMIC_ACQUIRE);
+        if (epoch != 0 && epoch != epoch_)
+        {
+            epoch_ = epoch;
+            ++restarts_;
+            cursor_ = 0;
+        }
+    }
+
+    bool FrameRingReader::read_slot(uint64_t n, FrameRingView &out) const
+    {
+        const uint8_t *s = base_ + sizeof(FrameRingHeader) + (n & (slot_count_ - 1)) * slot_size_;
+        const FrameSlotHeader *sh = reinterpret_cast<const FrameSlotHeader *>(s);
+        const uint64_t before = __atomic_load_n(&sh->seq, __ATOMIC_ACQUIRE);
+        if (before != 2 * n + 2)
+            return false;
+
+        FrameRingView v;
+        v.seq = n;
+        v.frame_id = get(&sh->frame_id);
+        v.timestamp_ns = get(&sh->timestamp_ns);
+        v.width = get(&sh->width);
+        v.height = get(&sh->height);
+        v.format = static_cast<PixelFormat>(get(&sh->format));
+        v.stride = get(&sh->stride);
+        v.bytes = std::min(get(&sh->bytes), frame_capacity_);
+        v.data = s + sizeof(FrameSlotHeader);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&sh->seq, __ATOMIC_RELAXED) != before)
+            return false;
+        out = v;
+        return true;
+    }
+
+    bool FrameRingReader::next(FrameRingView &out)
+    {
+        if (!base_)
+            return false;
+        follow_producer();
+        const uint64_t pub = published();
+        if (cursor_ > pub)
+            cursor_ = pub;
+        // The slot the producer fills next is not readable, so a ring of N
+        // holds N-1 frames a reader can still get
+        const uint64_t keep = slot_count_ - 1;
+        if (pub - cursor_ > keep)
+        {
+            missed_ += pub - keep - cursor_;
+            cursor_ = pub - keep;
+        }
+        while (cursor_ < pub)
+        {
+            if (read_slot(cursor_++, out))
+                return true;
+            ++missed_;
+        }
+        return false;
+    }
+
+    bool FrameRingReader::latest(FrameRingView &out)
+    {
+        if (!base_)
+            return false;
+        follow_producer();
+        const uint64_t pub = published();
+        if (pub == 0 || pub <= cursor_)
+            return false;
+        if (pub - 1 > cursor_)
+            missed_ += pub - 1 - cursor_;
+        cursor_ = pub;
+        return read_slot(pub - 1, out);
+    }
+
+    bool FrameRingReader::valid(const FrameRingView &view) const
+    {
+        if (!base_ || !view.data)
+            return false;
+        const FrameSlotHeader *sh = reinterpret_cast<const FrameSlotHeader *>(view.data - sizeof(FrameSlotHeader));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return __atomic_load_n(&sh->seq, __ATOMIC_RELAXED) == 2 * view.seq + 2;
+    }
+
+    bool FrameRingReader::copy(const FrameRingView &view, std::vector<uint8_t> &out) const
+    {
+        if (!valid(view))
+            return false;
+        out.assign(view.data, view.data + view.bytes);
+        return valid(view);
+    }
+
+} // namespace camera
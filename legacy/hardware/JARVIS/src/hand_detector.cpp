@@ -80,7 +80,7 @@ namespace hand_detector
 
         std::vector<HandDetection> detections;
 
-        if (frame.data.empty() || frame.width == 0 || frame.height == 0)
+        if (!frame.has_pixels() || frame.width == 0 || frame.height == 0)
         {
             return detections;
         }
@@ -88,9 +88,24 @@ namespace hand_detector
         current_frame_++;
         stats_.frames_processed++; // Count frame immediately
 
-        const uint32_t work_width = frame.width / config_.downscale_factor;
-        const uint32_t work_height = frame.height / config_.downscale_factor;
+        // A low-res detection stream from the camera replaces the software
+        // downscale; results are scaled back to the main frame either way
+        const camera::Frame *lores = frame.lores;
+        if (lores && (lores->format != camera::PixelFormat::RGB888 || !lores->has_pixels() ||
+                      lores->width == 0 || lores->height == 0))
+            lores = nullptr;
+        // Otherwise a power-of-two downscale is a level of the frame's
+        // pyramid, shared with the other consumers of this frame
+        for (int level = 1; !lores && level <= camera::kPyramidLevels; ++level)
+        {
+            if (config_.downscale_factor == (1 << level))
+                lores = frame.pyramid_level(level);
+        }
+        const uint32_t work_width = lores ? lores->width : frame.width / config_.downscale_factor;
+        const uint32_t work_height = lores ? lores->height : frame.height / config_.downscale_factor;
         const size_t pixel_count = work_width * work_height;
+        const float scale_x = lores ? static_cast<float>(frame.width) / work_width : config_.downscale_factor;
+        const float scale_y = lores ? static_cast<float>(frame.height) / work_height : config_.downscale_factor;
 
         // Ensure buffers are allocated (reuse across frames)
         if (hsv_buffer_.size() < pixel_count * 3)
@@ -105,29 +120,49 @@ namespace hand_detector
         // Step 1: Convert RGB to HSV (with SIMD if available)
         if (frame.format == camera::PixelFormat::RGB888)
         {
-            if (config_.downscale_factor > 1)
+            if (lores)
             {
-                camera::utils::resize_nearest(frame.data.data(), temp_buffer_.data(),
-                                              frame.width, frame.height,
-                                              work_width, work_height, 3);
                 if (config_.enable_simd && simd::is_neon_available())
                 {
-                    simd::convert_rgb_to_hsv_simd(temp_buffer_.data(), hsv_buffer_.data(), pixel_count);
+                    simd::convert_rgb_to_hsv_simd(lores->pixels(), hsv_buffer_.data(), pixel_count);
                 }
                 else
                 {
-                    simd::scalar::convert_rgb_to_hsv(temp_buffer_.data(), hsv_buffer_.data(), pixel_count);
+                    simd::scalar::convert_rgb_to_hsv(lores->pixels(), hsv_buffer_.data(), pixel_count);
                 }
             }
-            else
+            else if (config_.downscale_factor > 1)
             {
+                camera::utils::resize_nearest(frame.pixels(), temp_buffer_.data(),
+                                              frame.width, frame.height,
+                                              work_width, work_height, 3,
+                                              frame.stride > 0 ? static_cast<size_t>(frame.stride) : 0);
                 if (config_.enable_simd && simd::is_neon_available())
                 {
-                    simd::convert_rgb_to_hsv_simd(frame.data.data(), hsv_buffer_.data(), pixel_count);
+                    simd::convert_rgb_to_hsv_simd(temp_buffer_.data(), hsv_buffer_.data(), pixel_count);
                 }
                 else
                 {
-                    simd::scalar::convert_rgb_to_hsv(frame.data.data(), hsv_buffer_.data(), pixel_count);
+                    simd::scalar::convert_rgb_to_hsv(temp_buffer_.data(), hsv_buffer_.data(), pixel_count);
+                }
+            }
+            else
+            {
+                // Padded rows (a crop of a wider buffer) go a row at a time
+                const size_t row = static_cast<size_t>(work_width) * 3;
+                const size_t stride = frame.stride > 0 ? static_cast<size_t>(frame.stride) : row;
+                const uint32_t rows = stride == row ? 1 : work_height;
+                const size_t run = stride == row ? pixel_count : work_width;
+                for (uint32_t y = 0; y < rows; ++y)
+                {
+                    if (config_.enable_simd && simd::is_neon_available())
+                    {
+                        simd::convert_rgb_to_hsv_simd(frame.pixels() + y * stride, hsv_buffer_.data() + y * row, run);
+                    }
+                    else
+                    {
+                        simd::scalar::convert_rgb_to_hsv(frame.pixels() + y * stride, hsv_buffer_.data() + y * row, run);
+                    }
                 }
             }
         }
@@ -258,24 +293,26 @@ namespace hand_detector
             hand.contour_area = static_cast<uint32_t>(polygon_area);
 
             // Scale back to original resolution
-            if (config_.downscale_factor > 1)
+            if (lores || config_.downscale_factor > 1)
             {
-                hand.bbox.x *= config_.downscale_factor;
-                hand.bbox.y *= config_.downscale_factor;
-                hand.bbox.width *= config_.downscale_factor;
-                hand.bbox.height *= config_.downscale_factor;
-                hand.center.x *= config_.downscale_factor;
-                hand.center.y *= config_.downscale_factor;
+                auto sx = [scale_x](int v) { return static_cast<int>(v * scale_x); };
+                auto sy = [scale_y](int v) { return static_cast<int>(v * scale_y); };
+                hand.bbox.x = sx(hand.bbox.x);
+                hand.bbox.y = sy(hand.bbox.y);
+                hand.bbox.width = sx(hand.bbox.width);
+                hand.bbox.height = sy(hand.bbox.height);
+                hand.center.x = sx(hand.center.x);
+                hand.center.y = sy(hand.center.y);
 
                 for (auto &pt : hand.contour)
                 {
-                    pt.x *= config_.downscale_factor;
-                    pt.y *= config_.downscale_factor;
+                    pt.x = sx(pt.x);
+                    pt.y = sy(pt.y);
                 }
                 for (auto &pt : hand.fingertips)
                 {
-                    pt.x *= config_.downscale_factor;
-                    pt.y *= config_.downscale_factor;
+                    pt.x = sx(pt.x);
+                    pt.y = sy(pt.y);
                 }
             }
 
@@ -395,7 +432,7 @@ namespace hand_detector
                                       int roi_x, int roi_y,
                                       int roi_w, int roi_h)
     {
-        if (frame.data.empty() || frame.format != camera::PixelFormat::RGB888)
+        if (!frame.has_pixels() || frame.format != camera::PixelFormat::RGB888)
         {
             return false;
         }
@@ -459,12 +459,14 @@ namespace hand_detector
         const int target_w = tflite_state_->input_width;
         const int target_h = tflite_state_->input_height;
 
-        // Simple bilinear resize
-        const float scale_x = static_cast<float>(frame.width) / target_w;
-        const float scale_y = static_cast<float>(frame.height) / target_h;
+        // Simple bilinear resize, from the smallest pyramid level that
+        // still covers the model input
+        const camera::Frame &level = frame.pyramid_for(target_w, target_h);
+        const float scale_x = static_cast<float>(level.width) / target_w;
+        const float scale_y = static_cast<float>(level.height) / target_h;
 
-        const uint8_t *src = frame.data.data();
-        const int src_stride = frame.stride;
+        const uint8_t *src = level.pixels();
+        const int src_stride = level.stride;
 
         for (int y = 0; y < target_h; ++y)
         {
@@ -474,8 +476,8 @@ namespace hand_detector
                 int src_y = static_cast<int>(y * scale_y);
 
                 // Clamp to frame bounds
-                src_x = std::min(src_x, static_cast<int>(frame.width - 1));
-                src_y = std::min(src_y, static_cast<int>(frame.height - 1));
+                src_x = std::min(src_x, static_cast<int>(level.width - 1));
+                src_y = std::min(src_y, static_cast<int>(level.height - 1));
 
                 const uint8_t *pixel = src + src_y * src_stride + src_x * 3;
 
@@ -476,7 +476,7 @@ namespace hand_detector
 
     void ProductionHandDetector::update_adaptive_params(const camera::Frame &frame)
     {
-        if (frame.data.empty() || frame.format != camera::PixelFormat::RGB888)
+        if (!frame.has_pixels() || frame.format != camera::PixelFormat::RGB888)
         {
             return;
         }
@@ -511,9 +511,9 @@ namespace hand_detector
                         if (idx + 2 >= static_cast<int>(frame.stride * frame.height))
                             continue;
 
-                        uint8_t r = frame.data[idx];
-                        uint8_t g = frame.data[idx + 1];
-                        uint8_t b = frame.data[idx + 2];
+                        uint8_t r = frame.pixels()[idx];
+                        uint8_t g = frame.pixels()[idx + 1];
+                        uint8_t b = frame.pixels()[idx + 2];
 
                         // Compute perceived brightness (ITU-R BT.709)
                         float brightness = 0.2126f * r + 0.7152f * g + 0.0722f * b;
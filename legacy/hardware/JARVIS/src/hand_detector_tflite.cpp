@@ -29,6 +29,9 @@ struct TFLiteHandDetectorImpl {
     std::unique_ptr<tflite::FlatBufferModel> landmark_model;
 #endif
     TFLiteConfig config;
+    // Palm box smoothing state (per detector, so several can run side by side)
+    std::vector<hand_detector::BoundingBox> last_smoothed_palms;
+    float smoothing_alpha = 0.5f; // 0.0 = no smoothing, 1.0 = no update
 };
 
 
@@ -45,11 +48,7 @@ struct TFLiteHandDetectorImpl {
 
 
 // --- Robust Palm Detection: Lower threshold, fallback, smoothing, debug hooks ---
-// Smoothing state for palm boxes (simple exponential moving average)
-namespace {
-    static std::vector<hand_detector::BoundingBox> last_smoothed_palms;
-    static float smoothing_alpha = 0.5f; // 0.0 = no smoothing, 1.0 = no update
-}
+// Palm boxes are smoothed with a simple exponential moving average kept in impl_
 
 std::vector<hand_detector::BoundingBox> TFLiteHandDetector::detect_palms(const camera::Frame &frame)
 {
@@ -86,12 +85,14 @@ std::vector<hand_detector::BoundingBox> TFLiteHandDetector::detect_palms(const c
             }
         }
     };
+    // Resize from the smallest pyramid level that still covers the input
+    const camera::Frame &src = frame.pyramid_for(input_width, input_height);
     if (input_tensor->type == kTfLiteUInt8) {
-        bilinear_resize(frame.data.data(), static_cast<int>(frame.width), static_cast<int>(frame.height), input_data, input_width, input_height);
+        bilinear_resize(src.pixels(), static_cast<int>(src.width), static_cast<int>(src.height), input_data, input_width, input_height);
     } else if (input_tensor->type == kTfLiteFloat32) {
         float* input_f = input_tensor->data.f;
         std::vector<uint8_t> tmp(input_width * input_height * 3);
-        bilinear_resize(frame.data.data(), static_cast<int>(frame.width), static_cast<int>(frame.height), tmp.data(), input_width, input_height);
+        bilinear_resize(src.pixels(), static_cast<int>(src.width), static_cast<int>(src.height), tmp.data(), input_width, input_height);
         for (int i = 0; i < input_width * input_height * 3; ++i)
             input_f[i] = tmp[i] / 255.0f;
     }
@@ -101,7 +102,7 @@ std::vector<hand_detector::BoundingBox> TFLiteHandDetector::detect_palms(const c
     if (impl_->palm_interpreter->Invoke() != kTfLiteOk) {
         std::cerr << "[TFLiteHandDetector] Palm detection inference failed" << std::endl;
         // Fallback: return last smoothed palms if available
-        if (!last_smoothed_palms.empty()) return last_smoothed_palms;
+        if (!impl_->last_smoothed_palms.empty()) return impl_->last_smoothed_palms;
         return palms;
     }
 
@@ -145,23 +146,23 @@ std::vector<hand_detector::BoundingBox> TFLiteHandDetector::detect_palms(const c
     // --- Temporal smoothing (EMA) ---
     // Per-hand smoothing and hold-last logic can be implemented here if needed for further robustness.
     if (!palms.empty()) {
-        if (last_smoothed_palms.size() != palms.size()) {
-            last_smoothed_palms = palms;
+        if (impl_->last_smoothed_palms.size() != palms.size()) {
+            impl_->last_smoothed_palms = palms;
         } else {
             for (size_t i = 0; i < palms.size(); ++i) {
-                last_smoothed_palms[i].x = static_cast<int>(smoothing_alpha * last_smoothed_palms[i].x + (1 - smoothing_alpha) * palms[i].x);
-                last_smoothed_palms[i].y = static_cast<int>(smoothing_alpha * last_smoothed_palms[i].y + (1 - smoothing_alpha) * palms[i].y);
-                last_smoothed_palms[i].width = static_cast<int>(smoothing_alpha * last_smoothed_palms[i].width + (1 - smoothing_alpha) * palms[i].width);
-                last_smoothed_palms[i].height = static_cast<int>(smoothing_alpha * last_smoothed_palms[i].height + (1 - smoothing_alpha) * palms[i].height);
-                last_smoothed_palms[i].confidence = smoothing_alpha * last_smoothed_palms[i].confidence + (1 - smoothing_alpha) * palms[i].confidence;
+                impl_->last_smoothed_palms[i].x = static_cast<int>(impl_->smoothing_alpha * impl_->last_smoothed_palms[i].x + (1 - impl_->smoothing_alpha) * palms[i].x);
+                impl_->last_smoothed_palms[i].y = static_cast<int>(impl_->smoothing_alpha * impl_->last_smoothed_palms[i].y + (1 - impl_->smoothing_alpha) * palms[i].y);
+                impl_->last_smoothed_palms[i].width = static_cast<int>(impl_->smoothing_alpha * impl_->last_smoothed_palms[i].width + (1 - impl_->smoothing_alpha) * palms[i].width);
+                impl_->last_smoothed_palms[i].height = static_cast<int>(impl_->smoothing_alpha * impl_->last_smoothed_palms[i].height + (1 - impl_->smoothing_alpha) * palms[i].height);
+                impl_->last_smoothed_palms[i].confidence = impl_->smoothing_alpha * impl_->last_smoothed_palms[i].confidence + (1 - impl_->smoothing_alpha) * palms[i].confidence;
             }
         }
     }
     // If no palms detected, hold last for a few frames (optional: add timeout logic)
-    if (palms.empty() && !last_smoothed_palms.empty()) {
-        palms = last_smoothed_palms;
+    if (palms.empty() && !impl_->last_smoothed_palms.empty()) {
+        palms = impl_->last_smoothed_palms;
     } else if (!palms.empty()) {
-        palms = last_smoothed_palms;
+        palms = impl_->last_smoothed_palms;
     }
 
     // --- Debug visualization hook (no-op, user can add drawing here) ---
@@ -329,9 +330,9 @@ camera::Frame TFLiteHandDetector::crop_frame_to_bbox(const camera::Frame& frame,
         for (int x = 0; x < w; ++x) {
             int src_idx = ((y0 + y) * frame.width + (x0 + x)) * 3;
             int dst_idx = (y * w + x) * 3;
-            cropped.data[dst_idx + 0] = frame.data[src_idx + 0];
-            cropped.data[dst_idx + 1] = frame.data[src_idx + 1];
-            cropped.data[dst_idx + 2] = frame.data[src_idx + 2];
+            cropped.data[dst_idx + 0] = frame.pixels()[src_idx + 0];
+            cropped.data[dst_idx + 1] = frame.pixels()[src_idx + 1];
+            cropped.data[dst_idx + 2] = frame.pixels()[src_idx + 2];
         }
     }
     return cropped;
@@ -0,0 +1,275 @@
+#include "homography.hpp"
+#include "sketch_pad.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace sketch
+{
+
+    namespace
+    {
+
+        // Similarity transform moving the centroid to the origin and scaling
+        // the mean distance to sqrt(2) (Hartley normalization).
+        void normalization(const Point *pts, size_t n, double T[9])
+        {
+            double cx = 0.0, cy = 0.0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                cx += pts[i].x;
+                cy += pts[i].y;
+            }
+            cx /= n;
+            cy /= n;
+
+            double mean = 0.0;
+            for (size_t i = 0; i < n; ++i)
+                mean += std::hypot(pts[i].x - cx, pts[i].y - cy);
+            mean /= n;
+
+            double s = mean > 1e-12 ? std::sqrt(2.0) / mean : 1.0;
+            T[0] = s, T[1] = 0, T[2] = -s * cx;
+            T[3] = 0, T[4] = s, T[5] = -s * cy;
+            T[6] = 0, T[7] = 0, T[8] = 1;
+        }
+
+        void mat3_mul(const double A[9], const double B[9], double out[9])
+        {
+            double r[9];
+            for (int i = 0; i < 3; ++i)
+                for (int j = 0; j < 3; ++j)
+                    r[i * 3 + j] = A[i * 3] * B[j] + A[i * 3 + 1] * B[3 + j] + A[i * 3 + 2] * B[6 + j];
+            std::copy(r, r + 9, out);
+        }
+
+        // Solve M x = b in place (8x8, Gaussian elimination, partial pivoting)
+        bool solve8(double M[8][8], double b[8], double x[8])
+        {
+            for (int col = 0; col < 8; ++col)
+            {
+                int pivot = col;
+                for (int r = col + 1; r < 8; ++r)
+                    if (std::fabs(M[r][col]) > std::fabs(M[pivot][col]))
+                        pivot = r;
+                if (std::fabs(M[pivot][col]) < 1e-12)
+                    return false;
+                if (pivot != col)
+                {
+                    std::swap_ranges(M[col], M[col] + 8, M[pivot]);
+                    std::swap(b[col], b[pivot]);
+                }
+                for (int r = col + 1; r < 8; ++r)
+                {
+                    double f = M[r][col] / M[col][col];
+                    for (int c = col; c < 8; ++c)
+                        M[r][c] -= f * M[col][c];
+                    b[r] -= f * b[col];
+                }
+            }
+            for (int r = 7; r >= 0; --r)
+            {
+                double acc = b[r];
+                for (int c = r + 1; c < 8; ++c)
+                    acc -= M[r][c] * x[c];
+                x[r] = acc / M[r][r];
+            }
+            return true;
+        }
+
+    } // namespace
+
+    bool solve_homography(const Point *src, const Point *dst, size_t n, double H[9])
+    {
+        if (!src || !dst || n < 4)
+            return false;
+
+        double Ts[9], Td[9];
+        normalization(src, n, Ts);
+        normalization(dst, n, Td);
+
+        // Normal equations of the 2n x 8 DLT system with h33 fixed to 1.
+        // For n == 4 this is the exact solve.
+        double AtA[8][8] = {};
+        double Atb[8] = {};
+        for (size_t i = 0; i < n; ++i)
+        {
+            double x = Ts[0] * src[i].x + Ts[2];
+            double y = Ts[4] * src[i].y + Ts[5];
+            double u = Td[0] * dst[i].x + Td[2];
+            double v = Td[4] * dst[i].y + Td[5];
+
+            const double r1[8] = {x, y, 1, 0, 0, 0, -u * x, -u * y};
+            const double r2[8] = {0, 0, 0, x, y, 1, -v * x, -v * y};
+            for (int a = 0; a < 8; ++a)
+            {
+                Atb[a] += r1[a] * u + r2[a] * v;
+                for (int b = 0; b < 8; ++b)
+                    AtA[a][b] += r1[a] * r1[b] + r2[a] * r2[b];
+            }
+        }
+
+        double h[8];
+        if (!solve8(AtA, Atb, h))
+            return false;
+
+        double Hn[9] = {h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7], 1.0};
+
+        // Denormalize: H = Td^-1 * Hn * Ts
+        double Td_inv[9];
+        if (!invert_homography(Td, Td_inv))
+            return false;
+        double tmp[9];
+        mat3_mul(Hn, Ts, tmp);
+        mat3_mul(Td_inv, tmp, H);
+
+        if (std::fabs(H[8]) < 1e-12)
+            return false;
+        double s = 1.0 / H[8];
+        for (int i = 0; i < 9; ++i)
+            H[i] *= s;
+        return true;
+    }
+
+    bool invert_homography(const double H[9], double out[9])
+    {
+        double a = H[0], b = H[1], c = H[2];
+        double d = H[3], e = H[4], f = H[5];
+        double g = H[6], h = H[7], i = H[8];
+
+        double A = e * i - f * h, B = -(d * i - f * g), C = d * h - e * g;
+        double det = a * A + b * B + c * C;
+        if (std::fabs(det) < 1e-15)
+            return false;
+        double inv = 1.0 / det;
+
+        out[0] = A * inv;
+        out[1] = -(b * i - c * h) * inv;
+        out[2] = (b * f - c * e) * inv;
+        out[3] = B * inv;
+        out[4] = (a * i - c * g) * inv;
+        out[5] = -(a * f - c * d) * inv;
+        out[6] = C * inv;
+        out[7] = -(a * h - b * g) * inv;
+        out[8] = (a * e - b * d) * inv;
+        return true;
+    }
+
+    bool apply_homography(const double H[9], double x, double y, double &ox, double &oy)
+    {
+        double w = H[6] * x + H[7] * y + H[8];
+        if (std::fabs(w) < 1e-12)
+            return false;
+        ox = (H[0] * x + H[1] * y + H[2]) / w;
+        oy = (H[3] * x + H[4] * y + H[5]) / w;
+        return true;
+    }
+
+    // ------------------------------------------------------------------------
+    // RemapGrid
+    // ------------------------------------------------------------------------
+
+    bool RemapGrid::build(const double H[9], uint32_t src_width, uint32_t src_height,
+                          uint32_t cell, bool fixed_point)
+    {
+        reset();
+        if (src_width < 2 || src_height < 2 || cell == 0)
+            return false;
+
+        // Nodes every `cell` pixels, with one extra so the last cell is whole
+        uint32_t cols = (src_width - 1) / cell + 2;
+        uint32_t rows = (src_height - 1) / cell + 2;
+
+        std::vector<float> nodes(static_cast<size_t>(cols) * rows * 2);
+        for (uint32_t r = 0; r < rows; ++r)
+        {
+            for (uint32_t c = 0; c < cols; ++c)
+            {
+                double px = 100.0 * (c * cell) / src_width;
+                double py = 100.0 * (r * cell) / src_height;
+                double ox, oy;
+                if (!apply_homography(H, px, py, ox, oy))
+                    return false; // line at infinity crosses the source
+                size_t idx = (static_cast<size_t>(r) * cols + c) * 2;
+                nodes[idx] = static_cast<float>(ox);
+                nodes[idx + 1] = static_cast<float>(oy);
+            }
+        }
+
+        if (fixed_point)
+        {
+            nodes_q_.resize(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i)
+                nodes_q_[i] = static_cast<int32_t>(std::lround(nodes[i] * 65536.0f));
+        }
+        else
+        {
+            nodes_f_ = std::move(nodes);
+        }
+
+        src_width_ = src_width;
+        src_height_ = src_height;
+        cell_ = cell;
+        cols_ = cols;
+        rows_ = rows;
+        fixed_point_ = fixed_point;
+        return true;
+    }
+
+    void RemapGrid::reset()
+    {
+        src_width_ = src_height_ = cell_ = cols_ = rows_ = 0;
+        fixed_point_ = false;
+        nodes_f_.clear();
+        nodes_q_.clear();
+    }
+
+    void RemapGrid::map(float px, float py, float &out_x, float &out_y) const
+    {
+        if (!valid())
+        {
+            out_x = px;
+            out_y = py;
+            return;
+        }
+
+        px = std::min(std::max(px, 0.0f), static_cast<float>(src_width_ - 1));
+        py = std::min(std::max(py, 0.0f), static_cast<float>(src_height_ - 1));
+
+        float gx = px / cell_;
+        float gy = py / cell_;
+        uint32_t c = std::min(static_cast<uint32_t>(gx), cols_ - 2);
+        uint32_t r = std::min(static_cast<uint32_t>(gy), rows_ - 2);
+        float tx = gx - c;
+        float ty = gy - r;
+
+        size_t i00 = (static_cast<size_t>(r) * cols_ + c) * 2;
+        size_t i01 = i00 + 2;
+        size_t i10 = i00 + static_cast<size_t>(cols_) * 2;
+        size_t i11 = i10 + 2;
+
+        if (fixed_point_)
+        {
+            // 8-bit fractional weights, 64-bit accumulators
+            int64_t wx = static_cast<int64_t>(tx * 256.0f);
+            int64_t wy = static_cast<int64_t>(ty * 256.0f);
+            const int32_t *q = nodes_q_.data();
+            for (int k = 0; k < 2; ++k)
+            {
+                int64_t top = q[i00 + k] * (256 - wx) + q[i01 + k] * wx;
+                int64_t bot = q[i10 + k] * (256 - wx) + q[i11 + k] * wx;
+                int64_t v = (top * (256 - wy) + bot * wy) >> 16;
+                (k == 0 ? out_x : out_y) = static_cast<float>(v) * (1.0f / 65536.0f);
+            }
+            return;
+        }
+
+        const float *f = nodes_f_.data();
+        for (int k = 0; k < 2; ++k)
+        {
+            float top = f[i00 + k] + (f[i01 + k] - f[i00 + k]) * tx;
+            float bot = f[i10 + k] + (f[i11 + k] - f[i10 + k]) * tx;
+            (k == 0 ? out_x : out_y) = top + (bot - top) * ty;
+        }
+    }
+
+} // namespace sketch
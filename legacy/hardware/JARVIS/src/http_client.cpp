@@ -1,16 +1,26 @@
 #include "http_client.hpp"
+#include "http_response_parser.hpp"
+#include "http_shared.hpp"
 
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <signal.h>
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <map>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -92,519 +102,868 @@ namespace
         return 0;
     }
 
-    static bool parse_http_response(const std::string &resp, std::string &body_out, int &status_out)
+
+    using Clock = std::chrono::steady_clock;
+
+    // Bodies up to this size go out in the same write as the headers
+    const size_t kCoalesceBody = 16 * 1024;
+
+    using http_shared::Address;
+
+    struct Connection
     {
-        // Find header/body separator \r\n\r\n
-        size_t pos = resp.find("\r\n\r\n");
-        if (pos == std::string::npos)
-            return false;
-        // Optionally validate status line starts with HTTP/1.1 200
-        size_t line_end = resp.find("\r\n");
-        if (line_end == std::string::npos)
-            return false;
-        std::string status = resp.substr(0, line_end);
-        // Extract numeric status code if present
-        status_out = 0;
+        int fd = -1;
+        SSL *ssl = nullptr;
+        Clock::time_point idle_since;
+        bool peer_closed = false; // last failure was EOF, a reset or a broken pipe
+    };
+
+    static bool peer_gone(int err)
+    {
+        return err == ECONNRESET || err == EPIPE;
+    }
+
+    static void close_connection(Connection &c)
+    {
+        if (c.ssl)
         {
-            size_t sp1 = status.find(' ');
-            if (sp1 != std::string::npos)
-            {
-                size_t sp2 = status.find(' ', sp1 + 1);
-                std::string code = (sp2 == std::string::npos) ? status.substr(sp1 + 1) : status.substr(sp1 + 1, sp2 - sp1 - 1);
-                try { status_out = std::stoi(code); } catch (...) { status_out = 0; }
-            }
+            SSL_shutdown(c.ssl);
+            SSL_free(c.ssl);
+            c.ssl = nullptr;
+        }
+        if (c.fd >= 0)
+        {
+            ::close(c.fd);
+            c.fd = -1;
         }
-        body_out = resp.substr(pos + 4);
-        return true;
     }
 
-} // namespace
-
-// use_tls: if true, initiate TLS over the connected socket (OpenSSL)
-std::string HttpClient::get(const std::string &host, uint16_t port, const std::string &path,
-                            int timeout_ms, bool use_tls)
-{
-    last_error_.clear();
-    const char *dbg_env = std::getenv("JARVIS_HTTP_DEBUG");
-    bool http_debug = dbg_env && *dbg_env;
-
-    // Resolve host
-    struct addrinfo hints;
-    std::memset(&hints, 0, sizeof(hints));
-    hints.ai_family = AF_UNSPEC; // allow IPv4 or IPv6
-    hints.ai_socktype = SOCK_STREAM;
-    struct addrinfo *res = nullptr;
-    std::string port_str = std::to_string(port);
-    int rc = getaddrinfo(host.c_str(), port_str.c_str(), &hints, &res);
-    if (rc != 0)
+    // An idle keep-alive socket has nothing to read; EOF or stray bytes mean
+    // the server has closed it (or broken framing), so it must not be reused
+    static bool idle_connection_usable(const Connection &c)
     {
-        last_error_ = std::string("getaddrinfo: ") + gai_strerror(rc);
-        return {};
+        struct pollfd pfd;
+        pfd.fd = c.fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        return poll(&pfd, 1, 0) == 0;
     }
 
-    int fd = -1;
-    for (struct addrinfo *p = res; p != nullptr; p = p->ai_next)
+    // Process-wide keep-alive connections, DNS results and TLS state
+    class ConnectionPool
     {
-        fd = ::socket(p->ai_family, p->ai_socktype, p->ai_protocol);
-        if (fd < 0)
-            continue;
-        if (!set_timeouts(fd, timeout_ms))
+    public:
+        static ConnectionPool &instance()
         {
-            last_error_ = "setsockopt timeouts failed";
-            ::close(fd);
-            fd = -1;
-            continue;
+            // Never destroyed: pooled SSL objects must not be freed after
+            // OpenSSL's own atexit cleanup has run
+            static ConnectionPool *pool = new ConnectionPool();
+            return *pool;
         }
-        if (connect_with_timeout(fd, p->ai_addr, p->ai_addrlen, timeout_ms) == 0)
+
+        HttpPoolConfig config()
         {
-            break; // connected
+            std::lock_guard<std::mutex> lock(mutex_);
+            return config_;
         }
-        else
+
+        void set_config(const HttpPoolConfig &config)
         {
-            // record which address we attempted for better diagnostics
-            char addrbuf[128] = {};
-            if (p->ai_family == AF_INET)
             {
-                struct sockaddr_in *sin = reinterpret_cast<struct sockaddr_in *>(p->ai_addr);
-                inet_ntop(AF_INET, &sin->sin_addr, addrbuf, sizeof(addrbuf));
+                std::lock_guard<std::mutex> lock(mutex_);
+                config_ = config;
             }
-            else if (p->ai_family == AF_INET6)
-            {
-                struct sockaddr_in6 *sin6 = reinterpret_cast<struct sockaddr_in6 *>(p->ai_addr);
-                inet_ntop(AF_INET6, &sin6->sin6_addr, addrbuf, sizeof(addrbuf));
-            }
-            last_error_ = std::string("connect failed to ") + addrbuf + ": " + std::strerror(errno);
-            ::close(fd);
-            fd = -1;
-            continue;
+            if (!config.keep_alive)
+                close_idle();
         }
-    }
-    freeaddrinfo(res);
 
-    if (fd < 0)
-    {
-        if (last_error_.empty())
-            last_error_ = "could not connect";
-        return {};
-    }
+        void note(uint64_t HttpPoolStats::*counter)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++(stats_.*counter);
+        }
 
-    // If TLS requested, create SSL objects
-    SSL_CTX *ctx = nullptr;
-    SSL *ssl = nullptr;
-    if (use_tls)
-    {
-        SSL_load_error_strings();
-        OpenSSL_add_ssl_algorithms();
-        ctx = SSL_CTX_new(TLS_client_method());
-        if (!ctx)
+        void note_cache(uint64_t HttpCacheStats::*counter, uint64_t amount = 1)
         {
-            last_error_ = "OpenSSL: SSL_CTX_new failed";
-            ::close(fd);
-            return {};
+            std::lock_guard<std::mutex> lock(mutex_);
+            cache_stats_.*counter += amount;
         }
-        ssl = SSL_new(ctx);
-        if (!ssl)
+
+        HttpCacheStats cache_stats()
         {
-            last_error_ = "OpenSSL: SSL_new failed";
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+            std::lock_guard<std::mutex> lock(mutex_);
+            return cache_stats_;
         }
-        if (!SSL_set_fd(ssl, fd))
+
+        HttpPoolStats stats()
         {
-            last_error_ = "OpenSSL: SSL_set_fd failed";
-            SSL_free(ssl);
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+            std::lock_guard<std::mutex> lock(mutex_);
+            HttpPoolStats out = stats_;
+            out.idle = 0;
+            for (const auto &entry : idle_)
+                out.idle += entry.second.size();
+            return out;
         }
-        // Set Server Name Indication (SNI) so TLS servers can route correctly
-        if (!SSL_set_tlsext_host_name(ssl, host.c_str()))
+
+        // Most recently used live connection for key, if any
+        bool acquire(const std::string &key, Connection &out)
         {
-            // Not fatal; continue but log to last_error_ for diagnostics
-            unsigned long err = ERR_get_error();
-            char buf[256];
-            ERR_error_string_n(err, buf, sizeof(buf));
-            last_error_ = std::string("SSL_set_tlsext_host_name warning: ") + buf;
+            std::vector<Connection> dead;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = idle_.find(key);
+                if (it == idle_.end())
+                    return false;
+                Clock::time_point now = Clock::now();
+                std::vector<Connection> &list = it->second;
+                while (!list.empty() && !found)
+                {
+                    Connection c = list.back();
+                    list.pop_back();
+                    if (now - c.idle_since > std::chrono::milliseconds(config_.idle_timeout_ms) ||
+                        !idle_connection_usable(c))
+                        dead.push_back(c);
+                    else
+                    {
+                        out = c;
+                        found = true;
+                    }
+                }
+                if (list.empty())
+                    idle_.erase(it);
+            }
+            for (Connection &c : dead)
+                close_connection(c);
+            return found;
         }
-        if (SSL_connect(ssl) != 1)
+
+        void release(const std::string &key, Connection c)
         {
-            unsigned long err = ERR_get_error();
-            char buf[256];
-            ERR_error_string_n(err, buf, sizeof(buf));
-            last_error_ = std::string("SSL_connect failed: ") + buf;
-            SSL_free(ssl);
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+            std::vector<Connection> evicted;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (config_.keep_alive && config_.max_idle_per_host > 0)
+                {
+                    c.idle_since = Clock::now();
+                    std::vector<Connection> &list = idle_[key];
+                    list.push_back(c);
+                    while (list.size() > config_.max_idle_per_host)
+                    {
+                        evicted.push_back(list.front());
+                        list.erase(list.begin());
+                    }
+                }
+                else
+                    evicted.push_back(c);
+            }
+            for (Connection &e : evicted)
+                close_connection(e);
         }
-    }
 
-    // Build request
-    std::ostringstream oss;
-    oss << "GET " << (path.empty() ? "/" : path) << " HTTP/1.1\r\n";
-    oss << "Host: " << host << ":" << port << "\r\n";
-    oss << "User-Agent: JARVIS/1.0\r\n";
-    oss << "Accept: application/json\r\n";
-    oss << "Connection: close\r\n\r\n";
-    std::string req = oss.str();
-    if (http_debug)
-    {
-        std::cerr << "[HttpClient] >>> GET " << (use_tls ? "https://" : "http://") << host << ":" << port << path << "\n";
-        std::cerr << "[HttpClient] >>> Request:\n" << req << "\n";
-    }
-    ssize_t sent = 0;
-    if (use_tls)
-    {
-        sent = SSL_write(ssl, req.data(), static_cast<int>(req.size()));
-        if (sent <= 0)
+        void close_idle()
         {
-            last_error_ = "SSL_write failed";
-            SSL_shutdown(ssl);
-            SSL_free(ssl);
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+            std::map<std::string, std::vector<Connection>> idle;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                idle.swap(idle_);
+            }
+            for (auto &entry : idle)
+                for (Connection &c : entry.second)
+                    close_connection(c);
         }
-    }
-    else
-    {
-        sent = ::send(fd, req.data(), req.size(), 0);
-        if (sent < 0)
+
+        void reset()
         {
-            last_error_ = std::string("send failed: ") + std::strerror(errno);
-            ::close(fd);
-            return {};
+            close_idle();
+            std::lock_guard<std::mutex> lock(mutex_);
+            dns_.clear();
+            for (auto &entry : sessions_)
+                SSL_SESSION_free(entry.second);
+            sessions_.clear();
+            stats_ = HttpPoolStats();
+            cache_stats_ = HttpCacheStats();
         }
-    }
 
-    std::string resp;
-    char buf[4096];
-    while (true)
-    {
-        ssize_t n = 0;
-        if (use_tls)
-            n = SSL_read(ssl, buf, sizeof(buf));
-        else
-            n = ::recv(fd, buf, sizeof(buf), 0);
+        bool resolve(const std::string &host, uint16_t port, std::vector<Address> &out, std::string &error)
+        {
+            std::string port_str = std::to_string(port);
+            std::string key = host + ":" + port_str;
+            int ttl_ms = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ttl_ms = config_.dns_ttl_ms;
+                auto it = dns_.find(key);
+                if (ttl_ms > 0 && it != dns_.end() && Clock::now() < it->second.expires)
+                {
+                    out = it->second.addresses;
+                    ++stats_.dns_cache_hits;
+                    return true;
+                }
+                ++stats_.dns_lookups;
+            }
+
+            struct addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC; // allow IPv4 or IPv6
+            hints.ai_socktype = SOCK_STREAM;
+            struct addrinfo *res = nullptr;
+            int rc = getaddrinfo(host.c_str(), port_str.c_str(), &hints, &res);
+            if (rc != 0)
+            {
+                error = std::string("getaddrinfo: ") + gai_strerror(rc);
+                return false;
+            }
+            out.clear();
+            for (struct addrinfo *p = res; p != nullptr; p = p->ai_next)
+            {
+                if (p->ai_addrlen > sizeof(Address::addr))
+                    continue;
+                Address a;
+                std::memcpy(&a.addr, p->ai_addr, p->ai_addrlen);
+                a.len = p->ai_addrlen;
+                a.family = p->ai_family;
+                a.socktype = p->ai_socktype;
+                a.protocol = p->ai_protocol;
+                out.push_back(a);
+            }
+            freeaddrinfo(res);
 
-        if (n > 0)
+            if (ttl_ms > 0 && !out.empty())
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                dns_[key] = DnsEntry{out, Clock::now() + std::chrono::milliseconds(ttl_ms)};
+            }
+            return true;
+        }
+
+        // None of the cached addresses answered; look the host up again next time
+        void forget_address(const std::string &host, uint16_t port)
         {
-            resp.append(buf, buf + n);
-            continue;
+            std::lock_guard<std::mutex> lock(mutex_);
+            dns_.erase(host + ":" + std::to_string(port));
         }
-        if (n == 0)
-            break; // EOF
 
-        // error
-        if (use_tls)
+        SSL_CTX *tls_context()
         {
-            int err = SSL_get_error(ssl, static_cast<int>(n));
-            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!ctx_)
             {
-                last_error_ = "SSL read timeout";
+                OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS | OPENSSL_INIT_LOAD_CRYPTO_STRINGS, nullptr);
+                ctx_ = SSL_CTX_new(TLS_client_method());
+                // Sessions are kept per host below, not in OpenSSL's cache
+                if (ctx_)
+                    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
             }
-            else
+            return ctx_;
+        }
+
+        void apply_session(const std::string &key, SSL *ssl)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sessions_.find(key);
+            if (it != sessions_.end())
+                SSL_set_session(ssl, it->second);
+        }
+
+        // Remember the session after a response: TLS 1.3 tickets arrive
+        // after the handshake, with the first application data
+        void save_session(const std::string &key, SSL *ssl)
+        {
+            SSL_SESSION *session = SSL_get1_session(ssl);
+            if (!session)
+                return;
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+            if (!SSL_SESSION_is_resumable(session))
             {
-                last_error_ = "SSL_read failed";
+                SSL_SESSION_free(session);
+                return;
             }
+#endif
+            std::lock_guard<std::mutex> lock(mutex_);
+            SSL_SESSION *&slot = sessions_[key];
+            if (slot)
+                SSL_SESSION_free(slot);
+            slot = session;
         }
-        else
+
+        void forget_session(const std::string &key)
         {
-            if (errno == EAGAIN || errno == EWOULDBLOCK)
-                last_error_ = "recv timeout";
-            else
-                last_error_ = std::string("recv failed: ") + std::strerror(errno);
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = sessions_.find(key);
+            if (it == sessions_.end())
+                return;
+            SSL_SESSION_free(it->second);
+            sessions_.erase(it);
         }
-        break;
-    }
-
-    if (use_tls)
-    {
-        SSL_shutdown(ssl);
-        SSL_free(ssl);
-        SSL_CTX_free(ctx);
-    }
-    ::close(fd);
 
-    int status = 0;
-    std::string body;
-    if (!parse_http_response(resp, body, status))
-    {
-        last_error_ = "invalid HTTP response";
-        if (http_debug)
+    private:
+        ConnectionPool()
         {
-            std::cerr << "[HttpClient] <<< Invalid HTTP response (raw length=" << resp.size() << "):\n";
-            std::cerr << resp << "\n";
+            // Writing to a pooled socket the server has already closed must
+            // fail with EPIPE, not kill the process
+            struct sigaction sa;
+            if (sigaction(SIGPIPE, nullptr, &sa) == 0 && sa.sa_handler == SIG_DFL)
+                signal(SIGPIPE, SIG_IGN);
         }
-        return {};
-    }
-    if (http_debug)
-    {
-        std::cerr << "[HttpClient] <<< Response status=" << status << " body_len=" << body.size() << "\n";
-        // Print a truncated body for readability
-        std::string body_snip = body.substr(0, std::min<size_t>(body.size(), 4096));
-        std::cerr << "[HttpClient] <<< Body (first " << body_snip.size() << " bytes):\n" << body_snip << "\n";
-    }
-    if (status < 200 || status >= 300)
-    {
-        last_error_ = std::string("HTTP error: ") + std::to_string(status) + " body=" + body;
-        return {};
-    }
-    return body;
-}
 
-std::string HttpClient::post(const std::string &host, uint16_t port, const std::string &path,
-                            const std::string &body, const std::string &content_type,
-                            int timeout_ms, bool use_tls)
-{
-    last_error_.clear();
-    const char *dbg_env = std::getenv("JARVIS_HTTP_DEBUG");
-    bool http_debug = dbg_env && *dbg_env;
+        struct DnsEntry
+        {
+            std::vector<Address> addresses;
+            Clock::time_point expires;
+        };
 
-    // Resolve host
-    struct addrinfo hints;
-    std::memset(&hints, 0, sizeof(hints));
-    hints.ai_family = AF_UNSPEC; // allow IPv4 or IPv6
-    hints.ai_socktype = SOCK_STREAM;
-    struct addrinfo *res = nullptr;
-    std::string port_str = std::to_string(port);
-    int rc = getaddrinfo(host.c_str(), port_str.c_str(), &hints, &res);
-    if (rc != 0)
-    {
-        last_error_ = std::string("getaddrinfo: ") + gai_strerror(rc);
-        return {};
-    }
+        std::mutex mutex_;
+        HttpPoolConfig config_;
+        HttpPoolStats stats_;
+        HttpCacheStats cache_stats_;
+        std::map<std::string, std::vector<Connection>> idle_; // oldest first
+        std::map<std::string, DnsEntry> dns_;
+        std::map<std::string, SSL_SESSION *> sessions_;
+        SSL_CTX *ctx_ = nullptr;
+    };
 
-    int fd = -1;
-    for (struct addrinfo *p = res; p != nullptr; p = p->ai_next)
+    static bool open_connection(const std::string &host, uint16_t port, bool use_tls, int timeout_ms,
+                                const std::string &key, Connection &conn, std::string &error)
     {
-        fd = ::socket(p->ai_family, p->ai_socktype, p->ai_protocol);
-        if (fd < 0)
-            continue;
-        if (!set_timeouts(fd, timeout_ms))
+        ConnectionPool &pool = ConnectionPool::instance();
+        std::vector<Address> addresses;
+        if (!pool.resolve(host, port, addresses, error))
+            return false;
+
+        int fd = -1;
+        for (const Address &a : addresses)
         {
-            last_error_ = "setsockopt timeouts failed";
+            fd = ::socket(a.family, a.socktype, a.protocol);
+            if (fd < 0)
+                continue;
+            if (!set_timeouts(fd, timeout_ms))
+            {
+                error = "setsockopt timeouts failed";
+                ::close(fd);
+                fd = -1;
+                continue;
+            }
+            if (connect_with_timeout(fd, reinterpret_cast<const struct sockaddr *>(&a.addr), a.len, timeout_ms) == 0)
+                break; // connected
+            // record which address we attempted for better diagnostics
+            error = std::string("connect failed to ") + http_shared::address_string(a) + ": " + std::strerror(errno);
             ::close(fd);
             fd = -1;
-            continue;
         }
-        if (connect_with_timeout(fd, p->ai_addr, p->ai_addrlen, timeout_ms) == 0)
+        if (fd < 0)
         {
-            break; // connected
+            pool.forget_address(host, port);
+            if (error.empty())
+                error = "could not connect";
+            return false;
         }
-        else
+        // Headers and body may go out in separate writes; don't let Nagle
+        // hold the second one back on a reused connection
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pool.note(&HttpPoolStats::connects);
+        conn.fd = fd;
+
+        if (!use_tls)
+            return true;
+
+        SSL_CTX *ctx = pool.tls_context();
+        if (!ctx)
         {
-            char addrbuf[128] = {};
-            if (p->ai_family == AF_INET)
+            error = "OpenSSL: SSL_CTX_new failed";
+            close_connection(conn);
+            return false;
+        }
+        conn.ssl = SSL_new(ctx);
+        if (!conn.ssl)
+        {
+            error = "OpenSSL: SSL_new failed";
+            close_connection(conn);
+            return false;
+        }
+        if (!SSL_set_fd(conn.ssl, fd))
+        {
+            error = "OpenSSL: SSL_set_fd failed";
+            close_connection(conn);
+            return false;
+        }
+        // Set Server Name Indication (SNI) so TLS servers can route correctly
+        SSL_set_tlsext_host_name(conn.ssl, host.c_str());
+        pool.apply_session(key, conn.ssl);
+        if (SSL_connect(conn.ssl) != 1)
+        {
+            unsigned long err = ERR_get_error();
+            char buf[256];
+            ERR_error_string_n(err, buf, sizeof(buf));
+            error = std::string("SSL_connect failed: ") + buf;
+            SSL_free(conn.ssl); // no shutdown: the handshake never finished
+            conn.ssl = nullptr;
+            close_connection(conn);
+            pool.forget_session(key);
+            return false;
+        }
+        pool.note(&HttpPoolStats::tls_handshakes);
+        if (SSL_session_reused(conn.ssl))
+            pool.note(&HttpPoolStats::tls_resumed);
+        return true;
+    }
+
+    static bool write_all(Connection &c, const char *data, size_t size, std::string &error)
+    {
+        while (size > 0)
+        {
+            if (c.ssl)
             {
-                struct sockaddr_in *sin = reinterpret_cast<struct sockaddr_in *>(p->ai_addr);
-                inet_ntop(AF_INET, &sin->sin_addr, addrbuf, sizeof(addrbuf));
+                int sent = SSL_write(c.ssl, data, static_cast<int>(size));
+                if (sent <= 0)
+                {
+                    c.peer_closed = SSL_get_error(c.ssl, sent) == SSL_ERROR_SYSCALL && peer_gone(errno);
+                    error = "SSL_write failed";
+                    return false;
+                }
+                size -= static_cast<size_t>(sent);
+                data += sent;
             }
-            else if (p->ai_family == AF_INET6)
+            else
             {
-                struct sockaddr_in6 *sin6 = reinterpret_cast<struct sockaddr_in6 *>(p->ai_addr);
-                inet_ntop(AF_INET6, &sin6->sin6_addr, addrbuf, sizeof(addrbuf));
+                ssize_t sent = ::send(c.fd, data, size, MSG_NOSIGNAL);
+                if (sent < 0)
+                {
+                    c.peer_closed = peer_gone(errno);
+                    error = std::string("send failed: ") + std::strerror(errno);
+                    return false;
+                }
+                size -= static_cast<size_t>(sent);
+                data += sent;
             }
-            last_error_ = std::string("connect failed to ") + addrbuf + ": " + std::strerror(errno);
-            ::close(fd);
-            fd = -1;
-            continue;
         }
+        return true;
     }
-    freeaddrinfo(res);
 
-    if (fd < 0)
+    // Servers that write headers and body separately with Nagle on stall
+    // until we ACK the first part; delayed ACK would make that ~40 ms per
+    // response on a kept-alive connection. The kernel clears the flag
+    // again, so it is set before every read.
+    static void ack_immediately(int fd)
     {
-        if (last_error_.empty())
-            last_error_ = "could not connect";
-        return {};
+#ifdef TCP_QUICKACK
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one));
+#else
+        (void)fd;
+#endif
     }
 
-    // If TLS requested, create SSL objects
-    SSL_CTX *ctx = nullptr;
-    SSL *ssl = nullptr;
-    if (use_tls)
+    // > 0 bytes read, 0 on EOF, < 0 on error (error set)
+    static ssize_t read_some(Connection &c, char *buf, size_t size, std::string &error)
     {
-        SSL_load_error_strings();
-        OpenSSL_add_ssl_algorithms();
-        ctx = SSL_CTX_new(TLS_client_method());
-        if (!ctx)
-        {
-            last_error_ = "OpenSSL: SSL_CTX_new failed";
-            ::close(fd);
-            return {};
+        ack_immediately(c.fd);
+        if (c.ssl)
+        {
+            int n = SSL_read(c.ssl, buf, static_cast<int>(size));
+            if (n > 0)
+                return n;
+            int err = SSL_get_error(c.ssl, n);
+            if (err == SSL_ERROR_ZERO_RETURN)
+                return 0;
+            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+                error = "SSL read timeout";
+            else if (err == SSL_ERROR_SYSCALL && n == 0)
+                return 0; // peer closed without close_notify
+            else
+            {
+                c.peer_closed = err == SSL_ERROR_SYSCALL && peer_gone(errno);
+                error = "SSL_read failed";
+            }
+            return -1;
         }
-        ssl = SSL_new(ctx);
-        if (!ssl)
+        ssize_t n = ::recv(c.fd, buf, size, 0);
+        if (n >= 0)
+            return n;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            error = "recv timeout";
+        else
         {
-            last_error_ = "OpenSSL: SSL_new failed";
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+            c.peer_closed = peer_gone(errno);
+            error = std::string("recv failed: ") + std::strerror(errno);
         }
-        if (!SSL_set_fd(ssl, fd))
-        {
-            last_error_ = "OpenSSL: SSL_set_fd failed";
-            SSL_free(ssl);
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+        return -1;
+    }
+
+    // Read one response into parser. The connection stays reusable only if
+    // the body was framed (Content-Length or chunked), the server keeps it
+    // open and nothing arrived past the end of the response.
+    static bool read_response(Connection &c, HttpResponseParser &parser, bool &reusable, std::string &error)
+    {
+        reusable = false;
+        char buf[16384];
+        bool surplus = false;
+        while (!parser.done())
+        {
+            ssize_t n = read_some(c, buf, sizeof(buf), error);
+            if (n < 0)
+                return false;
+            if (n == 0)
+            {
+                c.peer_closed = parser.bytes_fed() == 0;
+                parser.finish_eof();
+                break;
+            }
+            size_t used = parser.feed(buf, static_cast<size_t>(n));
+            if (parser.failed())
+                break;
+            surplus = used < static_cast<size_t>(n);
         }
-        if (SSL_connect(ssl) != 1)
+        if (!parser.done())
         {
-            unsigned long err = ERR_get_error();
-            char buf[256];
-            ERR_error_string_n(err, buf, sizeof(buf));
-            last_error_ = std::string("SSL_connect failed: ") + buf;
-            SSL_free(ssl);
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+            error = parser.error();
+            return false;
         }
+        reusable = parser.keep_alive() && parser.framing() != HttpResponseParser::Framing::UNTIL_EOF && !surplus;
+        return true;
     }
 
+} // namespace
+
+bool HttpClient::request(const char *method, const std::string &host, uint16_t port, const std::string &path,
+                         const std::string *body, const std::string &content_type, int timeout_ms, bool use_tls,
+                         std::string *into, const BodyCallback &on_data, HttpValidators *validators)
+{
+    last_error_.clear();
+    last_status_ = 0;
+    const char *dbg_env = std::getenv("JARVIS_HTTP_DEBUG");
+    bool http_debug = dbg_env && *dbg_env;
+
+    ConnectionPool &pool = ConnectionPool::instance();
+    pool.note(&HttpPoolStats::requests);
+    bool keep_alive = pool.config().keep_alive;
+    std::string key = std::string(use_tls ? "https://" : "http://") + host + ":" + std::to_string(port);
+
     // Build request
     std::ostringstream oss;
-    oss << "POST " << (path.empty() ? "/" : path) << " HTTP/1.1\r\n";
+    oss << method << " " << (path.empty() ? "/" : path) << " HTTP/1.1\r\n";
     oss << "Host: " << host << ":" << port << "\r\n";
     oss << "User-Agent: JARVIS/1.0\r\n";
     oss << "Accept: application/json\r\n";
-    oss << "Content-Type: " << content_type << "\r\n";
-    oss << "Content-Length: " << body.size() << "\r\n";
-    oss << "Connection: close\r\n\r\n";
-    std::string header = oss.str();
-
-    if (http_debug)
+    if (validators)
+    {
+        if (!validators->etag.empty())
+            oss << "If-None-Match: " << validators->etag << "\r\n";
+        if (!validators->last_modified.empty())
+            oss << "If-Modified-Since: " << validators->last_modified << "\r\n";
+    }
+    if (body)
     {
-        std::cerr << "[HttpClient] >>> POST " << (use_tls ? "https://" : "http://") << host << ":" << port << path << "\n";
-        std::cerr << "[HttpClient] >>> Headers:\n" << header << "\n";
-        std::string body_snip = body.substr(0, std::min<size_t>(body.size(), 8192));
-        std::cerr << "[HttpClient] >>> Body (first " << body_snip.size() << " bytes):\n" << body_snip << "\n";
+        oss << "Content-Type: " << content_type << "\r\n";
+        oss << "Content-Length: " << body->size() << "\r\n";
     }
+    oss << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+    std::string req = oss.str();
 
-    // send header + body (using SSL if requested)
-    if (use_tls)
+    if (http_debug)
     {
-        ssize_t s = SSL_write(ssl, header.data(), static_cast<int>(header.size()));
-        if (s <= 0)
+        std::cerr << "[HttpClient] >>> " << method << " " << (use_tls ? "https://" : "http://") << host << ":" << port << path << "\n";
+        std::cerr << "[HttpClient] >>> Headers:\n" << req << "\n";
+        if (body)
         {
-            last_error_ = "SSL_write(header) failed";
-            SSL_shutdown(ssl);
-            SSL_free(ssl);
-            SSL_CTX_free(ctx);
-            ::close(fd);
-            return {};
+            std::string body_snip = body->substr(0, std::min<size_t>(body->size(), 8192));
+            std::cerr << "[HttpClient] >>> Body (first " << body_snip.size() << " bytes):\n" << body_snip << "\n";
         }
-        size_t to_send = body.size();
-        const char *ptr = body.data();
-        while (to_send > 0)
-        {
-            int sent = SSL_write(ssl, ptr, static_cast<int>(to_send));
-            if (sent <= 0)
+    }
+
+    bool body_separate = body && body->size() > kCoalesceBody;
+    if (body && !body_separate)
+        req += *body;
+
+    // Bodies of successful responses go to the caller (callback, or
+    // straight into *into); error bodies are kept for last_error_
+    HttpResponseParser parser(std::strcmp(method, "HEAD") == 0);
+    std::string error_body;
+    if (on_data)
+        parser.set_body_sink([&](const char *data, size_t size) {
+            if (parser.status() < 200 || parser.status() >= 300)
             {
-                last_error_ = "SSL_write(body) failed";
-                SSL_shutdown(ssl);
-                SSL_free(ssl);
-                SSL_CTX_free(ctx);
-                ::close(fd);
-                return {};
+                error_body.append(data, size);
+                return true;
+            }
+            return on_data(data, size);
+        });
+    if (into)
+        parser.body().swap(*into); // reuse the caller's capacity
+
+    bool done = false;
+    // A pooled connection can be closed by the server while idle; that
+    // shows up as EOF, a reset or a broken pipe before any response byte
+    // and is retried once on a fresh connection. Anything else, a timeout
+    // above all, may mean the server already acted on the request.
+    for (int attempt = 0; attempt < 2 && !done; ++attempt)
+    {
+        Connection conn;
+        bool reused = attempt == 0 && keep_alive && pool.acquire(key, conn);
+        if (reused)
+        {
+            set_timeouts(conn.fd, timeout_ms);
+            pool.note(&HttpPoolStats::reuses);
+        }
+        else if (!open_connection(host, port, use_tls, timeout_ms, key, conn, last_error_))
+            break;
+
+        parser.reset(std::strcmp(method, "HEAD") == 0);
+        std::string error;
+        bool reusable = false;
+        bool ok = write_all(conn, req.data(), req.size(), error) &&
+                  (!body_separate || write_all(conn, body->data(), body->size(), error)) &&
+                  read_response(conn, parser, reusable, error);
+        if (!ok)
+        {
+            close_connection(conn);
+            if (reused && conn.peer_closed && parser.bytes_fed() == 0)
+            {
+                pool.note(&HttpPoolStats::retries);
+                continue;
             }
-            to_send -= static_cast<size_t>(sent);
-            ptr += sent;
+            last_error_ = error;
+            if (http_debug)
+                std::cerr << "[HttpClient] <<< " << error << " after " << parser.bytes_fed() << " bytes\n";
+            break;
         }
+
+        if (conn.ssl)
+            pool.save_session(key, conn.ssl);
+        if (keep_alive && reusable)
+            pool.release(key, conn);
+        else
+            close_connection(conn);
+        done = true;
     }
-    else
+
+    if (into)
     {
-        ssize_t sent = ::send(fd, header.data(), header.size(), 0);
-        if (sent < 0)
+        into->swap(parser.body());
+        if (!done)
+            into->clear();
+    }
+    if (!done)
+        return false;
+
+    last_status_ = parser.status();
+    if (http_debug)
+    {
+        std::cerr << "[HttpClient] <<< Response status=" << parser.status() << " body_len=" << parser.body_bytes() << "\n";
+        if (into)
         {
-            last_error_ = std::string("send header failed: ") + std::strerror(errno);
-            ::close(fd);
-            return {};
+            // Print a truncated body for readability
+            std::string body_snip = into->substr(0, std::min<size_t>(into->size(), 4096));
+            std::cerr << "[HttpClient] <<< Body (first " << body_snip.size() << " bytes):\n" << body_snip << "\n";
         }
-        size_t to_send = body.size();
-        const char *ptr = body.data();
-        while (to_send > 0)
+    }
+    if (validators && parser.status() == 304)
+        return true;
+    if (parser.status() < 200 || parser.status() >= 300)
+    {
+        if (into)
         {
-            ssize_t s = ::send(fd, ptr, to_send, 0);
-            if (s < 0)
-            {
-                last_error_ = std::string("send body failed: ") + std::strerror(errno);
-                ::close(fd);
-                return {};
-            }
-            to_send -= static_cast<size_t>(s);
-            ptr += s;
+            error_body.swap(*into);
+            into->clear();
         }
+        last_error_ = std::string("HTTP error: ") + std::to_string(parser.status()) + " body=" + error_body;
+        return false;
+    }
+    if (validators)
+    {
+        validators->etag = parser.header("etag");
+        validators->last_modified = parser.header("last-modified");
+        validators->size = parser.body_bytes();
     }
+    return true;
+}
+
+// use_tls: if true, initiate TLS over the connected socket (OpenSSL)
+std::string HttpClient::get(const std::string &host, uint16_t port, const std::string &path,
+                            int timeout_ms, bool use_tls)
+{
+    std::string out;
+    request("GET", host, port, path, nullptr, std::string(), timeout_ms, use_tls, &out, BodyCallback());
+    return out;
+}
+
+std::string HttpClient::post(const std::string &host, uint16_t port, const std::string &path,
+                             const std::string &body, const std::string &content_type,
+                             int timeout_ms, bool use_tls)
+{
+    std::string out;
+    request("POST", host, port, path, &body, content_type, timeout_ms, use_tls, &out, BodyCallback());
+    return out;
+}
+
+bool HttpClient::get_into(const std::string &host, uint16_t port, const std::string &path, std::string &out,
+                          int timeout_ms, bool use_tls)
+{
+    return request("GET", host, port, path, nullptr, std::string(), timeout_ms, use_tls, &out, BodyCallback());
+}
+
+HttpFetch HttpClient::get_if_modified(const std::string &host, uint16_t port, const std::string &path,
+                                     HttpValidators &validators, std::string &out, int timeout_ms, bool use_tls)
+{
+    HttpValidators sent = validators;
+    std::string body;
+    if (!request("GET", host, port, path, nullptr, std::string(), timeout_ms, use_tls, &body, BodyCallback(),
+                 &sent))
+        return HttpFetch::FAILED;
 
-    std::string resp;
-    char buf[4096];
-    while (true)
+    ConnectionPool &pool = ConnectionPool::instance();
+    if (last_status_ == 304)
     {
-        ssize_t n = 0;
-        if (use_tls)
-            n = SSL_read(ssl, buf, sizeof(buf));
-        else
-            n = ::recv(fd, buf, sizeof(buf), 0);
+        pool.note_cache(&HttpCacheStats::hits);
+        pool.note_cache(&HttpCacheStats::bytes_saved, validators.size);
+        return HttpFetch::NOT_MODIFIED;
+    }
+    pool.note_cache(&HttpCacheStats::misses);
+    pool.note_cache(&HttpCacheStats::bytes_downloaded, body.size());
+    validators = sent;
+    out.swap(body);
+    return HttpFetch::MODIFIED;
+}
 
-        if (n > 0)
-        {
-            resp.append(buf, buf + n);
+bool HttpClient::get_stream(const std::string &host, uint16_t port, const std::string &path,
+                            const BodyCallback &on_data, int timeout_ms, bool use_tls)
+{
+    return request("GET", host, port, path, nullptr, std::string(), timeout_ms, use_tls, nullptr, on_data);
+}
+
+void HttpClient::set_pool_config(const HttpPoolConfig &config)
+{
+    ConnectionPool::instance().set_config(config);
+}
+
+HttpPoolConfig HttpClient::pool_config()
+{
+    return ConnectionPool::instance().config();
+}
+
+HttpPoolStats HttpClient::pool_stats()
+{
+    return ConnectionPool::instance().stats();
+}
+
+HttpCacheStats HttpClient::cache_stats()
+{
+    return ConnectionPool::instance().cache_stats();
+}
+
+bool HttpValidators::load(const std::string &path)
+{
+    *this = HttpValidators();
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+    char line[1024];
+    while (std::fgets(line, sizeof(line), f))
+    {
+        std::string text(line);
+        while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+            text.pop_back();
+        auto colon = text.find(": ");
+        if (colon == std::string::npos)
             continue;
-        }
-        if (n == 0)
-            break; // EOF
+        std::string name = text.substr(0, colon);
+        std::string value = text.substr(colon + 2);
+        if (name == "etag")
+            etag = value;
+        else if (name == "last-modified")
+            last_modified = value;
+        else if (name == "size")
+            size = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    std::fclose(f);
+    return !empty();
+}
+
+bool HttpValidators::save(const std::string &path) const
+{
+    if (empty())
+    {
+        ::unlink(path.c_str());
+        return true;
+    }
+    std::string tmp = path + ".tmp";
+    FILE *f = std::fopen(tmp.c_str(), "wb");
+    if (!f)
+        return false;
+    std::string text;
+    if (!etag.empty())
+        text += "etag: " + etag + "\n";
+    if (!last_modified.empty())
+        text += "last-modified: " + last_modified + "\n";
+    text += "size: " + std::to_string(size) + "\n";
+    bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        ::unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void HttpClient::close_idle_connections()
+{
+    ConnectionPool::instance().close_idle();
+}
 
-        if (use_tls)
+void HttpClient::reset_pool()
+{
+    ConnectionPool::instance().reset();
+}
+
+namespace http_shared
+{
+
+    bool resolve(const std::string &host, uint16_t port, std::vector<Address> &out, std::string &error)
+    {
+        return ConnectionPool::instance().resolve(host, port, out, error);
+    }
+
+    void forget_address(const std::string &host, uint16_t port)
+    {
+        ConnectionPool::instance().forget_address(host, port);
+    }
+
+    std::string address_string(const Address &a)
+    {
+        char addrbuf[128] = {};
+        if (a.family == AF_INET)
         {
-            int err = SSL_get_error(ssl, static_cast<int>(n));
-            if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
-                last_error_ = "SSL read timeout";
-            else
-                last_error_ = "SSL_read failed";
+            const struct sockaddr_in *sin = reinterpret_cast<const struct sockaddr_in *>(&a.addr);
+            inet_ntop(AF_INET, &sin->sin_addr, addrbuf, sizeof(addrbuf));
         }
-        else
+        else if (a.family == AF_INET6)
         {
-            if (errno == EAGAIN || errno == EWOULDBLOCK)
-                last_error_ = "recv timeout";
-            else
-                last_error_ = std::string("recv failed: ") + std::strerror(errno);
+            const struct sockaddr_in6 *sin6 = reinterpret_cast<const struct sockaddr_in6 *>(&a.addr);
+            inet_ntop(AF_INET6, &sin6->sin6_addr, addrbuf, sizeof(addrbuf));
         }
-        break;
+        return addrbuf;
     }
 
-    if (use_tls)
+    SSL_CTX *tls_context()
     {
-        SSL_shutdown(ssl);
-        SSL_free(ssl);
-        SSL_CTX_free(ctx);
+        return ConnectionPool::instance().tls_context();
     }
-    ::close(fd);
 
-    int status = 0;
-    std::string body_out;
-    if (!parse_http_response(resp, body_out, status))
+    void apply_session(const std::string &key, SSL *ssl)
     {
-        last_error_ = "invalid HTTP response";
-        if (http_debug)
-        {
-            std::cerr << "[HttpClient] <<< Invalid HTTP response (raw length=" << resp.size() << "):\n";
-            std::cerr << resp << "\n";
-        }
-        return {};
+        ConnectionPool::instance().apply_session(key, ssl);
     }
-    if (http_debug)
+
+    void save_session(const std::string &key, SSL *ssl)
     {
-        std::cerr << "[HttpClient] <<< Response status=" << status << " body_len=" << body_out.size() << "\n";
-        std::string body_snip = body_out.substr(0, std::min<size_t>(body_out.size(), 4096));
-        std::cerr << "[HttpClient] <<< Body (first " << body_snip.size() << " bytes):\n" << body_snip << "\n";
+        ConnectionPool::instance().save_session(key, ssl);
     }
-    if (status < 200 || status >= 300)
+
+    void forget_session(const std::string &key)
     {
-        last_error_ = std::string("HTTP error: ") + std::to_string(status) + " body=" + body_out;
-        return {};
+        ConnectionPool::instance().forget_session(key);
     }
-    return body_out;
-}
+
+} // namespace http_shared
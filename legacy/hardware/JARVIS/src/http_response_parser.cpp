@@ -0,0 +1,308 @@
+#include "http_response_parser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    // Status line, header or chunk-size line
+    const size_t kMaxLine = 16 * 1024;
+    const size_t kMaxHeaders = 100;
+    // Content-Length is only a hint until the bytes arrive
+    const size_t kMaxReserve = 256 * 1024;
+
+    static std::string lowercase(std::string s)
+    {
+        for (char &ch : s)
+            ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        return s;
+    }
+
+    static bool has_token(const std::string &lower_value, const char *token)
+    {
+        return lower_value.find(token) != std::string::npos;
+    }
+}
+
+void HttpResponseParser::reset(bool head_request)
+{
+    state_ = State::STATUS_LINE;
+    head_request_ = head_request;
+    headers_complete_ = false;
+    status_ = 0;
+    minor_ = 1;
+    headers_.clear();
+    framing_ = Framing::NONE;
+    content_length_ = -1;
+    keep_alive_ = false;
+    remaining_ = 0;
+    line_.clear();
+    body_.clear();
+    error_.clear();
+    bytes_fed_ = 0;
+    body_bytes_ = 0;
+}
+
+const std::string &HttpResponseParser::header(const char *lower_name) const
+{
+    static const std::string empty;
+    for (const auto &h : headers_)
+        if (h.first == lower_name)
+            return h.second;
+    return empty;
+}
+
+void HttpResponseParser::fail(const char *message)
+{
+    state_ = State::FAILED;
+    error_ = message;
+}
+
+bool HttpResponseParser::emit(const char *data, size_t size)
+{
+    body_bytes_ += size;
+    if (!sink_)
+    {
+        if (body_.size() + size > max_body_)
+        {
+            fail("HTTP body too large");
+            return false;
+        }
+        body_.append(data, size);
+        return true;
+    }
+    if (!sink_(data, size))
+    {
+        fail("body sink aborted");
+        return false;
+    }
+    return true;
+}
+
+bool HttpResponseParser::take_line(const char *&p, const char *end)
+{
+    const char *nl = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+    const char *stop = nl ? nl : end;
+    if (line_.size() + static_cast<size_t>(stop - p) > kMaxLine)
+    {
+        fail("HTTP line too long");
+        return false;
+    }
+    line_.append(p, stop);
+    p = nl ? nl + 1 : end;
+    if (!nl)
+        return false;
+    if (!line_.empty() && line_.back() == '\r')
+        line_.pop_back();
+    return true;
+}
+
+bool HttpResponseParser::on_status_line()
+{
+    // HTTP/1.1 200 OK
+    if (line_.compare(0, 7, "HTTP/1.") != 0 || line_.size() < 12 || line_[8] != ' ')
+    {
+        fail("invalid HTTP response");
+        return false;
+    }
+    minor_ = line_[7] - '0';
+    status_ = std::atoi(line_.c_str() + 9);
+    keep_alive_ = minor_ >= 1;
+    return true;
+}
+
+bool HttpResponseParser::on_header_line()
+{
+    size_t colon = line_.find(':');
+    if (colon == std::string::npos || colon == 0)
+        return true; // tolerate junk lines, as the old parser did
+    if (headers_.size() >= kMaxHeaders)
+    {
+        fail("too many HTTP headers");
+        return false;
+    }
+    std::string name = lowercase(line_.substr(0, colon));
+    size_t v = line_.find_first_not_of(" \t", colon + 1);
+    size_t e = line_.find_last_not_of(" \t");
+    std::string value = (v == std::string::npos) ? std::string() : line_.substr(v, e - v + 1);
+
+    if (name == "content-length")
+    {
+        char *endp = nullptr;
+        long long n = std::strtoll(value.c_str(), &endp, 10);
+        if (endp == value.c_str() || n < 0)
+        {
+            fail("invalid Content-Length");
+            return false;
+        }
+        content_length_ = n;
+    }
+    else if (name == "transfer-encoding")
+    {
+        if (has_token(lowercase(value), "chunked"))
+            framing_ = Framing::CHUNKED;
+    }
+    else if (name == "connection")
+    {
+        std::string token = lowercase(value);
+        if (has_token(token, "close"))
+            keep_alive_ = false;
+        else if (has_token(token, "keep-alive"))
+            keep_alive_ = true;
+    }
+    headers_.emplace_back(std::move(name), std::move(value));
+    return true;
+}
+
+bool HttpResponseParser::on_headers_done()
+{
+    // Interim 1xx responses precede the real one
+    if (status_ >= 100 && status_ < 200 && status_ != 101)
+    {
+        uint64_t fed = bytes_fed_;
+        reset(head_request_);
+        bytes_fed_ = fed;
+        return true;
+    }
+
+    headers_complete_ = true;
+    if (head_request_ || status_ == 204 || status_ == 304 || status_ == 101)
+    {
+        framing_ = Framing::NONE;
+        state_ = State::DONE;
+        return true;
+    }
+    if (framing_ == Framing::CHUNKED)
+    {
+        // Chunked wins over any Content-Length (RFC 7230 3.3.3)
+        content_length_ = -1;
+        state_ = State::CHUNK_SIZE;
+        return true;
+    }
+    if (content_length_ >= 0)
+    {
+        framing_ = Framing::CONTENT_LENGTH;
+        remaining_ = static_cast<uint64_t>(content_length_);
+        if (!sink_)
+        {
+            if (remaining_ > max_body_)
+            {
+                fail("HTTP body too large");
+                return false;
+            }
+            body_.reserve(static_cast<size_t>(std::min<uint64_t>(remaining_, kMaxReserve)));
+        }
+        state_ = remaining_ ? State::BODY : State::DONE;
+        return true;
+    }
+    framing_ = Framing::UNTIL_EOF;
+    keep_alive_ = false;
+    state_ = State::BODY;
+    return true;
+}
+
+size_t HttpResponseParser::feed(const char *data, size_t size)
+{
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end)
+    {
+        switch (state_)
+        {
+        case State::DONE:
+        case State::FAILED:
+            bytes_fed_ += static_cast<uint64_t>(p - data);
+            return static_cast<size_t>(p - data);
+
+        case State::STATUS_LINE:
+            if (!take_line(p, end))
+                break;
+            if (on_status_line())
+                state_ = State::HEADERS;
+            line_.clear();
+            break;
+
+        case State::HEADERS:
+            if (!take_line(p, end))
+                break;
+            if (line_.empty())
+                on_headers_done();
+            else
+                on_header_line();
+            line_.clear();
+            break;
+
+        case State::BODY:
+        {
+            size_t n = static_cast<size_t>(end - p);
+            if (framing_ == Framing::CONTENT_LENGTH)
+                n = static_cast<size_t>(std::min<uint64_t>(n, remaining_));
+            if (!emit(p, n))
+                break;
+            p += n;
+            if (framing_ == Framing::CONTENT_LENGTH && (remaining_ -= n) == 0)
+                state_ = State::DONE;
+            break;
+        }
+
+        case State::CHUNK_SIZE:
+        {
+            if (!take_line(p, end))
+                break;
+            // Size in hex, optionally followed by ;extensions
+            bool valid = !line_.empty() && std::isxdigit(static_cast<unsigned char>(line_[0]));
+            unsigned long long n = valid ? std::strtoull(line_.c_str(), nullptr, 16) : 0;
+            line_.clear();
+            if (!valid)
+            {
+                fail("invalid chunk size");
+                break;
+            }
+            remaining_ = n;
+            state_ = n ? State::CHUNK_DATA : State::TRAILERS;
+            break;
+        }
+
+        case State::CHUNK_DATA:
+        {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(static_cast<uint64_t>(end - p), remaining_));
+            if (!emit(p, n))
+                break;
+            p += n;
+            if ((remaining_ -= n) == 0)
+                state_ = State::CHUNK_DATA_END;
+            break;
+        }
+
+        case State::CHUNK_DATA_END:
+            if (!take_line(p, end))
+                break;
+            if (!line_.empty())
+                fail("invalid chunk terminator");
+            else
+                state_ = State::CHUNK_SIZE;
+            line_.clear();
+            break;
+
+        case State::TRAILERS:
+            if (!take_line(p, end))
+                break;
+            if (line_.empty())
+                state_ = State::DONE;
+            line_.clear();
+            break;
+        }
+    }
+    bytes_fed_ += static_cast<uint64_t>(p - data);
+    return static_cast<size_t>(p - data);
+}
+
+void HttpResponseParser::finish_eof()
+{
+    if (state_ == State::BODY && framing_ == Framing::UNTIL_EOF)
+        state_ = State::DONE;
+    else if (state_ != State::DONE && state_ != State::FAILED)
+        fail(bytes_fed_ ? "invalid HTTP response" : "connection closed");
+}
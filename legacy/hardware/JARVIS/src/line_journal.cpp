@@ -0,0 +1,347 @@
+#include "line_journal.hpp"
+#include "blueprint_format.hpp"
+#include "crypto.hpp"
+#include "sketch_pad.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sketch
+{
+
+    namespace
+    {
+
+        const char kJournalMagic[4] = {'J', 'R', 'V', 'J'};
+        const uint16_t kJournalVersion = 1;
+        const size_t kFileHeaderSize = 40; // magic, version, reserved, anchor[32]
+        const size_t kRecordHeaderSize = 16;
+        const size_t kMacSize = 32;
+        const uint32_t kMaxPayload = 64;
+
+        struct RecordHeader
+        {
+            uint32_t length;
+            uint8_t op;
+            uint8_t reserved[3];
+            uint64_t seq;
+        };
+        static_assert(sizeof(RecordHeader) == kRecordHeaderSize, "journal record header layout");
+
+        // MAC(prev || record) into out
+        void chain_mac(const uint8_t prev[32], const char *record, size_t length,
+                       const std::string &secret, uint8_t out[32])
+        {
+            std::string buf(reinterpret_cast<const char *>(prev), kMacSize);
+            buf.append(record, length);
+            if (secret.empty())
+                crypto::sha256(buf.data(), buf.size(), out);
+            else
+                crypto::hmac_sha256(buf.data(), buf.size(), secret, out);
+        }
+
+        void anchor_for(const std::string &base_signature, uint8_t out[32])
+        {
+            crypto::sha256(base_signature.data(), base_signature.size(), out);
+        }
+
+        bool write_all(int fd, const char *data, size_t length)
+        {
+            while (length > 0)
+            {
+                ssize_t n = ::write(fd, data, length);
+                if (n < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    return false;
+                }
+                data += n;
+                length -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool decode(const RecordHeader &h, const char *payload, JournalRecord &out)
+        {
+            out = JournalRecord();
+            out.op = static_cast<JournalOp>(h.op);
+            switch (out.op)
+            {
+            case JournalOp::ADD_LINE:
+                if (h.length != 24)
+                    return false;
+                std::memcpy(&out.x0, payload, 4);
+                std::memcpy(&out.y0, payload + 4, 4);
+                std::memcpy(&out.x1, payload + 8, 4);
+                std::memcpy(&out.y1, payload + 12, 4);
+                std::memcpy(&out.color, payload + 16, 4);
+                std::memcpy(&out.thickness, payload + 20, 4);
+                return true;
+            case JournalOp::CLEAR:
+                return h.length == 0;
+            case JournalOp::GRID:
+                if (h.length != 12)
+                    return false;
+                std::memcpy(&out.grid_spacing_percent, payload, 4);
+                std::memcpy(&out.real_world_spacing_cm, payload + 4, 4);
+                std::memcpy(&out.grid_flags, payload + 8, 4);
+                return true;
+            }
+            return false;
+        }
+
+        // True if the journal at `path` starts from `anchor`
+        bool anchored_to(const std::string &path, const uint8_t anchor[32])
+        {
+            int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+            char header[kFileHeaderSize];
+            const bool ok = pread(fd, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                            std::memcmp(header, kJournalMagic, 4) == 0 &&
+                            std::memcmp(header + 8, anchor, kMacSize) == 0;
+            ::close(fd);
+            return ok;
+        }
+
+    } // namespace
+
+    std::string LineJournal::staged_path(const std::string &path)
+    {
+        return path + ".next";
+    }
+
+    LineJournal::~LineJournal()
+    {
+        close();
+    }
+
+    bool LineJournal::open(const std::string &path, const std::string &base_signature,
+                           const std::string &secret, std::vector<JournalRecord> *replay)
+    {
+        close();
+        path_ = path;
+        secret_ = secret;
+
+        uint8_t anchor[32];
+        anchor_for(base_signature, anchor);
+        // A staged journal for this base takes over; one for another base
+        // belongs to a replacement that never landed
+        const std::string staged = staged_path(path);
+        if (access(staged.c_str(), F_OK) == 0)
+        {
+            if (anchored_to(staged, anchor))
+            {
+                if (rename(staged.c_str(), path.c_str()) != 0)
+                    std::cerr << "[LineJournal] Cannot adopt " << staged << ": " << strerror(errno) << "\n";
+            }
+            else
+                unlink(staged.c_str());
+        }
+
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+        if (fd_ < 0)
+        {
+            std::cerr << "[LineJournal] Cannot open " << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+
+        // Read the whole journal; it is bounded by compaction
+        std::string data;
+        {
+            struct stat st = {};
+            if (fstat(fd_, &st) == 0 && st.st_size > 0)
+            {
+                data.resize(static_cast<size_t>(st.st_size));
+                ssize_t got = pread(fd_, &data[0], data.size(), 0);
+                data.resize(got > 0 ? static_cast<size_t>(got) : 0);
+            }
+        }
+
+        if (data.size() < kFileHeaderSize || std::memcmp(data.data(), kJournalMagic, 4) != 0 ||
+            std::memcmp(data.data() + 8, anchor, kMacSize) != 0)
+        {
+            // New, unreadable, or written against another base: start over
+            if (!data.empty())
+                std::cerr << "[LineJournal] Discarding stale journal: " << path << "\n";
+            return reset(base_signature);
+        }
+
+        std::memcpy(chain_, anchor, kMacSize);
+        size_t offset = kFileHeaderSize;
+        size_t good = offset;
+        while (offset + kRecordHeaderSize + kMacSize <= data.size())
+        {
+            RecordHeader h;
+            std::memcpy(&h, data.data() + offset, sizeof(h));
+            if (h.length > kMaxPayload || offset + kRecordHeaderSize + h.length + kMacSize > data.size())
+                break;
+
+            size_t body = kRecordHeaderSize + h.length;
+            uint8_t mac[32];
+            chain_mac(chain_, data.data() + offset, body, secret_, mac);
+            if (std::memcmp(mac, data.data() + offset + body, kMacSize) != 0 || h.seq != seq_ + 1)
+                break;
+
+            JournalRecord rec;
+            if (!decode(h, data.data() + offset + kRecordHeaderSize, rec))
+                break;
+            if (replay)
+                replay->push_back(rec);
+
+            std::memcpy(chain_, mac, kMacSize);
+            seq_ = h.seq;
+            ++records_;
+            offset += body + kMacSize;
+            good = offset;
+        }
+
+        if (good != data.size())
+        {
+            std::cerr << "[LineJournal] Dropping " << (data.size() - good) << " torn/invalid byte(s) at end of "
+                      << path << "\n";
+            if (ftruncate(fd_, static_cast<off_t>(good)) != 0)
+            {
+                std::cerr << "[LineJournal] ftruncate failed: " << strerror(errno) << "\n";
+                close();
+                return false;
+            }
+        }
+        size_ = good;
+        lseek(fd_, static_cast<off_t>(good), SEEK_SET);
+        return true;
+    }
+
+    void LineJournal::close()
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+        fd_ = -1;
+        seq_ = 0;
+        records_ = 0;
+        size_ = 0;
+        pending_.clear();
+    }
+
+    bool LineJournal::reset(const std::string &base_signature)
+    {
+        if (fd_ < 0)
+            return false;
+        seq_ = 0;
+        records_ = 0;
+        pending_.clear();
+        if (ftruncate(fd_, 0) != 0 || lseek(fd_, 0, SEEK_SET) != 0 || !write_header(base_signature) ||
+            fdatasync(fd_) != 0)
+        {
+            std::cerr << "[LineJournal] Reset failed for " << path_ << ": " << strerror(errno) << "\n";
+            close();
+            return false;
+        }
+        size_ = kFileHeaderSize;
+        return true;
+    }
+
+    bool LineJournal::write_header(const std::string &base_signature)
+    {
+        char header[kFileHeaderSize] = {};
+        std::memcpy(header, kJournalMagic, 4);
+        std::memcpy(header + 4, &kJournalVersion, 2);
+        anchor_for(base_signature, chain_);
+        std::memcpy(header + 8, chain_, kMacSize);
+        return write_all(fd_, header, sizeof(header));
+    }
+
+    void LineJournal::append(JournalOp op, const void *payload, size_t length)
+    {
+        RecordHeader h;
+        std::memset(&h, 0, sizeof(h));
+        h.length = static_cast<uint32_t>(length);
+        h.op = static_cast<uint8_t>(op);
+        h.seq = ++seq_;
+
+        size_t start = pending_.size();
+        pending_.append(reinterpret_cast<const char *>(&h), sizeof(h));
+        pending_.append(static_cast<const char *>(payload), length);
+        uint8_t mac[32];
+        chain_mac(chain_, pending_.data() + start, sizeof(h) + length, secret_, mac);
+        pending_.append(reinterpret_cast<const char *>(mac), kMacSize);
+        std::memcpy(chain_, mac, kMacSize);
+        ++records_;
+    }
+
+    void LineJournal::append_line(const Line &line)
+    {
+        char p[24];
+        int32_t thickness = line.thickness;
+        std::memcpy(p, &line.start.x, 4);
+        std::memcpy(p + 4, &line.start.y, 4);
+        std::memcpy(p + 8, &line.end.x, 4);
+        std::memcpy(p + 12, &line.end.y, 4);
+        std::memcpy(p + 16, &line.color, 4);
+        std::memcpy(p + 20, &thickness, 4);
+        append(JournalOp::ADD_LINE, p, sizeof(p));
+    }
+
+    void LineJournal::append_clear()
+    {
+        append(JournalOp::CLEAR, nullptr, 0);
+    }
+
+    void LineJournal::append_grid(const GridConfig &grid)
+    {
+        char p[12];
+        uint32_t flags = (grid.snap_to_grid ? kGridSnap : 0u) | (grid.show_measurements ? kGridMeasurements : 0u);
+        std::memcpy(p, &grid.grid_spacing_percent, 4);
+        std::memcpy(p + 4, &grid.real_world_spacing_cm, 4);
+        std::memcpy(p + 8, &flags, 4);
+        append(JournalOp::GRID, p, sizeof(p));
+    }
+
+    bool LineJournal::sync()
+    {
+        if (fd_ < 0)
+            return false;
+        if (pending_.empty())
+            return true;
+        if (!write_all(fd_, pending_.data(), pending_.size()) || fdatasync(fd_) != 0)
+        {
+            std::cerr << "[LineJournal] Append failed for " << path_ << ": " << strerror(errno) << "\n";
+            close();
+            return false;
+        }
+        size_ += pending_.size();
+        pending_.clear();
+        return true;
+    }
+
+    void LineJournal::apply(const JournalRecord &record, std::vector<Line> &lines, GridConfig &grid)
+    {
+        switch (record.op)
+        {
+        case JournalOp::ADD_LINE:
+        {
+            Line line;
+            line.start = Point(record.x0, record.y0);
+            line.end = Point(record.x1, record.y1);
+            line.color = record.color;
+            line.thickness = record.thickness;
+            lines.push_back(line);
+            break;
+        }
+        case JournalOp::CLEAR:
+            lines.clear();
+            break;
+        case JournalOp::GRID:
+            grid.grid_spacing_percent = record.grid_spacing_percent;
+            grid.real_world_spacing_cm = record.real_world_spacing_cm;
+            grid.snap_to_grid = (record.grid_flags & kGridSnap) != 0;
+            grid.show_measurements = (record.grid_flags & kGridMeasurements) != 0;
+            break;
+        }
+    }
+
+} // namespace sketch
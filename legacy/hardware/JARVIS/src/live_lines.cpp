@@ -0,0 +1,543 @@
+#include "live_lines.hpp"
+#include "draw_ticker.hpp"
+#include "http_client.hpp"
+#include "logger.hpp"
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using json = nlohmann::json;
+
+namespace renderer
+{
+    namespace
+    {
+        uint32_t parse_color(const json &c)
+        {
+            if (c.is_number_unsigned() || c.is_number_integer())
+                return c.get<uint32_t>() & 0x00FFFFFF;
+            if (!c.is_string())
+                return 0x00FFFFFF;
+            std::string s = c.get<std::string>();
+            if (!s.empty() && s[0] == '#')
+                s = s.substr(1);
+            if (s.size() != 6)
+                return 0x00FFFFFF; // white fallback
+            unsigned int r = 0, g = 0, b = 0;
+            std::sscanf(s.c_str(), "%02x%02x%02x", &r, &g, &b);
+            return (r << 16) | (g << 8) | b;
+        }
+
+        int coord(const json &obj, const char *key, int fallback)
+        {
+            auto it = obj.find(key);
+            if (it == obj.end() || !it->is_number())
+                return fallback;
+            return static_cast<int>(it->get<double>());
+        }
+
+        bool parse_line(const json &obj, std::string &id, RenderLine &line)
+        {
+            if (!obj.is_object() || !obj.contains("id"))
+                return false;
+            const json &jid = obj["id"];
+            id = jid.is_string() ? jid.get<std::string>() : jid.dump();
+            line.x0 = coord(obj, "x0", 0);
+            line.y0 = coord(obj, "y0", 0);
+            line.x1 = coord(obj, "x1", 0);
+            line.y1 = coord(obj, "y1", 0);
+            line.thickness = coord(obj, "thickness", 3);
+            line.color = obj.contains("color") ? parse_color(obj["color"]) : 0x00FFFFFF;
+            return true;
+        }
+
+        DirtyRect screen_rect(uint32_t width, uint32_t height)
+        {
+            DirtyRect r;
+            r.x1 = static_cast<int>(width);
+            r.y1 = static_cast<int>(height);
+            return r;
+        }
+
+        DirtyRect clamp(const DirtyRect &r, uint32_t width, uint32_t height)
+        {
+            DirtyRect out;
+            out.x0 = std::max(0, r.x0);
+            out.y0 = std::max(0, r.y0);
+            out.x1 = std::min(r.x1, static_cast<int>(width));
+            out.y1 = std::min(r.y1, static_cast<int>(height));
+            return out;
+        }
+
+        bool intersects(const DirtyRect &a, const DirtyRect &b)
+        {
+            return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+        }
+    }
+
+    void DirtyRect::add(int ax0, int ay0, int ax1, int ay1)
+    {
+        if (ax1 <= ax0 || ay1 <= ay0)
+            return;
+        if (empty())
+        {
+            x0 = ax0;
+            y0 = ay0;
+            x1 = ax1;
+            y1 = ay1;
+            return;
+        }
+        x0 = std::min(x0, ax0);
+        y0 = std::min(y0, ay0);
+        x1 = std::max(x1, ax1);
+        y1 = std::max(y1, ay1);
+    }
+
+    void DirtyRect::add(const RenderLine &line)
+    {
+        // draw_line widens the pen horizontally by thickness / 2
+        int half = std::max(0, std::max(1, line.thickness) / 2);
+        add(std::min(line.x0, line.x1) - half, std::min(line.y0, line.y1),
+            std::max(line.x0, line.x1) + half + 1, std::max(line.y0, line.y1) + 1);
+    }
+
+    // ---------------------------------------------------------------- SSE
+
+    void SseParser::feed(const char *data, size_t size, const Handler &on_event)
+    {
+        const char *p = data;
+        const char *end = data + size;
+        while (p < end)
+        {
+            if (skip_lf_)
+            {
+                skip_lf_ = false;
+                if (*p == '\n')
+                {
+                    ++p;
+                    continue;
+                }
+            }
+            const char *stop = p;
+            while (stop < end && *stop != '\n' && *stop != '\r')
+                ++stop;
+            line_.append(p, stop);
+            if (stop == end)
+                break;
+            skip_lf_ = *stop == '\r';
+            p = stop + 1;
+            line(on_event);
+        }
+    }
+
+    void SseParser::reset()
+    {
+        line_.clear();
+        event_ = SseEvent();
+        has_data_ = false;
+        skip_lf_ = false;
+    }
+
+    void SseParser::line(const Handler &on_event)
+    {
+        if (line_.empty())
+        {
+            // Blank line: dispatch
+            if (has_data_)
+                on_event(event_);
+            std::string id = event_.id; // the last event id carries over
+            event_ = SseEvent();
+            event_.id = id;
+            has_data_ = false;
+            return;
+        }
+        if (line_[0] == ':')
+        {
+            line_.clear(); // comment (keep-alive)
+            return;
+        }
+        size_t colon = line_.find(':');
+        std::string field = line_.substr(0, colon);
+        std::string value;
+        if (colon != std::string::npos)
+        {
+            size_t start = colon + 1;
+            if (start < line_.size() && line_[start] == ' ')
+                ++start;
+            value = line_.substr(start);
+        }
+        if (field == "event")
+            event_.type = value;
+        else if (field == "data")
+        {
+            if (has_data_)
+                event_.data += '\n';
+            event_.data += value;
+            has_data_ = true;
+        }
+        else if (field == "id")
+            event_.id = value;
+        line_.clear();
+    }
+
+    bool parse_line_event(const SseEvent &sse, LineEvent &out)
+    {
+        out = LineEvent();
+        out.seq = std::strtoull(sse.id.c_str(), nullptr, 10);
+        if (sse.type == "clear")
+        {
+            out.type = LineEvent::CLEAR;
+            return true;
+        }
+        json j = json::parse(sse.data, nullptr, false);
+        if (j.is_discarded() || !j.is_object())
+            return false;
+        if (sse.type == "add")
+        {
+            out.type = LineEvent::ADD;
+            return parse_line(j, out.id, out.line);
+        }
+        if (sse.type == "remove")
+        {
+            out.type = LineEvent::REMOVE;
+            if (!j.contains("id"))
+                return false;
+            out.id = j["id"].is_string() ? j["id"].get<std::string>() : j["id"].dump();
+            return true;
+        }
+        if (sse.type == "snapshot")
+        {
+            out.type = LineEvent::SNAPSHOT;
+            if (!j.contains("lines") || !j["lines"].is_array())
+                return false;
+            out.lines.reserve(j["lines"].size());
+            for (const auto &l : j["lines"])
+            {
+                std::pair<std::string, RenderLine> entry;
+                if (parse_line(l, entry.first, entry.second))
+                    out.lines.push_back(std::move(entry));
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // ---------------------------------------------------------- line set
+
+    LiveLineSet::LiveLineSet(uint32_t width, uint32_t height, int cell_size)
+        : width_(width), height_(height), cell_size_(std::max(8, cell_size))
+    {
+    }
+
+    template <typename Fn>
+    void LiveLineSet::for_cells(const RenderLine &line, Fn fn)
+    {
+        DirtyRect box;
+        box.add(line);
+        box = clamp(box, width_, height_);
+        if (box.empty())
+            return; // off screen: never drawn
+        for (int cy = box.y0 / cell_size_; cy <= (box.y1 - 1) / cell_size_; ++cy)
+            for (int cx = box.x0 / cell_size_; cx <= (box.x1 - 1) / cell_size_; ++cx)
+                fn((static_cast<uint64_t>(cy) << 32) | static_cast<uint32_t>(cx));
+    }
+
+    bool LiveLineSet::apply(const LineEvent &event, DirtyRect &dirty)
+    {
+        switch (event.type)
+        {
+        case LineEvent::ADD:
+            return add(event.id, event.line, dirty);
+        case LineEvent::REMOVE:
+            return remove(event.id, dirty);
+        case LineEvent::CLEAR:
+            if (index_.empty())
+                return false;
+            clear(dirty);
+            return true;
+        case LineEvent::SNAPSHOT:
+        {
+            clear(dirty);
+            for (const auto &entry : event.lines)
+                add(entry.first, entry.second, dirty);
+            return true;
+        }
+        }
+        return false;
+    }
+
+    bool LiveLineSet::add(const std::string &id, const RenderLine &line, DirtyRect &dirty)
+    {
+        auto it = index_.find(id);
+        if (it != index_.end())
+        {
+            const RenderLine &old = slots_[it->second].line;
+            if (old.x0 == line.x0 && old.y0 == line.y0 && old.x1 == line.x1 && old.y1 == line.y1 &&
+                old.thickness == line.thickness && old.color == line.color)
+                return false;
+            remove(id, dirty);
+        }
+        uint32_t slot;
+        if (!free_.empty())
+        {
+            slot = free_.back();
+            free_.pop_back();
+        }
+        else
+        {
+            slot = static_cast<uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
+        Slot &s = slots_[slot];
+        s.line = line;
+        s.order = next_order_++;
+        s.live = true;
+        index_[id] = slot;
+        for_cells(line, [&](uint64_t cell) { cells_[cell].push_back(slot); });
+        dirty.add(line);
+        return true;
+    }
+
+    bool LiveLineSet::remove(const std::string &id, DirtyRect &dirty)
+    {
+        auto it = index_.find(id);
+        if (it == index_.end())
+            return false;
+        uint32_t slot = it->second;
+        index_.erase(it);
+        Slot &s = slots_[slot];
+        for_cells(s.line, [&](uint64_t cell) {
+            auto c = cells_.find(cell);
+            if (c == cells_.end())
+                return;
+            std::vector<uint32_t> &v = c->second;
+            auto pos = std::find(v.begin(), v.end(), slot);
+            if (pos != v.end())
+            {
+                *pos = v.back();
+                v.pop_back();
+            }
+            if (v.empty())
+                cells_.erase(c);
+        });
+        s.live = false;
+        free_.push_back(slot);
+        dirty.add(s.line);
+        return true;
+    }
+
+    void LiveLineSet::clear(DirtyRect &dirty)
+    {
+        slots_.clear();
+        free_.clear();
+        index_.clear();
+        cells_.clear();
+        DirtyRect all = screen_rect(width_, height_);
+        dirty.add(all.x0, all.y0, all.x1, all.y1);
+    }
+
+    void LiveLineSet::lines_in(const DirtyRect &rect, std::vector<const RenderLine *> &out) const
+    {
+        out.clear();
+        DirtyRect r = clamp(rect, width_, height_);
+        if (r.empty())
+            return;
+        std::vector<uint32_t> found;
+        for (int cy = r.y0 / cell_size_; cy <= (r.y1 - 1) / cell_size_; ++cy)
+            for (int cx = r.x0 / cell_size_; cx <= (r.x1 - 1) / cell_size_; ++cx)
+            {
+                auto c = cells_.find((static_cast<uint64_t>(cy) << 32) | static_cast<uint32_t>(cx));
+                if (c != cells_.end())
+                    found.insert(found.end(), c->second.begin(), c->second.end());
+            }
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+        std::vector<std::pair<uint64_t, const RenderLine *>> hits;
+        for (uint32_t slot : found)
+        {
+            DirtyRect box;
+            box.add(slots_[slot].line);
+            if (intersects(box, r))
+                hits.emplace_back(slots_[slot].order, &slots_[slot].line);
+        }
+        std::sort(hits.begin(), hits.end(),
+                  [](const std::pair<uint64_t, const RenderLine *> &a, const std::pair<uint64_t, const RenderLine *> &b) {
+                      return a.first < b.first;
+                  });
+        out.reserve(hits.size());
+        for (const auto &h : hits)
+            out.push_back(h.second);
+    }
+
+    const RenderLine *LiveLineSet::find(const std::string &id) const
+    {
+        auto it = index_.find(id);
+        return it == index_.end() ? nullptr : &slots_[it->second].line;
+    }
+
+    void paint_region(const LiveLineSet &set, const DirtyRect &rect,
+                      void *map, uint32_t stride, uint32_t width, uint32_t height,
+                      uint32_t background)
+    {
+        DirtyRect r = clamp(rect, width, height);
+        if (r.empty())
+            return;
+        draw_ticker::clear_rect(map, stride, width, height, r.x0, r.y0, r.x1, r.y1, background);
+        std::vector<const RenderLine *> lines;
+        set.lines_in(r, lines);
+        for (const RenderLine *l : lines)
+            draw_ticker::draw_line_clipped(map, stride, width, height, r.x0, r.y0, r.x1, r.y1,
+                                           l->x0, l->y0, l->x1, l->y1, l->color, std::max(1, l->thickness));
+    }
+
+    // -------------------------------------------------------- subscriber
+
+    LiveLineSubscriber::LiveLineSubscriber(LiveConfig config)
+        : config_(std::move(config))
+    {
+        if (config_.timeout_ms <= config_.wait_ms)
+            config_.timeout_ms = config_.wait_ms + 2000;
+    }
+
+    LiveLineSubscriber::~LiveLineSubscriber()
+    {
+        stop();
+    }
+
+    void LiveLineSubscriber::start()
+    {
+        if (running_.exchange(true))
+            return;
+        unsupported_ = false;
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void LiveLineSubscriber::stop()
+    {
+        running_ = false;
+        cv_.notify_all();
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+    bool LiveLineSubscriber::apply(LiveLineSet &set, DirtyRect &dirty, int timeout_ms)
+    {
+        std::deque<LineEvent> events;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (queue_.empty() && timeout_ms > 0)
+                cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                             [this]() { return !queue_.empty() || !running_; });
+            events.swap(queue_);
+        }
+        bool changed = false;
+        for (const auto &e : events)
+            changed = set.apply(e, dirty) || changed;
+        return changed;
+    }
+
+    LiveStats LiveLineSubscriber::stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    void LiveLineSubscriber::sleep_ms(int ms)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, std::chrono::milliseconds(ms), [this]() { return !running_; });
+    }
+
+    void LiveLineSubscriber::run()
+    {
+        HttpClient client;
+        SseParser parser;
+        uint64_t since = 0;
+        const char sep = config_.path.find('?') == std::string::npos ? '?' : '&';
+        while (running_)
+        {
+            std::string target = config_.path + sep + "since=" + std::to_string(since) +
+                                 "&wait_ms=" + std::to_string(config_.wait_ms);
+            parser.reset();
+            size_t received = 0;
+            auto started = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++stats_.requests;
+            }
+            bool ok = client.get_stream(config_.host, config_.port, target, [&](const char *data, size_t size) {
+                std::vector<LineEvent> batch;
+                parser.feed(data, size, [&](const SseEvent &sse) {
+                    LineEvent event;
+                    if (parse_line_event(sse, event))
+                        batch.push_back(std::move(event));
+                });
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.bytes += size;
+                for (auto &event : batch)
+                {
+                    if (queue_.size() >= config_.max_queued)
+                    {
+                        // Too far behind: start over from a snapshot
+                        queue_.clear();
+                        resync_ = true;
+                        ++stats_.resyncs;
+                        break;
+                    }
+                    if (event.seq)
+                        since = event.seq;
+                    ++stats_.events;
+                    ++received;
+                    queue_.push_back(std::move(event));
+                }
+                if (!batch.empty())
+                    cv_.notify_all();
+                return running_ && !resync_;
+            }, config_.timeout_ms, config_.use_tls);
+
+            if (!running_)
+                break;
+            bool resync;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                resync = resync_;
+                resync_ = false;
+            }
+            if (resync)
+            {
+                since = 0;
+                continue;
+            }
+            if (!ok)
+            {
+                int status = client.last_status();
+                if (status == 404 || status == 405 || status == 501)
+                {
+                    JLOG_WARN("Live") << "Server has no line event stream at " << config_.path;
+                    unsupported_ = true;
+                    running_ = false;
+                    cv_.notify_all();
+                    break;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++stats_.errors;
+                }
+                JLOG_DEBUG("Live") << "Event request failed: " << client.last_error();
+                sleep_ms(config_.retry_ms);
+                continue;
+            }
+            // A server that answers at once with nothing is not holding the
+            // request open; do not spin on it
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - started).count();
+            if (received == 0 && elapsed < config_.wait_ms / 4)
+                sleep_ms(config_.retry_ms);
+        }
+    }
+
+} // namespace renderer
@@ -0,0 +1,520 @@
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+namespace logger
+{
+
+    namespace
+    {
+
+        constexpr size_t kRingSlots = 256; // per thread, power of two
+        constexpr size_t kBatchBytes = 64 * 1024;
+
+        // Single-producer/single-consumer ring owned by one thread.
+        struct Ring
+        {
+            struct Slot
+            {
+                uint16_t len;
+                char data[kMaxRecord];
+            };
+
+            Slot slots[kRingSlots];
+            std::atomic<uint64_t> head{0}; // next slot the producer writes
+            std::atomic<uint64_t> tail{0}; // next slot the consumer reads
+            std::atomic<bool> retired{false};
+
+            bool push(const char *data, size_t len)
+            {
+                uint64_t h = head.load(std::memory_order_relaxed);
+                if (h - tail.load(std::memory_order_acquire) >= kRingSlots)
+                    return false;
+                Slot &s = slots[h & (kRingSlots - 1)];
+                s.len = static_cast<uint16_t>(len);
+                std::memcpy(s.data, data, len);
+                head.store(h + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Append queued records to out; returns number drained.
+            size_t drain(std::string &out)
+            {
+                uint64_t t = tail.load(std::memory_order_relaxed);
+                uint64_t h = head.load(std::memory_order_acquire);
+                size_t n = 0;
+                while (t != h && out.size() < kBatchBytes)
+                {
+                    const Slot &s = slots[t & (kRingSlots - 1)];
+                    out.append(s.data, s.len);
+                    ++t;
+                    ++n;
+                }
+                tail.store(t, std::memory_order_release);
+                return n;
+            }
+        };
+
+        struct State
+        {
+            // Module registry
+            std::mutex modules_mtx;
+            std::unordered_map<std::string, Module *> modules;
+            std::unordered_map<std::string, Level> overrides;
+            std::atomic<uint8_t> default_level{static_cast<uint8_t>(Level::Info)};
+
+            // Rings
+            std::mutex rings_mtx;
+            std::vector<std::shared_ptr<Ring>> rings;
+
+            // Writer
+            std::mutex writer_mtx;
+            std::condition_variable writer_cv;
+            std::condition_variable flushed_cv;
+            std::thread writer;
+            bool running = false;
+            bool stopping = false;
+            uint64_t flush_requested = 0;
+            uint64_t flush_done = 0;
+            std::atomic<bool> synchronous{false};
+            std::atomic<bool> shut_down{false};
+            std::atomic<bool> started{false};
+
+            // Sink
+            std::mutex sink_mtx;
+            std::function<void(const char *, size_t)> sink;
+
+            std::atomic<uint64_t> written{0};
+            std::atomic<uint64_t> dropped{0};
+            std::atomic<uint64_t> dropped_reported{0};
+
+            // Rings are single-consumer: the writer and callers of flush()
+            // without a writer take turns draining them
+            std::mutex drain_mtx;
+        };
+
+        bool configure_into(const std::string &spec, State &st, bool apply_modules);
+
+        // Leaked on purpose: records may be emitted from static destructors
+        // and thread_local cleanup after main returns.
+        State &state()
+        {
+            static State *s = [] {
+                State *st = new State();
+                if (const char *spec = std::getenv("JARVIS_LOG_LEVEL"))
+                    configure_into(spec, *st, false);
+                if (const char *sync = std::getenv("JARVIS_LOG_SYNC"))
+                    st->synchronous.store(std::strcmp(sync, "0") != 0);
+                return st;
+            }();
+            return *s;
+        }
+
+        void write_fd2(const char *data, size_t len)
+        {
+            while (len > 0)
+            {
+                ssize_t n = ::write(2, data, len);
+                if (n <= 0)
+                    return;
+                data += n;
+                len -= static_cast<size_t>(n);
+            }
+        }
+
+        void emit(State &st, const char *data, size_t len)
+        {
+            if (len == 0)
+                return;
+            std::lock_guard<std::mutex> lock(st.sink_mtx);
+            if (st.sink)
+                st.sink(data, len);
+            else
+                write_fd2(data, len);
+        }
+
+        // Drain every ring once. Returns records written.
+        size_t drain_all(State &st, std::string &batch)
+        {
+            std::lock_guard<std::mutex> drain_lock(st.drain_mtx);
+            std::vector<std::shared_ptr<Ring>> rings;
+            {
+                std::lock_guard<std::mutex> lock(st.rings_mtx);
+                rings = st.rings;
+            }
+
+            size_t total = 0;
+            for (auto &r : rings)
+            {
+                size_t n;
+                do
+                {
+                    batch.clear();
+                    n = r->drain(batch);
+                    emit(st, batch.data(), batch.size());
+                    total += n;
+                } while (n > 0 && batch.size() >= kBatchBytes);
+            }
+            st.written.fetch_add(total, std::memory_order_relaxed);
+
+            // Forget rings whose thread exited and which are now empty
+            {
+                std::lock_guard<std::mutex> lock(st.rings_mtx);
+                st.rings.erase(std::remove_if(st.rings.begin(), st.rings.end(),
+                                              [](const std::shared_ptr<Ring> &r)
+                                              {
+                                                  return r->retired.load() &&
+                                                         r->head.load() == r->tail.load();
+                                              }),
+                               st.rings.end());
+            }
+
+            const uint64_t dropped = st.dropped.load(std::memory_order_relaxed);
+            const uint64_t reported = st.dropped_reported.exchange(dropped);
+            if (dropped != reported)
+            {
+                std::string msg = "[Logger][WARN] dropped " +
+                                  std::to_string(dropped - reported) +
+                                  " records (ring full)\n";
+                emit(st, msg.data(), msg.size());
+            }
+            return total;
+        }
+
+        void writer_loop(State &st)
+        {
+            std::string batch;
+            batch.reserve(kBatchBytes + kMaxRecord);
+            std::unique_lock<std::mutex> lock(st.writer_mtx);
+            for (;;)
+            {
+                st.writer_cv.wait_for(lock, std::chrono::milliseconds(10));
+                bool stopping = st.stopping;
+                uint64_t requested = st.flush_requested;
+                lock.unlock();
+
+                drain_all(st, batch);
+
+                lock.lock();
+                st.flush_done = requested;
+                st.flushed_cv.notify_all();
+                if (stopping)
+                    break;
+            }
+        }
+
+        void ensure_writer(State &st)
+        {
+            if (st.started.load(std::memory_order_acquire))
+                return;
+            std::lock_guard<std::mutex> lock(st.writer_mtx);
+            if (st.running || st.shut_down.load())
+                return;
+            st.running = true;
+            st.started.store(true, std::memory_order_release);
+            st.writer = std::thread(writer_loop, std::ref(st));
+            static bool registered = false;
+            if (!registered)
+            {
+                registered = true;
+                std::atexit([] { shutdown(); });
+            }
+        }
+
+        struct ThreadRing
+        {
+            std::shared_ptr<Ring> ring;
+            ~ThreadRing()
+            {
+                if (ring)
+                    ring->retired.store(true);
+            }
+        };
+
+        Ring *thread_ring()
+        {
+            thread_local ThreadRing tr;
+            if (!tr.ring)
+            {
+                tr.ring = std::make_shared<Ring>();
+                State &st = state();
+                std::lock_guard<std::mutex> lock(st.rings_mtx);
+                st.rings.push_back(tr.ring);
+            }
+            return tr.ring.get();
+        }
+
+        std::string trim(const std::string &s)
+        {
+            size_t b = s.find_first_not_of(" \t");
+            size_t e = s.find_last_not_of(" \t");
+            if (b == std::string::npos)
+                return "";
+            return s.substr(b, e - b + 1);
+        }
+
+    } // namespace
+
+    bool parse_level(const std::string &text, Level &out)
+    {
+        std::string t = trim(text);
+        std::transform(t.begin(), t.end(), t.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        if (t == "trace")
+            out = Level::Trace;
+        else if (t == "debug")
+            out = Level::Debug;
+        else if (t == "info")
+            out = Level::Info;
+        else if (t == "warn" || t == "warning")
+            out = Level::Warn;
+        else if (t == "error")
+            out = Level::Error;
+        else if (t == "off" || t == "none")
+            out = Level::Off;
+        else
+            return false;
+        return true;
+    }
+
+    const char *level_name(Level level)
+    {
+        switch (level)
+        {
+        case Level::Trace:
+            return "TRACE";
+        case Level::Debug:
+            return "DEBUG";
+        case Level::Info:
+            return "INFO";
+        case Level::Warn:
+            return "WARN";
+        case Level::Error:
+            return "ERROR";
+        default:
+            return "OFF";
+        }
+    }
+
+    namespace
+    {
+
+        // Called with modules_mtx held, or before the registry is published.
+        bool configure_into(const std::string &spec, State &st, bool apply_modules)
+        {
+            bool ok = true;
+            size_t pos = 0;
+            while (pos <= spec.size())
+            {
+                size_t comma = spec.find(',', pos);
+                if (comma == std::string::npos)
+                    comma = spec.size();
+                std::string item = trim(spec.substr(pos, comma - pos));
+                pos = comma + 1;
+                if (item.empty())
+                    continue;
+
+                Level lvl;
+                size_t eq = item.find('=');
+                if (eq == std::string::npos)
+                {
+                    if (!parse_level(item, lvl))
+                    {
+                        ok = false;
+                        continue;
+                    }
+                    st.default_level.store(static_cast<uint8_t>(lvl));
+                    continue;
+                }
+
+                std::string name = trim(item.substr(0, eq));
+                if (name.empty() || !parse_level(item.substr(eq + 1), lvl))
+                {
+                    ok = false;
+                    continue;
+                }
+                st.overrides[name] = lvl;
+            }
+
+            if (apply_modules)
+            {
+                for (auto &kv : st.modules)
+                {
+                    auto it = st.overrides.find(kv.first);
+                    kv.second->level.store(static_cast<uint8_t>(
+                        it != st.overrides.end() ? it->second : static_cast<Level>(st.default_level.load())));
+                }
+            }
+            return ok;
+        }
+
+    } // namespace
+
+    Module &module(const char *name)
+    {
+        State &st = state();
+        std::lock_guard<std::mutex> lock(st.modules_mtx);
+        auto it = st.modules.find(name);
+        if (it != st.modules.end())
+            return *it->second;
+
+        Module *m = new Module();
+        m->name = name;
+        auto ov = st.overrides.find(name);
+        m->level.store(static_cast<uint8_t>(
+            ov != st.overrides.end() ? ov->second : static_cast<Level>(st.default_level.load())));
+        st.modules.emplace(name, m);
+        return *m;
+    }
+
+    void set_level(const char *module_name, Level level)
+    {
+        State &st = state();
+        Module &m = module(module_name);
+        std::lock_guard<std::mutex> lock(st.modules_mtx);
+        st.overrides[module_name] = level;
+        m.level.store(static_cast<uint8_t>(level));
+    }
+
+    void set_default_level(Level level)
+    {
+        State &st = state();
+        std::lock_guard<std::mutex> lock(st.modules_mtx);
+        st.default_level.store(static_cast<uint8_t>(level));
+        for (auto &kv : st.modules)
+        {
+            if (st.overrides.find(kv.first) == st.overrides.end())
+                kv.second->level.store(static_cast<uint8_t>(level));
+        }
+    }
+
+    Level default_level()
+    {
+        return static_cast<Level>(state().default_level.load());
+    }
+
+    bool configure(const std::string &spec)
+    {
+        State &st = state();
+        std::lock_guard<std::mutex> lock(st.modules_mtx);
+        return configure_into(spec, st, true);
+    }
+
+    void set_sink(std::function<void(const char *data, size_t len)> sink)
+    {
+        State &st = state();
+        std::lock_guard<std::mutex> lock(st.sink_mtx);
+        st.sink = std::move(sink);
+    }
+
+    void set_synchronous(bool sync)
+    {
+        if (sync)
+            flush();
+        state().synchronous.store(sync);
+    }
+
+    void flush()
+    {
+        State &st = state();
+        std::unique_lock<std::mutex> lock(st.writer_mtx);
+        if (!st.running)
+        {
+            lock.unlock();
+            std::string batch;
+            drain_all(st, batch);
+            return;
+        }
+        uint64_t ticket = ++st.flush_requested;
+        st.writer_cv.notify_one();
+        st.flushed_cv.wait(lock, [&]
+                           { return st.flush_done >= ticket || !st.running; });
+    }
+
+    void shutdown()
+    {
+        State &st = state();
+        std::thread writer;
+        {
+            std::lock_guard<std::mutex> lock(st.writer_mtx);
+            st.shut_down.store(true);
+            if (!st.running)
+                return;
+            st.stopping = true;
+            ++st.flush_requested;
+            st.writer_cv.notify_one();
+            writer = std::move(st.writer);
+        }
+        if (writer.joinable())
+            writer.join();
+
+        std::lock_guard<std::mutex> lock(st.writer_mtx);
+        st.running = false;
+        st.stopping = false;
+        st.flushed_cv.notify_all();
+    }
+
+    Stats stats()
+    {
+        State &st = state();
+        Stats s;
+        s.written = st.written.load();
+        s.dropped = st.dropped.load();
+        return s;
+    }
+
+    namespace detail
+    {
+
+        Record::Record(const Module &m, Level level)
+            : sb_(buf_, kMaxRecord - 1), os_(&sb_), level_(level)
+        {
+            os_ << '[' << m.name << ']';
+            if (level >= Level::Warn)
+                os_ << '[' << level_name(level) << ']';
+            os_ << ' ';
+        }
+
+        Record::~Record()
+        {
+            size_t len = sb_.size();
+            buf_[len++] = '\n';
+
+            State &st = state();
+            if (st.synchronous.load(std::memory_order_relaxed) || st.shut_down.load(std::memory_order_relaxed))
+            {
+                emit(st, buf_, len);
+                st.written.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            ensure_writer(st);
+            if (!thread_ring()->push(buf_, len))
+            {
+                // Errors must not be lost to a full ring
+                if (level_ >= Level::Error)
+                {
+                    emit(st, buf_, len);
+                    st.written.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    st.dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+    } // namespace detail
+
+} // namespace logger
@@ -17,11 +17,18 @@
 #include <drm.h>
 #include <drm_mode.h>
 #include <string>
+#include <sstream>
 #include <vector>
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <linux/fb.h>
 
 #include "draw_ticker.hpp"
 #include "http_client.hpp"
+#include "async_http_client.hpp"
 #include "renderer.hpp"
 #include <nlohmann/json.hpp>
 #include "crypto.hpp"
@@ -30,7 +37,17 @@
 #include "hand_detector_production.hpp"
 #include "hand_detector_mediapipe.hpp"
 #include "hand_detector_hybrid.hpp"
+#include "detection_bus.hpp"
 #include "sketch_pad.hpp"
+#include "persist_worker.hpp"
+#include "blueprint_format.hpp"
+#include "blueprint_outbox.hpp"
+#include "blueprint_store.hpp"
+#include "blueprint_sync.hpp"
+#include "signed_json.hpp"
+#include "worker_pool.hpp"
+#include "surface.hpp"
+#include "logger.hpp"
 #include "pipeline.hpp"
 
 #define JARVIS_BLUEPRINT_ID "TestBlueprint456"
@@ -41,6 +58,31 @@ static void fatal(const char *msg)
     std::exit(EXIT_FAILURE);
 }
 
+// Detections shared with the Python app through shared memory when
+// JARVIS_DETECTION_BUS is set ("1" for /jarvis_detections, or a name).
+// Null when disabled or the segment could not be created.
+static hand_detector::DetectionPublisher *detection_bus()
+{
+    static hand_detector::DetectionPublisher bus;
+    static bool tried = false;
+    if (!tried)
+    {
+        tried = true;
+        const char *env = std::getenv("JARVIS_DETECTION_BUS");
+        if (env && *env && std::strcmp(env, "0") != 0)
+        {
+            hand_detector::DetectionBusConfig config;
+            if (std::strcmp(env, "1") != 0)
+                config.name = env[0] == '/' ? env : std::string("/") + env;
+            if (bus.open(config))
+                std::cerr << "[DetectionBus] Publishing to /dev/shm" << config.name << "\n";
+            else
+                std::cerr << "[DetectionBus] " << bus.error() << "\n";
+        }
+    }
+    return bus.is_open() ? &bus : nullptr;
+}
+
 int main(int argc, char **argv)
 {
     // ---------------------------------------------------------------------------
@@ -48,6 +90,11 @@ int main(int argc, char **argv)
     // Supported flags:
     //   --imx500         Enable IMX500 NPU postprocessing (sets env var)
     //   --model <path>   Override hand landmark model path (env JARVIS_MODEL_PATH)
+    //   --log-level <s>  Logger levels, e.g. "info,SketchPad=debug" (env JARVIS_LOG_LEVEL)
+    //   --detection-bus <name>  Share detections over shm (env JARVIS_DETECTION_BUS)
+    //   --record <file>  Record raw camera frames (env JARVIS_RECORD)
+    //   --replay <file>  Use a recording instead of the camera (env JARVIS_REPLAY)
+    //   --replay-fps <n|max>  Replay pace; default as recorded (env JARVIS_REPLAY_FPS)
     // ---------------------------------------------------------------------------
     for (int i = 1; i < argc; ++i)
     {
@@ -61,11 +108,42 @@ int main(int argc, char **argv)
             setenv("JARVIS_MODEL_PATH", argv[i + 1], 1);
             ++i;
         }
+        else if (arg == "--detection-bus" && i + 1 < argc)
+        {
+            setenv("JARVIS_DETECTION_BUS", argv[i + 1], 1);
+            ++i;
+        }
+        else if (arg == "--record" && i + 1 < argc)
+        {
+            setenv("JARVIS_RECORD", argv[i + 1], 1);
+            ++i;
+        }
+        else if (arg == "--replay" && i + 1 < argc)
+        {
+            setenv("JARVIS_REPLAY", argv[i + 1], 1);
+            ++i;
+        }
+        else if (arg == "--replay-fps" && i + 1 < argc)
+        {
+            setenv("JARVIS_REPLAY_FPS", argv[i + 1], 1);
+            ++i;
+        }
+        else if (arg == "--log-level" && i + 1 < argc)
+        {
+            if (!logger::configure(argv[i + 1]))
+                std::cerr << "[Config] Invalid --log-level spec: " << argv[i + 1] << "\n";
+            ++i;
+        }
         else if (arg == "--help" || arg == "-h")
         {
             std::cout << "JARVIS Options:\n"
                       << "  --imx500            Enable IMX500 hand landmark acceleration\n"
                       << "  --model <path>      Override hand landmark model file\n"
+                      << "  --log-level <spec>  Log levels, e.g. info,SketchPad=debug\n"
+                      << "  --detection-bus <n> Publish detections to shared memory (1 = default name)\n"
+                      << "  --record <file>     Record raw camera frames for replay\n"
+                      << "  --replay <file>     Run from a recording instead of the camera\n"
+                      << "  --replay-fps <n>    Replay pace: frames per second or max (default: as recorded)\n"
                       << "  --help              Show this help\n\n";
             return 0;
         }
@@ -402,58 +480,104 @@ int main(int argc, char **argv)
 
     
 
-    // Forward-declare POST helper so fetch lambda can call it even though
-    // the actual lambda definition appears later in this translation unit.
-    std::function<bool(const std::string &sketch_name, sketch::SketchPad &sketchpad)> post_local_to_server;
+    // Uploads go through an epoll reactor thread so the drawing and
+    // command loops never wait on the server
+    AsyncHttpClient async_http;
+    // Uploads that failed, retried in the background (created once the
+    // server address is known)
+    std::unique_ptr<sketch::BlueprintOutbox> outbox;
+    auto queue_outbox_post = [&outbox](const std::string &sketch_name, const std::string &export_json) {
+        if (outbox && outbox->enqueue(sketch_name, export_json))
+            std::cerr << "[Server] Queued upload of '" << sketch_name << "' for retry\n";
+        else
+            std::cerr << "[Server] Failed to queue upload of '" << sketch_name << "'\n";
+    };
+    // Queueing appends to the outbox log and syncs it, so completion
+    // callbacks (reactor thread) hand their failures to this thread
+    jarvis::WorkerPool outbox_requeue(1);
 
-    // Helper: process any queued outbound posts in `blueprints/_outbox/`.
-    auto process_outbox = [&]() {
-        const char *outdir = "blueprints/_outbox";
-        struct stat st = {};
-        if (::stat(outdir, &st) != 0)
+    // Forward-declare POST helpers so fetch lambda can call them even though
+    // the actual lambda definitions appear later in this translation unit.
+    std::function<bool(const std::string &sketch_name, sketch::SketchPad &sketchpad)> post_local_to_server;
+    std::function<std::future<bool>(const std::string &sketch_name, const std::string &json)> post_blueprint_async;
+
+    // Line-level delta sync: one BlueprintSync per blueprint, progress kept
+    // next to the file ("<name>.jarvis.sync"). Servers without the delta
+    // push/pull endpoints get full uploads and downloads instead.
+    std::mutex blueprint_sync_mutex;
+    std::map<std::string, std::unique_ptr<sketch::BlueprintSync>> blueprint_syncs;
+    std::atomic<bool> delta_sync_unsupported{false};
+    auto blueprint_sync_for = [&](const std::string &sketch_name) -> sketch::BlueprintSync * {
+        // A JARVIS_SERVER that already names the blueprint API pins the
+        // load/save paths; deltas need their own
+        if (delta_sync_unsupported || path.find("/api/workstation/blueprint") != std::string::npos)
+            return nullptr;
+        std::lock_guard<std::mutex> lock(blueprint_sync_mutex);
+        auto &entry = blueprint_syncs[sketch_name];
+        if (!entry)
         {
-            // No outbox directory yet - nothing to do
-            return;
+            std::string enc_workstation = device_id;
+            std::string enc_blueprint = JARVIS_BLUEPRINT_ID;
+            if (!secret.empty())
+            {
+                enc_workstation = crypto::aes256_encrypt(device_id, secret);
+                enc_blueprint = crypto::aes256_encrypt(sketch_name, secret);
+            }
+            std::string prefix = path;
+            if (prefix.empty() || prefix.back() != '/')
+                prefix += '/';
+            if (prefix[0] != '/')
+                prefix = "/" + prefix;
+            sketch::SyncEndpoint endpoint;
+            endpoint.host = host;
+            endpoint.port = port;
+            endpoint.use_tls = server_use_tls;
+            endpoint.push_path = prefix + "api/workstation/blueprint/push/" + enc_workstation + "/" + enc_blueprint;
+            endpoint.pull_path = prefix + "api/workstation/blueprint/pull/" + enc_workstation + "/" + enc_blueprint;
+            entry.reset(new sketch::BlueprintSync(async_http, device_id, endpoint,
+                                                  "blueprints/" + sketch_name + ".jarvis.sync"));
         }
-        DIR *d = opendir(outdir);
-        if (!d) return;
-        struct dirent *ent;
-        while ((ent = readdir(d)) != nullptr)
+        return entry.get();
+    };
+
+    // Helper: perform server blueprint load and update local file if server has a different version
+    // Returns true if sketchpad has been loaded (from server or local) and is ready
+    auto fetch_and_update_from_server = [&](const std::string &sketch_name, sketch::SketchPad &sketchpad) -> bool {
+        // Delta sync: start from the local copy and exchange only what
+        // changed on either side since the last sync
+        if (sketch::BlueprintSync *sync = blueprint_sync_for(sketch_name))
         {
-            std::string name = ent->d_name;
-            if (name.size() <= 12) // at minimum "a.pending.json"
-                continue;
-            if (name.size() < 13) continue;
-            const std::string suffix = ".pending.json";
-            if (name.size() <= suffix.size()) continue;
-            if (name.substr(name.size() - suffix.size()) != suffix)
-                continue;
-            std::string sketch_name = name.substr(0, name.size() - suffix.size());
-            // Attempt to post using a fresh SketchPad instance
-            sketch::SketchPad sp(width, height);
-            sp.init(sketch_name, width, height);
-            // Ensure the sketch is loaded so post_local_to_server can find the path
-            sp.load(sketch_name);
-            bool ok = false;
-            try { ok = post_local_to_server(sketch_name, sp); } catch (...) { ok = false; }
-            std::string fullpath = std::string(outdir) + "/" + name;
-            if (ok)
+            bool have_local = sketchpad.load(sketch_name);
+            if (!have_local)
+                sketchpad.init(sketch_name, width, height);
+            uint64_t merges = sync->stats().merges;
+            sketch::SyncResult result = sync->sync(sketchpad);
+            if (result == sketch::SyncResult::SYNCED || result == sketch::SyncResult::UP_TO_DATE)
             {
-                // remove queued file
-                unlink(fullpath.c_str());
-                std::cerr << "[Outbox] Posted queued blueprint: " << sketch_name << "\n";
+                if (sync->stats().merges != merges)
+                {
+                    std::cout << "[Server] Merged server changes into '" << sketch_name << "'\n";
+                    if (!sketchpad.save(sketch_name))
+                        std::cerr << "[Server] Warning: failed to save merged blueprint\n";
+                }
+                else
+                {
+                    std::cout << "[Server] Local copy is up-to-date (no update)\n";
+                }
+                if (have_local || sketchpad.get_stroke_count() > 0)
+                    return true;
+            }
+            else if (result == sketch::SyncResult::UNSUPPORTED)
+            {
+                std::cerr << "[Server] Server has no delta sync; using full downloads\n";
+                delta_sync_unsupported = true;
             }
             else
             {
-                std::cerr << "[Outbox] Still queued (post failed): " << sketch_name << "\n";
+                std::cerr << "[Server] Sync failed: " << sync->last_error() << "\n";
             }
         }
-        closedir(d);
-    };
 
-    // Helper: perform server blueprint load and update local file if server has a different version
-    // Returns true if sketchpad has been loaded (from server or local) and is ready
-    auto fetch_and_update_from_server = [&](const std::string &sketch_name, sketch::SketchPad &sketchpad) -> bool {
         const char *secret_env = std::getenv("JARVIS_SECRET");
         std::string secret = secret_env ? std::string(secret_env) : std::string();
         // Derive encrypted ids if we have a secret, else use plain ids
@@ -493,11 +617,37 @@ int main(int argc, char **argv)
             };
 
             std::string server_path = make_blueprint_endpoint("load");
+
+        // Local copy the download revalidates; its ETag/Last-Modified live
+        // in "<file>.etag" and are only trusted while the file exists
+        std::string local_path = sketchpad.get_last_loaded_path();
+        if (local_path.empty())
+        {
+            local_path = std::string("blueprints/") + sketch_name;
+            if (local_path.find(".jarvis") == std::string::npos)
+                local_path += ".jarvis";
+        }
+        const std::string validators_path = local_path + ".etag";
+        HttpValidators validators;
+        if (access(local_path.c_str(), R_OK) == 0)
+            validators.load(validators_path);
+
         HttpClient client;
-        std::string body = client.get(host, port, server_path, 3000, server_use_tls);
+        std::string body;
+        HttpFetch fetched = client.get_if_modified(host, port, server_path, validators, body, 3000, server_use_tls);
+        if (fetched == HttpFetch::NOT_MODIFIED)
+        {
+            std::cout << "[Server] Local copy is up-to-date (304)\n";
+            if (sketchpad.load(sketch_name))
+                return true;
+            // The cached copy is unusable; drop the validators and download it whole
+            HttpValidators().save(validators_path);
+            validators = HttpValidators();
+            fetched = client.get_if_modified(host, port, server_path, validators, body, 3000, server_use_tls);
+        }
 
         // If server returned a non-empty body, try to parse and persist it.
-        if (!body.empty())
+        if (fetched == HttpFetch::MODIFIED && !body.empty())
         {
             try
             {
@@ -505,16 +655,6 @@ int main(int argc, char **argv)
                 // stringify deterministically
                 std::string server_payload = j.dump(2) + "\n";
 
-                // Determine local path we loaded from (if any)
-                std::string local_path = sketchpad.get_last_loaded_path();
-                if (local_path.empty())
-                {
-                    // default target
-                    local_path = std::string("blueprints/") + sketch_name;
-                    if (local_path.find(".jarvis") == std::string::npos)
-                        local_path += ".jarvis";
-                }
-
                 // Read local file if exists
                 std::string local_contents;
                 {
@@ -533,9 +673,17 @@ int main(int argc, char **argv)
                     }
                 }
 
+                // Binary local copies are compared through their JSON export
+                if (sketch::is_binary_blueprint(local_contents.data(), local_contents.size()))
+                {
+                    sketch::SketchPad local_pad;
+                    local_contents = local_pad.load(local_path) ? local_pad.export_json() : std::string();
+                }
+
                 if (!local_contents.empty() && local_contents == server_payload)
                 {
                     std::cout << "[Server] Local copy is up-to-date (no update)\n";
+                    validators.save(validators_path);
                     // Attempt to load local file into sketchpad to ensure it's available
                     if (sketchpad.load(sketch_name))
                         return true;
@@ -579,6 +727,7 @@ int main(int argc, char **argv)
                         else
                         {
                             std::cout << "[Server] Updated local blueprint from server: " << local_path << "\n";
+                            validators.save(validators_path);
                             if (sketchpad.load(sketch_name))
                                 return true;
                             // If standard load failed due to signature verification,
@@ -607,14 +756,6 @@ int main(int argc, char **argv)
 
         // If we reach here, server was not usable/valid. Try to load a local blueprint and
         // then push it to the server so the server has a copy.
-        std::string local_path = sketchpad.get_last_loaded_path();
-        if (local_path.empty())
-        {
-            local_path = std::string("blueprints/") + sketch_name;
-            if (local_path.find(".jarvis") == std::string::npos)
-                local_path += ".jarvis";
-        }
-
         // Try loading from local file into the provided sketchpad
         if (sketchpad.load(sketch_name))
         {
@@ -680,8 +821,8 @@ int main(int argc, char **argv)
         return false;
     };
 
-    // Helper: POST local blueprint to server after a successful save
-    post_local_to_server = [&](const std::string &sketch_name, sketch::SketchPad &sketchpad) -> bool {
+    // Blueprint API target for one sketch: <path>/api/workstation/blueprint/<action>/<enc_ws>/<enc_bp>
+    auto blueprint_endpoint = [&](const std::string &action, const std::string &sketch_name) -> std::string {
         const char *secret_env = std::getenv("JARVIS_SECRET");
         std::string secret = secret_env ? std::string(secret_env) : std::string();
         std::string enc_workstation = device_id;
@@ -692,62 +833,34 @@ int main(int argc, char **argv)
             enc_blueprint = crypto::aes256_encrypt(sketch_name, secret);
         }
 
-        auto make_blueprint_endpoint = [&](const std::string &action) -> std::string {
-            std::string prefix = path;
-            if (!prefix.empty() && prefix[0] != '/')
-                prefix = std::string("/") + prefix;
-            std::string target;
-            if (prefix.find("/api/workstation/blueprint") != std::string::npos)
-            {
-                if (prefix.back() != '/')
-                    prefix += '/';
-                target = prefix + enc_workstation + "/" + enc_blueprint;
-            }
-            else
-            {
-                if (!prefix.empty() && prefix.back() != '/')
-                    prefix += '/';
-                target = prefix + std::string("api/workstation/blueprint/") + action + "/" + enc_workstation + "/" + enc_blueprint;
-            }
-            if (target.empty() || target[0] != '/')
-                target = std::string("/") + target;
-            return target;
-        };
-
-        std::string save_path = make_blueprint_endpoint("save");
-        // Read local file JSON to include as `data` in request
-        std::string local_path = sketchpad.get_last_loaded_path();
-        if (local_path.empty())
+        std::string prefix = path;
+        if (!prefix.empty() && prefix[0] != '/')
+            prefix = std::string("/") + prefix;
+        std::string target;
+        if (prefix.find("/api/workstation/blueprint") != std::string::npos)
         {
-            local_path = std::string("blueprints/") + sketch_name;
-            if (local_path.find(".jarvis") == std::string::npos)
-                local_path += ".jarvis";
+            if (prefix.back() != '/')
+                prefix += '/';
+            target = prefix + enc_workstation + "/" + enc_blueprint;
         }
-
-        std::string local_contents;
+        else
         {
-            FILE *f = fopen(local_path.c_str(), "rb");
-                if (!f)
-                {
-                    std::cerr << "[Server] Cannot open local file to POST: " << local_path << "\n";
-                    return false;
-                }
-            fseek(f, 0, SEEK_END);
-            long sz = ftell(f);
-            fseek(f, 0, SEEK_SET);
-            if (sz > 0)
-            {
-                local_contents.resize(sz);
-                fread(&local_contents[0], 1, sz, f);
-            }
-            fclose(f);
+            if (!prefix.empty() && prefix.back() != '/')
+                prefix += '/';
+            target = prefix + std::string("api/workstation/blueprint/") + action + "/" + enc_workstation + "/" + enc_blueprint;
         }
+        if (target.empty() || target[0] != '/')
+            target = std::string("/") + target;
+        return target;
+    };
 
-        if (local_contents.empty())
-        {
-            std::cerr << "[Server] Local file empty, not posting\n";
-            return false;
-        }
+    // Helper: POST a signed JSON export to the server without blocking the
+    // caller. The future resolves once the server has answered; failures are
+    // queued in the outbox.
+    post_blueprint_async = [&](const std::string &sketch_name, const std::string &local_contents) -> std::future<bool> {
+        std::string save_path = blueprint_endpoint("save", sketch_name);
+        auto posted = std::make_shared<std::promise<bool>>();
+        std::future<bool> result = posted->get_future();
 
         try
         {
@@ -756,58 +869,114 @@ int main(int argc, char **argv)
             payload["name"] = sketch_name;
             payload["data"] = meta;
 
-            HttpClient client;
-            std::string resp = client.post(host, port, save_path, payload.dump(), "application/json", 3000, server_use_tls);
-            if (resp.empty())
-            {
-                std::cerr << "[Server] POST failed: " << client.last_error() << "\n";
-                // Queue the payload for later retry in blueprints/_outbox
-                std::string outdir = std::string("blueprints/_outbox");
-                struct stat st = {};
-                if (::stat(outdir.c_str(), &st) != 0)
+            HttpRequest request;
+            request.method = "POST";
+            request.host = host;
+            request.port = port;
+            request.path = save_path;
+            request.body = payload.dump();
+            request.use_tls = server_use_tls;
+            // Runs on the reactor thread, which must not block: a failed
+            // upload is queued from outbox_requeue, and the future resolves
+            // once it is in the outbox
+            async_http.send(std::move(request), [sketch_name, local_contents, posted, &queue_outbox_post,
+                                                 &outbox_requeue](HttpResponse resp) {
+                if (!resp.ok)
                 {
-                    ::mkdir("blueprints", 0755);
-                    ::mkdir(outdir.c_str(), 0755);
+                    std::cerr << "[Server] POST failed: " << resp.error << "\n";
+                    outbox_requeue.submit([sketch_name, local_contents, posted, &queue_outbox_post]() {
+                        queue_outbox_post(sketch_name, local_contents);
+                        posted->set_value(false);
+                    });
+                    return;
                 }
-                std::string pending = outdir + "/" + sketch_name + ".pending.json";
-                int fd = open((pending + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
-                if (fd >= 0)
-                {
-                    const std::string bodystr = payload.dump(2) + "\n";
-                    const char *ptr = bodystr.data();
-                    size_t left = bodystr.size();
-                    while (left > 0)
-                    {
-                        ssize_t w = write(fd, ptr, left);
-                        if (w <= 0)
-                        {
-                            if (errno == EINTR) continue;
-                            break;
-                        }
-                        left -= static_cast<size_t>(w);
-                        ptr += w;
-                    }
-                    fsync(fd);
-                    close(fd);
-                    rename((pending + ".tmp").c_str(), pending.c_str());
-                    std::cerr << "[Server] Queued POST for later: " << pending << "\n";
-                }
-                else
+                std::cout << "[Server] Posted local changes to server (response length: " << resp.body.size() << ")\n";
+                posted->set_value(true);
+            });
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[Server] Failed to parse exported JSON before POST: " << e.what() << "\n";
+            posted->set_value(false);
+        }
+        return result;
+    };
+
+    // Blocking form, for callers already off the drawing thread (the persist worker)
+    auto post_blueprint_json = [&](const std::string &sketch_name, const std::string &local_contents) -> bool {
+        return post_blueprint_async(sketch_name, local_contents).get();
+    };
+
+    // Runs a delta pass for a saved snapshot; true if the server is up to
+    // date. Server changes merged into the pad are saved right away.
+    auto sync_blueprint = [&](sketch::SketchPad &pad, const sketch::SaveSnapshot &snapshot) -> bool {
+        const std::string &sketch_name = snapshot.sketch.name;
+        sketch::BlueprintSync *sync = blueprint_sync_for(sketch_name);
+        if (sync)
+        {
+            uint64_t merges = sync->stats().merges;
+            sketch::SyncResult result = sync->sync(pad, snapshot);
+            if (result == sketch::SyncResult::SYNCED || result == sketch::SyncResult::UP_TO_DATE)
+            {
+                if (sync->stats().merges != merges)
                 {
-                    std::cerr << "[Server] Failed to queue POST: cannot open " << pending << "\n";
+                    std::cout << "[Server] Merged server changes into '" << sketch_name << "'\n";
+                    pad.save(sketch_name);
                 }
-                return false;
+                return true;
             }
-            else
+            if (result == sketch::SyncResult::FAILED)
             {
-                std::cout << "[Server] Posted local changes to server (response length: " << resp.size() << ")\n";
-                return true;
+                std::cerr << "[Server] Sync of '" << sketch_name << "' failed: " << sync->last_error() << "\n";
+                queue_outbox_post(sketch_name, sketch::export_json_blueprint(snapshot.sketch, snapshot.grid,
+                                                                             sketch::blueprint_secret()));
+                return false;
             }
+            std::cerr << "[Server] Server has no delta sync; uploading full blueprints\n";
+            delta_sync_unsupported = true;
         }
-        catch (const std::exception &e)
+        return post_blueprint_json(sketch_name, sketch::export_json_blueprint(snapshot.sketch, snapshot.grid,
+                                                                              sketch::blueprint_secret()));
+    };
+    // Delta pushes started from the command loops run here, one at a time
+    jarvis::WorkerPool sync_uploads(1);
+
+    // Helper: send local changes to the server after a successful save
+    // Returns once the upload is queued; the result is logged when it lands.
+    post_local_to_server = [&](const std::string &sketch_name, sketch::SketchPad &sketchpad) -> bool {
+        sketch::BlueprintSync *sync = blueprint_sync_for(sketch_name);
+        if (!sync)
         {
-            std::cerr << "[Server] Failed to parse local file JSON before POST: " << e.what() << "\n";
+            // Local files are binary blueprints; the server speaks the signed JSON export
+            post_blueprint_async(sketch_name, sketchpad.export_json());
+            return true;
         }
+        // Only the lines changed since the last sync go out. The pad may be
+        // gone by the time this runs, so it pushes from a copy and leaves
+        // merging server changes to the next full pass.
+        auto snapshot = std::make_shared<sketch::SaveSnapshot>(sketchpad.snapshot_content());
+        sync_uploads.submit([&, sync, sketch_name, snapshot]() {
+            switch (sync->push(*snapshot))
+            {
+            case sketch::SyncResult::UP_TO_DATE:
+            case sketch::SyncResult::SYNCED:
+                break;
+            case sketch::SyncResult::CONFLICT:
+                std::cerr << "[Server] '" << sketch_name << "' changed on the server; merging on the next sync\n";
+                break;
+            case sketch::SyncResult::UNSUPPORTED:
+                delta_sync_unsupported = true;
+                post_blueprint_async(sketch_name, sketch::export_json_blueprint(snapshot->sketch, snapshot->grid,
+                                                                                sketch::blueprint_secret()));
+                break;
+            case sketch::SyncResult::FAILED:
+                std::cerr << "[Server] Push of '" << sketch_name << "' failed: " << sync->last_error() << "\n";
+                queue_outbox_post(sketch_name, sketch::export_json_blueprint(snapshot->sketch, snapshot->grid,
+                                                                             sketch::blueprint_secret()));
+                break;
+            }
+        });
+        return true;
     };
 
     
@@ -862,27 +1031,63 @@ int main(int argc, char **argv)
         // allows JARVIS_SERVER to be a simple base like "http://host:3000" or "https://host".
     }
 
-    // Attempt to process any queued outbound posts (retry previous failures)
-    process_outbox();
+    // Retry uploads that failed in earlier runs; later failures join them.
+    // Several queued blueprints go out in one request when the server has
+    // the batch endpoint (not when JARVIS_SERVER pins the blueprint API).
+    {
+        std::string enc_workstation = secret.empty() ? device_id : crypto::aes256_encrypt(device_id, secret);
+        std::string prefix = path;
+        if (prefix.empty() || prefix.back() != '/')
+            prefix += '/';
+        sketch::OutboxConfig outbox_config;
+        outbox_config.host = host;
+        outbox_config.port = port;
+        outbox_config.use_tls = server_use_tls;
+        outbox_config.save_path = [&](const std::string &sketch_name) {
+            return blueprint_endpoint("save", sketch_name);
+        };
+        if (path.find("/api/workstation/blueprint") == std::string::npos)
+            outbox_config.batch_path = prefix + "api/workstation/blueprint/batch/" + enc_workstation;
+        outbox.reset(new sketch::BlueprintOutbox(async_http, "blueprints/_outbox", outbox_config));
+    }
+
+    // Listing and lookup use the store index (tools/jarvis_store); only
+    // blueprints changed since it was written are read (and verified)
+    // here, across a worker pool.
+    sketch::BlueprintIndex blueprint_index;
+    const std::string blueprint_index_path = std::string("blueprints/") + sketch::kBlueprintIndexFile;
+    blueprint_index.load(blueprint_index_path);
+    if (blueprint_index.refresh("blueprints", sketch::blueprint_secret()) > 0)
+        blueprint_index.save(blueprint_index_path);
+    std::cerr << "Blueprints: " << blueprint_index.size() << " saved locally.\n";
 
     std::cerr << "Polling server http://" << host << ":" << port << path << " for lines.\n";
     std::cerr << "Commands:\n";
     std::cerr << "  <Enter>      - Render a frame\n";
     std::cerr << "  blueprint    - Drawing mode (follow index finger)\n";
+    std::cerr << "  multi <n> [name] - Drawing mode on n camera/projector surfaces\n";
+    std::cerr << "  live         - Follow line events from the server (Enter stops)\n";
     std::cerr << "  show-config  - Print resolved server and env settings\n";
     std::cerr << "  test         - Production hand detector (testing)\n";
+    std::cerr << "  list         - List saved blueprints\n";
     std::cerr << "  load <name>  - Load a .jarvis sketch\n";
     std::cerr << "  stop         - Exit\n";
 
+    // Lines of the last poll; an unchanged response is not redrawn
+    renderer::DotsFrame dots_frame;
+
     while (true)
     {
         std::string line;
         std::getline(std::cin, line);
+        if (!line.empty())
+            dots_frame.invalidate(); // other modes draw over the poll result
 
         if (line.empty())
         {
             // User pressed Enter; fetch and render
-            bool ok = renderer::render_frame(host, port, path, use_gbm, bo, dumb_map, dumb_pitch, width, height);
+            bool ok = renderer::render_frame(host, port, path, use_gbm, bo, dumb_map, dumb_pitch, width, height,
+                                             dots_frame);
             if (ok)
             {
                 if (drmModeSetCrtc(fd, crtc_id, fb_id, 0, 0, &conn_id, 1, &mode))
@@ -892,6 +1097,53 @@ int main(int argc, char **argv)
                 }
             }
         }
+        else if (line == "live")
+        {
+            // Subscribe to line add/remove events and repaint only what changed
+            renderer::LiveConfig live_config;
+            live_config.host = host;
+            live_config.port = port;
+            live_config.use_tls = server_use_tls;
+            live_config.path = (path.size() > 1 && path.back() == '/' ? path.substr(0, path.size() - 1) : path) + "/events";
+            if (const char *env_live = std::getenv("JARVIS_LIVE_PATH"); env_live && *env_live)
+                live_config.path = trim_ws(env_live);
+            renderer::LiveLineSubscriber live(live_config);
+            renderer::LiveLineSet live_lines(width, height);
+            live.start();
+            std::cerr << "[Live] Following " << live_config.path << "; press Enter to stop\n";
+
+            int stdin_flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+            fcntl(STDIN_FILENO, F_SETFL, stdin_flags | O_NONBLOCK);
+
+            renderer::DirtyRect dirty;
+            dirty.add(0, 0, static_cast<int>(width), static_cast<int>(height));
+            bool quit = false;
+            while (!quit)
+            {
+                if (!dirty.empty())
+                {
+                    if (renderer::render_region(live_lines, dirty, use_gbm, bo, dumb_map, dumb_pitch, width, height) &&
+                        drmModeSetCrtc(fd, crtc_id, fb_id, 0, 0, &conn_id, 1, &mode))
+                        std::cerr << "drmModeSetCrtc failed during live render: " << strerror(errno) << "\n";
+                    dirty = renderer::DirtyRect();
+                }
+                live.apply(live_lines, dirty, 50);
+                if (live.unsupported())
+                {
+                    std::cerr << "[Live] Server has no line events; press Enter to poll instead\n";
+                    break;
+                }
+                char buf[16];
+                if (read(STDIN_FILENO, buf, sizeof(buf)) > 0)
+                    quit = true;
+            }
+
+            live.stop();
+            fcntl(STDIN_FILENO, F_SETFL, stdin_flags);
+            renderer::LiveStats live_stats = live.stats();
+            std::cerr << "[Live] Stopped: " << live_stats.events << " events in " << live_stats.requests
+                      << " requests, " << live_lines.size() << " lines on screen\n";
+        }
         else if (line == "blueprint")
         {
             // Drawing mode - follow index finger to draw
@@ -935,12 +1187,16 @@ int main(int argc, char **argv)
 
             std::cerr << "\n[SYSTEM] Initializing camera subsystem...\n";
 
-            camera::Camera cam;
             camera::CameraConfig cam_config;
             cam_config.width = 1280;
             cam_config.height = 720;
             cam_config.framerate = 30;
+            cam_config.lores_width = 640; // half-size detection stream
+            cam_config.lores_height = 360;
             cam_config.verbose = false;
+            // The camera, or a recording when --replay / JARVIS_REPLAY is set
+            std::unique_ptr<camera::FrameSource> source = camera::make_frame_source(cam_config);
+            camera::FrameSource &cam = *source;
 
             if (!cam.init(cam_config))
             {
@@ -980,19 +1236,45 @@ int main(int argc, char **argv)
             std::cerr << "[SYSTEM] Hand detection initialized\n";
             std::cerr << "[SYSTEM] Features: Multi-frame tracking, Adaptive lighting, Gesture stabilization\n";
 
+            // Saves, signing and uploads run on this worker; the loop below
+            // only snapshots the sketch (declared first so it outlives the pad)
+            sketch::PersistWorker persist_worker{sketch::PersistWorker::SnapshotUploader(sync_blueprint)};
+            auto report_persist_results = [&persist_worker, &sketch_name]() {
+                for (const auto &r : persist_worker.take_results())
+                {
+                    if (!r.saved)
+                    {
+                        std::cerr << "\n[ERROR] Save failed: '" << r.path << "'\n";
+                        continue;
+                    }
+                    std::cerr << "\n[SYSTEM] ✓ Project saved: '" << sketch_name << ".jarvis'";
+                    if (r.upload_attempted)
+                        std::cerr << (r.uploaded ? " (synced)" : " (upload queued)");
+                    std::cerr << "\n";
+                }
+            };
+
             // Initialize enterprise sketch pad
             sketch::SketchPad sketchpad(width, height);
             sketchpad.init(sketch_name, width, height);
-            // Ensure every successful local save also triggers a POST to server
-            sketchpad.set_on_save_callback([&](const std::string &saved_path) {
-                // best-effort: post local file to server after each save
-                post_local_to_server(sketch_name, sketchpad);
-            });
+            // Detections arrive in camera pixels; table-mounted setups map
+            // them through the projector calibration when one is present
+            sketchpad.set_camera_resolution(cam_config.width, cam_config.height);
+            {
+                const char *calib = std::getenv("JARVIS_CALIBRATION");
+                sketchpad.load_calibration(calib ? calib : "blueprints/_calibration.json");
+            }
+            // Projector/scanout latency the process can't measure itself
+            if (const char *lat = std::getenv("JARVIS_DISPLAY_LATENCY_MS"))
+                sketchpad.set_display_latency_ms(std::strtof(lat, nullptr));
             // If a .jarvis exists for this sketch name, load it so user can update existing blueprint
             if (sketchpad.load(sketch_name))
             {
                 std::cerr << "[SketchPad] Loaded existing project: '" << sketch_name << "'\n";
             }
+            // Every save from here on (including the auto-save after each
+            // line) is written and POSTed to the server by the worker
+            sketchpad.set_persist_worker(&persist_worker);
             sketchpad.set_color(0x00FFFFFF);      // White for projection
             sketchpad.set_thickness(4);           // Clear lines for architects
             sketchpad.set_confirmation_frames(2); // 2 frame confirmation with tolerance
@@ -1108,6 +1390,7 @@ int main(int argc, char **argv)
             std::cerr << "║    's' - Save project                                      ║\n";
             std::cerr << "║    'c' - Clear all lines                                   ║\n";
             std::cerr << "║    'i' - Show project info                                 ║\n";
+            std::cerr << "║    'v' - Toggle camera overlay (check calibration)         ║\n";
             std::cerr << "║    'q' - Quit and save                                     ║\n";
             std::cerr << "╚════════════════════════════════════════════════════════════╝\n\n";
 
@@ -1125,6 +1408,8 @@ int main(int argc, char **argv)
             bool have_last_tip = false;
             bool have_start_point = false;
             sketch::Point start_point_percent(0, 0);
+            // Camera image warped into display space under the sketch
+            bool show_camera_overlay = false;
 
             while (!quit)
             {
@@ -1149,6 +1434,8 @@ int main(int argc, char **argv)
                 // Detect hands
                 auto detections = detector.detect(*frame);
                 frame_counter++;
+                if (auto *bus = detection_bus())
+                    bus->publish(frame->sequence, frame->timestamp_ns, frame->width, frame->height, detections);
 
                 // Auto-calibrate on first good detection
                 if (!calibrated && !detections.empty() &&
@@ -1161,52 +1448,26 @@ int main(int argc, char **argv)
                     }
                 }
 
-                // Display detection info (similar to test mode)
-                if (!detections.empty() || frame_counter % 30 == 0)
-                {
-                    std::cout << "[frame " << frame_counter << "] " << detections.size() << " hand(s)";
-                    if (detections.empty())
-                    {
-                        std::cout << "\n";
-                    }
-                }
+                // Detection summary goes through the async logger, which also
+                // rate limits it, so the draw loop never blocks on terminal output
+                JLOG_EVERY_N(logger::Level::Info, "Blueprint", 10)
+                    << "[frame " << frame->sequence << "] " << detections.size() << " hand(s)"
+                    << " missed=" << cam.get_missed_frames();
 
                 for (size_t i = 0; i < detections.size(); ++i)
                 {
                     const auto &hand = detections[i];
-                    std::string label = hand_detector::HandDetector::gesture_to_string(hand.gesture);
-
-                    // Highlight drawing gestures
-                    if (hand.gesture == hand_detector::Gesture::OPEN_PALM)
-                        label = "OPEN PALM ✋";
-                    else if (hand.gesture == hand_detector::Gesture::FIST)
-                        label = "FIST ✊";
-                    else if (hand.gesture == hand_detector::Gesture::POINTING)
-                        label = "POINTING ☝ [DRAWING]";
-                    else if (hand.gesture == hand_detector::Gesture::PEACE)
-                        label = "PEACE ✌ [DRAWING]";
-                    else if (hand.gesture == hand_detector::Gesture::OK_SIGN)
-                        label = "OK 👌";
-
-                    std::cout << "\n  ➜ Hand #" << (i + 1)
-                              << ": " << label
-                              << " | fingers=" << hand.num_fingers
-                              << " | conf=" << (int)(hand.bbox.confidence * 100) << "%"
-                              << " | pos=(" << (int)hand.center.x << "," << (int)hand.center.y << ")";
-
-                    // Show fingertip position if available
-                    if (!hand.fingertips.empty())
-                    {
-                        std::cout << " | tip=(" << (int)hand.fingertips[0].x << "," << (int)hand.fingertips[0].y << ")";
-                    }
-                }
-                if (!detections.empty())
-                {
-                    std::cout << "\n";
+                    JLOG_DEBUG("Blueprint") << "  ➜ Hand #" << (i + 1)
+                                         << ": " << hand_detector::HandDetector::gesture_to_string(hand.gesture)
+                                         << " | fingers=" << hand.num_fingers
+                                         << " | conf=" << (int)(hand.bbox.confidence * 100) << "%"
+                                         << " | pos=(" << (int)hand.center.x << "," << (int)hand.center.y << ")"
+                                         << " | tip=(" << (hand.fingertips.empty() ? -1 : (int)hand.fingertips[0].x)
+                                         << "," << (hand.fingertips.empty() ? -1 : (int)hand.fingertips[0].y) << ")";
                 }
 
                 // Update sketch with hand detections
-                sketchpad.update(detections);
+                sketchpad.update(detections, frame->timestamp_ns);
 
                 // Track last fingertip when pointing/peace gestures are detected
                 if (!detections.empty())
@@ -1235,9 +1496,9 @@ int main(int argc, char **argv)
                             px = best_hand->center.x;
                             py = best_hand->center.y;
                         }
-                        last_tip_percent = sketch::Point::from_pixels(px, py, sketchpad.get_sketch().width, sketchpad.get_sketch().height);
+                        last_tip_percent = sketchpad.camera_to_display(px, py);
                         have_last_tip = true;
-                        std::cerr << "[Blueprint] Last tip: (" << last_tip_percent.x << "," << last_tip_percent.y << ")\n";
+                        JLOG_EVERY_N(logger::Level::Debug, "Blueprint", 30) << "Last tip: (" << last_tip_percent.x << "," << last_tip_percent.y << ")";
                     }
                 }
 
@@ -1262,6 +1523,8 @@ int main(int argc, char **argv)
                     {
                         // Clear background (black for projector)
                         draw_ticker::clear_buffer(map_data, map_stride, width, height, 0x00000000);
+                        if (show_camera_overlay)
+                            sketchpad.render_camera_overlay(*frame, map_data, map_stride, width, height);
 
                         // Render sketch with anti-aliasing
                         sketchpad.render(map_data, map_stride, width, height);
@@ -1284,11 +1547,19 @@ int main(int argc, char **argv)
                         // Use fb0 resolution for render
                         // We assume sketchpad was re-init'd to fb resolution when mapping occurred
                         draw_ticker::clear_buffer(fb0_map, fb0_stride, sketchpad.get_sketch().width, sketchpad.get_sketch().height, 0x00000000);
+                        if (show_camera_overlay)
+                            sketchpad.render_camera_overlay(*frame, fb0_map, fb0_stride, sketchpad.get_sketch().width,
+                                                            sketchpad.get_sketch().height);
                         sketchpad.render(fb0_map, fb0_stride, sketchpad.get_sketch().width, sketchpad.get_sketch().height);
                         msync(fb0_map, fb0_size, MS_SYNC);
                     }
+                    // Measured capture -> display latency drives fingertip prediction
+                    sketchpad.note_frame_displayed(frame->timestamp_ns);
                 }
 
+                // Completed background saves/uploads
+                report_persist_results();
+
                 // Check for commands
                 char buf[16];
                 ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
@@ -1299,24 +1570,18 @@ int main(int argc, char **argv)
                         char c = buf[i];
                         if (c == 'q' || c == 'Q')
                         {
-                            // Save and quit
+                            // Save and quit: wait for the queued write and upload
                             if (sketchpad.save(sketch_name))
                             {
-                                std::cerr << "\n[SYSTEM] ✓ Project saved: '" << sketch_name << ".jarvis'\n";
-                                // Attempt to post local changes to server (best-effort)
-                                post_local_to_server(sketch_name, sketchpad);
+                                persist_worker.flush();
+                                report_persist_results();
                             }
                             quit = true;
                             break;
                         }
                         if (c == 's' || c == 'S')
                         {
-                            if (sketchpad.save(sketch_name))
-                            {
-                                std::cerr << "\n[SYSTEM] ✓ Project saved: '" << sketch_name << ".jarvis'\n";
-                                post_local_to_server(sketch_name, sketchpad);
-                            }
-                            else
+                            if (!sketchpad.save(sketch_name))
                             {
                                 std::cerr << "\n[ERROR] Save failed\n";
                             }
@@ -1328,16 +1593,16 @@ int main(int argc, char **argv)
                             have_start_point = false;
                             have_last_tip = false;
                             // Persist cleared state
-                            if (sketchpad.save(sketch_name))
-                            {
-                                std::cerr << "[SYSTEM] ✓ Cleared project saved: '" << sketch_name << ".jarvis'\n";
-                                post_local_to_server(sketch_name, sketchpad);
-                            }
-                            else
+                            if (!sketchpad.save(sketch_name))
                             {
                                 std::cerr << "[ERROR] Failed to save cleared project\n";
                             }
                         }
+                        if (c == 'v' || c == 'V')
+                        {
+                            show_camera_overlay = !show_camera_overlay;
+                            std::cerr << "\n[SYSTEM] Camera overlay " << (show_camera_overlay ? "on" : "off") << "\n";
+                        }
                         if (c == 'i' || c == 'I')
                         {
                             std::cerr << "\n╔════════════════════════════════════════════════════════════╗\n";
@@ -1392,13 +1657,8 @@ int main(int argc, char **argv)
                                 std::cerr << "[Blueprint] END set at (" << end_point.x << "," << end_point.y << ") - Line created.\n";
                                 have_start_point = false; // reset for next line
                                 sketchpad.clear_manual_start();
-                                    // Persist new line immediately
-                                    if (sketchpad.save(sketch_name))
-                                    {
-                                        std::cerr << "[SketchPad] ✔ Saved project: '" << sketch_name << ".jarvis'\n";
-                                        post_local_to_server(sketch_name, sketchpad);
-                                    }
-                                    else
+                                    // Persist new line (written by the worker)
+                                    if (!sketchpad.save(sketch_name))
                                     {
                                         std::cerr << "[SketchPad] ✖ Failed to save project: '" << sketch_name << "'\n";
                                     }
@@ -1412,18 +1672,143 @@ int main(int argc, char **argv)
             cam.stop();
             std::cerr << "\n[SYSTEM] Enterprise drawing session ended.\n\n";
         }
+        else if (line.substr(0, 5) == "multi")
+        {
+            // Several tables from one process: camera i drives viewport i
+            // (side-by-side columns of the display, one per projector)
+            size_t count = 2;
+            std::string base_name = "table";
+            {
+                std::istringstream args(line.substr(5));
+                args >> count >> base_name;
+                if (count == 0 || count > 4)
+                    count = 2;
+            }
+
+            sketch::SurfaceConfig base;
+            base.name = base_name;
+            base.camera.width = 1280;
+            base.camera.height = 720;
+            base.camera.framerate = 30;
+            base.camera.lores_width = 640;
+            base.camera.lores_height = 360;
+            base.detector.enable_gesture = true;
+            base.detector.min_hand_area = 2000;
+            base.detector.downscale_factor = 2;
+            base.production.gesture_stabilization_frames = 10;
+            base.production.tracking_history_frames = 5;
+            base.production.min_detection_quality = 0.5f;
+
+            sketch::MultiSurfaceRunner runner;
+            auto configs = sketch::MultiSurfaceRunner::split_viewports(base, count, width, height);
+            for (size_t i = 0; i < configs.size(); ++i)
+            {
+                configs[i].calibration_path = "blueprints/_calibration_" + std::to_string(i) + ".json";
+                sketch::Surface &surface = runner.add_surface(configs[i]);
+                sketch::SketchPad &pad = surface.pad();
+                std::string name = configs[i].name;
+                pad.set_on_save_callback([&post_local_to_server, &pad, name](const std::string &) {
+                    post_local_to_server(name, pad);
+                });
+                if (pad.load(name))
+                    std::cerr << "[Multi] Loaded existing project: '" << name << "'\n";
+                pad.set_color(0x00FFFFFF);
+                pad.set_thickness(4);
+                pad.set_confirmation_frames(2);
+                pad.set_grid_enabled(true);
+                pad.set_snap_to_grid(true);
+                pad.set_show_measurements(true);
+            }
+
+            if (!runner.start_all())
+            {
+                std::cerr << "[ERROR] Not all cameras started; check `rpicam-hello --list-cameras`\n";
+                runner.stop();
+                continue;
+            }
+            std::cerr << "[SYSTEM] " << count << " surfaces running. Commands: 's' save all, 'c' clear all, 'q' quit and save\n";
+
+            int stdin_flags = fcntl(STDIN_FILENO, F_GETFL, 0);
+            fcntl(STDIN_FILENO, F_SETFL, stdin_flags | O_NONBLOCK);
+
+            auto save_all = [&]() {
+                for (size_t i = 0; i < runner.size(); ++i)
+                {
+                    sketch::Surface &surface = runner.surface(i);
+                    if (!surface.pad().save(surface.config().name))
+                        std::cerr << "[ERROR] Save failed for '" << surface.config().name << "'\n";
+                }
+            };
+
+            bool quit = false;
+            while (!quit)
+            {
+                // Queue one step per idle surface; each waits on its own camera
+                runner.pump();
+
+                void *map_data = nullptr;
+                uint32_t map_stride = 0;
+                if (use_gbm)
+                {
+                    map_data = gbm_bo_map(bo, 0, 0, width, height,
+                                          GBM_BO_TRANSFER_WRITE, &map_stride, &map_data);
+                }
+                else
+                {
+                    map_stride = dumb_pitch;
+                    map_data = dumb_map;
+                }
+                if (map_data)
+                {
+                    runner.render_all(map_data, map_stride, width, height);
+                    if (use_gbm)
+                        gbm_bo_unmap(bo, map_data);
+                    if (drmModeSetCrtc(fd, crtc_id, fb_id, 0, 0, &conn_id, 1, &mode))
+                        std::cerr << "[ERROR] Display update failed\n";
+                }
+
+                char buf[16];
+                ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+                for (ssize_t i = 0; i < n; ++i)
+                {
+                    char c = buf[i];
+                    if (c == 'q' || c == 'Q')
+                        quit = true;
+                    else if (c == 's' || c == 'S')
+                        save_all();
+                    else if (c == 'c' || c == 'C')
+                    {
+                        for (size_t k = 0; k < runner.size(); ++k)
+                            runner.surface(k).pad().clear();
+                        save_all();
+                    }
+                }
+
+                // Render at roughly camera rate; the workers do the heavy lifting
+                usleep(33000);
+            }
+
+            runner.stop();
+            save_all();
+            fcntl(STDIN_FILENO, F_SETFL, stdin_flags);
+            std::cerr << "\n[SYSTEM] Multi-surface session ended.\n\n";
+        }
         else if (line == "test")
         {
             // Production hand recognition mode
             std::cerr << "\n=== JARVIS Production Hand Recognition Mode ===\n";
             std::cerr << "Initializing camera...\n";
 
-            camera::Camera cam;
             camera::CameraConfig cam_config;
             cam_config.width = 1920;
             cam_config.height = 1080;
             cam_config.framerate = 30;
+            cam_config.lores_width = 960; // half-size detection stream
+            cam_config.lores_height = 540;
             cam_config.verbose = true;
+            // The camera, or a recording when --replay / JARVIS_REPLAY is set
+            std::unique_ptr<camera::FrameSource> source = camera::make_frame_source(cam_config);
+            camera::FrameSource &cam = *source;
 
             if (!cam.init(cam_config))
             {
@@ -1504,6 +1889,8 @@ int main(int argc, char **argv)
 
                 auto detections = detector.detect(*frame);
                 frame_counter++;
+                if (auto *bus = detection_bus())
+                    bus->publish(frame->sequence, frame->timestamp_ns, frame->width, frame->height, detections);
 
                 // Auto-calibrate on first good detection
                 if (!calibrated && !detections.empty() &&
@@ -1519,7 +1906,7 @@ int main(int argc, char **argv)
                 // Only log when detections occur or every 30 frames
                 if (!detections.empty() || frame_counter % 30 == 0)
                 {
-                    std::cout << "[frame " << frame_counter << "] " << detections.size() << " hand(s)";
+                    std::cout << "[frame " << frame->sequence << "] " << detections.size() << " hand(s)";
                     if (detections.empty())
                     {
                         std::cout << "\n";
@@ -1630,7 +2017,35 @@ int main(int argc, char **argv)
             std::cerr << "  TLS enabled: " << (server_use_tls ? "yes" : "no") << "\n";
             const char *dev = std::getenv("JARVIS_DEVICE_ID");
             std::cerr << "  JARVIS_DEVICE_ID: " << (dev ? dev : "(not set)") << "\n";
-            std::cerr << "  JARVIS_SECRET set: " << (std::getenv("JARVIS_SECRET") ? "yes" : "no") << "\n\n";
+            std::cerr << "  JARVIS_SECRET set: " << (std::getenv("JARVIS_SECRET") ? "yes" : "no") << "\n";
+            HttpCacheStats cache = HttpClient::cache_stats();
+            std::cerr << "  Blueprint cache: " << cache.hits << " hits, " << cache.misses << " misses, "
+                      << cache.bytes_downloaded << " bytes downloaded, " << cache.bytes_saved << " bytes saved\n";
+            if (outbox)
+            {
+                sketch::OutboxStats queued = outbox->stats();
+                std::cerr << "  Upload outbox: " << queued.pending << " pending, " << queued.uploaded << " uploaded, "
+                          << queued.failed << " failed attempts, " << queued.coalesced << " coalesced, "
+                          << queued.batches << " batches\n";
+            }
+            std::cerr << "\n";
+            continue;
+        }
+        else if (line == "list")
+        {
+            // Only blueprints changed since the last listing are re-read
+            if (blueprint_index.refresh("blueprints", sketch::blueprint_secret()) > 0)
+                blueprint_index.save(blueprint_index_path);
+            std::cerr << "\n" << blueprint_index.size() << " blueprint(s):\n";
+            for (const auto &entry : blueprint_index.entries())
+            {
+                std::cerr << "  " << std::left << std::setw(24) << entry.name << std::right << std::setw(6)
+                          << entry.line_count << " lines" << std::fixed << std::setprecision(0) << "  ["
+                          << entry.min_x << "," << entry.min_y << " - " << entry.max_x << "," << entry.max_y
+                          << "%]" << ((entry.flags & sketch::kIndexVerified) ? "" : "  (signature mismatch)")
+                          << "\n";
+            }
+            std::cerr << std::defaultfloat << "\n";
             continue;
         }
         else if (line.substr(0, 5) == "load ")
@@ -1651,6 +2066,8 @@ int main(int argc, char **argv)
 
             std::cerr << "\n=== JARVIS Load Sketch Mode ===\n";
             std::cerr << "Loading sketch: '" << sketch_name << "'\n";
+            if (const sketch::BlueprintIndexEntry *indexed = blueprint_index.find(sketch_name))
+                std::cerr << "Local copy: " << indexed->line_count << " lines\n";
 
             // Load sketch (attempt server sync first). Set on-save callback before
             // fetching so any immediate saves/uploads are wired.
@@ -1668,6 +2085,14 @@ int main(int argc, char **argv)
             {
                 std::cerr << "Failed to fetch or load sketch '" << sketch_name << "' (no server and no valid local file)\n";
                 std::cerr << "Make sure 'blueprints/" << sketch_name << ".jarvis' exists and is valid.\n";
+                std::vector<const sketch::BlueprintIndexEntry *> similar = blueprint_index.with_prefix(sketch_name);
+                if (!similar.empty())
+                {
+                    std::cerr << "Saved blueprints starting with '" << sketch_name << "':";
+                    for (size_t i = 0; i < similar.size() && i < 8; ++i)
+                        std::cerr << " " << similar[i]->name;
+                    std::cerr << "\n";
+                }
                 continue;
             }
 
@@ -1777,12 +2202,16 @@ int main(int argc, char **argv)
             std::cerr << "Entering interactive edit mode for loaded sketch...\n";
 
             // Initialize camera for interactive editing
-            camera::Camera cam;
             camera::CameraConfig cam_config;
             cam_config.width = 1280;
             cam_config.height = 720;
             cam_config.framerate = 30;
+            cam_config.lores_width = 640; // half-size detection stream
+            cam_config.lores_height = 360;
             cam_config.verbose = false;
+            // The camera, or a recording when --replay / JARVIS_REPLAY is set
+            std::unique_ptr<camera::FrameSource> source = camera::make_frame_source(cam_config);
+            camera::FrameSource &cam = *source;
 
             if (!cam.init(cam_config))
             {
@@ -1797,6 +2226,17 @@ int main(int argc, char **argv)
                 continue;
             }
 
+            // Detections arrive in camera pixels; table-mounted setups map
+            // them through the projector calibration when one is present
+            sketchpad.set_camera_resolution(cam_config.width, cam_config.height);
+            {
+                const char *calib = std::getenv("JARVIS_CALIBRATION");
+                sketchpad.load_calibration(calib ? calib : "blueprints/_calibration.json");
+            }
+            // Projector/scanout latency the process can't measure itself
+            if (const char *lat = std::getenv("JARVIS_DISPLAY_LATENCY_MS"))
+                sketchpad.set_display_latency_ms(std::strtof(lat, nullptr));
+
             // Configure hand detector (same defaults as blueprint)
             hand_detector::DetectorConfig det_config;
             det_config.verbose = false;
@@ -1850,6 +2290,8 @@ int main(int argc, char **argv)
 
                 auto detections = detector.detect(*frame);
                 frame_counter++;
+                if (auto *bus = detection_bus())
+                    bus->publish(frame->sequence, frame->timestamp_ns, frame->width, frame->height, detections);
 
                 // Auto-calibrate on first good detection
                 if (!calibrated && !detections.empty() && detections[0].bbox.confidence > 0.7f)
@@ -1861,41 +2303,26 @@ int main(int argc, char **argv)
                     }
                 }
 
-                // Print detection summary occasionally
-                if (!detections.empty() || frame_counter % 30 == 0)
-                {
-                    std::cout << "[frame " << frame_counter << "] " << detections.size() << " hand(s)";
-                    if (detections.empty())
-                        std::cout << "\n";
-                }
+                // Detection summary goes through the async logger, which also
+                // rate limits it, so the draw loop never blocks on terminal output
+                JLOG_EVERY_N(logger::Level::Info, "Edit", 10)
+                    << "[frame " << frame->sequence << "] " << detections.size() << " hand(s)"
+                    << " missed=" << cam.get_missed_frames();
 
                 for (size_t i = 0; i < detections.size(); ++i)
                 {
                     const auto &hand = detections[i];
-                    std::string label = hand_detector::HandDetector::gesture_to_string(hand.gesture);
-                    if (hand.gesture == hand_detector::Gesture::OPEN_PALM)
-                        label = "OPEN PALM ✋";
-                    else if (hand.gesture == hand_detector::Gesture::FIST)
-                        label = "FIST ✊";
-                    else if (hand.gesture == hand_detector::Gesture::POINTING)
-                        label = "POINTING ☝ [DRAWING]";
-                    else if (hand.gesture == hand_detector::Gesture::PEACE)
-                        label = "PEACE ✌ [DRAWING]";
-
-                    std::cout << "\n  ➜ Hand #" << (i + 1)
-                              << ": " << label
-                              << " | fingers=" << hand.num_fingers
-                              << " | conf=" << (int)(hand.bbox.confidence * 100) << "%"
-                              << " | pos=(" << (int)hand.center.x << "," << (int)hand.center.y << ")";
-
-                    if (!hand.fingertips.empty())
-                        std::cout << " | tip=(" << (int)hand.fingertips[0].x << "," << (int)hand.fingertips[0].y << ")";
+                    JLOG_DEBUG("Edit") << "  ➜ Hand #" << (i + 1)
+                                         << ": " << hand_detector::HandDetector::gesture_to_string(hand.gesture)
+                                         << " | fingers=" << hand.num_fingers
+                                         << " | conf=" << (int)(hand.bbox.confidence * 100) << "%"
+                                         << " | pos=(" << (int)hand.center.x << "," << (int)hand.center.y << ")"
+                                         << " | tip=(" << (hand.fingertips.empty() ? -1 : (int)hand.fingertips[0].x)
+                                         << "," << (hand.fingertips.empty() ? -1 : (int)hand.fingertips[0].y) << ")";
                 }
-                if (!detections.empty())
-                    std::cout << "\n";
 
                 // Update sketchpad with detections
-                sketchpad.update(detections);
+                sketchpad.update(detections, frame->timestamp_ns);
 
                 // Track fingertip for manual controls
                 if (!detections.empty())
@@ -1923,9 +2350,9 @@ int main(int argc, char **argv)
                             px = best_hand->center.x;
                             py = best_hand->center.y;
                         }
-                        last_tip_percent = sketch::Point::from_pixels(px, py, sketchpad.get_sketch().width, sketchpad.get_sketch().height);
+                        last_tip_percent = sketchpad.camera_to_display(px, py);
                         have_last_tip = true;
-                        std::cerr << "[Edit] Last tip: (" << last_tip_percent.x << "," << last_tip_percent.y << ")\n";
+                        JLOG_EVERY_N(logger::Level::Debug, "Edit", 30) << "Last tip: (" << last_tip_percent.x << "," << last_tip_percent.y << ")";
                     }
                 }
 
@@ -1966,6 +2393,8 @@ int main(int argc, char **argv)
                         sketchpad.render(fb0_map, fb0_stride, sketchpad.get_sketch().width, sketchpad.get_sketch().height);
                         msync(fb0_map, fb0_size, MS_SYNC);
                     }
+                    // Measured capture -> display latency drives fingertip prediction
+                    sketchpad.note_frame_displayed(frame->timestamp_ns);
                 }
 
                 // Non-blocking keyboard handling
@@ -2228,5 +2657,10 @@ int main(int argc, char **argv)
     drmModeFreeConnector(conn);
     drmModeFreeResources(res);
     close(fd);
+    // Uploads still in flight fail into the outbox log for the next run
+    outbox->shutdown();
+    async_http.shutdown();
+    outbox_requeue.shutdown();
+    logger::shutdown();
     return 0;
 }
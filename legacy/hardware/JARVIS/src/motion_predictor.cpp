@@ -0,0 +1,152 @@
+#include "motion_predictor.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace sketch
+{
+
+    namespace
+    {
+
+        // Least-squares polynomial fit of degree 1 or 2; returns coefficients
+        // c0 + c1*t (+ c2*t^2). False if the normal matrix is singular.
+        bool fit(const double *t, const double *v, size_t n, int degree, double c[3])
+        {
+            int m = degree + 1;
+            double A[3][4] = {};
+            for (size_t i = 0; i < n; ++i)
+            {
+                double p[3] = {1.0, t[i], t[i] * t[i]};
+                for (int r = 0; r < m; ++r)
+                {
+                    for (int k = 0; k < m; ++k)
+                        A[r][k] += p[r] * p[k];
+                    A[r][m] += p[r] * v[i];
+                }
+            }
+
+            // Gauss-Jordan on the small augmented system
+            for (int col = 0; col < m; ++col)
+            {
+                int pivot = col;
+                for (int r = col + 1; r < m; ++r)
+                    if (std::fabs(A[r][col]) > std::fabs(A[pivot][col]))
+                        pivot = r;
+                if (std::fabs(A[pivot][col]) < 1e-12)
+                    return false;
+                if (pivot != col)
+                    for (int k = 0; k <= m; ++k)
+                        std::swap(A[col][k], A[pivot][k]);
+                for (int r = 0; r < m; ++r)
+                {
+                    if (r == col)
+                        continue;
+                    double f = A[r][col] / A[col][col];
+                    for (int k = col; k <= m; ++k)
+                        A[r][k] -= f * A[col][k];
+                }
+            }
+            c[0] = c[1] = c[2] = 0.0;
+            for (int r = 0; r < m; ++r)
+                c[r] = A[r][m] / A[r][r];
+            return true;
+        }
+
+    } // namespace
+
+    MotionPredictor::MotionPredictor(const PredictorConfig &config)
+        : config_(config)
+    {
+    }
+
+    void MotionPredictor::set_config(const PredictorConfig &config)
+    {
+        config_ = config;
+        while (samples_.size() > std::max<size_t>(config_.history, 2))
+            samples_.pop_front();
+    }
+
+    void MotionPredictor::add_sample(float x, float y, uint64_t timestamp_ns)
+    {
+        if (!samples_.empty())
+        {
+            uint64_t last = samples_.back().t_ns;
+            // Out-of-order or duplicate timestamps carry no velocity information
+            if (timestamp_ns <= last)
+                return;
+            // A long gap means the finger left and came back: start over
+            if ((timestamp_ns - last) / 1e6 > config_.stale_after_ms)
+                samples_.clear();
+        }
+
+        samples_.push_back({x, y, timestamp_ns});
+        while (samples_.size() > std::max<size_t>(config_.history, 2))
+            samples_.pop_front();
+    }
+
+    void MotionPredictor::reset()
+    {
+        samples_.clear();
+    }
+
+    bool MotionPredictor::predict(uint64_t target_ns, float &out_x, float &out_y) const
+    {
+        if (samples_.size() < 2)
+            return false;
+
+        const Sample &newest = samples_.back();
+        const uint64_t t0 = newest.t_ns;
+
+        // Times relative to the newest sample, in seconds
+        double t[64], xs[64], ys[64];
+        size_t n = std::min<size_t>(samples_.size(), 64);
+        size_t first = samples_.size() - n;
+        for (size_t i = 0; i < n; ++i)
+        {
+            const Sample &s = samples_[first + i];
+            t[i] = -static_cast<double>(t0 - s.t_ns) * 1e-9;
+            xs[i] = s.x;
+            ys[i] = s.y;
+        }
+
+        int degree = (config_.model == PredictionModel::CONSTANT_ACCELERATION && n >= 3) ? 2 : 1;
+        double cx[3], cy[3];
+        if (!fit(t, xs, n, degree, cx) || !fit(t, ys, n, degree, cy))
+        {
+            out_x = newest.x;
+            out_y = newest.y;
+            return true;
+        }
+
+        double h = target_ns > t0 ? static_cast<double>(target_ns - t0) * 1e-9 : 0.0;
+        h = std::min(h, static_cast<double>(config_.max_horizon_ms) * 1e-3);
+
+        double px = cx[0] + cx[1] * h + cx[2] * h * h;
+        double py = cy[0] + cy[1] * h + cy[2] * h * h;
+
+        // Overshoot clamp: stay within a bounded distance of the last
+        // observed position so sudden stops don't fling the preview ahead
+        double dx = px - newest.x;
+        double dy = py - newest.y;
+        double dist = std::sqrt(dx * dx + dy * dy);
+        double limit = config_.max_overshoot_percent;
+        if (dist > limit && dist > 0.0)
+        {
+            px = newest.x + dx * (limit / dist);
+            py = newest.y + dy * (limit / dist);
+        }
+
+        out_x = static_cast<float>(px);
+        out_y = static_cast<float>(py);
+        return true;
+    }
+
+    void LatencyEstimator::observe(uint64_t latency_ns)
+    {
+        if (samples_++ == 0)
+            estimate_ns_ = static_cast<double>(latency_ns);
+        else
+            estimate_ns_ += alpha_ * (static_cast<double>(latency_ns) - estimate_ns_);
+    }
+
+} // namespace sketch
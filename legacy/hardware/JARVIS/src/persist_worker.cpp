@@ -0,0 +1,150 @@
+#include "persist_worker.hpp"
+#include "blueprint_format.hpp"
+#include "logger.hpp"
+#include "signed_json.hpp"
+#include "sketch_pad.hpp"
+#include <chrono>
+
+namespace sketch
+{
+
+    namespace
+    {
+        const size_t kMaxResults = 64;
+    }
+
+    PersistWorker::PersistWorker(Uploader uploader)
+        : uploader_(std::move(uploader)), pool_(1)
+    {
+    }
+
+    PersistWorker::PersistWorker(SnapshotUploader uploader)
+        : snapshot_uploader_(std::move(uploader)), pool_(1)
+    {
+    }
+
+    PersistWorker::~PersistWorker()
+    {
+        shutdown();
+    }
+
+    bool PersistWorker::submit(SketchPad &pad, std::shared_ptr<const SaveSnapshot> snapshot)
+    {
+        Key key(&pad, snapshot->path);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_)
+            return false;
+
+        auto it = queued_.find(key);
+        if (it != queued_.end())
+        {
+            // Still waiting: the newer content replaces it
+            it->second.snapshot = std::move(snapshot);
+            ++it->second.requests;
+            ++coalesced_;
+            return true;
+        }
+        queued_[key] = Job{std::move(snapshot), 1};
+        // Submitting under our lock keeps the pool queue and queued_ in step
+        if (!pool_.submit([this, key]() { run(key); }))
+        {
+            queued_.erase(key);
+            return false;
+        }
+        return true;
+    }
+
+    void PersistWorker::run(const Key &key)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = queued_.find(key);
+            if (it == queued_.end())
+                return;
+            job = std::move(it->second);
+            queued_.erase(it);
+        }
+
+        const SaveSnapshot &snapshot = *job.snapshot;
+        auto start = std::chrono::steady_clock::now();
+        PersistResult result;
+        result.name = snapshot.sketch.name;
+        result.path = snapshot.path;
+        result.lines = snapshot.sketch.lines.size();
+        result.requests = job.requests;
+        result.saved = key.first->persist_snapshot(job.snapshot);
+        if (result.saved && (uploader_ || snapshot_uploader_))
+        {
+            result.upload_attempted = true;
+            try
+            {
+                if (snapshot_uploader_)
+                    result.uploaded = snapshot_uploader_(*key.first, snapshot);
+                else
+                    result.uploaded = uploader_(snapshot.sketch.name,
+                                                export_json_blueprint(snapshot.sketch, snapshot.grid, blueprint_secret()));
+            }
+            catch (const std::exception &e)
+            {
+                JLOG_ERROR("Persist") << "Upload of '" << snapshot.sketch.name << "' threw: " << e.what();
+            }
+        }
+        result.duration_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                       std::chrono::steady_clock::now() - start)
+                                                       .count());
+
+        if (!result.saved)
+            JLOG_ERROR("Persist") << "Save failed: '" << result.path << "'";
+        else
+            JLOG_DEBUG("Persist") << "Saved '" << result.path << "' (" << result.lines << " lines, "
+                                  << result.requests << " request(s), " << result.duration_us << " us)";
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++writes_;
+        if (results_.size() >= kMaxResults)
+            results_.erase(results_.begin()); // nobody is polling; keep the latest
+        results_.push_back(std::move(result));
+    }
+
+    std::vector<PersistResult> PersistWorker::take_results()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<PersistResult> out;
+        out.swap(results_);
+        return out;
+    }
+
+    void PersistWorker::flush()
+    {
+        pool_.wait_idle();
+    }
+
+    void PersistWorker::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        pool_.shutdown();
+    }
+
+    size_t PersistWorker::pending() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queued_.size();
+    }
+
+    uint64_t PersistWorker::writes() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return writes_;
+    }
+
+    uint64_t PersistWorker::coalesced() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return coalesced_;
+    }
+
+} // namespace sketch
@@ -0,0 +1,614 @@
+#include "signed_json.hpp"
+#include "sketch_pad.hpp"
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace sketch
+{
+
+    using json = nlohmann::json;
+
+    // ------------------------------------------------------------------------
+    // CborDigest
+    // ------------------------------------------------------------------------
+
+    CborDigest::CborDigest(const std::string &secret) : stream_(secret) {}
+
+    void CborDigest::put(const void *data, size_t size)
+    {
+        if (used_ + size > sizeof(buffer_))
+        {
+            flush();
+            if (size > sizeof(buffer_))
+            {
+                stream_.update(data, size);
+                return;
+            }
+        }
+        std::memcpy(buffer_ + used_, data, size);
+        used_ += size;
+    }
+
+    void CborDigest::flush()
+    {
+        stream_.update(buffer_, used_);
+        used_ = 0;
+    }
+
+    // Initial byte and big-endian argument in the shortest form, as
+    // nlohmann's binary_writer does for every major type
+    void CborDigest::head(uint8_t major, uint64_t value)
+    {
+        unsigned char b[9];
+        size_t n;
+        const uint8_t m = static_cast<uint8_t>(major << 5);
+        if (value <= 23)
+        {
+            b[0] = static_cast<unsigned char>(m | value);
+            n = 1;
+        }
+        else if (value <= 0xFF)
+        {
+            b[0] = m | 24;
+            n = 2;
+        }
+        else if (value <= 0xFFFF)
+        {
+            b[0] = m | 25;
+            n = 3;
+        }
+        else if (value <= 0xFFFFFFFFull)
+        {
+            b[0] = m | 26;
+            n = 5;
+        }
+        else
+        {
+            b[0] = m | 27;
+            n = 9;
+        }
+        for (size_t i = 1; i < n; ++i)
+            b[i] = static_cast<unsigned char>(value >> (8 * (n - 1 - i)));
+        put(b, n);
+    }
+
+    void CborDigest::begin_map(size_t entries) { head(5, entries); }
+    void CborDigest::begin_array(size_t elements) { head(4, elements); }
+
+    void CborDigest::string(const char *data, size_t size)
+    {
+        head(3, size);
+        put(data, size);
+    }
+
+    void CborDigest::boolean(bool v)
+    {
+        const unsigned char b = v ? 0xF5 : 0xF4;
+        put(&b, 1);
+    }
+
+    void CborDigest::null()
+    {
+        const unsigned char b = 0xF6;
+        put(&b, 1);
+    }
+
+    void CborDigest::integer(int64_t v)
+    {
+        if (v >= 0)
+            head(0, static_cast<uint64_t>(v));
+        else
+            head(1, static_cast<uint64_t>(-1 - v));
+    }
+
+    void CborDigest::unsigned_integer(uint64_t v) { head(0, v); }
+
+    void CborDigest::number(double v)
+    {
+        if (std::isnan(v))
+        {
+            const unsigned char b[3] = {0xF9, 0x7E, 0x00};
+            put(b, 3);
+            return;
+        }
+        if (std::isinf(v))
+        {
+            const unsigned char b[3] = {0xF9, static_cast<unsigned char>(v > 0 ? 0x7C : 0xFC), 0x00};
+            put(b, 3);
+            return;
+        }
+
+        // Single precision whenever it round-trips (write_compact_float)
+        unsigned char b[9];
+        if (v >= static_cast<double>(std::numeric_limits<float>::lowest()) &&
+            v <= static_cast<double>(std::numeric_limits<float>::max()) &&
+            static_cast<double>(static_cast<float>(v)) == v)
+        {
+            float f = static_cast<float>(v);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            b[0] = 0xFA;
+            for (int i = 0; i < 4; ++i)
+                b[1 + i] = static_cast<unsigned char>(bits >> (8 * (3 - i)));
+            put(b, 5);
+            return;
+        }
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        b[0] = 0xFB;
+        for (int i = 0; i < 8; ++i)
+            b[1 + i] = static_cast<unsigned char>(bits >> (8 * (7 - i)));
+        put(b, 9);
+    }
+
+    std::string CborDigest::finish_hex()
+    {
+        flush();
+        return stream_.final_hex();
+    }
+
+    // ------------------------------------------------------------------------
+    // Streaming verification
+    // ------------------------------------------------------------------------
+
+    namespace
+    {
+
+        // A parsed scalar, converted the way basic_json::get<T>() would
+        struct Scalar
+        {
+            enum Kind
+            {
+                NUL,
+                BOOLEAN,
+                INTEGER,
+                UNSIGNED,
+                FLOAT,
+                STRING
+            } kind;
+            bool b = false;
+            int64_t i = 0;
+            uint64_t u = 0;
+            double d = 0.0;
+            const std::string *s = nullptr;
+
+            explicit Scalar(Kind k) : kind(k) {}
+
+            template <typename T>
+            bool number(T &out) const
+            {
+                switch (kind)
+                {
+                case BOOLEAN: out = static_cast<T>(b); return true;
+                case INTEGER: out = static_cast<T>(i); return true;
+                case UNSIGNED: out = static_cast<T>(u); return true;
+                case FLOAT: out = static_cast<T>(d); return true;
+                default: return false;
+                }
+            }
+
+            bool boolean(bool &out) const
+            {
+                if (kind != BOOLEAN)
+                    return false;
+                out = b;
+                return true;
+            }
+
+            bool text(std::string &out) const
+            {
+                if (kind != STRING)
+                    return false;
+                out = *s;
+                return true;
+            }
+        };
+
+        // Drives both passes over the text. The counting pass records the
+        // element count of every container (CBOR needs it before the
+        // elements) and whether object keys arrive sorted and unique. The
+        // digest pass replays the counts into a CborDigest and reads the
+        // blueprint fields on the way.
+        class SignedJsonHandler
+        {
+        public:
+            enum class Role
+            {
+                ROOT,
+                GRID,
+                LINES,
+                LINE,
+                OTHER,
+                INVALID
+            };
+
+            // Counting pass
+            SignedJsonHandler() = default;
+
+            // Digest pass over the same text
+            SignedJsonHandler(std::vector<size_t> counts, CborDigest *digest, Sketch *sketch,
+                              GridConfig *grid, int default_thickness)
+                : counting_(false), counts_(std::move(counts)), digest_(digest), sketch_(sketch),
+                  grid_(grid), default_thickness_(default_thickness)
+            {
+            }
+
+            bool null() { return scalar(Scalar(Scalar::NUL)); }
+            bool boolean(bool v)
+            {
+                Scalar s(Scalar::BOOLEAN);
+                s.b = v;
+                return scalar(s);
+            }
+            bool number_integer(json::number_integer_t v)
+            {
+                Scalar s(Scalar::INTEGER);
+                s.i = v;
+                return scalar(s);
+            }
+            bool number_unsigned(json::number_unsigned_t v)
+            {
+                Scalar s(Scalar::UNSIGNED);
+                s.u = v;
+                return scalar(s);
+            }
+            bool number_float(json::number_float_t v, const std::string &)
+            {
+                Scalar s(Scalar::FLOAT);
+                s.d = v;
+                return scalar(s);
+            }
+            bool string(std::string &v)
+            {
+                if (signature_next_)
+                {
+                    signature_next_ = false;
+                    signature_ = v;
+                    has_signature_ = true;
+                    return true;
+                }
+                Scalar s(Scalar::STRING);
+                s.s = &v;
+                return scalar(s);
+            }
+            bool binary(json::binary_t &) { return false; } // never produced by JSON text
+
+            bool start_object(size_t) { return start(true); }
+            bool start_array(size_t) { return start(false); }
+            bool end_object() { return end(); }
+            bool end_array() { return end(); }
+
+            bool key(std::string &k)
+            {
+                Frame &f = stack_.back();
+                if (stack_.size() == 1 && k == "signature")
+                {
+                    // Not part of the signed content; a repeated key wins, as in the DOM
+                    signature_next_ = true;
+                    return true;
+                }
+                if (counting_)
+                {
+                    ++counts_[f.count_index];
+                    if (f.has_key && !(f.key < k))
+                        sorted_ = false;
+                }
+                else
+                {
+                    digest_->string(k);
+                }
+                f.key = k;
+                f.has_key = true;
+                return true;
+            }
+
+            bool parse_error(size_t, const std::string &, const nlohmann::detail::exception &)
+            {
+                return false;
+            }
+
+            bool sorted() const { return sorted_; }
+            bool has_signature() const { return has_signature_ && !signature_invalid_; }
+            bool signature_invalid() const { return signature_invalid_; }
+            bool bad_field() const { return bad_field_; }
+            bool has_grid() const { return has_grid_; }
+            const std::string &signature() const { return signature_; }
+            std::vector<size_t> &counts() { return counts_; }
+
+        private:
+            struct Frame
+            {
+                Role role;
+                bool object;
+                size_t count_index;
+                std::string key;
+                bool has_key;
+            };
+
+            // The signature must be a string
+            bool reject_signature()
+            {
+                signature_invalid_ = true;
+                return false;
+            }
+
+            void count_element()
+            {
+                if (counting_ && !stack_.empty() && !stack_.back().object)
+                    ++counts_[stack_.back().count_index];
+            }
+
+            Role child_role(bool object) const
+            {
+                if (stack_.empty())
+                    return object ? Role::ROOT : Role::OTHER;
+                const Frame &parent = stack_.back();
+                if (parent.role == Role::ROOT && parent.key == "grid")
+                    return object ? Role::GRID : Role::INVALID;
+                if (parent.role == Role::ROOT && parent.key == "lines")
+                    return object ? Role::OTHER : Role::LINES;
+                if (parent.role == Role::LINES)
+                    return object ? Role::LINE : Role::INVALID;
+                return Role::OTHER;
+            }
+
+            bool start(bool object)
+            {
+                if (signature_next_)
+                    return reject_signature();
+                count_element();
+
+                Role role = child_role(object);
+                size_t index;
+                if (counting_)
+                {
+                    index = counts_.size();
+                    counts_.push_back(0);
+                }
+                else
+                {
+                    index = next_container_++;
+                    if (index >= counts_.size())
+                        return false; // text changed between passes
+                    if (object)
+                        digest_->begin_map(counts_[index]);
+                    else
+                        digest_->begin_array(counts_[index]);
+
+                    if (role == Role::INVALID)
+                        bad_field_ = true;
+                    else if (role == Role::GRID)
+                        has_grid_ = true;
+                    else if (role == Role::LINE)
+                    {
+                        Line line;
+                        line.color = 0x00FFFFFF; // Files without color/thickness: white, default thickness
+                        line.thickness = default_thickness_;
+                        sketch_->lines.push_back(line);
+                    }
+                }
+                stack_.push_back(Frame{role, object, index, std::string(), false});
+                return true;
+            }
+
+            bool end()
+            {
+                stack_.pop_back();
+                return true;
+            }
+
+            bool scalar(const Scalar &v)
+            {
+                if (signature_next_)
+                    return reject_signature();
+                count_element();
+                if (counting_)
+                    return true;
+
+                switch (v.kind)
+                {
+                case Scalar::NUL: digest_->null(); break;
+                case Scalar::BOOLEAN: digest_->boolean(v.b); break;
+                case Scalar::INTEGER: digest_->integer(v.i); break;
+                case Scalar::UNSIGNED: digest_->unsigned_integer(v.u); break;
+                case Scalar::FLOAT: digest_->number(v.d); break;
+                case Scalar::STRING: digest_->string(*v.s); break;
+                }
+                if (!stack_.empty() && !assign(stack_.back(), v))
+                    bad_field_ = true;
+                return true;
+            }
+
+            // Same fields and conversions as the DOM loader it replaces
+            bool assign(const Frame &f, const Scalar &v)
+            {
+                switch (f.role)
+                {
+                case Role::ROOT:
+                    if (f.key == "name")
+                        return v.text(sketch_->name);
+                    if (f.key == "width")
+                        return v.number(sketch_->width);
+                    if (f.key == "height")
+                        return v.number(sketch_->height);
+                    if (f.key == "created_timestamp")
+                        return v.number(sketch_->created_timestamp);
+                    return f.key != "grid";
+                case Role::GRID:
+                    if (f.key == "grid_spacing_percent")
+                        return v.number(grid_->grid_spacing_percent);
+                    if (f.key == "real_world_spacing_cm")
+                        return v.number(grid_->real_world_spacing_cm);
+                    if (f.key == "snap_to_grid")
+                        return v.boolean(grid_->snap_to_grid);
+                    if (f.key == "show_measurements")
+                        return v.boolean(grid_->show_measurements);
+                    return true;
+                case Role::LINES:
+                    return false; // every line is an object
+                case Role::LINE:
+                {
+                    Line &line = sketch_->lines.back();
+                    if (f.key == "x0")
+                        return v.number(line.start.x);
+                    if (f.key == "y0")
+                        return v.number(line.start.y);
+                    if (f.key == "x1")
+                        return v.number(line.end.x);
+                    if (f.key == "y1")
+                        return v.number(line.end.y);
+                    if (f.key == "color")
+                        return v.number(line.color);
+                    if (f.key == "thickness")
+                        return v.number(line.thickness);
+                    return true;
+                }
+                default:
+                    return true;
+                }
+            }
+
+            bool counting_ = true;
+            std::vector<size_t> counts_;
+            size_t next_container_ = 0;
+            std::vector<Frame> stack_;
+
+            bool sorted_ = true;
+            bool signature_next_ = false;
+            bool has_signature_ = false;
+            bool signature_invalid_ = false;
+            std::string signature_;
+
+            CborDigest *digest_ = nullptr;
+            Sketch *sketch_ = nullptr;
+            GridConfig *grid_ = nullptr;
+            int default_thickness_ = 3;
+            bool bad_field_ = false;
+            bool has_grid_ = false;
+        };
+
+    } // namespace
+
+    const char *signed_json_result_name(SignedJsonResult result)
+    {
+        switch (result)
+        {
+        case SignedJsonResult::OK: return "ok";
+        case SignedJsonResult::PARSE_ERROR: return "parse error";
+        case SignedJsonResult::MISSING_SIGNATURE: return "missing signature";
+        case SignedJsonResult::BAD_SIGNATURE: return "signature mismatch";
+        case SignedJsonResult::BAD_FIELD: return "invalid field";
+        }
+        return "unknown";
+    }
+
+    SignedJsonResult read_signed_json_blueprint(const char *text, size_t size, const std::string &secret,
+                                                int default_thickness, Sketch &sketch, GridConfig &grid)
+    {
+        SignedJsonHandler counter;
+        if (!json::sax_parse(text, text + size, &counter))
+            return counter.signature_invalid() ? SignedJsonResult::MISSING_SIGNATURE : SignedJsonResult::PARSE_ERROR;
+        if (!counter.has_signature())
+            return SignedJsonResult::MISSING_SIGNATURE;
+
+        if (!counter.sorted())
+        {
+            // Keys out of order or repeated: let the DOM sort and deduplicate
+            // them once, then stream the normalized text
+            std::string normalized = json::parse(text, text + size).dump();
+            return read_signed_json_blueprint(normalized.data(), normalized.size(), secret,
+                                              default_thickness, sketch, grid);
+        }
+
+        Sketch loaded;
+        loaded.name = sketch.name;
+        loaded.width = sketch.width;
+        loaded.height = sketch.height;
+        loaded.created_timestamp = sketch.created_timestamp;
+        GridConfig loaded_grid = grid;
+
+        CborDigest digest(secret);
+        SignedJsonHandler reader(std::move(counter.counts()), &digest, &loaded, &loaded_grid, default_thickness);
+        if (!json::sax_parse(text, text + size, &reader))
+            return SignedJsonResult::PARSE_ERROR;
+        if (digest.finish_hex() != counter.signature())
+            return SignedJsonResult::BAD_SIGNATURE;
+        if (reader.bad_field())
+            return SignedJsonResult::BAD_FIELD;
+
+        // If grid info exists in the file, enable grid rendering
+        if (reader.has_grid())
+            loaded_grid.enabled = true;
+        sketch = std::move(loaded);
+        grid = loaded_grid;
+        return SignedJsonResult::OK;
+    }
+
+    std::string json_blueprint_signature(const Sketch &sketch, const GridConfig &grid, const std::string &secret)
+    {
+        // Keys in std::map order, values typed as export_json() stores them
+        CborDigest d(secret);
+        d.begin_map(6);
+        d.string("created_timestamp");
+        d.unsigned_integer(sketch.created_timestamp);
+        d.string("grid");
+        d.begin_map(4);
+        d.string("grid_spacing_percent");
+        d.number(grid.grid_spacing_percent);
+        d.string("real_world_spacing_cm");
+        d.number(grid.real_world_spacing_cm);
+        d.string("show_measurements");
+        d.boolean(grid.show_measurements);
+        d.string("snap_to_grid");
+        d.boolean(grid.snap_to_grid);
+        d.string("height");
+        d.unsigned_integer(sketch.height);
+        d.string("lines");
+        d.begin_array(sketch.lines.size());
+        for (const auto &line : sketch.lines)
+        {
+            d.begin_map(4);
+            d.string("x0");
+            d.number(line.start.x);
+            d.string("x1");
+            d.number(line.end.x);
+            d.string("y0");
+            d.number(line.start.y);
+            d.string("y1");
+            d.number(line.end.y);
+        }
+        d.string("name");
+        d.string(sketch.name);
+        d.string("width");
+        d.unsigned_integer(sketch.width);
+        return d.finish_hex();
+    }
+
+    std::string export_json_blueprint(const Sketch &sketch, const GridConfig &grid, const std::string &secret)
+    {
+        json j;
+        j["name"] = sketch.name;
+        j["width"] = sketch.width;
+        j["height"] = sketch.height;
+        j["created_timestamp"] = sketch.created_timestamp;
+        j["grid"] = {
+            {"grid_spacing_percent", grid.grid_spacing_percent},
+            {"real_world_spacing_cm", grid.real_world_spacing_cm},
+            {"snap_to_grid", grid.snap_to_grid},
+            {"show_measurements", grid.show_measurements}
+        };
+        j["lines"] = json::array();
+        for (const auto &line : sketch.lines)
+        {
+            json li = { {"x0", line.start.x}, {"y0", line.start.y}, {"x1", line.end.x}, {"y1", line.end.y} };
+            j["lines"].push_back(li);
+        }
+
+        // Signature over the CBOR of the document, streamed from the sketch itself
+        j["signature"] = json_blueprint_signature(sketch, grid, secret);
+        return j.dump(2) + "\n";
+    }
+
+} // namespace sketch
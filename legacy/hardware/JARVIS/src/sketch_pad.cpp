@@ -1,9 +1,14 @@
 #include "sketch_pad.hpp"
+#include "blueprint_format.hpp"
+#include "line_journal.hpp"
+#include "signed_json.hpp"
+#include "persist_worker.hpp"
 #include "draw_ticker.hpp"
 #include <nlohmann/json.hpp>
-#include "crypto.hpp"
+#include "logger.hpp"
 #include <fstream>
 #include <sstream>
+#include <iterator>
 #include <cmath>
 #include <algorithm>
 #include <chrono>
@@ -40,23 +45,48 @@ namespace sketch
         return Point(xp / wp, yp / wp);
     }
 
-    void ProjectorCalibration::compute_homography()
+    bool ProjectorCalibration::compute_homography()
     {
-        // Simplified DLT (Direct Linear Transform) for homography estimation
-        // For production, use OpenCV's getPerspectiveTransform or similar
-        // This is a basic 4-point implementation
+        return compute_homography(camera_corners, display_corners, 4);
+    }
 
-        // For now, compute a simple affine approximation
-        // In enterprise deployment, integrate OpenCV or a robust homography solver
+    bool ProjectorCalibration::compute_homography(const Point *camera_pts, const Point *display_pts, size_t n)
+    {
+        double H[9];
+        if (!solve_homography(camera_pts, display_pts, n, H))
+        {
+            calibrated = false;
+            std::cerr << "[ProjectorCalibration] Homography solve failed (need >= 4 non-degenerate points, got "
+                      << n << ")\n";
+            return false;
+        }
 
-        // Mark as calibrated with identity for now
+        for (int i = 0; i < 9; ++i)
+            transform_matrix[i] = static_cast<float>(H[i]);
         calibrated = true;
 
-        std::cerr << "[ProjectorCalibration] Calibration computed (affine approximation)\n";
+        // Report the fit quality over the input points
+        double max_err = 0.0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            Point p = transform(camera_pts[i]);
+            max_err = std::max(max_err, static_cast<double>(p.distance(display_pts[i])));
+        }
+        std::cerr << "[ProjectorCalibration] Homography computed from " << n
+                  << " points (max residual " << max_err << "%)\n";
+        return true;
     }
 
     using json = nlohmann::json;
 
+    // Same clock as camera::Frame::timestamp_ns
+    static inline uint64_t steady_now_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
     // Helper to blend colors with alpha
     static inline uint32_t blend_color(uint32_t bg, uint32_t fg, float alpha)
     {
@@ -262,6 +292,7 @@ namespace sketch
 
     bool SketchPad::load_from_json(const std::string &json_str, const std::string &resolved_path)
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         // Attempt to parse JSON payload even if signature verification fails
         try
         {
@@ -294,6 +325,8 @@ namespace sketch
             if (full.find(".jarvis") == std::string::npos)
                 full += ".jarvis";
             last_loaded_path_ = full;
+            // Recovered content is rewritten in full on the next save
+            ++content_generation_;
 
             // Reset state machine and buffers
             state_ = DrawingState::WAITING_FOR_START;
@@ -343,10 +376,17 @@ namespace sketch
         sketch_.height = height;
     }
 
-    SketchPad::~SketchPad() {}
+    SketchPad::~SketchPad()
+    {
+        PersistWorker *worker = persist_worker_;
+        if (worker)
+            worker->flush(); // queued snapshots still point at this pad
+        wait_for_compaction();
+    }
 
     void SketchPad::init(const std::string &name, uint32_t width, uint32_t height)
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         bool preserving = false;
         if (sketch_.name == name && !sketch_.lines.empty())
         {
@@ -364,12 +404,18 @@ namespace sketch
                                             std::chrono::system_clock::now().time_since_epoch())
                                             .count();
             sketch_.lines.clear();
+            // New project: the first save writes a full base
+            ++content_generation_;
         }
 
         state_ = DrawingState::WAITING_FOR_START;
         current_confirmation_.reset();
         gesture_changed_since_start_ = false;
         position_buffer_.clear();
+        predictor_.reset();
+        // Camera resolution may default to the sketch size
+        if (camera_width_ == 0)
+            rebuild_remap();
 
         std::cerr << "[SketchPad] ┌─────────────────────────────────────────────────┐\n";
         std::cerr << "[SketchPad] │  ENTERPRISE DRAWING SYSTEM - ARCHITECT MODE   │\n";
@@ -395,10 +441,42 @@ namespace sketch
 
     bool SketchPad::update(const std::vector<hand_detector::HandDetection> &hands)
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return update(hands, 0);
+    }
+
+    bool SketchPad::update(const std::vector<hand_detector::HandDetection> &hands, uint64_t frame_timestamp_ns)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        frame_timestamp_ns_ = frame_timestamp_ns;
+        // Until the display path reports back, processing latency is the
+        // best lower bound available
+        if (frame_timestamp_ns != 0 && !display_feedback_)
+        {
+            uint64_t now = steady_now_ns();
+            if (now > frame_timestamp_ns)
+                latency_.observe(now - frame_timestamp_ns);
+        }
+
         update_state_machine(hands);
         return state_ != DrawingState::WAITING_FOR_START;
     }
 
+    void SketchPad::note_frame_displayed(uint64_t capture_timestamp_ns)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        uint64_t now = steady_now_ns();
+        if (capture_timestamp_ns == 0 || now <= capture_timestamp_ns)
+            return;
+        if (!display_feedback_)
+        {
+            // Replace the processing-only estimate rather than blending into it
+            latency_.reset();
+            display_feedback_ = true;
+        }
+        latency_.observe(now - capture_timestamp_ns);
+    }
+
     void SketchPad::update_state_machine(const std::vector<hand_detector::HandDetection> &hands)
     {
         // Find best pointing/peace hand with higher confidence threshold for architects
@@ -416,29 +494,20 @@ namespace sketch
             }
         }
 
-        // Debug: log all hands and selected gesture for drawing
+        // Debug: log all hands and selected gesture for drawing (rate limited)
         if (!hands.empty())
         {
-            std::cerr << "[SketchPad][Frame] Hands: ";
-            for (const auto &hand : hands)
-            {
-                std::cerr << hand_detector::HandDetector::gesture_to_string(hand.gesture)
-                          << "(conf=" << (int)(hand.bbox.confidence * 100) << "%) ";
-            }
-            std::cerr << "| Selected: " << hand_detector::HandDetector::gesture_to_string(active_gesture)
-                      << " (conf=" << (int)(best_confidence * 100) << "%)\n";
+            JLOG_EVERY_N(logger::Level::Debug, "SketchPad", 30)
+                << "[Frame] Hands: " << hands.size()
+                << " first=" << hand_detector::HandDetector::gesture_to_string(hands[0].gesture)
+                << "(conf=" << (int)(hands[0].bbox.confidence * 100) << "%)"
+                << " | Selected: " << hand_detector::HandDetector::gesture_to_string(active_gesture)
+                << " (conf=" << (int)(best_confidence * 100) << "%)";
         }
 
-        // Track if we EVER had 2+ consecutive frames (for persistent line drawing)
-        static int first_gesture_frames = 0;
-        static Point first_gesture_pos;
-        static int second_gesture_frames = 0;
-        static Point second_gesture_pos;
-        static bool first_locked = false;
-        static bool second_locked = false;
-
         // Get current position with enterprise-grade smoothing
         Point current_pos;
+        Point preview_pos;
         bool has_pointing = false;
 
         if (pointing_hand && best_confidence > 0.65f)
@@ -458,8 +527,16 @@ namespace sketch
                 pixel_y = pointing_hand->center.y;
             }
 
-            // Convert to percentage coordinates
-            current_pos = Point::from_pixels(pixel_x, pixel_y, sketch_.width, sketch_.height);
+            // Convert to display percentage coordinates (through the
+            // precomputed remap grid when the projector is calibrated)
+            current_pos = camera_to_display(pixel_x, pixel_y);
+
+            // Raw track for the latency predictor (its fit does the smoothing)
+            if (frame_timestamp_ns_ != 0)
+            {
+                Point track = (use_projector_calibration_ && !remap_.valid()) ? apply_calibration(current_pos) : current_pos;
+                predictor_.add_sample(track.x, track.y, frame_timestamp_ns_);
+            }
 
             // Add to smoothing buffer
             position_buffer_.push_back(current_pos);
@@ -478,15 +555,27 @@ namespace sketch
                 current_pos = get_smoothed_position();
             }
 
-            // Apply projector calibration if enabled
-            if (use_projector_calibration_)
+            // Apply projector calibration if enabled and not already
+            // folded into the remap grid
+            if (use_projector_calibration_ && !remap_.valid())
             {
                 current_pos = apply_calibration(current_pos);
             }
 
-            // Debug: log the smoothed position used for drawing
-            std::cerr << "[SketchPad][Frame] Smoothed drawing position: ("
-                      << current_pos.x << ", " << current_pos.y << ")\n";
+            // The preview leads the smoothed position by the pipeline latency
+            // so it sits under the finger rather than trailing it
+            preview_pos = current_pos;
+            if (latency_compensation_ && frame_timestamp_ns_ != 0)
+            {
+                float px, py;
+                if (predictor_.predict(frame_timestamp_ns_ + latency_.latency_ns(), px, py))
+                    preview_pos = Point(px, py);
+            }
+
+            // Debug: log the smoothed position used for drawing (rate limited)
+            JLOG_EVERY_N(logger::Level::Debug, "SketchPad", 30)
+                << "[Frame] Smoothed drawing position: ("
+                << current_pos.x << ", " << current_pos.y << ")";
         }
 
         // Check for non-pointing gestures (for state transitions)
@@ -541,11 +630,11 @@ namespace sketch
                 }
 
                 // Track first gesture persistently
-                if (current_confirmation_.consecutive_frames >= required_confirmation_frames_ && !first_locked)
+                if (current_confirmation_.consecutive_frames >= required_confirmation_frames_ && !first_locked_)
                 {
-                    first_gesture_frames = current_confirmation_.consecutive_frames;
-                    first_gesture_pos = current_confirmation_.position; // Use LAST position
-                    first_locked = true;
+                    first_gesture_frames_ = current_confirmation_.consecutive_frames;
+                    first_gesture_pos_ = current_confirmation_.position; // Use LAST position
+                    first_locked_ = true;
                 }
 
                 // Check if confirmed (use LAST position at this location)
@@ -556,11 +645,11 @@ namespace sketch
                     state_ = DrawingState::START_CONFIRMED;
                     gesture_changed_since_start_ = false;
 
-                    std::cerr << "[SketchPad] ✓ START confirmed at ("
-                              << start_point_.x << ", " << start_point_.y
-                              << ") after " << current_confirmation_.consecutive_frames
-                              << " detections (conf: " << (int)(current_confirmation_.avg_confidence() * 100) << "%)"
-                              << " gesture: " << (active_gesture == hand_detector::Gesture::POINTING ? "POINTING" : "PEACE") << "\n";
+                    JLOG_INFO("SketchPad") << "✓ START confirmed at ("
+                                           << start_point_.x << ", " << start_point_.y
+                                           << ") after " << current_confirmation_.consecutive_frames
+                                           << " detections (conf: " << (int)(current_confirmation_.avg_confidence() * 100) << "%)"
+                                           << " gesture: " << (active_gesture == hand_detector::Gesture::POINTING ? "POINTING" : "PEACE");
 
                     current_confirmation_.reset();
                 }
@@ -583,12 +672,12 @@ namespace sketch
                 state_ = DrawingState::WAITING_FOR_END;
                 current_confirmation_.reset();
 
-                std::cerr << "[SketchPad] → Gesture changed (non-drawing), waiting for END point...\n";
+                JLOG_INFO("SketchPad") << "→ Gesture changed (non-drawing), waiting for END point...";
             }
             else if (has_pointing)
             {
                 // Update preview end point in real-time
-                preview_end_point_ = current_pos;
+                preview_end_point_ = preview_pos;
 
                 // If user moved far enough, consider gesture as changed
                 // This allows: pointing -> move hand -> pointing (same gesture, different position)
@@ -598,7 +687,7 @@ namespace sketch
                     // Moved significantly - allow END confirmation
                     gesture_changed_since_start_ = true;
                     state_ = DrawingState::WAITING_FOR_END;
-                    std::cerr << "[SketchPad] → Hand moved " << (int)dist_from_start << "%, waiting for END point...\n";
+                    JLOG_INFO("SketchPad") << "→ Hand moved " << (int)dist_from_start << "%, waiting for END point...";
                 }
             }
             else
@@ -609,7 +698,7 @@ namespace sketch
                     gesture_changed_since_start_ = true;
                     state_ = DrawingState::WAITING_FOR_END;
                     current_confirmation_.reset();
-                    std::cerr << "[SketchPad] → Hand removed (0 hands), waiting for END point...\n";
+                    JLOG_INFO("SketchPad") << "→ Hand removed (0 hands), waiting for END point...";
                 }
             }
             break;
@@ -618,7 +707,7 @@ namespace sketch
             if (has_pointing)
             {
                 // Update preview
-                preview_end_point_ = current_pos;
+                preview_end_point_ = preview_pos;
 
                 // Accept any drawing gesture (pointing or peace) for confirmation
                 if (current_confirmation_.consecutive_frames > 0)
@@ -653,11 +742,11 @@ namespace sketch
                 }
 
                 // Track second gesture persistently
-                if (current_confirmation_.consecutive_frames >= required_confirmation_frames_ && !second_locked)
+                if (current_confirmation_.consecutive_frames >= required_confirmation_frames_ && !second_locked_)
                 {
-                    second_gesture_frames = current_confirmation_.consecutive_frames;
-                    second_gesture_pos = current_confirmation_.position; // Use LAST position
-                    second_locked = true;
+                    second_gesture_frames_ = current_confirmation_.consecutive_frames;
+                    second_gesture_pos_ = current_confirmation_.position; // Use LAST position
+                    second_locked_ = true;
                 }
 
                 // Check if confirmed (use LAST position at this location)
@@ -667,21 +756,21 @@ namespace sketch
                     preview_end_point_ = snap_to_grid(current_confirmation_.position);
                     state_ = DrawingState::END_CONFIRMED;
 
-                    std::cerr << "[SketchPad] ✓ END confirmed at ("
-                              << preview_end_point_.x << ", " << preview_end_point_.y
-                              << ") after " << current_confirmation_.consecutive_frames
-                              << " detections (conf: " << (int)(current_confirmation_.avg_confidence() * 100) << "%)"
-                              << " gesture: " << (active_gesture == hand_detector::Gesture::POINTING ? "POINTING" : "PEACE") << "\n";
+                    JLOG_INFO("SketchPad") << "✓ END confirmed at ("
+                                           << preview_end_point_.x << ", " << preview_end_point_.y
+                                           << ") after " << current_confirmation_.consecutive_frames
+                                           << " detections (conf: " << (int)(current_confirmation_.avg_confidence() * 100) << "%)"
+                                           << " gesture: " << (active_gesture == hand_detector::Gesture::POINTING ? "POINTING" : "PEACE");
                 }
             }
             else
             {
                 // If we have both locked positions, draw line even without current confirmation
-                if (first_locked && second_locked && !has_pointing)
+                if (first_locked_ && second_locked_ && !has_pointing)
                 {
-                    preview_end_point_ = snap_to_grid(second_gesture_pos);
+                    preview_end_point_ = snap_to_grid(second_gesture_pos_);
                     state_ = DrawingState::END_CONFIRMED;
-                    std::cerr << "[SketchPad] ✓ END confirmed from history (no hand)\n";
+                    JLOG_INFO("SketchPad") << "✓ END confirmed from history (no hand)";
                 }
                 else if (current_confirmation_.consecutive_frames > 0)
                 {
@@ -697,11 +786,12 @@ namespace sketch
             current_confirmation_.reset();
             gesture_changed_since_start_ = false;
             position_buffer_.clear();
+            predictor_.reset();
             // Reset persistent tracking
-            first_gesture_frames = 0;
-            first_locked = false;
-            second_gesture_frames = 0;
-            second_locked = false;
+            first_gesture_frames_ = 0;
+            first_locked_ = false;
+            second_gesture_frames_ = 0;
+            second_locked_ = false;
             break;
         }
     }
@@ -791,6 +881,9 @@ namespace sketch
 
     void SketchPad::set_calibration_points(const Point camera_pts[4], const Point display_pts[4])
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        calib_camera_pts_.clear();
+        calib_display_pts_.clear();
         for (int i = 0; i < 4; ++i)
         {
             calibration_.camera_corners[i] = camera_pts[i];
@@ -799,11 +892,157 @@ namespace sketch
         std::cerr << "[SketchPad] Calibration points set\n";
     }
 
-    void SketchPad::calibrate_projector()
+    void SketchPad::set_calibration_points(const std::vector<Point> &camera_pts, const std::vector<Point> &display_pts)
     {
-        calibration_.compute_homography();
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        size_t n = std::min(camera_pts.size(), display_pts.size());
+        calib_camera_pts_.assign(camera_pts.begin(), camera_pts.begin() + n);
+        calib_display_pts_.assign(display_pts.begin(), display_pts.begin() + n);
+        for (size_t i = 0; i < 4 && i < n; ++i)
+        {
+            calibration_.camera_corners[i] = camera_pts[i];
+            calibration_.display_corners[i] = display_pts[i];
+        }
+        std::cerr << "[SketchPad] Calibration points set (" << n << " pairs)\n";
+    }
+
+    bool SketchPad::calibrate_projector()
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        bool ok = calib_camera_pts_.size() >= 4
+                      ? calibration_.compute_homography(calib_camera_pts_.data(), calib_display_pts_.data(),
+                                                        calib_camera_pts_.size())
+                      : calibration_.compute_homography();
+        if (!ok)
+        {
+            use_projector_calibration_ = false;
+            remap_.reset();
+            overlay_remap_.reset();
+            return false;
+        }
+
         use_projector_calibration_ = true;
+        rebuild_remap();
         std::cerr << "[SketchPad] ✓ Projector calibration activated\n";
+        return true;
+    }
+
+    bool SketchPad::load_calibration(const std::string &path)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::ifstream file(path);
+        if (!file.is_open())
+            return false;
+
+        try
+        {
+            json j;
+            file >> j;
+            std::vector<Point> cam, disp;
+            for (const auto &p : j.at("camera"))
+                cam.emplace_back(p.at(0).get<float>(), p.at(1).get<float>());
+            for (const auto &p : j.at("display"))
+                disp.emplace_back(p.at(0).get<float>(), p.at(1).get<float>());
+            if (cam.size() < 4 || cam.size() != disp.size())
+            {
+                std::cerr << "[SketchPad] Calibration file needs matching camera/display lists of >= 4 points: " << path << "\n";
+                return false;
+            }
+            set_calibration_points(cam, disp);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "[SketchPad] Calibration file parse error: " << e.what() << "\n";
+            return false;
+        }
+        return calibrate_projector();
+    }
+
+    void SketchPad::set_camera_resolution(uint32_t width, uint32_t height)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        camera_width_ = width;
+        camera_height_ = height;
+        rebuild_remap();
+    }
+
+    void SketchPad::set_remap_options(uint32_t cell, bool fixed_point)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        remap_cell_ = cell > 0 ? cell : 8;
+        remap_fixed_point_ = fixed_point;
+        rebuild_remap();
+    }
+
+    void SketchPad::rebuild_remap()
+    {
+        remap_.reset();
+        overlay_remap_.reset();
+        if (!calibration_.calibrated)
+            return;
+
+        uint32_t cw = camera_width_ ? camera_width_ : sketch_.width;
+        uint32_t ch = camera_height_ ? camera_height_ : sketch_.height;
+        double H[9];
+        for (int i = 0; i < 9; ++i)
+            H[i] = calibration_.transform_matrix[i];
+        if (!remap_.build(H, cw, ch, remap_cell_, remap_fixed_point_))
+        {
+            std::cerr << "[SketchPad] Remap grid build failed; falling back to per-point transform\n";
+        }
+    }
+
+    Point SketchPad::camera_to_display(float px, float py) const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (use_projector_calibration_ && remap_.valid())
+        {
+            float x, y;
+            remap_.map(px, py, x, y);
+            return Point(x, y);
+        }
+        uint32_t cw = camera_width_ ? camera_width_ : sketch_.width;
+        uint32_t ch = camera_height_ ? camera_height_ : sketch_.height;
+        return Point::from_pixels(px, py, cw, ch);
+    }
+
+    void SketchPad::render_camera_overlay(const camera::Frame &frame, void *map, uint32_t stride,
+                                          uint32_t width, uint32_t height)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (frame.format != camera::PixelFormat::RGB888 || !frame.has_pixels() || width == 0 || height == 0)
+            return;
+
+        // Display pixel -> camera percent: the inverse homography, sampled
+        // on a grid sized for the display and rebuilt only when it changes
+        if (!overlay_remap_.valid() || overlay_remap_.src_width() != width || overlay_remap_.src_height() != height)
+        {
+            double H[9], Hinv[9];
+            for (int i = 0; i < 9; ++i)
+                H[i] = calibration_.calibrated ? calibration_.transform_matrix[i] : (i % 4 == 0 ? 1.0 : 0.0);
+            if (!invert_homography(H, Hinv) || !overlay_remap_.build(Hinv, width, height, 16, remap_fixed_point_))
+                return;
+        }
+
+        const uint32_t fstride = frame.stride ? frame.stride : frame.width * 3;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                float cx, cy;
+                overlay_remap_.map(static_cast<float>(x), static_cast<float>(y), cx, cy);
+                int sx = static_cast<int>(cx * frame.width / 100.0f);
+                int sy = static_cast<int>(cy * frame.height / 100.0f);
+                if (sx < 0 || sy < 0 || sx >= static_cast<int>(frame.width) || sy >= static_cast<int>(frame.height))
+                    continue;
+                const uint8_t *px = frame.pixels() + static_cast<size_t>(sy) * fstride + sx * 3;
+                // Dimmed so the sketch drawn on top stays readable
+                uint32_t color = (static_cast<uint32_t>(px[0] >> 1) << 16) |
+                                 (static_cast<uint32_t>(px[1] >> 1) << 8) |
+                                 static_cast<uint32_t>(px[2] >> 1);
+                set_pixel(map, stride, width, height, static_cast<int>(x), static_cast<int>(y), color);
+            }
+        }
     }
 
     Point SketchPad::snap_to_grid(const Point &p) const
@@ -832,8 +1071,8 @@ namespace sketch
 
         if (dist < 1.0f)
         { // Minimum 1% of screen distance
-            std::cerr << "[SketchPad] ✗ Line too short (" << std::fixed << std::setprecision(1)
-                      << dist << "%), discarded\n";
+            JLOG_INFO("SketchPad") << "✗ Line too short (" << std::fixed << std::setprecision(1)
+                                   << dist << "%), discarded";
             return;
         }
 
@@ -851,13 +1090,13 @@ namespace sketch
 
         float real_length = line.get_real_length(grid_config_);
 
-        std::cerr << "[SketchPad] ✓ Line #" << std::setw(4) << sketch_.lines.size() << " created: "
-                  << "(" << std::setw(6) << std::fixed << std::setprecision(1) << line.start.x
-                  << "%," << std::setw(6) << line.start.y << "%) → "
-                  << "(" << std::setw(6) << line.end.x
-                  << "%," << std::setw(6) << line.end.y << "%) "
-                  << "length: " << std::setw(5) << std::setprecision(1) << dist << "% "
-                  << "(" << std::setw(6) << std::setprecision(2) << real_length << " cm)\n";
+        JLOG_INFO("SketchPad") << "✓ Line #" << std::setw(4) << sketch_.lines.size() << " created: "
+                               << "(" << std::setw(6) << std::fixed << std::setprecision(1) << line.start.x
+                               << "%," << std::setw(6) << line.start.y << "%) → "
+                               << "(" << std::setw(6) << line.end.x
+                               << "%," << std::setw(6) << line.end.y << "%) "
+                               << "length: " << std::setw(5) << std::setprecision(1) << dist << "% "
+                               << "(" << std::setw(6) << std::setprecision(2) << real_length << " cm)";
         // Persist after each confirmed line so an unexpected shutdown preserves progress
         if (!save(sketch_.name))
         {
@@ -867,15 +1106,21 @@ namespace sketch
 
     void SketchPad::clear()
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         sketch_.lines.clear();
+        ++clear_epoch_; // journaled as a CLEAR record on the next save
         state_ = DrawingState::WAITING_FOR_START;
         current_confirmation_.reset();
         gesture_changed_since_start_ = false;
         position_buffer_.clear();
+        predictor_.reset();
+        first_gesture_frames_ = second_gesture_frames_ = 0;
+        first_locked_ = second_locked_ = false;
     }
 
     void SketchPad::add_line(const Point &start_percent, const Point &end_percent)
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         Point s = start_percent;
         Point e = end_percent;
         if (grid_config_.enabled && grid_config_.snap_to_grid)
@@ -902,11 +1147,12 @@ namespace sketch
                              .count();
         sketch_.lines.push_back(line);
 
-        std::cerr << "[SketchPad] add_line: created line from (" << s.x << "," << s.y << ") to (" << e.x << "," << e.y << ")\n";
+        JLOG_DEBUG("SketchPad") << "add_line: created line from (" << s.x << "," << s.y << ") to (" << e.x << "," << e.y << ")";
     }
 
     void SketchPad::set_manual_start(const Point &p)
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         // Snap to grid if enabled so the manual start dot lies on an intersection
         Point snapped = p;
         if (grid_config_.enabled && grid_config_.snap_to_grid)
@@ -923,163 +1169,114 @@ namespace sketch
 
     void SketchPad::clear_manual_start()
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         manual_preview_active_ = false;
     }
 
-    bool SketchPad::save(const std::string &base_filename)
+    namespace
     {
-            // Determine target path. If we previously loaded from an explicit path,
-            // prefer saving back to that same resolved file so edits go to the same file.
-            std::string full_path;
-            if ((base_filename.empty() || base_filename == sketch_.name) && !last_loaded_path_.empty())
-            {
-                full_path = last_loaded_path_;
-            }
-            else
-            {
-                std::string base = base_filename.empty() ? sketch_.name : base_filename;
-                full_path = (base.find('/') == std::string::npos) ? std::string("blueprints/") + base : base;
-                if (full_path.find(".jarvis") == std::string::npos)
-                    full_path += ".jarvis";
-            }
 
-            // Ensure parent directory exists (create recursively as needed)
-            auto ensure_parent = [](const std::string &path) -> bool {
-                auto pos = path.find_last_of('/');
-                if (pos == std::string::npos)
-                    return true; // no parent dir
-                std::string dir = path.substr(0, pos);
-                // Create directories iteratively
-                std::string accum;
-                size_t start = 0;
-                if (dir.size() > 0 && dir[0] == '/')
-                {
-                    accum = "/";
-                    start = 1;
-                }
-                while (start < dir.size())
-                {
-                    auto next = dir.find('/', start);
-                    std::string part = dir.substr(start, (next == std::string::npos) ? std::string::npos : next - start);
-                    if (!accum.empty() && accum.back() != '/')
-                        accum += "/";
-                    accum += part;
-                    struct stat st = {};
-                    if (stat(accum.c_str(), &st) != 0)
-                    {
-                        if (mkdir(accum.c_str(), 0755) != 0 && errno != EEXIST)
-                            return false;
-                    }
-                    if (next == std::string::npos)
-                        break;
-                    start = next + 1;
-                }
-                return true;
-            };
-
-            if (!ensure_parent(full_path))
-            {
-                std::cerr << "[SketchPad] Failed to create parent directory for: " << full_path << "\n";
-                return false;
-            }
+        std::string journal_path_for(const std::string &blueprint_path)
+        {
+            return blueprint_path + ".journal";
+        }
 
-        // Build JSON
-        json j;
-        j["name"] = sketch_.name;
-        j["width"] = sketch_.width;
-        j["height"] = sketch_.height;
-        j["created_timestamp"] = sketch_.created_timestamp;
-        j["grid"] = {
-            {"grid_spacing_percent", grid_config_.grid_spacing_percent},
-            {"real_world_spacing_cm", grid_config_.real_world_spacing_cm},
-            {"snap_to_grid", grid_config_.snap_to_grid},
-            {"show_measurements", grid_config_.show_measurements}
-        };
-        j["lines"] = json::array();
-        for (const auto &line : sketch_.lines)
+        bool same_grid(const GridConfig &a, const GridConfig &b)
         {
-            json li = { {"x0", line.start.x}, {"y0", line.start.y}, {"x1", line.end.x}, {"y1", line.end.y} };
-            j["lines"].push_back(li);
+            return a.grid_spacing_percent == b.grid_spacing_percent &&
+                   a.real_world_spacing_cm == b.real_world_spacing_cm &&
+                   a.snap_to_grid == b.snap_to_grid && a.show_measurements == b.show_measurements;
         }
 
-        // Compute signature
-        const char *secret_env = std::getenv("JARVIS_SECRET");
-        // Use deterministic binary serialization (CBOR) for signature computation
-        std::vector<uint8_t> cbor_sig = json::to_cbor(j);
-        std::string payload_sig(cbor_sig.begin(), cbor_sig.end());
-        std::string sig;
-        if (secret_env && *secret_env)
-            sig = crypto::hmac_sha256_hex(payload_sig, std::string(secret_env));
-        else
-            sig = crypto::sha256_hex(payload_sig);
-        j["signature"] = sig;
+    } // namespace
 
-        // Write atomically to a temp file then rename. Use restrictive permissions (user read/write only).
-        std::string tmp_path = full_path + ".tmp";
+    std::string SketchPad::resolve_path(const std::string &base_filename) const
+    {
+        std::string base = base_filename.empty() ? sketch_.name : base_filename;
+        std::string full_path = (base.find('/') == std::string::npos) ? std::string("blueprints/") + base : base;
+        if (full_path.find(".jarvis") == std::string::npos)
+            full_path += ".jarvis";
+        return full_path;
+    }
 
-        std::string payload = j.dump(2) + "\n";
+    std::string SketchPad::export_json() const
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        return export_json_blueprint(sketch_, grid_config_, blueprint_secret());
+    }
 
-        // Open temp file with 0600 permissions
-        int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
-        if (fd < 0)
+    bool SketchPad::save(const std::string &base_filename)
+    {
+        std::shared_ptr<const SaveSnapshot> snapshot;
+        PersistWorker *worker = nullptr;
         {
-            std::cerr << "[SketchPad] Failed to open temp file for writing: " << tmp_path << " (" << strerror(errno) << ")\n";
-            return false;
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            snapshot = snapshot_for_save(base_filename);
+            worker = persist_worker_;
         }
+        // Off-thread: the drawing loop only pays for the copy
+        if (worker)
+            return worker->submit(*this, snapshot);
+        return persist_snapshot(snapshot);
+    }
 
-        // Write full payload (loop to handle partial writes)
-        const char *buf = payload.data();
-        size_t to_write = payload.size();
-        while (to_write > 0)
-        {
-            ssize_t written = ::write(fd, buf, to_write);
-            if (written < 0)
-            {
-                if (errno == EINTR)
-                    continue;
-                std::cerr << "[SketchPad] Write error: " << strerror(errno) << "\n";
-                close(fd);
-                unlink(tmp_path.c_str());
-                return false;
-            }
-            to_write -= static_cast<size_t>(written);
-            buf += written;
-        }
+    std::shared_ptr<const SaveSnapshot> SketchPad::snapshot_for_save(const std::string &base_filename)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        auto snapshot = std::make_shared<SaveSnapshot>();
+        // Determine target path. If we previously loaded from an explicit path,
+        // prefer saving back to that same resolved file so edits go to the same file.
+        if ((base_filename.empty() || base_filename == sketch_.name) && !last_loaded_path_.empty())
+            snapshot->path = last_loaded_path_;
+        else
+            snapshot->path = resolve_path(base_filename);
+        snapshot->sketch = sketch_;
+        snapshot->grid = grid_config_;
+        snapshot->clear_epoch = clear_epoch_;
+        snapshot->content_generation = content_generation_;
+        snapshot->sequence = ++save_sequence_;
 
-        // Ensure data hits disk
-        if (fsync(fd) != 0)
-        {
-            std::cerr << "[SketchPad] fsync failed: " << strerror(errno) << "\n";
-            close(fd);
-            unlink(tmp_path.c_str());
-            return false;
-        }
+        // Remember where we saved so subsequent saves without filename write back
+        last_loaded_path_ = snapshot->path;
+        return snapshot;
+    }
 
-        if (close(fd) != 0)
+    bool SketchPad::persist_snapshot(const std::shared_ptr<const SaveSnapshot> &snapshot)
+    {
+        bool journaled = false;
         {
-            std::cerr << "[SketchPad] close failed: " << strerror(errno) << "\n";
-            unlink(tmp_path.c_str());
-            return false;
-        }
+            std::lock_guard<std::mutex> io(io_mutex_);
+            // A newer save (or a load) already reached disk
+            if (durable_.valid && snapshot->sequence <= durable_.sequence)
+                return true;
 
-        // Atomically replace target
-        if (rename(tmp_path.c_str(), full_path.c_str()) != 0)
-        {
-            std::cerr << "[SketchPad] rename failed: " << strerror(errno) << "\n";
-            unlink(tmp_path.c_str());
-            return false;
+            // Cheap path: append what changed since the last save to the journal.
+            // Anything the journal can't express falls back to a full rewrite.
+            journaled = journal_enabled_ && durable_.valid && journal_.is_open() &&
+                        durable_.content_generation == snapshot->content_generation &&
+                        durable_.path == snapshot->path && append_changes(*snapshot);
+            if (!journaled && !write_base(*snapshot))
+                return false;
+
+            last_persisted_ = snapshot;
+            if (journaled && journal_.record_count() >= compact_after_records_)
+                start_compaction(snapshot);
         }
+        JLOG_DEBUG("SketchPad") << "Saved project: '" << snapshot->path << "' (" << snapshot->sketch.lines.size()
+                                << " lines, " << (journaled ? "journal" : "full") << ")";
 
-        // Remember where we saved so subsequent saves without filename write back
-        last_loaded_path_ = full_path;
-        std::cerr << "[SketchPad] Saved project: '" << full_path << "'\n";
         // Invoke on-save callback if registered so external code can react
         // (e.g., post the saved file to a cloud server).
-        if (on_save_callback_)
+        std::function<void(const std::string &)> callback;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex_);
+            callback = on_save_callback_;
+        }
+        if (callback)
         {
             try
             {
-                on_save_callback_(full_path);
+                callback(snapshot->path);
             }
             catch (...) {
                 // Swallow exceptions - save succeeded; callback failure
@@ -1090,99 +1287,331 @@ namespace sketch
         return true;
     }
 
-    bool SketchPad::load(const std::string &base_filename)
+    SaveSnapshot SketchPad::snapshot_content() const
     {
-        std::string base = base_filename.empty() ? sketch_.name : base_filename;
-        std::string full_path = (base.find('/') == std::string::npos) ? std::string("blueprints/") + base : base;
-        if (full_path.find(".jarvis") == std::string::npos) full_path += ".jarvis";
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        SaveSnapshot snapshot;
+        snapshot.sketch = sketch_;
+        snapshot.grid = grid_config_;
+        snapshot.clear_epoch = clear_epoch_;
+        snapshot.content_generation = content_generation_;
+        return snapshot;
+    }
 
-        std::ifstream file(full_path);
-        if (!file.is_open())
-        {
-            std::cerr << "[SketchPad] Failed to open file for reading: " << full_path << "\n";
+    bool SketchPad::apply_remote_changes(const SaveSnapshot &seen, const std::vector<size_t> &remove,
+                                         const std::vector<Line> &add, const GridConfig *grid,
+                                         uint64_t *content_generation)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        size_t seen_lines = seen.sketch.lines.size();
+        if (clear_epoch_ != seen.clear_epoch || content_generation_ != seen.content_generation ||
+            sketch_.lines.size() < seen_lines)
             return false;
+        for (size_t i = 0; i < remove.size(); ++i)
+        {
+            if (remove[i] >= seen_lines || (i > 0 && remove[i] <= remove[i - 1]))
+                return false;
         }
-        json j;
-        try { file >> j; } catch (const std::exception &e) { std::cerr << "[SketchPad] JSON parse error: " << e.what() << "\n"; return false; }
-        file.close();
 
-        if (!j.contains("signature"))
+        std::vector<Line> &lines = sketch_.lines;
+        size_t insert_at = seen_lines;
+        if (!remove.empty())
         {
-            std::cerr << "[SketchPad] Missing signature in file: " << full_path << "\n";
-            return false;
+            size_t out = remove.front();
+            size_t next = 0;
+            for (size_t i = remove.front(); i < lines.size(); ++i)
+            {
+                if (next < remove.size() && remove[next] == i)
+                {
+                    ++next;
+                    continue;
+                }
+                lines[out++] = lines[i];
+            }
+            lines.resize(out);
+            insert_at -= remove.size();
         }
-        std::string sig = j["signature"].get<std::string>();
-        json jcopy = j;
-        jcopy.erase("signature");
-        // Recreate deterministic binary representation (CBOR) for verification
-        std::vector<uint8_t> cbor_verify = json::to_cbor(jcopy);
-        std::string payload(cbor_verify.begin(), cbor_verify.end());
-        const char *secret_env = std::getenv("JARVIS_SECRET");
-        std::string expected;
-        if (secret_env && *secret_env)
-            expected = crypto::hmac_sha256_hex(payload, std::string(secret_env));
-        else
-            expected = crypto::sha256_hex(payload);
+        bool appended = remove.empty() && insert_at == lines.size();
+        lines.insert(lines.begin() + static_cast<std::ptrdiff_t>(insert_at), add.begin(), add.end());
 
-        if (expected != sig)
+        if (grid)
         {
-            std::cerr << "[SketchPad] Signature mismatch (file may be tampered): " << full_path << "\n";
+            grid_config_.grid_spacing_percent = grid->grid_spacing_percent;
+            grid_config_.real_world_spacing_cm = grid->real_world_spacing_cm;
+            grid_config_.snap_to_grid = grid->snap_to_grid;
+            grid_config_.show_measurements = grid->show_measurements;
+        }
+        // The journal only appends; anything else makes the next save a full write
+        if (!appended)
+            ++content_generation_;
+        if (content_generation)
+            *content_generation = content_generation_;
+        return true;
+    }
+
+    void SketchPad::set_persist_worker(PersistWorker *worker)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        persist_worker_ = worker;
+    }
+
+    bool SketchPad::compact()
+    {
+        std::shared_ptr<const SaveSnapshot> snapshot = snapshot_for_save("");
+        std::lock_guard<std::mutex> io(io_mutex_);
+        if (!write_base(*snapshot))
             return false;
+        last_persisted_ = snapshot;
+        return true;
+    }
+
+    void SketchPad::wait_for_compaction()
+    {
+        std::thread worker;
+        {
+            std::lock_guard<std::mutex> io(io_mutex_);
+            worker.swap(compactor_);
         }
+        if (worker.joinable())
+            worker.join();
+    }
 
-        // Populate sketch and grid
-        try
+    size_t SketchPad::get_journal_records() const
+    {
+        std::lock_guard<std::mutex> io(io_mutex_);
+        return journal_.is_open() ? journal_.record_count() : 0;
+    }
+
+    // Full rewrite of the base file; the journal restarts against it
+    bool SketchPad::write_base(const SaveSnapshot &snapshot)
+    {
+        std::string sig;
+        if (!persist_blueprint(snapshot.path, snapshot.sketch, snapshot.grid, blueprint_secret(), &sig))
+            return false;
+        ++base_generation_;
+        mark_durable(snapshot);
+        if (journal_enabled_)
+        {
+            if (journal_.is_open() && journal_.path() == journal_path_for(snapshot.path))
+                journal_.reset(sig);
+            else
+                journal_.open(journal_path_for(snapshot.path), sig, blueprint_secret(), nullptr);
+        }
+        else
         {
-            sketch_.name = j.value("name", sketch_.name);
-            sketch_.width = j.value("width", sketch_.width);
-            sketch_.height = j.value("height", sketch_.height);
-            sketch_.created_timestamp = j.value("created_timestamp", sketch_.created_timestamp);
+            journal_.close();
+        }
+        return true;
+    }
+
+    SketchPad::DurableState SketchPad::durable_of(const SaveSnapshot &snapshot)
+    {
+        DurableState state;
+        state.valid = true;
+        state.path = snapshot.path;
+        state.lines = snapshot.sketch.lines.size();
+        state.grid = snapshot.grid;
+        state.clear_epoch = snapshot.clear_epoch;
+        state.content_generation = snapshot.content_generation;
+        state.sequence = snapshot.sequence;
+        return state;
+    }
+
+    void SketchPad::mark_durable(const SaveSnapshot &snapshot)
+    {
+        durable_ = durable_of(snapshot);
+    }
 
-            if (j.contains("grid"))
+    bool SketchPad::queue_changes(LineJournal &journal, const DurableState &from, const SaveSnapshot &to)
+    {
+        const std::vector<Line> &lines = to.sketch.lines;
+        size_t first = from.lines;
+        if (to.clear_epoch != from.clear_epoch)
+        {
+            journal.append_clear();
+            first = 0;
+        }
+        if (lines.size() < first)
+            return false; // lines removed some other way; rewrite instead
+        for (size_t i = first; i < lines.size(); ++i)
+            journal.append_line(lines[i]);
+        if (!same_grid(to.grid, from.grid))
+            journal.append_grid(to.grid);
+        return true;
+    }
+
+    bool SketchPad::append_changes(const SaveSnapshot &snapshot)
+    {
+        if (!queue_changes(journal_, durable_, snapshot) || !journal_.sync())
+            return false;
+        mark_durable(snapshot);
+        return true;
+    }
+
+    // Fold the journal into a fresh base without blocking the caller. The
+    // expensive part (encode, sign, write, fsync) runs on a worker against
+    // the snapshot; only installing the base and its journal take io_mutex_.
+    // The new journal, holding what was saved after the snapshot, is staged
+    // before the base is swapped, so every crash point leaves a base and a
+    // journal that together hold every saved line.
+    void SketchPad::start_compaction(const std::shared_ptr<const SaveSnapshot> &snapshot)
+    {
+        if (compacting_)
+            return;
+        if (compactor_.joinable())
+            compactor_.join(); // previous run has already released the lock
+
+        compacting_ = true;
+        uint64_t generation = base_generation_;
+        std::string secret = blueprint_secret();
+
+        compactor_ = std::thread([this, snapshot, generation, secret]()
+                                 {
+            const std::string &full_path = snapshot->path;
+            const std::string staged = full_path + ".compact";
+            std::string sig;
+            bool ok = stage_blueprint(staged, snapshot->sketch, snapshot->grid, secret, &sig);
+
+            std::lock_guard<std::mutex> io(io_mutex_);
+            const std::string journal_path = journal_.path();
+            const std::string next_journal = LineJournal::staged_path(journal_path);
+            // A full save or load in the meantime supersedes this snapshot
+            ok = ok && generation == base_generation_ && durable_.valid && durable_.path == full_path &&
+                 journal_.is_open() && journal_path == journal_path_for(full_path);
+            if (ok)
+            {
+                LineJournal next;
+                ok = next.open(next_journal, sig, secret, nullptr) &&
+                     (!last_persisted_ || last_persisted_ == snapshot ||
+                      queue_changes(next, durable_of(*snapshot), *last_persisted_)) &&
+                     next.sync();
+            }
+            if (ok && install_blueprint(staged, full_path, sig))
+            {
+                ++base_generation_;
+                size_t folded = journal_.record_count();
+                // Adopts the staged journal; durable_ already describes its end
+                if (!journal_.open(journal_path, sig, secret, nullptr))
+                    durable_.valid = false;
+                JLOG_INFO("SketchPad") << "Compacted " << folded << " journal record(s) into '" << full_path << "'";
+            }
+            else
             {
-                auto g = j["grid"];
-                grid_config_.grid_spacing_percent = g.value("grid_spacing_percent", grid_config_.grid_spacing_percent);
-                grid_config_.real_world_spacing_cm = g.value("real_world_spacing_cm", grid_config_.real_world_spacing_cm);
-                grid_config_.snap_to_grid = g.value("snap_to_grid", grid_config_.snap_to_grid);
-                grid_config_.show_measurements = g.value("show_measurements", grid_config_.show_measurements);
-                // If grid info exists in file, enable grid rendering
-                grid_config_.enabled = true;
+                unlink(staged.c_str());
+                unlink(next_journal.c_str());
             }
+            compacting_ = false; });
+    }
 
-            sketch_.lines.clear();
-                if (j.contains("lines") && j["lines"].is_array())
-                {
-                    for (auto &li : j["lines"]) {
-                        Line line;
-                        line.start.x = li.value("x0", 0.0f);
-                        line.start.y = li.value("y0", 0.0f);
-                        line.end.x = li.value("x1", 0.0f);
-                        line.end.y = li.value("y1", 0.0f);
-                        // If file doesn't include color/thickness, default to white and a sane thickness
-                        line.color = li.value("color", static_cast<uint32_t>(0x00FFFFFF));
-                        line.thickness = li.value("thickness", current_thickness_ > 0 ? current_thickness_ : 3);
-                        sketch_.lines.push_back(line);
-                    }
-                }
+    bool SketchPad::load(const std::string &base_filename)
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        std::string full_path = resolve_path(base_filename);
+
+        char magic[4] = {};
+        {
+            std::ifstream probe(full_path, std::ios::binary);
+            if (!probe.is_open())
+            {
+                std::cerr << "[SketchPad] Failed to open file for reading: " << full_path << "\n";
+                return false;
+            }
+            probe.read(magic, sizeof(magic));
         }
-        catch (const std::exception &e)
+
+        std::string base_signature;
+        if (is_binary_blueprint(magic, sizeof(magic)))
+        {
+            BlueprintView view;
+            if (!view.open(full_path))
+            {
+                std::cerr << "[SketchPad] " << view.error() << "\n";
+                return false;
+            }
+            base_signature = verified_blueprint_signature(view, full_path, blueprint_secret());
+            if (base_signature.empty())
+            {
+                std::cerr << "[SketchPad] Signature mismatch (file may be tampered): " << full_path << "\n";
+                return false;
+            }
+            view.to_sketch(sketch_, &grid_config_);
+        }
+        else if (!load_json_file(full_path))
         {
-            std::cerr << "[SketchPad] JSON load error: " << e.what() << "\n";
             return false;
         }
 
+        ++content_generation_;
+        size_t replayed = 0;
+        {
+            std::lock_guard<std::mutex> io(io_mutex_);
+            ++base_generation_;
+            journal_.close();
+            if (!base_signature.empty() && journal_enabled_)
+            {
+                // Changes saved since the base was last rewritten
+                std::vector<JournalRecord> records;
+                if (journal_.open(journal_path_for(full_path), base_signature, blueprint_secret(), &records))
+                {
+                    for (const auto &rec : records)
+                        LineJournal::apply(rec, sketch_.lines, grid_config_);
+                    replayed = records.size();
+                }
+            }
+            // What was just read is what is on disk. JSON imports are
+            // rewritten in the binary format on the next save.
+            durable_.valid = !base_signature.empty();
+            durable_.path = full_path;
+            durable_.lines = sketch_.lines.size();
+            durable_.grid = grid_config_;
+            durable_.clear_epoch = clear_epoch_;
+            durable_.content_generation = content_generation_;
+            durable_.sequence = save_sequence_;
+            last_persisted_.reset();
+        }
+
         // Reset state machine
         state_ = DrawingState::WAITING_FOR_START;
         current_confirmation_.reset();
         gesture_changed_since_start_ = false;
         position_buffer_.clear();
 
-        std::cerr << "[SketchPad] Loaded project: '" << full_path << "'\n";
+        std::cerr << "[SketchPad] Loaded project: '" << full_path << "' (" << sketch_.lines.size() << " lines";
+        if (replayed > 0)
+            std::cerr << ", " << replayed << " from journal";
+        std::cerr << ")\n";
         // Remember the resolved path so subsequent save() writes back to same file
         last_loaded_path_ = full_path;
         return true;
     }
 
+    // Legacy / imported JSON blueprint with an embedded CBOR signature.
+    // Verified and read in one streaming pass; no DOM or CBOR copy.
+    bool SketchPad::load_json_file(const std::string &full_path)
+    {
+        std::ifstream file(full_path, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        file.close();
+
+        const int default_thickness = current_thickness_ > 0 ? current_thickness_ : 3;
+        SignedJsonResult result = read_signed_json_blueprint(text.data(), text.size(), blueprint_secret(),
+                                                             default_thickness, sketch_, grid_config_);
+        switch (result)
+        {
+        case SignedJsonResult::OK:
+            return true;
+        case SignedJsonResult::MISSING_SIGNATURE:
+            std::cerr << "[SketchPad] Missing signature in file: " << full_path << "\n";
+            return false;
+        case SignedJsonResult::BAD_SIGNATURE:
+            std::cerr << "[SketchPad] Signature mismatch (file may be tampered): " << full_path << "\n";
+            return false;
+        default:
+            std::cerr << "[SketchPad] JSON load error (" << signed_json_result_name(result) << "): " << full_path << "\n";
+            return false;
+        }
+    }
+
     // Enterprise rendering with anti-aliasing
     void SketchPad::draw_aa_line(void *map, uint32_t stride, uint32_t width, uint32_t height,
                                  const Point &p0, const Point &p1, uint32_t color, int thickness)
@@ -1362,6 +1791,7 @@ namespace sketch
 
     void SketchPad::render(void *map, uint32_t stride, uint32_t width, uint32_t height)
     {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
         // Render grid first (background)
         if (grid_config_.enabled)
         {
@@ -1382,11 +1812,12 @@ namespace sketch
             // Choose a visible color for lines (fallback to white if unset)
             uint32_t draw_color = (line.color == 0) ? 0x00FFFFFF : line.color;
 
-            std::cerr << "[SketchPad][Render] Line: start=(" << line.start.x << "," << line.start.y << ") "
-                      << "end=(" << line.end.x << "," << line.end.y << ") "
-                      << "pixels=(" << start_px << "," << start_py << ") -> (" << end_px << "," << end_py << ") "
-                      << "color=0x" << std::hex << std::setw(8) << std::setfill('0') << draw_color << std::dec
-                      << " thickness=" << line.thickness << "\n";
+            // Per-line trace is compiled out unless JARVIS_LOG_COMPILE_LEVEL=0
+            JLOG_TRACE("SketchPad") << "[Render] Line: start=(" << line.start.x << "," << line.start.y << ") "
+                                    << "end=(" << line.end.x << "," << line.end.y << ") "
+                                    << "pixels=(" << start_px << "," << start_py << ") -> (" << end_px << "," << end_py << ") "
+                                    << "color=0x" << std::hex << std::setw(8) << std::setfill('0') << draw_color << std::dec
+                                    << " thickness=" << line.thickness;
 
             // Draw dots at start and end grid points
             const int dot_radius = 4;
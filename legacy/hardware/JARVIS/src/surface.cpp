@@ -0,0 +1,207 @@
+#include "surface.hpp"
+#include "draw_ticker.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <thread>
+
+namespace sketch
+{
+
+    // ------------------------------------------------------------------------
+    // Surface
+    // ------------------------------------------------------------------------
+
+    Surface::Surface(const SurfaceConfig &config)
+        : config_(config),
+          detector_(config.detector, config.production),
+          pad_(config.viewport_width, config.viewport_height),
+          calibrated_(false),
+          busy_(false),
+          frames_(0),
+          failures_(0),
+          last_frame_ns_(0)
+    {
+        pad_.init(config_.name, config_.viewport_width, config_.viewport_height);
+        pad_.set_camera_resolution(config_.camera.width, config_.camera.height);
+        if (!config_.calibration_path.empty())
+            pad_.load_calibration(config_.calibration_path);
+    }
+
+    Surface::~Surface()
+    {
+        stop();
+    }
+
+    bool Surface::start()
+    {
+        if (!camera_.init(config_.camera) || !camera_.start())
+        {
+            JLOG_ERROR("Surface") << "'" << config_.name << "' camera " << config_.camera.camera_index
+                                  << " failed: " << camera_.get_error();
+            return false;
+        }
+        source_ = [this]() -> const camera::Frame *
+        { return camera_.capture_frame(); };
+        JLOG_INFO("Surface") << "'" << config_.name << "' started on camera " << config_.camera.camera_index;
+        return true;
+    }
+
+    void Surface::stop()
+    {
+        if (camera_.is_running())
+            camera_.stop();
+    }
+
+    bool Surface::step()
+    {
+        const camera::Frame *frame = source_ ? source_() : nullptr;
+        if (!frame)
+        {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        process_frame(*frame);
+        return true;
+    }
+
+    void Surface::process_frame(const camera::Frame &frame)
+    {
+        auto detections = detector_.detect(frame);
+
+        // Same one-shot skin calibration as single-surface blueprint mode
+        if (!calibrated_ && !detections.empty() && detections[0].bbox.confidence > 0.7f)
+            calibrated_ = detector_.auto_calibrate(frame);
+
+        pad_.update(detections, frame.timestamp_ns);
+        last_frame_ns_.store(frame.timestamp_ns, std::memory_order_release);
+        uint64_t n = frames_.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (!detections.empty())
+            JLOG_EVERY_N(logger::Level::Debug, "Surface", 30)
+                << "'" << config_.name << "' frame " << n << ": " << detections.size() << " hand(s)";
+    }
+
+    void Surface::render(void *map, uint32_t stride, uint32_t width, uint32_t height)
+    {
+        if (!map || width == 0 || height == 0)
+            return;
+
+        uint32_t vx = std::min(config_.viewport_x, width);
+        uint32_t vy = std::min(config_.viewport_y, height);
+        uint32_t vw = std::min(config_.viewport_width, width - vx);
+        uint32_t vh = std::min(config_.viewport_height, height - vy);
+        if (vw == 0 || vh == 0)
+            return;
+
+        // The pixel writers infer bytes per pixel from stride / width, so a
+        // viewport narrower than the buffer is only drawn correctly on 32bpp
+        // buffers (the DRM/GBM path; not a 16bpp /dev/fb0)
+        uint8_t *origin = static_cast<uint8_t *>(map) + static_cast<size_t>(vy) * stride + static_cast<size_t>(vx) * 4;
+        draw_ticker::clear_buffer(origin, stride, vw, vh, 0x00000000);
+        pad_.render(origin, stride, vw, vh);
+        // Measured capture -> display latency drives fingertip prediction
+        uint64_t shown = last_frame_ns_.load(std::memory_order_acquire);
+        if (shown != 0)
+            pad_.note_frame_displayed(shown);
+    }
+
+    // ------------------------------------------------------------------------
+    // MultiSurfaceRunner
+    // ------------------------------------------------------------------------
+
+    MultiSurfaceRunner::MultiSurfaceRunner(size_t threads) : threads_(threads) {}
+
+    MultiSurfaceRunner::~MultiSurfaceRunner()
+    {
+        stop();
+    }
+
+    Surface &MultiSurfaceRunner::add_surface(const SurfaceConfig &config)
+    {
+        surfaces_.push_back(std::make_unique<Surface>(config));
+        return *surfaces_.back();
+    }
+
+    bool MultiSurfaceRunner::start_all()
+    {
+        bool ok = true;
+        for (auto &s : surfaces_)
+            ok = s->start() && ok;
+        return ok;
+    }
+
+    size_t MultiSurfaceRunner::pump()
+    {
+        if (!pool_)
+        {
+            size_t n = threads_;
+            if (n == 0)
+                n = std::min<size_t>(std::max<size_t>(surfaces_.size(), 1),
+                                     std::max(1u, std::thread::hardware_concurrency()));
+            pool_ = std::make_unique<jarvis::WorkerPool>(n);
+        }
+
+        size_t queued = 0;
+        for (auto &s : surfaces_)
+        {
+            bool expected = false;
+            if (!s->busy_.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                continue; // previous step still running
+
+            Surface *surface = s.get();
+            bool ok = pool_->submit([surface]()
+                                    {
+                surface->step();
+                surface->busy_.store(false, std::memory_order_release); });
+            if (!ok)
+            {
+                s->busy_.store(false, std::memory_order_release);
+                continue;
+            }
+            ++queued;
+        }
+        return queued;
+    }
+
+    void MultiSurfaceRunner::wait_idle()
+    {
+        if (pool_)
+            pool_->wait_idle();
+    }
+
+    void MultiSurfaceRunner::render_all(void *map, uint32_t stride, uint32_t width, uint32_t height)
+    {
+        for (auto &s : surfaces_)
+            s->render(map, stride, width, height);
+    }
+
+    void MultiSurfaceRunner::stop()
+    {
+        if (pool_)
+            pool_->shutdown();
+        for (auto &s : surfaces_)
+            s->stop();
+    }
+
+    std::vector<SurfaceConfig> MultiSurfaceRunner::split_viewports(const SurfaceConfig &base, size_t count,
+                                                                   uint32_t width, uint32_t height)
+    {
+        std::vector<SurfaceConfig> out;
+        if (count == 0)
+            return out;
+        uint32_t column = width / static_cast<uint32_t>(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            SurfaceConfig c = base;
+            c.name = base.name + "_" + std::to_string(i);
+            c.camera.camera_index = static_cast<int>(i);
+            c.viewport_x = static_cast<uint32_t>(i) * column;
+            c.viewport_y = 0;
+            // Last column absorbs the rounding remainder
+            c.viewport_width = (i + 1 == count) ? width - c.viewport_x : column;
+            c.viewport_height = height;
+            out.push_back(c);
+        }
+        return out;
+    }
+
+} // namespace sketch
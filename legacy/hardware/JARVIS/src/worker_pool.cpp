@@ -0,0 +1,87 @@
+#include "worker_pool.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace jarvis
+{
+
+    WorkerPool::WorkerPool(size_t threads)
+    {
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            workers_.emplace_back(&WorkerPool::worker_loop, this);
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        shutdown();
+    }
+
+    bool WorkerPool::submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_)
+                return false;
+            tasks_.push_back(std::move(task));
+        }
+        work_cv_.notify_one();
+        return true;
+    }
+
+    void WorkerPool::wait_idle()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this]
+                      { return tasks_.empty() && active_ == 0; });
+    }
+
+    void WorkerPool::shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto &t : workers_)
+        {
+            if (t.joinable())
+                t.join();
+        }
+    }
+
+    void WorkerPool::worker_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;)
+        {
+            work_cv_.wait(lock, [this]
+                          { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return; // stopping and drained
+
+            std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            ++active_;
+            lock.unlock();
+
+            try
+            {
+                task();
+            }
+            catch (const std::exception &e)
+            {
+                JLOG_ERROR("WorkerPool") << "Task threw: " << e.what();
+            }
+
+            lock.lock();
+            --active_;
+            if (tasks_.empty() && active_ == 0)
+                idle_cv_.notify_all();
+        }
+    }
+
+} // namespace jarvis
@@ -0,0 +1,180 @@
+#pragma once
+
+// In-memory stand-in for the server's line event stream.
+//
+// Keeps the current lines plus a log of add/remove/clear events with
+// sequence numbers and answers
+//   GET <path>?since=<seq>&wait_ms=<n>
+// long-poll style: the events after `since` (at most max_batch), or, if
+// there are none yet, whatever arrives within wait_ms. A `since` of 0 or
+// older than the retained log gets a snapshot.
+
+#include "local_http_server.hpp"
+
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace test_http
+{
+
+    class LiveLineServer
+    {
+    public:
+        struct Line
+        {
+            int x0, y0, x1, y1, thickness;
+            std::string color;
+        };
+
+        explicit LiveLineServer(std::string path = "/dots/events", size_t max_batch = 500)
+            : path_(std::move(path)), max_batch_(max_batch),
+              server_([this](const Request &r) { return handle(r); })
+        {
+        }
+        ~LiveLineServer()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+            cv_.notify_all();
+        }
+
+        uint16_t port() const { return server_.port(); }
+        const std::string &path() const { return path_; }
+
+        void add(const std::string &id, const Line &line)
+        {
+            nlohmann::json j = line_json(id, line);
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_[id] = line;
+            log("add", j.dump());
+        }
+        void remove(const std::string &id)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_.erase(id);
+            log("remove", nlohmann::json({{"id", id}}).dump());
+        }
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_.clear();
+            log("clear", "{}");
+        }
+        // Forget the event log: later requests get a snapshot
+        void drop_history()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            history_start_ = seq_;
+            events_.clear();
+        }
+
+        std::map<std::string, Line> lines() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return lines_;
+        }
+        uint64_t seq() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return seq_;
+        }
+        int requests() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return requests_;
+        }
+        int snapshots() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return snapshots_;
+        }
+
+    private:
+        struct Event
+        {
+            uint64_t seq;
+            std::string text; // SSE framing
+        };
+
+        static nlohmann::json line_json(const std::string &id, const Line &l)
+        {
+            return {{"id", id}, {"x0", l.x0}, {"y0", l.y0}, {"x1", l.x1}, {"y1", l.y1},
+                    {"thickness", l.thickness}, {"color", l.color}};
+        }
+
+        void log(const std::string &type, const std::string &data)
+        {
+            ++seq_;
+            events_.push_back(Event{seq_, "id: " + std::to_string(seq_) + "\nevent: " + type + "\ndata: " + data + "\n\n"});
+            cv_.notify_all();
+        }
+
+        static uint64_t param(const std::string &target, const char *name)
+        {
+            std::string key = std::string(name) + "=";
+            auto pos = target.find(key);
+            return pos == std::string::npos ? 0 : std::strtoull(target.c_str() + pos + key.size(), nullptr, 10);
+        }
+
+        Reply handle(const Request &r)
+        {
+            if (r.path.compare(0, path_.size(), path_) != 0)
+                return response(404, "{\"error\":\"not found\"}");
+            uint64_t since = param(r.path, "since");
+            int wait_ms = static_cast<int>(param(r.path, "wait_ms"));
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++requests_;
+            std::string body;
+            if (since == 0 || since < history_start_ || since > seq_)
+            {
+                ++snapshots_;
+                nlohmann::json all = nlohmann::json::array();
+                for (const auto &entry : lines_)
+                    all.push_back(line_json(entry.first, entry.second));
+                body = "id: " + std::to_string(seq_) + "\nevent: snapshot\ndata: " +
+                       nlohmann::json({{"lines", all}}).dump() + "\n\n";
+            }
+            else
+            {
+                cv_.wait_for(lock, std::chrono::milliseconds(wait_ms),
+                             [&]() { return closing_ || seq_ > since; });
+                size_t sent = 0;
+                for (const auto &e : events_)
+                {
+                    if (e.seq <= since)
+                        continue;
+                    body += e.text;
+                    if (++sent == max_batch_)
+                        break;
+                }
+                if (sent == 0)
+                    body = ": idle\n\n";
+            }
+            Reply reply;
+            reply.bytes = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nContent-Length: " +
+                          std::to_string(body.size()) + "\r\n\r\n" + body;
+            return reply;
+        }
+
+        std::string path_;
+        size_t max_batch_;
+        mutable std::mutex mutex_;
+        std::condition_variable cv_;
+        std::map<std::string, Line> lines_;
+        std::vector<Event> events_;
+        uint64_t seq_ = 0;
+        uint64_t history_start_ = 0;
+        int requests_ = 0;
+        int snapshots_ = 0;
+        bool closing_ = false;
+        LocalHttpServer server_; // last: stops before the state above goes away
+    };
+
+} // namespace test_http
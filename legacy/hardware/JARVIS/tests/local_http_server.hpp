@@ -0,0 +1,280 @@
+#pragma once
+
+// Loopback HTTP/1.1 server for client tests.
+//
+// Listens on 127.0.0.1 with an ephemeral port, serves keep-alive
+// connections (one thread each) and hands every parsed request to a
+// handler that returns the raw response bytes. With TLS enabled it uses a
+// throwaway self-signed certificate generated at startup.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace test_http
+{
+
+    struct Request
+    {
+        std::string method;
+        std::string path;
+        std::map<std::string, std::string> headers; // names lowercased
+        std::string body;
+        int connection = 0; // index of the accepted connection it arrived on
+
+        std::string header(const std::string &lower_name) const
+        {
+            auto it = headers.find(lower_name);
+            return it == headers.end() ? std::string() : it->second;
+        }
+    };
+
+    // Raw response bytes. Set close to drop the connection after sending.
+    struct Reply
+    {
+        std::string bytes;
+        bool close = false;
+    };
+
+    inline Reply response(int status, const std::string &body,
+                          const std::string &extra_headers = std::string())
+    {
+        Reply r;
+        r.bytes = "HTTP/1.1 " + std::to_string(status) + " X\r\nContent-Type: application/json\r\n" +
+                  extra_headers + "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        return r;
+    }
+
+    class LocalHttpServer
+    {
+    public:
+        using Handler = std::function<Reply(const Request &)>;
+
+        explicit LocalHttpServer(Handler handler, bool tls = false)
+            : handler_(std::move(handler))
+        {
+            if (tls)
+                init_tls();
+            listen_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+            int one = 1;
+            setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            ::bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+            socklen_t len = sizeof(addr);
+            getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+            port_ = ntohs(addr.sin_port);
+            ::listen(listen_fd_, 64);
+            accept_thread_ = std::thread([this]() { accept_loop(); });
+        }
+
+        ~LocalHttpServer() { stop(); }
+
+        uint16_t port() const { return port_; }
+        int accepted() const { return accepted_.load(); }
+        int requests() const { return requests_.load(); }
+
+        // Close every open connection, as a server dropping idle keep-alives does
+        void close_connections()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (int fd : open_fds_)
+                ::shutdown(fd, SHUT_RDWR);
+        }
+
+        void stop()
+        {
+            if (stopping_.exchange(true))
+                return;
+            ::shutdown(listen_fd_, SHUT_RDWR);
+            if (accept_thread_.joinable())
+                accept_thread_.join();
+            close_connections();
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                threads.swap(connection_threads_);
+            }
+            for (auto &t : threads)
+                t.join();
+            ::close(listen_fd_);
+            if (ctx_)
+                SSL_CTX_free(ctx_);
+        }
+
+    private:
+        void init_tls()
+        {
+            EVP_PKEY *pkey = nullptr;
+            EVP_PKEY_CTX *kctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+            EVP_PKEY_keygen_init(kctx);
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(kctx, NID_X9_62_prime256v1);
+            EVP_PKEY_keygen(kctx, &pkey);
+            EVP_PKEY_CTX_free(kctx);
+
+            X509 *cert = X509_new();
+            X509_set_version(cert, 2);
+            ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+            X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+            X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+            X509_set_pubkey(cert, pkey);
+            X509_NAME *name = X509_get_subject_name(cert);
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                       reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+            X509_set_issuer_name(cert, name);
+            X509_sign(cert, pkey, EVP_sha256());
+
+            ctx_ = SSL_CTX_new(TLS_server_method());
+            SSL_CTX_use_certificate(ctx_, cert);
+            SSL_CTX_use_PrivateKey(ctx_, pkey);
+            SSL_CTX_set_session_id_context(ctx_, reinterpret_cast<const unsigned char *>("jarvis"), 6);
+            X509_free(cert);
+            EVP_PKEY_free(pkey);
+        }
+
+        void accept_loop()
+        {
+            while (!stopping_)
+            {
+                int fd = ::accept(listen_fd_, nullptr, nullptr);
+                if (fd < 0)
+                    return;
+                int index = accepted_.fetch_add(1);
+                std::lock_guard<std::mutex> lock(mutex_);
+                open_fds_.push_back(fd);
+                connection_threads_.emplace_back([this, fd, index]() { serve(fd, index); });
+            }
+        }
+
+        void serve(int fd, int index)
+        {
+            SSL *ssl = nullptr;
+            if (ctx_)
+            {
+                ssl = SSL_new(ctx_);
+                SSL_set_fd(ssl, fd);
+                if (SSL_accept(ssl) != 1)
+                {
+                    SSL_free(ssl);
+                    ssl = nullptr;
+                    finish(fd);
+                    return;
+                }
+            }
+            auto read_more = [&](std::string &buf) {
+                char tmp[4096];
+                int n = ssl ? SSL_read(ssl, tmp, sizeof(tmp)) : static_cast<int>(::recv(fd, tmp, sizeof(tmp), 0));
+                if (n <= 0)
+                    return false;
+                buf.append(tmp, static_cast<size_t>(n));
+                return true;
+            };
+            auto write_all = [&](const std::string &bytes) {
+                size_t off = 0;
+                while (off < bytes.size())
+                {
+                    int n = ssl ? SSL_write(ssl, bytes.data() + off, static_cast<int>(bytes.size() - off))
+                                : static_cast<int>(::send(fd, bytes.data() + off, bytes.size() - off, MSG_NOSIGNAL));
+                    if (n <= 0)
+                        return false;
+                    off += static_cast<size_t>(n);
+                }
+                return true;
+            };
+
+            std::string buf;
+            while (!stopping_)
+            {
+                size_t header_end;
+                while ((header_end = buf.find("\r\n\r\n")) == std::string::npos)
+                    if (!read_more(buf))
+                        goto done;
+
+                {
+                    Request req;
+                    req.connection = index;
+                    size_t line_end = buf.find("\r\n");
+                    std::string line = buf.substr(0, line_end);
+                    size_t sp1 = line.find(' ');
+                    size_t sp2 = line.find(' ', sp1 + 1);
+                    req.method = line.substr(0, sp1);
+                    req.path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+                    for (size_t pos = line_end + 2; pos < header_end;)
+                    {
+                        size_t eol = buf.find("\r\n", pos);
+                        size_t colon = buf.find(':', pos);
+                        if (colon != std::string::npos && colon < eol)
+                        {
+                            std::string key = buf.substr(pos, colon - pos);
+                            std::transform(key.begin(), key.end(), key.begin(),
+                                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                            size_t v = buf.find_first_not_of(' ', colon + 1);
+                            req.headers[key] = buf.substr(v, eol - v);
+                        }
+                        pos = eol + 2;
+                    }
+                    size_t length = std::strtoul(req.header("content-length").c_str(), nullptr, 10);
+                    while (buf.size() < header_end + 4 + length)
+                        if (!read_more(buf))
+                            goto done;
+                    req.body = buf.substr(header_end + 4, length);
+                    buf.erase(0, header_end + 4 + length);
+
+                    ++requests_;
+                    Reply reply = handler_(req);
+                    if (!write_all(reply.bytes) || reply.close || req.header("connection") == "close")
+                        goto done;
+                }
+            }
+        done:
+            if (ssl)
+            {
+                SSL_shutdown(ssl);
+                SSL_free(ssl);
+            }
+            finish(fd);
+        }
+
+        void finish(int fd)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            open_fds_.erase(std::remove(open_fds_.begin(), open_fds_.end(), fd), open_fds_.end());
+            ::close(fd);
+        }
+
+        Handler handler_;
+        SSL_CTX *ctx_ = nullptr;
+        int listen_fd_ = -1;
+        uint16_t port_ = 0;
+        std::atomic<bool> stopping_{false};
+        std::atomic<int> accepted_{0};
+        std::atomic<int> requests_{0};
+        std::mutex mutex_;
+        std::vector<int> open_fds_;
+        std::vector<std::thread> connection_threads_;
+        std::thread accept_thread_;
+    };
+
+} // namespace test_http
@@ -0,0 +1,227 @@
+#pragma once
+
+// In-memory stand-in for the server side of blueprint delta sync.
+//
+// Holds one blueprint as id -> line plus a version counter and the
+// history of accepted pushes, and answers
+//   POST <push_path>               delta against "base"; 409 if base is stale
+//   GET  <pull_path>?since=<v>     changes after v, or a full snapshot
+// Bodies may be deflated in either direction. With deltas disabled every
+// request gets a 404, like a server that only knows full uploads.
+
+#include "blueprint_sync.hpp"
+#include "local_http_server.hpp"
+
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace test_http
+{
+
+    class SyncStandInServer
+    {
+    public:
+        explicit SyncStandInServer(bool deltas = true)
+            : deltas_(deltas), server_([this](const Request &r) { return handle(r); })
+        {
+        }
+
+        uint16_t port() const { return server_.port(); }
+        std::string push_path() const { return "/api/workstation/blueprint/push/ws/bp"; }
+        std::string pull_path() const { return "/api/workstation/blueprint/pull/ws/bp"; }
+
+        sketch::SyncEndpoint endpoint() const
+        {
+            sketch::SyncEndpoint ep;
+            ep.host = "127.0.0.1";
+            ep.port = port();
+            ep.push_path = push_path();
+            ep.pull_path = pull_path();
+            ep.timeout_ms = 2000;
+            return ep;
+        }
+
+        uint64_t version() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return version_;
+        }
+        size_t line_count() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return lines_.size();
+        }
+        sketch::GridConfig grid() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return grid_;
+        }
+        std::map<std::string, uint64_t> version_vector() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return vv_;
+        }
+        // Bytes of the last push body as received, and whether it was deflated
+        size_t last_push_bytes() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return last_push_bytes_;
+        }
+        bool last_push_deflated() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return last_push_deflated_;
+        }
+        size_t last_pull_bytes() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return last_pull_bytes_;
+        }
+        int pushes() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return pushes_;
+        }
+        // Forget the history: every later pull gets a full snapshot
+        void drop_history()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            history_.clear();
+            history_start_ = version_;
+        }
+
+    private:
+        Reply handle(const Request &r)
+        {
+            if (!deltas_)
+                return response(404, "{\"error\":\"not found\"}");
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (r.method == "POST" && r.path == push_path())
+                return push(r);
+            if (r.method == "GET" && r.path.compare(0, pull_path().size(), pull_path()) == 0)
+                return pull(r);
+            return response(404, "{\"error\":\"not found\"}");
+        }
+
+        Reply push(const Request &r)
+        {
+            std::string body = r.body;
+            last_push_bytes_ = r.body.size();
+            last_push_deflated_ = r.header("content-encoding") == "deflate";
+            if (last_push_deflated_ && !sketch::inflate_body(r.body, body))
+                return response(400, "{\"error\":\"bad deflate\"}");
+            sketch::LineDelta delta;
+            if (!sketch::decode_line_delta(body, delta))
+                return response(400, "{\"error\":\"bad delta\"}");
+            if (delta.base != version_)
+                return response(409, "{\"version\":" + std::to_string(version_) + "}");
+
+            if (delta.clear)
+                lines_.clear();
+            for (const auto &id : delta.removed)
+                lines_.erase(id);
+            for (const auto &entry : delta.added)
+                lines_[entry.first] = entry.second;
+            if (delta.grid_changed)
+                grid_ = delta.grid;
+            ++version_;
+            ++pushes_;
+            if (!delta.device.empty())
+                ++vv_[delta.device];
+            delta.version = version_;
+            history_.push_back(delta);
+
+            sketch::LineDelta answer;
+            answer.version = version_;
+            answer.version_vector = vv_;
+            return response(200, sketch::encode_line_delta(answer));
+        }
+
+        Reply pull(const Request &r)
+        {
+            uint64_t since = 0;
+            auto q = r.path.find("since=");
+            if (q != std::string::npos)
+                since = std::strtoull(r.path.c_str() + q + 6, nullptr, 10);
+
+            sketch::LineDelta out;
+            out.base = since;
+            out.version = version_;
+            out.version_vector = vv_;
+            if (since == version_)
+            {
+                // nothing new
+            }
+            else if (since == 0 || since < history_start_ || since > version_)
+            {
+                out.full = true;
+                out.clear = true;
+                for (const auto &entry : lines_)
+                    out.added.push_back(entry);
+                out.grid_changed = true;
+                out.grid = grid_;
+            }
+            else
+            {
+                // Fold the pushes after `since` into one change
+                std::map<std::string, sketch::Line> added;
+                std::set<std::string> removed;
+                for (const auto &op : history_)
+                {
+                    if (op.version <= since)
+                        continue;
+                    if (op.clear)
+                    {
+                        out.clear = true;
+                        added.clear();
+                        removed.clear();
+                    }
+                    for (const auto &id : op.removed)
+                        if (!added.erase(id) && !out.clear)
+                            removed.insert(id);
+                    for (const auto &entry : op.added)
+                        if (!removed.erase(entry.first))
+                            added[entry.first] = entry.second;
+                    if (op.grid_changed)
+                    {
+                        out.grid_changed = true;
+                        out.grid = op.grid;
+                    }
+                }
+                out.removed.assign(removed.begin(), removed.end());
+                out.added.assign(added.begin(), added.end());
+            }
+
+            std::string body = sketch::encode_line_delta(out);
+            std::string packed;
+            std::string extra;
+            if (r.header("accept-encoding").find("deflate") != std::string::npos && body.size() > 256 &&
+                sketch::deflate_body(body, packed))
+            {
+                body.swap(packed);
+                extra = "Content-Encoding: deflate\r\n";
+            }
+            last_pull_bytes_ = body.size();
+            return response(200, body, extra);
+        }
+
+        bool deltas_;
+        mutable std::mutex mutex_;
+        uint64_t version_ = 0;
+        std::map<std::string, sketch::Line> lines_;
+        sketch::GridConfig grid_;
+        std::map<std::string, uint64_t> vv_;
+        std::vector<sketch::LineDelta> history_;
+        uint64_t history_start_ = 0;
+        size_t last_push_bytes_ = 0;
+        bool last_push_deflated_ = false;
+        size_t last_pull_bytes_ = 0;
+        int pushes_ = 0;
+        LocalHttpServer server_; // last: stops before the state above goes away
+    };
+
+} // namespace test_http
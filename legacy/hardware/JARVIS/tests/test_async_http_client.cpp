@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "async_http_client.hpp"
+#include "local_http_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long long ms_since(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+// Echoes the request; /slow/<ms> answers after that many milliseconds
+test_http::Reply slow_echo(const test_http::Request &req) {
+    if (req.path.compare(0, 6, "/slow/") == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::atoi(req.path.c_str() + 6)));
+    return test_http::response(200, req.method + " " + req.path + " " + req.body);
+}
+
+} // namespace
+
+// Requests are in flight together; the caller never waits on the network
+TEST(AsyncHttpClientTest, ConcurrentRequestsOverlap) {
+    test_http::LocalHttpServer server(slow_echo);
+    AsyncHttpClient client(4);
+
+    auto start = Clock::now();
+    std::vector<std::future<HttpResponse>> futures;
+    for (int i = 0; i < 4; ++i)
+        futures.push_back(client.get("127.0.0.1", server.port(), "/slow/200", 2000));
+    EXPECT_LT(ms_since(start), 50);
+
+    for (auto &f : futures) {
+        HttpResponse r = f.get();
+        EXPECT_TRUE(r.ok) << r.error;
+        EXPECT_EQ(r.status, 200);
+        EXPECT_EQ(r.body, "GET /slow/200 ");
+    }
+    // Serially this would take 800 ms
+    EXPECT_LT(ms_since(start), 600);
+    EXPECT_EQ(client.stats().peak_in_flight, 4u);
+}
+
+TEST(AsyncHttpClientTest, PerHostLimitQueuesAndReuses) {
+    test_http::LocalHttpServer server(slow_echo);
+    AsyncHttpClient client(2);
+    std::vector<std::future<HttpResponse>> futures;
+    for (int i = 0; i < 6; ++i)
+        futures.push_back(client.get("127.0.0.1", server.port(), "/slow/30", 2000));
+    for (auto &f : futures)
+        EXPECT_TRUE(f.get().ok);
+
+    EXPECT_EQ(server.accepted(), 2);
+    AsyncHttpStats stats = client.stats();
+    EXPECT_EQ(stats.connects, 2u);
+    EXPECT_EQ(stats.reuses, 4u);
+    EXPECT_EQ(stats.completed, 6u);
+    EXPECT_EQ(stats.in_flight, 0u);
+}
+
+TEST(AsyncHttpClientTest, CallbackAndHeaders) {
+    test_http::LocalHttpServer server([](const test_http::Request &req) {
+        return test_http::response(201, req.body + "|" + req.header("x-trace"), "ETag: \"v1\"\r\n");
+    });
+    AsyncHttpClient client;
+
+    HttpRequest req;
+    req.method = "POST";
+    req.host = "127.0.0.1";
+    req.port = server.port();
+    req.path = "/save";
+    req.body = "{\"name\":\"desk\"}";
+    req.headers.emplace_back("X-Trace", "abc");
+
+    std::promise<HttpResponse> done;
+    client.send(req, [&](HttpResponse r) { done.set_value(std::move(r)); });
+    HttpResponse r = done.get_future().get();
+    EXPECT_TRUE(r.ok);
+    EXPECT_EQ(r.status, 201);
+    EXPECT_EQ(r.body, "{\"name\":\"desk\"}|abc");
+    EXPECT_EQ(r.header("etag"), "\"v1\"");
+}
+
+TEST(AsyncHttpClientTest, ErrorsAndTimeouts) {
+    test_http::LocalHttpServer server([](const test_http::Request &req) {
+        if (req.path == "/missing")
+            return test_http::response(404, "nope");
+        return slow_echo(req);
+    });
+    AsyncHttpClient client;
+
+    auto start = Clock::now();
+    auto slow = client.get("127.0.0.1", server.port(), "/slow/300", 100);
+    auto fast = client.get("127.0.0.1", server.port(), "/fast", 1000);
+    auto missing = client.get("127.0.0.1", server.port(), "/missing", 1000);
+    auto refused = client.get("127.0.0.1", 1, "/", 1000);
+
+    HttpResponse f = fast.get();
+    EXPECT_TRUE(f.ok);
+    EXPECT_LT(ms_since(start), 100); // not held up by the slow one
+
+    HttpResponse s = slow.get();
+    EXPECT_FALSE(s.ok);
+    EXPECT_EQ(s.error, "recv timeout");
+    EXPECT_LT(ms_since(start), 500);
+
+    HttpResponse m = missing.get();
+    EXPECT_FALSE(m.ok);
+    EXPECT_EQ(m.status, 404);
+    EXPECT_EQ(m.error, "HTTP error: 404 body=nope");
+
+    HttpResponse c = refused.get();
+    EXPECT_FALSE(c.ok);
+    EXPECT_EQ(c.status, 0);
+    EXPECT_EQ(c.error.compare(0, 14, "connect failed"), 0) << c.error;
+}
+
+// A connection the server dropped while idle is replaced transparently
+TEST(AsyncHttpClientTest, RetriesConnectionClosedWhileIdle) {
+    test_http::LocalHttpServer server(slow_echo);
+    AsyncHttpClient client(1);
+    EXPECT_TRUE(client.get("127.0.0.1", server.port(), "/a", 1000).get().ok);
+    server.close_connections();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    HttpResponse r = client.post("127.0.0.1", server.port(), "/b", "x", "text/plain", 1000).get();
+    EXPECT_TRUE(r.ok) << r.error;
+    EXPECT_EQ(r.body, "POST /b x");
+    EXPECT_EQ(server.accepted(), 2);
+    EXPECT_EQ(server.requests(), 2);
+}
+
+TEST(AsyncHttpClientTest, TlsRequests) {
+    test_http::LocalHttpServer server(slow_echo, true);
+    AsyncHttpClient client(3);
+    std::vector<std::future<HttpResponse>> futures;
+    for (int i = 0; i < 6; ++i)
+        futures.push_back(client.get("127.0.0.1", server.port(), "/slow/20", 2000, true));
+    for (auto &f : futures) {
+        HttpResponse r = f.get();
+        EXPECT_TRUE(r.ok) << r.error;
+        EXPECT_EQ(r.body, "GET /slow/20 ");
+    }
+    EXPECT_LE(server.accepted(), 3);
+}
+
+TEST(AsyncHttpClientTest, ShutdownFailsPendingRequests) {
+    test_http::LocalHttpServer server(slow_echo);
+    auto client = std::make_unique<AsyncHttpClient>(1);
+    auto first = client->get("127.0.0.1", server.port(), "/slow/300", 2000);
+    auto queued = client->get("127.0.0.1", server.port(), "/slow/300", 2000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    auto start = Clock::now();
+    client->shutdown();
+    EXPECT_LT(ms_since(start), 200);
+    EXPECT_EQ(first.get().error, "client shut down");
+    EXPECT_EQ(queued.get().error, "client shut down");
+    EXPECT_EQ(client->get("127.0.0.1", server.port(), "/", 100).get().error, "client shut down");
+    client.reset();
+}
@@ -0,0 +1,230 @@
+#include <gtest/gtest.h>
+#include "blueprint_format.hpp"
+#include "sketch_pad.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+
+using namespace sketch;
+
+namespace {
+
+const char *kDir = "blueprint_format_test";
+
+std::string path_of(const std::string &name) {
+    return std::string(kDir) + "/" + name + ".jarvis";
+}
+
+std::string read_all(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void write_all(const std::string &path, const std::string &data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << data;
+}
+
+Sketch make_sketch(size_t lines) {
+    Sketch s;
+    s.name = "columnar";
+    s.width = 1920;
+    s.height = 1080;
+    s.created_timestamp = 1234567890123ull;
+    for (size_t i = 0; i < lines; ++i) {
+        Line l;
+        l.start = Point(static_cast<float>(i % 100), 1.5f);
+        l.end = Point(2.5f, static_cast<float>(i % 97));
+        l.color = 0x00FF0000u + static_cast<uint32_t>(i);
+        l.thickness = static_cast<int>(i % 7) + 1;
+        s.lines.push_back(l);
+    }
+    return s;
+}
+
+class BlueprintFormatTest : public ::testing::Test {
+protected:
+    void SetUp() override { mkdir(kDir, 0755); }
+    void TearDown() override {
+        for (const char *n : {"pad", "legacy", "tamper", "crash"}) {
+            std::remove(path_of(n).c_str());
+            std::remove((path_of(n) + ".new").c_str());
+            std::remove(blueprint_signature_path(path_of(n)).c_str());
+            std::remove((path_of(n) + ".journal").c_str());
+        }
+        rmdir(kDir);
+    }
+};
+
+} // namespace
+
+TEST_F(BlueprintFormatTest, EncodeAndViewRoundTrip) {
+    Sketch s = make_sketch(5);
+    GridConfig grid;
+    grid.grid_spacing_percent = 2.5f;
+    grid.real_world_spacing_cm = 10.0f;
+    grid.snap_to_grid = false;
+    grid.show_measurements = true;
+
+    std::string bytes = encode_blueprint(s, grid);
+    ASSERT_TRUE(is_binary_blueprint(bytes.data(), bytes.size()));
+
+    BlueprintView view;
+    ASSERT_TRUE(view.attach(bytes.data(), bytes.size())) << view.error();
+    EXPECT_EQ(view.header().version, kBlueprintVersion);
+    EXPECT_EQ(view.line_count(), 5u);
+    EXPECT_EQ(view.name(), "columnar");
+    EXPECT_FLOAT_EQ(view.x0()[3], 3.0f);
+    EXPECT_FLOAT_EQ(view.y1()[4], 4.0f);
+    EXPECT_EQ(view.color()[2], 0x00FF0002u);
+    EXPECT_EQ(view.thickness()[6 % 5], 2);
+
+    Sketch out;
+    GridConfig out_grid;
+    view.to_sketch(out, &out_grid);
+    EXPECT_EQ(out.width, 1920u);
+    EXPECT_EQ(out.created_timestamp, 1234567890123ull);
+    ASSERT_EQ(out.lines.size(), 5u);
+    EXPECT_FLOAT_EQ(out.lines[1].start.x, 1.0f);
+    EXPECT_FLOAT_EQ(out_grid.grid_spacing_percent, 2.5f);
+    EXPECT_FALSE(out_grid.snap_to_grid);
+    EXPECT_TRUE(out_grid.show_measurements);
+}
+
+TEST_F(BlueprintFormatTest, RejectsTruncatedAndForeignData) {
+    std::string bytes = encode_blueprint(make_sketch(10), GridConfig());
+    BlueprintView view;
+    EXPECT_FALSE(view.attach(bytes.data(), bytes.size() - 4));
+    EXPECT_FALSE(view.attach(bytes.data(), 20));
+    std::string json = "{\"lines\":[]}";
+    EXPECT_FALSE(view.attach(json.data(), json.size()));
+    EXPECT_FALSE(view.valid());
+
+    // Line count inflated past the end of the buffer
+    BlueprintHeader h;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    h.line_count = 0x7fffffffu;
+    std::memcpy(&bytes[0], &h, sizeof(h));
+    EXPECT_FALSE(view.attach(bytes.data(), bytes.size()));
+}
+
+TEST_F(BlueprintFormatTest, SketchPadSavesBinaryWithDetachedSignature) {
+    SketchPad pad(1000, 1000);
+    pad.init("pad", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.add_line(Point(10.0f, 10.0f), Point(50.0f, 40.0f));
+    pad.add_line(Point(20.0f, 70.0f), Point(90.0f, 70.0f));
+    ASSERT_TRUE(pad.save(std::string(kDir) + "/pad"));
+
+    std::string bytes = read_all(path_of("pad"));
+    EXPECT_TRUE(is_binary_blueprint(bytes.data(), bytes.size()));
+    EXPECT_FALSE(read_all(blueprint_signature_path(path_of("pad"))).empty());
+
+    SketchPad loaded;
+    ASSERT_TRUE(loaded.load(std::string(kDir) + "/pad"));
+    ASSERT_EQ(loaded.get_stroke_count(), 2);
+    const Sketch &a = pad.get_sketch(), &b = loaded.get_sketch();
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_FLOAT_EQ(a.lines[i].start.x, b.lines[i].start.x);
+        EXPECT_FLOAT_EQ(a.lines[i].end.y, b.lines[i].end.y);
+        EXPECT_EQ(a.lines[i].thickness, b.lines[i].thickness);
+    }
+    EXPECT_EQ(loaded.get_last_loaded_path(), path_of("pad"));
+}
+
+TEST_F(BlueprintFormatTest, TamperedOrUnsignedBlueprintRejected) {
+    SketchPad pad(640, 480);
+    pad.init("tamper", 640, 480);
+    pad.add_line(Point(10.0f, 10.0f), Point(20.0f, 20.0f));
+    ASSERT_TRUE(pad.save(std::string(kDir) + "/tamper"));
+
+    std::string bytes = read_all(path_of("tamper"));
+    bytes[bytes.size() - 1] ^= 0x01;
+    write_all(path_of("tamper"), bytes);
+    SketchPad loaded;
+    EXPECT_FALSE(loaded.load(std::string(kDir) + "/tamper"));
+
+    ASSERT_TRUE(pad.save(std::string(kDir) + "/tamper"));
+    std::remove(blueprint_signature_path(path_of("tamper")).c_str());
+    EXPECT_FALSE(loaded.load(std::string(kDir) + "/tamper"));
+}
+
+// Replacing a base and its .sig takes two renames; a crash between them
+// must leave a blueprint that still loads
+TEST_F(BlueprintFormatTest, InterruptedInstallKeepsAVerifiablePair) {
+    const std::string path = path_of("crash");
+    const std::string secret = "k";
+    Sketch old_sketch = make_sketch(3), new_sketch = make_sketch(5);
+    GridConfig grid;
+    std::string old_sig, new_sig;
+    ASSERT_TRUE(persist_blueprint(path, old_sketch, grid, secret, &old_sig));
+    EXPECT_EQ(read_blueprint_signatures(path), std::vector<std::string>{old_sig});
+
+    auto loads_lines = [&]() -> size_t {
+        BlueprintView view;
+        if (!view.open(path) || verified_blueprint_signature(view, path, secret).empty())
+            return 0;
+        return view.line_count();
+    };
+
+    // Failure after the .sig lists the new signature, before the rename:
+    // the old base still verifies
+    ASSERT_TRUE(stage_blueprint(path + ".new", new_sketch, grid, secret, &new_sig));
+    ASSERT_FALSE(install_blueprint(path + ".missing", path, new_sig));
+    EXPECT_EQ(read_blueprint_signatures(path), (std::vector<std::string>{new_sig, old_sig}));
+    EXPECT_EQ(loads_lines(), 3u);
+
+    // Crash after the rename, before the old signature is retired
+    ASSERT_EQ(std::rename((path + ".new").c_str(), path.c_str()), 0);
+    EXPECT_EQ(loads_lines(), 5u);
+
+    // A completed install leaves only the new signature
+    ASSERT_TRUE(persist_blueprint(path, old_sketch, grid, secret, &old_sig));
+    EXPECT_EQ(read_blueprint_signatures(path), std::vector<std::string>{old_sig});
+    EXPECT_EQ(loads_lines(), 3u);
+    BlueprintView view;
+    ASSERT_TRUE(view.open(path));
+    EXPECT_TRUE(verified_blueprint_signature(view, path, "other").empty());
+}
+
+// Older JSON saves (and server downloads) still import
+TEST_F(BlueprintFormatTest, JsonExportImports) {
+    SketchPad pad(800, 600);
+    pad.init("legacy", 800, 600);
+    pad.set_real_world_spacing(7.0f);
+    pad.add_line(Point(5.0f, 5.0f), Point(25.0f, 45.0f));
+    std::string json = pad.export_json();
+    EXPECT_NE(json.find("\"signature\""), std::string::npos);
+    write_all(path_of("legacy"), json);
+
+    SketchPad loaded;
+    ASSERT_TRUE(loaded.load(std::string(kDir) + "/legacy"));
+    EXPECT_EQ(loaded.get_stroke_count(), 1);
+    EXPECT_EQ(loaded.export_json(), json);
+
+    // Saving converts it to the binary format
+    ASSERT_TRUE(loaded.save(""));
+    std::string bytes = read_all(path_of("legacy"));
+    EXPECT_TRUE(is_binary_blueprint(bytes.data(), bytes.size()));
+}
+
+TEST_F(BlueprintFormatTest, LargeBlueprintMapsInPlace) {
+    Sketch s = make_sketch(200000);
+    std::string bytes = encode_blueprint(s, GridConfig());
+    write_all(path_of("pad"), bytes);
+
+    BlueprintView view;
+    ASSERT_TRUE(view.open(path_of("pad"))) << view.error();
+    EXPECT_EQ(view.line_count(), 200000u);
+    EXPECT_EQ(view.size(), bytes.size());
+    EXPECT_FLOAT_EQ(view.x0()[199999], static_cast<float>(199999 % 100));
+    EXPECT_EQ(view.color()[123456], 0x00FF0000u + 123456u);
+    EXPECT_TRUE(view.verify_signature(blueprint_signature(bytes.data(), bytes.size(), ""), ""));
+    EXPECT_FALSE(view.verify_signature(blueprint_signature(bytes.data(), bytes.size(), "k"), ""));
+
+    BlueprintView moved(std::move(view));
+    EXPECT_FALSE(view.valid());
+    EXPECT_TRUE(moved.valid());
+}
@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+#include "async_http_client.hpp"
+#include "blueprint_outbox.hpp"
+#include "local_http_server.hpp"
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sketch;
+using json = nlohmann::json;
+
+namespace {
+
+const char *kDir = "blueprint_outbox_test";
+
+// Records what arrived; single uploads go to /save/<name>, batches to /batch
+class UploadServer {
+public:
+    explicit UploadServer(int batch_status = 200)
+        : batch_status_(batch_status), server_([this](const test_http::Request &r) { return handle(r); }) {}
+
+    OutboxConfig config(bool batching) const {
+        OutboxConfig c;
+        c.host = "127.0.0.1";
+        c.port = server_.port();
+        c.timeout_ms = 2000;
+        c.save_path = [](const std::string &name) { return "/save/" + name; };
+        if (batching)
+            c.batch_path = "/batch";
+        c.backoff_initial_ms = 60000;
+        c.background = false;
+        return c;
+    }
+
+    void set_failing(bool failing) { failing_ = failing; }
+    void reject(const std::string &name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rejected_.push_back(name);
+    }
+    void set_delay_ms(int ms) { delay_ms_ = ms; }
+
+    // Latest "data" received per blueprint
+    std::map<std::string, json> received() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return received_;
+    }
+    int singles() const { return singles_; }
+    int batches() const { return batches_; }
+    int requests() const { return requests_; }
+
+private:
+    test_http::Reply handle(const test_http::Request &r) {
+        ++requests_;
+        if (delay_ms_)
+            std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+        if (failing_)
+            return test_http::response(503, "{\"error\":\"down\"}");
+        json body = json::parse(r.body, nullptr, false);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (r.path == "/batch") {
+            if (batch_status_ != 200)
+                return test_http::response(batch_status_, "{}");
+            ++batches_;
+            json answer = {{"rejected", rejected_}};
+            for (const auto &b : body["blueprints"]) {
+                std::string name = b["name"].get<std::string>();
+                if (std::find(rejected_.begin(), rejected_.end(), name) == rejected_.end())
+                    received_[name] = b["data"];
+            }
+            return test_http::response(200, answer.dump());
+        }
+        ++singles_;
+        received_[body["name"].get<std::string>()] = body["data"];
+        return test_http::response(200, "{}");
+    }
+
+    int batch_status_;
+    std::atomic<bool> failing_{false};
+    std::atomic<int> delay_ms_{0};
+    std::atomic<int> singles_{0};
+    std::atomic<int> batches_{0};
+    std::atomic<int> requests_{0};
+    mutable std::mutex mutex_;
+    std::vector<std::string> rejected_;
+    std::map<std::string, json> received_;
+    test_http::LocalHttpServer server_; // last: stops before the state above goes away
+};
+
+std::string export_of(int version) {
+    return json({{"version", version}, {"lines", json::array()}}).dump(2);
+}
+
+class BlueprintOutboxTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        TearDown();
+        mkdir(kDir, 0755);
+    }
+    void TearDown() override {
+        for (const char *f : {"outbox.log", "outbox.log.tmp", "legacy.pending.json"})
+            std::remove((std::string(kDir) + "/" + f).c_str());
+        rmdir(kDir);
+    }
+
+    AsyncHttpClient http{8};
+};
+
+} // namespace
+
+TEST_F(BlueprintOutboxTest, CoalescesAndSurvivesRestart) {
+    UploadServer server;
+    {
+        BlueprintOutbox outbox(http, kDir, server.config(false));
+        EXPECT_EQ(outbox.enqueue("a", export_of(1)), 1u);
+        EXPECT_EQ(outbox.enqueue("b", export_of(1)), 2u);
+        EXPECT_EQ(outbox.enqueue("a", export_of(2)), 3u);
+        EXPECT_EQ(outbox.enqueue("c", "not json"), 0u);
+        EXPECT_EQ(outbox.pending(), 2u);
+        OutboxStats stats = outbox.stats();
+        EXPECT_EQ(stats.enqueued, 3u);
+        EXPECT_EQ(stats.coalesced, 1u);
+    }
+
+    // A new run picks the queue up from the log, latest export per blueprint
+    BlueprintOutbox outbox(http, kDir, server.config(false));
+    EXPECT_EQ(outbox.pending(), 2u);
+    EXPECT_EQ(outbox.last_sequence(), 3u);
+    EXPECT_EQ(outbox.stats().compactions, 1u); // the superseded record was dropped
+    EXPECT_EQ(outbox.drain(), 2u);
+    EXPECT_EQ(outbox.pending(), 0u);
+    EXPECT_EQ(server.singles(), 2);
+    EXPECT_EQ(server.received()["a"]["version"], 2);
+    EXPECT_EQ(server.received()["b"]["version"], 1);
+
+    BlueprintOutbox after(http, kDir, server.config(false));
+    EXPECT_EQ(after.pending(), 0u);
+    EXPECT_EQ(after.last_sequence(), 3u);
+}
+
+// A crash mid-append leaves a fragment with no newline; the next run must
+// not glue its first record onto it
+TEST_F(BlueprintOutboxTest, TornTailIsCutBeforeTheNextAppend) {
+    UploadServer server;
+    {
+        BlueprintOutbox outbox(http, kDir, server.config(false));
+        outbox.enqueue("a", export_of(1));
+        outbox.enqueue("b", export_of(1));
+    }
+    {
+        std::ofstream log(std::string(kDir) + "/outbox.log", std::ios::binary | std::ios::app);
+        log << "{\"seq\":3,\"name\":\"x\",\"da";
+    }
+    {
+        BlueprintOutbox outbox(http, kDir, server.config(false));
+        EXPECT_EQ(outbox.pending(), 2u);
+        EXPECT_EQ(outbox.enqueue("c", export_of(5)), 3u);
+    }
+
+    BlueprintOutbox outbox(http, kDir, server.config(false));
+    EXPECT_EQ(outbox.pending(), 3u);
+    EXPECT_EQ(outbox.drain(), 3u);
+    EXPECT_EQ(server.received()["c"]["version"], 5);
+    EXPECT_EQ(server.received().count("x"), 0u);
+}
+
+TEST_F(BlueprintOutboxTest, FailuresBackOff) {
+    UploadServer server;
+    server.set_failing(true);
+    BlueprintOutbox outbox(http, kDir, server.config(false));
+    outbox.enqueue("a", export_of(1));
+
+    EXPECT_EQ(outbox.drain(), 0u);
+    EXPECT_EQ(server.requests(), 1);
+    EXPECT_EQ(outbox.stats().failed, 1u);
+    EXPECT_TRUE(outbox.queued("a"));
+
+    // Not due again for at least half the initial delay
+    EXPECT_EQ(outbox.drain(), 0u);
+    EXPECT_EQ(server.requests(), 1);
+
+    // A newer save replaces the payload but keeps the backoff
+    outbox.enqueue("a", export_of(2));
+    EXPECT_EQ(outbox.drain(), 0u);
+    EXPECT_EQ(server.requests(), 1);
+
+    server.set_failing(false);
+    EXPECT_EQ(outbox.drain(true), 1u);
+    EXPECT_EQ(server.received()["a"]["version"], 2);
+    EXPECT_FALSE(outbox.queued("a"));
+}
+
+TEST_F(BlueprintOutboxTest, BatchesWhenTheServerCan) {
+    UploadServer server;
+    server.reject("b");
+    OutboxConfig config = server.config(true);
+    config.max_batch = 3;
+    BlueprintOutbox outbox(http, kDir, config);
+    for (const char *name : {"a", "b", "c", "d", "e"})
+        outbox.enqueue(name, export_of(1));
+
+    EXPECT_EQ(outbox.drain(), 4u);
+    EXPECT_EQ(server.batches(), 2); // 3 + 2
+    EXPECT_EQ(server.singles(), 0);
+    EXPECT_EQ(outbox.pending(), 1u);
+    EXPECT_TRUE(outbox.queued("b"));
+    OutboxStats stats = outbox.stats();
+    EXPECT_EQ(stats.requests, 2u);
+    EXPECT_EQ(stats.batches, 2u);
+    EXPECT_EQ(stats.uploaded, 4u);
+    EXPECT_EQ(stats.failed, 1u);
+}
+
+TEST_F(BlueprintOutboxTest, FallsBackToSingleUploads) {
+    UploadServer server(404);
+    BlueprintOutbox outbox(http, kDir, server.config(true));
+    for (const char *name : {"a", "b", "c"})
+        outbox.enqueue(name, export_of(1));
+
+    EXPECT_EQ(outbox.drain(), 3u);
+    EXPECT_EQ(server.singles(), 3);
+    EXPECT_EQ(server.received().size(), 3u);
+
+    // Later passes skip the batch endpoint
+    outbox.enqueue("a", export_of(2));
+    outbox.enqueue("b", export_of(2));
+    EXPECT_EQ(outbox.drain(), 2u);
+    EXPECT_EQ(server.requests(), 1 + 3 + 2);
+}
+
+TEST_F(BlueprintOutboxTest, BoundsConcurrentUploads) {
+    UploadServer server;
+    server.set_delay_ms(30);
+    OutboxConfig config = server.config(false);
+    config.max_in_flight = 2;
+    BlueprintOutbox outbox(http, kDir, config);
+    for (int i = 0; i < 6; ++i)
+        outbox.enqueue("bp" + std::to_string(i), export_of(i));
+
+    EXPECT_EQ(outbox.drain(), 6u);
+    EXPECT_LE(http.stats().peak_in_flight, 2u);
+    EXPECT_EQ(server.singles(), 6);
+}
+
+TEST_F(BlueprintOutboxTest, ImportsLegacyPendingFiles) {
+    {
+        std::ofstream legacy(std::string(kDir) + "/legacy.pending.json");
+        legacy << json({{"name", "legacy"}, {"data", json::parse(export_of(7))}}).dump(2) << "\n";
+    }
+    UploadServer server;
+    BlueprintOutbox outbox(http, kDir, server.config(false));
+    EXPECT_TRUE(outbox.queued("legacy"));
+    EXPECT_NE(access((std::string(kDir) + "/legacy.pending.json").c_str(), F_OK), 0);
+    EXPECT_EQ(outbox.drain(), 1u);
+    EXPECT_EQ(server.received()["legacy"]["version"], 7);
+}
+
+TEST_F(BlueprintOutboxTest, BackgroundThreadRetries) {
+    UploadServer server;
+    OutboxConfig config = server.config(false);
+    config.background = true;
+    config.backoff_initial_ms = 20;
+    server.set_failing(true);
+    BlueprintOutbox outbox(http, kDir, config);
+    outbox.enqueue("a", export_of(1));
+
+    auto wait_for = [](const std::function<bool()> &done) {
+        for (int i = 0; i < 200 && !done(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return done();
+    };
+    ASSERT_TRUE(wait_for([&] { return server.requests() >= 2; }));
+    server.set_failing(false);
+    ASSERT_TRUE(wait_for([&] { return outbox.pending() == 0; }));
+    EXPECT_EQ(server.received()["a"]["version"], 1);
+}
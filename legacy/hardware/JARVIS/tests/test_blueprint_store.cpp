@@ -0,0 +1,285 @@
+#include <gtest/gtest.h>
+#include "blueprint_format.hpp"
+#include "blueprint_store.hpp"
+#include "crypto.hpp"
+#include "line_journal.hpp"
+#include "signed_json.hpp"
+#include "sketch_pad.hpp"
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sketch;
+
+namespace {
+
+const char *kDir = "blueprint_store_test";
+const std::string kSecret = "store-secret";
+
+std::string path_of(const std::string &name) {
+    return std::string(kDir) + "/" + name + ".jarvis";
+}
+
+std::string read_all(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+void write_all(const std::string &path, const std::string &data) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << data;
+}
+
+bool exists(const std::string &path) {
+    struct stat st = {};
+    return stat(path.c_str(), &st) == 0;
+}
+
+Sketch make_sketch(const std::string &name, size_t lines, float offset) {
+    Sketch s;
+    s.name = name;
+    for (size_t i = 0; i < lines; ++i) {
+        Line l;
+        l.start = Point(offset + static_cast<float>(i), 10.0f);
+        l.end = Point(offset, 20.0f + static_cast<float>(i));
+        l.color = 0x00123456u;
+        l.thickness = 2;
+        s.lines.push_back(l);
+    }
+    return s;
+}
+
+// Saved blueprint plus `journaled` lines appended through its journal
+void make_blueprint(const std::string &name, size_t lines, size_t journaled = 0,
+                    const std::string &secret = kSecret) {
+    std::string sig;
+    ASSERT_TRUE(persist_blueprint(path_of(name), make_sketch(name, lines, 5.0f), GridConfig(), secret, &sig));
+    if (journaled == 0)
+        return;
+    LineJournal journal;
+    ASSERT_TRUE(journal.open(path_of(name) + ".journal", sig, secret, nullptr));
+    Sketch extra = make_sketch(name, journaled, 70.0f);
+    for (const auto &l : extra.lines)
+        journal.append_line(l);
+    ASSERT_TRUE(journal.sync());
+}
+
+class BlueprintStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override { mkdir(kDir, 0755); }
+    void TearDown() override {
+        if (DIR *d = opendir(kDir)) {
+            while (struct dirent *ent = readdir(d)) {
+                if (ent->d_name[0] != '.')
+                    std::remove((std::string(kDir) + "/" + ent->d_name).c_str());
+            }
+            closedir(d);
+        }
+        rmdir(kDir);
+    }
+
+    StoreOptions options(size_t threads = 4) {
+        StoreOptions o;
+        o.dir = kDir;
+        o.secret = kSecret;
+        o.threads = threads;
+        return o;
+    }
+};
+
+} // namespace
+
+TEST_F(BlueprintStoreTest, IndexRoundTripAndLookup) {
+    BlueprintIndex index;
+    for (const char *name : {"kitchen", "bath", "kitchen-v2", "attic"}) {
+        BlueprintIndexEntry e;
+        e.name = name;
+        e.line_count = static_cast<uint32_t>(std::strlen(name));
+        e.max_x = 42.5f;
+        e.hash[0] = static_cast<uint8_t>(name[0]);
+        e.mtime_ns = 1700000000123456789LL;
+        e.flags = kIndexVerified;
+        index.put(e);
+    }
+    BlueprintIndexEntry replaced;
+    replaced.name = "bath";
+    replaced.line_count = 99;
+    index.put(replaced);
+    ASSERT_EQ(index.size(), 4u);
+
+    const std::string path = std::string(kDir) + "/" + kBlueprintIndexFile;
+    ASSERT_TRUE(index.save(path));
+    BlueprintIndex loaded;
+    ASSERT_TRUE(loaded.load(path));
+    ASSERT_EQ(loaded.size(), 4u);
+    EXPECT_EQ(loaded.entries().front().name, "attic");
+    const BlueprintIndexEntry *k = loaded.find("kitchen");
+    ASSERT_NE(k, nullptr);
+    EXPECT_EQ(k->line_count, 7u);
+    EXPECT_FLOAT_EQ(k->max_x, 42.5f);
+    EXPECT_EQ(k->hash[0], 'k');
+    EXPECT_EQ(k->mtime_ns, 1700000000123456789LL);
+    EXPECT_EQ(loaded.find("bath")->line_count, 99u);
+    EXPECT_EQ(loaded.find("kitch"), nullptr);
+    auto prefixed = loaded.with_prefix("kitchen");
+    ASSERT_EQ(prefixed.size(), 2u);
+    EXPECT_EQ(prefixed[1]->name, "kitchen-v2");
+
+    // A truncated index is rejected rather than half-read
+    std::string bytes = read_all(path);
+    write_all(path, bytes.substr(0, bytes.size() - 3));
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_TRUE(loaded.empty());
+}
+
+TEST_F(BlueprintStoreTest, VerifyAndIndexInParallel) {
+    for (int i = 0; i < 40; ++i)
+        make_blueprint("bp" + std::to_string(i), 3 + i, i % 4 == 0 ? 2 : 0);
+    // Legacy JSON blueprint and a tampered one
+    write_all(path_of("legacy"), export_json_blueprint(make_sketch("legacy", 4, 1.0f), GridConfig(), kSecret));
+    make_blueprint("tampered", 5);
+    std::string bytes = read_all(path_of("tampered"));
+    bytes[bytes.size() - 1] ^= 0x01;
+    write_all(path_of("tampered"), bytes);
+    write_all(std::string(kDir) + "/notes.txt", "not a blueprint");
+
+    StoreReport report = run_store_pass(options());
+    ASSERT_EQ(report.files.size(), 42u);
+    EXPECT_EQ(report.ok, 41u);
+    EXPECT_EQ(report.failed, 1u);
+    EXPECT_EQ(report.compacted, 0u);
+    EXPECT_TRUE(report.index_written);
+    for (const auto &r : report.files) {
+        if (r.name == "tampered")
+            EXPECT_EQ(r.status, StoreStatus::BAD_SIGNATURE);
+        else
+            EXPECT_EQ(r.status, StoreStatus::OK) << r.name << ": " << r.error;
+    }
+
+    BlueprintIndex index;
+    ASSERT_TRUE(index.load(std::string(kDir) + "/" + kBlueprintIndexFile));
+    EXPECT_EQ(index.size(), 41u);
+    EXPECT_EQ(index.find("tampered"), nullptr);
+
+    // Journal lines are counted and widen the bounds
+    const BlueprintIndexEntry *journaled = index.find("bp8");
+    ASSERT_NE(journaled, nullptr);
+    EXPECT_EQ(journaled->line_count, 13u);
+    EXPECT_FLOAT_EQ(journaled->min_x, 5.0f);
+    EXPECT_FLOAT_EQ(journaled->max_x, 71.0f);
+    EXPECT_GT(journaled->journal_size, 0u);
+    const BlueprintIndexEntry *plain = index.find("bp9");
+    ASSERT_NE(plain, nullptr);
+    EXPECT_EQ(plain->line_count, 12u);
+    EXPECT_FLOAT_EQ(plain->max_y, 31.0f);
+    EXPECT_TRUE(plain->flags & kIndexVerified);
+    unsigned char hash[32];
+    std::string base = read_all(path_of("bp9"));
+    crypto::sha256(base.data(), base.size(), hash);
+    EXPECT_EQ(std::memcmp(hash, plain->hash, 32), 0);
+
+    const BlueprintIndexEntry *legacy = index.find("legacy");
+    ASSERT_NE(legacy, nullptr);
+    EXPECT_TRUE(legacy->flags & kIndexJson);
+    EXPECT_EQ(legacy->line_count, 4u);
+}
+
+TEST_F(BlueprintStoreTest, ResignFoldsJournalsAndSkipsBadFiles) {
+    for (int i = 0; i < 12; ++i)
+        make_blueprint("bp" + std::to_string(i), 4, i % 3 == 0 ? 3 : 0);
+    write_all(path_of("legacy"), export_json_blueprint(make_sketch("legacy", 2, 1.0f), GridConfig(), kSecret));
+    make_blueprint("foreign", 2, 0, "other-secret");
+    const std::string foreign = read_all(path_of("foreign") + ".sig");
+
+    StoreOptions o = options();
+    o.resign = true;
+    o.new_secret = "rotated-secret";
+    StoreReport report = run_store_pass(o);
+    EXPECT_EQ(report.ok, 13u);
+    EXPECT_EQ(report.resigned, 13u);
+    EXPECT_EQ(report.compacted, 4u); // the journaled ones
+    EXPECT_EQ(report.failed, 1u);
+    // Not verifiable with the old key: left alone
+    EXPECT_EQ(read_all(path_of("foreign") + ".sig"), foreign);
+
+    for (int i = 0; i < 12; ++i) {
+        const std::string path = path_of("bp" + std::to_string(i));
+        BlueprintView view;
+        ASSERT_TRUE(view.open(path));
+        EXPECT_TRUE(view.verify_signature(read_blueprint_signature(path), "rotated-secret")) << path;
+        EXPECT_EQ(view.line_count(), i % 3 == 0 ? 7u : 4u);
+        EXPECT_FALSE(exists(path + ".journal"));
+    }
+    // JSON is rewritten in the binary format under the new key
+    BlueprintView legacy;
+    ASSERT_TRUE(legacy.open(path_of("legacy")));
+    EXPECT_TRUE(legacy.verify_signature(read_blueprint_signature(path_of("legacy")), "rotated-secret"));
+
+    // Everything verifies with the new key afterwards
+    StoreOptions check = options(1);
+    check.secret = "rotated-secret";
+    StoreReport after = run_store_pass(check);
+    EXPECT_EQ(after.ok, 13u);
+    EXPECT_EQ(after.failed, 1u);
+}
+
+TEST_F(BlueprintStoreTest, RefreshRereadsOnlyChangedFiles) {
+    for (int i = 0; i < 5; ++i)
+        make_blueprint("bp" + std::to_string(i), 2);
+    ASSERT_TRUE(run_store_pass(options()).index_written);
+
+    BlueprintIndex index;
+    ASSERT_TRUE(index.load(std::string(kDir) + "/" + kBlueprintIndexFile));
+    EXPECT_EQ(index.refresh(kDir, kSecret), 0u);
+
+    // Changed, added, removed and journaled
+    make_blueprint("bp1", 9);
+    make_blueprint("new", 1);
+    std::remove(path_of("bp2").c_str());
+    std::remove((path_of("bp2") + ".sig").c_str());
+    std::string sig = read_blueprint_signature(path_of("bp3"));
+    {
+        LineJournal journal;
+        ASSERT_TRUE(journal.open(path_of("bp3") + ".journal", sig, kSecret, nullptr));
+        journal.append_clear();
+        ASSERT_TRUE(journal.sync());
+    }
+
+    EXPECT_EQ(index.refresh(kDir, kSecret), 4u);
+    EXPECT_EQ(index.size(), 5u);
+    EXPECT_EQ(index.find("bp1")->line_count, 9u);
+    EXPECT_EQ(index.find("new")->line_count, 1u);
+    EXPECT_EQ(index.find("bp2"), nullptr);
+    EXPECT_EQ(index.find("bp3")->line_count, 0u);
+    EXPECT_EQ(index.refresh(kDir, kSecret), 0u);
+}
+
+// Changed files are indexed across the pool; the result matches a serial pass
+TEST_F(BlueprintStoreTest, RefreshIndexesChangedFilesInParallel) {
+    for (int i = 0; i < 12; ++i)
+        make_blueprint("bp" + std::to_string(i), 1 + i, i % 3 == 0 ? 2 : 0);
+    make_blueprint("foreign", 3, 0, "other-secret");
+
+    BlueprintIndex pooled;
+    EXPECT_EQ(pooled.refresh(kDir, kSecret, 4), 13u);
+    BlueprintIndex serial;
+    EXPECT_EQ(serial.refresh(kDir, kSecret, 1), 13u);
+
+    ASSERT_EQ(pooled.size(), serial.size());
+    for (size_t i = 0; i < pooled.size(); ++i) {
+        const BlueprintIndexEntry &a = pooled.entries()[i];
+        const BlueprintIndexEntry &b = serial.entries()[i];
+        EXPECT_EQ(a.name, b.name);
+        EXPECT_EQ(a.line_count, b.line_count);
+        EXPECT_EQ(a.flags, b.flags);
+        EXPECT_EQ(std::memcmp(a.hash, b.hash, sizeof(a.hash)), 0);
+    }
+    EXPECT_EQ(pooled.find("bp3")->line_count, 6u); // 4 + 2 journaled
+    EXPECT_TRUE(pooled.find("bp3")->flags & kIndexVerified);
+    EXPECT_FALSE(pooled.find("foreign")->flags & kIndexVerified);
+    EXPECT_EQ(pooled.refresh(kDir, kSecret, 4), 0u);
+}
@@ -0,0 +1,348 @@
+#include <gtest/gtest.h>
+#include "async_http_client.hpp"
+#include "blueprint_sync.hpp"
+#include "persist_worker.hpp"
+#include "sync_stand_in_server.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sketch;
+using test_http::SyncStandInServer;
+
+namespace {
+
+const char *kDir = "blueprint_sync_test";
+
+std::string state_of(const std::string &name) { return std::string(kDir) + "/" + name + ".sync"; }
+
+class BlueprintSyncTest : public ::testing::Test {
+protected:
+    void SetUp() override { mkdir(kDir, 0755); }
+    void TearDown() override {
+        for (const char *n : {"a", "b", "restart", "worker"})
+            std::remove(state_of(n).c_str());
+        for (const char *f : {"worker.jarvis", "worker.jarvis.sig", "worker.jarvis.journal"})
+            std::remove((std::string(kDir) + "/" + f).c_str());
+        rmdir(kDir);
+    }
+
+    AsyncHttpClient http;
+};
+
+void init_pad(SketchPad &pad, const std::string &name) {
+    pad.init(name, 1000, 1000);
+    pad.set_grid_enabled(false);
+}
+
+void draw(SketchPad &pad, int first, int count) {
+    for (int i = first; i < first + count; ++i)
+        pad.add_line(Point(1.0f + (i % 90), 2.0f + (i / 90)), Point(5.0f + (i % 90), 40.0f + (i / 90) * 0.5f));
+}
+
+std::multiset<std::string> contents(const SketchPad &pad) {
+    std::multiset<std::string> out;
+    for (const Line &l : pad.get_sketch().lines)
+        out.insert(line_id(l));
+    return out;
+}
+
+} // namespace
+
+TEST(LineIdTest, ContentAddressed) {
+    Line a;
+    a.start = Point(10.0f, 20.0f);
+    a.end = Point(30.0f, 40.0f);
+    a.timestamp = 1;
+    Line b = a;
+    b.timestamp = 99; // not part of the content
+    EXPECT_EQ(line_id(a), line_id(b));
+    EXPECT_EQ(16u, line_id(a).size());
+    EXPECT_NE(line_id(a), line_id(a, 1)); // second identical line
+    b.color = 0x00FF0000;
+    EXPECT_NE(line_id(a), line_id(b));
+
+    Line z = a;
+    z.start.x = -0.0f;
+    Line p = a;
+    p.start.x = 0.0f;
+    EXPECT_EQ(line_id(z), line_id(p));
+}
+
+TEST(LineDeltaTest, EncodeDecodeRoundTrip) {
+    LineDelta d;
+    d.base = 7;
+    d.clear = true;
+    d.device = "dev";
+    d.version_vector["dev"] = 3;
+    d.removed = {"aaaa", "bbbb"};
+    Line l;
+    l.start = Point(1.25f, 2.5f);
+    l.end = Point(99.0f, 0.1f);
+    l.color = 0x00ABCDEF;
+    l.thickness = 6;
+    d.added.emplace_back(line_id(l), l);
+    d.grid_changed = true;
+    d.grid.grid_spacing_percent = 2.5f;
+    d.grid.snap_to_grid = false;
+
+    LineDelta back;
+    ASSERT_TRUE(decode_line_delta(encode_line_delta(d), back));
+    EXPECT_EQ(7u, back.base);
+    EXPECT_TRUE(back.clear);
+    EXPECT_EQ("dev", back.device);
+    EXPECT_EQ(3u, back.version_vector["dev"]);
+    EXPECT_EQ(d.removed, back.removed);
+    ASSERT_EQ(1u, back.added.size());
+    // Floats survive the text form bit for bit, so ids can be recomputed
+    EXPECT_EQ(line_id(l), line_id(back.added[0].second));
+    EXPECT_EQ(6, back.added[0].second.thickness);
+    EXPECT_TRUE(back.grid_changed);
+    EXPECT_FLOAT_EQ(2.5f, back.grid.grid_spacing_percent);
+    EXPECT_FALSE(back.grid.snap_to_grid);
+
+    EXPECT_FALSE(decode_line_delta("not json", back));
+    EXPECT_FALSE(decode_line_delta("{\"version\":1,\"add\":[[1,2]]}", back));
+    // A whole blueprint (what the load endpoint serves) is not a delta
+    EXPECT_FALSE(decode_line_delta("{\"name\":\"x\",\"lines\":[]}", back));
+
+    std::string packed, unpacked;
+    if (!deflate_body(encode_line_delta(d), packed))
+        GTEST_SKIP() << "built without zlib";
+    ASSERT_TRUE(inflate_body(packed, unpacked));
+    EXPECT_EQ(encode_line_delta(d), unpacked);
+    EXPECT_FALSE(inflate_body(packed.substr(0, packed.size() / 2), unpacked));
+}
+
+// After the first upload only the new lines are hashed and sent
+TEST_F(BlueprintSyncTest, TrafficScalesWithTheEdit) {
+    SyncStandInServer server;
+    SketchPad pad;
+    init_pad(pad, "a");
+    draw(pad, 0, 300);
+    BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("a"));
+
+    ASSERT_EQ(SyncResult::SYNCED, sync.sync(pad));
+    EXPECT_EQ(300u, server.line_count());
+    EXPECT_EQ(1u, server.version());
+    size_t first_push = server.last_push_bytes();
+
+    draw(pad, 300, 2);
+    ASSERT_EQ(SyncResult::SYNCED, sync.sync(pad));
+    EXPECT_EQ(302u, server.line_count());
+    SyncStats stats = sync.stats();
+    EXPECT_EQ(302u, stats.lines_hashed);
+    EXPECT_EQ(302u, stats.lines_sent);
+    EXPECT_LT(server.last_push_bytes() * 5, first_push);
+    EXPECT_LT(server.last_pull_bytes(), 200u);
+
+    // Nothing new anywhere: one small pull, no push
+    int pushes = server.pushes();
+    EXPECT_EQ(SyncResult::UP_TO_DATE, sync.sync(pad));
+    EXPECT_EQ(pushes, server.pushes());
+    EXPECT_EQ(1u, sync.version_vector().size());
+    EXPECT_EQ(2u, sync.version_vector()["dev-a"]);
+}
+
+TEST_F(BlueprintSyncTest, LargePushesAreDeflated) {
+    std::string probe;
+    if (!deflate_body("x", probe))
+        GTEST_SKIP() << "built without zlib";
+    SyncStandInServer server;
+    SketchPad pad;
+    init_pad(pad, "a");
+    draw(pad, 0, 500);
+    BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("a"));
+    ASSERT_EQ(SyncResult::SYNCED, sync.sync(pad));
+    EXPECT_TRUE(server.last_push_deflated());
+    EXPECT_LT(sync.stats().bytes_sent, 500u * 60);
+
+    // A pull of everything comes back deflated too
+    SketchPad other;
+    init_pad(other, "b");
+    BlueprintSync second(http, "dev-b", server.endpoint(), state_of("b"));
+    ASSERT_EQ(SyncResult::SYNCED, second.sync(other));
+    EXPECT_EQ(500, other.get_stroke_count());
+    EXPECT_LT(server.last_pull_bytes(), 500u * 60);
+}
+
+// Two devices editing the same blueprint end up with the union
+TEST_F(BlueprintSyncTest, TwoDevicesConverge) {
+    SyncStandInServer server;
+    SketchPad a, b;
+    init_pad(a, "a");
+    init_pad(b, "b");
+    BlueprintSync sync_a(http, "dev-a", server.endpoint(), state_of("a"));
+    BlueprintSync sync_b(http, "dev-b", server.endpoint(), state_of("b"));
+
+    draw(a, 0, 10);
+    ASSERT_EQ(SyncResult::SYNCED, sync_a.sync(a));
+    draw(b, 100, 3);
+    ASSERT_EQ(SyncResult::SYNCED, sync_b.sync(b));
+    EXPECT_EQ(13, b.get_stroke_count());
+    EXPECT_EQ(10u, sync_b.stats().lines_received);
+
+    draw(a, 200, 1);
+    ASSERT_EQ(SyncResult::SYNCED, sync_a.sync(a));
+    ASSERT_EQ(SyncResult::SYNCED, sync_b.sync(b));
+    EXPECT_EQ(14u, server.line_count());
+    EXPECT_EQ(contents(a), contents(b));
+    // a only received b's three lines, not the whole blueprint
+    EXPECT_EQ(3u, sync_a.stats().lines_received);
+
+    auto vv = server.version_vector();
+    EXPECT_EQ(2u, vv["dev-a"]);
+    EXPECT_EQ(1u, vv["dev-b"]);
+    EXPECT_EQ(vv, sync_b.version_vector());
+}
+
+TEST_F(BlueprintSyncTest, ClearAndGridChangesPropagate) {
+    SyncStandInServer server;
+    SketchPad a, b;
+    init_pad(a, "a");
+    init_pad(b, "b");
+    BlueprintSync sync_a(http, "dev-a", server.endpoint(), state_of("a"));
+    BlueprintSync sync_b(http, "dev-b", server.endpoint(), state_of("b"));
+    draw(a, 0, 20);
+    ASSERT_EQ(SyncResult::SYNCED, sync_a.sync(a));
+    ASSERT_EQ(SyncResult::SYNCED, sync_b.sync(b));
+    ASSERT_EQ(20, b.get_stroke_count());
+
+    a.clear();
+    draw(a, 500, 2);
+    a.set_grid_spacing(2.0f);
+    ASSERT_EQ(SyncResult::SYNCED, sync_a.sync(a));
+    EXPECT_EQ(2u, server.line_count());
+    EXPECT_FLOAT_EQ(2.0f, server.grid().grid_spacing_percent);
+    // The clear went out as one flag, not twenty ids
+    EXPECT_LT(server.last_push_bytes(), 400u);
+
+    ASSERT_EQ(SyncResult::SYNCED, sync_b.sync(b));
+    EXPECT_EQ(contents(a), contents(b));
+    EXPECT_FLOAT_EQ(2.0f, b.get_grid_config().grid_spacing_percent);
+}
+
+// A push racing another device's push is refused; the next sync merges
+TEST_F(BlueprintSyncTest, ConflictingPushIsMergedOnNextSync) {
+    SyncStandInServer server;
+    SketchPad a, b;
+    init_pad(a, "a");
+    init_pad(b, "b");
+    BlueprintSync sync_a(http, "dev-a", server.endpoint(), state_of("a"));
+    BlueprintSync sync_b(http, "dev-b", server.endpoint(), state_of("b"));
+    ASSERT_EQ(SyncResult::UP_TO_DATE, sync_a.sync(a));
+    ASSERT_EQ(SyncResult::UP_TO_DATE, sync_b.sync(b));
+
+    draw(b, 0, 4);
+    ASSERT_EQ(SyncResult::SYNCED, sync_b.push(b.snapshot_content()));
+    draw(a, 50, 2);
+    EXPECT_EQ(SyncResult::CONFLICT, sync_a.push(a.snapshot_content()));
+    EXPECT_EQ(2, a.get_stroke_count()); // push() never touches the pad
+
+    ASSERT_EQ(SyncResult::SYNCED, sync_a.sync(a));
+    EXPECT_EQ(6, a.get_stroke_count());
+    EXPECT_EQ(6u, server.line_count());
+    EXPECT_EQ(1u, sync_a.stats().conflicts);
+}
+
+// The sidecar lets a new process skip the full exchange when nothing
+// changed offline, and fall back to a union merge when something did
+TEST_F(BlueprintSyncTest, StateSurvivesRestart) {
+    SyncStandInServer server;
+    SketchPad pad;
+    init_pad(pad, "restart");
+    draw(pad, 0, 50);
+    {
+        BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("restart"));
+        ASSERT_EQ(SyncResult::SYNCED, sync.sync(pad));
+    }
+    {
+        BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("restart"));
+        EXPECT_EQ(SyncResult::UP_TO_DATE, sync.sync(pad));
+        EXPECT_EQ(1u, sync.server_version());
+        EXPECT_EQ(0u, sync.stats().pushes);
+        EXPECT_EQ(1u, sync.version_vector()["dev-a"]);
+    }
+
+    draw(pad, 50, 1); // drawn while "offline"
+    {
+        BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("restart"));
+        ASSERT_EQ(SyncResult::SYNCED, sync.sync(pad));
+        EXPECT_EQ(51u, server.line_count());
+        EXPECT_EQ(51, pad.get_stroke_count());
+    }
+
+    // Server history gone: the next pull is a full snapshot, merged as-is
+    server.drop_history();
+    draw(pad, 60, 1);
+    BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("restart"));
+    ASSERT_EQ(SyncResult::SYNCED, sync.sync(pad));
+    EXPECT_EQ(52u, server.line_count());
+    EXPECT_EQ(52, pad.get_stroke_count());
+}
+
+TEST_F(BlueprintSyncTest, ServerWithoutDeltasIsReported) {
+    SyncStandInServer server(false);
+    SketchPad pad;
+    init_pad(pad, "a");
+    draw(pad, 0, 3);
+    BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("a"));
+    EXPECT_EQ(SyncResult::UNSUPPORTED, sync.sync(pad));
+    EXPECT_EQ(SyncResult::UNSUPPORTED, sync.push(pad.snapshot_content()));
+    EXPECT_EQ(3, pad.get_stroke_count());
+}
+
+// Saves through the persist worker upload deltas from the save snapshot
+TEST_F(BlueprintSyncTest, PersistWorkerSyncsSnapshots) {
+    SyncStandInServer server;
+    BlueprintSync sync(http, "dev-a", server.endpoint(), state_of("worker"));
+    PersistWorker worker([&sync](SketchPad &pad, const SaveSnapshot &snapshot) {
+        SyncResult r = sync.sync(pad, snapshot);
+        return r == SyncResult::SYNCED || r == SyncResult::UP_TO_DATE;
+    });
+    SketchPad pad;
+    init_pad(pad, "worker");
+    pad.set_persist_worker(&worker);
+    std::string base = std::string(kDir) + "/worker";
+
+    draw(pad, 0, 5);
+    ASSERT_TRUE(pad.save(base));
+    draw(pad, 5, 1);
+    ASSERT_TRUE(pad.save(base));
+    worker.flush();
+
+    auto results = worker.take_results();
+    ASSERT_FALSE(results.empty());
+    EXPECT_TRUE(results.back().uploaded);
+    EXPECT_EQ(6u, server.line_count());
+    EXPECT_EQ(6u, sync.stats().lines_sent);
+}
+
+// Merges land after the lines the caller saw and are refused after a clear
+TEST(SketchPadRemoteChangesTest, InsertsAfterSeenLines) {
+    SketchPad pad;
+    init_pad(pad, "merge");
+    draw(pad, 0, 3);
+    SaveSnapshot seen = pad.snapshot_content();
+    draw(pad, 10, 1); // drawn while the pull was in flight
+
+    Line remote;
+    remote.start = Point(50.0f, 50.0f);
+    remote.end = Point(60.0f, 60.0f);
+    uint64_t generation = 0;
+    ASSERT_TRUE(pad.apply_remote_changes(seen, {1}, {remote}, nullptr, &generation));
+    const auto &lines = pad.get_sketch().lines;
+    ASSERT_EQ(4u, lines.size());
+    EXPECT_EQ(seen.sketch.lines[0].start.x, lines[0].start.x);
+    EXPECT_EQ(seen.sketch.lines[2].start.x, lines[1].start.x);
+    EXPECT_EQ(50.0f, lines[2].start.x);
+    // Not a plain append, so the next save rewrites the base
+    EXPECT_NE(seen.content_generation, generation);
+
+    SaveSnapshot before_clear = pad.snapshot_content();
+    pad.clear();
+    EXPECT_FALSE(pad.apply_remote_changes(before_clear, {}, {remote}, nullptr, &generation));
+    EXPECT_EQ(0, pad.get_stroke_count());
+}
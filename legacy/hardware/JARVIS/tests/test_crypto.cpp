@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "crypto.hpp"
+#include <openssl/evp.h>
 #include <string>
+#include <vector>
 
 // Test basic encryption produces non-empty output
 TEST(CryptoTest, EncryptProducesOutput) {
@@ -76,3 +78,99 @@ TEST(CryptoTest, LongInput) {
     EXPECT_FALSE(encrypted.empty());
     EXPECT_GT(encrypted.length(), plaintext.length() / 2); // Should be substantial
 }
+
+namespace {
+
+std::string hex_of(const std::string& bytes) {
+    return crypto::to_hex(bytes.data(), bytes.size());
+}
+
+// Decrypt aes256_encrypt output with a key derived the documented way
+std::string decrypt(const std::string& hex, const std::string& secret) {
+    std::string raw;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+        raw.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    if (raw.size() < 32) return {};
+    unsigned char key[32];
+    crypto::sha256(secret.data(), secret.size(), key);
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    std::vector<unsigned char> out(raw.size());
+    int len = 0, total = 0;
+    bool ok = EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key,
+                                 reinterpret_cast<const unsigned char*>(raw.data())) == 1 &&
+              EVP_DecryptUpdate(ctx, out.data(), &len,
+                                reinterpret_cast<const unsigned char*>(raw.data()) + 16,
+                                static_cast<int>(raw.size() - 16)) == 1;
+    total = len;
+    ok = ok && EVP_DecryptFinal_ex(ctx, out.data() + total, &len) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    return ok ? std::string(reinterpret_cast<char*>(out.data()), total + len) : std::string();
+}
+
+} // namespace
+
+TEST(CryptoTest, HexEncoding) {
+    std::string all;
+    for (int i = 0; i < 256; ++i) all.push_back(static_cast<char>(i));
+    std::string hex = hex_of(all);
+    ASSERT_EQ(hex.size(), 512u);
+    EXPECT_EQ(hex.substr(0, 8), "00010203");
+    EXPECT_EQ(hex.substr(2 * 0x9e, 4), "9e9f");
+    EXPECT_EQ(hex.substr(508), "feff");
+    EXPECT_EQ(hex_of(""), "");
+}
+
+TEST(CryptoTest, HasherIsReusable) {
+    crypto::Hasher hasher;
+    EXPECT_EQ(hasher.final_hex(), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    for (int round = 0; round < 3; ++round) {
+        hasher.update("a", 1);
+        hasher.update("bc", 2);
+        EXPECT_EQ(hasher.final_hex(), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    }
+    // init() drops anything fed so far
+    hasher.update("junk", 4);
+    ASSERT_TRUE(hasher.init());
+    hasher.update("abc", 3);
+    EXPECT_EQ(hasher.final_hex(), crypto::sha256_hex("abc"));
+}
+
+TEST(CryptoTest, HmacMatchesRfc4231) {
+    crypto::Hmac jefe("Jefe");
+    ASSERT_TRUE(jefe.ok());
+    for (int round = 0; round < 3; ++round) {
+        jefe.update("what do ya want ", 16);
+        jefe.update("for nothing?", 12);
+        EXPECT_EQ(jefe.final_hex(), "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    }
+
+    // Keys longer than a block are hashed first
+    const std::string long_key(131, '\xaa');
+    const std::string data = "Test Using Larger Than Block-Size Key - Hash Key First";
+    const std::string expected = "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54";
+    crypto::Hmac hmac(long_key);
+    hmac.update(data.data(), data.size());
+    EXPECT_EQ(hmac.final_hex(), expected);
+    EXPECT_EQ(crypto::hmac_sha256_hex(data, long_key), expected);
+    // The one-shot helper switches keys correctly
+    EXPECT_EQ(crypto::hmac_sha256_hex("what do ya want for nothing?", "Jefe"),
+              "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    EXPECT_EQ(crypto::hmac_sha256_hex(data, long_key), expected);
+    EXPECT_EQ(crypto::hmac_sha256_hex("", ""), "b613679a0814d9ec772f95d778c35fc5ff1697c493715653c6c712144292c5ad");
+}
+
+TEST(CryptoTest, CachedEncryptorDecrypts) {
+    crypto::AesEncryptor encryptor("my-secret-key");
+    ASSERT_TRUE(encryptor.ok());
+    std::string a = encryptor.encrypt("TestDevice123");
+    std::string b = encryptor.encrypt("TestDevice123");
+    EXPECT_NE(a, b); // fresh IV each time
+    EXPECT_EQ(decrypt(a, "my-secret-key"), "TestDevice123");
+    EXPECT_EQ(decrypt(b, "my-secret-key"), "TestDevice123");
+    EXPECT_EQ(decrypt(encryptor.encrypt(std::string(1000, 'A')), "my-secret-key"), std::string(1000, 'A'));
+    EXPECT_EQ(encryptor.encrypt(""), "");
+
+    // The one-shot form follows the secret it is given
+    for (const char* secret : {"one", "two", "one"})
+        EXPECT_EQ(decrypt(crypto::aes256_encrypt("blueprint-7", secret), secret), "blueprint-7");
+}
@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include "detection_bus.hpp"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace hand_detector;
+
+namespace {
+
+HandDetection make_hand(int i) {
+    HandDetection d;
+    d.bbox.x = 10 * i;
+    d.bbox.y = 20 * i;
+    d.bbox.width = 30 + i;
+    d.bbox.height = 40 + i;
+    d.bbox.confidence = 0.5f + 0.01f * i;
+    d.center = Point(15 * i, 25 * i);
+    d.gesture = static_cast<Gesture>(i % 8);
+    d.gesture_confidence = 0.25f * (i % 4);
+    d.num_fingers = i % 6;
+    d.contour_area = 1000u + static_cast<uint32_t>(i);
+    d.contour = {Point(1, 2), Point(3, 4)};
+    for (int f = 0; f < (i % 7); ++f)
+        d.fingertips.emplace_back(i + f, i - f);
+    return d;
+}
+
+class DetectionBusTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        name_ = "/jarvis_bus_test_" + std::to_string(getpid()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        DetectionPublisher::unlink(name_);
+    }
+    void TearDown() override { DetectionPublisher::unlink(name_); }
+
+    DetectionBusConfig config(uint32_t slots = 8, uint32_t max_hands = 4) {
+        DetectionBusConfig c;
+        c.name = name_;
+        c.slots = slots;
+        c.max_hands = max_hands;
+        return c;
+    }
+
+    std::string name_;
+};
+
+} // namespace
+
+TEST_F(DetectionBusTest, RoundTripsRecords) {
+    DetectionPublisher pub;
+    ASSERT_TRUE(pub.open(config())) << pub.error();
+    DetectionSubscriber sub;
+    ASSERT_TRUE(sub.open(name_)) << sub.error();
+
+    BusEvent ev;
+    EXPECT_FALSE(sub.next(ev));
+
+    std::vector<HandDetection> hands = {make_hand(1), make_hand(6)};
+    EXPECT_EQ(pub.publish(7, 123456789, 640, 480, hands), 0u);
+    EXPECT_EQ(pub.publish(8, 123456999, 640, 480, {}), 1u);
+
+    ASSERT_TRUE(sub.next(ev));
+    EXPECT_EQ(ev.seq, 0u);
+    EXPECT_EQ(ev.frame_id, 7u);
+    EXPECT_EQ(ev.capture_ns, 123456789u);
+    EXPECT_GT(ev.publish_ns, 0u);
+    EXPECT_EQ(ev.frame_width, 640u);
+    EXPECT_EQ(ev.frame_height, 480u);
+    ASSERT_EQ(ev.hands.size(), 2u);
+    const HandDetection &h = ev.hands[1];
+    EXPECT_EQ(h.bbox.x, 60);
+    EXPECT_EQ(h.bbox.height, 46);
+    EXPECT_FLOAT_EQ(h.bbox.confidence, 0.56f);
+    EXPECT_EQ(h.center.y, 150);
+    EXPECT_EQ(h.gesture, Gesture::OK_SIGN);
+    EXPECT_FLOAT_EQ(h.gesture_confidence, 0.5f);
+    EXPECT_EQ(h.num_fingers, 0);
+    EXPECT_EQ(h.contour_area, 1006u);
+    EXPECT_TRUE(h.contour.empty());
+    // Six fingertips in, five carried
+    ASSERT_EQ(h.fingertips.size(), 5u);
+    EXPECT_EQ(h.fingertips[4].x, 10);
+    EXPECT_EQ(h.fingertips[4].y, 2);
+
+    ASSERT_TRUE(sub.next(ev));
+    EXPECT_EQ(ev.frame_id, 8u);
+    EXPECT_TRUE(ev.hands.empty());
+    EXPECT_FALSE(sub.next(ev));
+    EXPECT_EQ(sub.missed(), 0u);
+
+    // Hands past max_hands are dropped
+    std::vector<HandDetection> many;
+    for (int i = 0; i < 6; ++i)
+        many.push_back(make_hand(i));
+    pub.publish(9, 0, 320, 240, many);
+    ASSERT_TRUE(sub.next(ev));
+    EXPECT_EQ(ev.hands.size(), 4u);
+}
+
+TEST_F(DetectionBusTest, SlowReaderSkipsOverwrittenRecords) {
+    DetectionPublisher pub;
+    ASSERT_TRUE(pub.open(config(5))); // rounded up to 8 slots
+    DetectionSubscriber sub;
+    ASSERT_TRUE(sub.open(name_));
+
+    for (uint64_t i = 0; i < 20; ++i)
+        pub.publish(100 + i, i, 1, 1, {make_hand(1)});
+
+    BusEvent ev;
+    ASSERT_TRUE(sub.next(ev));
+    EXPECT_EQ(ev.seq, 12u); // oldest still in the ring
+    EXPECT_EQ(ev.frame_id, 112u);
+    EXPECT_EQ(sub.missed(), 12u);
+    int read = 1;
+    while (sub.next(ev))
+        ++read;
+    EXPECT_EQ(read, 8);
+    EXPECT_EQ(ev.frame_id, 119u);
+
+    pub.publish(200, 0, 1, 1, {});
+    pub.publish(201, 0, 1, 1, {});
+    pub.publish(202, 0, 1, 1, {});
+    ASSERT_TRUE(sub.latest(ev));
+    EXPECT_EQ(ev.frame_id, 202u);
+    EXPECT_EQ(sub.missed(), 14u);
+    EXPECT_FALSE(sub.latest(ev));
+    EXPECT_FALSE(sub.next(ev));
+}
+
+TEST_F(DetectionBusTest, ReaderFollowsRestartedProducer) {
+    DetectionSubscriber sub;
+    EXPECT_FALSE(sub.open(name_));
+    EXPECT_FALSE(sub.error().empty());
+
+    BusEvent ev;
+    {
+        DetectionPublisher pub;
+        ASSERT_TRUE(pub.open(config()));
+        ASSERT_TRUE(sub.open(name_));
+        pub.publish(1, 0, 1, 1, {});
+        pub.publish(2, 0, 1, 1, {});
+        ASSERT_TRUE(sub.next(ev));
+    } // closed: retired, name kept
+
+    // Same layout: the segment is reused under a new epoch
+    DetectionPublisher again;
+    ASSERT_TRUE(again.open(config()));
+    again.publish(50, 0, 1, 1, {});
+    ASSERT_TRUE(sub.next(ev));
+    EXPECT_EQ(ev.frame_id, 50u);
+    EXPECT_EQ(sub.restarts(), 1u);
+    again.close();
+
+    // Different layout: a new segment replaces the retired one
+    DetectionPublisher bigger;
+    ASSERT_TRUE(bigger.open(config(64, 2)));
+    bigger.publish(60, 0, 1, 1, {make_hand(2), make_hand(3)});
+    ASSERT_TRUE(sub.next(ev));
+    EXPECT_EQ(ev.frame_id, 60u);
+    EXPECT_EQ(ev.hands.size(), 2u);
+    EXPECT_EQ(sub.restarts(), 2u);
+}
+
+TEST_F(DetectionBusTest, ConcurrentReadersSeeConsistentRecords) {
+    DetectionPublisher pub;
+    ASSERT_TRUE(pub.open(config(16)));
+    const uint64_t total = 20000;
+
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> bad{0};
+    std::atomic<uint64_t> seen{0};
+    std::atomic<int> attached{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r) {
+        readers.emplace_back([&] {
+            DetectionSubscriber sub;
+            const bool opened = sub.open(name_);
+            ++attached;
+            if (!opened) {
+                ++bad;
+                return;
+            }
+            BusEvent ev;
+            uint64_t last = 0;
+            bool first = true;
+            for (;;) {
+                bool finished = done.load();
+                bool got = false;
+                while (sub.next(ev)) {
+                    got = true;
+                    ++seen;
+                    // Every field of a record derives from its frame id, so
+                    // a torn read would show up as a mismatch
+                    const uint64_t f = ev.frame_id;
+                    if ((!first && f <= last) || ev.capture_ns != f * 3 || ev.frame_width != f % 1000 ||
+                        ev.hands.size() != f % 3 ||
+                        (!ev.hands.empty() && ev.hands.back().contour_area != static_cast<uint32_t>(f)))
+                        ++bad;
+                    last = f;
+                    first = false;
+                }
+                if (finished && !got)
+                    break;
+            }
+        });
+    }
+
+    // Subscribers start at the newest record: publish only once both are attached
+    while (attached.load() < 2)
+        std::this_thread::yield();
+    for (uint64_t f = 1; f <= total; ++f) {
+        std::vector<HandDetection> hands(f % 3);
+        for (auto &h : hands)
+            h.contour_area = static_cast<uint32_t>(f);
+        pub.publish(f, f * 3, static_cast<uint32_t>(f % 1000), 1, hands);
+    }
+    done = true;
+    for (auto &t : readers)
+        t.join();
+    EXPECT_EQ(bad.load(), 0u);
+    EXPECT_GT(seen.load(), 0u);
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include "dots_parser.hpp"
+#include "local_http_server.hpp"
+#include "renderer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace renderer;
+
+namespace {
+
+std::vector<RenderLine> parse(const std::string &body, size_t chunk, DotsParser &parser, bool *complete = nullptr) {
+    std::vector<RenderLine> lines;
+    parser.reset(&lines);
+    for (size_t i = 0; i < body.size(); i += chunk)
+        parser.feed(body.data() + i, std::min(chunk, body.size() - i));
+    bool done = parser.finish();
+    if (complete)
+        *complete = done;
+    return lines;
+}
+
+// The regex extraction render_frame used before, as the reference
+std::vector<RenderLine> regex_reference(const std::string &body, bool &clear) {
+    std::vector<RenderLine> lines;
+    std::regex obj_re(R"RX(\{[^}]*\})RX");
+    std::regex x0_re(R"RX("x0"\s*:\s*(-?\d+))RX");
+    std::regex y0_re(R"RX("y0"\s*:\s*(-?\d+))RX");
+    std::regex x1_re(R"RX("x1"\s*:\s*(-?\d+))RX");
+    std::regex y1_re(R"RX("y1"\s*:\s*(-?\d+))RX");
+    std::regex th_re(R"RX("thickness"\s*:\s*(\d+))RX");
+    std::regex c_re(R"RX("color"\s*:\s*"(#[0-9a-fA-F]{6})")RX");
+    std::regex clear_re(R"RX("clear"\s*:\s*(true|false))RX");
+    std::smatch m;
+    clear = !std::regex_search(body, m, clear_re) || m[1].str() == "true";
+    for (auto it = std::sregex_iterator(body.begin(), body.end(), obj_re); it != std::sregex_iterator(); ++it) {
+        std::string obj = it->str();
+        RenderLine l;
+        bool has_any = false;
+        if (std::regex_search(obj, m, x0_re)) { l.x0 = std::stoi(m[1].str()); has_any = true; }
+        if (std::regex_search(obj, m, y0_re)) { l.y0 = std::stoi(m[1].str()); has_any = true; }
+        if (std::regex_search(obj, m, x1_re)) { l.x1 = std::stoi(m[1].str()); has_any = true; }
+        if (std::regex_search(obj, m, y1_re)) { l.y1 = std::stoi(m[1].str()); has_any = true; }
+        if (std::regex_search(obj, m, th_re))
+            l.thickness = std::stoi(m[1].str());
+        if (std::regex_search(obj, m, c_re)) {
+            unsigned int r = 0, g = 0, b = 0;
+            std::sscanf(m[1].str().c_str() + 1, "%02x%02x%02x", &r, &g, &b);
+            l.color = (r << 16) | (g << 8) | b;
+        }
+        if (has_any)
+            lines.push_back(l);
+    }
+    return lines;
+}
+
+std::string sample_body(int count) {
+    std::string body = "{\"id\":\"bp\",\"blueprintId\":\"bp\",\"clear\":false,\"lines\":[";
+    for (int i = 0; i < count; ++i) {
+        char obj[160];
+        std::snprintf(obj, sizeof(obj),
+                      "%s{\"x0\": %d, \"y0\":%d,\"x1\":%d.%d,\"y1\":%d,\"color\":\"#%06X\",\"thickness\":%d}",
+                      i ? "," : "", i % 1920, -(i % 7), (i * 13) % 1920, i % 10, (i * 7) % 1080,
+                      (i * 2654435761u) & 0xFFFFFF, 1 + i % 9);
+        body += obj;
+    }
+    return body + "]}";
+}
+
+void expect_same(const std::vector<RenderLine> &a, const std::vector<RenderLine> &b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i].x0, b[i].x0) << i;
+        EXPECT_EQ(a[i].y0, b[i].y0) << i;
+        EXPECT_EQ(a[i].x1, b[i].x1) << i;
+        EXPECT_EQ(a[i].y1, b[i].y1) << i;
+        EXPECT_EQ(a[i].thickness, b[i].thickness) << i;
+        EXPECT_EQ(a[i].color, b[i].color) << i;
+    }
+}
+
+} // namespace
+
+TEST(DotsParserTest, MatchesTheRegexExtraction) {
+    std::string body = sample_body(300);
+    bool clear = true;
+    std::vector<RenderLine> expected = regex_reference(body, clear);
+    ASSERT_EQ(expected.size(), 300u);
+
+    DotsParser parser;
+    for (size_t chunk : {1u, 3u, 64u, 4096u, 1u << 20}) {
+        bool complete = false;
+        std::vector<RenderLine> lines = parse(body, chunk, parser, &complete);
+        EXPECT_TRUE(complete);
+        expect_same(lines, expected);
+        EXPECT_TRUE(parser.has_clear());
+        EXPECT_EQ(parser.clear(), clear);
+        EXPECT_TRUE(parser.saw_lines_key());
+    }
+}
+
+TEST(DotsParserTest, DefaultsAndOddValues) {
+    DotsParser parser;
+    std::vector<RenderLine> lines = parse(
+        "{\"lines\":[{\"x0\":5},"
+        "{\"x0\":1,\"y0\":2,\"color\":\"FF0000\",\"thickness\":-4},"
+        "{\"name\":\"no {coords} \\\"here\\\"\",\"color\":\"#00ff00\"},"
+        "{\"x1\":\"7\",\"y1\":1e2,\"color\":\"#0000fF\",\"note\":null}]}",
+        5, parser);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0].x0, 5);
+    EXPECT_EQ(lines[0].thickness, 3);
+    EXPECT_EQ(lines[0].color, 0x00FFFFFFu);
+    EXPECT_EQ(lines[1].color, 0x00FFFFFFu); // colours need the '#'
+    EXPECT_EQ(lines[1].thickness, 3);       // negative thickness is ignored
+    EXPECT_EQ(lines[2].x1, 0);              // a string is not a coordinate
+    EXPECT_EQ(lines[2].y1, 1);
+    EXPECT_EQ(lines[2].color, 0x000000FFu);
+    EXPECT_FALSE(parser.has_clear());
+}
+
+TEST(DotsParserTest, ClearFlagAndTruncation) {
+    DotsParser parser;
+    bool complete = true;
+    parse("{\"clear\": true, \"lines\": [{\"x0\": 1}, {\"x0\": 2", 4, parser, &complete);
+    EXPECT_TRUE(parser.has_clear());
+    EXPECT_TRUE(parser.clear());
+    EXPECT_FALSE(complete);
+
+    std::vector<RenderLine> lines = parse("{\"clear\":false,\"lines\":[]}", 2, parser, &complete);
+    EXPECT_TRUE(complete);
+    EXPECT_TRUE(lines.empty());
+    EXPECT_FALSE(parser.clear());
+    EXPECT_TRUE(parser.saw_lines_key());
+}
+
+TEST(DotsParserTest, HashFollowsContent) {
+    DotsParser parser;
+    parse(sample_body(10), 7, parser);
+    uint64_t a = parser.hash();
+    parse(sample_body(10), 1000, parser);
+    EXPECT_EQ(parser.hash(), a);
+    parse(sample_body(11), 7, parser);
+    EXPECT_NE(parser.hash(), a);
+}
+
+TEST(DotsParserTest, FasterThanTheRegexExtraction) {
+    std::string body = sample_body(3000);
+    DotsParser parser;
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<RenderLine> lines = parse(body, 16384, parser);
+    auto t1 = std::chrono::steady_clock::now();
+    bool clear;
+    std::vector<RenderLine> expected = regex_reference(body, clear);
+    auto t2 = std::chrono::steady_clock::now();
+    expect_same(lines, expected);
+    EXPECT_LT((t1 - t0) * 4, t2 - t1);
+}
+
+TEST(RenderFrameTest, UnchangedResponseIsNotRedrawn) {
+    std::mutex mutex;
+    std::string body = sample_body(50);
+    test_http::LocalHttpServer server([&](const test_http::Request &) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return test_http::response(200, body);
+    });
+    const uint32_t w = 640, h = 480;
+    std::vector<uint32_t> fb(w * h, 0x12345678);
+    DotsFrame frame;
+
+    ASSERT_TRUE(render_frame("127.0.0.1", server.port(), "/dots", false, nullptr, fb.data(), w * 4, w, h, frame));
+    EXPECT_EQ(frame.redraws, 1u);
+    EXPECT_EQ(frame.lines.size(), 50u);
+    EXPECT_FALSE(frame.clear);
+    std::vector<uint32_t> drawn = fb;
+    EXPECT_NE(drawn, std::vector<uint32_t>(w * h, 0x12345678));
+
+    // Same content: nothing is touched
+    std::fill(fb.begin(), fb.end(), 0u);
+    ASSERT_TRUE(render_frame("127.0.0.1", server.port(), "/dots", false, nullptr, fb.data(), w * 4, w, h, frame));
+    EXPECT_EQ(frame.redraws, 1u);
+    EXPECT_EQ(frame.polls, 2u);
+    EXPECT_EQ(fb, std::vector<uint32_t>(w * h, 0u));
+
+    // Invalidated (another mode drew) or changed: drawn again
+    frame.invalidate();
+    ASSERT_TRUE(render_frame("127.0.0.1", server.port(), "/dots", false, nullptr, fb.data(), w * 4, w, h, frame));
+    EXPECT_EQ(frame.redraws, 2u);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        body = sample_body(51);
+    }
+    ASSERT_TRUE(render_frame("127.0.0.1", server.port(), "/dots", false, nullptr, fb.data(), w * 4, w, h, frame));
+    EXPECT_EQ(frame.redraws, 3u);
+    EXPECT_EQ(frame.lines.size(), 51u);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "frame_pyramid.hpp"
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace camera;
+
+namespace {
+
+Frame rgb_frame(uint32_t width, uint32_t height, int stride = 0) {
+    Frame f;
+    f.width = width;
+    f.height = height;
+    f.format = PixelFormat::RGB888;
+    f.stride = stride ? stride : static_cast<int>(width * 3);
+    f.data.resize(static_cast<size_t>(f.stride) * height);
+    uint32_t v = 12345;
+    for (auto &b : f.data) {
+        v = v * 1103515245u + 12345u;
+        b = static_cast<uint8_t>(v >> 16);
+    }
+    f.size = f.data.size();
+    f.timestamp_ns = 1000;
+    f.sequence = 1;
+    return f;
+}
+
+// Straightforward 2x2 average of a packed or strided RGB image
+std::vector<uint8_t> halve(const uint8_t *src, size_t stride, uint32_t w, uint32_t h) {
+    std::vector<uint8_t> out(static_cast<size_t>(w / 2) * (h / 2) * 3);
+    for (uint32_t y = 0; y < h / 2; ++y)
+        for (uint32_t x = 0; x < w / 2; ++x)
+            for (int c = 0; c < 3; ++c) {
+                const uint8_t *p = src + 2 * y * stride + 2 * x * 3 + c;
+                out[(y * (w / 2) + x) * 3 + c] =
+                    static_cast<uint8_t>((p[0] + p[3] + p[stride] + p[stride + 3] + 2) >> 2);
+            }
+    return out;
+}
+
+} // namespace
+
+TEST(FramePyramidTest, LevelsAreRepeatedHalvings) {
+    // Odd sizes and row padding: the last column and row are dropped
+    Frame f = rgb_frame(101, 67, 101 * 3 + 5);
+    std::vector<uint8_t> expect = halve(f.pixels(), f.stride, f.width, f.height);
+    uint32_t w = f.width / 2, h = f.height / 2;
+    for (int level = 1; level <= kPyramidLevels; ++level) {
+        const Frame *l = f.pyramid_level(level);
+        ASSERT_NE(l, nullptr) << level;
+        EXPECT_EQ(l->width, w);
+        EXPECT_EQ(l->height, h);
+        EXPECT_EQ(l->stride, static_cast<int>(w * 3));
+        EXPECT_EQ(l->format, PixelFormat::RGB888);
+        EXPECT_EQ(l->timestamp_ns, f.timestamp_ns);
+        EXPECT_EQ(l->sequence, f.sequence);
+        EXPECT_EQ(l->data, expect) << level;
+        expect = halve(expect.data(), w * 3, w, h);
+        w /= 2;
+        h /= 2;
+    }
+    EXPECT_EQ(f.pyramid_level(0), nullptr);
+    EXPECT_EQ(f.pyramid_level(kPyramidLevels + 1), nullptr);
+}
+
+TEST(FramePyramidTest, BuildsOnlyAsDeepAsAsked) {
+    Frame f = rgb_frame(101, 67, 101 * 3 + 5);
+    const std::vector<uint8_t> half = halve(f.pixels(), f.stride, f.width, f.height);
+    const std::vector<uint8_t> quarter = halve(half.data(), 50 * 3, 50, 33);
+    const std::vector<uint8_t> eighth = halve(quarter.data(), 25 * 3, 25, 16);
+
+    ASSERT_NE(f.pyramid_level(1), nullptr);
+    EXPECT_EQ(f.pyramid->built_levels(), 1);
+    // A deeper request extends the levels already there
+    ASSERT_NE(f.pyramid_level(3), nullptr);
+    EXPECT_EQ(f.pyramid->built_levels(), 3);
+    EXPECT_EQ(f.pyramid_level(3)->data, eighth);
+    EXPECT_EQ(f.pyramid_level(2)->data, quarter);
+
+    // Straight to the deepest level on a new capture
+    f.sequence = 2;
+    ASSERT_NE(f.pyramid_level(2), nullptr);
+    EXPECT_EQ(f.pyramid->built_levels(), 2);
+    EXPECT_EQ(f.pyramid_level(2)->data, quarter);
+    EXPECT_EQ(f.pyramid_level(1)->data, half);
+    EXPECT_EQ(f.pyramid->built_levels(), 2);
+}
+
+TEST(FramePyramidTest, ConcurrentConsumersShareOnePyramid) {
+    Frame f = rgb_frame(320, 240);
+    const std::vector<uint8_t> half = halve(f.pixels(), f.stride, f.width, f.height);
+    for (int round = 0; round < 50; ++round) {
+        f.sequence = round + 2; // stale pyramid, or none the first time
+        const Frame *seen[4] = {};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&f, &seen, t] { seen[t] = f.pyramid_level(1 + t % 2); });
+        for (auto &t : threads)
+            t.join();
+        ASSERT_NE(seen[0], nullptr);
+        EXPECT_EQ(seen[0], seen[2]);
+        EXPECT_EQ(seen[1], seen[3]);
+        EXPECT_EQ(seen[0], f.pyramid_level(1));
+        EXPECT_EQ(seen[0]->data, half);
+    }
+}
+
+TEST(FramePyramidTest, WideRowsMatchTheReference) {
+    // Wide enough for the vector path, with a scalar tail
+    Frame f = rgb_frame(2 * 37, 8);
+    const Frame *l = f.pyramid_level(1);
+    ASSERT_NE(l, nullptr);
+    EXPECT_EQ(l->data, halve(f.pixels(), f.stride, f.width, f.height));
+}
+
+TEST(FramePyramidTest, BuiltOnceAndSharedByCopies) {
+    Frame f = rgb_frame(64, 48);
+    EXPECT_EQ(f.pyramid, nullptr); // nothing until asked
+    const Frame *half = f.pyramid_level(1);
+    ASSERT_NE(half, nullptr);
+    EXPECT_EQ(f.pyramid_level(1), half);
+    // Copies borrowing the same pixels share it
+    Frame borrowed = f;
+    borrowed.data.clear();
+    borrowed.external = f.data.data();
+    EXPECT_EQ(borrowed.pyramid_level(1), half);
+    EXPECT_EQ(borrowed.pyramid_level(3), f.pyramid_level(3));
+    // A copy owning its own pixels gets its own
+    Frame owned = f;
+    ASSERT_NE(owned.pyramid_level(1), nullptr);
+    EXPECT_NE(owned.pyramid_level(1), half);
+    EXPECT_EQ(owned.pyramid_level(1)->data, half->data);
+}
+
+TEST(FramePyramidTest, NewFrameRebuilds) {
+    Frame f = rgb_frame(64, 48);
+    const Frame *half = f.pyramid_level(1);
+    ASSERT_NE(half, nullptr);
+    const uint8_t before = half->data[0];
+
+    // Same buffer, next capture: the same pyramid is rebuilt in place
+    f.data[0] = f.data[3] = f.data[f.stride] = f.data[f.stride + 3] = static_cast<uint8_t>(before + 100);
+    f.sequence = 2;
+    EXPECT_EQ(f.pyramid_level(1), half);
+    EXPECT_EQ(half->data[0], static_cast<uint8_t>(before + 100));
+    EXPECT_EQ(half->sequence, 2u);
+
+    // Pixels edited in place keep the key, so the pyramid must be dropped
+    f.data[0] = f.data[3] = f.data[f.stride] = f.data[f.stride + 3] = 7;
+    f.invalidate_pyramid();
+    ASSERT_NE(f.pyramid_level(1), nullptr);
+    EXPECT_EQ(f.pyramid_level(1)->data[0], 7);
+}
+
+TEST(FramePyramidTest, CopyKeepsItsPyramidWhenTheOriginalMovesOn) {
+    Frame f = rgb_frame(64, 48);
+    Frame copy = f;
+    const Frame *half = copy.pyramid_level(1);
+    ASSERT_NE(half, nullptr);
+    f.pyramid = copy.pyramid;
+    const std::vector<uint8_t> kept = half->data;
+
+    f.data.assign(f.data.size(), 200);
+    f.sequence = 2;
+    const Frame *next = f.pyramid_level(1);
+    ASSERT_NE(next, nullptr);
+    EXPECT_NE(next, half);
+    EXPECT_EQ(next->data[0], 200);
+    EXPECT_EQ(copy.pyramid_level(1), half);
+    EXPECT_EQ(half->data, kept);
+}
+
+TEST(FramePyramidTest, OnlyForRgbFramesLargeEnough) {
+    Frame yuv = rgb_frame(64, 48);
+    yuv.format = PixelFormat::YUV420;
+    EXPECT_EQ(yuv.pyramid_level(1), nullptr);
+
+    Frame small = rgb_frame(6, 6);
+    EXPECT_NE(small.pyramid_level(2), nullptr);
+    EXPECT_EQ(small.pyramid_level(3), nullptr);
+
+    Frame truncated = rgb_frame(64, 48);
+    truncated.data.resize(100);
+    EXPECT_EQ(truncated.pyramid_level(1), nullptr);
+}
+
+TEST(FramePyramidTest, PyramidForPicksTheSmallestCoveringLevel) {
+    Frame f = rgb_frame(640, 480);
+    EXPECT_EQ(f.pyramid_for(192, 192).width, 320u);
+    EXPECT_EQ(f.pyramid_for(128, 96).width, 160u);
+    EXPECT_EQ(f.pyramid_for(16, 16).width, 80u); // 1/8 is the last level
+    EXPECT_EQ(&f.pyramid_for(400, 300), &f);
+}
@@ -0,0 +1,353 @@
+#include <gtest/gtest.h>
+#include "frame_recording.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace camera;
+
+namespace {
+
+class FrameRecordingTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        path_ = "/tmp/jarvis_recording_test_" + std::to_string(getpid()) + "_" +
+                ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".jrec";
+    }
+    void TearDown() override { std::remove(path_.c_str()); }
+
+    // 8x4 RGB frame filled from its id, 10 ms apart
+    static Frame rgb_frame(uint64_t id) {
+        Frame f;
+        f.width = 8;
+        f.height = 4;
+        f.format = PixelFormat::RGB888;
+        f.stride = 24;
+        f.data.assign(96, static_cast<uint8_t>(id));
+        f.size = f.data.size();
+        f.timestamp_ns = 1000000000ULL + id * 10000000ULL;
+        return f;
+    }
+
+    void record(uint64_t frames) {
+        FrameRecorder rec;
+        ASSERT_TRUE(rec.open(path_)) << rec.error();
+        for (uint64_t id = 1; id <= frames; ++id)
+            ASSERT_TRUE(rec.write(id, rgb_frame(id))) << rec.error();
+        ASSERT_TRUE(rec.close()) << rec.error();
+    }
+
+    CameraConfig replay_config(float fps) {
+        CameraConfig c;
+        c.replay = path_;
+        c.replay_fps = fps;
+        return c;
+    }
+
+    std::string path_;
+};
+
+} // namespace
+
+TEST_F(FrameRecordingTest, FramesAndMetadataRoundTrip) {
+    FrameRecorder rec;
+    ASSERT_TRUE(rec.open(path_)) << rec.error();
+    Frame rgb = rgb_frame(1);
+    IMX500HandLandmark hand;
+    hand.landmarks[IMX500HandLandmark::INDEX_FINGER_TIP] = IMX500Keypoint(0.25f, 0.75f, 0.9f);
+    hand.handedness = 1.0f;
+    rgb.imx500_hand_landmarks.push_back(hand);
+    rgb.imx500_detections.resize(2);
+    ASSERT_TRUE(rec.write(1, rgb));
+
+    // Raw YUV420 with the metadata of the frame it was converted into
+    std::vector<uint8_t> yuv(8 * 4 * 3 / 2, 0x80);
+    Frame meta = rgb_frame(2);
+    ASSERT_TRUE(rec.write(2, meta, yuv.data(), static_cast<uint32_t>(yuv.size()), PixelFormat::YUV420, 8));
+    EXPECT_FALSE(rec.write(3, Frame()));
+    ASSERT_TRUE(rec.close());
+    EXPECT_EQ(rec.frames(), 2u);
+
+    FrameRecording r;
+    ASSERT_TRUE(r.open(path_)) << r.error();
+    EXPECT_TRUE(r.indexed());
+    ASSERT_EQ(r.size(), 2u);
+
+    RecordingView v;
+    ASSERT_TRUE(r.frame(0, v));
+    EXPECT_EQ(v.frame_id, 1u);
+    EXPECT_EQ(v.timestamp_ns, rgb.timestamp_ns);
+    EXPECT_EQ(v.width, 8u);
+    EXPECT_EQ(v.format, PixelFormat::RGB888);
+    EXPECT_EQ(v.stride, 24u);
+    ASSERT_EQ(v.bytes, 96u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(v.data) % 64, 0u);
+    EXPECT_EQ(v.data[95], 1);
+    Frame out;
+    FrameRecording::copy_metadata(v, out);
+    EXPECT_TRUE(out.has_imx500_metadata);
+    EXPECT_EQ(out.imx500_detections.size(), 2u);
+    ASSERT_EQ(out.imx500_hand_landmarks.size(), 1u);
+    EXPECT_FLOAT_EQ(out.imx500_hand_landmarks[0].landmarks[IMX500HandLandmark::INDEX_FINGER_TIP].y, 0.75f);
+    EXPECT_FLOAT_EQ(out.imx500_hand_landmarks[0].handedness, 1.0f);
+
+    ASSERT_TRUE(r.frame(1, v));
+    EXPECT_EQ(v.format, PixelFormat::YUV420);
+    EXPECT_EQ(v.bytes, 48u);
+    EXPECT_EQ(v.data[0], 0x80);
+    FrameRecording::copy_metadata(v, out);
+    EXPECT_FALSE(out.has_imx500_metadata);
+    EXPECT_FALSE(r.frame(2, v));
+}
+
+TEST_F(FrameRecordingTest, UnclosedRecordingIsRecovered) {
+    record(5);
+    // Undo what close() adds: the header fields and the index
+    {
+        std::fstream f(path_, std::ios::in | std::ios::out | std::ios::binary);
+        RecordingHeader h;
+        f.read(reinterpret_cast<char *>(&h), sizeof(h));
+        const uint64_t index_offset = h.index_offset;
+        h.frame_count = 0;
+        h.index_offset = 0;
+        f.seekp(0);
+        f.write(reinterpret_cast<const char *>(&h), sizeof(h));
+        f.close();
+        // ...and a record torn in half by the crash
+        ASSERT_EQ(truncate(path_.c_str(), static_cast<off_t>(index_offset - 100)), 0);
+    }
+    FrameRecording r;
+    ASSERT_TRUE(r.open(path_)) << r.error();
+    EXPECT_FALSE(r.indexed());
+    ASSERT_EQ(r.size(), 4u);
+    RecordingView v;
+    ASSERT_TRUE(r.frame(3, v));
+    EXPECT_EQ(v.frame_id, 4u);
+
+    std::ofstream(path_, std::ios::binary) << "not a recording, but long enough to have a header......";
+    EXPECT_FALSE(r.open(path_));
+    EXPECT_FALSE(r.open(path_ + ".missing"));
+}
+
+TEST_F(FrameRecordingTest, ReplayServesFramesInOrder) {
+    record(3);
+    ReplaySource src;
+    EXPECT_FALSE(src.start());
+    ASSERT_TRUE(src.init(replay_config(-1.0f))) << src.get_error();
+    EXPECT_EQ(src.get_config().width, 8u);
+    EXPECT_EQ(src.get_config().height, 4u);
+    EXPECT_EQ(src.get_config().framerate, 100u);
+    ASSERT_TRUE(src.start());
+
+    for (uint64_t id = 1; id <= 3; ++id) {
+        Frame *f = src.capture_frame();
+        ASSERT_NE(f, nullptr) << src.get_error();
+        EXPECT_EQ(f->timestamp_ns, rgb_frame(id).timestamp_ns);
+        EXPECT_EQ(f->sequence, id);
+        EXPECT_EQ(f->format, PixelFormat::RGB888);
+        ASSERT_TRUE(f->has_pixels());
+        // RGB records are borrowed from the mapping, not copied
+        EXPECT_NE(f->external, nullptr);
+        EXPECT_EQ(f->pixels()[95], id);
+    }
+    EXPECT_EQ(src.capture_frame(), nullptr);
+    EXPECT_FALSE(src.is_running());
+    EXPECT_EQ(src.get_error(), "End of recording");
+    EXPECT_EQ(src.frames_served(), 3u);
+    EXPECT_EQ(src.get_missed_frames(), 0u);
+}
+
+TEST_F(FrameRecordingTest, ReplayKeepsSequenceGapsAsMissedFrames) {
+    {
+        FrameRecorder rec;
+        ASSERT_TRUE(rec.open(path_)) << rec.error();
+        for (uint64_t id : {1, 2, 5, 6})
+            ASSERT_TRUE(rec.write(id, rgb_frame(id))) << rec.error();
+        ASSERT_TRUE(rec.close()) << rec.error();
+    }
+    CameraConfig c = replay_config(-1.0f);
+    c.replay_loop = true;
+    ReplaySource src;
+    ASSERT_TRUE(src.init(c)) << src.get_error();
+    ASSERT_TRUE(src.start());
+
+    // The second pass continues the numbering with the same gap in it
+    const uint64_t expect[] = {1, 2, 5, 6, 7, 8, 11, 12};
+    for (uint64_t seq : expect) {
+        Frame *f = src.capture_frame();
+        ASSERT_NE(f, nullptr) << src.get_error();
+        EXPECT_EQ(f->sequence, seq);
+    }
+    EXPECT_EQ(src.get_missed_frames(), 4u);
+
+    // Restarting starts the count again
+    src.stop();
+    ASSERT_TRUE(src.start());
+    Frame *f = src.capture_frame();
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(f->sequence, 1u);
+    EXPECT_EQ(src.get_missed_frames(), 0u);
+}
+
+TEST_F(FrameRecordingTest, ReplayConvertsYuvLikeTheCamera) {
+    std::vector<uint8_t> yuv(16 * 8 * 3 / 2);
+    for (size_t i = 0; i < yuv.size(); ++i)
+        yuv[i] = static_cast<uint8_t>(i * 7);
+    {
+        FrameRecorder rec;
+        ASSERT_TRUE(rec.open(path_));
+        Frame meta;
+        meta.width = 16;
+        meta.height = 8;
+        ASSERT_TRUE(rec.write(1, meta, yuv.data(), static_cast<uint32_t>(yuv.size()), PixelFormat::YUV420, 16));
+    }
+    std::vector<uint8_t> expect(16 * 8 * 3);
+    utils::yuv420_to_rgb888(yuv.data(), expect.data(), 16, 8);
+
+    ReplaySource src;
+    ASSERT_TRUE(src.init(replay_config(-1.0f)));
+    ASSERT_TRUE(src.start());
+    Frame *f = src.capture_frame();
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(f->format, PixelFormat::RGB888);
+    EXPECT_EQ(f->stride, 48);
+    EXPECT_EQ(f->external, nullptr);
+    EXPECT_EQ(f->data, expect);
+}
+
+// RGB records are borrowed from the mapping; one whose size or stride
+// cannot cover its rows must stop the replay instead of being read past
+TEST_F(FrameRecordingTest, ReplayRejectsMalformedRgbRecords) {
+    struct Bad {
+        uint32_t bytes;
+        uint32_t stride;
+        PixelFormat format;
+    };
+    for (const Bad &bad : {Bad{50, 24, PixelFormat::RGB888}, Bad{96, 20, PixelFormat::RGB888},
+                           Bad{96, 24, PixelFormat::RGBA8888}, Bad{96, 24, PixelFormat::UNKNOWN}}) {
+        std::vector<uint8_t> pixels(bad.bytes, 0x40);
+        {
+            FrameRecorder rec;
+            ASSERT_TRUE(rec.open(path_));
+            ASSERT_TRUE(rec.write(1, rgb_frame(1)));
+            ASSERT_TRUE(rec.write(2, rgb_frame(2), pixels.data(), bad.bytes, bad.format, bad.stride));
+            ASSERT_TRUE(rec.close());
+        }
+        ReplaySource src;
+        ASSERT_TRUE(src.init(replay_config(-1.0f))) << src.get_error();
+        ASSERT_TRUE(src.start());
+        ASSERT_NE(src.capture_frame(), nullptr) << src.get_error();
+        EXPECT_EQ(src.capture_frame(), nullptr) << bad.bytes << " " << bad.stride;
+        EXPECT_EQ(src.get_error(), "Short or malformed record 1");
+        EXPECT_FALSE(src.is_running());
+    }
+}
+
+TEST_F(FrameRecordingTest, ReplayDeliversTheDetectionStream) {
+    std::vector<uint8_t> yuv(16 * 8 * 3 / 2);
+    for (size_t i = 0; i < yuv.size(); ++i)
+        yuv[i] = static_cast<uint8_t>(i * 13);
+    {
+        FrameRecorder rec;
+        ASSERT_TRUE(rec.open(path_));
+        Frame meta;
+        meta.width = 16;
+        meta.height = 8;
+        meta.timestamp_ns = 5;
+        ASSERT_TRUE(rec.write(1, meta, yuv.data(), static_cast<uint32_t>(yuv.size()), PixelFormat::YUV420, 16));
+    }
+    // Sampling the planes gives what converting everything and then
+    // downscaling would, including for uneven ratios
+    std::vector<uint8_t> rgb(16 * 8 * 3), expect(6 * 4 * 3);
+    utils::yuv420_to_rgb888(yuv.data(), rgb.data(), 16, 8);
+    utils::resize_nearest(rgb.data(), expect.data(), 16, 8, 6, 4, 3);
+
+    CameraConfig c = replay_config(-1.0f);
+    c.lores_width = 6;
+    c.lores_height = 4;
+    ReplaySource src;
+    ASSERT_TRUE(src.init(c));
+    ASSERT_TRUE(src.start());
+    Frame *f = src.capture_frame();
+    ASSERT_NE(f, nullptr);
+    ASSERT_NE(f->lores, nullptr);
+    EXPECT_EQ(f->lores->width, 6u);
+    EXPECT_EQ(f->lores->stride, 18);
+    EXPECT_EQ(f->lores->timestamp_ns, f->timestamp_ns);
+    EXPECT_EQ(f->lores->sequence, f->sequence);
+    EXPECT_EQ(f->lores->data, expect);
+
+    // YUV420 stream: each plane sampled on its own
+    c.lores_format = PixelFormat::YUV420;
+    c.lores_width = 8;
+    c.lores_height = 4;
+    ASSERT_TRUE(src.init(c));
+    ASSERT_TRUE(src.start());
+    f = src.capture_frame();
+    ASSERT_NE(f->lores, nullptr);
+    ASSERT_EQ(f->lores->size, 48u);
+    EXPECT_EQ(f->lores->format, PixelFormat::YUV420);
+    EXPECT_EQ(f->lores->data[8 + 1], yuv[2 * 16 + 2]); // Y (1, 1) <- (2, 2)
+    EXPECT_EQ(f->lores->data[32 + 4 + 1], yuv[128 + 2 * 8 + 2]); // U (1, 1) <- (2, 2)
+
+    // Odd YUV420 sizes and streams larger than the frame are refused
+    c.lores_width = 7;
+    ASSERT_TRUE(src.init(c));
+    ASSERT_TRUE(src.start());
+    EXPECT_EQ(src.capture_frame()->lores, nullptr);
+    c.lores_format = PixelFormat::RGB888;
+    c.lores_width = 32;
+    ASSERT_TRUE(src.init(c));
+    ASSERT_TRUE(src.start());
+    EXPECT_EQ(src.capture_frame()->lores, nullptr);
+}
+
+TEST_F(FrameRecordingTest, ReplayPacing) {
+    record(6); // 50 ms from first to last
+    using clock = std::chrono::steady_clock;
+    auto run = [&](float fps) {
+        ReplaySource src;
+        EXPECT_TRUE(src.init(replay_config(fps)));
+        EXPECT_TRUE(src.start());
+        auto start = clock::now();
+        for (int i = 0; i < 6; ++i)
+            EXPECT_NE(src.capture_frame(), nullptr);
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    };
+    EXPECT_GE(run(0.0f), 49.0);   // as recorded
+    EXPECT_GE(run(100.0f), 49.0); // 10 ms apart
+    EXPECT_LT(run(-1.0f), 40.0);  // unpaced
+
+    // Looping keeps going, with timestamps that keep rising
+    CameraConfig c = replay_config(-1.0f);
+    c.replay_loop = true;
+    ReplaySource src;
+    ASSERT_TRUE(src.init(c));
+    ASSERT_TRUE(src.start());
+    uint64_t last = 0;
+    for (int i = 0; i < 14; ++i) {
+        Frame *f = src.capture_frame();
+        ASSERT_NE(f, nullptr);
+        EXPECT_GT(f->timestamp_ns, last);
+        last = f->timestamp_ns;
+    }
+    EXPECT_EQ(last, rgb_frame(2).timestamp_ns + 2 * 60000000ULL);
+}
+
+TEST_F(FrameRecordingTest, FactoryPicksReplayWhenConfigured) {
+    record(1);
+    CameraConfig c;
+    std::unique_ptr<FrameSource> live = make_frame_source(c);
+    EXPECT_NE(dynamic_cast<Camera *>(live.get()), nullptr);
+
+    setenv("JARVIS_REPLAY", path_.c_str(), 1);
+    std::unique_ptr<FrameSource> replay = make_frame_source(c);
+    ASSERT_NE(dynamic_cast<ReplaySource *>(replay.get()), nullptr);
+    EXPECT_TRUE(replay->init(c)) << replay->get_error();
+    c.camera_index = 1; // looks for <name>_1.jrec
+    EXPECT_EQ(replay_path(c), path_.substr(0, path_.size() - 5) + "_1.jrec");
+    unsetenv("JARVIS_REPLAY");
+}
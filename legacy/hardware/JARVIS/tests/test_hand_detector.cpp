@@ -3,6 +3,7 @@
 #include "camera.hpp"
 #include <vector>
 #include <cstring>
+#include <cmath>
 
 using namespace hand_detector;
 using namespace camera;
@@ -135,6 +136,150 @@ TEST_F(HandDetectorTest, SimpleSkinRegion) {
     EXPECT_GE(detections.size(), 0); // May or may not detect depending on color calibration
 }
 
+// Borrowed pixels (Python buffers) detect exactly like an owned frame
+TEST_F(HandDetectorTest, BorrowedPixelsMatchOwnedFrame) {
+    DetectorConfig config;
+    config.verbose = false;
+    config.min_hand_area = 1000;
+    HandDetector owned_detector, borrowed_detector;
+    owned_detector.init(config);
+    borrowed_detector.init(config);
+    draw_skin_rect(100, 80, 60, 80);
+    draw_skin_rect(220, 40, 40, 120);
+
+    std::vector<uint8_t> pixels = test_frame.data;
+    Frame borrowed;
+    borrowed.external = pixels.data();
+    borrowed.size = pixels.size();
+    borrowed.width = test_width;
+    borrowed.height = test_height;
+    borrowed.stride = test_width * 3;
+    borrowed.format = PixelFormat::RGB888;
+    EXPECT_TRUE(borrowed.data.empty());
+    EXPECT_EQ(borrowed.pixels(), pixels.data());
+
+    auto owned = owned_detector.detect(test_frame);
+    auto seen = borrowed_detector.detect(borrowed);
+    ASSERT_EQ(owned.size(), seen.size());
+    for (size_t i = 0; i < owned.size(); ++i) {
+        EXPECT_EQ(owned[i].bbox.x, seen[i].bbox.x);
+        EXPECT_EQ(owned[i].bbox.width, seen[i].bbox.width);
+        EXPECT_EQ(owned[i].contour_area, seen[i].contour_area);
+        EXPECT_EQ(owned[i].gesture, seen[i].gesture);
+    }
+    EXPECT_EQ(borrowed_detector.get_stats().frames_processed, 1u);
+
+    uint8_t r, g, b;
+    ASSERT_TRUE(borrowed.get_rgb(110, 90, r, g, b));
+    EXPECT_EQ(r, 220);
+    borrowed.size = 0;
+    EXPECT_FALSE(borrowed.has_pixels());
+    EXPECT_TRUE(borrowed_detector.detect(borrowed).empty());
+}
+
+// A crop of a wider buffer (padded rows) detects like the packed pixels
+TEST_F(HandDetectorTest, PaddedRowsMatchPackedFrame) {
+    for (int dy = -55; dy <= 55; ++dy) {
+        const int half = static_cast<int>(40 * std::sqrt(1.0 - dy * dy / (55.0 * 55.0)));
+        draw_skin_rect(110 - half, 120 + dy, 2 * half + 1, 1);
+    }
+    const size_t row = test_width * 3;
+    const size_t stride = row + 48;
+    std::vector<uint8_t> padded(stride * test_height, 255);
+    for (uint32_t y = 0; y < test_height; ++y)
+        std::memcpy(padded.data() + y * stride, test_frame.data.data() + y * row, row);
+    Frame borrowed;
+    borrowed.external = padded.data();
+    borrowed.size = stride * (test_height - 1) + row; // the last row's padding is not ours
+    borrowed.width = test_width;
+    borrowed.height = test_height;
+    borrowed.stride = static_cast<int>(stride);
+    borrowed.format = PixelFormat::RGB888;
+
+    // What the detector logged, then what it found
+    auto run = [](HandDetector &d, const Frame &f) {
+        ::testing::internal::CaptureStderr();
+        auto hands = d.detect(f);
+        std::string seen = ::testing::internal::GetCapturedStderr();
+        for (const auto &h : hands)
+            seen += std::to_string(h.bbox.x) + "," + std::to_string(h.bbox.y) + " " +
+                    std::to_string(h.bbox.width) + "x" + std::to_string(h.bbox.height) + "\n";
+        return seen;
+    };
+    // Full size, the pyramid, and the nearest-neighbour resize
+    for (int downscale : {1, 2, 3}) {
+        DetectorConfig config;
+        config.verbose = true; // the rejection log shows what each detector analysed
+        config.min_hand_area = 250 / (downscale * downscale);
+        config.downscale_factor = downscale;
+        HandDetector packed(config), borrowing(config);
+        const std::string packed_log = run(packed, test_frame);
+        ASSERT_FALSE(packed_log.empty()) << downscale;
+        EXPECT_EQ(run(borrowing, borrowed), packed_log) << downscale;
+    }
+}
+
+TEST_F(HandDetectorTest, LoresStreamReplacesSoftwareDownscale) {
+    DetectorConfig config;
+    config.verbose = true; // the rejection log shows what each detector analysed
+    config.min_hand_area = 250;
+    config.downscale_factor = 2;
+    HandDetector downscaling(config);
+    config.downscale_factor = 1; // ignored when a stream is delivered
+    HandDetector streamed(config);
+    HandDetector full_size(config);
+    HandDetector lores_only(config);
+    // Skin-coloured ellipse, row by row
+    for (int dy = -55; dy <= 55; ++dy) {
+        const int half = static_cast<int>(40 * std::sqrt(1.0 - dy * dy / (55.0 * 55.0)));
+        draw_skin_rect(110 - half, 120 + dy, 2 * half + 1, 1);
+    }
+
+    CameraConfig cam;
+    cam.lores_width = test_width / 2;
+    cam.lores_height = test_height / 2;
+    Frame lores;
+    ASSERT_TRUE(make_lores_frame(cam, test_frame.data.data(), PixelFormat::RGB888, test_width, test_height, lores));
+    EXPECT_EQ(lores.size, test_width * test_height * 3 / 4);
+    Frame with_stream = test_frame;
+    with_stream.lores = &lores;
+
+    auto run = [](HandDetector &d, const Frame &f, std::vector<HandDetection> &out) {
+        ::testing::internal::CaptureStderr();
+        out = d.detect(f);
+        return ::testing::internal::GetCapturedStderr();
+    };
+    std::vector<HandDetection> expected, seen, full;
+    // The stream is analysed exactly as if it were the frame, with results
+    // in main-frame coordinates
+    const std::string lores_log = run(lores_only, lores, expected);
+    const std::string streamed_log = run(streamed, with_stream, seen);
+    ASSERT_FALSE(lores_log.empty());
+    EXPECT_EQ(streamed_log, lores_log);
+    ASSERT_EQ(expected.size(), seen.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].bbox.x * 2, seen[i].bbox.x);
+        EXPECT_EQ(expected[i].bbox.width * 2, seen[i].bbox.width);
+        EXPECT_EQ(expected[i].center.y * 2, seen[i].center.y);
+    }
+
+    // Software downscaling reads the frame's pyramid, the same as a
+    // stream holding the half-size level
+    const std::string downscaled_log = run(downscaling, test_frame, expected);
+    ASSERT_NE(test_frame.pyramid_level(1), nullptr);
+    Frame half = *test_frame.pyramid_level(1);
+    Frame with_half = test_frame;
+    with_half.lores = &half;
+    HandDetector streamed_half(config);
+    EXPECT_EQ(run(streamed_half, with_half, seen), downscaled_log);
+    EXPECT_EQ(expected.size(), seen.size());
+
+    // A stream the detector cannot use falls back to the main frame
+    lores.format = PixelFormat::YUV420;
+    EXPECT_EQ(run(streamed, with_stream, seen), run(full_size, test_frame, full));
+    EXPECT_NE(run(full_size, test_frame, full), lores_log);
+}
+
 // Test calibration
 TEST_F(HandDetectorTest, Calibration) {
     HandDetector detector;
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include "homography.hpp"
+#include "sketch_pad.hpp"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <vector>
+
+using namespace sketch;
+
+namespace {
+
+// A keystoned projector view: known ground-truth homography
+const double kTruth[9] = {
+    0.9, 0.05, 4.0,
+    -0.03, 1.1, 2.0,
+    0.0008, -0.0005, 1.0};
+
+Point apply_truth(const Point &p) {
+    double x, y;
+    apply_homography(kTruth, p.x, p.y, x, y);
+    return Point(static_cast<float>(x), static_cast<float>(y));
+}
+
+} // namespace
+
+// Four corners determine H exactly
+TEST(HomographyTest, FourPointExact) {
+    Point src[4] = {Point(10.0f, 10.0f), Point(90.0f, 12.0f), Point(88.0f, 85.0f), Point(12.0f, 90.0f)};
+    Point dst[4];
+    for (int i = 0; i < 4; ++i)
+        dst[i] = apply_truth(src[i]);
+
+    double H[9];
+    ASSERT_TRUE(solve_homography(src, dst, 4, H));
+    for (int i = 0; i < 9; ++i)
+        EXPECT_NEAR(H[i], kTruth[i], 1e-4) << "element " << i; // float inputs
+}
+
+// Extra noisy points are fitted in the least-squares sense
+TEST(HomographyTest, LeastSquaresWithNoise) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(5.0f, 95.0f);
+    std::normal_distribution<float> noise(0.0f, 0.05f);
+
+    std::vector<Point> src, dst;
+    for (int i = 0; i < 40; ++i) {
+        Point p(coord(rng), coord(rng));
+        Point q = apply_truth(p);
+        src.push_back(p);
+        dst.push_back(Point(q.x + noise(rng), q.y + noise(rng)));
+    }
+
+    double H[9];
+    ASSERT_TRUE(solve_homography(src.data(), dst.data(), src.size(), H));
+
+    // Prediction error on clean points is well below the input noise
+    for (float x = 10.0f; x <= 90.0f; x += 20.0f) {
+        for (float y = 10.0f; y <= 90.0f; y += 20.0f) {
+            double ox, oy;
+            ASSERT_TRUE(apply_homography(H, x, y, ox, oy));
+            Point t = apply_truth(Point(x, y));
+            EXPECT_NEAR(ox, t.x, 0.05);
+            EXPECT_NEAR(oy, t.y, 0.05);
+        }
+    }
+}
+
+TEST(HomographyTest, DegenerateInputRejected) {
+    Point collinear[4] = {Point(0.0f, 0.0f), Point(10.0f, 10.0f), Point(20.0f, 20.0f), Point(30.0f, 30.0f)};
+    double H[9];
+    EXPECT_FALSE(solve_homography(collinear, collinear, 4, H));
+    EXPECT_FALSE(solve_homography(collinear, collinear, 3, H));
+}
+
+TEST(HomographyTest, InverseRoundTrip) {
+    double inv[9];
+    ASSERT_TRUE(invert_homography(kTruth, inv));
+    double x, y, bx, by;
+    ASSERT_TRUE(apply_homography(kTruth, 37.0, 61.0, x, y));
+    ASSERT_TRUE(apply_homography(inv, x, y, bx, by));
+    EXPECT_NEAR(bx, 37.0, 1e-9);
+    EXPECT_NEAR(by, 61.0, 1e-9);
+}
+
+// Grid lookups agree with the direct transform (float and fixed-point)
+TEST(HomographyTest, RemapGridMatchesDirectTransform) {
+    const uint32_t w = 640, h = 480;
+    for (bool fixed : {false, true}) {
+        RemapGrid grid;
+        ASSERT_TRUE(grid.build(kTruth, w, h, 8, fixed));
+        EXPECT_TRUE(grid.valid());
+        EXPECT_EQ(grid.fixed_point(), fixed);
+
+        float max_err = 0.0f;
+        for (uint32_t py = 0; py < h; py += 7) {
+            for (uint32_t px = 0; px < w; px += 7) {
+                float gx, gy;
+                grid.map(static_cast<float>(px), static_cast<float>(py), gx, gy);
+                Point t = apply_truth(Point::from_pixels(static_cast<float>(px), static_cast<float>(py), w, h));
+                max_err = std::max(max_err, std::max(std::fabs(gx - t.x), std::fabs(gy - t.y)));
+            }
+        }
+        // Well under a display pixel at 1080p (~0.09%)
+        EXPECT_LT(max_err, 0.02f) << (fixed ? "fixed" : "float");
+    }
+}
+
+TEST(HomographyTest, RemapGridClampsOutOfRange) {
+    RemapGrid grid;
+    ASSERT_TRUE(grid.build(kTruth, 320, 240, 16));
+    float ax, ay, bx, by;
+    grid.map(-50.0f, -50.0f, ax, ay);
+    grid.map(0.0f, 0.0f, bx, by);
+    EXPECT_FLOAT_EQ(ax, bx);
+    EXPECT_FLOAT_EQ(ay, by);
+}
+
+// SketchPad routes camera pixels through the grid once calibrated
+TEST(HomographyTest, SketchPadCalibrationUsesGrid) {
+    SketchPad pad(1920, 1080);
+    pad.set_camera_resolution(640, 480);
+
+    // Uncalibrated: plain percentage of the camera frame
+    Point p = pad.camera_to_display(320.0f, 240.0f);
+    EXPECT_NEAR(p.x, 50.0f, 1e-4);
+    EXPECT_NEAR(p.y, 50.0f, 1e-4);
+
+    std::vector<Point> cam = {Point(10.0f, 10.0f), Point(90.0f, 10.0f), Point(90.0f, 90.0f),
+                              Point(10.0f, 90.0f), Point(50.0f, 50.0f)};
+    std::vector<Point> disp;
+    for (const auto &c : cam)
+        disp.push_back(apply_truth(c));
+    pad.set_calibration_points(cam, disp);
+    ASSERT_TRUE(pad.calibrate_projector());
+    EXPECT_TRUE(pad.get_remap_grid().valid());
+
+    p = pad.camera_to_display(320.0f, 240.0f);
+    Point t = apply_truth(Point(50.0f, 50.0f));
+    EXPECT_NEAR(p.x, t.x, 0.02f);
+    EXPECT_NEAR(p.y, t.y, 0.02f);
+}
+
+TEST(HomographyTest, LoadCalibrationFile) {
+    const char *path = "test_calibration.json";
+    {
+        std::ofstream f(path);
+        f << R"({"camera":[[0,0],[100,0],[100,100],[0,100]],"display":[[10,10],[90,10],[90,90],[10,90]]})";
+    }
+    SketchPad pad(640, 480);
+    ASSERT_TRUE(pad.load_calibration(path));
+    Point p = pad.camera_to_display(320.0f, 240.0f);
+    EXPECT_NEAR(p.x, 50.0f, 0.01f);
+    EXPECT_NEAR(p.y, 50.0f, 0.01f);
+    std::remove(path);
+
+    EXPECT_FALSE(pad.load_calibration("does_not_exist.json"));
+}
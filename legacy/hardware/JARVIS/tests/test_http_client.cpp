@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "http_client.hpp"
+#include "local_http_server.hpp"
+#include <chrono>
 #include <string>
 
 // Note: These tests are basic unit tests for HttpClient structure.
@@ -60,3 +62,300 @@ TEST_F(HttpClientTest, PathHandling) {
         client.get("127.0.0.1", 8080, "/api/test?param=value", 100);
     });
 }
+
+// Keep-alive pool, TLS resumption and DNS cache against a loopback server
+class HttpPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        HttpClient::set_pool_config(HttpPoolConfig());
+        HttpClient::reset_pool();
+    }
+    void TearDown() override {
+        HttpClient::set_pool_config(HttpPoolConfig());
+        HttpClient::reset_pool();
+    }
+
+    static test_http::Reply echo(const test_http::Request &req) {
+        return test_http::response(200, req.method + " " + req.path + " " + req.body);
+    }
+};
+
+TEST_F(HttpPoolTest, KeepAliveReusesConnection) {
+    test_http::LocalHttpServer server(echo);
+    HttpClient client;
+    for (int i = 0; i < 5; ++i) {
+        std::string path = "/dots?i=" + std::to_string(i);
+        EXPECT_EQ(client.get("127.0.0.1", server.port(), path, 1000), "GET " + path + " ");
+        EXPECT_TRUE(client.last_error().empty());
+    }
+    // A fresh client shares the pool
+    HttpClient other;
+    EXPECT_EQ(other.post("127.0.0.1", server.port(), "/save", "{\"a\":1}", "application/json", 1000),
+              "POST /save {\"a\":1}");
+
+    EXPECT_EQ(server.accepted(), 1);
+    HttpPoolStats stats = HttpClient::pool_stats();
+    EXPECT_EQ(stats.requests, 6u);
+    EXPECT_EQ(stats.connects, 1u);
+    EXPECT_EQ(stats.reuses, 5u);
+    EXPECT_EQ(stats.idle, 1u);
+}
+
+TEST_F(HttpPoolTest, LargePostBodyOnPooledConnection) {
+    test_http::LocalHttpServer server([](const test_http::Request &req) {
+        return test_http::response(200, std::to_string(req.body.size()));
+    });
+    HttpClient client;
+    std::string big(200000, 'x');
+    EXPECT_EQ(client.post("127.0.0.1", server.port(), "/save", big, "text/plain", 2000), "200000");
+    EXPECT_EQ(client.post("127.0.0.1", server.port(), "/save", "abc", "text/plain", 2000), "3");
+    EXPECT_EQ(server.accepted(), 1);
+}
+
+// A connection the server dropped while idle is replaced transparently
+TEST_F(HttpPoolTest, ServerClosedIdleConnectionIsRetried) {
+    test_http::LocalHttpServer server(echo);
+    HttpClient client;
+    ASSERT_FALSE(client.get("127.0.0.1", server.port(), "/a", 1000).empty());
+    server.close_connections();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    EXPECT_EQ(client.post("127.0.0.1", server.port(), "/b", "x", "text/plain", 1000), "POST /b x");
+    EXPECT_EQ(server.accepted(), 2);
+    EXPECT_EQ(server.requests(), 2);
+}
+
+// A timeout on a pooled connection is not a stale socket: the server may
+// already have acted on the request, so it must not be sent again
+TEST_F(HttpPoolTest, TimeoutOnPooledConnectionIsNotRetried) {
+    test_http::LocalHttpServer server([](const test_http::Request &req) {
+        if (req.path == "/slow")
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        return echo(req);
+    });
+    HttpClient client;
+    ASSERT_FALSE(client.get("127.0.0.1", server.port(), "/a", 1000).empty());
+
+    EXPECT_TRUE(client.post("127.0.0.1", server.port(), "/slow", "x", "text/plain", 100).empty());
+    EXPECT_EQ(client.last_error(), "recv timeout");
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    EXPECT_EQ(server.requests(), 2);
+    EXPECT_EQ(server.accepted(), 1);
+    EXPECT_EQ(HttpClient::pool_stats().retries, 0u);
+}
+
+TEST_F(HttpPoolTest, ConnectionCloseIsNotPooled) {
+    test_http::LocalHttpServer server([](const test_http::Request &) {
+        return test_http::response(200, "ok", "Connection: close\r\n");
+    });
+    HttpClient client;
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/", 1000), "ok");
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/", 1000), "ok");
+    EXPECT_EQ(server.accepted(), 2);
+    EXPECT_EQ(HttpClient::pool_stats().reuses, 0u);
+    EXPECT_EQ(HttpClient::pool_stats().idle, 0u);
+}
+
+TEST_F(HttpPoolTest, ChunkedAndErrorResponsesKeepConnection) {
+    test_http::LocalHttpServer server([](const test_http::Request &req) {
+        if (req.path == "/missing")
+            return test_http::response(404, "nope");
+        test_http::Reply r;
+        r.bytes = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                  "5\r\nhello\r\n7;ext=1\r\n, world\r\n0\r\nX-Trailer: 1\r\n\r\n";
+        return r;
+    });
+    HttpClient client;
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/chunked", 1000), "hello, world");
+    EXPECT_TRUE(client.get("127.0.0.1", server.port(), "/missing", 1000).empty());
+    EXPECT_EQ(client.last_error(), "HTTP error: 404 body=nope");
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/chunked", 1000), "hello, world");
+    EXPECT_EQ(server.accepted(), 1);
+}
+
+TEST_F(HttpPoolTest, KeepAliveCanBeDisabled) {
+    HttpPoolConfig config;
+    config.keep_alive = false;
+    HttpClient::set_pool_config(config);
+    test_http::LocalHttpServer server(echo);
+    HttpClient client;
+    for (int i = 0; i < 3; ++i)
+        EXPECT_EQ(client.get("127.0.0.1", server.port(), "/", 1000), "GET / ");
+    EXPECT_EQ(server.accepted(), 3);
+}
+
+TEST_F(HttpPoolTest, IdleTimeoutDropsConnection) {
+    HttpPoolConfig config;
+    config.idle_timeout_ms = 10;
+    HttpClient::set_pool_config(config);
+    test_http::LocalHttpServer server(echo);
+    HttpClient client;
+    EXPECT_FALSE(client.get("127.0.0.1", server.port(), "/", 1000).empty());
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_FALSE(client.get("127.0.0.1", server.port(), "/", 1000).empty());
+    EXPECT_EQ(server.accepted(), 2);
+}
+
+TEST_F(HttpPoolTest, DnsResultsAreCached) {
+    HttpPoolConfig config;
+    config.keep_alive = false; // force a connect per request
+    HttpClient::set_pool_config(config);
+    test_http::LocalHttpServer server(echo);
+    HttpClient client;
+    for (int i = 0; i < 3; ++i)
+        EXPECT_FALSE(client.get("localhost", server.port(), "/", 1000).empty());
+    HttpPoolStats stats = HttpClient::pool_stats();
+    EXPECT_EQ(stats.dns_lookups, 1u);
+    EXPECT_EQ(stats.dns_cache_hits, 2u);
+
+    config.dns_ttl_ms = 0;
+    HttpClient::set_pool_config(config);
+    EXPECT_FALSE(client.get("localhost", server.port(), "/", 1000).empty());
+    EXPECT_EQ(HttpClient::pool_stats().dns_lookups, 2u);
+}
+
+TEST_F(HttpPoolTest, TlsConnectionReusedAndSessionResumed) {
+    test_http::LocalHttpServer server(echo, true);
+    HttpClient client;
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/a", 2000, true), "GET /a ");
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/b", 2000, true), "GET /b ");
+    EXPECT_EQ(server.accepted(), 1);
+    EXPECT_EQ(HttpClient::pool_stats().tls_handshakes, 1u);
+
+    // A new connection resumes the cached session instead of a full handshake
+    HttpClient::close_idle_connections();
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/c", 2000, true), "GET /c ");
+    HttpPoolStats stats = HttpClient::pool_stats();
+    EXPECT_EQ(server.accepted(), 2);
+    EXPECT_EQ(stats.tls_handshakes, 2u);
+    EXPECT_EQ(stats.tls_resumed, 1u);
+}
+
+TEST_F(HttpPoolTest, StreamAndReuseBuffer) {
+    std::string payload(300000, 'p');
+    test_http::LocalHttpServer server([&](const test_http::Request &req) {
+        if (req.path == "/gone")
+            return test_http::response(410, "gone");
+        return test_http::response(200, payload);
+    });
+    HttpClient client;
+    std::string streamed;
+    size_t pieces = 0;
+    ASSERT_TRUE(client.get_stream("127.0.0.1", server.port(), "/big", [&](const char *d, size_t n) {
+        streamed.append(d, n);
+        ++pieces;
+        return true;
+    }, 2000));
+    EXPECT_EQ(streamed, payload);
+    EXPECT_GT(pieces, 1u);
+    EXPECT_EQ(client.last_status(), 200);
+
+    // Error bodies are reported through last_error(), not the callback
+    bool called = false;
+    EXPECT_FALSE(client.get_stream("127.0.0.1", server.port(), "/gone",
+                                   [&](const char *, size_t) { called = true; return true; }, 2000));
+    EXPECT_FALSE(called);
+    EXPECT_EQ(client.last_status(), 410);
+    EXPECT_EQ(client.last_error(), "HTTP error: 410 body=gone");
+
+    std::string buf;
+    ASSERT_TRUE(client.get_into("127.0.0.1", server.port(), "/big", buf, 2000));
+    EXPECT_EQ(buf, payload);
+    const char *storage = buf.data();
+    ASSERT_TRUE(client.get_into("127.0.0.1", server.port(), "/big", buf, 2000));
+    EXPECT_EQ(buf.data(), storage); // same allocation reused
+    EXPECT_EQ(buf, payload);
+    EXPECT_EQ(server.accepted(), 1);
+}
+
+// Aborting a stream drops the connection instead of pooling it half-read
+TEST_F(HttpPoolTest, AbortedStreamNotPooled) {
+    test_http::LocalHttpServer server([](const test_http::Request &) {
+        return test_http::response(200, std::string(100000, 'x'));
+    });
+    HttpClient client;
+    EXPECT_FALSE(client.get_stream("127.0.0.1", server.port(), "/", [](const char *, size_t) { return false; }, 2000));
+    EXPECT_EQ(HttpClient::pool_stats().idle, 0u);
+    EXPECT_EQ(client.get("127.0.0.1", server.port(), "/", 2000).size(), 100000u);
+    EXPECT_EQ(server.accepted(), 2);
+}
+
+// Conditional GETs: a matching ETag costs a 304 and leaves the cached copy alone
+TEST_F(HttpPoolTest, ConditionalGetShortCircuitsOn304) {
+    std::string etag = "\"v1\"";
+    std::string body = std::string(5000, 'b');
+    test_http::LocalHttpServer server([&](const test_http::Request &req) {
+        if (req.header("if-none-match") == etag)
+            return test_http::response(304, "", "ETag: " + etag + "\r\n");
+        return test_http::response(200, body,
+                                   "ETag: " + etag + "\r\nLast-Modified: Tue, 01 Sep 2026 10:00:00 GMT\r\n");
+    });
+    HttpClient client;
+    HttpValidators validators;
+    std::string out;
+    ASSERT_EQ(client.get_if_modified("127.0.0.1", server.port(), "/bp", validators, out, 2000), HttpFetch::MODIFIED);
+    EXPECT_EQ(out, body);
+    EXPECT_EQ(validators.etag, etag);
+    EXPECT_EQ(validators.last_modified, "Tue, 01 Sep 2026 10:00:00 GMT");
+    EXPECT_EQ(validators.size, body.size());
+
+    out = "cached";
+    EXPECT_EQ(client.get_if_modified("127.0.0.1", server.port(), "/bp", validators, out, 2000),
+              HttpFetch::NOT_MODIFIED);
+    EXPECT_EQ(out, "cached");
+    EXPECT_EQ(validators.etag, etag);
+    EXPECT_EQ(client.last_status(), 304);
+    EXPECT_TRUE(client.last_error().empty());
+
+    // The blueprint changed on the server
+    etag = "\"v2\"";
+    body = "{\"lines\":[]}";
+    ASSERT_EQ(client.get_if_modified("127.0.0.1", server.port(), "/bp", validators, out, 2000), HttpFetch::MODIFIED);
+    EXPECT_EQ(out, body);
+    EXPECT_EQ(validators.etag, etag);
+
+    HttpCacheStats stats = HttpClient::cache_stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.bytes_downloaded, 5000u + body.size());
+    EXPECT_EQ(stats.bytes_saved, 5000u);
+    EXPECT_EQ(server.accepted(), 1); // the 304 kept the connection
+
+    HttpClient::reset_pool();
+    EXPECT_EQ(HttpClient::cache_stats().hits, 0u);
+}
+
+TEST_F(HttpPoolTest, ConditionalGetFailureKeepsValidators) {
+    test_http::LocalHttpServer server([](const test_http::Request &) {
+        return test_http::response(500, "oops");
+    });
+    HttpClient client;
+    HttpValidators validators;
+    validators.etag = "\"v1\"";
+    validators.size = 10;
+    std::string out = "cached";
+    EXPECT_EQ(client.get_if_modified("127.0.0.1", server.port(), "/bp", validators, out, 2000), HttpFetch::FAILED);
+    EXPECT_EQ(out, "cached");
+    EXPECT_EQ(validators.etag, "\"v1\"");
+    EXPECT_EQ(HttpClient::cache_stats().misses, 0u);
+}
+
+TEST(HttpValidatorsTest, SaveLoadRoundTrip) {
+    std::string path = ::testing::TempDir() + "jarvis_validators_test.etag";
+    HttpValidators v;
+    v.etag = "W/\"abc\"";
+    v.last_modified = "Tue, 01 Sep 2026 10:00:00 GMT";
+    v.size = 1234;
+    ASSERT_TRUE(v.save(path));
+
+    HttpValidators loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_EQ(loaded.etag, v.etag);
+    EXPECT_EQ(loaded.last_modified, v.last_modified);
+    EXPECT_EQ(loaded.size, 1234u);
+
+    // Empty validators remove the file
+    ASSERT_TRUE(HttpValidators().save(path));
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_TRUE(loaded.empty());
+}
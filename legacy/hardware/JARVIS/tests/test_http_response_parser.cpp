@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+#include "http_response_parser.hpp"
+#include <string>
+
+namespace {
+
+// Feed in fixed-size pieces to exercise every split point
+size_t feed_in_pieces(HttpResponseParser &p, const std::string &raw, size_t piece) {
+    size_t used = 0;
+    while (used < raw.size() && !p.done() && !p.failed()) {
+        size_t n = std::min(piece, raw.size() - used);
+        used += p.feed(raw.data() + used, n);
+    }
+    return used;
+}
+
+} // namespace
+
+TEST(HttpResponseParserTest, ContentLengthBody) {
+    std::string raw = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 11\r\n\r\n{\"lines\":1}";
+    HttpResponseParser p;
+    EXPECT_EQ(p.feed(raw.data(), raw.size()), raw.size());
+    ASSERT_TRUE(p.done());
+    EXPECT_EQ(p.status(), 200);
+    EXPECT_EQ(p.framing(), HttpResponseParser::Framing::CONTENT_LENGTH);
+    EXPECT_EQ(p.header("content-type"), "application/json");
+    EXPECT_EQ(p.body(), "{\"lines\":1}");
+    EXPECT_TRUE(p.keep_alive());
+}
+
+TEST(HttpResponseParserTest, ChunkedAtEverySplit) {
+    std::string raw = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                      "5\r\nhello\r\n7;name=x\r\n, world\r\n0\r\nX-Checksum: 1\r\n\r\n";
+    for (size_t piece = 1; piece <= raw.size(); ++piece) {
+        HttpResponseParser p;
+        EXPECT_EQ(feed_in_pieces(p, raw, piece), raw.size()) << piece;
+        ASSERT_TRUE(p.done()) << piece;
+        EXPECT_EQ(p.body(), "hello, world") << piece;
+        EXPECT_EQ(p.framing(), HttpResponseParser::Framing::CHUNKED);
+    }
+}
+
+// The body goes to the sink as it arrives; nothing is buffered
+TEST(HttpResponseParserTest, SinkReceivesBodyAndCanAbort) {
+    std::string body(100000, 'b');
+    std::string raw = "HTTP/1.1 200 OK\r\nContent-Length: 100000\r\n\r\n" + body;
+    std::string got;
+    int calls = 0;
+    HttpResponseParser p;
+    p.set_body_sink([&](const char *d, size_t n) { got.append(d, n); ++calls; return true; });
+    feed_in_pieces(p, raw, 4096);
+    ASSERT_TRUE(p.done());
+    EXPECT_EQ(got, body);
+    EXPECT_GT(calls, 1);
+    EXPECT_TRUE(p.body().empty());
+    EXPECT_EQ(p.body_bytes(), body.size());
+
+    HttpResponseParser q;
+    q.set_body_sink([](const char *, size_t) { return false; });
+    q.feed(raw.data(), raw.size());
+    EXPECT_TRUE(q.failed());
+}
+
+// Parsing stops at the end of the message; the rest is the next response
+TEST(HttpResponseParserTest, StopsAtMessageEnd) {
+    std::string first = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+    std::string second = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+    std::string raw = first + second;
+    HttpResponseParser p;
+    size_t used = p.feed(raw.data(), raw.size());
+    EXPECT_EQ(used, first.size());
+    EXPECT_EQ(p.body(), "ok");
+
+    p.reset();
+    EXPECT_EQ(p.feed(raw.data() + used, raw.size() - used), second.size());
+    EXPECT_TRUE(p.done());
+    EXPECT_EQ(p.status(), 404);
+    EXPECT_TRUE(p.body().empty());
+}
+
+TEST(HttpResponseParserTest, BodylessResponses) {
+    std::string raw = "HTTP/1.1 304 Not Modified\r\nETag: \"abc\"\r\n\r\n";
+    HttpResponseParser p;
+    p.feed(raw.data(), raw.size());
+    EXPECT_TRUE(p.done());
+    EXPECT_EQ(p.header("etag"), "\"abc\"");
+
+    // HEAD: Content-Length describes the body that was not sent
+    std::string head = "HTTP/1.1 200 OK\r\nContent-Length: 500\r\n\r\n";
+    HttpResponseParser h(true);
+    EXPECT_EQ(h.feed(head.data(), head.size()), head.size());
+    EXPECT_TRUE(h.done());
+}
+
+TEST(HttpResponseParserTest, InterimResponseSkipped) {
+    std::string raw = "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 201 Created\r\nContent-Length: 3\r\n\r\nnew";
+    HttpResponseParser p;
+    feed_in_pieces(p, raw, 7);
+    ASSERT_TRUE(p.done());
+    EXPECT_EQ(p.status(), 201);
+    EXPECT_EQ(p.body(), "new");
+}
+
+TEST(HttpResponseParserTest, UnframedBodyEndsAtEof) {
+    std::string raw = "HTTP/1.0 200 OK\r\n\r\nuntil close";
+    HttpResponseParser p;
+    p.feed(raw.data(), raw.size());
+    EXPECT_FALSE(p.done());
+    p.finish_eof();
+    ASSERT_TRUE(p.done());
+    EXPECT_EQ(p.body(), "until close");
+    EXPECT_FALSE(p.keep_alive());
+    EXPECT_EQ(p.framing(), HttpResponseParser::Framing::UNTIL_EOF);
+}
+
+TEST(HttpResponseParserTest, ConnectionHeaders) {
+    std::string close = "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    HttpResponseParser a;
+    a.feed(close.data(), close.size());
+    EXPECT_TRUE(a.done());
+    EXPECT_FALSE(a.keep_alive());
+
+    std::string ka = "HTTP/1.0 200 OK\r\nConnection: Keep-Alive\r\nContent-Length: 0\r\n\r\n";
+    HttpResponseParser b;
+    b.feed(ka.data(), ka.size());
+    EXPECT_TRUE(b.keep_alive());
+}
+
+// A Content-Length is not trusted for allocation, and body() stays bounded
+TEST(HttpResponseParserTest, OversizedBodyFailsCleanly) {
+    std::string huge = "HTTP/1.1 200 OK\r\nContent-Length: 9223372036854775807\r\n\r\nabc";
+    HttpResponseParser p;
+    EXPECT_NO_THROW(p.feed(huge.data(), huge.size()));
+    ASSERT_TRUE(p.failed());
+    EXPECT_EQ(p.error(), "HTTP body too large");
+
+    // Within the limit the declared size only sets a small reservation
+    std::string big = "HTTP/1.1 200 OK\r\nContent-Length: 50000000\r\n\r\nabc";
+    HttpResponseParser q;
+    q.feed(big.data(), big.size());
+    EXPECT_FALSE(q.failed());
+    EXPECT_LE(q.body().capacity(), 1024u * 1024u);
+
+    auto too_large = [](const std::string &raw) {
+        HttpResponseParser r;
+        r.set_max_body(10);
+        r.feed(raw.data(), raw.size());
+        r.finish_eof();
+        return r.failed() && r.error() == "HTTP body too large";
+    };
+    EXPECT_TRUE(too_large("HTTP/1.1 200 OK\r\nContent-Length: 11\r\n\r\nhello world"));
+    EXPECT_TRUE(too_large("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n6\r\nhello \r\n5\r\nworld\r\n0\r\n\r\n"));
+    EXPECT_TRUE(too_large("HTTP/1.1 200 OK\r\n\r\nhello world"));
+    EXPECT_FALSE(too_large("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nhelloworld"));
+
+    // A sink takes whatever the server sends
+    HttpResponseParser s;
+    s.set_max_body(10);
+    size_t seen = 0;
+    s.set_body_sink([&](const char *, size_t n) {
+        seen += n;
+        return true;
+    });
+    std::string sunk = "HTTP/1.1 200 OK\r\nContent-Length: 11\r\n\r\nhello world";
+    s.feed(sunk.data(), sunk.size());
+    EXPECT_TRUE(s.done());
+    EXPECT_EQ(seen, 11u);
+}
+
+TEST(HttpResponseParserTest, MalformedInput) {
+    auto fails = [](const std::string &raw) {
+        HttpResponseParser p;
+        p.feed(raw.data(), raw.size());
+        p.finish_eof();
+        return p.failed();
+    };
+    EXPECT_TRUE(fails("garbage\r\n\r\n"));
+    EXPECT_TRUE(fails("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n"));
+    EXPECT_TRUE(fails("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nabX\r\n"));
+    EXPECT_TRUE(fails("HTTP/1.1 200 OK\r\nContent-Length: -4\r\n\r\n"));
+    EXPECT_TRUE(fails("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort"));
+    EXPECT_TRUE(fails("HTTP/1.1 200 OK\r\nX: " + std::string(20000, 'a') + "\r\n\r\n"));
+
+    HttpResponseParser p;
+    p.finish_eof();
+    EXPECT_EQ(p.error(), "connection closed");
+}
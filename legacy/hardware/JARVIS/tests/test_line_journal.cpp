@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+#include "blueprint_format.hpp"
+#include "line_journal.hpp"
+#include "sketch_pad.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sketch;
+
+namespace {
+
+const char *kDir = "line_journal_test";
+
+std::string file(const std::string &name) { return std::string(kDir) + "/" + name; }
+
+Line make_line(float x) {
+    Line l;
+    l.start = Point(x, 1.0f);
+    l.end = Point(x + 10.0f, 2.0f);
+    l.color = 0x00ABCDEFu;
+    l.thickness = 4;
+    return l;
+}
+
+long file_size(const std::string &path) {
+    struct stat st = {};
+    return stat(path.c_str(), &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+class LineJournalTest : public ::testing::Test {
+protected:
+    void SetUp() override { mkdir(kDir, 0755); }
+    void TearDown() override {
+        for (const char *n : {"j", "pad.jarvis", "pad.jarvis.sig", "pad.jarvis.journal", "pad.jarvis.compact",
+                              "pad.jarvis.journal.next", "keep.jarvis", "keep.jarvis.sig", "keep.jarvis.journal"})
+            std::remove(file(n).c_str());
+        rmdir(kDir);
+    }
+};
+
+} // namespace
+
+TEST_F(LineJournalTest, AppendAndReplay) {
+    {
+        LineJournal j;
+        ASSERT_TRUE(j.open(file("j"), "base-sig", "", nullptr));
+        j.append_line(make_line(1.0f));
+        j.append_line(make_line(2.0f));
+        j.append_clear();
+        GridConfig g;
+        g.real_world_spacing_cm = 12.5f;
+        g.snap_to_grid = false;
+        j.append_grid(g);
+        j.append_line(make_line(3.0f));
+        ASSERT_TRUE(j.sync());
+        EXPECT_EQ(j.record_count(), 5u);
+    }
+
+    LineJournal j;
+    std::vector<JournalRecord> records;
+    ASSERT_TRUE(j.open(file("j"), "base-sig", "", &records));
+    ASSERT_EQ(records.size(), 5u);
+
+    std::vector<Line> lines;
+    GridConfig grid;
+    for (const auto &r : records)
+        LineJournal::apply(r, lines, grid);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_FLOAT_EQ(lines[0].start.x, 3.0f);
+    EXPECT_EQ(lines[0].color, 0x00ABCDEFu);
+    EXPECT_EQ(lines[0].thickness, 4);
+    EXPECT_FLOAT_EQ(grid.real_world_spacing_cm, 12.5f);
+    EXPECT_FALSE(grid.snap_to_grid);
+}
+
+// A crash mid-append loses only the torn record; appends continue the chain
+TEST_F(LineJournalTest, TornTailIsTruncated) {
+    {
+        LineJournal j;
+        ASSERT_TRUE(j.open(file("j"), "sig", "key", nullptr));
+        for (int i = 0; i < 3; ++i)
+            j.append_line(make_line(static_cast<float>(i)));
+        ASSERT_TRUE(j.sync());
+    }
+    ASSERT_EQ(truncate(file("j").c_str(), file_size(file("j")) - 5), 0);
+
+    {
+        LineJournal j;
+        std::vector<JournalRecord> records;
+        ASSERT_TRUE(j.open(file("j"), "sig", "key", &records));
+        EXPECT_EQ(records.size(), 2u);
+        j.append_line(make_line(9.0f));
+        ASSERT_TRUE(j.sync());
+    }
+
+    LineJournal j;
+    std::vector<JournalRecord> records;
+    ASSERT_TRUE(j.open(file("j"), "sig", "key", &records));
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_FLOAT_EQ(records[2].x0, 9.0f);
+}
+
+TEST_F(LineJournalTest, TamperedOrForeignRecordsRejected) {
+    {
+        LineJournal j;
+        ASSERT_TRUE(j.open(file("j"), "sig", "key", nullptr));
+        for (int i = 0; i < 4; ++i)
+            j.append_line(make_line(static_cast<float>(i)));
+        ASSERT_TRUE(j.sync());
+    }
+
+    // Wrong key: nothing after the header verifies
+    {
+        LineJournal j;
+        std::vector<JournalRecord> records;
+        ASSERT_TRUE(j.open(file("j"), "sig", "other", &records));
+        EXPECT_TRUE(records.empty());
+    }
+}
+
+TEST_F(LineJournalTest, FlippedByteStopsReplay) {
+    {
+        LineJournal j;
+        ASSERT_TRUE(j.open(file("j"), "sig", "", nullptr));
+        for (int i = 0; i < 4; ++i)
+            j.append_line(make_line(static_cast<float>(i)));
+        ASSERT_TRUE(j.sync());
+    }
+    {
+        std::fstream f(file("j"), std::ios::in | std::ios::out | std::ios::binary);
+        // Inside the payload of the third record: 40-byte header, 72-byte records
+        f.seekp(40 + 2 * 72 + 20);
+        f.put('\x7f');
+    }
+    LineJournal j;
+    std::vector<JournalRecord> records;
+    ASSERT_TRUE(j.open(file("j"), "sig", "", &records));
+    EXPECT_EQ(records.size(), 2u);
+}
+
+// A journal written against another base is discarded, not replayed
+TEST_F(LineJournalTest, StaleJournalDiscarded) {
+    {
+        LineJournal j;
+        ASSERT_TRUE(j.open(file("j"), "old-base", "", nullptr));
+        j.append_line(make_line(1.0f));
+        ASSERT_TRUE(j.sync());
+    }
+    LineJournal j;
+    std::vector<JournalRecord> records;
+    ASSERT_TRUE(j.open(file("j"), "new-base", "", &records));
+    EXPECT_TRUE(records.empty());
+    EXPECT_EQ(j.record_count(), 0u);
+}
+
+// After the first full write, saves append to the journal and leave the base alone
+TEST_F(LineJournalTest, SketchPadSavesIncrementally) {
+    const std::string base = file("pad");
+    SketchPad pad(1000, 1000);
+    pad.init("pad", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.add_line(Point(10.0f, 10.0f), Point(20.0f, 20.0f));
+    ASSERT_TRUE(pad.save(base));
+    long base_size = file_size(base + ".jarvis");
+    ASSERT_GT(base_size, 0);
+
+    for (int i = 0; i < 5; ++i) {
+        pad.add_line(Point(30.0f + i, 10.0f), Point(40.0f + i, 20.0f));
+        ASSERT_TRUE(pad.save(""));
+    }
+    EXPECT_EQ(file_size(base + ".jarvis"), base_size);
+    EXPECT_EQ(pad.get_journal_records(), 5u);
+
+    pad.set_real_world_spacing(9.0f);
+    pad.clear();
+    pad.add_line(Point(50.0f, 50.0f), Point(60.0f, 70.0f));
+    ASSERT_TRUE(pad.save(""));
+    EXPECT_EQ(pad.get_journal_records(), 8u); // +clear, +line, +grid
+
+    SketchPad loaded;
+    ASSERT_TRUE(loaded.load(base));
+    ASSERT_EQ(loaded.get_stroke_count(), 1);
+    EXPECT_FLOAT_EQ(loaded.get_sketch().lines[0].end.y, 70.0f);
+    EXPECT_FLOAT_EQ(loaded.get_grid_config().real_world_spacing_cm, 9.0f);
+}
+
+// Background compaction folds the journal into the base without losing
+// lines that arrive while it runs
+TEST_F(LineJournalTest, CompactionFoldsJournal) {
+    const std::string base = file("pad");
+    SketchPad pad(1000, 1000);
+    pad.init("pad", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.set_journal_compaction(4);
+    ASSERT_TRUE(pad.save(base));
+
+    for (int i = 0; i < 40; ++i) {
+        pad.add_line(Point(1.0f + i, 10.0f), Point(1.0f + i, 90.0f));
+        ASSERT_TRUE(pad.save(""));
+    }
+    pad.wait_for_compaction();
+    EXPECT_LT(pad.get_journal_records(), 40u);
+    EXPECT_EQ(file_size(base + ".jarvis.compact"), -1);
+    EXPECT_EQ(file_size(base + ".jarvis.journal.next"), -1);
+
+    SketchPad loaded;
+    ASSERT_TRUE(loaded.load(base));
+    ASSERT_EQ(loaded.get_stroke_count(), 40);
+    for (int i = 0; i < 40; ++i)
+        EXPECT_FLOAT_EQ(loaded.get_sketch().lines[i].start.x, 1.0f + i);
+
+    // Explicit compaction empties the journal
+    ASSERT_TRUE(pad.compact());
+    EXPECT_EQ(pad.get_journal_records(), 0u);
+    ASSERT_TRUE(loaded.load(base));
+    EXPECT_EQ(loaded.get_stroke_count(), 40);
+}
+
+// Compaction stages the base and the journal for it, publishes the new
+// signature, renames the base, then adopts the journal. Lines saved while
+// it ran must survive a crash at any of those steps.
+TEST_F(LineJournalTest, InterruptedCompactionStillLoads) {
+    const std::string base = file("pad");
+    const std::string path = base + ".jarvis";
+    const std::string journal = path + ".journal";
+    SketchPad pad(1000, 1000);
+    pad.init("pad", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.add_line(Point(5.0f, 10.0f), Point(5.0f, 90.0f));
+    ASSERT_TRUE(pad.save(base));
+    for (int i = 0; i < 6; ++i) {
+        pad.add_line(Point(10.0f + i, 10.0f), Point(10.0f + i, 90.0f));
+        ASSERT_TRUE(pad.save(""));
+    }
+    const Sketch snapshot = pad.get_sketch(); // what the compactor encodes
+    // Saved while the snapshot was being staged
+    for (int i = 0; i < 2; ++i) {
+        pad.add_line(Point(50.0f + i, 10.0f), Point(50.0f + i, 90.0f));
+        ASSERT_TRUE(pad.save(""));
+    }
+    ASSERT_EQ(pad.get_journal_records(), 8u);
+    auto copy = [](const std::string &from, const std::string &to) {
+        std::ifstream in(from, std::ios::binary);
+        std::ofstream out(to, std::ios::binary | std::ios::trunc);
+        out << in.rdbuf();
+    };
+    for (const char *ext : {".jarvis", ".jarvis.sig", ".jarvis.journal"})
+        copy(base + ext, file("keep") + ext);
+
+    for (int step = 0; step < 4; ++step) {
+        for (const char *ext : {".jarvis", ".jarvis.sig", ".jarvis.journal"})
+            copy(file("keep") + ext, base + ext);
+        std::string sig;
+        ASSERT_TRUE(stage_blueprint(path + ".compact", snapshot, pad.get_grid_config(), blueprint_secret(), &sig));
+        {
+            LineJournal next;
+            ASSERT_TRUE(next.open(LineJournal::staged_path(journal), sig, blueprint_secret(), nullptr));
+            for (size_t i = 7; i < 9; ++i)
+                next.append_line(pad.get_sketch().lines[i]);
+            ASSERT_TRUE(next.sync());
+        }
+        if (step == 1) // signature published, base not yet renamed
+            EXPECT_FALSE(install_blueprint(path + ".missing", path, sig));
+        if (step >= 2) // base renamed, staged journal not yet adopted
+            ASSERT_TRUE(install_blueprint(path + ".compact", path, sig));
+        if (step == 3) { // done
+            LineJournal adopt;
+            ASSERT_TRUE(adopt.open(journal, sig, blueprint_secret(), nullptr));
+            EXPECT_EQ(adopt.record_count(), 2u);
+        }
+
+        SketchPad loaded;
+        ASSERT_TRUE(loaded.load(base)) << step;
+        ASSERT_EQ(loaded.get_stroke_count(), 9) << step;
+        EXPECT_FLOAT_EQ(loaded.get_sketch().lines[6].start.x, 15.0f) << step;
+        EXPECT_FLOAT_EQ(loaded.get_sketch().lines[8].start.x, 51.0f) << step;
+        EXPECT_NE(access(LineJournal::staged_path(journal).c_str(), F_OK), 0) << step;
+        std::remove((path + ".compact").c_str());
+    }
+}
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+#include "draw_ticker.hpp"
+#include "live_line_server.hpp"
+#include "live_lines.hpp"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace renderer;
+
+namespace {
+
+const int kW = 320;
+const int kH = 240;
+
+std::vector<SseEvent> parse_all(const std::string &text, size_t chunk) {
+    SseParser parser;
+    std::vector<SseEvent> out;
+    for (size_t i = 0; i < text.size(); i += chunk)
+        parser.feed(text.data() + i, std::min(chunk, text.size() - i),
+                    [&](const SseEvent &e) { out.push_back(e); });
+    return out;
+}
+
+LineEvent add_event(const std::string &id, int x0, int y0, int x1, int y1, uint32_t color, int thickness = 3) {
+    LineEvent e;
+    e.type = LineEvent::ADD;
+    e.id = id;
+    e.line.x0 = x0;
+    e.line.y0 = y0;
+    e.line.x1 = x1;
+    e.line.y1 = y1;
+    e.line.color = color;
+    e.line.thickness = thickness;
+    return e;
+}
+
+LineEvent remove_event(const std::string &id) {
+    LineEvent e;
+    e.type = LineEvent::REMOVE;
+    e.id = id;
+    return e;
+}
+
+// Full repaint, as a reference for partial ones
+std::vector<uint32_t> full_paint(const LiveLineSet &set) {
+    std::vector<uint32_t> fb(kW * kH, 0xDEADBEEF);
+    DirtyRect all;
+    all.add(0, 0, kW, kH);
+    paint_region(set, all, fb.data(), kW * 4, kW, kH);
+    return fb;
+}
+
+template <typename Pred>
+bool wait_for(Pred done, int ms = 5000) {
+    for (int i = 0; i < ms / 5 && !done(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return done();
+}
+
+} // namespace
+
+TEST(SseParserTest, FramingSurvivesAnySplit) {
+    const std::string text =
+        ": keep-alive\r\n"
+        "id: 7\r\nevent: add\r\ndata: {\"id\":\"a\",\r\ndata: \"x0\":1}\r\n\r\n"
+        "event: clear\ndata:\n\n"
+        "data: plain\r\r";
+    for (size_t chunk : {1u, 2u, 3u, 7u, 1000u}) {
+        std::vector<SseEvent> events = parse_all(text, chunk);
+        ASSERT_EQ(events.size(), 3u) << "chunk " << chunk;
+        EXPECT_EQ(events[0].type, "add");
+        EXPECT_EQ(events[0].id, "7");
+        EXPECT_EQ(events[0].data, "{\"id\":\"a\",\n\"x0\":1}");
+        EXPECT_EQ(events[1].type, "clear");
+        EXPECT_EQ(events[1].data, "");
+        EXPECT_EQ(events[1].id, "7"); // last id carries over
+        EXPECT_EQ(events[2].type, "message");
+        EXPECT_EQ(events[2].data, "plain");
+    }
+}
+
+TEST(LineEventTest, ParsesServerEvents) {
+    SseEvent sse;
+    sse.type = "add";
+    sse.id = "42";
+    sse.data = "{\"id\":\"l1\",\"x0\":10,\"y0\":20,\"x1\":30.7,\"y1\":40,\"thickness\":5,\"color\":\"#FF8000\"}";
+    LineEvent e;
+    ASSERT_TRUE(parse_line_event(sse, e));
+    EXPECT_EQ(e.type, LineEvent::ADD);
+    EXPECT_EQ(e.seq, 42u);
+    EXPECT_EQ(e.id, "l1");
+    EXPECT_EQ(e.line.x1, 30);
+    EXPECT_EQ(e.line.thickness, 5);
+    EXPECT_EQ(e.line.color, 0x00FF8000u);
+
+    sse.type = "snapshot";
+    sse.data = "{\"lines\":[{\"id\":\"a\",\"x0\":1},{\"x0\":2},{\"id\":7,\"y1\":3}]}";
+    ASSERT_TRUE(parse_line_event(sse, e));
+    ASSERT_EQ(e.lines.size(), 2u); // the entry without an id is skipped
+    EXPECT_EQ(e.lines[1].first, "7");
+
+    sse.type = "remove";
+    sse.data = "{}";
+    EXPECT_FALSE(parse_line_event(sse, e));
+    sse.type = "rotate";
+    sse.data = "{\"id\":\"a\"}";
+    EXPECT_FALSE(parse_line_event(sse, e));
+}
+
+TEST(LiveLineSetTest, DirtyRegionsFollowTheChange) {
+    LiveLineSet set(kW, kH);
+    DirtyRect dirty;
+    ASSERT_TRUE(set.apply(add_event("a", 10, 10, 50, 20, 0xFF0000, 3), dirty));
+    EXPECT_EQ(dirty.x0, 9);
+    EXPECT_EQ(dirty.y0, 10);
+    EXPECT_EQ(dirty.x1, 52);
+    EXPECT_EQ(dirty.y1, 21);
+
+    DirtyRect again;
+    EXPECT_FALSE(set.apply(add_event("a", 10, 10, 50, 20, 0xFF0000, 3), again));
+    EXPECT_TRUE(again.empty());
+    EXPECT_FALSE(set.apply(remove_event("missing"), again));
+    EXPECT_TRUE(again.empty());
+
+    ASSERT_TRUE(set.apply(add_event("far", 200, 200, 210, 210, 0x00FF00), again));
+    std::vector<const RenderLine *> near;
+    set.lines_in(dirty, near);
+    ASSERT_EQ(near.size(), 1u);
+    EXPECT_EQ(near[0], set.find("a"));
+
+    LineEvent clear;
+    clear.type = LineEvent::CLEAR;
+    DirtyRect cleared;
+    ASSERT_TRUE(set.apply(clear, cleared));
+    EXPECT_EQ(cleared.x1 - cleared.x0, static_cast<int>(kW));
+    EXPECT_EQ(cleared.y1 - cleared.y0, static_cast<int>(kH));
+    EXPECT_EQ(set.size(), 0u);
+}
+
+TEST(LiveLineSetTest, PartialRepaintsMatchFullRepaint) {
+    LiveLineSet set(kW, kH, 32);
+    std::vector<uint32_t> fb = full_paint(set);
+    std::vector<LineEvent> events;
+    for (int i = 0; i < 60; ++i)
+        events.push_back(add_event("l" + std::to_string(i), (i * 37) % kW, (i * 53) % kH,
+                                   (i * 91 + 40) % (kW + 40) - 20, (i * 17 + 30) % kH,
+                                   0x010101u * (i + 1), 1 + i % 6));
+    for (int i = 0; i < 60; i += 3)
+        events.push_back(remove_event("l" + std::to_string(i)));
+    events.push_back(add_event("l1", 0, 0, kW - 1, kH - 1, 0x00ABCDEF, 4)); // moved line
+
+    for (const auto &e : events) {
+        DirtyRect dirty;
+        if (set.apply(e, dirty))
+            paint_region(set, dirty, fb.data(), kW * 4, kW, kH);
+        ASSERT_EQ(fb, full_paint(set));
+    }
+    EXPECT_EQ(set.size(), 40u);
+}
+
+TEST(LiveLineSubscriberTest, FollowsAFastEventStream) {
+    test_http::LiveLineServer server;
+    server.add("seed", {0, 0, 10, 10, 2, "#FFFFFF"});
+
+    LiveConfig config;
+    config.host = "127.0.0.1";
+    config.port = server.port();
+    config.path = server.path();
+    config.wait_ms = 200;
+    LiveLineSubscriber sub(config);
+    sub.start();
+
+    // Producer at full speed while the subscriber keeps up
+    std::thread producer([&]() {
+        for (int i = 0; i < 3000; ++i) {
+            server.add("l" + std::to_string(i), {i % kW, i % kH, (i * 7) % kW, (i * 3) % kH, 1 + i % 4, "#00FF00"});
+            if (i % 5 == 0)
+                server.remove("l" + std::to_string(i / 2));
+        }
+    });
+
+    LiveLineSet set(kW, kH);
+    auto caught_up = [&]() {
+        DirtyRect dirty;
+        sub.apply(set, dirty, 20);
+        return set.size() == server.lines().size() && sub.stats().events > 1000;
+    };
+    producer.join();
+    ASSERT_TRUE(wait_for(caught_up));
+
+    for (const auto &entry : server.lines()) {
+        const RenderLine *l = set.find(entry.first);
+        ASSERT_NE(l, nullptr) << entry.first;
+        EXPECT_EQ(l->x1, entry.second.x1);
+        EXPECT_EQ(l->thickness, entry.second.thickness);
+    }
+    LiveStats stats = sub.stats();
+    EXPECT_EQ(stats.errors, 0u);
+    // Events arrive in batches, not one request each
+    EXPECT_LT(stats.requests * 10, stats.events);
+    EXPECT_EQ(server.snapshots(), 1);
+
+    // Quiet server: requests are held open, not repeated
+    int before = server.requests();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_LE(server.requests() - before, 3);
+    sub.stop();
+}
+
+TEST(LiveLineSubscriberTest, ResyncsFromSnapshot) {
+    test_http::LiveLineServer server;
+    LiveConfig config;
+    config.host = "127.0.0.1";
+    config.port = server.port();
+    config.path = server.path();
+    config.wait_ms = 100;
+    LiveLineSubscriber sub(config);
+    sub.start();
+    LiveLineSet set(kW, kH);
+
+    server.add("a", {1, 1, 5, 5, 1, "#FF0000"});
+    ASSERT_TRUE(wait_for([&]() { DirtyRect d; sub.apply(set, d, 10); return set.contains("a"); }));
+
+    // History lost on the server: the next request gets a snapshot
+    server.drop_history();
+    server.remove("a");
+    server.add("b", {2, 2, 6, 6, 1, "#00FF00"});
+    server.drop_history();
+    server.clear();
+    server.add("c", {3, 3, 7, 7, 1, "#0000FF"});
+    server.drop_history();
+    ASSERT_TRUE(wait_for([&]() { DirtyRect d; sub.apply(set, d, 10); return set.contains("c"); }));
+    EXPECT_FALSE(set.contains("a"));
+    EXPECT_FALSE(set.contains("b"));
+    EXPECT_GE(server.snapshots(), 2);
+}
+
+TEST(LiveLineSubscriberTest, ServerWithoutEventsIsUnsupported) {
+    test_http::LiveLineServer server("/other");
+    LiveConfig config;
+    config.host = "127.0.0.1";
+    config.port = server.port();
+    config.path = "/dots/events";
+    LiveLineSubscriber sub(config);
+    sub.start();
+    ASSERT_TRUE(wait_for([&]() { return sub.unsupported(); }));
+    sub.stop();
+}
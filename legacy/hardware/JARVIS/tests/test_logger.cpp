@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "logger.hpp"
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Captures logger output for assertions
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        captured.clear();
+        logger::set_sink([this](const char *data, size_t len) {
+            std::lock_guard<std::mutex> lock(mtx);
+            captured.append(data, len);
+        });
+        logger::set_default_level(logger::Level::Info);
+    }
+
+    void TearDown() override {
+        logger::flush();
+        logger::set_sink(nullptr);
+        logger::set_default_level(logger::Level::Info);
+    }
+
+    std::string output() {
+        logger::flush();
+        std::lock_guard<std::mutex> lock(mtx);
+        return captured;
+    }
+
+    size_t count(const std::string &needle) {
+        std::string out = output();
+        size_t n = 0;
+        for (size_t pos = out.find(needle); pos != std::string::npos; pos = out.find(needle, pos + 1))
+            ++n;
+        return n;
+    }
+
+    std::mutex mtx;
+    std::string captured;
+};
+
+// Records are prefixed with the module and end with a newline
+TEST_F(LoggerTest, FormatsModulePrefix) {
+    JLOG_INFO("LogFmt") << "hello " << 42;
+    JLOG_WARN("LogFmt") << "careful";
+    std::string out = output();
+    EXPECT_NE(out.find("[LogFmt] hello 42\n"), std::string::npos);
+    EXPECT_NE(out.find("[LogFmt][WARN] careful\n"), std::string::npos);
+}
+
+// Records below the module's runtime level are skipped
+TEST_F(LoggerTest, RuntimeLevelFilters) {
+    JLOG_DEBUG("LogFilter") << "hidden";
+    logger::set_level("LogFilter", logger::Level::Debug);
+    JLOG_DEBUG("LogFilter") << "shown";
+    logger::set_level("LogFilter", logger::Level::Error);
+    JLOG_WARN("LogFilter") << "also hidden";
+
+    EXPECT_EQ(count("hidden"), 0u);
+    EXPECT_EQ(count("shown"), 1u);
+}
+
+// Arguments of filtered statements are not evaluated
+TEST_F(LoggerTest, FilteredArgumentsNotEvaluated) {
+    int calls = 0;
+    auto expensive = [&calls]() { ++calls; return 1; };
+    JLOG_DEBUG("LogLazy") << expensive();
+    JLOG_TRACE("LogLazy") << expensive();
+    EXPECT_EQ(calls, 0);
+}
+
+// Spec strings set the default and per-module levels
+TEST_F(LoggerTest, ConfigureSpec) {
+    EXPECT_TRUE(logger::configure("warn,LogSpec=debug"));
+    EXPECT_EQ(logger::default_level(), logger::Level::Warn);
+
+    JLOG_DEBUG("LogSpec") << "module debug";
+    JLOG_INFO("LogOther") << "other info";
+    EXPECT_EQ(count("module debug"), 1u);
+    EXPECT_EQ(count("other info"), 0u);
+
+    EXPECT_FALSE(logger::configure("loud"));
+    logger::configure("info,LogSpec=info");
+}
+
+TEST_F(LoggerTest, ParseLevel) {
+    logger::Level lvl;
+    EXPECT_TRUE(logger::parse_level("DEBUG", lvl));
+    EXPECT_EQ(lvl, logger::Level::Debug);
+    EXPECT_TRUE(logger::parse_level(" warning ", lvl));
+    EXPECT_EQ(lvl, logger::Level::Warn);
+    EXPECT_FALSE(logger::parse_level("verbose", lvl));
+}
+
+// Every-N sites emit on the 1st, N+1th, ... call
+TEST_F(LoggerTest, EveryNRateLimits) {
+    for (int i = 0; i < 100; ++i) {
+        JLOG_EVERY_N(logger::Level::Info, "LogEveryN", 30) << "tick " << i;
+    }
+    EXPECT_EQ(count("[LogEveryN] tick"), 4u);
+    EXPECT_EQ(count("tick 0\n"), 1u);
+    EXPECT_EQ(count("tick 30\n"), 1u);
+}
+
+// Over-long records are truncated rather than overflowing
+TEST_F(LoggerTest, LongRecordTruncated) {
+    std::string big(1000, 'x');
+    JLOG_INFO("LogLong") << big;
+    std::string out = output();
+    EXPECT_LE(out.size(), logger::kMaxRecord);
+    EXPECT_EQ(out.back(), '\n');
+}
+
+// Records from many threads all arrive intact
+TEST_F(LoggerTest, MultiThreadedProducers) {
+    const int threads = 4, per_thread = 100;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                JLOG_INFO("LogMT") << "t" << t << " i" << i;
+                if (i % 50 == 49)
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (auto &th : pool)
+        th.join();
+
+    // Each thread stays under its ring capacity, so nothing is dropped
+    EXPECT_EQ(count("[LogMT] t"), static_cast<size_t>(threads * per_thread));
+}
+
+// Synchronous mode writes before the statement returns
+TEST_F(LoggerTest, SynchronousMode) {
+    logger::set_synchronous(true);
+    JLOG_INFO("LogSync") << "now";
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        EXPECT_NE(captured.find("[LogSync] now"), std::string::npos);
+    }
+    logger::set_synchronous(false);
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "motion_predictor.hpp"
+#include "sketch_pad.hpp"
+#include <chrono>
+#include <vector>
+
+using namespace sketch;
+
+namespace {
+
+const uint64_t kFrameNs = 33333333; // ~30 fps
+
+uint64_t ms(double v) { return static_cast<uint64_t>(v * 1e6); }
+
+} // namespace
+
+// Uniform motion is extrapolated exactly by the constant-velocity model
+TEST(MotionPredictorTest, ConstantVelocityExtrapolates) {
+    MotionPredictor p;
+    // 30 %/s along x, 10 %/s along y
+    for (int i = 0; i < 6; ++i) {
+        double t = i * kFrameNs * 1e-9;
+        p.add_sample(10.0f + 30.0f * t, 20.0f + 10.0f * t, 1000000000ull + i * kFrameNs);
+    }
+
+    float x, y;
+    uint64_t last = p.last_timestamp_ns();
+    ASSERT_TRUE(p.predict(last + ms(50), x, y));
+    double t = 5 * kFrameNs * 1e-9 + 0.05;
+    EXPECT_NEAR(x, 10.0 + 30.0 * t, 1e-3);
+    EXPECT_NEAR(y, 20.0 + 10.0 * t, 1e-3);
+}
+
+// Accelerating motion needs the quadratic model
+TEST(MotionPredictorTest, ConstantAccelerationModel) {
+    PredictorConfig cfg;
+    cfg.model = PredictionModel::CONSTANT_ACCELERATION;
+    cfg.max_overshoot_percent = 100.0f;
+    MotionPredictor p(cfg);
+
+    auto pos = [](double t) { return 5.0 + 10.0 * t + 40.0 * t * t; };
+    for (int i = 0; i < 6; ++i) {
+        double t = i * kFrameNs * 1e-9;
+        p.add_sample(static_cast<float>(pos(t)), 50.0f, 1000000000ull + i * kFrameNs);
+    }
+
+    float x, y;
+    ASSERT_TRUE(p.predict(p.last_timestamp_ns() + ms(60), x, y));
+    double t = 5 * kFrameNs * 1e-9 + 0.06;
+    EXPECT_NEAR(x, pos(t), 1e-2);
+    EXPECT_NEAR(y, 50.0f, 1e-3);
+}
+
+// Prediction never strays further than the overshoot limit
+TEST(MotionPredictorTest, OvershootClamp) {
+    PredictorConfig cfg;
+    cfg.max_overshoot_percent = 2.0f;
+    MotionPredictor p(cfg);
+    // Very fast: 300 %/s
+    for (int i = 0; i < 4; ++i)
+        p.add_sample(10.0f + 10.0f * i, 10.0f, 1000000000ull + i * kFrameNs);
+
+    float x, y;
+    ASSERT_TRUE(p.predict(p.last_timestamp_ns() + ms(100), x, y));
+    EXPECT_NEAR(x, 40.0f + 2.0f, 1e-3);
+    EXPECT_NEAR(y, 10.0f, 1e-3);
+}
+
+// The horizon is capped even if the caller asks for a distant time
+TEST(MotionPredictorTest, HorizonClamp) {
+    PredictorConfig cfg;
+    cfg.max_horizon_ms = 40.0f;
+    cfg.max_overshoot_percent = 100.0f;
+    MotionPredictor p(cfg);
+    for (int i = 0; i < 4; ++i)
+        p.add_sample(10.0f * i * kFrameNs * 1e-9f, 0.0f, 1000000000ull + i * kFrameNs);
+
+    float x, y;
+    ASSERT_TRUE(p.predict(p.last_timestamp_ns() + ms(1000), x, y));
+    EXPECT_NEAR(x, 10.0 * (3 * kFrameNs * 1e-9 + 0.04), 1e-3);
+}
+
+// A long gap discards old samples; a single sample is not enough
+TEST(MotionPredictorTest, StaleHistoryReset) {
+    MotionPredictor p;
+    float x, y;
+    EXPECT_FALSE(p.predict(0, x, y));
+
+    p.add_sample(10.0f, 10.0f, 1000000000ull);
+    p.add_sample(11.0f, 10.0f, 1000000000ull + kFrameNs);
+    EXPECT_EQ(p.size(), 2u);
+
+    p.add_sample(80.0f, 80.0f, 1000000000ull + ms(1000));
+    EXPECT_EQ(p.size(), 1u);
+    EXPECT_FALSE(p.predict(p.last_timestamp_ns() + ms(30), x, y));
+
+    // Duplicate timestamps are ignored
+    p.add_sample(81.0f, 80.0f, p.last_timestamp_ns());
+    EXPECT_EQ(p.size(), 1u);
+}
+
+TEST(MotionPredictorTest, LatencyEstimatorSmooths) {
+    LatencyEstimator est(0.5f);
+    EXPECT_FALSE(est.has_estimate());
+    est.observe(ms(40));
+    EXPECT_EQ(est.latency_ns(), ms(40));
+    est.observe(ms(60));
+    EXPECT_EQ(est.latency_ns(), ms(50));
+    est.set_extra_ns(ms(10));
+    EXPECT_EQ(est.latency_ns(), ms(60));
+    est.reset();
+    EXPECT_EQ(est.latency_ns(), ms(10));
+}
+
+// With timestamps, the SketchPad preview leads the smoothed position
+TEST(MotionPredictorTest, SketchPadPreviewLeadsFinger) {
+    SketchPad pad(1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.set_display_latency_ms(50.0f);
+
+    auto hand_at = [](int x, int y) {
+        hand_detector::HandDetection h;
+        h.gesture = hand_detector::Gesture::POINTING;
+        h.bbox.confidence = 0.9f;
+        h.fingertips.push_back(hand_detector::Point(x, y));
+        return std::vector<hand_detector::HandDetection>{h};
+    };
+
+    uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    uint64_t t = now - 20 * kFrameNs;
+
+    // Lock START with a steady finger
+    for (int i = 0; i < 3; ++i, t += kFrameNs)
+        pad.update(hand_at(200, 500), t);
+    ASSERT_EQ(pad.get_state(), DrawingState::START_CONFIRMED);
+
+    // Then start sweeping right at 40 px/frame
+    int x = 200;
+    for (int i = 0; i < 2; ++i, t += kFrameNs) {
+        x += 40;
+        pad.update(hand_at(x, 500), t);
+    }
+    ASSERT_TRUE(pad.has_preview());
+
+    // Raw finger is at x% = 28; the preview is ahead of it
+    EXPECT_GT(pad.get_preview_end_point().x, 28.0f);
+    EXPECT_GT(pad.get_latency_estimate_ns(), ms(50));
+
+    // Without compensation the preview trails the finger
+    SketchPad lagging(1000, 1000);
+    lagging.set_grid_enabled(false);
+    lagging.enable_latency_compensation(false);
+    t = now - 20 * kFrameNs;
+    for (int i = 0; i < 3; ++i, t += kFrameNs)
+        lagging.update(hand_at(200, 500), t);
+    x = 200;
+    for (int i = 0; i < 2; ++i, t += kFrameNs) {
+        x += 40;
+        lagging.update(hand_at(x, 500), t);
+    }
+    EXPECT_LT(lagging.get_preview_end_point().x, pad.get_preview_end_point().x);
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "persist_worker.hpp"
+#include "sketch_pad.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sketch;
+
+namespace {
+
+const char *kDir = "persist_worker_test";
+
+std::string base_of(const std::string &name) { return std::string(kDir) + "/" + name; }
+
+void remove_blueprint(const std::string &name) {
+    std::string path = base_of(name) + ".jarvis";
+    for (const char *suffix : {"", ".sig", ".journal"})
+        std::remove((path + suffix).c_str());
+}
+
+class PersistWorkerTest : public ::testing::Test {
+protected:
+    void SetUp() override { mkdir(kDir, 0755); }
+    void TearDown() override {
+        for (const char *n : {"async", "burst", "upload", "stale"})
+            remove_blueprint(n);
+        rmdir(kDir);
+    }
+};
+
+// Holds the worker inside the uploader until released
+struct Gate {
+    std::mutex m;
+    std::condition_variable cv;
+    bool open = false;
+    std::atomic<int> entered{0};
+
+    void wait() {
+        ++entered;
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] { return open; });
+    }
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            open = true;
+        }
+        cv.notify_all();
+    }
+};
+
+} // namespace
+
+// With a worker attached, save() snapshots and returns; the write lands later
+TEST_F(PersistWorkerTest, SavesOffThread) {
+    PersistWorker worker;
+    SketchPad pad(1000, 1000);
+    pad.init("async", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.set_persist_worker(&worker);
+
+    pad.add_line(Point(10.0f, 10.0f), Point(20.0f, 20.0f));
+    ASSERT_TRUE(pad.save(base_of("async")));
+    // Drawing continues against the live sketch; the snapshot is unaffected
+    pad.add_line(Point(30.0f, 30.0f), Point(40.0f, 40.0f));
+    worker.flush();
+
+    auto results = worker.take_results();
+    ASSERT_FALSE(results.empty());
+    EXPECT_TRUE(results.back().saved);
+    EXPECT_FALSE(results.back().upload_attempted);
+
+    SketchPad loaded;
+    ASSERT_TRUE(loaded.load(base_of("async")));
+    EXPECT_GE(loaded.get_stroke_count(), 1);
+
+    ASSERT_TRUE(pad.save(""));
+    worker.flush();
+    ASSERT_TRUE(loaded.load(base_of("async")));
+    EXPECT_EQ(loaded.get_stroke_count(), 2);
+    EXPECT_TRUE(worker.take_results().back().saved);
+}
+
+// Saves queued behind a slow write collapse into one write of the newest content
+TEST_F(PersistWorkerTest, CoalescesQueuedSaves) {
+    Gate gate;
+    PersistWorker worker([&gate](const std::string &, const std::string &) {
+        gate.wait();
+        return true;
+    });
+    SketchPad pad(1000, 1000);
+    pad.init("burst", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.set_persist_worker(&worker);
+
+    ASSERT_TRUE(pad.save(base_of("burst")));
+    while (gate.entered == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // The worker is busy uploading; these pile up behind it
+    for (int i = 0; i < 10; ++i) {
+        pad.add_line(Point(1.0f + i, 10.0f), Point(1.0f + i, 90.0f));
+        ASSERT_TRUE(pad.save(""));
+    }
+    EXPECT_EQ(worker.pending(), 1u);
+    EXPECT_EQ(worker.coalesced(), 9u);
+
+    gate.release();
+    worker.flush();
+    auto results = worker.take_results();
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[1].requests, 10u);
+    EXPECT_EQ(results[1].lines, 10u);
+    EXPECT_TRUE(results[1].uploaded);
+    EXPECT_EQ(worker.writes(), 2u);
+
+    SketchPad loaded;
+    ASSERT_TRUE(loaded.load(base_of("burst")));
+    EXPECT_EQ(loaded.get_stroke_count(), 10);
+}
+
+// The uploader receives the signed JSON export of the saved snapshot
+TEST_F(PersistWorkerTest, UploadsSnapshotJson) {
+    std::string uploaded_name, uploaded_json;
+    PersistWorker worker([&](const std::string &name, const std::string &json) {
+        uploaded_name = name;
+        uploaded_json = json;
+        return false; // server unreachable
+    });
+    SketchPad pad(1000, 1000);
+    pad.init("upload", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.set_persist_worker(&worker);
+    pad.add_line(Point(10.0f, 10.0f), Point(60.0f, 10.0f));
+    ASSERT_TRUE(pad.save(base_of("upload")));
+    std::string expected = pad.export_json();
+    worker.flush();
+
+    EXPECT_EQ(uploaded_name, "upload");
+    EXPECT_EQ(uploaded_json, expected);
+    auto results = worker.take_results();
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_TRUE(results[0].saved);
+    EXPECT_TRUE(results[0].upload_attempted);
+    EXPECT_FALSE(results[0].uploaded);
+}
+
+// An older snapshot never overwrites content saved after it
+TEST_F(PersistWorkerTest, StaleSnapshotSkipped) {
+    SketchPad pad(1000, 1000);
+    pad.init("stale", 1000, 1000);
+    pad.set_grid_enabled(false);
+    pad.add_line(Point(10.0f, 10.0f), Point(20.0f, 20.0f));
+    auto older = pad.snapshot_for_save(base_of("stale"));
+    pad.add_line(Point(30.0f, 30.0f), Point(40.0f, 40.0f));
+    auto newer = pad.snapshot_for_save("");
+
+    ASSERT_TRUE(pad.persist_snapshot(newer));
+    ASSERT_TRUE(pad.persist_snapshot(older));
+
+    SketchPad loaded;
+    ASSERT_TRUE(loaded.load(base_of("stale")));
+    EXPECT_EQ(loaded.get_stroke_count(), 2);
+}
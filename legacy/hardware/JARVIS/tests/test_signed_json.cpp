@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include "signed_json.hpp"
+#include "sketch_pad.hpp"
+#include "crypto.hpp"
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+using namespace sketch;
+using json = nlohmann::json;
+
+namespace {
+
+// Reference: what tools/recompute_sig computes
+std::string reference_signature(json j, const std::string &secret) {
+    j.erase("signature");
+    std::vector<uint8_t> cbor = json::to_cbor(j);
+    std::string payload(cbor.begin(), cbor.end());
+    return secret.empty() ? crypto::sha256_hex(payload) : crypto::hmac_sha256_hex(payload, secret);
+}
+
+std::string sign(json j, const std::string &secret) {
+    j["signature"] = reference_signature(j, secret);
+    return j.dump(2) + "\n";
+}
+
+SignedJsonResult read(const std::string &text, const std::string &secret, Sketch &s, GridConfig &g) {
+    return read_signed_json_blueprint(text.data(), text.size(), secret, 3, s, g);
+}
+
+json sample_blueprint() {
+    json j;
+    j["name"] = "streamed";
+    j["width"] = 1920;
+    j["height"] = 1080;
+    j["created_timestamp"] = 1700000000123ull;
+    j["grid"] = {{"grid_spacing_percent", 2.5}, {"real_world_spacing_cm", 0.1},
+                 {"snap_to_grid", false}, {"show_measurements", true}};
+    j["lines"] = json::array();
+    for (int i = 0; i < 40; ++i)
+        j["lines"].push_back({{"x0", i * 0.5}, {"y0", 1.0 / (i + 1)}, {"x1", 99.75}, {"y1", i},
+                              {"color", 0x00112233 + i}, {"thickness", i % 5 + 1}});
+    return j;
+}
+
+} // namespace
+
+// The incremental digest matches one-shot hashing for both modes
+TEST(SignedJsonTest, DigestStreamMatchesOneShot) {
+    std::string data(10000, 'x');
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<char>(i * 31);
+    for (const std::string &key : {std::string(), std::string("secret"), std::string(100, 'k')}) {
+        crypto::DigestStream d(key);
+        for (size_t off = 0; off < data.size(); off += 7)
+            d.update(data.data() + off, std::min<size_t>(7, data.size() - off));
+        EXPECT_EQ(d.final_hex(), key.empty() ? crypto::sha256_hex(data) : crypto::hmac_sha256_hex(data, key));
+    }
+}
+
+// Every CBOR shape the encoder can emit agrees with json::to_cbor
+TEST(SignedJsonTest, CborDigestMatchesToCbor) {
+    json j;
+    j["ints"] = {0, 23, 24, 255, 256, 65535, 65536, 4294967295ull, 4294967296ull,
+                 -1, -24, -25, -256, -257, -65537, -4294967297ll, std::numeric_limits<int64_t>::min()};
+    j["floats"] = {0.0, -0.5, 1.5, 0.1, 1e300, -3.4e38, 16777217.0};
+    j["strings"] = {"", "short", std::string(24, 'a'), std::string(300, 'b'), std::string(70000, 'c'), "café \"q\"\n"};
+    j["nested"] = {{"a", json::array()}, {"b", {{"c", nullptr}, {"d", true}, {"e", false}}}};
+    j["big_array"] = json::array();
+    for (int i = 0; i < 300; ++i)
+        j["big_array"].push_back(i);
+
+    std::string text = sign(j, "");
+    Sketch s;
+    GridConfig g;
+    EXPECT_EQ(read(text, "", s, g), SignedJsonResult::OK);
+}
+
+TEST(SignedJsonTest, ReadsBlueprintFields) {
+    std::string text = sign(sample_blueprint(), "k");
+    Sketch s;
+    GridConfig g;
+    g.enabled = false;
+    ASSERT_EQ(read(text, "k", s, g), SignedJsonResult::OK);
+    EXPECT_EQ(s.name, "streamed");
+    EXPECT_EQ(s.width, 1920u);
+    EXPECT_EQ(s.created_timestamp, 1700000000123ull);
+    EXPECT_TRUE(g.enabled);
+    EXPECT_FALSE(g.snap_to_grid);
+    EXPECT_FLOAT_EQ(g.real_world_spacing_cm, 0.1f);
+    ASSERT_EQ(s.lines.size(), 40u);
+    EXPECT_FLOAT_EQ(s.lines[3].start.x, 1.5f);
+    EXPECT_FLOAT_EQ(s.lines[3].end.y, 3.0f);
+    EXPECT_EQ(s.lines[3].color, 0x00112236u);
+    EXPECT_EQ(s.lines[3].thickness, 4);
+
+    // Wrong key fails and leaves the outputs untouched
+    Sketch other;
+    EXPECT_EQ(read(text, "other", other, g), SignedJsonResult::BAD_SIGNATURE);
+    EXPECT_TRUE(other.lines.empty());
+}
+
+TEST(SignedJsonTest, RejectsTamperedAndUnsigned) {
+    std::string text = sign(sample_blueprint(), "");
+    Sketch s;
+    GridConfig g;
+
+    std::string tampered = text;
+    tampered.replace(tampered.find("99.75"), 5, "99.76");
+    EXPECT_EQ(read(tampered, "", s, g), SignedJsonResult::BAD_SIGNATURE);
+
+    json unsigned_doc = sample_blueprint();
+    EXPECT_EQ(read(unsigned_doc.dump(), "", s, g), SignedJsonResult::MISSING_SIGNATURE);
+    unsigned_doc["signature"] = 42;
+    EXPECT_EQ(read(unsigned_doc.dump(), "", s, g), SignedJsonResult::MISSING_SIGNATURE);
+    EXPECT_EQ(read("{\"lines\": [", "", s, g), SignedJsonResult::PARSE_ERROR);
+
+    json bad = sample_blueprint();
+    bad["width"] = "wide";
+    EXPECT_EQ(read(sign(bad, ""), "", s, g), SignedJsonResult::BAD_FIELD);
+}
+
+// Hand-edited key order and duplicate keys verify as the DOM would see them
+TEST(SignedJsonTest, UnsortedAndDuplicateKeys) {
+    json j = {{"name", "x"}, {"width", 10}, {"lines", json::array()}};
+    std::string sig = reference_signature(j, "");
+    std::string text = "{\"width\": 99, \"signature\": \"" + sig +
+                       "\", \"lines\": [], \"name\": \"x\", \"width\": 10}";
+    Sketch s;
+    GridConfig g;
+    ASSERT_EQ(read(text, "", s, g), SignedJsonResult::OK);
+    EXPECT_EQ(s.width, 10u);
+}
+
+// export_json() signs without building CBOR and still matches the reference
+TEST(SignedJsonTest, ExportMatchesRecomputeSig) {
+    SketchPad pad(800, 600);
+    pad.init("export", 800, 600);
+    pad.set_real_world_spacing(2.54f);
+    pad.add_line(Point(0.1f, 33.3f), Point(66.7f, 99.9f));
+    pad.add_line(Point(12.0f, 12.0f), Point(48.0f, 12.0f));
+
+    json j = json::parse(pad.export_json());
+    EXPECT_EQ(j["signature"].get<std::string>(), reference_signature(j, ""));
+
+    std::string text = j.dump(2);
+    Sketch s;
+    GridConfig g;
+    ASSERT_EQ(read(text, "", s, g), SignedJsonResult::OK);
+    ASSERT_EQ(s.lines.size(), 2u);
+    EXPECT_FLOAT_EQ(s.lines[0].end.y, pad.get_sketch().lines[0].end.y);
+    EXPECT_FLOAT_EQ(s.lines[1].start.x, pad.get_sketch().lines[1].start.x);
+}
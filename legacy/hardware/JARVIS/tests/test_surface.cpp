@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include "surface.hpp"
+#include "worker_pool.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace sketch;
+
+namespace {
+
+std::vector<hand_detector::HandDetection> hand_at(int x, int y) {
+    hand_detector::HandDetection h;
+    h.gesture = hand_detector::Gesture::POINTING;
+    h.bbox.confidence = 0.9f;
+    h.fingertips.push_back(hand_detector::Point(x, y));
+    return {h};
+}
+
+std::vector<hand_detector::HandDetection> open_palm() {
+    auto hands = hand_at(0, 0);
+    hands[0].gesture = hand_detector::Gesture::OPEN_PALM;
+    hands[0].fingertips.clear();
+    return hands;
+}
+
+} // namespace
+
+// Two pads in one process must not share gesture-lock state
+TEST(SurfaceTest, SketchPadsAreIsolated) {
+    SketchPad a(1000, 1000), b(1000, 1000);
+    a.set_grid_enabled(false);
+    b.set_grid_enabled(false);
+    a.enable_latency_compensation(false);
+    b.enable_latency_compensation(false);
+
+    for (int i = 0; i < 3; ++i)
+        a.update(hand_at(200, 200));
+    ASSERT_EQ(a.get_state(), DrawingState::START_CONFIRMED);
+
+    // b never saw a hand, and feeding it frames does not advance a
+    EXPECT_EQ(b.get_state(), DrawingState::WAITING_FOR_START);
+    for (int i = 0; i < 3; ++i)
+        b.update(open_palm());
+    EXPECT_EQ(b.get_state(), DrawingState::WAITING_FOR_START);
+    EXPECT_EQ(a.get_state(), DrawingState::START_CONFIRMED);
+
+    // Locking START on b starts from scratch rather than reusing a's lock
+    b.update(hand_at(800, 800));
+    EXPECT_EQ(b.get_state(), DrawingState::WAITING_FOR_START);
+}
+
+// update() on one thread while another renders must not tear or crash
+TEST(SurfaceTest, ConcurrentUpdateAndRender) {
+    SketchPad pad(320, 240);
+    pad.set_confirmation_frames(1);
+    std::vector<uint32_t> buffer(320 * 240);
+    std::atomic<bool> done{false};
+
+    std::thread renderer([&] {
+        while (!done.load())
+            pad.render(buffer.data(), 320 * 4, 320, 240);
+    });
+    for (int i = 0; i < 300; ++i) {
+        pad.update(i % 2 ? hand_at(40 + i % 200, 100) : open_palm());
+        if (i % 50 == 0)
+            pad.add_line(Point(10.0f, 10.0f), Point(60.0f, 60.0f));
+    }
+    done = true;
+    renderer.join();
+    EXPECT_GE(pad.get_sketch_copy().lines.size(), 6u);
+}
+
+TEST(SurfaceTest, WorkerPoolRunsAllTasks) {
+    jarvis::WorkerPool pool(3);
+    EXPECT_EQ(pool.size(), 3u);
+    std::atomic<int> sum{0};
+    for (int i = 1; i <= 100; ++i)
+        ASSERT_TRUE(pool.submit([&sum, i] { sum += i; }));
+    pool.wait_idle();
+    EXPECT_EQ(sum.load(), 5050);
+
+    // Exceptions are contained to the task
+    ASSERT_TRUE(pool.submit([] { throw std::runtime_error("boom"); }));
+    pool.wait_idle();
+
+    pool.shutdown();
+    EXPECT_FALSE(pool.submit([] {}));
+}
+
+TEST(SurfaceTest, SplitViewports) {
+    SurfaceConfig base;
+    base.name = "table";
+    auto cfgs = MultiSurfaceRunner::split_viewports(base, 3, 1921, 1080);
+    ASSERT_EQ(cfgs.size(), 3u);
+    EXPECT_EQ(cfgs[0].name, "table_0");
+    EXPECT_EQ(cfgs[2].camera.camera_index, 2);
+    EXPECT_EQ(cfgs[1].viewport_x, 640u);
+    EXPECT_EQ(cfgs[2].viewport_x + cfgs[2].viewport_width, 1921u);
+    EXPECT_EQ(cfgs[2].viewport_height, 1080u);
+}
+
+// Surfaces step on the shared pool and draw only inside their viewport
+TEST(SurfaceTest, RunnerStepsAndRendersViewports) {
+    const uint32_t w = 64, h = 32;
+    SurfaceConfig base;
+    base.name = "surface_test";
+    base.camera.width = 32;
+    base.camera.height = 32;
+    base.detector.enable_threading = false;
+
+    MultiSurfaceRunner runner(2);
+    for (const auto &cfg : MultiSurfaceRunner::split_viewports(base, 2, w, h)) {
+        Surface &s = runner.add_surface(cfg);
+        s.pad().set_grid_enabled(false);
+    }
+
+    // Blank frames from a synthetic source instead of a camera
+    camera::Frame frame;
+    frame.width = 32;
+    frame.height = 32;
+    frame.stride = 32 * 3;
+    frame.format = camera::PixelFormat::RGB888;
+    frame.data.assign(32 * 32 * 3, 0);
+    frame.size = frame.data.size();
+    for (size_t i = 0; i < runner.size(); ++i)
+        runner.surface(i).set_frame_source([&frame] { return &frame; });
+
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(runner.pump(), 2u);
+        runner.wait_idle();
+    }
+    EXPECT_EQ(runner.surface(0).frames_processed(), 5u);
+    EXPECT_EQ(runner.surface(1).frames_processed(), 5u);
+
+    // A line on the right-hand surface only touches the right half
+    runner.surface(1).pad().add_line(Point(10.0f, 50.0f), Point(90.0f, 50.0f));
+    std::vector<uint32_t> buffer(w * h, 0x00123456);
+    runner.render_all(buffer.data(), w * 4, w, h);
+
+    bool left_drawn = false, right_drawn = false;
+    for (uint32_t y = 0; y < h; ++y) {
+        for (uint32_t x = 0; x < w; ++x) {
+            uint32_t px = buffer[y * w + x];
+            EXPECT_NE(px, 0x00123456u) << "viewport not cleared at " << x << "," << y;
+            if (px != 0)
+                (x < w / 2 ? left_drawn : right_drawn) = true;
+        }
+    }
+    EXPECT_FALSE(left_drawn);
+    EXPECT_TRUE(right_drawn);
+    runner.stop();
+}
+
+// Capture failures are counted per surface
+TEST(SurfaceTest, CaptureFailureCounted) {
+    SurfaceConfig cfg;
+    cfg.name = "surface_fail";
+    cfg.viewport_width = 16;
+    cfg.viewport_height = 16;
+    Surface s(cfg);
+    s.set_frame_source([]() -> const camera::Frame * { return nullptr; });
+    EXPECT_FALSE(s.step());
+    EXPECT_EQ(s.capture_failures(), 1u);
+    EXPECT_EQ(s.frames_processed(), 0u);
+}
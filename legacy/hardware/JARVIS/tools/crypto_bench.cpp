@@ -0,0 +1,118 @@
+// crypto_bench.cpp
+// Measures the per-request crypto cost: encrypting the device and blueprint
+// IDs for a fetch, and HMAC-signing a blueprint payload.
+// Usage: crypto_bench [count] [payload_bytes]
+// Each case is also run the pre-cache way (new cipher context and key
+// derivation per call, HMAC() one-shot, ostringstream hex) for comparison.
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include "../include/crypto.hpp"
+
+namespace
+{
+    std::string stream_hex(const unsigned char *data, size_t len)
+    {
+        std::ostringstream oss;
+        for (size_t i = 0; i < len; ++i)
+            oss << std::hex << std::setw(2) << std::setfill('0') << (int)data[i];
+        return oss.str();
+    }
+
+    std::string uncached_encrypt(const std::string &plaintext, const std::string &secret)
+    {
+        unsigned char key[32];
+        SHA256(reinterpret_cast<const unsigned char *>(secret.data()), secret.size(), key);
+        unsigned char iv[16];
+        RAND_bytes(iv, sizeof(iv));
+        EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+        std::vector<unsigned char> out(plaintext.size() + 16);
+        int len = 0, total = 0;
+        EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), nullptr, key, iv);
+        EVP_EncryptUpdate(ctx, out.data(), &len, reinterpret_cast<const unsigned char *>(plaintext.data()),
+                          static_cast<int>(plaintext.size()));
+        total = len;
+        EVP_EncryptFinal_ex(ctx, out.data() + len, &len);
+        total += len;
+        EVP_CIPHER_CTX_free(ctx);
+        return stream_hex(iv, sizeof(iv)) + stream_hex(out.data(), total);
+    }
+
+    std::string uncached_hmac(const std::string &data, const std::string &key)
+    {
+        unsigned int len = EVP_MAX_MD_SIZE;
+        unsigned char out[EVP_MAX_MD_SIZE];
+        HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+             reinterpret_cast<const unsigned char *>(data.data()), data.size(), out, &len);
+        return stream_hex(out, len);
+    }
+
+    template <typename Fn>
+    double ns_per_op(int count, Fn fn)
+    {
+        size_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i)
+            sink += fn().size();
+        auto end = std::chrono::steady_clock::now();
+        if (sink == 0)
+            std::cerr << "no output\n";
+        return std::chrono::duration<double, std::nano>(end - start).count() / count;
+    }
+
+    void report(const char *name, double before, double after)
+    {
+        std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(10) << before << " ns" << std::setw(10) << after << " ns"
+                  << std::setprecision(1) << std::setw(8) << before / after << "x\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 100000;
+    size_t payload_bytes = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : 256;
+    const std::string secret = "workstation-shared-secret";
+    const std::string device_id = "workstation-001";
+    const std::string blueprint = "kitchen-layout-v2";
+    const std::string payload(payload_bytes, 'x');
+
+    std::cout << std::left << std::setw(26) << "case" << std::right << std::setw(13) << "uncached"
+              << std::setw(13) << "now" << std::setw(9) << "speedup" << "\n";
+
+    // What a fetch does: both IDs encrypted with the same secret
+    double enc_before = ns_per_op(count, [&]() {
+        return uncached_encrypt(device_id, secret) + uncached_encrypt(blueprint, secret);
+    });
+    double enc_after = ns_per_op(count, [&]() {
+        return crypto::aes256_encrypt(device_id, secret) + crypto::aes256_encrypt(blueprint, secret);
+    });
+    report("fetch ID encryption", enc_before, enc_after);
+
+    double hmac_before = ns_per_op(count, [&]() { return uncached_hmac(payload, secret); });
+    double hmac_after = ns_per_op(count, [&]() { return crypto::hmac_sha256_hex(payload, secret); });
+    report("hmac_sha256_hex", hmac_before, hmac_after);
+
+    crypto::Hmac hmac(secret);
+    double hmac_ctx = ns_per_op(count, [&]() {
+        hmac.update(payload.data(), payload.size());
+        return hmac.final_hex();
+    });
+    report("Hmac (caller-held)", hmac_before, hmac_ctx);
+
+    double hex_before = ns_per_op(count, [&]() {
+        return stream_hex(reinterpret_cast<const unsigned char *>(payload.data()), payload.size());
+    });
+    double hex_after = ns_per_op(count, [&]() { return crypto::to_hex(payload.data(), payload.size()); });
+    report("hex encode", hex_before, hex_after);
+    return 0;
+}
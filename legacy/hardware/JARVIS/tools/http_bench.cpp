@@ -0,0 +1,77 @@
+// http_bench.cpp
+// Measures HttpClient request latency against a running server.
+// Usage: http_bench <host> <port> <path> [count] [--tls] [--no-keepalive]
+// --no-keepalive opens a connection per request (the pre-pool behaviour);
+// otherwise requests share the keep-alive pool.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/http_client.hpp"
+
+int main(int argc, char **argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "Usage: http_bench <host> <port> <path> [count] [--tls] [--no-keepalive]\n";
+        return 2;
+    }
+    std::string host = argv[1];
+    uint16_t port = static_cast<uint16_t>(std::atoi(argv[2]));
+    std::string path = argv[3];
+    int count = 200;
+    bool tls = false;
+    HttpPoolConfig config;
+    for (int i = 4; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--tls") == 0)
+            tls = true;
+        else if (std::strcmp(argv[i], "--no-keepalive") == 0)
+        {
+            config.keep_alive = false;
+            config.dns_ttl_ms = 0;
+        }
+        else
+            count = std::max(1, std::atoi(argv[i]));
+    }
+    HttpClient::set_pool_config(config);
+
+    std::vector<double> us;
+    us.reserve(count);
+    int failures = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        HttpClient client; // a client per request, as renderer::render_frame does
+        auto start = std::chrono::steady_clock::now();
+        std::string body = client.get(host, port, path, 3000, tls);
+        auto end = std::chrono::steady_clock::now();
+        if (body.empty())
+        {
+            ++failures;
+            continue;
+        }
+        us.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    if (us.empty())
+    {
+        std::cerr << "All " << count << " requests failed\n";
+        return 1;
+    }
+    std::sort(us.begin(), us.end());
+    double sum = 0;
+    for (double v : us)
+        sum += v;
+    HttpPoolStats stats = HttpClient::pool_stats();
+    std::cout << "requests=" << us.size() << " failed=" << failures
+              << " mean_us=" << sum / us.size()
+              << " p50_us=" << us[us.size() / 2]
+              << " p95_us=" << us[us.size() * 95 / 100]
+              << " connects=" << stats.connects
+              << " tls_handshakes=" << stats.tls_handshakes
+              << " tls_resumed=" << stats.tls_resumed << "\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+// jarvis_store.cpp
+// Maintenance for a whole blueprint directory, one file per core.
+// Usage: jarvis_store [options] [dir]            (dir defaults to blueprints)
+//   --verify-only   check signatures and journals; write no blueprint or
+//                   index (torn journal tails are still cut, as on load)
+//   --compact       fold journals into their base, convert JSON blueprints
+//   --resign        re-sign everything with JARVIS_NEW_SECRET (files must
+//                   verify with JARVIS_SECRET first); journals are folded in
+//   --no-index      do not rewrite <dir>/_index.jarvisidx
+//   --threads N     worker threads (default: one per core)
+//   --list          print the index after the pass
+// Exits 1 if any blueprint failed. Run it while the device is not saving.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include "../include/blueprint_format.hpp"
+#include "../include/blueprint_store.hpp"
+
+namespace
+{
+    void print_index(const sketch::BlueprintIndex &index)
+    {
+        for (const auto &e : index.entries())
+        {
+            std::time_t t = static_cast<std::time_t>(e.mtime_ns / 1000000000LL);
+            char when[32] = "";
+            std::strftime(when, sizeof(when), "%Y-%m-%d %H:%M", std::localtime(&t));
+            std::cout << std::left << std::setw(28) << e.name << std::right << std::setw(7) << e.line_count
+                      << " lines  " << when << std::fixed << std::setprecision(1) << "  [" << e.min_x << ","
+                      << e.min_y << " .. " << e.max_x << "," << e.max_y << "]"
+                      << ((e.flags & sketch::kIndexJson) ? "  json" : "")
+                      << ((e.flags & sketch::kIndexVerified) ? "" : "  unverified") << "\n";
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    sketch::StoreOptions options;
+    options.secret = sketch::blueprint_secret();
+    bool list = false;
+    bool verify_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--verify-only") == 0)
+        {
+            verify_only = true;
+            options.index = false;
+        }
+        else if (std::strcmp(argv[i], "--compact") == 0)
+            options.compact = true;
+        else if (std::strcmp(argv[i], "--resign") == 0)
+            options.resign = true;
+        else if (std::strcmp(argv[i], "--no-index") == 0)
+            options.index = false;
+        else if (std::strcmp(argv[i], "--list") == 0)
+            list = true;
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            options.threads = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+        else if (argv[i][0] == '-')
+        {
+            std::cerr << "Usage: jarvis_store [--verify-only] [--compact] [--resign] [--no-index] "
+                         "[--threads N] [--list] [dir]\n";
+            return 2;
+        }
+        else
+            options.dir = argv[i];
+    }
+    if (verify_only && (options.compact || options.resign))
+    {
+        std::cerr << "--verify-only cannot be combined with --compact or --resign\n";
+        return 2;
+    }
+    if (options.resign)
+    {
+        const char *next = std::getenv("JARVIS_NEW_SECRET");
+        if (!next)
+        {
+            std::cerr << "--resign needs JARVIS_NEW_SECRET (set it empty for plain SHA256)\n";
+            return 2;
+        }
+        options.new_secret = next;
+    }
+
+    sketch::StoreReport report = sketch::run_store_pass(options);
+    for (const auto &r : report.files)
+    {
+        if (r.status != sketch::StoreStatus::OK)
+            std::cerr << r.name << ": " << sketch::store_status_name(r.status)
+                      << (r.error.empty() ? "" : " (" + r.error + ")") << "\n";
+    }
+    std::cout << report.files.size() << " blueprint(s) in " << options.dir << ": " << report.ok << " ok, "
+              << report.failed << " failed, " << report.compacted << " compacted, " << report.resigned
+              << " re-signed (" << report.duration_us / 1000 << " ms)\n";
+    if (options.index)
+        std::cout << (report.index_written ? "Index written: " : "Index NOT written: ") << options.dir << "/"
+                  << sketch::kBlueprintIndexFile << "\n";
+
+    if (list)
+    {
+        sketch::BlueprintIndex index;
+        if (index.load(options.dir + "/" + sketch::kBlueprintIndexFile))
+            print_index(index);
+    }
+    return report.failed == 0 && (!options.index || report.index_written) ? 0 : 1;
+}
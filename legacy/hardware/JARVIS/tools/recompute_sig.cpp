@@ -1,14 +1,23 @@
 // recompute_sig.cpp
-// Small utility to recompute the `signature` field in a .jarvis file
+// Small utility to recompute the signature of a .jarvis file
 // Usage: recompute_sig <path/to/file.jarvis>
+// Binary blueprints get a fresh detached "<file>.sig"; JSON files get their
+// embedded `signature` field rewritten. A binary blueprint's line journal is
+// chained to the old signature: it is folded into the base when the base
+// still verifies with the key, and removed otherwise.
 // If environment variable JARVIS_SECRET is set, HMAC-SHA256 is used; otherwise plain SHA256 is used.
 
+#include <cstdio>
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
+#include <unistd.h>
 #include <nlohmann/json.hpp>
+#include "../include/blueprint_format.hpp"
 #include "../include/crypto.hpp"
+#include "../include/line_journal.hpp"
+#include "../include/sketch_pad.hpp"
 
 int main(int argc, char **argv)
 {
@@ -19,6 +28,75 @@ int main(int argc, char **argv)
     }
     std::string path = argv[1];
 
+    const char *secret_env = std::getenv("JARVIS_SECRET");
+    std::string secret = (secret_env && *secret_env) ? std::string(secret_env) : std::string();
+
+    char magic[4] = {};
+    {
+        std::ifstream probe(path, std::ios::binary);
+        if (!probe.is_open())
+        {
+            std::cerr << "Failed to open " << path << " for reading\n";
+            return 2;
+        }
+        probe.read(magic, sizeof(magic));
+    }
+
+    // Binary blueprint ("JRVB" magic): sign the raw bytes
+    if (sketch::is_binary_blueprint(magic, sizeof(magic)))
+    {
+        sketch::BlueprintView view;
+        if (!view.open(path))
+        {
+            std::cerr << "Failed to read " << path << ": " << view.error() << "\n";
+            return 2;
+        }
+        const std::string journal = path + ".journal"; // as SketchPad names it
+        const bool has_journal = access(journal.c_str(), F_OK) == 0;
+        std::string sig = sketch::blueprint_signature(view.data(), view.size(), secret);
+
+        // Records are only trusted behind a base that verifies with this key
+        std::vector<sketch::JournalRecord> records;
+        const std::string verified = sketch::verified_blueprint_signature(view, path, secret);
+        if (has_journal && !verified.empty())
+        {
+            sketch::LineJournal j;
+            j.open(journal, verified, secret, &records);
+        }
+        if (!records.empty())
+        {
+            sketch::Sketch sk;
+            sketch::GridConfig grid;
+            view.to_sketch(sk, &grid);
+            view.close();
+            for (const auto &rec : records)
+                sketch::LineJournal::apply(rec, sk.lines, grid);
+            if (!sketch::persist_blueprint(path, sk, grid, secret, &sig))
+            {
+                std::cerr << "Failed to rewrite " << path << "\n";
+                return 2;
+            }
+            std::cout << "Folded " << records.size() << " journal record(s) into " << path << "\n";
+        }
+        else
+        {
+            std::string sig_line = sig + "\n";
+            if (!sketch::write_file_atomic(sketch::blueprint_signature_path(path), sig_line.data(), sig_line.size()))
+            {
+                std::cerr << "Failed to write " << sketch::blueprint_signature_path(path) << "\n";
+                return 2;
+            }
+            if (has_journal && verified.empty())
+                std::cerr << "Dropping " << journal << ": its records were chained to the previous signature\n";
+        }
+        // A journal anchored to the previous signature would be discarded on load
+        std::remove(journal.c_str());
+
+        std::cout << "Recomputed detached signature: " << sketch::blueprint_signature_path(path) << "\n";
+        std::cout << "New signature: " << sig << "\n";
+        return 0;
+    }
+
     std::ifstream in(path);
     if (!in.is_open())
     {
@@ -41,11 +119,10 @@ int main(int argc, char **argv)
     std::vector<uint8_t> cbor = nlohmann::json::to_cbor(j);
     std::string payload(cbor.begin(), cbor.end());
 
-    const char *secret_env = std::getenv("JARVIS_SECRET");
     std::string sig;
-    if (secret_env && *secret_env)
+    if (!secret.empty())
     {
-        sig = crypto::hmac_sha256_hex(payload, std::string(secret_env));
+        sig = crypto::hmac_sha256_hex(payload, secret);
     }
     else
     {
@@ -54,21 +131,11 @@ int main(int argc, char **argv)
 
     j["signature"] = sig;
 
-    // Write atomically to a temp file then rename
-    std::string tmp = path + ".tmp";
-    std::ofstream out(tmp, std::ios::trunc);
-    if (!out.is_open())
-    {
-        std::cerr << "Failed to open temp file for writing: " << tmp << "\n";
-        return 2;
-    }
-    out << j.dump(2) << "\n";
-    out.close();
-
-    if (std::rename(tmp.c_str(), path.c_str()) != 0)
+    // Write atomically: temp file, fsync, rename
+    std::string text = j.dump(2) + "\n";
+    if (!sketch::write_file_atomic(path, text.data(), text.size()))
     {
-        std::perror("rename");
-        std::remove(tmp.c_str());
+        std::cerr << "Failed to write " << path << "\n";
         return 2;
     }
 
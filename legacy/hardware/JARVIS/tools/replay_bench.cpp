@@ -0,0 +1,119 @@
+// replay_bench.cpp
+// Runs the production hand detector over a camera recording, headless.
+// Usage: replay_bench <recording> [--fps <n>|--recorded] [--basic] [--lores <w>x<h>]
+// By default frames are served as fast as the detector takes them; --fps
+// paces them, --recorded replays at capture pace. --basic uses HandDetector
+// instead of ProductionHandDetector. --lores delivers a detection stream of
+// that size, as CameraConfig::lores_width/height does on the device.
+// Prints per-frame detect time and a checksum of every detection: the same
+// recording and build give the same checksum, so it doubles as a
+// regression check for detector changes.
+// Record with: JARVIS_RECORD=capture.jrec ./JARVIS
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../include/frame_recording.hpp"
+#include "../include/hand_detector.hpp"
+#include "../include/hand_detector_production.hpp"
+
+namespace
+{
+    // FNV-1a over the fields a regression would change
+    void mix(uint64_t &h, const void *data, size_t len)
+    {
+        const auto *p = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < len; ++i)
+            h = (h ^ p[i]) * 1099511628211ULL;
+    }
+
+    void mix(uint64_t &h, const std::vector<hand_detector::HandDetection> &hands)
+    {
+        uint32_t n = static_cast<uint32_t>(hands.size());
+        mix(h, &n, sizeof(n));
+        for (const auto &d : hands)
+        {
+            int32_t v[7] = {d.bbox.x, d.bbox.y, d.bbox.width, d.bbox.height, d.center.x, d.center.y,
+                            static_cast<int32_t>(d.gesture)};
+            mix(h, v, sizeof(v));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: replay_bench <recording> [--fps <n>|--recorded] [--basic] [--lores <w>x<h>]\n";
+        return 2;
+    }
+    camera::CameraConfig config;
+    config.replay = argv[1];
+    config.replay_fps = -1.0f;
+    bool basic = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            config.replay_fps = static_cast<float>(std::atof(argv[++i]));
+        else if (std::strcmp(argv[i], "--recorded") == 0)
+            config.replay_fps = 0.0f;
+        else if (std::strcmp(argv[i], "--basic") == 0)
+            basic = true;
+        else if (std::strcmp(argv[i], "--lores") == 0 && i + 1 < argc &&
+                 std::sscanf(argv[++i], "%ux%u", &config.lores_width, &config.lores_height) != 2)
+        {
+            std::cerr << "--lores expects <width>x<height>\n";
+            return 2;
+        }
+    }
+
+    camera::ReplaySource source;
+    if (!source.init(config) || !source.start())
+    {
+        std::cerr << source.get_error() << "\n";
+        return 1;
+    }
+
+    hand_detector::DetectorConfig det_config;
+    hand_detector::HandDetector basic_detector(det_config);
+    hand_detector::ProductionHandDetector production_detector(det_config, hand_detector::ProductionConfig());
+
+    std::vector<double> ms;
+    uint64_t checksum = 1469598103934665603ULL;
+    uint64_t hands = 0;
+    auto wall_start = std::chrono::steady_clock::now();
+    while (camera::Frame *frame = source.capture_frame())
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto detections = basic ? basic_detector.detect(*frame) : production_detector.detect(*frame);
+        auto end = std::chrono::steady_clock::now();
+        ms.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        hands += detections.size();
+        mix(checksum, detections);
+    }
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    if (ms.empty())
+    {
+        std::cerr << "No frames: " << source.get_error() << "\n";
+        return 1;
+    }
+
+    double sum = 0;
+    for (double v : ms)
+        sum += v;
+    std::sort(ms.begin(), ms.end());
+    std::cout << "frames=" << ms.size() << " hands=" << hands
+              << " mean_ms=" << sum / ms.size()
+              << " p50_ms=" << ms[ms.size() / 2]
+              << " p95_ms=" << ms[ms.size() * 95 / 100]
+              << " max_ms=" << ms.back()
+              << " fps=" << ms.size() / wall_s
+              << " checksum=" << std::hex << std::setw(16) << std::setfill('0') << checksum << "\n";
+    return 0;
+}
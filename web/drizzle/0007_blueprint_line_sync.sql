@@ -0,0 +1,12 @@
+CREATE TABLE "blueprint_line_sync" (
+	"blueprint_id" text PRIMARY KEY NOT NULL,
+	"version" integer DEFAULT 0 NOT NULL,
+	"lines" text DEFAULT '{}' NOT NULL,
+	"grid" text,
+	"version_vector" text DEFAULT '{}' NOT NULL,
+	"history" text DEFAULT '[]' NOT NULL,
+	"history_start" integer DEFAULT 0 NOT NULL,
+	"updated_at" timestamp DEFAULT now() NOT NULL
+);
+--> statement-breakpoint
+ALTER TABLE "blueprint_line_sync" ADD CONSTRAINT "blueprint_line_sync_blueprint_id_blueprint_id_fk" FOREIGN KEY ("blueprint_id") REFERENCES "public"."blueprint"("id") ON DELETE cascade ON UPDATE no action;
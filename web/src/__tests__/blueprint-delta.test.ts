@@ -0,0 +1,110 @@
+import {
+  MAX_DELTA_HISTORY,
+  applyPush,
+  changesSince,
+  emptyLineSyncState,
+  lineSyncRowFromState,
+  lineSyncStateFromRow,
+  type DeltaEntry,
+  type LineSyncState
+} from '~/lib/blueprint-delta';
+import { blueprintDeltaPushSchema } from '~/lib/validation/blueprint-delta';
+
+// ── helpers ────────────────────────────────────────────────────────────────
+
+function line(id: string, x = 1): DeltaEntry {
+  return [id, x, 2, x + 10, 20, 0xabcdef, 3];
+}
+
+function push(state: LineSyncState, change: { clear?: boolean; remove?: string[]; add?: DeltaEntry[]; grid?: Record<string, unknown> }, device = 'dev-a') {
+  return applyPush(state, { base: state.version, device, remove: [], add: [], ...change });
+}
+
+// ── pushes ─────────────────────────────────────────────────────────────────
+
+describe('blueprint line delta', () => {
+  test('push applies removals and additions and counts per device', () => {
+    let state = push(emptyLineSyncState(), { add: [line('a'), line('b')] });
+    state = push(state, { remove: ['a'], add: [line('c')] }, 'dev-b');
+
+    expect(state.version).toBe(2);
+    expect(Object.keys(state.lines).sort()).toEqual(['b', 'c']);
+    expect(state.lines.c).toEqual([1, 2, 11, 20, 0xabcdef, 3]);
+    expect(state.versionVector).toEqual({ 'dev-a': 1, 'dev-b': 1 });
+  });
+
+  test('clear drops every line before the additions', () => {
+    let state = push(emptyLineSyncState(), { add: [line('a'), line('b')] });
+    state = push(state, { clear: true, add: [line('c')] });
+    expect(Object.keys(state.lines)).toEqual(['c']);
+  });
+
+  // ── pulls ────────────────────────────────────────────────────────────────
+
+  test('pull folds the pushes after since into one change', () => {
+    let state = push(emptyLineSyncState(), { add: [line('a'), line('b')] });
+    state = push(state, { add: [line('c')], grid: { spacing: 5 } });
+    state = push(state, { remove: ['b', 'c'], add: [line('d')] });
+
+    const out = changesSince(state, 1);
+    expect(out.base).toBe(1);
+    expect(out.version).toBe(3);
+    expect(out.full).toBeUndefined();
+    expect(out.remove).toEqual(['b']); // c came and went after 1
+    expect(out.add.map((e) => e[0])).toEqual(['d']);
+    expect(out.grid).toEqual({ spacing: 5 });
+    expect(out.vv).toEqual({ 'dev-a': 3 });
+  });
+
+  test('pull at the current version is empty', () => {
+    const state = push(emptyLineSyncState(), { add: [line('a')] });
+    const out = changesSince(state, 1);
+    expect(out.remove).toEqual([]);
+    expect(out.add).toEqual([]);
+    expect(out.clear).toBeUndefined();
+
+    expect(changesSince(emptyLineSyncState(), 0).add).toEqual([]);
+  });
+
+  test('pull from 0, the future or past the history is a full snapshot', () => {
+    let state = emptyLineSyncState();
+    for (let i = 0; i < MAX_DELTA_HISTORY + 5; ++i) state = push(state, { add: [line(`l${i}`, i)] });
+    expect(state.history.length).toBe(MAX_DELTA_HISTORY);
+    expect(state.historyStart).toBe(5);
+
+    for (const since of [0, 4, state.version + 1]) {
+      const out = changesSince(state, since);
+      expect(out.full).toBe(true);
+      expect(out.clear).toBe(true);
+      expect(out.add.length).toBe(MAX_DELTA_HISTORY + 5);
+    }
+    // Still covered by the history
+    const out = changesSince(state, 5);
+    expect(out.full).toBeUndefined();
+    expect(out.add.length).toBe(MAX_DELTA_HISTORY);
+  });
+
+  test('state survives its database row', () => {
+    let state = push(emptyLineSyncState(), { add: [line('a')], grid: { spacing: 2 } });
+    state = push(state, { remove: ['a'] });
+    expect(lineSyncStateFromRow(lineSyncRowFromState(state))).toEqual(state);
+  });
+
+  // ── validation ───────────────────────────────────────────────────────────
+
+  test('push body matches what the client sends', () => {
+    const body = blueprintDeltaPushSchema.parse({
+      base: 4,
+      version: 0,
+      device: 'dev-a',
+      vv: { 'dev-a': 2 },
+      remove: ['0123456789abcdef'],
+      add: [['fedcba9876543210', 1.5, 2, 3, 4, 4294967295, 2]]
+    });
+    expect(body.base).toBe(4);
+    expect(body.add[0]![5]).toBe(4294967295);
+
+    expect(() => blueprintDeltaPushSchema.parse({ remove: [] })).toThrow();
+    expect(() => blueprintDeltaPushSchema.parse({ base: 0, add: [['x', 1, 2]] })).toThrow();
+  });
+});
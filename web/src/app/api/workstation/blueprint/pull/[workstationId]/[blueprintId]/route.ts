@@ -0,0 +1,113 @@
+import { NextResponse } from "next/server";
+import { deflateSync } from "zlib";
+import { db } from "~/server/db";
+import { blueprint } from "~/server/db/schemas/blueprint";
+import { blueprintLineSync } from "~/server/db/schemas/blueprint_line_sync";
+import { workstation } from "~/server/db/schemas/workstation";
+import { eq, and } from "drizzle-orm";
+import { decodeId, getEncryptionSecret } from "~/lib/crypto-utils";
+import { syncLogger } from "~/lib/syncLogger";
+import {
+  changesSince,
+  emptyLineSyncState,
+  lineSyncStateFromRow,
+} from "~/lib/blueprint-delta";
+
+// Answers below this size are not worth deflating
+const DEFLATE_MIN_BYTES = 256;
+
+// Line-level delta pull for the legacy C++ client (§9 of the sync protocol):
+// GET ...?since=<version> returns the changes after that version, or a full
+// snapshot when the history no longer reaches back that far. A blueprint
+// that was never pushed is empty at version 0.
+export async function GET(
+  request: Request,
+  ctx: { params: Promise<{ workstationId: string; blueprintId: string }> },
+) {
+  try {
+    const { workstationId, blueprintId } = await ctx.params;
+    if (!workstationId || !blueprintId) {
+      return NextResponse.json({ error: "Bad request" }, { status: 400 });
+    }
+    const since = Number(new URL(request.url).searchParams.get("since") ?? 0);
+    if (!Number.isInteger(since) || since < 0) {
+      return NextResponse.json({ error: "Invalid since" }, { status: 400 });
+    }
+
+    let secret: string;
+    try {
+      secret = getEncryptionSecret();
+    } catch (error) {
+      console.error("Encryption secret not configured:", error);
+      return NextResponse.json(
+        { error: "Server configuration error" },
+        { status: 500 },
+      );
+    }
+    const decodedWorkstationId = decodeId(workstationId, secret);
+    const decodedBlueprintId = decodeId(blueprintId, secret);
+
+    // Not 404: the client reads 404 as "no delta endpoints" and falls back
+    // to full downloads
+    const workstationRecord = (
+      await db
+        .select()
+        .from(workstation)
+        .where(eq(workstation.id, decodedWorkstationId))
+        .limit(1)
+    )[0];
+    if (!workstationRecord) {
+      return NextResponse.json(
+        { error: "Unknown workstation" },
+        { status: 403 },
+      );
+    }
+
+    const owned = await db
+      .select({ id: blueprint.id })
+      .from(blueprint)
+      .where(
+        and(
+          eq(blueprint.id, decodedBlueprintId),
+          eq(blueprint.workstationId, decodedWorkstationId),
+        ),
+      )
+      .limit(1);
+    const row = owned.length
+      ? (
+          await db
+            .select()
+            .from(blueprintLineSync)
+            .where(eq(blueprintLineSync.blueprintId, decodedBlueprintId))
+            .limit(1)
+        )[0]
+      : undefined;
+    const state = row ? lineSyncStateFromRow(row) : emptyLineSyncState();
+
+    const body = JSON.stringify(changesSince(state, since));
+    if (
+      body.length > DEFLATE_MIN_BYTES &&
+      (request.headers.get("accept-encoding") ?? "").includes("deflate")
+    ) {
+      return new NextResponse(new Uint8Array(deflateSync(body)), {
+        status: 200,
+        headers: {
+          "Content-Type": "application/json",
+          "Content-Encoding": "deflate",
+        },
+      });
+    }
+    return new NextResponse(body, {
+      status: 200,
+      headers: { "Content-Type": "application/json" },
+    });
+  } catch (error) {
+    syncLogger.error("blueprint.delta.pull.error", {
+      error: error instanceof Error ? error.message : String(error),
+    });
+    return NextResponse.json(
+      { error: "Internal server error" },
+      { status: 500 },
+    );
+  }
+}
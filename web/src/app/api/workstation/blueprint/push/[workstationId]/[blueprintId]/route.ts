@@ -0,0 +1,168 @@
+import { NextResponse } from "next/server";
+import { inflateSync } from "zlib";
+import { db } from "~/server/db";
+import { blueprint } from "~/server/db/schemas/blueprint";
+import { blueprintLineSync } from "~/server/db/schemas/blueprint_line_sync";
+import { workstation } from "~/server/db/schemas/workstation";
+import { eq, and } from "drizzle-orm";
+import { z } from "zod";
+import { decodeId, getEncryptionSecret } from "~/lib/crypto-utils";
+import { syncLogger } from "~/lib/syncLogger";
+import { blueprintDeltaPushSchema } from "~/lib/validation/blueprint-delta";
+import {
+  applyPush,
+  emptyLineSyncState,
+  lineSyncRowFromState,
+  lineSyncStateFromRow,
+} from "~/lib/blueprint-delta";
+
+// Line-level delta push from the legacy C++ client (§9 of the sync protocol).
+// Authenticated like `save`: the device names its workstation in the path.
+// Answers 409 when `base` is not the current version; the client then pulls,
+// merges and pushes again, which also makes a replayed push harmless.
+export async function POST(
+  request: Request,
+  ctx: { params: Promise<{ workstationId: string; blueprintId: string }> },
+) {
+  try {
+    const { workstationId, blueprintId } = await ctx.params;
+    if (!workstationId || !blueprintId) {
+      return NextResponse.json({ error: "Bad request" }, { status: 400 });
+    }
+
+    let secret: string;
+    try {
+      secret = getEncryptionSecret();
+    } catch (error) {
+      console.error("Encryption secret not configured:", error);
+      return NextResponse.json(
+        { error: "Server configuration error" },
+        { status: 500 },
+      );
+    }
+    const decodedWorkstationId = decodeId(workstationId, secret);
+    const decodedBlueprintId = decodeId(blueprintId, secret);
+
+    // Not 404: the client reads 404 as "no delta endpoints" and falls back
+    // to full uploads
+    const workstationRecord = (
+      await db
+        .select()
+        .from(workstation)
+        .where(eq(workstation.id, decodedWorkstationId))
+        .limit(1)
+    )[0];
+    if (!workstationRecord) {
+      return NextResponse.json(
+        { error: "Unknown workstation" },
+        { status: 403 },
+      );
+    }
+
+    const raw = Buffer.from(await request.arrayBuffer());
+    const text =
+      request.headers.get("content-encoding") === "deflate"
+        ? inflateSync(raw).toString("utf8")
+        : raw.toString("utf8");
+    const push = blueprintDeltaPushSchema.parse(JSON.parse(text));
+
+    const existing = (
+      await db
+        .select()
+        .from(blueprint)
+        .where(eq(blueprint.id, decodedBlueprintId))
+        .limit(1)
+    )[0];
+    if (existing && existing.workstationId !== decodedWorkstationId) {
+      return NextResponse.json({ error: "Access denied" }, { status: 403 });
+    }
+
+    const now = new Date();
+    if (!existing) {
+      await db.insert(blueprint).values({
+        id: decodedBlueprintId,
+        name: decodedBlueprintId,
+        createdAt: now,
+        createdBy: workstationRecord.userId,
+        metadata: null,
+        workstationId: decodedWorkstationId,
+        updatedAt: now,
+      });
+    }
+
+    const row = (
+      await db
+        .select()
+        .from(blueprintLineSync)
+        .where(eq(blueprintLineSync.blueprintId, decodedBlueprintId))
+        .limit(1)
+    )[0];
+    const state = row ? lineSyncStateFromRow(row) : emptyLineSyncState();
+    if (push.base !== state.version) {
+      return NextResponse.json(
+        { error: "Version conflict", version: state.version },
+        { status: 409 },
+      );
+    }
+
+    // Compare-and-set on the version so concurrent pushes cannot both land
+    const next = applyPush(state, push);
+    const values = { ...lineSyncRowFromState(next), updatedAt: now };
+    const written = row
+      ? await db
+          .update(blueprintLineSync)
+          .set(values)
+          .where(
+            and(
+              eq(blueprintLineSync.blueprintId, decodedBlueprintId),
+              eq(blueprintLineSync.version, push.base),
+            ),
+          )
+          .returning({ version: blueprintLineSync.version })
+      : await db
+          .insert(blueprintLineSync)
+          .values({ blueprintId: decodedBlueprintId, ...values })
+          .onConflictDoNothing()
+          .returning({ version: blueprintLineSync.version });
+    if (written.length === 0) {
+      return NextResponse.json({ error: "Version conflict" }, { status: 409 });
+    }
+
+    await db
+      .update(blueprint)
+      .set({ syncStatus: "synced", lastSyncedAt: now, updatedAt: now })
+      .where(eq(blueprint.id, decodedBlueprintId));
+
+    syncLogger.info("blueprint.delta.push", {
+      blueprintId: decodedBlueprintId,
+      workstationId: decodedWorkstationId,
+      device: push.device,
+      version: next.version,
+      added: push.add.length,
+      removed: push.remove.length,
+    });
+
+    return NextResponse.json({ version: next.version, vv: next.versionVector });
+  } catch (error) {
+    if (error instanceof z.ZodError) {
+      return NextResponse.json(
+        { error: "Invalid delta", details: error.issues },
+        { status: 400 },
+      );
+    }
+    // Malformed JSON or a corrupt deflate stream
+    if (
+      error instanceof SyntaxError ||
+      (error as { code?: string })?.code?.startsWith("Z_")
+    ) {
+      return NextResponse.json({ error: "Invalid body" }, { status: 400 });
+    }
+    syncLogger.error("blueprint.delta.push.error", {
+      error: error instanceof Error ? error.message : String(error),
+    });
+    return NextResponse.json(
+      { error: "Internal server error" },
+      { status: 500 },
+    );
+  }
+}
@@ -0,0 +1,171 @@
+/**
+ * Line-level delta sync for blueprints drawn on the legacy C++ client.
+ *
+ * The client gives every line a content-addressed id and sends only the
+ * lines added or removed since the version it last agreed on. The server
+ * keeps the current lines, a version counter, the pushes accepted per
+ * device and a bounded history of accepted changes, so a pull can answer
+ * with what happened after `since` (or a full snapshot when that history
+ * is gone). See §9 of doc/BLUEPRINT_SYNC_PROTOCOL.md.
+ */
+
+/** x0, y0, x1, y1, color, thickness */
+export type DeltaLine = [number, number, number, number, number, number];
+/** A line on the wire: [id, x0, y0, x1, y1, color, thickness] */
+export type DeltaEntry = [string, ...DeltaLine];
+/** Grid settings are stored and returned as sent. */
+export type DeltaGrid = Record<string, unknown>;
+
+export interface LineChange {
+  clear?: boolean;
+  remove: string[];
+  add: DeltaEntry[];
+  grid?: DeltaGrid;
+}
+
+export interface LinePush extends LineChange {
+  base: number;
+  device?: string;
+}
+
+export interface HistoryEntry extends LineChange {
+  version: number;
+}
+
+export interface LineSyncState {
+  version: number;
+  lines: Record<string, DeltaLine>;
+  grid: DeltaGrid | null;
+  versionVector: Record<string, number>;
+  /** Accepted changes, oldest first; covers versions (historyStart, version]. */
+  history: HistoryEntry[];
+  historyStart: number;
+}
+
+export interface LinePull extends LineChange {
+  base: number;
+  version: number;
+  vv: Record<string, number>;
+  full?: boolean;
+}
+
+/** Accepted changes kept for pulls; older clients get a full snapshot. */
+export const MAX_DELTA_HISTORY = 256;
+
+export function emptyLineSyncState(): LineSyncState {
+  return {
+    version: 0,
+    lines: {},
+    grid: null,
+    versionVector: {},
+    history: [],
+    historyStart: 0,
+  };
+}
+
+/**
+ * Applies a push made against `state.version` and returns the next state.
+ * The caller checks `push.base` first; a stale base is a conflict.
+ */
+export function applyPush(state: LineSyncState, push: LinePush): LineSyncState {
+  const lines = push.clear ? {} : { ...state.lines };
+  for (const id of push.remove) delete lines[id];
+  for (const [id, ...line] of push.add) lines[id] = line;
+
+  const version = state.version + 1;
+  const versionVector = { ...state.versionVector };
+  if (push.device) versionVector[push.device] = (versionVector[push.device] ?? 0) + 1;
+
+  const entry: HistoryEntry = { version, remove: push.remove, add: push.add };
+  if (push.clear) entry.clear = true;
+  if (push.grid) entry.grid = push.grid;
+  let history = [...state.history, entry];
+  let historyStart = state.historyStart;
+  if (history.length > MAX_DELTA_HISTORY) {
+    const dropped = history.length - MAX_DELTA_HISTORY;
+    historyStart = history[dropped - 1]!.version;
+    history = history.slice(dropped);
+  }
+
+  return {
+    version,
+    lines,
+    grid: push.grid ?? state.grid,
+    versionVector,
+    history,
+    historyStart,
+  };
+}
+
+/** What a client at version `since` is missing, folded into one change. */
+export function changesSince(state: LineSyncState, since: number): LinePull {
+  const out: LinePull = {
+    base: since,
+    version: state.version,
+    vv: state.versionVector,
+    remove: [],
+    add: [],
+  };
+  if (since === state.version) return out;
+
+  if (since === 0 || since < state.historyStart || since > state.version) {
+    out.full = true;
+    out.clear = true;
+    out.add = Object.entries(state.lines).map(([id, line]) => [id, ...line] as DeltaEntry);
+    if (state.grid) out.grid = state.grid;
+    return out;
+  }
+
+  const added = new Map<string, DeltaLine>();
+  const removed = new Set<string>();
+  for (const entry of state.history) {
+    if (entry.version <= since) continue;
+    if (entry.clear) {
+      out.clear = true;
+      added.clear();
+      removed.clear();
+    }
+    for (const id of entry.remove) {
+      if (!added.delete(id) && !out.clear) removed.add(id);
+    }
+    for (const [id, ...line] of entry.add) {
+      if (!removed.delete(id)) added.set(id, line);
+    }
+    if (entry.grid) out.grid = entry.grid;
+  }
+  out.remove = [...removed];
+  out.add = [...added].map(([id, line]) => [id, ...line] as DeltaEntry);
+  return out;
+}
+
+/** Columns of `blueprint_line_sync` that hold the state. */
+export interface LineSyncRow {
+  version: number;
+  lines: string;
+  grid: string | null;
+  versionVector: string;
+  history: string;
+  historyStart: number;
+}
+
+export function lineSyncStateFromRow(row: LineSyncRow): LineSyncState {
+  return {
+    version: row.version,
+    lines: JSON.parse(row.lines) as Record<string, DeltaLine>,
+    grid: row.grid ? (JSON.parse(row.grid) as DeltaGrid) : null,
+    versionVector: JSON.parse(row.versionVector) as Record<string, number>,
+    history: JSON.parse(row.history) as HistoryEntry[],
+    historyStart: row.historyStart,
+  };
+}
+
+export function lineSyncRowFromState(state: LineSyncState): LineSyncRow {
+  return {
+    version: state.version,
+    lines: JSON.stringify(state.lines),
+    grid: state.grid ? JSON.stringify(state.grid) : null,
+    versionVector: JSON.stringify(state.versionVector),
+    history: JSON.stringify(state.history),
+    historyStart: state.historyStart,
+  };
+}
@@ -0,0 +1,26 @@
+import { z } from "zod";
+
+// [id, x0, y0, x1, y1, color, thickness]
+const deltaEntrySchema = z.tuple([
+  z.string().min(1).max(64),
+  z.number(),
+  z.number(),
+  z.number(),
+  z.number(),
+  z.number().int().nonnegative(),
+  z.number().int(),
+]);
+
+// Body of a line-level delta push from the legacy C++ client
+export const blueprintDeltaPushSchema = z.object({
+  base: z.number().int().nonnegative(),
+  device: z.string().max(128).optional(),
+  clear: z.boolean().optional(),
+  remove: z.array(z.string().min(1).max(64)).default([]),
+  add: z.array(deltaEntrySchema).default([]),
+  grid: z.record(z.string(), z.any()).optional(),
+  // The client's version vector; the server keeps its own
+  vv: z.record(z.string(), z.number()).optional(),
+});
+
+export type BlueprintDeltaPushInput = z.infer<typeof blueprintDeltaPushSchema>;
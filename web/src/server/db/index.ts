@@ -20,6 +20,7 @@ import * as syncLog from "~/server/db/schemas/sync_log";
 import * as idempotencyKey from "~/server/db/schemas/idempotency_key";
 import * as scriptFile from "~/server/db/schemas/script_file";
 import * as blueprintVersion from "~/server/db/schemas/blueprint_version";
+import * as blueprintLineSync from "~/server/db/schemas/blueprint_line_sync";
 
 const globalForDb = globalThis as unknown as {
   conn: postgres.Sql | undefined;
@@ -48,6 +49,7 @@ export const schema = {
   ...idempotencyKey,
   ...scriptFile,
   ...blueprintVersion,
+  ...blueprintLineSync,
 };
 
 export const db = drizzle(conn, {
@@ -0,0 +1,33 @@
+import { pgTable, text, timestamp, integer } from "drizzle-orm/pg-core";
+import { blueprint } from "./blueprint";
+
+/**
+ * Line-level delta sync state of a blueprint (legacy C++ client).
+ *
+ * Kept apart from `blueprint.metadata`, which holds the signed full
+ * export from `save`. JSON columns hold what `~/lib/blueprint-delta`
+ * works on.
+ */
+export const blueprintLineSync = pgTable("blueprint_line_sync", {
+  blueprintId: text("blueprint_id")
+    .primaryKey()
+    .references(() => blueprint.id, { onDelete: "cascade" }),
+
+  /** Bumped by every accepted push; pushes must name it as their base. */
+  version: integer("version").notNull().default(0),
+
+  /** JSON: line id -> [x0, y0, x1, y1, color, thickness] */
+  lines: text("lines").notNull().default("{}"),
+
+  /** JSON grid settings as last pushed, or null. */
+  grid: text("grid"),
+
+  /** JSON: device -> pushes accepted from it */
+  versionVector: text("version_vector").notNull().default("{}"),
+
+  /** JSON: accepted changes covering versions (history_start, version] */
+  history: text("history").notNull().default("[]"),
+  historyStart: integer("history_start").notNull().default(0),
+
+  updatedAt: timestamp("updated_at").notNull().defaultNow(),
+});